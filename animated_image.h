@@ -0,0 +1,152 @@
+// AnimatedImage - Decoder interface for frame-by-frame animated images (GIF, APNG).
+// A decoder owns the encoded file and a full-size RGBA canvas; each DecodeNext
+// applies the previous frame's disposal, composites the next frame's region over
+// the canvas and hands back the result flattened to opaque BGRA. Frame count and
+// delays come from a skim over the file at open, without decoding any pixels.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+
+struct FAnimationInfo
+{
+    int32_t Width = 0;
+    int32_t Height = 0;
+    int32_t FrameCount = 0;
+    int32_t LoopCount = 0;                 // 0 = forever
+    int64_t Duration100ns = 0;
+    std::vector<int32_t> DelaysMs;         // One per frame, already clamped
+    const char* FormatName = "";
+};
+
+/** Larger canvases are rejected rather than allocated: no side past 16384, and no more than 64 MP (256 MB of BGRA). */
+constexpr int32_t MaxAnimationDimension = 16384;
+constexpr int64_t MaxAnimationPixels = 64LL * 1024 * 1024;
+
+inline bool IsAnimationCanvasAllowed(int32_t Width, int32_t Height)
+{
+    return Width > 0 && Height > 0 && Width <= MaxAnimationDimension && Height <= MaxAnimationDimension
+        && static_cast<int64_t>(Width) * Height <= MaxAnimationPixels;
+}
+
+/** Delays at or below 10ms mean "as fast as possible" to encoders; browsers play them at 100ms. */
+constexpr int32_t MinAnimationDelayMs = 20;
+constexpr int32_t DefaultAnimationDelayMs = 100;
+
+inline int32_t ClampAnimationDelayMs(int32_t DelayMs)
+{
+    return DelayMs < MinAnimationDelayMs ? DefaultAnimationDelayMs : DelayMs;
+}
+
+class IAnimationDecoder
+{
+public:
+    virtual ~IAnimationDecoder() = default;
+
+    virtual const FAnimationInfo& GetInfo() const = 0;
+
+    /**
+     * Composites the next frame and writes the canvas into Out as BGRA8 at the
+     * animation's size. Returns false after the last frame or on corrupt data.
+     */
+    virtual bool DecodeNext(FFrame& Out) = 0;
+
+    /** Back to before the first frame with a cleared canvas. */
+    virtual void Rewind() = 0;
+
+    /** Index of the frame the next DecodeNext produces. */
+    virtual int32_t GetNextFrameIndex() const = 0;
+};
+
+/**
+ * Straight-alpha canvas of 0xAARRGGBB pixels (BGRA in memory) with the helpers
+ * both decoders share: rectangle clears, snapshots for restore-to-previous
+ * disposal, and flattening over black into an opaque frame.
+ */
+class FAnimationCanvas
+{
+public:
+    void Reset(int32_t InWidth, int32_t InHeight)
+    {
+        Width = InWidth;
+        Height = InHeight;
+        Pixels.assign(static_cast<size_t>(Width) * Height, 0);
+        Saved.clear();
+    }
+
+    void Clear() { std::fill(Pixels.begin(), Pixels.end(), 0u); }
+
+    void ClearRect(const FIntRect& Rect)
+    {
+        FIntRect Clipped = IntersectRect(Rect, FIntRect{ 0, 0, Width, Height });
+        for (int32_t Y = Clipped.Top; Y < Clipped.Bottom; ++Y)
+        {
+            uint32_t* Row = &Pixels[static_cast<size_t>(Y) * Width];
+            std::fill(Row + Clipped.Left, Row + Clipped.Right, 0u);
+        }
+    }
+
+    /** Restore without a prior Save since the last Reset keeps the canvas as is. */
+    void Save() { Saved = Pixels; }
+    void Restore() { if (Saved.size() == Pixels.size()) Pixels = Saved; }
+
+    uint32_t* Row(int32_t Y) { return &Pixels[static_cast<size_t>(Y) * Width]; }
+    int32_t GetWidth() const { return Width; }
+    int32_t GetHeight() const { return Height; }
+
+    /** Premultiplies against black so transparent areas show the desktop's black backdrop. */
+    void Flatten(FFrame& Out) const
+    {
+        Out.Allocate(Width, Height, EPixelFormat::BGRA8);
+        const FFrameView& View = Out.GetView();
+        for (int32_t Y = 0; Y < Height; ++Y)
+        {
+            const uint32_t* Source = &Pixels[static_cast<size_t>(Y) * Width];
+            uint32_t* Dest = reinterpret_cast<uint32_t*>(View.Row(0, Y));
+            for (int32_t X = 0; X < Width; ++X)
+            {
+                uint32_t Pixel = Source[X];
+                uint32_t Alpha = Pixel >> 24;
+                if (Alpha == 255)
+                {
+                    Dest[X] = Pixel;
+                    continue;
+                }
+                uint32_t R = (((Pixel >> 16) & 0xFF) * Alpha + 127) / 255;
+                uint32_t G = (((Pixel >> 8) & 0xFF) * Alpha + 127) / 255;
+                uint32_t B = ((Pixel & 0xFF) * Alpha + 127) / 255;
+                Dest[X] = 0xFF000000u | (R << 16) | (G << 8) | B;
+            }
+        }
+    }
+
+private:
+    std::vector<uint32_t> Pixels;
+    std::vector<uint32_t> Saved;
+    int32_t Width = 0;
+    int32_t Height = 0;
+};
+
+/** Source-over of a straight-alpha pixel onto a straight-alpha pixel. */
+inline uint32_t BlendOver(uint32_t Source, uint32_t Dest)
+{
+    uint32_t SourceAlpha = Source >> 24;
+    if (SourceAlpha == 255) return Source;
+    if (SourceAlpha == 0) return Dest;
+    uint32_t DestAlpha = Dest >> 24;
+    uint32_t DestWeight = DestAlpha * (255 - SourceAlpha) / 255;
+    uint32_t OutAlpha = SourceAlpha + DestWeight;
+    auto Channel = [&](int32_t Shift)
+    {
+        uint32_t S = (Source >> Shift) & 0xFF;
+        uint32_t D = (Dest >> Shift) & 0xFF;
+        return ((S * SourceAlpha + D * DestWeight + OutAlpha / 2) / OutAlpha) << Shift;
+    };
+    return (OutAlpha << 24) | Channel(16) | Channel(8) | Channel(0);
+}
@@ -0,0 +1,293 @@
+// AnimationCache - IVideoSource over an animated image with a decoded-frame cache.
+// Animated GIF/APNG wallpapers are short loops of small frames: decoding them once
+// and replaying from memory turns every pass after the first into a copy. Frames
+// are cached at the smallest size that still covers the largest target surface,
+// in one pooled slab (a single aligned allocation, one frame per band of rows).
+// When the whole loop would not fit the memory cap, the source streams instead,
+// re-decoding every pass; a cap lowered at run time (SetCacheLevel) drops the cache
+// the same way, and one raised again re-caches from the next loop. Either way it
+// loops by itself with timestamps that keep increasing, so the last frame's delay
+// is honored before the first repeats.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "animated_image.h"
+#include "gif_decoder.h"
+#include "png_decoder.h"
+#include "video_source.h"
+
+/** Sniffs the file; nullptr for anything that is neither a GIF nor a PNG/APNG, or that fails to parse. */
+inline std::unique_ptr<IAnimationDecoder> CreateAnimationDecoder(std::vector<uint8_t> Data)
+{
+    if (IsGifData(Data.data(), Data.size()))
+    {
+        auto Decoder = std::make_unique<FGifDecoder>();
+        if (Decoder->Open(std::move(Data))) return Decoder;
+    }
+    else if (IsPngData(Data.data(), Data.size()))
+    {
+        auto Decoder = std::make_unique<FPngDecoder>();
+        if (Decoder->Open(std::move(Data))) return Decoder;
+    }
+    return nullptr;
+}
+
+inline bool IsAnimatedImageData(const uint8_t* Data, size_t Size)
+{
+    return IsGifData(Data, Size) || IsPngData(Data, Size);
+}
+
+constexpr int64_t DefaultAnimationCacheBytes = 256ll * 1024 * 1024;
+
+struct FAnimationCacheSettings
+{
+    int64_t MaxCacheBytes = DefaultAnimationCacheBytes;   // 0 always streams
+    int32_t TargetWidth = 0;                              // Largest surface shown on; 0 keeps the source size
+    int32_t TargetHeight = 0;
+};
+
+enum class EAnimationCacheMode : uint8_t
+{
+    Cached,
+    Streaming
+};
+
+/** Area-average downscale of a BGRA8 view into a smaller BGRA8 view. */
+inline void DownscaleBgra(const FFrameView& Source, const FFrameView& Dest)
+{
+    for (int32_t Y = 0; Y < Dest.Height; ++Y)
+    {
+        int32_t Top = static_cast<int32_t>(static_cast<int64_t>(Y) * Source.Height / Dest.Height);
+        int32_t Bottom = static_cast<int32_t>(static_cast<int64_t>(Y + 1) * Source.Height / Dest.Height);
+        if (Bottom <= Top) Bottom = Top + 1;
+        uint32_t* Out = reinterpret_cast<uint32_t*>(Dest.Row(0, Y));
+        for (int32_t X = 0; X < Dest.Width; ++X)
+        {
+            int32_t Left = static_cast<int32_t>(static_cast<int64_t>(X) * Source.Width / Dest.Width);
+            int32_t Right = static_cast<int32_t>(static_cast<int64_t>(X + 1) * Source.Width / Dest.Width);
+            if (Right <= Left) Right = Left + 1;
+            uint32_t Sums[4] = {};
+            for (int32_t SourceY = Top; SourceY < Bottom; ++SourceY)
+            {
+                const uint8_t* Pixel = Source.Row(0, SourceY) + static_cast<ptrdiff_t>(Left) * 4;
+                for (int32_t SourceX = Left; SourceX < Right; ++SourceX, Pixel += 4)
+                {
+                    Sums[0] += Pixel[0];
+                    Sums[1] += Pixel[1];
+                    Sums[2] += Pixel[2];
+                    Sums[3] += Pixel[3];
+                }
+            }
+            uint32_t Count = static_cast<uint32_t>((Bottom - Top) * (Right - Left));
+            uint32_t Half = Count / 2;
+            Out[X] = ((Sums[3] + Half) / Count << 24) | ((Sums[2] + Half) / Count << 16)
+                | ((Sums[1] + Half) / Count << 8) | ((Sums[0] + Half) / Count);
+        }
+    }
+}
+
+class FAnimatedImageSource final : public IVideoSource
+{
+public:
+    bool Open(std::unique_ptr<IAnimationDecoder> InDecoder, const FAnimationCacheSettings& InSettings)
+    {
+        Decoder = std::move(InDecoder);
+        if (!Decoder || Decoder->GetInfo().FrameCount <= 0) return false;
+        Animation = Decoder->GetInfo();
+        Settings = InSettings;
+
+        // Cover the target: downscale only while both dimensions stay at or above it.
+        OutputWidth = Animation.Width;
+        OutputHeight = Animation.Height;
+        if (Settings.TargetWidth > 0 && Settings.TargetHeight > 0
+            && Animation.Width > Settings.TargetWidth && Animation.Height > Settings.TargetHeight)
+        {
+            double ScaleX = static_cast<double>(Settings.TargetWidth) / Animation.Width;
+            double ScaleY = static_cast<double>(Settings.TargetHeight) / Animation.Height;
+            double Scale = ScaleX > ScaleY ? ScaleX : ScaleY;
+            OutputWidth = static_cast<int32_t>(Animation.Width * Scale + 0.5);
+            OutputHeight = static_cast<int32_t>(Animation.Height * Scale + 0.5);
+        }
+
+        int32_t MinDelayMs = *std::min_element(Animation.DelaysMs.begin(), Animation.DelaysMs.end());
+        Info = {};
+        Info.Width = OutputWidth;
+        Info.Height = OutputHeight;
+        Info.Format = EPixelFormat::BGRA8;
+        Info.FrameRateNumerator = 1000;
+        Info.FrameRateDenominator = static_cast<uint32_t>(MinDelayMs);
+        Info.Duration100ns = Animation.Duration100ns;
+
+        FrameStarts.assign(Animation.DelaysMs.size(), 0);
+        for (size_t Index = 1; Index < FrameStarts.size(); ++Index)
+        {
+            FrameStarts[Index] = FrameStarts[Index - 1] + static_cast<int64_t>(Animation.DelaysMs[Index - 1]) * 10000;
+        }
+
+        Slab.SetResourceTag("Animation.Cache");
+        Decoded.SetResourceTag("Animation.Decode");
+        bRecache = false;
+        Mode = EAnimationCacheMode::Streaming;
+        if (FitsCache(Settings.MaxCacheBytes)) StartCache();
+        NextFrame = 0;
+        LoopBase100ns = 0;
+        return true;
+    }
+
+    const FVideoInfo& GetInfo() const override { return Info; }
+
+    bool ReadFrame(FFrame& Out) override
+    {
+        if (NextFrame >= Animation.FrameCount)
+        {
+            NextFrame = 0;
+            LoopBase100ns += Animation.Duration100ns;
+        }
+        // A cache allowed again fills from the top of the loop, one frame per frame shown.
+        if (bRecache && NextFrame == 0)
+        {
+            bRecache = false;
+            StartCache();
+        }
+
+        if (Mode == EAnimationCacheMode::Cached)
+        {
+            if (!FillCache(NextFrame + 1)) return false;
+            Out.Allocate(OutputWidth, OutputHeight, EPixelFormat::BGRA8);
+            CopyRows(GetCachedView(NextFrame), Out.GetView());
+        }
+        else
+        {
+            if (Decoder->GetNextFrameIndex() != NextFrame && !SkipTo(NextFrame)) return false;
+            if (!DecodeInto(Out)) return false;
+        }
+
+        Out.Timestamp100ns = LoopBase100ns + FrameStarts[NextFrame];
+        ++NextFrame;
+        return true;
+    }
+
+    /** Position wraps into the loop; the next frame is the first starting at or after it. */
+    bool Seek(int64_t Position100ns) override
+    {
+        int64_t Duration = Animation.Duration100ns > 0 ? Animation.Duration100ns : 1;
+        if (Position100ns < 0) Position100ns = 0;
+        LoopBase100ns = Position100ns / Duration * Duration;
+        int64_t Offset = Position100ns - LoopBase100ns;
+        NextFrame = static_cast<int32_t>(std::lower_bound(FrameStarts.begin(), FrameStarts.end(), Offset) - FrameStarts.begin());
+        if (Mode == EAnimationCacheMode::Cached) return true;
+        return NextFrame >= Animation.FrameCount || SkipTo(NextFrame);
+    }
+
+    int64_t GetCacheBytes() const override { return static_cast<int64_t>(Slab.GetSizeBytes()); }
+
+    /** A cache that no longer fits is dropped at once (streaming from the current frame); one that fits again returns next loop. */
+    void SetCacheLevel(int32_t Level) override
+    {
+        bool bFits = FitsCache(GetCacheLevelBytes(Settings.MaxCacheBytes, Level));
+        bRecache = bFits && Mode == EAnimationCacheMode::Streaming;
+        if (bFits || Mode != EAnimationCacheMode::Cached) return;
+        Mode = EAnimationCacheMode::Streaming;
+        Slab.Release();
+        CachedFrames = 0;
+        Decoder->Rewind();
+    }
+
+    const FAnimationInfo& GetAnimationInfo() const { return Animation; }
+    EAnimationCacheMode GetMode() const { return Mode; }
+    int32_t GetCachedFrames() const { return CachedFrames; }
+
+    /** Total frames run through the decoder; stops growing once a cached loop is complete. */
+    uint64_t GetDecodedFrames() const { return DecodedFrames; }
+
+private:
+    /** One slab for the whole loop: a frame is a band of OutputHeight rows. */
+    bool FitsCache(int64_t MaxBytes) const
+    {
+        size_t Stride = (static_cast<size_t>(OutputWidth) * 4 + FrameAlignment - 1) & ~(FrameAlignment - 1);
+        size_t TotalBytes = Stride * OutputHeight * static_cast<size_t>(Animation.FrameCount);
+        int64_t SlabRows = static_cast<int64_t>(OutputHeight) * Animation.FrameCount;
+        return MaxBytes > 0 && TotalBytes <= static_cast<uint64_t>(MaxBytes) && SlabRows <= INT32_MAX;
+    }
+
+    void StartCache()
+    {
+        Mode = EAnimationCacheMode::Cached;
+        Slab.Allocate(OutputWidth, OutputHeight * Animation.FrameCount, EPixelFormat::BGRA8);
+        CachedFrames = 0;
+        Decoder->Rewind();
+    }
+
+    FFrameView GetCachedView(int32_t Index) const
+    {
+        return Slab.GetView().Crop({ 0, Index * OutputHeight, OutputWidth, (Index + 1) * OutputHeight });
+    }
+
+    /** Decodes in order until Count frames are cached; the decoder is kept to stream if the cache is dropped. */
+    bool FillCache(int32_t Count)
+    {
+        while (CachedFrames < Count)
+        {
+            if (!Decoder->DecodeNext(Decoded)) return false;
+            ++DecodedFrames;
+            FFrameView Slot = GetCachedView(CachedFrames);
+            if (OutputWidth == Animation.Width && OutputHeight == Animation.Height) CopyRows(Decoded.GetView(), Slot);
+            else DownscaleBgra(Decoded.GetView(), Slot);
+            // The scratch frame is not needed again unless the cache is dropped.
+            if (++CachedFrames == Animation.FrameCount) Decoded.Release();
+        }
+        return true;
+    }
+
+    /** Streaming: reposition the decoder, compositing (not presenting) the frames in between. */
+    bool SkipTo(int32_t Index)
+    {
+        if (Decoder->GetNextFrameIndex() > Index) Decoder->Rewind();
+        while (Decoder->GetNextFrameIndex() < Index)
+        {
+            if (!Decoder->DecodeNext(Decoded)) return false;
+            ++DecodedFrames;
+        }
+        return true;
+    }
+
+    bool DecodeInto(FFrame& Out)
+    {
+        ++DecodedFrames;
+        if (OutputWidth == Animation.Width && OutputHeight == Animation.Height) return Decoder->DecodeNext(Out);
+        if (!Decoder->DecodeNext(Decoded)) return false;
+        Out.Allocate(OutputWidth, OutputHeight, EPixelFormat::BGRA8);
+        DownscaleBgra(Decoded.GetView(), Out.GetView());
+        return true;
+    }
+
+    static void CopyRows(const FFrameView& Source, const FFrameView& Dest)
+    {
+        size_t RowBytes = static_cast<size_t>(Dest.Width) * 4;
+        for (int32_t Y = 0; Y < Dest.Height; ++Y) std::memcpy(Dest.Row(0, Y), Source.Row(0, Y), RowBytes);
+    }
+
+    std::unique_ptr<IAnimationDecoder> Decoder;
+    FAnimationInfo Animation;
+    FAnimationCacheSettings Settings;
+    FVideoInfo Info;
+    std::vector<int64_t> FrameStarts;
+    EAnimationCacheMode Mode = EAnimationCacheMode::Streaming;
+    bool bRecache = false;              // Cache allowed again; starts at the next loop
+    FFrame Slab;
+    FFrame Decoded;
+    int32_t OutputWidth = 0;
+    int32_t OutputHeight = 0;
+    int32_t CachedFrames = 0;
+    int32_t NextFrame = 0;
+    int64_t LoopBase100ns = 0;
+    uint64_t DecodedFrames = 0;
+};
@@ -10,12 +10,16 @@ set SOURCE=main.cpp
 :: Output executable
 set OUTPUT=VideoWallpaper.exe
 
+:: Command-line control client (console application)
+set CLIENT_SOURCE=vwctl.cpp
+set CLIENT_OUTPUT=vwctl.exe
+
 :: Resource file
 set RESOURCE=app.rc
 set RESOURCE_OBJ=app_res.o
 
 :: Libraries to link against (MinGW)
-set LIBS=-lmfplay -lmfplat -lmfuuid -lmf -lole32 -lshlwapi -lgdi32 -luser32 -lshell32 -lcomdlg32 -ladvapi32 -lpsapi
+set LIBS=-lmfplay -lmfplat -lmfreadwrite -lmfuuid -lmf -lole32 -lshlwapi -lgdi32 -luser32 -lshell32 -lcomdlg32 -ladvapi32 -lpsapi -lwtsapi32
 
 :: Compiler flags
 :: -static to avoid dependency on MinGW DLLs
@@ -43,7 +47,12 @@ if %ERRORLEVEL% EQU 0 (
     del %RESOURCE_OBJ% >nul 2>&1
 ) else (
     echo Build failed.
+    goto :end
 )
 
+echo Building %CLIENT_OUTPUT%...
+g++ %CLIENT_SOURCE% -o %CLIENT_OUTPUT% -static -municode -std=c++20 -Os -s -ladvapi32
+if %ERRORLEVEL% NEQ 0 echo Client build failed.
+
 :end
 endlocal
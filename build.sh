@@ -0,0 +1,95 @@
+#!/bin/sh
+# Linux build: the X11 wallpaper, the control client, the shared decode service, the cost analyzer
+# and the soak, animation, crossfade, ping-pong, memory, decode service, rendition,
+# tone-mapping, codec-free source, scheduling, cost model, tracer, window cache,
+# pipeline startup, master clock, span layout, compositor, tile diff, keyframe
+# selection, quality controller, shell re-attach and session lifecycle benchmarks,
+# and the control endpoint tests.
+# Needs g++ (C++20) and the X11, Xext and Xrandr development headers
+# (Debian/Ubuntu: libx11-dev libxext-dev libxrandr-dev).
+
+CXX=${CXX:-g++}
+FLAGS="-std=c++20 -O2 -pthread"
+
+echo "Building videowallpaper-x11..."
+$CXX main_x11.cpp -o videowallpaper-x11 $FLAGS -lX11 -lXext -lXrandr || echo "X11 wallpaper build failed."
+
+echo "Building vwctl..."
+$CXX vwctl.cpp -o vwctl $FLAGS || echo "Client build failed."
+
+echo "Building vwdecoded..."
+$CXX vwdecoded.cpp -o vwdecoded $FLAGS || echo "Decode service build failed."
+
+echo "Building vwcost..."
+$CXX vwcost.cpp -o vwcost $FLAGS || echo "Cost analyzer build failed."
+
+echo "Building soak..."
+$CXX soak.cpp -o soak $FLAGS || echo "Soak build failed."
+
+echo "Building anim_bench..."
+$CXX anim_bench.cpp -o anim_bench $FLAGS || echo "Animation benchmark build failed."
+
+echo "Building crossfade_bench..."
+$CXX crossfade_bench.cpp -o crossfade_bench $FLAGS || echo "Crossfade benchmark build failed."
+
+echo "Building pingpong_bench..."
+$CXX pingpong_bench.cpp -o pingpong_bench $FLAGS || echo "Ping-pong benchmark build failed."
+
+echo "Building memory_bench..."
+$CXX memory_bench.cpp -o memory_bench $FLAGS || echo "Memory benchmark build failed."
+
+echo "Building service_bench..."
+$CXX service_bench.cpp -o service_bench $FLAGS || echo "Decode service benchmark build failed."
+
+echo "Building rendition_bench..."
+$CXX rendition_bench.cpp -o rendition_bench $FLAGS || echo "Rendition benchmark build failed."
+
+echo "Building tonemap_bench..."
+$CXX tonemap_bench.cpp -o tonemap_bench $FLAGS || echo "Tone-mapping benchmark build failed."
+
+echo "Building source_bench..."
+$CXX source_bench.cpp -o source_bench $FLAGS || echo "Source benchmark build failed."
+
+echo "Building qos_bench..."
+$CXX qos_bench.cpp -o qos_bench $FLAGS || echo "Scheduling benchmark build failed."
+
+echo "Building cost_bench..."
+$CXX cost_bench.cpp -o cost_bench $FLAGS || echo "Cost model benchmark build failed."
+
+echo "Building trace_bench..."
+$CXX trace_bench.cpp -o trace_bench $FLAGS || echo "Tracer benchmark build failed."
+
+echo "Building window_bench..."
+$CXX window_bench.cpp -o window_bench $FLAGS || echo "Window cache benchmark build failed."
+
+echo "Building pipeline_bench..."
+$CXX pipeline_bench.cpp -o pipeline_bench $FLAGS || echo "Pipeline startup benchmark build failed."
+
+echo "Building clock_bench..."
+$CXX clock_bench.cpp -o clock_bench $FLAGS || echo "Master clock benchmark build failed."
+
+echo "Building span_bench..."
+$CXX span_bench.cpp -o span_bench $FLAGS || echo "Span layout benchmark build failed."
+
+echo "Building compositor_bench..."
+$CXX compositor_bench.cpp -o compositor_bench $FLAGS || echo "Compositor benchmark build failed."
+
+echo "Building tile_bench..."
+$CXX tile_bench.cpp -o tile_bench $FLAGS || echo "Tile diff benchmark build failed."
+
+echo "Building keyframe_bench..."
+$CXX keyframe_bench.cpp -o keyframe_bench $FLAGS || echo "Keyframe selection benchmark build failed."
+
+echo "Building quality_bench..."
+$CXX quality_bench.cpp -o quality_bench $FLAGS || echo "Quality controller benchmark build failed."
+
+echo "Building shell_bench..."
+$CXX shell_bench.cpp -o shell_bench $FLAGS || echo "Shell re-attach benchmark build failed."
+
+echo "Building lifecycle_bench..."
+$CXX lifecycle_bench.cpp -o lifecycle_bench $FLAGS || echo "Session lifecycle benchmark build failed."
+
+echo "Building control_bench..."
+$CXX control_bench.cpp -o control_bench $FLAGS || echo "Control endpoint test build failed."
+
+echo "Build successful!"
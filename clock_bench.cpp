@@ -0,0 +1,294 @@
+// clock_bench - Master clock and drift correction against skewed simulated pipelines.
+// Simulates --pipelines players whose clocks run fast or slow by up to --skew-pct,
+// whose position reads jitter by a few milliseconds and whose seeks take a while to
+// land, slaved to one FMasterClock for --hours of simulated playback the way the
+// Windows update tick does it: every 500 ms each player's drift is trimmed by
+// FDriftCorrector, and at the master's wrap every player is seeked to the start
+// together. A timer fires late by up to a Windows timer tick, so players also run
+// off the end first and restart on their own. Away from seeks, drift must stay
+// within two frames without hard seeks, every loop must play to within 100 ms of
+// the end of the file, and a player that falls a second behind must be caught by
+// one seek.
+// Pause and resume must continue the timeline where it stopped.
+//   g++ -std=c++20 -O2 -pthread clock_bench.cpp -o clock_bench
+//   clock_bench [--pipelines N] [--skew-pct X] [--hours N] [--loop-s N] [--seed N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "master_clock.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    constexpr int64_t MsNs = 1000000;
+    constexpr int64_t StepNs = 2 * MsNs;
+    constexpr int64_t TickNs = 500 * MsNs;          // TimerIntervalMs
+    constexpr int64_t FrameDuration100ns = 166667;  // 60 fps
+
+    /** A loop cut this far before the end of the file counts as short; wrapping early used to cut 500 ms. */
+    constexpr int64_t ShortLoop100ns = 1000000;
+
+    struct FBenchOptions
+    {
+        int32_t Pipelines = 4;
+        double SkewPct = 0.2;
+        double Hours = 2.0;
+        int32_t LoopSeconds = 30;
+        uint32_t Seed = 1;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--pipelines") Options.Pipelines = std::atoi(Value);
+            else if (Name == "--skew-pct") Options.SkewPct = std::atof(Value);
+            else if (Name == "--hours") Options.Hours = std::atof(Value);
+            else if (Name == "--loop-s") Options.LoopSeconds = std::atoi(Value);
+            else if (Name == "--seed") Options.Seed = static_cast<uint32_t>(std::atoi(Value));
+            else return false;
+        }
+        return Options.Pipelines > 0 && Options.SkewPct >= 0.0 && Options.SkewPct < 2.0 && Options.Hours > 0.0 && Options.LoopSeconds > 1;
+    }
+
+    /** One player: a position that advances at its own clock's pace times the rate it was given. */
+    struct FSimPipeline
+    {
+        double Skew = 1.0;
+        double Rate = 1.0;
+        double Position100ns = 0.0;
+        int64_t SeekLandsNs = 0;        // Frozen until then while a seek completes
+        int64_t LastSeekNs = 0;
+        double SeekTarget100ns = 0.0;
+        double LoopMax100ns = 0.0;      // Furthest position reached this loop
+        FDriftCorrector Drift;
+        int64_t Ended = 0;
+        int64_t ShortLoops = 0;         // Loops that stopped short of the last frame
+    };
+
+    struct FSimResult
+    {
+        double MaxDriftMs = 0.0;
+        int64_t Seeks = 0;
+        int64_t Ended = 0;
+        int64_t ShortLoops = 0;
+        int64_t Loops = 0;
+    };
+
+    void Seek(FSimPipeline& Pipeline, double Target100ns, int64_t NowNs, int64_t LatencyNs)
+    {
+        Pipeline.SeekTarget100ns = Target100ns;
+        Pipeline.SeekLandsNs = NowNs + LatencyNs;
+        Pipeline.LastSeekNs = Pipeline.SeekLandsNs;
+    }
+
+    /**
+     * Restarts the loop bookkeeping when a player goes back to the start. A player that
+     * already ran off the end and restarted is sent back again by the synchronized loop
+     * just after; that is not a loop of its own.
+     */
+    void StartLoop(FSimPipeline& Pipeline, int64_t Duration100ns)
+    {
+        bool bLoop = Pipeline.LoopMax100ns >= Duration100ns / 2;
+        if (bLoop && Pipeline.LoopMax100ns < Duration100ns - ShortLoop100ns) ++Pipeline.ShortLoops;
+        Pipeline.LoopMax100ns = 0.0;
+    }
+
+    /** StallAtNs: the last player loses a second there, as after a decoder hiccup. */
+    FSimResult Simulate(const FBenchOptions& Options, int64_t StallAtNs)
+    {
+        std::mt19937 Random(Options.Seed);
+        std::uniform_real_distribution<double> SkewDistribution(-Options.SkewPct / 100.0, Options.SkewPct / 100.0);
+        std::uniform_int_distribution<int64_t> JitterDistribution(-20000, 20000);           // +-2 ms position reads
+        std::uniform_int_distribution<int64_t> SeekDistribution(10 * MsNs, 60 * MsNs);
+        std::uniform_int_distribution<int64_t> TimerDistribution(0, 16 * MsNs);            // Timer resolution
+
+        int64_t Duration100ns = static_cast<int64_t>(Options.LoopSeconds) * 10000000;
+        std::vector<FSimPipeline> Pipelines(static_cast<size_t>(Options.Pipelines));
+        for (size_t Index = 0; Index < Pipelines.size(); ++Index)
+        {
+            // The first two run at the extremes, so every run covers the worst case.
+            Pipelines[Index].Skew = 1.0 + (Index == 0 ? Options.SkewPct / 100.0 : Index == 1 ? -Options.SkewPct / 100.0 : SkewDistribution(Random));
+        }
+
+        FMasterClock Clock;
+        int64_t NowNs = 1000 * MsNs;
+        Clock.Start(NowNs, Duration100ns);
+        int64_t EndNs = NowNs + static_cast<int64_t>(Options.Hours * 3600.0 * 1e9);
+        int64_t SettleNs = NowNs + 20000 * MsNs;
+        int64_t NextTickNs = NowNs + TickNs;
+        int64_t LoopTimerNs = -1;
+        uint64_t LastLoopIndex = 0;
+        FSimResult Result;
+
+        for (; NowNs < EndNs; NowNs += StepNs)
+        {
+            for (FSimPipeline& Pipeline : Pipelines)
+            {
+                if (Pipeline.SeekLandsNs)
+                {
+                    if (NowNs < Pipeline.SeekLandsNs) continue;
+                    Pipeline.Position100ns = Pipeline.SeekTarget100ns;
+                    Pipeline.SeekLandsNs = 0;
+                }
+                if (StallAtNs > 0 && &Pipeline == &Pipelines.back() && NowNs >= StallAtNs && NowNs < StallAtNs + StepNs)
+                {
+                    Pipeline.Position100ns -= 10000000.0;
+                    if (Pipeline.Position100ns < 0.0) Pipeline.Position100ns += static_cast<double>(Duration100ns);
+                    Pipeline.LoopMax100ns = Pipeline.Position100ns;
+                }
+                Pipeline.Position100ns += StepNs / 100.0 * Pipeline.Skew * Pipeline.Rate;
+                if (Pipeline.Position100ns > Pipeline.LoopMax100ns) Pipeline.LoopMax100ns = Pipeline.Position100ns;
+                if (Pipeline.Position100ns >= Duration100ns)
+                {
+                    // MFP_EVENT_TYPE_PLAYBACK_ENDED, as the Windows callback handles it.
+                    ++Pipeline.Ended;
+                    Pipeline.LoopMax100ns = static_cast<double>(Duration100ns);
+                    StartLoop(Pipeline, Duration100ns);
+                    int64_t TimeToWrapNs = Clock.GetTimeToWrapNs(NowNs);
+                    bool bNearWrap = TimeToWrapNs >= 0 && TimeToWrapNs < DriftHardSeek100ns * 100;
+                    Pipeline.Position100ns = static_cast<double>(Duration100ns);
+                    Seek(Pipeline, bNearWrap ? 0.0 : static_cast<double>(Clock.GetPosition100ns(NowNs)), NowNs, SeekDistribution(Random));
+                    Pipeline.Drift.Reset();
+                }
+            }
+
+            uint64_t LoopIndex = Clock.GetLoopIndex(NowNs);
+            if (LoopIndex != LastLoopIndex && LoopTimerNs < 0)
+            {
+                // A wrap the tick did not schedule a timer for (only when the loop is shorter than a tick).
+                LoopTimerNs = NowNs;
+            }
+            if (LoopTimerNs >= 0 && NowNs >= LoopTimerNs)
+            {
+                // LoopAllPlayers
+                LoopTimerNs = -1;
+                LastLoopIndex = LoopIndex;
+                ++Result.Loops;
+                double Target = static_cast<double>(Clock.GetPosition100ns(NowNs));
+                for (FSimPipeline& Pipeline : Pipelines)
+                {
+                    if (!Pipeline.SeekLandsNs) StartLoop(Pipeline, Duration100ns);
+                    Seek(Pipeline, Target, NowNs, SeekDistribution(Random));
+                    Pipeline.Drift.Reset();
+                }
+            }
+
+            if (NowNs < NextTickNs) continue;
+            // SyncPlayersToMasterClock
+            NextTickNs += TickNs;
+            int64_t MasterPosition = Clock.GetPosition100ns(NowNs);
+            for (FSimPipeline& Pipeline : Pipelines)
+            {
+                if (Pipeline.SeekLandsNs) continue;
+                int64_t Read = static_cast<int64_t>(Pipeline.Position100ns) + JitterDistribution(Random);
+                int64_t TrueDrift = WrappedDelta100ns(static_cast<int64_t>(Pipeline.Position100ns), MasterPosition, Duration100ns);
+                // Steady state only: a seek lands behind by its own latency, which the trim then closes.
+                bool bSettling = NowNs < SettleNs || NowNs < Pipeline.LastSeekNs + static_cast<int64_t>(DriftCorrectionHorizonSec * 1e9);
+                if (!bSettling && !(StallAtNs > 0 && NowNs >= StallAtNs))
+                {
+                    double DriftMs = std::fabs(static_cast<double>(TrueDrift)) / 10000.0;
+                    if (DriftMs > Result.MaxDriftMs) Result.MaxDriftMs = DriftMs;
+                }
+                FDriftCorrection Correction = Pipeline.Drift.Update(MasterPosition, Read, Duration100ns);
+                if (Correction.bSeek) Seek(Pipeline, static_cast<double>(Correction.SeekTarget100ns), NowNs, SeekDistribution(Random));
+                else Pipeline.Rate = Correction.Rate;
+            }
+            int64_t TimeToWrapNs = Clock.GetTimeToWrapNs(NowNs);
+            if (TimeToWrapNs >= 0 && TimeToWrapNs < TickNs && LoopTimerNs < 0)
+            {
+                LoopTimerNs = NowNs + TimeToWrapNs + TimerDistribution(Random);
+            }
+        }
+
+        for (FSimPipeline& Pipeline : Pipelines)
+        {
+            Result.Seeks += static_cast<int64_t>(Pipeline.Drift.GetSeekCount());
+            Result.Ended += Pipeline.Ended;
+            Result.ShortLoops += Pipeline.ShortLoops;
+        }
+        return Result;
+    }
+
+    bool CheckClock()
+    {
+        bool bPass = true;
+        FMasterClock Clock;
+        int64_t Loop = 10 * 10000000;
+        Clock.Start(0, Loop);
+        bPass &= Check(Clock.GetPosition100ns(3000 * MsNs) == 3 * 10000000, "position follows wall time");
+        bPass &= Check(Clock.GetPosition100ns(10000 * MsNs) == 0 && Clock.GetLoopIndex(10000 * MsNs) == 1, "wraps at the loop length");
+        bPass &= Check(Clock.GetPosition100ns(10000 * MsNs - 100) == Loop - 1, "last instant before the wrap is shown");
+        bPass &= Check(Clock.GetTimeToWrapNs(9500 * MsNs) == 500 * MsNs, "time to wrap");
+        Clock.Pause(4000 * MsNs);
+        bPass &= Check(Clock.GetPosition100ns(60000 * MsNs) == 4 * 10000000 && Clock.GetTimeToWrapNs(60000 * MsNs) < 0, "paused clock holds");
+        Clock.Resume(60000 * MsNs);
+        bPass &= Check(Clock.GetPosition100ns(61000 * MsNs) == 5 * 10000000, "resume continues where it stopped");
+
+        bPass &= Check(WrappedDelta100ns(100, Loop - 100, Loop) == 200, "drift across the wrap, ahead");
+        bPass &= Check(WrappedDelta100ns(Loop - 100, 100, Loop) == -200, "drift across the wrap, behind");
+
+        FDriftCorrector Corrector;
+        bPass &= Check(Corrector.Update(1000000, 1000000 + DriftDeadband100ns / 2, Loop).Rate == 1.0, "deadband leaves the rate alone");
+        Corrector.Reset();
+        FDriftCorrection Ahead = Corrector.Update(1000000, 1000000 + 1000000, Loop);
+        bPass &= Check(Ahead.Rate < 1.0 && Ahead.Rate >= 1.0 - DriftMaxRateTrim, "ahead slows down");
+        Corrector.Reset();
+        FDriftCorrection Behind = Corrector.Update(1000000, 1000000 - 1000000, Loop);
+        bPass &= Check(Behind.Rate > 1.0 && Behind.Rate <= 1.0 + DriftMaxRateTrim, "behind speeds up");
+        FDriftCorrection Far = Corrector.Update(1000000, 1000000 + DriftHardSeek100ns + 1, Loop);
+        bPass &= Check(Far.bSeek && Far.SeekTarget100ns == 1000000 && Corrector.GetSeekCount() == 1, "large drift seeks");
+        return bPass;
+    }
+
+    bool CheckSimulation(const FBenchOptions& Options)
+    {
+        FSimResult Result = Simulate(Options, 0);
+        std::printf("%d pipelines, +-%.2f%% skew, %.1f h of %d s loops: max drift %.1f ms, %lld seek(s), %lld end(s) before the wrap, %lld short loop(s) of %lld\n",
+            Options.Pipelines, Options.SkewPct, Options.Hours, Options.LoopSeconds, Result.MaxDriftMs,
+            static_cast<long long>(Result.Seeks), static_cast<long long>(Result.Ended),
+            static_cast<long long>(Result.ShortLoops), static_cast<long long>(Result.Loops));
+        bool bPass = Check(Result.MaxDriftMs < 2.0 * FrameDuration100ns / 10000.0, "drift stays within two frames");
+        bPass &= Check(Result.Seeks == 0, "skew is trimmed without hard seeks");
+        bPass &= Check(Result.ShortLoops == 0, "every loop reaches the end of the file");
+        bPass &= Check(Result.Loops >= static_cast<int64_t>(Options.Hours * 3600.0 / Options.LoopSeconds) - 1, "every wrap loops the players");
+
+        FBenchOptions Short = Options;
+        Short.Hours = 0.05;
+        FSimResult Stalled = Simulate(Short, 60000 * MsNs + 1000 * MsNs + 123 * MsNs);
+        std::printf("player a second behind: %lld seek(s)\n", static_cast<long long>(Stalled.Seeks));
+        bPass &= Check(Stalled.Seeks == 1, "a player a second behind is caught by one seek");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: clock_bench [--pipelines N] [--skew-pct X] [--hours N] [--loop-s N] [--seed N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckClock(), "clock");
+    bPass &= Check(CheckSimulation(Options), "simulation");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
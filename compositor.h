@@ -0,0 +1,395 @@
+// Compositor - CPU presentation path for sessions without a usable GPU.
+// One decoded frame is color-converted once (10-bit HDR frames are tone mapped to
+// SDR on the way), then each output's region of it is scaled into a shared BGRA
+// canvas (the DIB the platform layer blits from).
+// Both stages are split into tiles and run on an FThreadPool; each stage is timed.
+// Scaled tiles are hashed in place so the presenter can skip unchanged regions.
+// During a crossfade each scaled tile is blended with another canvas before hashing.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "crossfade.h"
+#include "frame.h"
+#include "thread_pool.h"
+#include "tile_diff.h"
+#include "tonemap.h"
+#include "trace.h"
+
+/** Edge length of a composition tile; the same grid drives scaling and change detection. */
+constexpr int32_t CompositorTileSize = DefaultTileSize;
+
+/** Rows per color-conversion band; even so 4:2:0 chroma rows pair up. */
+constexpr int32_t ConvertBandRows = 16;
+
+/** Last value plus an exponential moving average, in nanoseconds. */
+struct FStageTiming
+{
+    int64_t LastNs = 0;
+    double AverageNs = 0.0;
+
+    void Add(int64_t Ns)
+    {
+        LastNs = Ns;
+        AverageNs = AverageNs == 0.0 ? static_cast<double>(Ns) : AverageNs + 0.05 * (Ns - AverageNs);
+    }
+};
+
+struct FCompositorStats
+{
+    FStageTiming Convert;
+    FStageTiming Scale;
+    FStageTiming Present;   // Reported by the platform layer via RecordPresent()
+    uint64_t Frames = 0;
+    uint64_t StaticFrames = 0;  // Frames with no changed tile
+    uint64_t TilesTotal = 0;
+    uint64_t TilesDirty = 0;
+};
+
+/** One presentation target: where it sits on the canvas and which part of the source it shows. */
+struct FCompositorOutput
+{
+    FIntRect Target;        // Canvas pixels
+    FIntRect SourceCrop;    // Source pixels; empty means the whole frame
+};
+
+/** Chroma contribution shared by the two horizontally adjacent pixels of a 4:2:0 sample. */
+struct FChromaTerms
+{
+    int32_t Red = 0;
+    int32_t Green = 0;
+    int32_t Blue = 0;
+};
+
+/** BT.709 limited-range coefficients in 8-bit fixed point. */
+inline FChromaTerms ChromaTerms709(int32_t U, int32_t V)
+{
+    int32_t D = U - 128;
+    int32_t E = V - 128;
+    return { 459 * E + 128, -55 * D - 136 * E + 128, 541 * D + 128 };
+}
+
+inline uint8_t ClampByte(int32_t Value)
+{
+    return static_cast<uint8_t>(Value < 0 ? 0 : (Value > 255 ? 255 : Value));
+}
+
+inline uint32_t PackBgra(int32_t Luma, const FChromaTerms& Terms)
+{
+    int32_t C = (Luma - 16) * 298;
+    return 0xFF000000u
+        | (static_cast<uint32_t>(ClampByte((C + Terms.Red) >> 8)) << 16)
+        | (static_cast<uint32_t>(ClampByte((C + Terms.Green) >> 8)) << 8)
+        | static_cast<uint32_t>(ClampByte((C + Terms.Blue) >> 8));
+}
+
+/** BT.709 limited-range YUV to BGRA for one pixel. */
+inline uint32_t YuvToBgra709(int32_t Y, int32_t U, int32_t V)
+{
+    return PackBgra(Y, ChromaTerms709(U, V));
+}
+
+/** Converts NV12 rows [RowBegin, RowEnd) into a BGRA view of the same size. */
+inline void ConvertNV12ToBGRA(const FFrameView& Source, const FFrameView& Dest, int32_t RowBegin, int32_t RowEnd)
+{
+    for (int32_t Y = RowBegin; Y < RowEnd; ++Y)
+    {
+        const uint8_t* Luma = Source.Row(0, Y);
+        const uint8_t* Chroma = Source.Row(1, Y / 2);
+        uint32_t* Out = reinterpret_cast<uint32_t*>(Dest.Row(0, Y));
+        int32_t X = 0;
+        for (; X + 1 < Source.Width; X += 2)
+        {
+            FChromaTerms Terms = ChromaTerms709(Chroma[X], Chroma[X + 1]);
+            Out[X] = PackBgra(Luma[X], Terms);
+            Out[X + 1] = PackBgra(Luma[X + 1], Terms);
+        }
+        if (X < Source.Width) Out[X] = YuvToBgra709(Luma[X], Chroma[X], Chroma[X + 1]);
+    }
+}
+
+/** Converts rows [RowBegin, RowEnd) of a half-size BGRA view: one luma sample per 2x2 block, chroma as stored. */
+inline void ConvertNV12ToBGRAHalf(const FFrameView& Source, const FFrameView& Dest, int32_t RowBegin, int32_t RowEnd)
+{
+    for (int32_t Y = RowBegin; Y < RowEnd; ++Y)
+    {
+        const uint8_t* Luma = Source.Row(0, Y * 2);
+        const uint8_t* Chroma = Source.Row(1, Y);
+        uint32_t* Out = reinterpret_cast<uint32_t*>(Dest.Row(0, Y));
+        for (int32_t X = 0; X < Dest.Width; ++X)
+        {
+            Out[X] = YuvToBgra709(Luma[X * 2], Chroma[X * 2], Chroma[X * 2 + 1]);
+        }
+    }
+}
+
+/** Bilinear lookup for one destination coordinate: source index pair and 8-bit weight of the second. */
+struct FScaleTap
+{
+    int32_t Index0 = 0;
+    int32_t Index1 = 0;
+    uint32_t Weight = 0;
+};
+
+inline std::vector<FScaleTap> BuildScaleTaps(int32_t DestSize, int32_t SourceOffset, int32_t SourceSize)
+{
+    std::vector<FScaleTap> Taps(DestSize > 0 ? DestSize : 0);
+    if (DestSize <= 0 || SourceSize <= 0) return Taps;
+    // Pixel-center mapping in 16.16 fixed point.
+    int64_t Step = (static_cast<int64_t>(SourceSize) << 16) / DestSize;
+    int64_t Position = Step / 2 - (1 << 15);
+    for (int32_t Index = 0; Index < DestSize; ++Index, Position += Step)
+    {
+        int64_t Clamped = Position < 0 ? 0 : Position;
+        int32_t Whole = static_cast<int32_t>(Clamped >> 16);
+        if (Whole > SourceSize - 1) Whole = SourceSize - 1;
+        FScaleTap& Tap = Taps[Index];
+        Tap.Index0 = SourceOffset + Whole;
+        Tap.Index1 = SourceOffset + (Whole + 1 < SourceSize ? Whole + 1 : Whole);
+        Tap.Weight = static_cast<uint32_t>((Clamped >> 8) & 0xFF);
+    }
+    return Taps;
+}
+
+inline uint32_t LerpBgra(uint32_t A, uint32_t B, uint32_t Weight)
+{
+    // Two channels per 32-bit lane: (0x00RR00BB) and (0x00AA00GG).
+    uint32_t InvWeight = 256 - Weight;
+    uint32_t RedBlue = (((A & 0x00FF00FFu) * InvWeight + (B & 0x00FF00FFu) * Weight) >> 8) & 0x00FF00FFu;
+    uint32_t AlphaGreen = ((((A >> 8) & 0x00FF00FFu) * InvWeight + ((B >> 8) & 0x00FF00FFu) * Weight)) & 0xFF00FF00u;
+    return RedBlue | AlphaGreen;
+}
+
+class FSoftwareCompositor
+{
+public:
+    explicit FSoftwareCompositor(FThreadPool& InPool) : Pool(InPool)
+    {
+        Canvas.SetResourceTag("Compositor.Canvas");
+        Converted.SetResourceTag("Compositor.Converted");
+    }
+
+    /** Sets the canvas size and outputs; taps are rebuilt lazily on the first frame of each source size. */
+    void Configure(int32_t CanvasWidth, int32_t CanvasHeight, const std::vector<FCompositorOutput>& InOutputs)
+    {
+        Canvas.Allocate(CanvasWidth, CanvasHeight, EPixelFormat::BGRA8);
+        Outputs.clear();
+        for (const auto& Output : InOutputs)
+        {
+            FOutputState State;
+            State.Config = Output;
+            State.Config.Target = IntersectRect(Output.Target, FIntRect{ 0, 0, CanvasWidth, CanvasHeight });
+            Outputs.push_back(State);
+        }
+        TapSourceWidth = TapSourceHeight = -1;
+    }
+
+    /**
+     * Converts YUV sources at 1/2^Shift resolution (0 or 1); scaling then works from the
+     * smaller frame. A quality knob: conversion cost drops 4x at Shift 1.
+     */
+    void SetSourceShift(int32_t Shift) { SourceShift = Shift > 0 ? 1 : 0; }
+
+    /** Frees the canvas and conversion buffer; the next Configure() allocates them again. */
+    void Release()
+    {
+        Canvas.Release();
+        Converted.Release();
+        Outputs.clear();
+        Tiles.clear();
+        Changes.Reset(0);
+        TapSourceWidth = TapSourceHeight = -1;
+    }
+
+    /**
+     * Converts (if needed) and scales Source into every output's canvas region. With a
+     * FadeFrom canvas of the same size, each tile is then mixed from it at FadeWeight
+     * (CrossfadeWeightOne = Source only), before change detection sees it.
+     */
+    void Compose(const FFrameView& Source, const FFrameView& FadeFrom = {}, uint32_t FadeWeight = CrossfadeWeightOne)
+    {
+        if (!Source.IsValid() || !Canvas.GetView().IsValid()) return;
+        TRACE_SCOPE("Compositor.Compose");
+
+        FFrameView Bgra = Source;
+        bool bYuv = Source.Format == EPixelFormat::NV12 || Source.Format == EPixelFormat::P010;
+        int32_t Shift = bYuv && Source.Width >= 2 && Source.Height >= 2 ? SourceShift : 0;
+        int64_t StartNs = TraceNowNs();
+        if (Source.Format != EPixelFormat::BGRA8)
+        {
+            TRACE_SCOPE("Compositor.Convert");
+            Converted.Allocate(Source.Width >> Shift, Source.Height >> Shift, EPixelFormat::BGRA8);
+            const FFrameView& Dest = Converted.GetView();
+            if (Source.Format == EPixelFormat::P010 && !ToneMap.IsBuilt()) ToneMap.Build(FToneMapSettings{});
+            int32_t Bands = (Dest.Height + ConvertBandRows - 1) / ConvertBandRows;
+            Pool.ParallelFor(static_cast<size_t>(Bands), [&](size_t Band)
+            {
+                int32_t RowBegin = static_cast<int32_t>(Band) * ConvertBandRows;
+                int32_t RowEnd = RowBegin + ConvertBandRows < Dest.Height ? RowBegin + ConvertBandRows : Dest.Height;
+                if (Source.Format == EPixelFormat::P010)
+                {
+                    if (Shift) ConvertP010ToBGRAHalf(ToneMap, Source, Dest, RowBegin, RowEnd);
+                    else ConvertP010ToBGRA(ToneMap, Source, Dest, RowBegin, RowEnd);
+                    return;
+                }
+                if (Source.Format != EPixelFormat::NV12) return;
+                if (Shift) ConvertNV12ToBGRAHalf(Source, Dest, RowBegin, RowEnd);
+                else ConvertNV12ToBGRA(Source, Dest, RowBegin, RowEnd);
+            });
+            Bgra = Dest;
+        }
+        int64_t ConvertedNs = TraceNowNs();
+        Stats.Convert.Add(ConvertedNs - StartNs);
+
+        {
+            TRACE_SCOPE("Compositor.Scale");
+            if
+            (
+                Bgra.Width != TapSourceWidth || Bgra.Height != TapSourceHeight || Shift != TapShift
+            ) RebuildTaps(Bgra.Width, Bgra.Height, Shift);
+            bool bFade = FadeWeight < CrossfadeWeightOne && FadeFrom.IsValid()
+                && FadeFrom.Width == Canvas.GetView().Width && FadeFrom.Height == Canvas.GetView().Height;
+            Pool.ParallelFor(Tiles.size(), [&](size_t TileIndex)
+            {
+                const FTileJob& Job = Tiles[TileIndex];
+                ScaleTile(Bgra, Outputs[Job.Output], Job.Tile);
+                if (bFade) FadeTile(FadeFrom, Job.Tile, FadeWeight);
+                Changes.Update(TileIndex, HashTileBgra(Canvas.GetView(), Job.Tile));
+            });
+            Changes.EndFrame();
+        }
+        Stats.Scale.Add(TraceNowNs() - ConvertedNs);
+        ++Stats.Frames;
+
+        size_t DirtyTiles = Changes.CountDirty(0, Changes.Size());
+        Stats.TilesTotal += Tiles.size();
+        Stats.TilesDirty += DirtyTiles;
+        if (!DirtyTiles) ++Stats.StaticFrames;
+        for (auto& Output : Outputs)
+        {
+            CoalesceDirtyTiles(Output.Grid, Changes.GetDirtyFlags() + Output.FirstTile, MaxDirtyRects, Output.DirtyRects);
+        }
+    }
+
+    /** True when the last Compose() changed no canvas pixel, so nothing needs presenting. */
+    bool IsStatic() const { return Changes.CountDirty(0, Changes.Size()) == 0; }
+
+    /** Changed regions of one output in the last Compose(), relative to its GetOutputView(). */
+    const std::vector<FIntRect>& GetDirtyRects(size_t Index) const { return Outputs[Index].DirtyRects; }
+
+    /** Makes the next Compose() report every tile dirty. */
+    void InvalidateChanges() { Changes.Invalidate(); }
+
+    void RecordPresent(int64_t Ns) { Stats.Present.Add(Ns); }
+
+    const FFrameView& GetCanvas() const { return Canvas.GetView(); }
+    FFrameView GetOutputView(size_t Index) const
+    {
+        return Index < Outputs.size() ? Canvas.GetView().Crop(Outputs[Index].Config.Target) : FFrameView{};
+    }
+    size_t GetOutputCount() const { return Outputs.size(); }
+    size_t GetTileCount() const { return Tiles.size(); }
+    const FCompositorStats& GetStats() const { return Stats; }
+
+private:
+    struct FOutputState
+    {
+        FCompositorOutput Config;
+        std::vector<FScaleTap> TapsX;
+        std::vector<FScaleTap> TapsY;
+        FTileGrid Grid;             // Output-local tile grid
+        size_t FirstTile = 0;       // Index of its first tile in Tiles
+        std::vector<FIntRect> DirtyRects;
+    };
+
+    struct FTileJob
+    {
+        size_t Output = 0;
+        FIntRect Tile;
+    };
+
+    /** Crops are given in full-resolution source pixels; Shift maps them onto a reduced conversion. */
+    void RebuildTaps(int32_t SourceWidth, int32_t SourceHeight, int32_t Shift)
+    {
+        TapSourceWidth = SourceWidth;
+        TapSourceHeight = SourceHeight;
+        TapShift = Shift;
+        Tiles.clear();
+        for (size_t Index = 0; Index < Outputs.size(); ++Index)
+        {
+            FOutputState& State = Outputs[Index];
+            const FIntRect& SourceCrop = State.Config.SourceCrop;
+            FIntRect Crop = SourceCrop.IsEmpty()
+                ? FIntRect{ 0, 0, SourceWidth, SourceHeight }
+                : IntersectRect
+                (
+                    FIntRect{ SourceCrop.Left >> Shift, SourceCrop.Top >> Shift, SourceCrop.Right >> Shift, SourceCrop.Bottom >> Shift },
+                    FIntRect{ 0, 0, SourceWidth, SourceHeight }
+                );
+            const FIntRect& Target = State.Config.Target;
+            State.TapsX = BuildScaleTaps(Target.Width(), Crop.Left, Crop.Width());
+            State.TapsY = BuildScaleTaps(Target.Height(), Crop.Top, Crop.Height());
+
+            // Tiles are laid out relative to the output so dirty rects come out in its coordinates.
+            State.Grid.Reset(FIntRect{ 0, 0, Target.Width(), Target.Height() }, CompositorTileSize);
+            State.FirstTile = Tiles.size();
+            for (int32_t Tile = 0; Tile < State.Grid.Count(); ++Tile)
+            {
+                FIntRect Local = State.Grid.GetTile(Tile);
+                Tiles.push_back
+                ({
+                    Index,
+                    { Local.Left + Target.Left, Local.Top + Target.Top, Local.Right + Target.Left, Local.Bottom + Target.Top }
+                });
+            }
+        }
+        Changes.Reset(Tiles.size());
+    }
+
+    void ScaleTile(const FFrameView& Source, const FOutputState& State, const FIntRect& Tile) const
+    {
+        const FFrameView& Dest = Canvas.GetView();
+        const FIntRect& Target = State.Config.Target;
+        for (int32_t Y = Tile.Top; Y < Tile.Bottom; ++Y)
+        {
+            const FScaleTap& TapY = State.TapsY[Y - Target.Top];
+            const uint32_t* Row0 = reinterpret_cast<const uint32_t*>(Source.Row(0, TapY.Index0));
+            const uint32_t* Row1 = reinterpret_cast<const uint32_t*>(Source.Row(0, TapY.Index1));
+            uint32_t* Out = reinterpret_cast<uint32_t*>(Dest.Row(0, Y));
+            for (int32_t X = Tile.Left; X < Tile.Right; ++X)
+            {
+                const FScaleTap& TapX = State.TapsX[X - Target.Left];
+                uint32_t Top = LerpBgra(Row0[TapX.Index0], Row0[TapX.Index1], TapX.Weight);
+                uint32_t Bottom = LerpBgra(Row1[TapX.Index0], Row1[TapX.Index1], TapX.Weight);
+                Out[X] = LerpBgra(Top, Bottom, TapY.Weight);
+            }
+        }
+    }
+
+    void FadeTile(const FFrameView& From, const FIntRect& Tile, uint32_t Weight) const
+    {
+        const FFrameView& Dest = Canvas.GetView();
+        for (int32_t Y = Tile.Top; Y < Tile.Bottom; ++Y)
+        {
+            uint32_t* Out = reinterpret_cast<uint32_t*>(Dest.Row(0, Y)) + Tile.Left;
+            const uint32_t* Outgoing = reinterpret_cast<const uint32_t*>(From.Row(0, Y)) + Tile.Left;
+            BlendBgraRow(Outgoing, Out, Out, Tile.Width(), Weight);
+        }
+    }
+
+    FThreadPool& Pool;
+    FFrame Canvas;
+    FFrame Converted;
+    FToneMapTables ToneMap;     // Built on the first P010 frame
+    std::vector<FOutputState> Outputs;
+    std::vector<FTileJob> Tiles;
+    FTileChangeDetector Changes;
+    int32_t TapSourceWidth = -1;
+    int32_t TapSourceHeight = -1;
+    int32_t TapShift = 0;
+    int32_t SourceShift = 0;
+    FCompositorStats Stats;
+};
@@ -0,0 +1,228 @@
+// compositor_bench - Software compositor checks and per-frame cost at 1080p and 4K.
+// Checks that an unscaled output reproduces the reference NV12 conversion exactly,
+// that source crops land in their own outputs, that every worker count composes
+// the same canvas, and that a repeated frame is reported static. Then composes
+// scrolling colour bars (every tile changes) from 1080p and 4K NV12 sources into
+// 1 to 4 side-by-side 1080p outputs, cloned or spanned, and prints the convert and
+// scale stage times per frame and the frame rate the CPU path could sustain.
+//   g++ -std=c++20 -O2 -pthread compositor_bench.cpp -o compositor_bench
+//   compositor_bench [--frames N] [--threads N] [--half 0|1]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "compositor.h"
+#include "pattern_source.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    struct FBenchOptions
+    {
+        int32_t Frames = 60;
+        int32_t Threads = 0;        // Pool workers; 0 picks hardware_concurrency - 1
+        int32_t Half = 0;           // Convert at half resolution (the quality step-down)
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--frames") Options.Frames = std::atoi(Value);
+            else if (Name == "--threads") Options.Threads = std::atoi(Value);
+            else if (Name == "--half") Options.Half = std::atoi(Value);
+            else return false;
+        }
+        return Options.Frames > 0 && Options.Threads >= 0 && (Options.Half == 0 || Options.Half == 1);
+    }
+
+    std::vector<FFrame> RenderFrames(int32_t Width, int32_t Height, EPatternScene Scene, int32_t Count)
+    {
+        FPatternSettings Settings;
+        Settings.Width = Width;
+        Settings.Height = Height;
+        Settings.Scene = Scene;
+        FPatternSource Source(Settings);
+        std::vector<FFrame> Frames(static_cast<size_t>(Count));
+        for (FFrame& Frame : Frames) Source.ReadFrame(Frame);
+        return Frames;
+    }
+
+    /** Side-by-side 1080p outputs; cloned outputs show the whole frame, spanned ones a slice each. */
+    std::vector<FCompositorOutput> MakeOutputs(int32_t Count, int32_t SourceWidth, int32_t SourceHeight, bool bSpan)
+    {
+        std::vector<FCompositorOutput> Outputs;
+        for (int32_t Index = 0; Index < Count; ++Index)
+        {
+            FCompositorOutput Output;
+            Output.Target = { Index * 1920, 0, (Index + 1) * 1920, 1080 };
+            if (bSpan) Output.SourceCrop = { SourceWidth * Index / Count, 0, SourceWidth * (Index + 1) / Count, SourceHeight };
+            Outputs.push_back(Output);
+        }
+        return Outputs;
+    }
+
+    bool SameView(const FFrameView& A, const FFrameView& B)
+    {
+        if (A.Width != B.Width || A.Height != B.Height) return false;
+        for (int32_t Y = 0; Y < A.Height; ++Y)
+        {
+            if (std::memcmp(A.Row(0, Y), B.Row(0, Y), static_cast<size_t>(A.Width) * 4) != 0) return false;
+        }
+        return true;
+    }
+
+    bool CheckIdentity()
+    {
+        std::vector<FFrame> Frames = RenderFrames(640, 360, EPatternScene::Motion, 1);
+        const FFrameView& Source = Frames[0].GetView();
+        FFrame Reference(Source.Width, Source.Height, EPixelFormat::BGRA8);
+        ConvertNV12ToBGRA(Source, Reference.GetView(), 0, Source.Height);
+
+        FThreadPool Pool(3);
+        FSoftwareCompositor Compositor(Pool);
+        Compositor.Configure(Source.Width, Source.Height, { FCompositorOutput{ { 0, 0, Source.Width, Source.Height }, {} } });
+        Compositor.Compose(Source);
+        return Check(SameView(Compositor.GetOutputView(0), Reference.GetView()), "unscaled output matches the reference conversion");
+    }
+
+    bool CheckCrops()
+    {
+        // Left half red, right half blue; each spanned output must show only its own half.
+        FFrame Source(256, 128, EPixelFormat::BGRA8);
+        const FFrameView& View = Source.GetView();
+        for (int32_t Y = 0; Y < View.Height; ++Y)
+        {
+            uint32_t* Row = reinterpret_cast<uint32_t*>(View.Row(0, Y));
+            for (int32_t X = 0; X < View.Width; ++X) Row[X] = X < View.Width / 2 ? 0xFFFF0000u : 0xFF0000FFu;
+        }
+
+        FThreadPool Pool(2);
+        FSoftwareCompositor Compositor(Pool);
+        Compositor.Configure(400, 100, { { { 0, 0, 200, 100 }, { 0, 0, 128, 128 } }, { { 200, 0, 400, 100 }, { 128, 0, 256, 128 } } });
+        Compositor.Compose(View);
+        bool bLeft = true;
+        bool bRight = true;
+        for (int32_t Y = 0; Y < 100; ++Y)
+        {
+            const uint32_t* Left = reinterpret_cast<const uint32_t*>(Compositor.GetOutputView(0).Row(0, Y));
+            const uint32_t* Right = reinterpret_cast<const uint32_t*>(Compositor.GetOutputView(1).Row(0, Y));
+            for (int32_t X = 0; X < 200; ++X)
+            {
+                bLeft &= Left[X] == 0xFFFF0000u;
+                bRight &= Right[X] == 0xFF0000FFu;
+            }
+        }
+        bool bPass = Check(bLeft && bRight, "source crops land in their own outputs");
+        bPass &= Check(Compositor.GetOutputView(1).Width == 200 && Compositor.GetOutputCount() == 2, "output views match their targets");
+        return bPass;
+    }
+
+    bool CheckWorkerCounts()
+    {
+        std::vector<FFrame> Frames = RenderFrames(3840, 2160, EPatternScene::Motion, 1);
+        std::vector<FCompositorOutput> Outputs = MakeOutputs(3, 3840, 2160, true);
+        FThreadPool Inline(1);
+        FSoftwareCompositor Reference(Inline);
+        Reference.Configure(3 * 1920, 1080, Outputs);
+        Reference.Compose(Frames[0].GetView());
+
+        bool bSame = true;
+        for (size_t Workers : { size_t(2), size_t(3), size_t(7) })
+        {
+            FThreadPool Pool(Workers);
+            FSoftwareCompositor Compositor(Pool);
+            Compositor.Configure(3 * 1920, 1080, Outputs);
+            Compositor.Compose(Frames[0].GetView());
+            bSame &= SameView(Compositor.GetCanvas(), Reference.GetCanvas());
+        }
+        return Check(bSame, "every worker count composes the same canvas");
+    }
+
+    bool CheckStatic()
+    {
+        std::vector<FFrame> Frames = RenderFrames(1920, 1080, EPatternScene::Static, 2);
+        FThreadPool Pool(3);
+        FSoftwareCompositor Compositor(Pool);
+        Compositor.Configure(2 * 1920, 1080, MakeOutputs(2, 1920, 1080, false));
+        Compositor.Compose(Frames[0].GetView());
+        bool bPass = Check(!Compositor.IsStatic(), "first frame is dirty");
+        Compositor.Compose(Frames[0].GetView());
+        bPass &= Check(Compositor.IsStatic() && Compositor.GetDirtyRects(0).empty(), "repeated frame is static");
+        Compositor.Compose(Frames[1].GetView());
+        bPass &= Check(!Compositor.IsStatic() && !Compositor.GetDirtyRects(1).empty(), "moving box dirties both clones");
+        const FCompositorStats& Stats = Compositor.GetStats();
+        bPass &= Check(Stats.Frames == 3 && Stats.StaticFrames == 1, "frames and static frames counted");
+        return bPass;
+    }
+
+    void RunBenchmark(const FBenchOptions& Options)
+    {
+        FThreadPool Pool(static_cast<size_t>(Options.Threads));
+        std::printf("ms per frame, %d frame(s), %s conversion\n", Options.Frames, Options.Half ? "half-size" : "full-size");
+        std::printf("%-6s %-6s %7s %9s %9s %9s %8s\n", "source", "mode", "outputs", "convert", "scale", "total", "fps");
+
+        const int32_t SourceSizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+        for (const auto& Size : SourceSizes)
+        {
+            std::vector<FFrame> Frames = RenderFrames(Size[0], Size[1], EPatternScene::Bars, 4);
+            for (bool bSpan : { false, true })
+            {
+                for (int32_t Count = 1; Count <= 4; ++Count)
+                {
+                    if (bSpan && Count == 1) continue;
+                    FSoftwareCompositor Compositor(Pool);
+                    Compositor.SetSourceShift(Options.Half);
+                    Compositor.Configure(Count * 1920, 1080, MakeOutputs(Count, Size[0], Size[1], bSpan));
+                    Compositor.Compose(Frames[0].GetView());
+
+                    double ConvertNs = 0.0;
+                    double ScaleNs = 0.0;
+                    auto Start = std::chrono::steady_clock::now();
+                    for (int32_t Frame = 0; Frame < Options.Frames; ++Frame)
+                    {
+                        Compositor.Compose(Frames[static_cast<size_t>(Frame) % Frames.size()].GetView());
+                        ConvertNs += static_cast<double>(Compositor.GetStats().Convert.LastNs);
+                        ScaleNs += static_cast<double>(Compositor.GetStats().Scale.LastNs);
+                    }
+                    double TotalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / Options.Frames;
+                    std::printf("%-6s %-6s %7d %9.2f %9.2f %9.2f %8.1f\n", Size[1] == 2160 ? "4K" : "1080p", bSpan ? "span" : "clone",
+                        Count, ConvertNs / Options.Frames / 1e6, ScaleNs / Options.Frames / 1e6, TotalMs, TotalMs > 0.0 ? 1000.0 / TotalMs : 0.0);
+                }
+            }
+        }
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: compositor_bench [--frames N] [--threads N] [--half 0|1]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckIdentity(), "identity");
+    bPass &= Check(CheckCrops(), "crops");
+    bPass &= Check(CheckWorkerCounts(), "worker counts");
+    bPass &= Check(CheckStatic(), "static frames");
+    RunBenchmark(Options);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
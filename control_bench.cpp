@@ -0,0 +1,482 @@
+// control_bench - Tests of the control protocol and the Unix-socket control server (Linux).
+// Protocol: every command parses with and without its argument, frames are put back
+// together from every split of a request stream, an oversized frame ends the
+// connection and replies round-trip. Server: the socket file is 0600 under any umask,
+// a second instance and a path that is not a socket are refused, a stale socket is
+// replaced, requests are answered in order over byte-at-a-time writes, pipelined
+// writes and several clients at once, a framing error or one client too many closes
+// the connection, and the file is gone after shutdown. Run as root it also checks
+// that another user is kept out twice: by the file mode, and by the peer-credential
+// check when the mode is opened up. Then times request round trips.
+//   g++ -std=c++20 -O2 -pthread control_bench.cpp -o control_bench
+//   control_bench [--requests N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_socket.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    struct FBenchOptions
+    {
+        int32_t Requests = 20000;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--requests") Options.Requests = std::atoi(Value);
+            else return false;
+        }
+        return Options.Requests > 0;
+    }
+
+    /** Answers every request with its command name and argument, so replies show what was parsed. */
+    FControlResponse EchoRequest(const FControlRequest& Request)
+    {
+        for (const auto& Info : ControlCommands)
+        {
+            if (Info.Command == Request.Command) return { true, std::string(Info.Name) + (Request.Argument.empty() ? "" : " " + Request.Argument) };
+        }
+        return { false, "unreachable" };
+    }
+
+    std::string Frame(const std::string& Payload)
+    {
+        std::string Out;
+        AppendControlFrame(Out, Payload);
+        return Out;
+    }
+
+    /** Payloads of every complete frame in Data. */
+    std::vector<std::string> Unframe(const std::string& Data)
+    {
+        FControlFrameReader Reader;
+        Reader.Append(Data.data(), Data.size());
+        std::vector<std::string> Payloads;
+        std::string Payload;
+        while (Reader.Next(Payload) == EControlFrameResult::Frame) Payloads.push_back(Payload);
+        return Payloads;
+    }
+
+    bool CheckParsing()
+    {
+        bool bParsed = true;
+        for (const auto& Info : ControlCommands)
+        {
+            FControlRequest Request;
+            FControlResponse Error;
+            std::string Text = std::string("  ") + Info.Name + (Info.bNeedsArgument ? "  some argument \r\n" : "\n");
+            bParsed &= ParseControlRequest(Text, Request, Error) && Request.Command == Info.Command;
+            bParsed &= Request.Argument == (Info.bNeedsArgument ? "some argument" : "");
+            if (!Info.bNeedsArgument) continue;
+            FControlRequest Bare;
+            bParsed &= !ParseControlRequest(Info.Name, Bare, Error) && !Error.bOk && Error.Text.find("needs an argument") != std::string::npos;
+        }
+
+        FControlRequest Request;
+        FControlResponse Error;
+        bool bUnknown = !ParseControlRequest("frobnicate now", Request, Error) && Error.Text == "unknown command 'frobnicate'";
+        bool bEmpty = !ParseControlRequest("   ", Request, Error) && !Error.bOk;
+
+        bool bRoundTrip = true;
+        for (const FControlResponse& Response : { FControlResponse{ true, "" }, FControlResponse{ false, "file not found" }, FControlResponse{ true, "\nvideo=a b\nstate=paused" } })
+        {
+            FControlResponse Parsed = ParseControlResponse(FormatControlResponse(Response));
+            bRoundTrip &= Parsed.bOk == Response.bOk && Parsed.Text == TrimControlText(Response.Text);
+        }
+
+        bool bPass = Check(bParsed, "every command parses, arguments are required");
+        bPass &= Check(bUnknown && bEmpty, "unknown and empty commands are errors");
+        bPass &= Check(bRoundTrip, "responses round-trip");
+        return bPass;
+    }
+
+    bool CheckFraming()
+    {
+        std::string Stream = Frame("status") + Frame("video /tmp/a clip.mp4") + Frame("nonsense") + Frame("set lowpower_fps 3") + Frame("");
+        std::string Expected;
+        {
+            FControlConnection Connection;
+            Connection.Receive(Stream.data(), Stream.size(), EchoRequest, Expected);
+        }
+        std::vector<std::string> Replies = Unframe(Expected);
+        bool bReplies = Replies.size() == 5 && Replies[0] == "ok status" && Replies[1] == "ok video /tmp/a clip.mp4"
+            && Replies[2] == "error unknown command 'nonsense'" && Replies[3] == "ok set lowpower_fps 3" && Replies[4].starts_with("error");
+
+        // Two cuts anywhere in the stream: the replies must not depend on how reads split it.
+        bool bSplits = true;
+        for (size_t First = 0; First <= Stream.size(); ++First)
+        {
+            for (size_t Second = First; Second <= Stream.size(); Second += 3)
+            {
+                FControlConnection Connection;
+                std::string Out;
+                bool bValid = Connection.Receive(Stream.data(), First, EchoRequest, Out);
+                bValid &= Connection.Receive(Stream.data() + First, Second - First, EchoRequest, Out);
+                bValid &= Connection.Receive(Stream.data() + Second, Stream.size() - Second, EchoRequest, Out);
+                bSplits &= bValid && Out == Expected;
+            }
+        }
+
+        std::string Oversized;
+        uint32_t Size = MaxControlFrameBytes + 1;
+        for (int32_t Byte = 0; Byte < 4; ++Byte) Oversized += static_cast<char>((Size >> (8 * Byte)) & 0xFF);
+        FControlConnection Connection;
+        std::string Out;
+        bool bReceived = Connection.Receive(Oversized.data(), Oversized.size(), EchoRequest, Out);
+
+        bool bPass = Check(bReplies, "requests answered in order, errors without the handler");
+        bPass &= Check(bSplits, "replies independent of read splits");
+        bPass &= Check(!bReceived && Out.empty(), "oversized frame ends the connection");
+        return bPass;
+    }
+
+    /** A private directory for the sockets of one run. */
+    class FScratchDir
+    {
+    public:
+        FScratchDir()
+        {
+            char Template[] = "/tmp/control_bench.XXXXXX";
+            if (mkdtemp(Template)) Path = Template;
+        }
+
+        ~FScratchDir()
+        {
+            if (Path.empty()) return;
+            for (const char* Name : { "/a.sock", "/b.sock", "/c.sock", "/file" }) unlink((Path + Name).c_str());
+            rmdir(Path.c_str());
+        }
+
+        std::string Path;
+    };
+
+    /** Runs the server loop on its own thread, as main_x11.cpp runs it in its event loop. */
+    class FServerThread
+    {
+    public:
+        explicit FServerThread(FControlSocketServer& InServer)
+            : Server(InServer)
+            , Thread([this] { Run(); })
+        {
+        }
+
+        ~FServerThread() { Stop(); }
+
+        void Stop()
+        {
+            bQuit.store(true, std::memory_order_relaxed);
+            if (Thread.joinable()) Thread.join();
+        }
+
+        uint64_t GetHandled() const { return Handled.load(std::memory_order_relaxed); }
+
+    private:
+        void Run()
+        {
+            std::vector<pollfd> Polls;
+            while (!bQuit.load(std::memory_order_relaxed))
+            {
+                Polls.clear();
+                Server.AddPolls(Polls);
+                if (poll(Polls.data(), Polls.size(), 10) <= 0) continue;
+                Server.Dispatch(Polls.data(), [this](const FControlRequest& Request)
+                {
+                    Handled.fetch_add(1, std::memory_order_relaxed);
+                    return EchoRequest(Request);
+                });
+            }
+        }
+
+        FControlSocketServer& Server;
+        std::atomic<bool> bQuit{ false };
+        std::atomic<uint64_t> Handled{ 0 };
+        std::thread Thread;
+    };
+
+    int Connect(const std::string& Path)
+    {
+        sockaddr_un Address = {};
+        Address.sun_family = AF_UNIX;
+        Path.copy(Address.sun_path, sizeof(Address.sun_path) - 1);
+        int Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (Socket >= 0 && connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0) return Socket;
+        if (Socket >= 0) close(Socket);
+        return -1;
+    }
+
+    bool SendBytes(int Socket, const std::string& Data, size_t Chunk)
+    {
+        for (size_t Offset = 0; Offset < Data.size(); Offset += Chunk)
+        {
+            size_t Size = Data.size() - Offset < Chunk ? Data.size() - Offset : Chunk;
+            if (send(Socket, Data.data() + Offset, Size, MSG_NOSIGNAL) != static_cast<ssize_t>(Size)) return false;
+        }
+        return true;
+    }
+
+    /** Reads until Count replies arrived; stops early if the server closes or goes quiet for a second. */
+    std::vector<std::string> ReadReplies(int Socket, size_t Count, bool* bClosed = nullptr)
+    {
+        FControlFrameReader Reader;
+        std::vector<std::string> Replies;
+        std::string Payload;
+        char Buffer[4096];
+        if (bClosed) *bClosed = false;
+        while (Replies.size() < Count)
+        {
+            if (Reader.Next(Payload) == EControlFrameResult::Frame)
+            {
+                Replies.push_back(Payload);
+                continue;
+            }
+            pollfd Poll = { Socket, POLLIN, 0 };
+            if (poll(&Poll, 1, 1000) <= 0) break;
+            ssize_t Read = recv(Socket, Buffer, sizeof(Buffer), 0);
+            if (Read <= 0)
+            {
+                if (bClosed) *bClosed = true;
+                break;
+            }
+            Reader.Append(Buffer, static_cast<size_t>(Read));
+        }
+        return Replies;
+    }
+
+    /** True if the server closes Socket without answering. */
+    bool IsClosedWithoutReply(int Socket)
+    {
+        bool bClosed = false;
+        std::vector<std::string> Replies = ReadReplies(Socket, 1, &bClosed);
+        return bClosed && Replies.empty();
+    }
+
+    bool CheckListen(const FScratchDir& Dir)
+    {
+        std::string Path = Dir.Path + "/a.sock";
+        std::string Error;
+        mode_t PreviousMask = umask(0);
+        bool bListening;
+        struct stat FileInfo = {};
+        bool bPrivate;
+        bool bSecondRefused;
+        {
+            FControlSocketServer Server(Path);
+            bListening = Server.Listen(Error);
+            umask(PreviousMask);
+            bPrivate = stat(Path.c_str(), &FileInfo) == 0 && S_ISSOCK(FileInfo.st_mode) && (FileInfo.st_mode & 0777) == 0600;
+
+            FControlSocketServer Second(Path);
+            bSecondRefused = !Second.Listen(Error) && Error.find("another instance") != std::string::npos;
+        }
+        bool bRemoved = access(Path.c_str(), F_OK) != 0;
+
+        // A socket left bound by a process that died: nothing answers, so it is replaced.
+        {
+            sockaddr_un Address = {};
+            Address.sun_family = AF_UNIX;
+            Path.copy(Address.sun_path, Path.size());
+            int Stale = socket(AF_UNIX, SOCK_STREAM, 0);
+            bind(Stale, reinterpret_cast<sockaddr*>(&Address), sizeof(Address));
+            close(Stale);
+        }
+        bool bStaleReplaced;
+        {
+            FControlSocketServer Server(Path);
+            bStaleReplaced = Server.Listen(Error);
+        }
+
+        std::string FilePath = Dir.Path + "/file";
+        std::FILE* File = std::fopen(FilePath.c_str(), "w");
+        if (File) std::fclose(File);
+        FControlSocketServer OverFile(FilePath);
+        bool bFileKept = !OverFile.Listen(Error) && access(FilePath.c_str(), F_OK) == 0;
+
+        bool bPass = Check(bListening && bPrivate, "socket file is 0600 under umask 000");
+        bPass &= Check(bSecondRefused, "second instance refused");
+        bPass &= Check(bRemoved, "socket file removed at shutdown");
+        bPass &= Check(bStaleReplaced, "stale socket replaced");
+        bPass &= Check(bFileKept, "a file that is not a socket is left alone");
+        return bPass;
+    }
+
+    bool CheckServing(const FScratchDir& Dir)
+    {
+        std::string Path = Dir.Path + "/b.sock";
+        std::string Error;
+        FControlSocketServer Server(Path);
+        if (!Check(Server.Listen(Error), "listen")) return false;
+        FServerThread Loop(Server);
+
+        // One byte per write.
+        int Slow = Connect(Path);
+        bool bSlow = Slow >= 0 && SendBytes(Slow, Frame("video /tmp/x.mp4") + Frame("pause"), 1);
+        std::vector<std::string> SlowReplies = ReadReplies(Slow, 2);
+        bSlow &= SlowReplies.size() == 2 && SlowReplies[0] == "ok video /tmp/x.mp4" && SlowReplies[1] == "ok pause";
+
+        // Many requests in one write, answered in order.
+        std::string Burst;
+        for (int32_t Index = 0; Index < 200; ++Index) Burst += Frame("set key " + std::to_string(Index));
+        int Pipelined = Connect(Path);
+        bool bOrdered = Pipelined >= 0 && SendBytes(Pipelined, Burst, Burst.size());
+        std::vector<std::string> Replies = ReadReplies(Pipelined, 200);
+        bOrdered &= Replies.size() == 200;
+        for (size_t Index = 0; bOrdered && Index < Replies.size(); ++Index) bOrdered &= Replies[Index] == "ok set key " + std::to_string(Index);
+
+        // Several clients with requests in flight at once.
+        std::vector<int> Clients;
+        for (int32_t Index = 0; Index < 5; ++Index) Clients.push_back(Connect(Path));
+        bool bConcurrent = true;
+        for (size_t Index = 0; Index < Clients.size(); ++Index) bConcurrent &= Clients[Index] >= 0 && SendBytes(Clients[Index], Frame("video " + std::to_string(Index)), 3);
+        for (size_t Index = Clients.size(); Index-- > 0;)
+        {
+            std::vector<std::string> Reply = ReadReplies(Clients[Index], 1);
+            bConcurrent &= Reply.size() == 1 && Reply[0] == "ok video " + std::to_string(Index);
+        }
+
+        // 2 + 5 connected: one more fits, the one after that is closed.
+        int Last = Connect(Path);
+        int Extra = Connect(Path);
+        bool bLimited = Last >= 0 && SendBytes(Last, Frame("status"), 64) && ReadReplies(Last, 1).size() == 1;
+        // The server may close it before the request is out, so the send is allowed to fail.
+        if (Extra >= 0) SendBytes(Extra, Frame("status"), 64);
+        bLimited &= Extra >= 0 && IsClosedWithoutReply(Extra);
+
+        // A framing error closes only that connection.
+        std::string Oversized(4, '\xFF');
+        bool bBroken = SendBytes(Slow, Oversized, 4) && IsClosedWithoutReply(Slow);
+        bBroken &= SendBytes(Pipelined, Frame("status"), 64) && ReadReplies(Pipelined, 1).size() == 1;
+
+        for (int Socket : Clients) close(Socket);
+        for (int Socket : { Slow, Pipelined, Last, Extra }) close(Socket);
+        Loop.Stop();
+
+        bool bPass = Check(bSlow, "byte-at-a-time requests");
+        bPass &= Check(bOrdered, "pipelined requests answered in order");
+        bPass &= Check(bConcurrent, "concurrent clients");
+        bPass &= Check(bLimited, "clients beyond the limit are closed");
+        bPass &= Check(bBroken, "framing error closes its connection only");
+        bPass &= Check(Server.GetRejectedCount() == 0, "own connections not rejected");
+        return bPass;
+    }
+
+    /** Forks a client that drops to another user and connects; its exit code says what happened. */
+    int ConnectAsOtherUser(const std::string& Path)
+    {
+        pid_t Child = fork();
+        if (Child == 0)
+        {
+            if (setgid(65534) != 0 || setuid(65534) != 0) _exit(10);
+            int Socket = Connect(Path);
+            if (Socket < 0) _exit(errno == EACCES ? 3 : 11);
+            SendBytes(Socket, Frame("status"), 64);
+            _exit(IsClosedWithoutReply(Socket) ? 4 : 12);
+        }
+        int Status = 0;
+        if (Child < 0 || waitpid(Child, &Status, 0) != Child || !WIFEXITED(Status)) return -1;
+        return WEXITSTATUS(Status);
+    }
+
+    bool CheckOtherUser(const FScratchDir& Dir)
+    {
+        if (geteuid() != 0)
+        {
+            std::printf("other user: skipped (needs root to switch users)\n");
+            return true;
+        }
+        std::string Path = Dir.Path + "/c.sock";
+        std::string Error;
+        FControlSocketServer Server(Path);
+        if (!Check(Server.Listen(Error), "listen")) return false;
+        FServerThread Loop(Server);
+        // The directory is private to this run; let the other user reach the socket inside it.
+        chmod(Dir.Path.c_str(), 0711);
+
+        int ByMode = ConnectAsOtherUser(Path);
+        chmod(Path.c_str(), 0666);
+        int ByCredentials = ConnectAsOtherUser(Path);
+        Loop.Stop();
+        chmod(Dir.Path.c_str(), 0700);
+
+        bool bPass = Check(ByMode == 3, "other user refused by the socket mode");
+        bPass &= Check(ByCredentials == 4 && Server.GetRejectedCount() == 1, "other user closed by the peer check");
+        bPass &= Check(Loop.GetHandled() == 0, "other user's request never handled");
+        return bPass;
+    }
+
+    void RunBenchmark(const FScratchDir& Dir, int32_t Requests)
+    {
+        std::string Path = Dir.Path + "/a.sock";
+        std::string Error;
+        FControlSocketServer Server(Path);
+        if (!Server.Listen(Error)) return;
+        FServerThread Loop(Server);
+        int Socket = Connect(Path);
+        std::string Request = Frame("status");
+        auto Start = std::chrono::steady_clock::now();
+        int32_t Answered = 0;
+        for (; Answered < Requests; ++Answered)
+        {
+            if (!SendBytes(Socket, Request, Request.size()) || ReadReplies(Socket, 1).size() != 1) break;
+        }
+        double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        close(Socket);
+        std::printf
+        (
+            "round trips: %d in %.2f s, %.1f us each\n", Answered, Seconds,
+            Answered ? Seconds * 1e6 / Answered : 0.0
+        );
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: control_bench [--requests N]\n");
+        return 2;
+    }
+
+    FScratchDir Dir;
+    if (Dir.Path.empty())
+    {
+        std::fprintf(stderr, "Cannot create a scratch directory under /tmp.\n");
+        return 2;
+    }
+
+    bool bPass = true;
+    bPass &= Check(CheckParsing(), "parsing");
+    bPass &= Check(CheckFraming(), "framing");
+    bPass &= Check(CheckListen(Dir), "listen");
+    bPass &= Check(CheckServing(Dir), "serving");
+    bPass &= Check(CheckOtherUser(Dir), "other user");
+    RunBenchmark(Dir, Options.Requests);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
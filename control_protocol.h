@@ -0,0 +1,205 @@
+// ControlProtocol - Request/response protocol of the local control endpoint.
+// A frame is a 4-byte little-endian payload length followed by UTF-8 text. A
+// request is a command word with an optional argument ("pause", "video C:\a.mp4",
+// "set lowpower_fps 3"); a response is "ok" or "error", optionally followed by a
+// space and text (status is key=value lines). FControlConnection turns received
+// bytes into dispatched requests and framed responses, so the same server loop
+// runs over any byte stream: a named pipe on Windows, a Unix socket elsewhere.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/** Pipe name (\\.\pipe\VideoWallpaper.<session>) or socket file stem. */
+constexpr const char* ControlEndpointName = "VideoWallpaper";
+
+/** Larger frames are a protocol error; requests and status replies are tiny. */
+constexpr uint32_t MaxControlFrameBytes = 64 * 1024;
+
+enum class EControlCommand : uint8_t
+{
+    Unknown,
+    Status,     // Key=value snapshot of the running instance
+    Pause,
+    Resume,
+    Toggle,     // Same as the tray's Pause/Resume
+    Mute,
+    Unmute,
+    Video,      // <path>: switch videos (also rewrites config.txt line one)
+    Set,        // <key> <value>: a config.txt setting, applied live where possible
+    Reload,     // Rebuild windows and pipelines in place
+    Resources,  // Live resource counters (needs tracking enabled at startup)
+    Quit
+};
+
+struct FControlCommandInfo
+{
+    EControlCommand Command;
+    const char* Name;
+    bool bNeedsArgument;
+};
+
+inline constexpr FControlCommandInfo ControlCommands[] =
+{
+    { EControlCommand::Status, "status", false },
+    { EControlCommand::Pause, "pause", false },
+    { EControlCommand::Resume, "resume", false },
+    { EControlCommand::Toggle, "toggle", false },
+    { EControlCommand::Mute, "mute", false },
+    { EControlCommand::Unmute, "unmute", false },
+    { EControlCommand::Video, "video", true },
+    { EControlCommand::Set, "set", true },
+    { EControlCommand::Reload, "reload", false },
+    { EControlCommand::Resources, "resources", false },
+    { EControlCommand::Quit, "quit", false }
+};
+
+struct FControlRequest
+{
+    EControlCommand Command = EControlCommand::Unknown;
+    std::string Argument;
+};
+
+struct FControlResponse
+{
+    bool bOk = true;
+    std::string Text;
+};
+
+inline std::string_view TrimControlText(std::string_view Text)
+{
+    const char* Whitespace = " \t\r\n";
+    size_t Start = Text.find_first_not_of(Whitespace);
+    if (Start == std::string_view::npos) return {};
+    return Text.substr(Start, Text.find_last_not_of(Whitespace) - Start + 1);
+}
+
+/** Splits "word rest of line"; Rest is empty if there is no argument. */
+inline void SplitControlWord(std::string_view Text, std::string_view& Word, std::string_view& Rest)
+{
+    Text = TrimControlText(Text);
+    size_t Space = Text.find_first_of(" \t");
+    Word = Text.substr(0, Space);
+    Rest = Space == std::string_view::npos ? std::string_view() : TrimControlText(Text.substr(Space));
+}
+
+/** Fills Out.Text with the reason on failure. */
+inline bool ParseControlRequest(std::string_view Text, FControlRequest& Request, FControlResponse& Out)
+{
+    std::string_view Word;
+    std::string_view Rest;
+    SplitControlWord(Text, Word, Rest);
+    for (const auto& Info : ControlCommands)
+    {
+        if (Word != Info.Name) continue;
+        if (Info.bNeedsArgument && Rest.empty())
+        {
+            Out = { false, std::string(Info.Name) + " needs an argument" };
+            return false;
+        }
+        Request.Command = Info.Command;
+        Request.Argument.assign(Rest);
+        return true;
+    }
+    Out = { false, "unknown command '" + std::string(Word) + "'" };
+    return false;
+}
+
+inline std::string FormatControlResponse(const FControlResponse& Response)
+{
+    std::string Text = Response.bOk ? "ok" : "error";
+    if (!Response.Text.empty()) Text += ' ' + Response.Text;
+    return Text;
+}
+
+inline FControlResponse ParseControlResponse(std::string_view Text)
+{
+    std::string_view Word;
+    std::string_view Rest;
+    SplitControlWord(Text, Word, Rest);
+    return { Word == "ok", std::string(Rest) };
+}
+
+inline void AppendControlFrame(std::string& Out, std::string_view Payload)
+{
+    uint32_t Size = static_cast<uint32_t>(Payload.size());
+    for (int32_t Byte = 0; Byte < 4; ++Byte) Out += static_cast<char>((Size >> (8 * Byte)) & 0xFF);
+    Out.append(Payload);
+}
+
+enum class EControlFrameResult : uint8_t
+{
+    Incomplete,
+    Frame,
+    Invalid     // Declared length above MaxControlFrameBytes
+};
+
+/** Reassembles frames from arbitrarily split reads. */
+class FControlFrameReader
+{
+public:
+    void Append(const char* Data, size_t Size) { Buffer.append(Data, Size); }
+
+    EControlFrameResult Next(std::string& Payload)
+    {
+        if (Buffer.size() - Offset < 4) return Compact(EControlFrameResult::Incomplete);
+        uint32_t Size = 0;
+        for (int32_t Byte = 0; Byte < 4; ++Byte)
+        {
+            Size |= static_cast<uint32_t>(static_cast<uint8_t>(Buffer[Offset + Byte])) << (8 * Byte);
+        }
+        if (Size > MaxControlFrameBytes) return EControlFrameResult::Invalid;
+        if (Buffer.size() - Offset - 4 < Size) return Compact(EControlFrameResult::Incomplete);
+
+        Payload.assign(Buffer, Offset + 4, Size);
+        Offset += 4 + static_cast<size_t>(Size);
+        return EControlFrameResult::Frame;
+    }
+
+private:
+    EControlFrameResult Compact(EControlFrameResult Result)
+    {
+        Buffer.erase(0, Offset);
+        Offset = 0;
+        return Result;
+    }
+
+    std::string Buffer;
+    size_t Offset = 0;
+};
+
+/** Server side of one client connection. */
+class FControlConnection
+{
+public:
+    /**
+     * Feeds received bytes. Each complete, well-formed request goes to Handler
+     * (FControlResponse(const FControlRequest&)); malformed ones are answered
+     * without it. Framed responses are appended to Out. Returns false on a framing
+     * error, after which the caller should close the connection.
+     */
+    template <typename THandler>
+    bool Receive(const char* Data, size_t Size, THandler&& Handler, std::string& Out)
+    {
+        Reader.Append(Data, Size);
+        std::string Payload;
+        for (;;)
+        {
+            EControlFrameResult Result = Reader.Next(Payload);
+            if (Result == EControlFrameResult::Incomplete) return true;
+            if (Result == EControlFrameResult::Invalid) return false;
+
+            FControlRequest Request;
+            FControlResponse Response;
+            if (ParseControlRequest(Payload, Request, Response)) Response = Handler(Request);
+            AppendControlFrame(Out, FormatControlResponse(Response));
+        }
+    }
+
+private:
+    FControlFrameReader Reader;
+};
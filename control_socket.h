@@ -0,0 +1,239 @@
+// ControlSocket - Unix-socket transport of the local control endpoint.
+// The counterpart of the Windows named pipe: one stream socket per user, at
+// $XDG_RUNTIME_DIR/VideoWallpaper.sock (/tmp/VideoWallpaper-<uid>.sock without a
+// runtime directory). The socket file is made 0600 before it accepts anything,
+// whatever the umask, and the credentials of every connection are checked too, so
+// only the user running the wallpaper is served even where the file mode is not
+// honoured. Listen() refuses a path another instance answers on and never removes
+// anything but a stale socket. FControlSocketServer does not block or own a
+// thread: the owner adds its descriptors to its own poll() set and calls
+// Dispatch() after polling, so requests run on the owner's thread - the X11 event
+// loop, where all state lives - as WM_CONTROL_REQUEST does on Windows.
+// POSIX; peer credentials are SO_PEERCRED on Linux and getpeereid() elsewhere.
+
+#pragma once
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "control_protocol.h"
+
+/** Connections served at once; more are closed as they arrive. */
+constexpr size_t MaxControlClients = 8;
+
+inline std::string GetControlSocketPath()
+{
+    const char* RuntimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (RuntimeDir && *RuntimeDir) return std::string(RuntimeDir) + "/" + ControlEndpointName + ".sock";
+    return std::string("/tmp/") + ControlEndpointName + "-" + std::to_string(getuid()) + ".sock";
+}
+
+/** User and group of the process at the other end of a connected Unix socket; false if the kernel cannot tell. */
+inline bool GetSocketPeerCredentials(int Socket, uid_t& Uid, gid_t& Gid)
+{
+#ifdef SO_PEERCRED
+    ucred Credentials = {};
+    socklen_t Size = sizeof(Credentials);
+    if (getsockopt(Socket, SOL_SOCKET, SO_PEERCRED, &Credentials, &Size) != 0 || Size != sizeof(Credentials)) return false;
+    Uid = Credentials.uid;
+    Gid = Credentials.gid;
+    return true;
+#else
+    return getpeereid(Socket, &Uid, &Gid) == 0;
+#endif
+}
+
+inline bool GetSocketPeerUid(int Socket, uid_t& Uid)
+{
+    gid_t Gid = 0;
+    return GetSocketPeerCredentials(Socket, Uid, Gid);
+}
+
+/**
+ * Sends all of Data on a non-blocking socket, waiting at most TimeoutMs for room each
+ * time its buffer is full: false if the peer does not read in time or is gone, so a
+ * client that stops reading costs the serving thread a bounded stall, not a hang.
+ */
+inline bool SendWithTimeout(int Socket, const std::string& Data, int32_t TimeoutMs)
+{
+    size_t Sent = 0;
+    while (Sent < Data.size())
+    {
+        ssize_t Result = send(Socket, Data.data() + Sent, Data.size() - Sent, MSG_NOSIGNAL);
+        if (Result < 0 && errno == EINTR) continue;
+        if (Result < 0 && errno == EAGAIN)
+        {
+            pollfd Poll = { Socket, POLLOUT, 0 };
+            if (poll(&Poll, 1, TimeoutMs) > 0) continue;
+        }
+        if (Result <= 0) return false;
+        Sent += static_cast<size_t>(Result);
+    }
+    return true;
+}
+
+class FControlSocketServer
+{
+public:
+    explicit FControlSocketServer(std::string InPath = GetControlSocketPath())
+        : Path(std::move(InPath))
+    {
+    }
+
+    ~FControlSocketServer()
+    {
+        for (auto& Client : Clients) close(Client.Socket);
+        if (ListenSocket < 0) return;
+        close(ListenSocket);
+        unlink(Path.c_str());
+    }
+
+    FControlSocketServer(const FControlSocketServer&) = delete;
+    FControlSocketServer& operator=(const FControlSocketServer&) = delete;
+
+    /** Binds the socket. Fails if another instance answers on it or the path is something other than a socket. */
+    bool Listen(std::string& Error)
+    {
+        sockaddr_un Address = {};
+        Address.sun_family = AF_UNIX;
+        if (Path.size() >= sizeof(Address.sun_path))
+        {
+            Error = "socket path too long";
+            return false;
+        }
+        Path.copy(Address.sun_path, Path.size());
+
+        struct stat FileInfo = {};
+        if (lstat(Path.c_str(), &FileInfo) == 0)
+        {
+            if (!S_ISSOCK(FileInfo.st_mode))
+            {
+                Error = Path + " exists and is not a socket";
+                return false;
+            }
+            int Existing = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            bool bAnswered = Existing >= 0 && connect(Existing, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0;
+            if (Existing >= 0) close(Existing);
+            if (bAnswered)
+            {
+                Error = "another instance is serving " + Path;
+                return false;
+            }
+            // Left behind by an instance that did not exit cleanly.
+            unlink(Path.c_str());
+        }
+
+        int Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (Socket < 0 || bind(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0)
+        {
+            if (Socket >= 0) close(Socket);
+            Error = "cannot bind " + Path;
+            return false;
+        }
+        // Connections are refused until listen(), so nothing gets in under the umask's mode.
+        if (chmod(Path.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(Socket, static_cast<int>(MaxControlClients)) != 0)
+        {
+            close(Socket);
+            unlink(Path.c_str());
+            Error = "cannot listen on " + Path;
+            return false;
+        }
+        ListenSocket = Socket;
+        return true;
+    }
+
+    bool IsListening() const { return ListenSocket >= 0; }
+    const std::string& GetPath() const { return Path; }
+    size_t GetClientCount() const { return Clients.size(); }
+
+    /** Connections closed because they came from another user. */
+    uint64_t GetRejectedCount() const { return Rejected; }
+
+    /** Appends the descriptors to poll: the listening socket first, then one per client. */
+    void AddPolls(std::vector<pollfd>& Polls) const
+    {
+        if (ListenSocket < 0) return;
+        Polls.push_back({ ListenSocket, POLLIN, 0 });
+        for (const auto& Client : Clients) Polls.push_back({ Client.Socket, POLLIN, 0 });
+    }
+
+    /**
+     * Serves what poll() reported on the descriptors AddPolls() appended, starting at
+     * Polls. Each request goes to Handler (FControlResponse(const FControlRequest&)) on
+     * this thread; clients that hang up or break the framing are closed.
+     */
+    template <typename THandler>
+    void Dispatch(const pollfd* Polls, THandler&& Handler)
+    {
+        if (ListenSocket < 0) return;
+        // Clients accepted below have no entry in Polls; walk only the ones that were polled.
+        for (size_t Index = Clients.size(); Index-- > 0;)
+        {
+            if (Polls[Index + 1].revents) Receive(Index, Handler);
+        }
+        if (Polls[0].revents & POLLIN) Accept();
+    }
+
+private:
+    struct FClient
+    {
+        int Socket = -1;
+        FControlConnection Connection;
+    };
+
+    void Accept()
+    {
+        for (;;)
+        {
+            int Socket = accept4(ListenSocket, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (Socket < 0) return;
+            uid_t Uid = 0;
+            if (!GetSocketPeerUid(Socket, Uid) || Uid != geteuid())
+            {
+                ++Rejected;
+                close(Socket);
+                continue;
+            }
+            if (Clients.size() >= MaxControlClients)
+            {
+                close(Socket);
+                continue;
+            }
+            Clients.push_back({});
+            Clients.back().Socket = Socket;
+        }
+    }
+
+    template <typename THandler>
+    void Receive(size_t Index, THandler& Handler)
+    {
+        char Buffer[4096];
+        ssize_t Read = recv(Clients[Index].Socket, Buffer, sizeof(Buffer), 0);
+        if (Read < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        std::string Out;
+        bool bValid = Read > 0 && Clients[Index].Connection.Receive(Buffer, static_cast<size_t>(Read), Handler, Out);
+        // Replies are small; a client that does not read them is dropped rather than waited for.
+        if (!Out.empty() && !SendWithTimeout(Clients[Index].Socket, Out, ControlSendTimeoutMs)) bValid = false;
+        if (bValid) return;
+        close(Clients[Index].Socket);
+        Clients.erase(Clients.begin() + static_cast<std::ptrdiff_t>(Index));
+    }
+
+    /** How long a full client send buffer may hold up the owner's thread. */
+    static constexpr int32_t ControlSendTimeoutMs = 100;
+
+    std::string Path;
+    int ListenSocket = -1;
+    std::vector<FClient> Clients;
+    uint64_t Rejected = 0;
+};
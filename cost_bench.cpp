@@ -0,0 +1,274 @@
+// cost_bench - Checks the cost model vwcost reports from.
+// A synthetic 3-second frame table with leading non-keyframes, uneven keyframe
+// spacing and a burst of large frames must split into the right GOPs, find the
+// bitrate peak a brute-force window scan finds, and measure keyframe gaps including
+// the wrap back to the first keyframe. Monitor estimates must scale decode and
+// conversion by decoded pixels and scaling by shown pixels, pick the covering
+// encode, and cap the frame rate at the first whole divisor that fits the budget.
+// Recommended encodes must cover their monitor, skip ones a configured encode or a
+// small saving makes pointless, and never repeat a suffix. Then the JSON writer's
+// escaping and nesting are checked on a full report.
+//   g++ -std=c++20 -O2 -pthread cost_bench.cpp -o cost_bench
+//   cost_bench
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cost_model.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    using FRendition = TRendition<std::string>;
+
+    constexpr int64_t FrameDuration = 333333;   // 30 fps
+    constexpr int32_t FrameCount = 90;
+
+    bool IsKeyframe(int32_t Index) { return Index == 5 || Index == 25 || Index == 65; }
+
+    /** Keyframes at 5, 25 and 65; frames 40-49 are a burst of large ones. */
+    std::vector<FCostFrame> BuildFrames()
+    {
+        std::vector<FCostFrame> Frames;
+        for (int32_t Index = 0; Index < FrameCount; ++Index)
+        {
+            FCostFrame Frame;
+            Frame.Timestamp100ns = Index * FrameDuration;
+            Frame.bKeyframe = IsKeyframe(Index);
+            Frame.Bytes = Frame.bKeyframe ? 40000 : (Index >= 40 && Index < 50 ? 30000 : 2000);
+            Frame.DecodeNs = Frame.bKeyframe ? 3000000 : 1000000;
+            Frames.push_back(Frame);
+        }
+        return Frames;
+    }
+
+    FVideoInfo MakeInfo(int32_t Width, int32_t Height)
+    {
+        FVideoInfo Info;
+        Info.Width = Width;
+        Info.Height = Height;
+        Info.FrameRateNumerator = 30;
+        Info.FrameRateDenominator = 1;
+        Info.Duration100ns = FrameCount * FrameDuration;
+        Info.Format = EPixelFormat::NV12;
+        return Info;
+    }
+
+    bool Near(double Value, double Expected) { return std::fabs(Value - Expected) <= std::fabs(Expected) * 1e-9 + 1e-12; }
+
+    bool CheckFrameTable()
+    {
+        std::vector<FCostFrame> Frames = BuildFrames();
+        int64_t Duration = FrameCount * FrameDuration;
+        bool bPass = true;
+
+        std::vector<FGopCost> Gops = SplitGops(Frames);
+        bPass &= Check(Gops.size() == 4, "leading frames form a GOP of their own");
+        if (Gops.size() == 4)
+        {
+            bPass &= Check(Gops[0].Frames == 5 && Gops[1].Frames == 20 && Gops[2].Frames == 40 && Gops[3].Frames == 25, "GOP lengths");
+            bPass &= Check(Gops[2].Start100ns == 25 * FrameDuration, "GOP start");
+            bPass &= Check(Gops[1].DecodeNs == 3000000 + 19 * 1000000, "GOP decode time");
+            bPass &= Check(Gops[2].Bytes == 40000 + 10 * 30000 + 29 * 2000, "GOP bytes");
+        }
+
+        FBitrateStats Bitrate = MeasureBitrate(Frames, Duration, 10000000);
+        int64_t Total = 0;
+        for (const FCostFrame& Frame : Frames) Total += Frame.Bytes;
+        bPass &= Check(Near(Bitrate.AverageBps, Total * 8.0 / (Duration / 1e7)), "average bitrate");
+        int64_t BestBytes = 0;
+        int64_t BestStart = 0;
+        for (const FCostFrame& Start : Frames)
+        {
+            int64_t Bytes = 0;
+            for (const FCostFrame& Frame : Frames)
+            {
+                if (Frame.Timestamp100ns >= Start.Timestamp100ns && Frame.Timestamp100ns < Start.Timestamp100ns + 10000000) Bytes += Frame.Bytes;
+            }
+            if (Bytes > BestBytes)
+            {
+                BestBytes = Bytes;
+                BestStart = Start.Timestamp100ns;
+            }
+        }
+        bPass &= Check(Near(Bitrate.PeakBps, BestBytes * 8.0), "peak matches a brute-force scan");
+        bPass &= Check(Bitrate.PeakStart100ns == BestStart, "peak window start");
+        bPass &= Check(Bitrate.PeakBps > Bitrate.AverageBps * 1.5, "burst stands out");
+        FBitrateStats Short = MeasureBitrate(Frames, Duration, Duration * 2);
+        bPass &= Check(Short.Window100ns == Duration && Near(Short.PeakBps, Short.AverageBps), "window longer than the clip");
+
+        FKeyframeSpacing Spacing = MeasureKeyframeSpacing(Frames, Duration);
+        bPass &= Check(Spacing.Keyframes == 3, "keyframe count");
+        bPass &= Check(Spacing.Min100ns == 20 * FrameDuration, "shortest gap");
+        bPass &= Check(Spacing.Max100ns == 40 * FrameDuration, "longest gap");
+        bPass &= Check(Spacing.Average100ns == 30 * FrameDuration, "gaps include the wrap to the first keyframe");
+
+        std::vector<FCostFrame> Single(1);
+        Single[0].bKeyframe = true;
+        FKeyframeSpacing Loop = MeasureKeyframeSpacing(Single, Duration);
+        bPass &= Check(Loop.Keyframes == 1 && Loop.Min100ns == Duration && Loop.Max100ns == Duration, "one keyframe: the whole loop");
+        bPass &= Check(MeasureKeyframeSpacing({}, Duration).Keyframes == 0 && MeasureBitrate({}, Duration, 10000000).PeakBps == 0.0, "empty table");
+        return bPass;
+    }
+
+    bool CheckMonitorCost()
+    {
+        FVideoInfo Info = MakeInfo(3840, 2160);
+        FFrameCost Cost { 8000000.0, 2000000.0, 4000000.0, 1.0 };
+        std::vector<FRendition> Renditions = { { 1920, 1080, "_1080p" } };
+        FCostSettings Settings;
+        Settings.CacheBudgetBytes = 1920ll * 1080 * 3 / 2 * FrameCount;   // Exactly the 1080p loop
+        bool bPass = true;
+
+        FMonitorCost Master = EstimateMonitorCost(Info, true, FrameCount, Cost, Renditions, 3840, 2160, Settings);
+        bPass &= Check(Master.Rendition == MasterRendition && Master.DecodeWidth == 3840, "4K monitor decodes the master");
+        bPass &= Check(Near(Master.LiveCpu, (8e6 + 2e6 + 4e6) * 30 / 1e9), "live cost at the source size");
+        bPass &= Check(Near(Master.CachedCpu, (2e6 + 4e6) * 30 / 1e9), "cached cost leaves out decoding");
+        bPass &= Check(Master.bOverBudget && Master.CapDivisor == MaxCapDivisor, "over budget at every cap");
+
+        FMonitorCost Small = EstimateMonitorCost(Info, true, FrameCount, Cost, Renditions, 1920, 1080, Settings);
+        bPass &= Check(Small.Rendition == 0 && Small.DecodeWidth == 1920 && Near(Small.Scale, 1.0), "1080p monitor decodes the 1080p encode");
+        bPass &= Check(Near(Small.LiveCpu, Master.LiveCpu / 4), "cost scales with pixels");
+        bPass &= Check(Small.CapDivisor == 2 && Near(Small.FpsCap, 15.0) && !Small.bOverBudget, "first divisor that fits");
+        bPass &= Check(Small.LiveCpuAtCap <= Settings.CpuBudget && Small.LiveCpu > Settings.CpuBudget, "cap brings it under budget");
+
+        int64_t FrameBytes = 1920ll * 1080 * 3 / 2;
+        int64_t OutputBytes = 2 * 1920ll * 1080 * 4;
+        bPass &= Check(Small.LiveBytes == (CodedDecoderFrames + 1) * FrameBytes + OutputBytes, "live memory");
+        bPass &= Check(Small.CachedBytes == FrameCount * FrameBytes + OutputBytes && Small.bCacheFits, "cached memory");
+        FMonitorCost Raw = EstimateMonitorCost(Info, false, FrameCount, Cost, Renditions, 1920, 1080, Settings);
+        bPass &= Check(Raw.LiveBytes == FrameBytes + OutputBytes, "raw sources hold one frame");
+
+        FMonitorCost Odd = EstimateMonitorCost(Info, true, FrameCount, Cost, Renditions, 1280, 1024, Settings);
+        bPass &= Check(Odd.Rendition == 0 && Near(Odd.Scale, 1024.0 / 1080), "cover fit on the taller side");
+        bPass &= Check(Near(Odd.DecodedPixelShare, 1920.0 * 1080 / (1280.0 * 1024)), "decoded pixel share");
+
+        FMonitorCost Upscaled = EstimateMonitorCost(MakeInfo(1280, 720), true, FrameCount, Cost, {}, 1920, 1080, Settings);
+        bPass &= Check(Near(Upscaled.Scale, 1.5) && Upscaled.DecodedPixelShare < 1.0, "smaller video is upscaled");
+
+        FCostSettings Tight = Settings;
+        Tight.CacheBudgetBytes -= 1;
+        bPass &= Check(!EstimateMonitorCost(Info, true, FrameCount, Cost, Renditions, 1920, 1080, Tight).bCacheFits, "loop over the cache budget");
+        return bPass;
+    }
+
+    bool CheckRecommendations()
+    {
+        FVideoInfo Info = MakeInfo(3840, 2160);
+        std::vector<FIntRect> Monitors =
+        {
+            { 0, 0, 1920, 1080 }, { 0, 0, 2560, 1440 }, { 0, 0, 3440, 1440 }, { 0, 0, 1366, 768 },
+            { 0, 0, 1920, 1200 }, { 0, 0, 3840, 2160 }, { 0, 0, 1920, 1080 },
+        };
+        bool bPass = true;
+
+        std::vector<FRendition> Fresh = RecommendRenditions(Info, Monitors, {});
+        for (size_t Index = 0; Index < Fresh.size(); ++Index)
+        {
+            bPass &= Check(Fresh[Index].Width % 2 == 0 && Fresh[Index].Height % 2 == 0, "even sizes");
+            for (size_t Other = 0; Other < Index; ++Other)
+            {
+                bPass &= Check(Fresh[Other].Suffix != Fresh[Index].Suffix, "suffixes are unique");
+                bPass &= Check(Fresh[Other].Width != Fresh[Index].Width || Fresh[Other].Height != Fresh[Index].Height, "sizes are unique");
+            }
+        }
+        for (const FIntRect& Monitor : Monitors)
+        {
+            int32_t Chosen = SelectRendition(Fresh, Monitor.Width(), Monitor.Height());
+            if (Chosen == MasterRendition) continue;
+            bPass &= Check(Fresh[static_cast<size_t>(Chosen)].Width >= Monitor.Width() && Fresh[static_cast<size_t>(Chosen)].Height >= Monitor.Height(), "covers its monitor");
+        }
+        // 3440x1440 needs 3440x1936 of a 16:9 video: too close to the master to be worth an encode.
+        bool bUltrawide = false;
+        bool b1080 = false;
+        for (const FRendition& Rendition : Fresh)
+        {
+            bUltrawide |= Rendition.Width == 3440;
+            b1080 |= Rendition.Width == 1920 && Rendition.Height == 1080 && Rendition.Suffix == "_1080p";
+        }
+        bPass &= Check(!bUltrawide, "small saving skipped");
+        bPass &= Check(b1080, "1080p recommended");
+        bPass &= Check(Fresh.size() == 4, "1080p, 1440p, 768p and 1200p");
+
+        std::vector<FRendition> Existing = { { 1920, 1080, "_1080p" }, { 2560, 1440, "_1440p" } };
+        std::vector<FRendition> Extra = RecommendRenditions(Info, Monitors, Existing);
+        bool bExtra1080 = false;
+        bool bCollides = false;
+        for (const FRendition& Rendition : Extra)
+        {
+            bExtra1080 |= Rendition.Width == 1920 && Rendition.Height == 1080;
+            for (const FRendition& Other : Existing) bCollides |= Other.Suffix == Rendition.Suffix;
+        }
+        bPass &= Check(!bExtra1080, "configured encode not recommended again");
+        bPass &= Check(!bCollides, "no suffix of a configured encode reused");
+        bPass &= Check(RecommendRenditions(MakeInfo(1280, 720), Monitors, {}).size() == 0, "nothing below a small video");
+        return bPass;
+    }
+
+    bool CheckJson()
+    {
+        FCostReport Report;
+        Report.VideoPath = "C:\\Videos\\\"ocean\"\n.mp4";
+        Report.SourceKind = "ffmpeg";
+        Report.Info = MakeInfo(3840, 2160);
+        Report.bCoded = true;
+        Report.Renditions = { { 1920, 1080, "_1080p" } };
+        Report.Cost = { 8000000.0, 2000000.0, 4000000.0, 0.5 };
+        std::vector<FIntRect> Monitors = { { 0, 0, 1920, 1080 }, { 0, 0, 1366, 768 } };
+        AnalyzeCost(Report, BuildFrames(), Monitors, FCostSettings());
+
+        std::ostringstream Out;
+        WriteCostReportJson(Out, Report);
+        std::string Json = Out.str();
+        bool bPass = true;
+        bPass &= Check(Json.find("\"C:\\\\Videos\\\\\\\"ocean\\\"\\u000a.mp4\"") != std::string::npos, "strings escaped");
+        int32_t Depth = 0;
+        bool bInString = false;
+        bool bBalanced = true;
+        for (size_t Index = 0; Index < Json.size(); ++Index)
+        {
+            char Char = Json[Index];
+            if (bInString)
+            {
+                if (Char == '\\') ++Index;
+                else if (Char == '"') bInString = false;
+                continue;
+            }
+            if (Char == '"') bInString = true;
+            else if (Char == '{' || Char == '[') ++Depth;
+            else if (Char == '}' || Char == ']') bBalanced &= --Depth >= 0;
+        }
+        bPass &= Check(bBalanced && Depth == 0 && !bInString, "brackets balance");
+        bPass &= Check(Json.find(",\n  }") == std::string::npos && Json.find(",\n}") == std::string::npos, "no trailing commas");
+        bPass &= Check(Json.find("\"gops\"") != std::string::npos && Json.find("\"recommended\"") != std::string::npos, "sections present");
+        bPass &= Check(Report.Monitors.size() == 2 && Near(Report.FpsCap, Report.Monitors[0].FpsCap < Report.Monitors[1].FpsCap ? Report.Monitors[0].FpsCap : Report.Monitors[1].FpsCap), "report cap is the lowest monitor's");
+        return bPass;
+    }
+}
+
+int main(int Argc, char**)
+{
+    if (Argc > 1)
+    {
+        std::fprintf(stderr, "usage: cost_bench\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckFrameTable(), "frame table");
+    bPass &= Check(CheckMonitorCost(), "monitor cost");
+    bPass &= Check(CheckRecommendations(), "recommendations");
+    bPass &= Check(CheckJson(), "json");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
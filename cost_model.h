@@ -0,0 +1,559 @@
+// CostModel - What a wallpaper will cost before it is rolled out.
+// Works from a frame table - each frame's timestamp, coded size, whether it is a
+// keyframe and the CPU time its decode took - and the measured cost of composing a
+// frame: per-GOP decode cost, bitrate peaks over a sliding window, and keyframe
+// spacing including the wrap back to the first frame. Against a list of monitor
+// sizes it then estimates, per monitor, the CPU share and memory of decoding live
+// and of playing from decoded frames kept in memory, recommends a frame-rate cap
+// (the source rate divided by a whole number, so frames stay evenly spaced) that
+// fits a CPU budget, and names the encodes worth adding next to the video. Costs
+// are scaled from the analysis machine by pixel counts: decode and conversion by
+// the pixels decoded, scaling by the pixels shown. The report is written as JSON.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+#include "rendition.h"
+#include "video_source.h"
+
+/** Decoded frames a live decoder holds besides the one being shown: references and frames in flight. */
+constexpr int32_t CodedDecoderFrames = 4;
+
+/** Largest divisor of the source rate tried for a frame-rate cap. */
+constexpr int32_t MaxCapDivisor = 4;
+
+struct FCostFrame
+{
+    int64_t Timestamp100ns = 0;
+    int64_t Bytes = 0;              // Coded size; the whole frame for uncompressed sources
+    bool bKeyframe = false;
+    int64_t DecodeNs = 0;           // CPU time its decode took; 0 where not measured
+};
+
+/** One GOP: a keyframe and the frames up to the next. */
+struct FGopCost
+{
+    int64_t Start100ns = 0;
+    int32_t Frames = 0;
+    int64_t Bytes = 0;
+    int64_t DecodeNs = 0;
+};
+
+struct FBitrateStats
+{
+    double AverageBps = 0.0;
+    double PeakBps = 0.0;           // Most bits in any window, per second
+    int64_t PeakStart100ns = 0;
+    int64_t Window100ns = 0;
+};
+
+struct FKeyframeSpacing
+{
+    int32_t Keyframes = 0;
+    int64_t Min100ns = 0;
+    int64_t Average100ns = 0;
+    int64_t Max100ns = 0;           // Includes the wrap from the last keyframe to the first
+};
+
+/** Measured per frame at the source size on the analysis machine. */
+struct FFrameCost
+{
+    double DecodeNs = 0.0;
+    double ConvertNs = 0.0;         // Colour conversion of the changed tiles
+    double ScaleNs = 0.0;           // Scaling onto a source-sized output
+    double DirtyShare = 1.0;        // Tiles that changed from one frame to the next
+};
+
+struct FCostSettings
+{
+    double CpuBudget = 0.10;                        // Share of one core a monitor's playback may take
+    int64_t CacheBudgetBytes = 256ll * 1024 * 1024; // Memory for decoded frames (pingpong_cache_mb)
+    int64_t BitrateWindow100ns = 10000000;          // One second
+};
+
+struct FMonitorCost
+{
+    int32_t Width = 0;
+    int32_t Height = 0;
+    int32_t Rendition = MasterRendition;    // Encode this monitor decodes, among the configured ones
+    int32_t DecodeWidth = 0;
+    int32_t DecodeHeight = 0;
+    double Scale = 1.0;                     // Shown pixels per decoded pixel on the covering side; above 1 upscales
+    double DecodedPixelShare = 1.0;         // Decoded pixels per shown pixel; above 1 is decoded and thrown away
+    double LiveCpu = 0.0;                   // Share of one core decoding and composing at the full rate
+    double CachedCpu = 0.0;                 // ...composing only, from decoded frames kept in memory
+    int64_t LiveBytes = 0;
+    int64_t CachedBytes = 0;
+    bool bCacheFits = false;                // The whole loop fits the cache budget
+    double FpsCap = 0.0;
+    int32_t CapDivisor = 1;
+    double LiveCpuAtCap = 0.0;
+    bool bOverBudget = false;               // Even the lowest cap exceeds the budget
+};
+
+struct FCostReport
+{
+    std::string VideoPath;
+    std::string SourceKind;                 // "pattern", "y4m" or "ffmpeg"
+    FVideoInfo Info;
+    bool bCoded = false;                    // Compressed: keyframes and GOPs mean something
+    int64_t FrameCount = 0;
+    bool bWholeLoop = true;                 // False when the analysis stopped before the end
+    std::vector<TRendition<std::string>> Renditions;    // Configured encodes whose files exist
+
+    std::vector<FGopCost> Gops;
+    FBitrateStats Bitrate;
+    FKeyframeSpacing Keyframes;
+    FFrameCost Cost;
+    std::vector<FMonitorCost> Monitors;
+    std::vector<TRendition<std::string>> RecommendedRenditions;
+    double FpsCap = 0.0;                    // The lowest monitor's cap: safe for every monitor listed
+};
+
+inline double GetFrameRate(const FVideoInfo& Info)
+{
+    return Info.FrameRateDenominator ? static_cast<double>(Info.FrameRateNumerator) / Info.FrameRateDenominator : 0.0;
+}
+
+/** Bytes of one decoded frame: 4:2:0 planes for NV12 and P010. */
+inline int64_t GetDecodedFrameBytes(int32_t Width, int32_t Height, EPixelFormat Format)
+{
+    int64_t Pixels = static_cast<int64_t>(Width) * Height;
+    if (Format == EPixelFormat::BGRA8) return Pixels * 4;
+    return Pixels * BytesPerPixel(Format) * 3 / 2;
+}
+
+/** Frames in presentation order; frames ahead of the first keyframe form a GOP of their own. */
+inline std::vector<FGopCost> SplitGops(const std::vector<FCostFrame>& Frames)
+{
+    std::vector<FGopCost> Gops;
+    for (const FCostFrame& Frame : Frames)
+    {
+        if (Gops.empty() || Frame.bKeyframe) Gops.push_back({ Frame.Timestamp100ns, 0, 0, 0 });
+        FGopCost& Gop = Gops.back();
+        ++Gop.Frames;
+        Gop.Bytes += Frame.Bytes;
+        Gop.DecodeNs += Frame.DecodeNs;
+    }
+    return Gops;
+}
+
+/** Frames in presentation order over Duration100ns; a clip shorter than the window is one window. */
+inline FBitrateStats MeasureBitrate(const std::vector<FCostFrame>& Frames, int64_t Duration100ns, int64_t Window100ns)
+{
+    FBitrateStats Stats;
+    if (Frames.empty() || Duration100ns <= 0 || Window100ns <= 0) return Stats;
+    Stats.Window100ns = Window100ns < Duration100ns ? Window100ns : Duration100ns;
+    int64_t Total = 0;
+    for (const FCostFrame& Frame : Frames) Total += Frame.Bytes;
+    Stats.AverageBps = Total * 8.0 * 1e7 / static_cast<double>(Duration100ns);
+
+    int64_t WindowBytes = 0;
+    size_t End = 0;
+    for (size_t Begin = 0; Begin < Frames.size(); ++Begin)
+    {
+        int64_t Limit = Frames[Begin].Timestamp100ns + Stats.Window100ns;
+        while (End < Frames.size() && Frames[End].Timestamp100ns < Limit) WindowBytes += Frames[End++].Bytes;
+        double Bps = WindowBytes * 8.0 * 1e7 / static_cast<double>(Stats.Window100ns);
+        if (Bps > Stats.PeakBps)
+        {
+            Stats.PeakBps = Bps;
+            Stats.PeakStart100ns = Frames[Begin].Timestamp100ns;
+        }
+        WindowBytes -= Frames[Begin].Bytes;
+    }
+    return Stats;
+}
+
+/** Gaps between keyframes as the loop plays them, wrapping from the last back to the first. */
+inline FKeyframeSpacing MeasureKeyframeSpacing(const std::vector<FCostFrame>& Frames, int64_t Duration100ns)
+{
+    FKeyframeSpacing Spacing;
+    std::vector<int64_t> Times;
+    for (const FCostFrame& Frame : Frames)
+    {
+        if (Frame.bKeyframe) Times.push_back(Frame.Timestamp100ns);
+    }
+    Spacing.Keyframes = static_cast<int32_t>(Times.size());
+    if (Times.empty()) return Spacing;
+
+    std::vector<int64_t> Gaps;
+    for (size_t Index = 1; Index < Times.size(); ++Index) Gaps.push_back(Times[Index] - Times[Index - 1]);
+    int64_t Wrap = Duration100ns - Times.back() + Times.front();
+    if (Wrap > 0) Gaps.push_back(Wrap);
+    if (Gaps.empty()) return Spacing;
+
+    int64_t Sum = 0;
+    Spacing.Min100ns = Gaps.front();
+    for (int64_t Gap : Gaps)
+    {
+        Spacing.Min100ns = Gap < Spacing.Min100ns ? Gap : Spacing.Min100ns;
+        Spacing.Max100ns = Gap > Spacing.Max100ns ? Gap : Spacing.Max100ns;
+        Sum += Gap;
+    }
+    Spacing.Average100ns = Sum / static_cast<int64_t>(Gaps.size());
+    return Spacing;
+}
+
+/**
+ * One monitor of Width x Height showing the video cover-fitted, decoding the
+ * configured encode SelectRendition picks for it. LoopFrames decoded frames make up
+ * one pass of the loop.
+ */
+inline FMonitorCost EstimateMonitorCost
+(
+    const FVideoInfo& Info, bool bCoded, int64_t LoopFrames, const FFrameCost& Cost,
+    const std::vector<TRendition<std::string>>& Renditions, int32_t Width, int32_t Height, const FCostSettings& Settings
+)
+{
+    FMonitorCost Monitor;
+    Monitor.Width = Width;
+    Monitor.Height = Height;
+    Monitor.Rendition = SelectRendition(Renditions, Width, Height);
+    Monitor.DecodeWidth = Monitor.Rendition == MasterRendition ? Info.Width : Renditions[static_cast<size_t>(Monitor.Rendition)].Width;
+    Monitor.DecodeHeight = Monitor.Rendition == MasterRendition ? Info.Height : Renditions[static_cast<size_t>(Monitor.Rendition)].Height;
+    if (Info.Width <= 0 || Info.Height <= 0 || Width <= 0 || Height <= 0) return Monitor;
+
+    double ScaleX = static_cast<double>(Width) / Monitor.DecodeWidth;
+    double ScaleY = static_cast<double>(Height) / Monitor.DecodeHeight;
+    Monitor.Scale = ScaleX > ScaleY ? ScaleX : ScaleY;
+    double SourcePixels = static_cast<double>(Info.Width) * Info.Height;
+    double DecodedPixels = static_cast<double>(Monitor.DecodeWidth) * Monitor.DecodeHeight;
+    double ShownPixels = static_cast<double>(Width) * Height;
+    Monitor.DecodedPixelShare = DecodedPixels / ShownPixels;
+
+    double DecodeNs = Cost.DecodeNs * DecodedPixels / SourcePixels;
+    double ComposeNs = Cost.ConvertNs * DecodedPixels / SourcePixels + Cost.ScaleNs * ShownPixels / SourcePixels;
+    double FrameRate = GetFrameRate(Info);
+    Monitor.LiveCpu = (DecodeNs + ComposeNs) * FrameRate / 1e9;
+    Monitor.CachedCpu = ComposeNs * FrameRate / 1e9;
+
+    // The composed canvas and the surface it is presented from, both BGRA at the monitor's size.
+    int64_t OutputBytes = 2 * GetDecodedFrameBytes(Width, Height, EPixelFormat::BGRA8);
+    int64_t FrameBytes = GetDecodedFrameBytes(Monitor.DecodeWidth, Monitor.DecodeHeight, Info.Format);
+    Monitor.LiveBytes = (bCoded ? CodedDecoderFrames + 1 : 1) * FrameBytes + OutputBytes;
+    Monitor.CachedBytes = LoopFrames * FrameBytes + OutputBytes;
+    Monitor.bCacheFits = LoopFrames * FrameBytes <= Settings.CacheBudgetBytes;
+
+    // A re-encode at the cap decodes fewer frames too, so the whole live cost scales with it.
+    Monitor.bOverBudget = true;
+    for (int32_t Divisor = 1; Divisor <= MaxCapDivisor; ++Divisor)
+    {
+        Monitor.CapDivisor = Divisor;
+        Monitor.FpsCap = FrameRate / Divisor;
+        Monitor.LiveCpuAtCap = Monitor.LiveCpu / Divisor;
+        if (Monitor.LiveCpuAtCap <= Settings.CpuBudget)
+        {
+            Monitor.bOverBudget = false;
+            break;
+        }
+    }
+    return Monitor;
+}
+
+/**
+ * Encodes worth adding: for each monitor smaller than the video on both sides, the
+ * video's aspect scaled to cover it, unless that saves less than a quarter of the
+ * decoded pixels or a configured encode already covers the monitor with at most a
+ * quarter more pixels than it. Suffixes follow the height ("_1080p").
+ */
+inline std::vector<TRendition<std::string>> RecommendRenditions
+(
+    const FVideoInfo& Info, const std::vector<FIntRect>& Monitors, const std::vector<TRendition<std::string>>& Existing
+)
+{
+    std::vector<TRendition<std::string>> Recommended;
+    if (Info.Width <= 0 || Info.Height <= 0) return Recommended;
+    for (const FIntRect& Monitor : Monitors)
+    {
+        if (Monitor.Width() >= Info.Width || Monitor.Height() >= Info.Height) continue;
+        double ScaleX = static_cast<double>(Monitor.Width()) / Info.Width;
+        double ScaleY = static_cast<double>(Monitor.Height()) / Info.Height;
+        double Scale = ScaleX > ScaleY ? ScaleX : ScaleY;
+        TRendition<std::string> Rendition;
+        // Rounded up to even sizes: never short of the monitor, always valid for 4:2:0.
+        Rendition.Width = (static_cast<int32_t>(std::ceil(Info.Width * Scale - 1e-6)) + 1) & ~1;
+        Rendition.Height = (static_cast<int32_t>(std::ceil(Info.Height * Scale - 1e-6)) + 1) & ~1;
+        int64_t Area = static_cast<int64_t>(Rendition.Width) * Rendition.Height;
+        if (Area * 4 > static_cast<int64_t>(Info.Width) * Info.Height * 3) continue;
+        int32_t Covering = SelectRendition(Existing, Monitor.Width(), Monitor.Height());
+        if (Covering != MasterRendition)
+        {
+            const auto& Other = Existing[static_cast<size_t>(Covering)];
+            if (static_cast<int64_t>(Other.Width) * Other.Height * 4 <= Area * 5) continue;
+        }
+        bool bDuplicate = false;
+        bool bSuffixTaken = false;
+        Rendition.Suffix = "_" + std::to_string(Monitor.Height()) + "p";
+        for (const auto& Other : Existing) bSuffixTaken |= Other.Suffix == Rendition.Suffix;
+        for (const auto& Other : Recommended)
+        {
+            bDuplicate |= Other.Width == Rendition.Width && Other.Height == Rendition.Height;
+            bSuffixTaken |= Other.Suffix == Rendition.Suffix;
+        }
+        // Ultrawide and 16:10 panels share heights with 16:9 ones.
+        if (bSuffixTaken) Rendition.Suffix = "_" + std::to_string(Monitor.Width()) + "x" + std::to_string(Monitor.Height());
+        if (!bDuplicate) Recommended.push_back(Rendition);
+    }
+    return Recommended;
+}
+
+/** Fills the derived parts of Report from the frame table in presentation order. */
+inline void AnalyzeCost
+(
+    FCostReport& Report, const std::vector<FCostFrame>& Frames, const std::vector<FIntRect>& Monitors,
+    const FCostSettings& Settings
+)
+{
+    Report.FrameCount = static_cast<int64_t>(Frames.size());
+    int64_t Duration100ns = Report.Info.Duration100ns;
+    if (!Frames.empty())
+    {
+        int64_t End = Frames.back().Timestamp100ns + Report.Info.FrameDuration100ns();
+        if (!Report.bWholeLoop || Duration100ns <= 0) Duration100ns = End;
+    }
+    Report.Gops = SplitGops(Frames);
+    Report.Bitrate = MeasureBitrate(Frames, Duration100ns, Settings.BitrateWindow100ns);
+    Report.Keyframes = MeasureKeyframeSpacing(Frames, Duration100ns);
+
+    Report.Monitors.clear();
+    Report.FpsCap = GetFrameRate(Report.Info);
+    for (const FIntRect& Monitor : Monitors)
+    {
+        Report.Monitors.push_back
+        (
+            EstimateMonitorCost
+            (
+                Report.Info, Report.bCoded, Report.FrameCount, Report.Cost, Report.Renditions,
+                Monitor.Width(), Monitor.Height(), Settings
+            )
+        );
+        Report.FpsCap = Report.Monitors.back().FpsCap < Report.FpsCap ? Report.Monitors.back().FpsCap : Report.FpsCap;
+    }
+    Report.RecommendedRenditions = RecommendRenditions(Report.Info, Monitors, Report.Renditions);
+}
+
+/** Minimal JSON output: objects and arrays written in order, commas placed by the writer. */
+class FJsonWriter
+{
+public:
+    explicit FJsonWriter(std::ostream& InOut) : Out(InOut) {}
+
+    void BeginObject(const char* Key = nullptr) { Open(Key, '{'); }
+    void EndObject() { Close('}'); }
+    void BeginArray(const char* Key = nullptr) { Open(Key, '['); }
+    void EndArray() { Close(']'); }
+
+    void Write(const char* Key, const std::string& Value)
+    {
+        WriteKey(Key);
+        WriteString(Value);
+    }
+
+    void Write(const char* Key, const char* Value) { Write(Key, std::string(Value)); }
+
+    void Write(const char* Key, bool bValue)
+    {
+        WriteKey(Key);
+        Out << (bValue ? "true" : "false");
+    }
+
+    void Write(const char* Key, int64_t Value)
+    {
+        WriteKey(Key);
+        Out << Value;
+    }
+
+    void Write(const char* Key, int32_t Value) { Write(Key, static_cast<int64_t>(Value)); }
+
+    /** Six significant digits; JSON has no NaN or infinity, so those are written as 0. */
+    void Write(const char* Key, double Value)
+    {
+        WriteKey(Key);
+        char Text[32];
+        std::snprintf(Text, sizeof(Text), "%.6g", std::isfinite(Value) ? Value : 0.0);
+        Out << Text;
+    }
+
+private:
+    void Open(const char* Key, char Bracket)
+    {
+        WriteKey(Key);
+        Out << Bracket;
+        bFirst.push_back(true);
+    }
+
+    void Close(char Bracket)
+    {
+        bFirst.pop_back();
+        Out << '\n' << std::string(bFirst.size() * 2, ' ') << Bracket;
+        if (bFirst.empty()) Out << '\n';
+    }
+
+    void WriteKey(const char* Key)
+    {
+        if (!bFirst.empty())
+        {
+            Out << (bFirst.back() ? "\n" : ",\n") << std::string(bFirst.size() * 2, ' ');
+            bFirst.back() = false;
+        }
+        if (!Key) return;
+        WriteString(Key);
+        Out << ": ";
+    }
+
+    void WriteString(const std::string& Text)
+    {
+        Out << '"';
+        for (char Char : Text)
+        {
+            if (Char == '"' || Char == '\\') Out << '\\' << Char;
+            else if (static_cast<unsigned char>(Char) < 0x20)
+            {
+                char Escape[8];
+                std::snprintf(Escape, sizeof(Escape), "\\u%04x", static_cast<unsigned>(Char));
+                Out << Escape;
+            }
+            else Out << Char;
+        }
+        Out << '"';
+    }
+
+    std::ostream& Out;
+    std::vector<bool> bFirst;   // Per open container: nothing written in it yet
+};
+
+inline std::string GetRenditionLabel(const std::vector<TRendition<std::string>>& Renditions, int32_t Rendition)
+{
+    return Rendition == MasterRendition ? std::string("master") : Renditions[static_cast<size_t>(Rendition)].Suffix;
+}
+
+/** The report for fleet dashboards: seconds, kbit/s, MB and shares of one core. */
+inline void WriteCostReportJson(std::ostream& Out, const FCostReport& Report)
+{
+    constexpr double MB = 1024.0 * 1024.0;
+    FJsonWriter Json(Out);
+    Json.BeginObject();
+    Json.Write("video", Report.VideoPath);
+    Json.Write("source", Report.SourceKind);
+    Json.Write("width", Report.Info.Width);
+    Json.Write("height", Report.Info.Height);
+    Json.Write("fps", GetFrameRate(Report.Info));
+    Json.Write("format", Report.Info.Format == EPixelFormat::P010 ? "p010" : "nv12");
+    Json.Write("coded", Report.bCoded);
+    Json.Write("frames", Report.FrameCount);
+    Json.Write("whole_loop", Report.bWholeLoop);
+    Json.Write("duration_s", Report.Info.Duration100ns / 1e7);
+
+    Json.BeginObject("frame_cost_ms");
+    Json.Write("decode", Report.Cost.DecodeNs / 1e6);
+    Json.Write("convert", Report.Cost.ConvertNs / 1e6);
+    Json.Write("scale", Report.Cost.ScaleNs / 1e6);
+    Json.Write("dirty_share", Report.Cost.DirtyShare);
+    Json.EndObject();
+
+    int64_t MaxGopFrames = 0;
+    int64_t MaxGopDecodeNs = 0;
+    int64_t GopDecodeNs = 0;
+    for (const FGopCost& Gop : Report.Gops)
+    {
+        MaxGopFrames = Gop.Frames > MaxGopFrames ? Gop.Frames : MaxGopFrames;
+        MaxGopDecodeNs = Gop.DecodeNs > MaxGopDecodeNs ? Gop.DecodeNs : MaxGopDecodeNs;
+        GopDecodeNs += Gop.DecodeNs;
+    }
+    Json.BeginObject("gop_summary");
+    Json.Write("count", static_cast<int64_t>(Report.Gops.size()));
+    Json.Write("max_frames", MaxGopFrames);
+    Json.Write("average_decode_ms", Report.Gops.empty() ? 0.0 : GopDecodeNs / 1e6 / static_cast<double>(Report.Gops.size()));
+    Json.Write("max_decode_ms", MaxGopDecodeNs / 1e6);
+    Json.EndObject();
+    Json.BeginArray("gops");
+    for (const FGopCost& Gop : Report.Gops)
+    {
+        Json.BeginObject();
+        Json.Write("start_s", Gop.Start100ns / 1e7);
+        Json.Write("frames", Gop.Frames);
+        Json.Write("bytes", Gop.Bytes);
+        Json.Write("decode_ms", Gop.DecodeNs / 1e6);
+        Json.EndObject();
+    }
+    Json.EndArray();
+
+    Json.BeginObject("bitrate");
+    Json.Write("average_kbps", Report.Bitrate.AverageBps / 1000.0);
+    Json.Write("peak_kbps", Report.Bitrate.PeakBps / 1000.0);
+    Json.Write("peak_at_s", Report.Bitrate.PeakStart100ns / 1e7);
+    Json.Write("peak_ratio", Report.Bitrate.AverageBps > 0.0 ? Report.Bitrate.PeakBps / Report.Bitrate.AverageBps : 0.0);
+    Json.Write("window_s", Report.Bitrate.Window100ns / 1e7);
+    Json.EndObject();
+
+    Json.BeginObject("keyframes");
+    Json.Write("count", Report.Keyframes.Keyframes);
+    Json.Write("min_interval_s", Report.Keyframes.Min100ns / 1e7);
+    Json.Write("average_interval_s", Report.Keyframes.Average100ns / 1e7);
+    Json.Write("max_interval_s", Report.Keyframes.Max100ns / 1e7);
+    Json.EndObject();
+
+    Json.BeginArray("renditions");
+    for (const auto& Rendition : Report.Renditions)
+    {
+        Json.BeginObject();
+        Json.Write("width", Rendition.Width);
+        Json.Write("height", Rendition.Height);
+        Json.Write("suffix", Rendition.Suffix);
+        Json.EndObject();
+    }
+    Json.EndArray();
+
+    Json.BeginArray("monitors");
+    for (const FMonitorCost& Monitor : Report.Monitors)
+    {
+        Json.BeginObject();
+        Json.Write("width", Monitor.Width);
+        Json.Write("height", Monitor.Height);
+        Json.Write("encode", GetRenditionLabel(Report.Renditions, Monitor.Rendition));
+        Json.Write("decode_width", Monitor.DecodeWidth);
+        Json.Write("decode_height", Monitor.DecodeHeight);
+        Json.Write("scale", Monitor.Scale);
+        Json.Write("upscaled", Monitor.Scale > 1.0);
+        Json.Write("decoded_pixel_share", Monitor.DecodedPixelShare);
+        Json.BeginObject("live");
+        Json.Write("cpu", Monitor.LiveCpu);
+        Json.Write("memory_mb", Monitor.LiveBytes / MB);
+        Json.EndObject();
+        Json.BeginObject("cached");
+        Json.Write("cpu", Monitor.CachedCpu);
+        Json.Write("memory_mb", Monitor.CachedBytes / MB);
+        Json.Write("fits_cache", Monitor.bCacheFits);
+        Json.EndObject();
+        Json.Write("fps_cap", Monitor.FpsCap);
+        Json.Write("cpu_at_cap", Monitor.LiveCpuAtCap);
+        Json.Write("over_budget", Monitor.bOverBudget);
+        Json.EndObject();
+    }
+    Json.EndArray();
+
+    Json.BeginObject("recommended");
+    Json.Write("fps_cap", Report.FpsCap);
+    Json.BeginArray("renditions");
+    for (const auto& Rendition : Report.RecommendedRenditions)
+    {
+        Json.BeginObject();
+        Json.Write("config", "rendition = " + std::to_string(Rendition.Width) + "x" + std::to_string(Rendition.Height) + " " + Rendition.Suffix);
+        Json.Write("width", Rendition.Width);
+        Json.Write("height", Rendition.Height);
+        Json.Write("decode_saving", 1.0 - static_cast<double>(Rendition.Width) * Rendition.Height / (static_cast<double>(Report.Info.Width) * Report.Info.Height));
+        Json.EndObject();
+    }
+    Json.EndArray();
+    Json.EndObject();
+    Json.EndObject();
+}
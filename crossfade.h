@@ -0,0 +1,116 @@
+// Crossfade - Blend kernel and timing of a transition between two videos.
+// While a new video fades in, the outgoing one keeps playing and both are composed
+// into canvases of the same layout; each output pixel is then a weighted mix of the
+// two. The weight follows an eased curve over the configured duration and advances
+// only while frames are shown, so a pause mid-transition resumes where it stopped.
+// Portable C++20: no platform headers (SSE2 intrinsics when available).
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CROSSFADE_SSE2 1
+#else
+#define CROSSFADE_SSE2 0
+#endif
+
+/** Blend weights are 8.8 fixed point: 0 shows only the outgoing pixel, this only the incoming one. */
+constexpr uint32_t CrossfadeWeightOne = 256;
+
+/** Longest wall-clock step one shown frame may advance a transition by (pauses and stalls are skipped). */
+constexpr int64_t MaxCrossfadeStepNs = 100'000'000;
+
+/** From + (To - From) * Weight / 256 per channel; exact at both ends of the weight range. */
+inline uint32_t BlendBgraPixel(uint32_t From, uint32_t To, uint32_t Weight)
+{
+    // Two channels per 32-bit lane, as in the scaler's bilinear taps.
+    uint32_t InvWeight = CrossfadeWeightOne - Weight;
+    uint32_t RedBlue = (((From & 0x00FF00FFu) * InvWeight + (To & 0x00FF00FFu) * Weight) >> 8) & 0x00FF00FFu;
+    uint32_t AlphaGreen = (((From >> 8) & 0x00FF00FFu) * InvWeight + ((To >> 8) & 0x00FF00FFu) * Weight) & 0xFF00FF00u;
+    return RedBlue | AlphaGreen;
+}
+
+/** Scalar reference of BlendBgraRow; also its tail. */
+inline void BlendBgraRowScalar(const uint32_t* From, const uint32_t* To, uint32_t* Out, int32_t Count, uint32_t Weight)
+{
+    for (int32_t X = 0; X < Count; ++X) Out[X] = BlendBgraPixel(From[X], To[X], Weight);
+}
+
+/**
+ * Blends Count BGRA pixels; Out may alias From or To. Four pixels per SSE2 step,
+ * widened to 16 bits: 255 * 256 still fits, so results match the scalar path bit for bit.
+ */
+inline void BlendBgraRow(const uint32_t* From, const uint32_t* To, uint32_t* Out, int32_t Count, uint32_t Weight)
+{
+    int32_t X = 0;
+#if CROSSFADE_SSE2
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i ToWeight = _mm_set1_epi16(static_cast<int16_t>(Weight));
+    const __m128i FromWeight = _mm_set1_epi16(static_cast<int16_t>(CrossfadeWeightOne - Weight));
+    for (; X + 4 <= Count; X += 4)
+    {
+        __m128i A = _mm_loadu_si128(reinterpret_cast<const __m128i*>(From + X));
+        __m128i B = _mm_loadu_si128(reinterpret_cast<const __m128i*>(To + X));
+        __m128i Low = _mm_add_epi16
+        (
+            _mm_mullo_epi16(_mm_unpacklo_epi8(A, Zero), FromWeight),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(B, Zero), ToWeight)
+        );
+        __m128i High = _mm_add_epi16
+        (
+            _mm_mullo_epi16(_mm_unpackhi_epi8(A, Zero), FromWeight),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(B, Zero), ToWeight)
+        );
+        __m128i Packed = _mm_packus_epi16(_mm_srli_epi16(Low, 8), _mm_srli_epi16(High, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + X), Packed);
+    }
+#endif
+    BlendBgraRowScalar(From + X, To + X, Out + X, Count - X, Weight);
+}
+
+/**
+ * Progress of one transition. The caller advances it by the wall time between shown
+ * frames; each step is capped at MaxCrossfadeStepNs so the time spent paused, or
+ * stalled on a slow decoder, does not skip the fade.
+ */
+class FCrossfadeSchedule
+{
+public:
+    /** A duration of zero or less completes at once (a cut). */
+    void Begin(int64_t InDurationNs)
+    {
+        DurationNs = InDurationNs;
+        ElapsedNs = 0;
+        bActive = DurationNs > 0;
+    }
+
+    void Finish() { bActive = false; }
+
+    void Advance(int64_t StepNs)
+    {
+        if (!bActive || StepNs <= 0) return;
+        ElapsedNs += StepNs < MaxCrossfadeStepNs ? StepNs : MaxCrossfadeStepNs;
+        if (ElapsedNs >= DurationNs) bActive = false;
+    }
+
+    bool IsActive() const { return bActive; }
+
+    /** Incoming weight in [0, CrossfadeWeightOne] on a smoothstep curve; CrossfadeWeightOne once finished. */
+    uint32_t GetWeight() const
+    {
+        if (!bActive) return CrossfadeWeightOne;
+        double Progress = static_cast<double>(ElapsedNs) / static_cast<double>(DurationNs);
+        double Eased = Progress * Progress * (3.0 - 2.0 * Progress);
+        return static_cast<uint32_t>(Eased * CrossfadeWeightOne + 0.5);
+    }
+
+    int64_t GetElapsedNs() const { return ElapsedNs; }
+    int64_t GetDurationNs() const { return DurationNs; }
+
+private:
+    int64_t DurationNs = 0;
+    int64_t ElapsedNs = 0;
+    bool bActive = false;
+};
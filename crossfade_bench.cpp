@@ -0,0 +1,352 @@
+// crossfade_bench - Checks and times the crossfade between videos.
+// First the blend kernel is checked against its scalar reference (every weight,
+// odd lengths, in place) and the schedule against its contract (starts at the old
+// video, ends exactly on the new one, never steps back, skips pauses). Then, at 4K
+// by default, it times the kernel on one thread, SSE2 against scalar, and a full
+// compose with and without a fade across the thread pool. Last, a live software
+// pipeline fed by synthetic videos is switched repeatedly with resource tracking on:
+// no switch, after a fade ends or in the middle of one, may ever have more than two
+// sources open, and once the last fade ends the outgoing video and its buffers must
+// be gone. Builds anywhere the portable headers do:
+//   g++ -std=c++20 -O2 -pthread crossfade_bench.cpp -o crossfade_bench
+//   crossfade_bench [--size WxH] [--frames N] [--fade-ms N] [--switches N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crossfade.h"
+#include "resource_tracker.h"
+#include "software_pipeline.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t Width = 3840;
+        int32_t Height = 2160;
+        int32_t Frames = 60;
+        int32_t FadeMs = 300;
+        int32_t Switches = 6;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--size")
+            {
+                if (std::sscanf(Value, "%dx%d", &Options.Width, &Options.Height) != 2) return false;
+                if (Options.Width <= 0 || Options.Height <= 0) return false;
+            }
+            else if (Name == "--frames") Options.Frames = std::atoi(Value);
+            else if (Name == "--fade-ms") Options.FadeMs = std::atoi(Value);
+            else if (Name == "--switches") Options.Switches = std::atoi(Value);
+            else return false;
+        }
+        return Options.Frames > 0 && Options.FadeMs > 0 && Options.Switches > 0;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    bool CheckBlendKernel()
+    {
+        std::mt19937 Random(7);
+        constexpr int32_t MaxLength = 67;
+        std::vector<uint32_t> From(MaxLength), To(MaxLength), Expected(MaxLength), Actual(MaxLength);
+        for (int32_t Length = 0; Length <= MaxLength; ++Length)
+        {
+            for (uint32_t Weight = 0; Weight <= CrossfadeWeightOne; ++Weight)
+            {
+                for (int32_t X = 0; X < Length; ++X)
+                {
+                    From[X] = static_cast<uint32_t>(Random());
+                    To[X] = static_cast<uint32_t>(Random());
+                }
+                BlendBgraRowScalar(From.data(), To.data(), Expected.data(), Length, Weight);
+                BlendBgraRow(From.data(), To.data(), Actual.data(), Length, Weight);
+                if (!Check(std::equal(Expected.begin(), Expected.begin() + Length, Actual.begin()), "kernel differs from scalar")) return false;
+                if (Weight == 0 && !Check(std::equal(From.begin(), From.begin() + Length, Actual.begin()), "weight 0 is not the outgoing pixel")) return false;
+                if (Weight == CrossfadeWeightOne && !Check(std::equal(To.begin(), To.begin() + Length, Actual.begin()), "full weight is not the incoming pixel")) return false;
+
+                // The compositor blends in place, over the incoming pixels.
+                BlendBgraRow(From.data(), To.data(), To.data(), Length, Weight);
+                if (!Check(std::equal(Expected.begin(), Expected.begin() + Length, To.begin()), "in-place blend differs")) return false;
+            }
+        }
+        return true;
+    }
+
+    bool CheckSchedule()
+    {
+        FCrossfadeSchedule Cut;
+        Cut.Begin(0);
+        bool bPass = Check(!Cut.IsActive() && Cut.GetWeight() == CrossfadeWeightOne, "zero duration is not a cut");
+
+        FCrossfadeSchedule Fade;
+        Fade.Begin(500'000'000);
+        bPass &= Check(Fade.IsActive() && Fade.GetWeight() == 0, "fade does not start on the outgoing video");
+        Fade.Advance(60'000'000'000);
+        bPass &= Check(Fade.GetElapsedNs() == MaxCrossfadeStepNs, "a pause is not capped to one step");
+
+        uint32_t Previous = Fade.GetWeight();
+        while (Fade.IsActive())
+        {
+            Fade.Advance(16'666'667);
+            bPass &= Check(Fade.GetWeight() >= Previous, "weight stepped back");
+            Previous = Fade.GetWeight();
+        }
+        bPass &= Check(Previous == CrossfadeWeightOne, "fade does not end on the incoming video");
+        return bPass;
+    }
+
+    /** Two 4K canvases, timed through the scalar and the SIMD kernel on one thread. */
+    void BenchKernel(const FBenchOptions& Options)
+    {
+        FFrame From, To, Out;
+        From.Allocate(Options.Width, Options.Height, EPixelFormat::BGRA8);
+        To.Allocate(Options.Width, Options.Height, EPixelFormat::BGRA8);
+        Out.Allocate(Options.Width, Options.Height, EPixelFormat::BGRA8);
+        for (int32_t Y = 0; Y < Options.Height; ++Y)
+        {
+            std::memset(From.GetView().Row(0, Y), Y & 0xFF, static_cast<size_t>(Options.Width) * 4);
+            std::memset(To.GetView().Row(0, Y), ~Y & 0xFF, static_cast<size_t>(Options.Width) * 4);
+        }
+
+        auto Time = [&](auto&& Kernel)
+        {
+            auto Start = std::chrono::steady_clock::now();
+            for (int32_t Frame = 0; Frame < Options.Frames; ++Frame)
+            {
+                uint32_t Weight = static_cast<uint32_t>(Frame * CrossfadeWeightOne / Options.Frames);
+                for (int32_t Y = 0; Y < Options.Height; ++Y)
+                {
+                    Kernel
+                    (
+                        reinterpret_cast<const uint32_t*>(From.GetView().Row(0, Y)),
+                        reinterpret_cast<const uint32_t*>(To.GetView().Row(0, Y)),
+                        reinterpret_cast<uint32_t*>(Out.GetView().Row(0, Y)), Options.Width, Weight
+                    );
+                }
+            }
+            return ElapsedMs(Start) / Options.Frames;
+        };
+        double ScalarMs = Time(BlendBgraRowScalar);
+        double SimdMs = Time(BlendBgraRow);
+        double Megapixels = static_cast<double>(Options.Width) * Options.Height / 1e6;
+        std::printf("kernel %dx%d, one thread (%s):\n", Options.Width, Options.Height, CROSSFADE_SSE2 ? "SSE2" : "no SIMD");
+        std::printf("  scalar     %7.2f ms/frame (%6.0f Mpx/s)\n", ScalarMs, Megapixels / ScalarMs * 1000);
+        std::printf("  simd       %7.2f ms/frame (%6.0f Mpx/s, %.1fx)\n", SimdMs, Megapixels / SimdMs * 1000, ScalarMs / SimdMs);
+    }
+
+    /** A whole compose at 4K, without and with an outgoing canvas to fade from. */
+    void BenchCompose(const FBenchOptions& Options)
+    {
+        FThreadPool Pool;
+        FSoftwareCompositor Compositor(Pool);
+        FSoftwareCompositor FadeCompositor(Pool);
+        std::vector<FCompositorOutput> Outputs(1);
+        Outputs[0].Target = { 0, 0, Options.Width, Options.Height };
+        Compositor.Configure(Options.Width, Options.Height, Outputs);
+        FadeCompositor.Configure(Options.Width, Options.Height, Outputs);
+
+        FFrame Incoming, Outgoing;
+        Incoming.Allocate(Options.Width, Options.Height, EPixelFormat::BGRA8);
+        Outgoing.Allocate(Options.Width, Options.Height, EPixelFormat::BGRA8);
+        for (int32_t Y = 0; Y < Options.Height; ++Y)
+        {
+            uint32_t* In = reinterpret_cast<uint32_t*>(Incoming.GetView().Row(0, Y));
+            uint32_t* Out = reinterpret_cast<uint32_t*>(Outgoing.GetView().Row(0, Y));
+            for (int32_t X = 0; X < Options.Width; ++X)
+            {
+                In[X] = 0xFF000000u | static_cast<uint32_t>(X * 7 + Y);
+                Out[X] = 0xFF000000u | static_cast<uint32_t>(X - Y * 5) << 8;
+            }
+        }
+        FadeCompositor.Compose(Outgoing.GetView());
+
+        auto Time = [&](bool bFade)
+        {
+            auto Start = std::chrono::steady_clock::now();
+            for (int32_t Frame = 0; Frame < Options.Frames; ++Frame)
+            {
+                uint32_t Weight = 1 + static_cast<uint32_t>(Frame * (CrossfadeWeightOne - 2) / Options.Frames);
+                if (bFade) Compositor.Compose(Incoming.GetView(), FadeCompositor.GetCanvas(), Weight);
+                else Compositor.Compose(Incoming.GetView());
+            }
+            return ElapsedMs(Start) / Options.Frames;
+        };
+        double PlainMs = Time(false);
+        double FadeMs = Time(true);
+        std::printf("compose %dx%d, %zu worker(s) and the caller:\n", Options.Width, Options.Height, Pool.GetWorkerCount());
+        std::printf("  plain      %7.2f ms/frame\n", PlainMs);
+        std::printf("  crossfade  %7.2f ms/frame (+%.2f ms for the blend)\n", FadeMs, FadeMs - PlainMs);
+    }
+
+    /** Codec-free NV12 source: a flat color that drifts, counted while open. */
+    class FSyntheticVideo final : public IVideoSource
+    {
+    public:
+        FSyntheticVideo(int32_t Width, int32_t Height, uint8_t InLuma) : Luma(InLuma)
+        {
+            Info.Width = Width;
+            Info.Height = Height;
+            Info.Format = EPixelFormat::NV12;
+            Info.FrameRateNumerator = 60;
+            Info.Duration100ns = Info.FrameDuration100ns() * 30;
+            RESOURCE_ACQUIRE("Bench.Source", Handle);
+        }
+
+        ~FSyntheticVideo() override { RESOURCE_RELEASE("Bench.Source", Handle); }
+
+        const FVideoInfo& GetInfo() const override { return Info; }
+
+        bool ReadFrame(FFrame& Out) override
+        {
+            if (Position100ns >= Info.Duration100ns) return false;
+            Out.Allocate(Info.Width, Info.Height, EPixelFormat::NV12);
+            const FFrameView& View = Out.GetView();
+            int32_t Phase = static_cast<int32_t>(Position100ns / Info.FrameDuration100ns());
+            for (int32_t Y = 0; Y < View.Height; ++Y) std::memset(View.Row(0, Y), Luma + Phase, static_cast<size_t>(View.Width));
+            for (int32_t Y = 0; Y < View.Height / 2; ++Y) std::memset(View.Row(1, Y), 128, static_cast<size_t>(View.Width));
+            Out.Timestamp100ns = Position100ns;
+            Position100ns += Info.FrameDuration100ns();
+            return true;
+        }
+
+        bool Seek(int64_t Position100nsIn) override
+        {
+            Position100ns = Position100nsIn < 0 ? 0 : Position100nsIn;
+            return true;
+        }
+
+    private:
+        FVideoInfo Info;
+        uint8_t Luma = 16;
+        int64_t Position100ns = 0;
+    };
+
+    class FNullPresenter final : public ISurfacePresenter<int32_t>
+    {
+    public:
+        void Present(const int32_t&, const FFrameView&, const std::vector<FIntRect>&) override
+        {
+            Presents.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> Presents{ 0 };
+    };
+
+    int64_t GetLive(const char* Subsystem, EResourceKind Kind, int64_t* Peak = nullptr)
+    {
+        for (const auto& Count : GResources.Snapshot())
+        {
+            if (std::strcmp(Count.Subsystem, Subsystem) != 0 || Count.Kind != Kind) continue;
+            if (Peak) *Peak = Count.Peak;
+            return Count.Live;
+        }
+        return 0;
+    }
+
+    /** Waits until the decode thread has taken a switch (true) or finished its fade (false). */
+    bool WaitForFade(const TSoftwarePipeline<int32_t>& Pipeline, bool bWantCrossfading, int32_t TimeoutMs)
+    {
+        auto Start = std::chrono::steady_clock::now();
+        while (Pipeline.IsCrossfading() != bWantCrossfading)
+        {
+            if (ElapsedMs(Start) > TimeoutMs) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+
+    /** Real-time switches through a live pipeline: the first half wait for each fade, the rest land mid-fade. */
+    bool CheckPipeline(const FBenchOptions& Options)
+    {
+        FNullPresenter Presenter;
+        auto Layout = BuildSoftwareLayout<int32_t>({ { 0, 0, 640, 360 }, { 640, 0, 1280, 360 } }, { 1, 2 }, false, {});
+        int32_t TimeoutMs = Options.FadeMs * 4 + 2000;
+        bool bPass = true;
+        {
+            TSoftwarePipeline<int32_t> Pipeline(Presenter);
+            Pipeline.Start(std::make_unique<FSyntheticVideo>(320, 180, 40), Layout, false);
+            for (int32_t Switch = 0; Switch < Options.Switches; ++Switch)
+            {
+                bool bMidFade = Switch >= Options.Switches / 2;
+                if (bMidFade && Switch == Options.Switches / 2)
+                {
+                    int64_t PeakSources = 0;
+                    GetLive("Bench.Source", EResourceKind::Handle, &PeakSources);
+                    bPass &= Check(PeakSources <= 2, "more than two sources open across whole fades");
+                }
+                int32_t Size = Switch % 3 == 0 ? 2 : 1;
+                auto Open = [Size, Switch]
+                {
+                    return std::make_unique<FSyntheticVideo>(320 * Size, 180 * Size, static_cast<uint8_t>(60 + Switch * 20));
+                };
+                bPass &= Check(Pipeline.Crossfade(Open, Options.FadeMs * 1000000LL), "next video did not open");
+                bPass &= Check(WaitForFade(Pipeline, true, TimeoutMs), "switch never started fading");
+                if (bMidFade) std::this_thread::sleep_for(std::chrono::milliseconds(Options.FadeMs / 3));
+                else bPass &= Check(WaitForFade(Pipeline, false, TimeoutMs), "fade never finished");
+            }
+            bPass &= Check(WaitForFade(Pipeline, false, TimeoutMs), "last fade never finished");
+
+            int64_t PeakSources = 0;
+            GetLive("Bench.Source", EResourceKind::Handle, &PeakSources);
+            std::printf
+            (
+                "pipeline: %d switches, %llu presents, %lld dropped; peak sources %lld, fade buffers after %lld bytes\n",
+                Options.Switches, static_cast<unsigned long long>(Presenter.Presents.load()),
+                static_cast<long long>(Pipeline.GetDroppedFrames()), static_cast<long long>(PeakSources),
+                static_cast<long long>(GetLive("Software.Fade", EResourceKind::HeapBytes))
+            );
+            bPass &= Check(!Pipeline.HasFailed(), "pipeline failed");
+            bPass &= Check(PeakSources <= 2, "more than two sources open across switches mid-fade");
+            bPass &= Check(GetLive("Bench.Source", EResourceKind::Handle) == 1, "outgoing source still open after the fade");
+            bPass &= Check(GetLive("Software.Fade", EResourceKind::HeapBytes) == 0, "fade frame still allocated after the fade");
+        }
+        bPass &= Check(GetLive("Bench.Source", EResourceKind::Handle) == 0, "source open after the pipeline stopped");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: crossfade_bench [--size WxH] [--frames N] [--fade-ms N] [--switches N]\n");
+        return 2;
+    }
+    GResources.SetEnabled(true);
+
+    bool bPass = Check(CheckBlendKernel(), "blend kernel");
+    bPass &= Check(CheckSchedule(), "schedule");
+    BenchKernel(Options);
+    BenchCompose(Options);
+    bPass &= CheckPipeline(Options);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,876 @@
+// DecodeService - One decoder per distinct (video, resolution), shared by every session.
+// On a multi-session host each wallpaper instance would otherwise decode the same
+// file on its own. FDecodeService runs in a separate process: sessions connect to
+// its socket and attach to a stream; the first attach opens the decoder and a
+// shared segment (see shared_frames.h), later ones just map it. Each stream opens and
+// decodes on its own thread, paced on media timestamps, so a slow probe holds up only
+// the sessions waiting for that stream; it rings a one-byte doorbell on every
+// attached connection after each frame.
+// The connection is the reference: a session that exits or crashes closes it (the
+// kernel does that for a dead process), the count drops, and a stream left without
+// sessions is torn down - decoder, segment and name - after a short linger that lets
+// a reloading session reattach. In the other direction, FSharedFrameSource notices a
+// dead or hung service (the connection closes or the doorbell stays silent) and
+// switches to decoding locally, so a service crash costs a session one stall, never
+// its wallpaper. Segment names carry the service's process id, and a service sweeps
+// only the segments of services that are gone.
+// The socket gets an explicit mode (0600 unless a host-wide service opens it up),
+// and a session of another user is served only files that user could read itself.
+// POSIX: shared memory, Unix sockets and threads. The protocol is portable; a Windows
+// build would carry it over named file mappings and pipes.
+
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <poll.h>
+#include <pwd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_protocol.h"
+#include "control_socket.h"
+#include "qos.h"
+#include "resource_tracker.h"
+#include "shared_frames.h"
+#include "video_source.h"
+
+/** Per-user socket path; a host-wide service passes its own path to both sides. */
+inline std::string GetDecodeServicePath()
+{
+    const char* RuntimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (RuntimeDir && *RuntimeDir) return std::string(RuntimeDir) + "/" + DecodeServiceEndpointName + ".sock";
+    return std::string("/tmp/") + DecodeServiceEndpointName + "-" + std::to_string(getuid()) + ".sock";
+}
+
+/** A mapped POSIX shared memory segment. Move-only; unmaps (but does not unlink) on destruction. */
+class FSharedMemory
+{
+public:
+    FSharedMemory() = default;
+    ~FSharedMemory() { Unmap(); }
+
+    FSharedMemory(FSharedMemory&& Other) noexcept { *this = std::move(Other); }
+    FSharedMemory& operator=(FSharedMemory&& Other) noexcept
+    {
+        if (this == &Other) return *this;
+        Unmap();
+        Data = Other.Data;
+        Size = Other.Size;
+        Other.Data = nullptr;
+        Other.Size = 0;
+        return *this;
+    }
+    FSharedMemory(const FSharedMemory&) = delete;
+    FSharedMemory& operator=(const FSharedMemory&) = delete;
+
+    /** New zero-filled segment at exactly Mode, whatever the umask; replaces one left behind under the same name. */
+    bool Create(const std::string& Name, size_t InSize, mode_t Mode)
+    {
+        std::string Path = "/" + Name;
+        shm_unlink(Path.c_str());
+        int Handle = shm_open(Path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (Handle < 0) return false;
+        bool bMapped = fchmod(Handle, Mode) == 0 && ftruncate(Handle, static_cast<off_t>(InSize)) == 0
+            && Map(Handle, InSize, PROT_READ | PROT_WRITE);
+        close(Handle);
+        if (!bMapped) shm_unlink(Path.c_str());
+        return bMapped;
+    }
+
+    /** Maps an existing segment read-only, at its full size. */
+    bool Open(const std::string& Name)
+    {
+        int Handle = shm_open(("/" + Name).c_str(), O_RDONLY, 0);
+        if (Handle < 0) return false;
+        struct stat FileInfo = {};
+        bool bMapped = fstat(Handle, &FileInfo) == 0 && FileInfo.st_size > 0
+            && Map(Handle, static_cast<size_t>(FileInfo.st_size), PROT_READ);
+        close(Handle);
+        return bMapped;
+    }
+
+    static void Unlink(const std::string& Name) { shm_unlink(("/" + Name).c_str()); }
+
+    void Unmap()
+    {
+        if (!Data) return;
+        munmap(Data, Size);
+        Data = nullptr;
+        Size = 0;
+        RESOURCE_RELEASE("SharedFrames", Handle);
+    }
+
+    void* GetData() const { return Data; }
+    size_t GetSize() const { return Size; }
+
+private:
+    bool Map(int Handle, size_t InSize, int Protection)
+    {
+        void* Mapped = mmap(nullptr, InSize, Protection, MAP_SHARED, Handle, 0);
+        if (Mapped == MAP_FAILED) return false;
+        Data = Mapped;
+        Size = InSize;
+        RESOURCE_ACQUIRE("SharedFrames", Handle);
+        return true;
+    }
+
+    void* Data = nullptr;
+    size_t Size = 0;
+};
+
+/** -1 on failure. */
+inline int ConnectUnixSocket(const std::string& Path)
+{
+    sockaddr_un Address = {};
+    Address.sun_family = AF_UNIX;
+    if (Path.size() >= sizeof(Address.sun_path)) return -1;
+    Path.copy(Address.sun_path, Path.size());
+
+    int Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (Socket < 0) return -1;
+    if (connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0) return Socket;
+    close(Socket);
+    return -1;
+}
+
+inline bool SendAll(int Socket, const std::string& Data)
+{
+    size_t Sent = 0;
+    while (Sent < Data.size())
+    {
+        ssize_t Result = send(Socket, Data.data() + Sent, Data.size() - Sent, MSG_NOSIGNAL);
+        if (Result <= 0) return false;
+        Sent += static_cast<size_t>(Result);
+    }
+    return true;
+}
+
+/** Sends one request frame and waits up to TimeoutMs for the reply's payload. */
+inline bool RequestOverSocket(int Socket, const std::string& Request, std::string& Reply, int32_t TimeoutMs)
+{
+    std::string Frame;
+    AppendControlFrame(Frame, Request);
+    if (!SendAll(Socket, Frame)) return false;
+
+    FControlFrameReader Reader;
+    auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TimeoutMs);
+    char Buffer[4096];
+    for (;;)
+    {
+        EControlFrameResult Result = Reader.Next(Reply);
+        if (Result == EControlFrameResult::Frame) return true;
+        if (Result == EControlFrameResult::Invalid) return false;
+        auto Remaining = std::chrono::duration_cast<std::chrono::milliseconds>(Deadline - std::chrono::steady_clock::now());
+        pollfd Poll = { Socket, POLLIN, 0 };
+        if (Remaining.count() <= 0 || poll(&Poll, 1, static_cast<int>(Remaining.count())) <= 0) return false;
+        ssize_t Read = recv(Socket, Buffer, sizeof(Buffer), 0);
+        if (Read <= 0) return false;
+        Reader.Append(Buffer, static_cast<size_t>(Read));
+    }
+}
+
+/**
+ * Whether Uid, with primary group Gid and the groups the user database lists for it,
+ * may read the regular file at the absolute Path: search on every directory above it
+ * and read on the file, by mode bits alone (ACLs are not consulted, so they can only
+ * make this refuse).
+ */
+inline bool CanUserReadFile(const std::string& Path, uid_t Uid, gid_t Gid)
+{
+    if (Uid == 0) return true;
+    std::vector<gid_t> Groups(1, Gid);
+    passwd Entry = {};
+    passwd* Found = nullptr;
+    std::vector<char> Buffer(16384);
+    if (getpwuid_r(Uid, &Entry, Buffer.data(), Buffer.size(), &Found) == 0 && Found)
+    {
+        int Count = 64;
+        Groups.resize(static_cast<size_t>(Count));
+        if (getgrouplist(Found->pw_name, Gid, Groups.data(), &Count) < 0)
+        {
+            Groups.resize(static_cast<size_t>(Count));
+            getgrouplist(Found->pw_name, Gid, Groups.data(), &Count);
+        }
+        Groups.resize(static_cast<size_t>(Count));
+    }
+    auto IsAllowed = [&](const struct stat& Info, mode_t UserBit, mode_t GroupBit, mode_t OtherBit)
+    {
+        if (Info.st_uid == Uid) return (Info.st_mode & UserBit) != 0;
+        for (gid_t Group : Groups)
+        {
+            if (Group == Info.st_gid) return (Info.st_mode & GroupBit) != 0;
+        }
+        return (Info.st_mode & OtherBit) != 0;
+    };
+
+    struct stat Info = {};
+    for (size_t Slash = Path.find('/'); Slash != std::string::npos; Slash = Path.find('/', Slash + 1))
+    {
+        std::string Directory = Slash == 0 ? "/" : Path.substr(0, Slash);
+        if (stat(Directory.c_str(), &Info) != 0 || !IsAllowed(Info, S_IXUSR, S_IXGRP, S_IXOTH)) return false;
+    }
+    return stat(Path.c_str(), &Info) == 0 && S_ISREG(Info.st_mode) && IsAllowed(Info, S_IRUSR, S_IRGRP, S_IROTH);
+}
+
+/**
+ * Opens a decoder for a stream key; Width x Height is the size frames should cover.
+ * nullptr if it cannot. Called on the stream's own thread, so streams open in parallel.
+ */
+using FSourceFactory = std::function<std::unique_ptr<IVideoSource>(const std::string& Path, int32_t Width, int32_t Height)>;
+
+struct FDecodeServiceSettings
+{
+    std::string SocketPath;         // Empty: GetDecodeServicePath()
+    mode_t SocketMode = S_IRUSR | S_IWUSR;  // Whatever the umask; a host-wide service opens it to other users
+    int32_t LingerMs = 2000;        // A stream without sessions decodes on this long, so a reload reattaches
+    size_t MaxStreams = 16;
+    size_t MaxConnections = 256;
+};
+
+class FDecodeService
+{
+public:
+    FDecodeService(FSourceFactory InOpenSource, FDecodeServiceSettings InSettings)
+        : OpenSource(std::move(InOpenSource))
+        , Settings(std::move(InSettings))
+    {
+        if (Settings.SocketPath.empty()) Settings.SocketPath = GetDecodeServicePath();
+    }
+
+    ~FDecodeService()
+    {
+        for (auto& Connection : Connections) close(Connection.Socket);
+        Connections.clear();
+        for (auto& [Name, Stream] : Streams) StopStream(*Stream);
+        Streams.clear();
+        if (ListenSocket >= 0)
+        {
+            close(ListenSocket);
+            unlink(Settings.SocketPath.c_str());
+        }
+        for (int Handle : WakePipe)
+        {
+            if (Handle >= 0) close(Handle);
+        }
+    }
+
+    FDecodeService(const FDecodeService&) = delete;
+    FDecodeService& operator=(const FDecodeService&) = delete;
+
+    /** Binds the socket at SocketMode. Fails if another service answers on it; otherwise clears what dead ones left. */
+    bool Listen(std::string& Error)
+    {
+        int Existing = ConnectUnixSocket(Settings.SocketPath);
+        if (Existing >= 0)
+        {
+            close(Existing);
+            Error = "a decode service is already running on " + Settings.SocketPath;
+            return false;
+        }
+        unlink(Settings.SocketPath.c_str());
+        SweepSegments();
+
+        sockaddr_un Address = {};
+        Address.sun_family = AF_UNIX;
+        if (Settings.SocketPath.size() >= sizeof(Address.sun_path))
+        {
+            Error = "socket path too long";
+            return false;
+        }
+        Settings.SocketPath.copy(Address.sun_path, Settings.SocketPath.size());
+        if (pipe2(WakePipe, O_CLOEXEC | O_NONBLOCK) != 0)
+        {
+            WakePipe[0] = WakePipe[1] = -1;
+            Error = "cannot create the wake pipe";
+            return false;
+        }
+        // Connections are refused until listen(), so nothing gets in under the umask's mode.
+        ListenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (ListenSocket < 0 || bind(ListenSocket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0
+            || chmod(Settings.SocketPath.c_str(), Settings.SocketMode) != 0 || listen(ListenSocket, 64) != 0)
+        {
+            Error = "cannot listen on " + Settings.SocketPath;
+            return false;
+        }
+        return true;
+    }
+
+    /** Serves until bQuit; requests, detaches and teardown all happen on this thread. */
+    void Run(const std::atomic<bool>& bQuit)
+    {
+        std::vector<pollfd> Polls;
+        while (!bQuit.load(std::memory_order_relaxed))
+        {
+            Polls.assign({ pollfd{ ListenSocket, POLLIN, 0 }, pollfd{ WakePipe[0], POLLIN, 0 } });
+            for (const auto& Connection : Connections) Polls.push_back({ Connection.Socket, POLLIN, 0 });
+            if (poll(Polls.data(), Polls.size(), ServicePollMs) > 0)
+            {
+                // Connections accepted below are not in Polls yet; walk only the ones that were.
+                size_t Polled = Polls.size() - 2;
+                for (size_t Index = Polled; Index-- > 0;)
+                {
+                    if (Polls[Index + 2].revents) Receive(Index);
+                }
+                if (Polls[0].revents & POLLIN) Accept();
+                char Drain[64];
+                while ((Polls[1].revents & POLLIN) && read(WakePipe[0], Drain, sizeof(Drain)) > 0) {}
+            }
+            CompleteAttaches();
+            DropFailedStreams();
+            ReapIdleStreams();
+        }
+    }
+
+    /** key=value lines, as returned for "status". */
+    std::string FormatStatus() const
+    {
+        std::string Text = "streams=" + std::to_string(Streams.size());
+        Text += "\nconnections=" + std::to_string(Connections.size());
+        Text += "\nattaches=" + std::to_string(Attaches);
+        Text += "\ndetaches=" + std::to_string(Detaches);
+        size_t Index = 0;
+        for (const auto& [Name, Stream] : Streams)
+        {
+            std::string Key = "\nstream." + std::to_string(Index++) + ".";
+            bool bOpened = Stream->bOpened.load(std::memory_order_acquire);
+            Text += Key + "name=" + Name;
+            Text += Key + "state=" + (bOpened ? "open" : Stream->bFailed.load(std::memory_order_relaxed) ? "failed" : "opening");
+            if (bOpened) Text += Key + "size=" + std::to_string(Stream->Info.Width) + "x" + std::to_string(Stream->Info.Height);
+            Text += Key + "clients=" + std::to_string(Stream->Clients);
+            Text += Key + "frames=" + std::to_string(Stream->Frames.load(std::memory_order_relaxed));
+            Text += Key + "path=" + Stream->Path;
+        }
+        return Text;
+    }
+
+private:
+    /** Bounds how long an idle stream outlives its linger and a failed one its sessions. */
+    static constexpr int32_t ServicePollMs = 100;
+
+    /** How long a session that does not read its replies may hold up the service thread before it is dropped. */
+    static constexpr int32_t ServiceSendTimeoutMs = 100;
+
+    struct FStream
+    {
+        std::string Name;
+        std::string Path;
+        int32_t Width = 0;                  // Size the sessions asked for
+        int32_t Height = 0;
+        // Written by the stream thread before bOpened (or bFailed) is set, read-only after.
+        FVideoInfo Info;
+        std::unique_ptr<IVideoSource> Source;
+        FSharedMemory Memory;
+        FSharedFrameWriter Writer;
+        std::thread Thread;
+        std::mutex Mutex;
+        std::condition_variable Condition;
+        bool bStopping = false;             // Under Mutex
+        std::vector<int> Doorbells;         // Under Mutex: sockets of attached sessions
+        std::string OpenError;
+        std::atomic<uint64_t> Frames{ 0 };
+        std::atomic<bool> bOpened{ false };
+        std::atomic<bool> bFailed{ false };
+        int32_t Clients = 0;
+        std::chrono::steady_clock::time_point IdleSince;
+    };
+
+    struct FConnection
+    {
+        int Socket = -1;
+        FControlFrameReader Reader;
+        FStream* Stream = nullptr;
+        bool bCounted = false;          // Counted in Stream->Clients and ringing
+        bool bAwaitingOpen = false;     // Attach answered once Stream opens (or fails to)
+        uid_t Uid = 0;                  // Peer credentials, taken at accept
+        gid_t Gid = 0;
+    };
+
+    void Accept()
+    {
+        int Socket = accept4(ListenSocket, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (Socket < 0) return;
+        uid_t Uid = 0;
+        gid_t Gid = 0;
+        if (Connections.size() >= Settings.MaxConnections || !GetSocketPeerCredentials(Socket, Uid, Gid))
+        {
+            close(Socket);
+            return;
+        }
+        Connections.push_back({});
+        Connections.back().Socket = Socket;
+        Connections.back().Uid = Uid;
+        Connections.back().Gid = Gid;
+    }
+
+    void Receive(size_t Index)
+    {
+        char Buffer[4096];
+        ssize_t Read = recv(Connections[Index].Socket, Buffer, sizeof(Buffer), MSG_DONTWAIT);
+        if (Read == 0 || (Read < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            Disconnect(Index);
+            return;
+        }
+        if (Read < 0) return;
+        Connections[Index].Reader.Append(Buffer, static_cast<size_t>(Read));
+        ServeRequests(Index);
+    }
+
+    /**
+     * Answers the complete requests buffered on a connection, up to an attach that waits
+     * for its stream. An attached session starts ringing once they are all answered, so
+     * no doorbell byte lands between its replies.
+     */
+    void ServeRequests(size_t Index)
+    {
+        FConnection& Connection = Connections[Index];
+        std::string Payload;
+        for (;;)
+        {
+            EControlFrameResult Result = Connection.Reader.Next(Payload);
+            if (Result == EControlFrameResult::Incomplete)
+            {
+                if (Connection.Stream && !Connection.bCounted) AddDoorbell(Connection);
+                return;
+            }
+            if (Result == EControlFrameResult::Invalid)
+            {
+                Disconnect(Index);
+                return;
+            }
+            FControlResponse Response = Handle(Connection, Payload);
+            // Answered by CompleteAttaches(), which serves anything pipelined behind it too.
+            if (Connection.bAwaitingOpen) return;
+            std::string Reply;
+            AppendControlFrame(Reply, FormatControlResponse(Response));
+            if (!SendWithTimeout(Connection.Socket, Reply, ServiceSendTimeoutMs))
+            {
+                Disconnect(Index);
+                return;
+            }
+        }
+    }
+
+    FControlResponse Handle(FConnection& Connection, const std::string& Payload)
+    {
+        std::string_view Word;
+        std::string_view Argument;
+        SplitControlWord(Payload, Word, Argument);
+        if (Word == "status") return { true, FormatStatus() };
+        if (Word != "attach") return { false, "unknown command '" + std::string(Word) + "'" };
+        if (Connection.Stream) return { false, "already attached" };
+
+        std::string Path;
+        int32_t Width = 0;
+        int32_t Height = 0;
+        if (!ParseAttachArgument(Argument, Path, Width, Height)) return { false, "usage: attach <W>x<H> <path>" };
+        if (!ResolveStreamPath(Connection, Path)) return { false, "cannot read " + Path };
+
+        std::string Name = GetSharedStreamName(getpid(), Path, Width, Height);
+        auto Found = Streams.find(Name);
+        FStream* Stream = Found != Streams.end() ? Found->second.get() : nullptr;
+        if (Stream && Stream->bFailed.load(std::memory_order_relaxed)) return { false, "stream failed" };
+        if (!Stream)
+        {
+            if (Streams.size() >= Settings.MaxStreams) return { false, "too many streams" };
+            Stream = StartStream(Name, Path, Width, Height);
+        }
+        Connection.Stream = Stream;
+        if (!Stream->bOpened.load(std::memory_order_acquire))
+        {
+            Connection.bAwaitingOpen = true;
+            return {};
+        }
+        return GetAttachResponse(*Stream);
+    }
+
+    static FControlResponse GetAttachResponse(const FStream& Stream)
+    {
+        return { true, Stream.Name + " " + std::to_string(Stream.Memory.GetSize()) };
+    }
+
+    /**
+     * Turns Path into what the stream is opened by: built-in sources (":pattern") stay
+     * as they are, files become their real path, so the file checked is the one opened.
+     * A session of another user is refused anything but a file it could read itself;
+     * the service's own user keeps any path its factory takes.
+     */
+    static bool ResolveStreamPath(const FConnection& Connection, std::string& Path)
+    {
+        if (Path.starts_with(':')) return true;
+        bool bForeign = Connection.Uid != geteuid();
+        char* RealPath = realpath(Path.c_str(), nullptr);
+        if (!RealPath) return !bForeign;
+        Path = RealPath;
+        std::free(RealPath);
+        return !bForeign || CanUserReadFile(Path, Connection.Uid, Connection.Gid);
+    }
+
+    /** Answers attaches that waited for their stream to open (or fail to). */
+    void CompleteAttaches()
+    {
+        for (size_t Index = Connections.size(); Index-- > 0;)
+        {
+            FConnection& Connection = Connections[Index];
+            if (!Connection.bAwaitingOpen) continue;
+            FStream& Stream = *Connection.Stream;
+            bool bOpened = Stream.bOpened.load(std::memory_order_acquire);
+            if (!bOpened && !Stream.bFailed.load(std::memory_order_acquire)) continue;
+
+            Connection.bAwaitingOpen = false;
+            if (!bOpened) Connection.Stream = nullptr;
+            std::string Reply;
+            AppendControlFrame(Reply, FormatControlResponse(bOpened ? GetAttachResponse(Stream) : FControlResponse{ false, Stream.OpenError }));
+            if (!SendWithTimeout(Connection.Socket, Reply, ServiceSendTimeoutMs))
+            {
+                Disconnect(Index);
+                continue;
+            }
+            ServeRequests(Index);
+        }
+    }
+
+    void AddDoorbell(FConnection& Connection)
+    {
+        FStream& Stream = *Connection.Stream;
+        Connection.bCounted = true;
+        ++Attaches;
+        ++Stream.Clients;
+        Stream.Writer.SetClients(static_cast<uint32_t>(Stream.Clients));
+        std::lock_guard<std::mutex> Lock(Stream.Mutex);
+        Stream.Doorbells.push_back(Connection.Socket);
+    }
+
+    /** The stream opens on its own thread; sessions attaching meanwhile are answered when it is ready. */
+    FStream* StartStream(const std::string& Name, const std::string& Path, int32_t Width, int32_t Height)
+    {
+        auto Stream = std::make_unique<FStream>();
+        Stream->Name = Name;
+        Stream->Path = Path;
+        Stream->Width = Width;
+        Stream->Height = Height;
+        Stream->IdleSince = std::chrono::steady_clock::now();
+        FStream* Raw = Stream.get();
+        Raw->Thread = std::thread([this, Raw] { RunStream(*Raw); });
+        Streams.emplace(Name, std::move(Stream));
+        return Raw;
+    }
+
+    /** Stream thread: opens the decoder (probing the file can take a while) and the segment, then decodes. */
+    void RunStream(FStream& Stream)
+    {
+        GQos.EnterThread(EWorkClass::Decode);
+        bool bOpened = OpenStream(Stream);
+        (bOpened ? Stream.bOpened : Stream.bFailed).store(true, std::memory_order_release);
+        // Wakes the service thread to answer the sessions waiting on this stream; a full pipe is awake already.
+        char Byte = 0;
+        [[maybe_unused]] ssize_t Written = write(WakePipe[1], &Byte, 1);
+        if (bOpened) Decode(Stream);
+    }
+
+    bool OpenStream(FStream& Stream)
+    {
+        Stream.Source = OpenSource(Stream.Path, Stream.Width, Stream.Height);
+        if (!Stream.Source)
+        {
+            Stream.OpenError = "cannot decode " + Stream.Path;
+            return false;
+        }
+        Stream.Info = Stream.Source->GetInfo();
+        FSharedStreamLayout Layout = GetSharedStreamLayout(Stream.Info.Width, Stream.Info.Height, Stream.Info.Format);
+        // Sessions of other users can map frames only where they may connect: a host-wide service.
+        mode_t Mode = S_IRUSR | S_IWUSR | (Settings.SocketMode & (S_IRGRP | S_IROTH));
+        if (!Layout.TotalBytes || !Stream.Memory.Create(Stream.Name, Layout.TotalBytes, Mode)
+            || !Stream.Writer.Initialize(Stream.Memory.GetData(), Stream.Memory.GetSize(), Stream.Info))
+        {
+            FSharedMemory::Unlink(Stream.Name);
+            Stream.OpenError = "cannot create shared memory for " + Stream.Path;
+            return false;
+        }
+        return true;
+    }
+
+    /** Paced on media timestamps like the software pipeline, looping at the end. */
+    void Decode(FStream& Stream)
+    {
+        FFrame Frame;
+        Frame.SetResourceTag("DecodeService.Decode");
+        auto Anchor = std::chrono::steady_clock::now();
+        int64_t AnchorTimestamp = -1;
+        int32_t ConsecutiveFailures = 0;
+        for (;;)
+        {
+            if (!Stream.Source->ReadFrame(Frame))
+            {
+                if (++ConsecutiveFailures > 2 || !Stream.Source->Seek(0)) break;
+                AnchorTimestamp = -1;
+                continue;
+            }
+            ConsecutiveFailures = 0;
+
+            auto Now = std::chrono::steady_clock::now();
+            if (AnchorTimestamp < 0 || Frame.Timestamp100ns < AnchorTimestamp)
+            {
+                Anchor = Now;
+                AnchorTimestamp = Frame.Timestamp100ns;
+            }
+            auto Due = Anchor + std::chrono::nanoseconds((Frame.Timestamp100ns - AnchorTimestamp) * 100);
+            {
+                std::unique_lock<std::mutex> Lock(Stream.Mutex);
+                if (Stream.Condition.wait_until(Lock, Due, [&] { return Stream.bStopping; })) return;
+            }
+            if (!Stream.Writer.Publish(Frame.GetView(), Frame.Timestamp100ns)) break;
+            Stream.Frames.fetch_add(1, std::memory_order_relaxed);
+
+            // Non-blocking: a session that stopped reading (paused) fills its buffer and just misses rings.
+            std::lock_guard<std::mutex> Lock(Stream.Mutex);
+            for (int Socket : Stream.Doorbells) send(Socket, "f", 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+        }
+        Stream.Writer.Close();
+        Stream.bFailed.store(true, std::memory_order_relaxed);
+    }
+
+    void Disconnect(size_t Index)
+    {
+        FConnection& Connection = Connections[Index];
+        if (FStream* Stream = Connection.bCounted ? Connection.Stream : nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(Stream->Mutex);
+                std::erase(Stream->Doorbells, Connection.Socket);
+            }
+            if (--Stream->Clients == 0) Stream->IdleSince = std::chrono::steady_clock::now();
+            Stream->Writer.SetClients(static_cast<uint32_t>(Stream->Clients));
+            ++Detaches;
+        }
+        // Off the doorbell list first: the decode thread must not ring a socket number that gets reused.
+        close(Connection.Socket);
+        Connections.erase(Connections.begin() + static_cast<ptrdiff_t>(Index));
+    }
+
+    /** Sessions of a stream whose decoder died are cut off, so they fall back to decoding themselves. */
+    void DropFailedStreams()
+    {
+        for (size_t Index = Connections.size(); Index-- > 0;)
+        {
+            FStream* Stream = Connections[Index].Stream;
+            if (Stream && Stream->bFailed.load(std::memory_order_relaxed)) Disconnect(Index);
+        }
+    }
+
+    void ReapIdleStreams()
+    {
+        auto Now = std::chrono::steady_clock::now();
+        for (auto Iterator = Streams.begin(); Iterator != Streams.end();)
+        {
+            FStream& Stream = *Iterator->second;
+            bool bOpening = !Stream.bOpened.load(std::memory_order_acquire) && !Stream.bFailed.load(std::memory_order_relaxed);
+            bool bIdle = Stream.Clients == 0 && !bOpening
+                && (Stream.bFailed.load(std::memory_order_relaxed) || Now - Stream.IdleSince >= std::chrono::milliseconds(Settings.LingerMs));
+            if (!bIdle)
+            {
+                ++Iterator;
+                continue;
+            }
+            StopStream(Stream);
+            Iterator = Streams.erase(Iterator);
+        }
+    }
+
+    void StopStream(FStream& Stream)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(Stream.Mutex);
+            Stream.bStopping = true;
+        }
+        Stream.Condition.notify_all();
+        if (Stream.Thread.joinable()) Stream.Thread.join();
+        Stream.Writer.Close();
+        Stream.Memory.Unmap();
+        FSharedMemory::Unlink(Stream.Name);
+    }
+
+    /**
+     * Segments of this user's services that are gone, found in /dev/shm; those of a
+     * running service (another socket, say) are left alone. Sessions still mapping a
+     * swept segment keep their mapping.
+     */
+    void SweepSegments()
+    {
+        DIR* Directory = opendir("/dev/shm");
+        if (!Directory) return;
+        while (dirent* Entry = readdir(Directory))
+        {
+            int64_t Owner = 0;
+            if (!ParseSharedStreamOwner(Entry->d_name, Owner) || Owner <= 0 || Owner > std::numeric_limits<pid_t>::max()) continue;
+            struct stat FileInfo = {};
+            std::string Path = std::string("/dev/shm/") + Entry->d_name;
+            if (stat(Path.c_str(), &FileInfo) != 0 || FileInfo.st_uid != geteuid()) continue;
+            if (kill(static_cast<pid_t>(Owner), 0) != 0 && errno == ESRCH) FSharedMemory::Unlink(Entry->d_name);
+        }
+        closedir(Directory);
+    }
+
+    FSourceFactory OpenSource;
+    FDecodeServiceSettings Settings;
+    int ListenSocket = -1;
+    int WakePipe[2] = { -1, -1 };       // Stream threads write a byte once their stream opens or fails to
+    std::vector<FConnection> Connections;
+    std::map<std::string, std::unique_ptr<FStream>> Streams;
+    uint64_t Attaches = 0;
+    uint64_t Detaches = 0;
+};
+
+/**
+ * Session side: a video source reading a stream of the decode service. ReadFrame
+ * waits for the service's doorbell and copies the newest frame; a session that
+ * falls behind skips to it. If the service goes away, closes the stream or stays
+ * silent for StallTimeoutMs, the source detaches and continues with OpenFallback's
+ * local decoder (or fails, without one). Live: seeks are not possible while shared.
+ */
+class FSharedFrameSource final : public IVideoSource
+{
+public:
+    using FFallbackFactory = std::function<std::unique_ptr<IVideoSource>()>;
+
+    explicit FSharedFrameSource(FFallbackFactory InOpenFallback = {}, int32_t InStallTimeoutMs = 3000)
+        : OpenFallback(std::move(InOpenFallback))
+        , StallTimeoutMs(InStallTimeoutMs)
+    {
+    }
+
+    ~FSharedFrameSource() override { Detach(); }
+
+    /** False (with Error) if the service is not running or cannot provide the stream. */
+    bool Attach(const std::string& SocketPath, const std::string& Path, int32_t Width, int32_t Height, std::string& Error)
+    {
+        Detach();
+        Socket = ConnectUnixSocket(SocketPath);
+        if (Socket < 0)
+        {
+            Error = "no decode service at " + SocketPath;
+            return false;
+        }
+        RESOURCE_ACQUIRE("SharedFrames.Client", Handle);
+
+        // The first session of a stream waits for the decoder to open.
+        std::string Reply;
+        if (!RequestOverSocket(Socket, FormatAttachRequest(Path, Width, Height), Reply, AttachTimeoutMs))
+        {
+            Error = "no reply from the decode service";
+            Detach();
+            return false;
+        }
+        FControlResponse Response = ParseControlResponse(Reply);
+        std::string_view Name;
+        std::string_view Size;
+        SplitControlWord(Response.Text, Name, Size);
+        if (!Response.bOk || !Memory.Open(std::string(Name)) || !Reader.Attach(Memory.GetData(), Memory.GetSize()))
+        {
+            Error = Response.bOk ? "cannot map " + std::string(Name) : Response.Text;
+            Detach();
+            return false;
+        }
+        Info = Reader.GetInfo();
+        return true;
+    }
+
+    /** Still reading from the service (rather than a local fallback, or nothing). */
+    bool IsShared() const { return Socket >= 0; }
+    bool HasFallenBack() const { return Fallback != nullptr; }
+    const FSharedFrameReader& GetReader() const { return Reader; }
+
+    const FVideoInfo& GetInfo() const override { return Fallback ? Fallback->GetInfo() : Info; }
+
+    bool ReadFrame(FFrame& Out) override
+    {
+        if (Fallback) return Fallback->ReadFrame(Out);
+        if (Socket < 0) return false;
+
+        int64_t FrameMs = Info.FrameDuration100ns() / 10000;
+        int64_t TimeoutMs = StallTimeoutMs > FrameMs * 4 ? StallTimeoutMs : FrameMs * 4;
+        auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TimeoutMs);
+        for (;;)
+        {
+            if (!DrainDoorbells()) break;
+            ESharedReadResult Result = Reader.Read(Out);
+            if (Result == ESharedReadResult::Frame) return true;
+            if (Result == ESharedReadResult::Closed) break;
+
+            auto Remaining = std::chrono::duration_cast<std::chrono::milliseconds>(Deadline - std::chrono::steady_clock::now());
+            pollfd Poll = { Socket, POLLIN, 0 };
+            if (Remaining.count() <= 0 || poll(&Poll, 1, static_cast<int>(Remaining.count())) <= 0) break;
+        }
+
+        Detach();
+        if (OpenFallback) Fallback = OpenFallback();
+        return Fallback && Fallback->ReadFrame(Out);
+    }
+
+    bool Seek(int64_t Position100ns) override
+    {
+        if (Fallback) return Fallback->Seek(Position100ns);
+        return Socket >= 0;
+    }
+
+    int64_t GetCacheBytes() const override { return Fallback ? Fallback->GetCacheBytes() : 0; }
+
+    void SetCacheLevel(int32_t Level) override
+    {
+        if (Fallback) Fallback->SetCacheLevel(Level);
+    }
+
+private:
+    /** The service may take a while to open a file nobody has attached to yet. */
+    static constexpr int32_t AttachTimeoutMs = 10000;
+
+    /** False once the service closed the connection. */
+    bool DrainDoorbells()
+    {
+        char Buffer[256];
+        for (;;)
+        {
+            ssize_t Read = recv(Socket, Buffer, sizeof(Buffer), MSG_DONTWAIT);
+            if (Read > 0) continue;
+            return Read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+    }
+
+    void Detach()
+    {
+        Memory.Unmap();
+        if (Socket < 0) return;
+        close(Socket);
+        Socket = -1;
+        RESOURCE_RELEASE("SharedFrames.Client", Handle);
+    }
+
+    FFallbackFactory OpenFallback;
+    int32_t StallTimeoutMs;
+    int Socket = -1;
+    FSharedMemory Memory;
+    FSharedFrameReader Reader;
+    FVideoInfo Info;
+    std::unique_ptr<IVideoSource> Fallback;
+};
@@ -0,0 +1,143 @@
+// FfmpegSource - Video decoding through an ffmpeg child process (POSIX).
+// ffprobe reads the stream's size, rate, duration and transfer curve; ffmpeg then
+// writes raw NV12 frames to a pipe (P010 for HDR10, which the compositor tone
+// maps). Seeks restart the child at the new position. Optionally frames are scaled
+// down to the smallest size that still covers a target, as the decode service does
+// so every session sharing a stream gets frames sized for its desktop.
+// The decoder lives in its own process, so a file that crashes it cannot take the
+// caller down: reads simply fail.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "resource_tracker.h"
+#include "video_source.h"
+
+/** Single-quoted for /bin/sh. */
+inline std::string QuoteShellArgument(const std::string& Text)
+{
+    std::string Quoted = "'";
+    for (char Char : Text) Quoted += Char == '\'' ? std::string("'\\''") : std::string(1, Char);
+    return Quoted + "'";
+}
+
+/** Decodes through an ffmpeg child process writing raw NV12 (or P010) frames to a pipe. */
+class FFfmpegSource final : public IVideoSource
+{
+public:
+    ~FFfmpegSource() override { Close(); }
+
+    /**
+     * CoverWidth x CoverHeight, if given, is the smallest size frames must still cover;
+     * larger videos are scaled down to it with their aspect ratio kept, smaller ones are not scaled up.
+     */
+    bool Open(const std::string& InPath, int32_t CoverWidth = 0, int32_t CoverHeight = 0)
+    {
+        Path = InPath;
+        std::string Probe = "ffprobe -v error -select_streams v:0 -show_entries stream=width,height,r_frame_rate,color_transfer"
+            " -show_entries format=duration -of default=noprint_wrappers=1 " + QuoteShellArgument(Path);
+        FILE* Pipe = popen(Probe.c_str(), "r");
+        if (!Pipe) return false;
+        char Line[256];
+        while (std::fgets(Line, sizeof(Line), Pipe))
+        {
+            unsigned Numerator = 0;
+            unsigned Denominator = 0;
+            double Seconds = 0.0;
+            if (std::strncmp(Line, "color_transfer=smpte2084", 24) == 0) bHdr = true;
+            if (std::sscanf(Line, "width=%d", &Info.Width) == 1) continue;
+            if (std::sscanf(Line, "height=%d", &Info.Height) == 1) continue;
+            if (std::sscanf(Line, "r_frame_rate=%u/%u", &Numerator, &Denominator) == 2 && Numerator && Denominator)
+            {
+                Info.FrameRateNumerator = Numerator;
+                Info.FrameRateDenominator = Denominator;
+            }
+            else if (std::sscanf(Line, "duration=%lf", &Seconds) == 1)
+            {
+                Info.Duration100ns = static_cast<int64_t>(Seconds * 10000000.0);
+            }
+        }
+        pclose(Pipe);
+        if (Info.Width <= 0 || Info.Height <= 0) return false;
+
+        Filter = "crop=";
+        if (CoverWidth > 0 && CoverHeight > 0 && Info.Width > CoverWidth && Info.Height > CoverHeight)
+        {
+            // Scale by the larger of the two ratios, so both sides still cover the target.
+            double Scale = static_cast<double>(CoverWidth) / Info.Width;
+            double ScaleY = static_cast<double>(CoverHeight) / Info.Height;
+            Scale = ScaleY > Scale ? ScaleY : Scale;
+            Info.Width = static_cast<int32_t>(Info.Width * Scale + 0.5);
+            Info.Height = static_cast<int32_t>(Info.Height * Scale + 0.5);
+            Filter = "scale=" + std::to_string(Info.Width) + ":" + std::to_string(Info.Height) + ",crop=";
+        }
+        // Odd sizes are cropped to even ones.
+        Info.Width &= ~1;
+        Info.Height &= ~1;
+        Filter += std::to_string(Info.Width) + ":" + std::to_string(Info.Height) + ":0:0";
+        Info.Format = bHdr ? EPixelFormat::P010 : EPixelFormat::NV12;
+        return Info.Width > 0 && Info.Height > 0 && Start(0);
+    }
+
+    const FVideoInfo& GetInfo() const override { return Info; }
+
+    bool ReadFrame(FFrame& Out) override
+    {
+        if (!Decoder) return false;
+        Out.Allocate(Info.Width, Info.Height, Info.Format);
+        const FFrameView& View = Out.GetView();
+        size_t RowBytes = static_cast<size_t>(Info.Width) * BytesPerPixel(Info.Format);
+        for (int32_t Y = 0; Y < Info.Height; ++Y)
+        {
+            if (std::fread(View.Row(0, Y), 1, RowBytes, Decoder) != RowBytes) return false;
+        }
+        for (int32_t Y = 0; Y < Info.Height / 2; ++Y)
+        {
+            if (std::fread(View.Row(1, Y), 1, RowBytes, Decoder) != RowBytes) return false;
+        }
+        Out.Timestamp100ns = StartTimestamp100ns + static_cast<int64_t>(FramesRead++) * Info.FrameDuration100ns();
+        return true;
+    }
+
+    /** Restarts the decoder at the new position; ffmpeg seeks to the keyframe before it and decodes forward. */
+    bool Seek(int64_t Position100ns) override
+    {
+        Close();
+        return Start(Position100ns < 0 ? 0 : Position100ns);
+    }
+
+private:
+    bool Start(int64_t Position100ns)
+    {
+        char Offset[32];
+        std::snprintf(Offset, sizeof(Offset), "%.3f", Position100ns / 10000000.0);
+        std::string Command = "ffmpeg -v error -nostdin -ss " + std::string(Offset) + " -i " + QuoteShellArgument(Path)
+            + " -an -vf " + Filter + " -f rawvideo -pix_fmt " + (Info.Format == EPixelFormat::P010 ? "p010le" : "nv12") + " -";
+        Decoder = popen(Command.c_str(), "r");
+        if (!Decoder) return false;
+        RESOURCE_ACQUIRE("Ffmpeg.Decoder", Handle);
+        StartTimestamp100ns = Position100ns;
+        FramesRead = 0;
+        return true;
+    }
+
+    void Close()
+    {
+        if (!Decoder) return;
+        pclose(Decoder);
+        Decoder = nullptr;
+        RESOURCE_RELEASE("Ffmpeg.Decoder", Handle);
+    }
+
+    FVideoInfo Info;
+    std::string Path;
+    std::string Filter;
+    bool bHdr = false;
+    FILE* Decoder = nullptr;
+    int64_t StartTimestamp100ns = 0;
+    uint64_t FramesRead = 0;
+};
@@ -0,0 +1,244 @@
+// Frame - Decoded video frame storage and zero-copy views.
+// FFrame owns pixel memory; FFrameView is a non-owning window onto it (plane
+// pointers + strides), so cropping a shared frame per monitor is pointer
+// arithmetic rather than a copy.
+// Portable C++20.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+#include "resource_tracker.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/** Row and plane alignment for owned frames, wide enough for AVX2 loads. */
+constexpr size_t FrameAlignment = 32;
+
+enum class EPixelFormat : uint8_t
+{
+    Unknown,
+    BGRA8,      // 4 bytes per pixel, single plane (GDI/DIB native order)
+    NV12,       // 8-bit Y plane + interleaved half-resolution UV plane
+    P010        // 16-bit (10 significant, MSB-aligned) Y plane + interleaved UV plane
+};
+
+struct FIntRect
+{
+    int32_t Left = 0;
+    int32_t Top = 0;
+    int32_t Right = 0;
+    int32_t Bottom = 0;
+
+    int32_t Width() const { return Right - Left; }
+    int32_t Height() const { return Bottom - Top; }
+    bool IsEmpty() const { return Right <= Left || Bottom <= Top; }
+
+    bool operator==(const FIntRect& Other) const
+    {
+        return Left == Other.Left && Top == Other.Top && Right == Other.Right && Bottom == Other.Bottom;
+    }
+};
+
+inline FIntRect IntersectRect(const FIntRect& A, const FIntRect& B)
+{
+    FIntRect Result;
+    Result.Left = A.Left > B.Left ? A.Left : B.Left;
+    Result.Top = A.Top > B.Top ? A.Top : B.Top;
+    Result.Right = A.Right < B.Right ? A.Right : B.Right;
+    Result.Bottom = A.Bottom < B.Bottom ? A.Bottom : B.Bottom;
+    if (Result.IsEmpty()) return {};
+    return Result;
+}
+
+inline int32_t BytesPerPixel(EPixelFormat Format)
+{
+    switch (Format)
+    {
+    case EPixelFormat::BGRA8: return 4;
+    case EPixelFormat::NV12:  return 1;
+    case EPixelFormat::P010:  return 2;
+    default:                  return 0;
+    }
+}
+
+inline int32_t PlaneCount(EPixelFormat Format)
+{
+    return (Format == EPixelFormat::NV12 || Format == EPixelFormat::P010) ? 2 : 1;
+}
+
+/** Non-owning view of a frame or a sub-rectangle of one. */
+struct FFrameView
+{
+    uint8_t* Planes[2] = {};
+    int32_t Strides[2] = {};
+    int32_t Width = 0;
+    int32_t Height = 0;
+    EPixelFormat Format = EPixelFormat::Unknown;
+
+    bool IsValid() const { return Planes[0] && Width > 0 && Height > 0; }
+
+    uint8_t* Row(int32_t Plane, int32_t Y) const
+    {
+        return Planes[Plane] + static_cast<ptrdiff_t>(Y) * Strides[Plane];
+    }
+
+    /**
+     * Zero-copy sub-view. The rect is clipped to the frame; for 4:2:0 formats it is
+     * widened to even coordinates so the chroma plane stays aligned with luma.
+     */
+    FFrameView Crop(FIntRect Rect) const
+    {
+        Rect = IntersectRect(Rect, FIntRect{ 0, 0, Width, Height });
+        if (PlaneCount(Format) == 2)
+        {
+            Rect.Left &= ~1; Rect.Top &= ~1;
+            Rect.Right = (Rect.Right + 1) & ~1; Rect.Bottom = (Rect.Bottom + 1) & ~1;
+            Rect = IntersectRect(Rect, FIntRect{ 0, 0, Width, Height });
+        }
+
+        FFrameView View;
+        if (Rect.IsEmpty() || !IsValid()) return View;
+
+        int32_t Bpp = BytesPerPixel(Format);
+        View.Format = Format;
+        View.Width = Rect.Width();
+        View.Height = Rect.Height();
+        View.Strides[0] = Strides[0];
+        View.Planes[0] = Planes[0] + static_cast<ptrdiff_t>(Rect.Top) * Strides[0]
+            + static_cast<ptrdiff_t>(Rect.Left) * Bpp;
+        if (PlaneCount(Format) == 2)
+        {
+            View.Strides[1] = Strides[1];
+            View.Planes[1] = Planes[1] + static_cast<ptrdiff_t>(Rect.Top / 2) * Strides[1]
+                + static_cast<ptrdiff_t>(Rect.Left) * Bpp;
+        }
+        return View;
+    }
+};
+
+/** Owning, aligned frame buffer. Move-only. */
+class FFrame
+{
+public:
+    FFrame() = default;
+    FFrame(int32_t InWidth, int32_t InHeight, EPixelFormat InFormat) { Allocate(InWidth, InHeight, InFormat); }
+
+    ~FFrame() { Untrack(); }
+
+    FFrame(FFrame&& Other) noexcept { *this = std::move(Other); }
+    FFrame& operator=(FFrame&& Other) noexcept
+    {
+        if (this == &Other) return *this;
+        Untrack();
+        Storage = std::move(Other.Storage);
+        View = Other.View;
+        SizeBytes = Other.SizeBytes;
+        ResourceTag = Other.ResourceTag;
+        Timestamp100ns = Other.Timestamp100ns;
+        Other.View = {};
+        Other.SizeBytes = 0;
+        return *this;
+    }
+    FFrame(const FFrame&) = delete;
+    FFrame& operator=(const FFrame&) = delete;
+
+    /** Accounts the storage as heap bytes of Subsystem in GResources (static string). */
+    void SetResourceTag(const char* Subsystem)
+    {
+        Untrack();
+        ResourceTag = Subsystem;
+        Track();
+    }
+
+    /** (Re)allocates only when the layout changes; contents are left undefined. */
+    void Allocate(int32_t InWidth, int32_t InHeight, EPixelFormat InFormat)
+    {
+        if (View.Width == InWidth && View.Height == InHeight && View.Format == InFormat && Storage) return;
+
+        int32_t Bpp = BytesPerPixel(InFormat);
+        size_t Stride = AlignUp(static_cast<size_t>(InWidth) * Bpp);
+        size_t LumaBytes = Stride * static_cast<size_t>(InHeight);
+        size_t ChromaBytes = PlaneCount(InFormat) == 2 ? Stride * static_cast<size_t>((InHeight + 1) / 2) : 0;
+
+        Untrack();
+        SizeBytes = LumaBytes + ChromaBytes;
+        Track();
+        Storage.reset(static_cast<uint8_t*>(AlignedAlloc(SizeBytes)));
+
+        View = {};
+        View.Width = InWidth;
+        View.Height = InHeight;
+        View.Format = InFormat;
+        View.Planes[0] = Storage.get();
+        View.Strides[0] = static_cast<int32_t>(Stride);
+        if (ChromaBytes)
+        {
+            View.Planes[1] = Storage.get() + LumaBytes;
+            View.Strides[1] = static_cast<int32_t>(Stride);
+        }
+    }
+
+    void Release()
+    {
+        Untrack();
+        Storage.reset();
+        View = {};
+        SizeBytes = 0;
+    }
+
+    const FFrameView& GetView() const { return View; }
+    int32_t Width() const { return View.Width; }
+    int32_t Height() const { return View.Height; }
+    EPixelFormat Format() const { return View.Format; }
+    size_t GetSizeBytes() const { return SizeBytes; }
+
+    /** Presentation timestamp in 100ns units. */
+    int64_t Timestamp100ns = 0;
+
+private:
+    struct FAlignedDeleter
+    {
+        void operator()(uint8_t* Ptr) const { AlignedFree(Ptr); }
+    };
+
+    void Track() const
+    {
+        if (ResourceTag && SizeBytes) GResources.Acquire(ResourceTag, EResourceKind::HeapBytes, static_cast<int64_t>(SizeBytes));
+    }
+
+    void Untrack() const
+    {
+        if (ResourceTag && SizeBytes) GResources.Release(ResourceTag, EResourceKind::HeapBytes, static_cast<int64_t>(SizeBytes));
+    }
+
+    static size_t AlignUp(size_t Value) { return (Value + FrameAlignment - 1) & ~(FrameAlignment - 1); }
+
+    static void* AlignedAlloc(size_t Bytes)
+    {
+#ifdef _WIN32
+        return _aligned_malloc(Bytes ? Bytes : 1, FrameAlignment);
+#else
+        return std::aligned_alloc(FrameAlignment, AlignUp(Bytes ? Bytes : 1));
+#endif
+    }
+
+    static void AlignedFree(void* Ptr)
+    {
+#ifdef _WIN32
+        _aligned_free(Ptr);
+#else
+        std::free(Ptr);
+#endif
+    }
+
+    std::unique_ptr<uint8_t, FAlignedDeleter> Storage;
+    FFrameView View;
+    size_t SizeBytes = 0;
+    const char* ResourceTag = nullptr;
+};
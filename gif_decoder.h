@@ -0,0 +1,330 @@
+// GifDecoder - GIF87a/GIF89a decoding into full-canvas frames.
+// Handles global and local palettes, graphic control extensions (delay, disposal,
+// transparency), interlaced images and the NETSCAPE2.0 loop count. The skim at
+// open records where each image descriptor starts, so decoding a frame is one
+// LZW pass over its sub-blocks plus a composite of its rectangle.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "animated_image.h"
+
+inline bool IsGifData(const uint8_t* Data, size_t Size)
+{
+    return Size >= 6 && (std::memcmp(Data, "GIF87a", 6) == 0 || std::memcmp(Data, "GIF89a", 6) == 0);
+}
+
+class FGifDecoder final : public IAnimationDecoder
+{
+public:
+    /** Takes the whole file and skims it; false if it is not a GIF or holds no complete frame. */
+    bool Open(std::vector<uint8_t> InData)
+    {
+        Data = std::move(InData);
+        Frames.clear();
+        Info = {};
+        Info.FormatName = "gif";
+        if (!IsGifData(Data.data(), Data.size()) || Data.size() < 13) return false;
+
+        Info.Width = Read16(6);
+        Info.Height = Read16(8);
+        if (!IsAnimationCanvasAllowed(Info.Width, Info.Height)) return false;
+
+        uint8_t Packed = Data[10];
+        size_t Offset = 13;
+        GlobalPaletteSize = 0;
+        if (Packed & 0x80)
+        {
+            GlobalPaletteSize = 2 << (Packed & 7);
+            if (!ReadPalette(Offset, GlobalPaletteSize, GlobalPalette)) return false;
+            Offset += static_cast<size_t>(GlobalPaletteSize) * 3;
+        }
+
+        FGifFrame Pending;
+        while (Offset < Data.size())
+        {
+            uint8_t Introducer = Data[Offset++];
+            if (Introducer == 0x3B) break;
+            if (Introducer == 0x21)
+            {
+                if (Offset >= Data.size()) break;
+                uint8_t Label = Data[Offset++];
+                if (Label == 0xF9 && Offset + 5 < Data.size() && Data[Offset] >= 4)
+                {
+                    Pending.Disposal = static_cast<uint8_t>((Data[Offset + 1] >> 2) & 7);
+                    Pending.DelayMs = Read16(Offset + 2) * 10;
+                    Pending.TransparentIndex = (Data[Offset + 1] & 1) ? Data[Offset + 4] : -1;
+                }
+                else if (Label == 0xFF && Offset + 16 < Data.size() && Data[Offset] == 11
+                    && std::memcmp(&Data[Offset + 1], "NETSCAPE2.0", 11) == 0 && Data[Offset + 12] >= 3)
+                {
+                    Info.LoopCount = Read16(Offset + 14);
+                }
+                Offset = SkipSubBlocks(Offset);
+            }
+            else if (Introducer == 0x2C)
+            {
+                Pending.DescriptorOffset = Offset;
+                if (Offset + 9 > Data.size()) break;
+                uint8_t ImagePacked = Data[Offset + 8];
+                Offset += 9;
+                if (ImagePacked & 0x80) Offset += static_cast<size_t>(2 << (ImagePacked & 7)) * 3;
+                Offset = SkipSubBlocks(Offset + 1); // LZW minimum code size, then data
+                if (Offset > Data.size()) break;
+
+                // A frame's rectangle may overhang the canvas (it is clipped), but not absurdly.
+                size_t Descriptor = Pending.DescriptorOffset;
+                if (Read16(Descriptor + 4) <= MaxAnimationDimension && Read16(Descriptor + 6) <= MaxAnimationDimension)
+                {
+                    Pending.DelayMs = ClampAnimationDelayMs(Pending.DelayMs);
+                    Frames.push_back(Pending);
+                }
+                Pending = {};
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (Frames.empty()) return false;
+
+        Info.FrameCount = static_cast<int32_t>(Frames.size());
+        for (const auto& Frame : Frames)
+        {
+            Info.DelaysMs.push_back(Frame.DelayMs);
+            Info.Duration100ns += static_cast<int64_t>(Frame.DelayMs) * 10000;
+        }
+        Rewind();
+        return true;
+    }
+
+    const FAnimationInfo& GetInfo() const override { return Info; }
+
+    bool DecodeNext(FFrame& Out) override
+    {
+        if (NextFrame >= static_cast<int32_t>(Frames.size())) return false;
+        const FGifFrame& Frame = Frames[NextFrame];
+
+        if (PreviousDisposal == 2) Canvas.ClearRect(PreviousRect);
+        else if (PreviousDisposal == 3) Canvas.Restore();
+
+        size_t Offset = Frame.DescriptorOffset;
+        FIntRect Rect;
+        Rect.Left = Read16(Offset);
+        Rect.Top = Read16(Offset + 2);
+        Rect.Right = Rect.Left + Read16(Offset + 4);
+        Rect.Bottom = Rect.Top + Read16(Offset + 6);
+        uint8_t Packed = Data[Offset + 8];
+        Offset += 9;
+
+        const uint32_t* Palette = GlobalPalette;
+        int32_t PaletteSize = GlobalPaletteSize;
+        if (Packed & 0x80)
+        {
+            PaletteSize = 2 << (Packed & 7);
+            ReadPalette(Offset, PaletteSize, LocalPalette);
+            Palette = LocalPalette;
+            Offset += static_cast<size_t>(PaletteSize) * 3;
+        }
+
+        // Restore-previous on the first frame has nothing to restore; encoders expect it to keep.
+        if (Frame.Disposal == 3 && NextFrame > 0) Canvas.Save();
+
+        int32_t FrameWidth = Rect.Width();
+        int32_t FrameHeight = Rect.Height();
+        Indices.assign(static_cast<size_t>(FrameWidth) * FrameHeight, 0);
+        size_t Decoded = DecodeLzw(Offset, Indices.data(), Indices.size());
+        // A truncated final frame keeps whatever decoded; missing pixels leave the canvas as is.
+        int32_t Transparent = Frame.TransparentIndex;
+        if (Decoded < Indices.size() && Transparent >= 0)
+        {
+            std::fill(Indices.begin() + static_cast<ptrdiff_t>(Decoded), Indices.end(), static_cast<uint8_t>(Transparent));
+        }
+
+        bool bInterlaced = (Packed & 0x40) != 0;
+        int32_t Pass = 0;
+        int32_t Row = 0;
+        for (int32_t SourceRow = 0; SourceRow < FrameHeight; ++SourceRow)
+        {
+            int32_t Y = bInterlaced ? Row : SourceRow;
+            if (bInterlaced)
+            {
+                static constexpr int32_t PassStep[4] = { 8, 8, 4, 2 };
+                static constexpr int32_t PassStart[4] = { 4, 2, 1, 0 };
+                Row += PassStep[Pass];
+                while (Row >= FrameHeight && Pass < 3) Row = PassStart[Pass++];
+            }
+
+            int32_t CanvasY = Rect.Top + Y;
+            if (CanvasY < 0 || CanvasY >= Canvas.GetHeight()) continue;
+            const uint8_t* Source = &Indices[static_cast<size_t>(SourceRow) * FrameWidth];
+            uint32_t* Dest = Canvas.Row(CanvasY);
+            int32_t Right = Rect.Right < Canvas.GetWidth() ? Rect.Right : Canvas.GetWidth();
+            for (int32_t X = Rect.Left; X < Right; ++X)
+            {
+                uint8_t Index = Source[X - Rect.Left];
+                if (Index == Transparent || Index >= PaletteSize) continue;
+                Dest[X] = Palette[Index];
+            }
+        }
+
+        PreviousDisposal = Frame.Disposal;
+        PreviousRect = Rect;
+        ++NextFrame;
+        Canvas.Flatten(Out);
+        return true;
+    }
+
+    void Rewind() override
+    {
+        Canvas.Reset(Info.Width, Info.Height);
+        NextFrame = 0;
+        PreviousDisposal = 0;
+        PreviousRect = {};
+    }
+
+    int32_t GetNextFrameIndex() const override { return NextFrame; }
+
+private:
+    struct FGifFrame
+    {
+        size_t DescriptorOffset = 0;
+        int32_t DelayMs = 0;
+        int32_t TransparentIndex = -1;
+        uint8_t Disposal = 0;          // 0/1 keep, 2 clear to background, 3 restore previous
+    };
+
+    int32_t Read16(size_t Offset) const { return Data[Offset] | (Data[Offset + 1] << 8); }
+
+    bool ReadPalette(size_t Offset, int32_t Count, uint32_t* Palette) const
+    {
+        if (Offset + static_cast<size_t>(Count) * 3 > Data.size()) return false;
+        for (int32_t Index = 0; Index < Count; ++Index)
+        {
+            const uint8_t* Rgb = &Data[Offset + static_cast<size_t>(Index) * 3];
+            Palette[Index] = 0xFF000000u | (Rgb[0] << 16) | (Rgb[1] << 8) | Rgb[2];
+        }
+        return true;
+    }
+
+    /** Offset just past the block terminator; past the end of the data if truncated. */
+    size_t SkipSubBlocks(size_t Offset) const
+    {
+        while (Offset < Data.size())
+        {
+            uint8_t Length = Data[Offset++];
+            if (!Length) return Offset;
+            Offset += Length;
+        }
+        return Data.size() + 1;
+    }
+
+    /** Variable-width LZW over the sub-blocks at Offset (code size byte first); returns indices written. */
+    size_t DecodeLzw(size_t Offset, uint8_t* Out, size_t OutSize)
+    {
+        if (Offset >= Data.size()) return 0;
+        int32_t MinCodeSize = Data[Offset++];
+        if (MinCodeSize < 2 || MinCodeSize > 11) return 0;
+
+        const int32_t ClearCode = 1 << MinCodeSize;
+        const int32_t EndCode = ClearCode + 1;
+        int32_t CodeSize = MinCodeSize + 1;
+        int32_t NextCode = EndCode + 1;
+        int32_t Previous = -1;
+        uint8_t First = 0;
+        for (int32_t Code = 0; Code < ClearCode; ++Code)
+        {
+            Prefix[Code] = 0;
+            Suffix[Code] = static_cast<uint8_t>(Code);
+        }
+
+        size_t Written = 0;
+        uint32_t BitBuffer = 0;
+        int32_t BitCount = 0;
+        size_t BlockLeft = 0;
+        while (Written < OutSize)
+        {
+            while (BitCount < CodeSize)
+            {
+                if (!BlockLeft)
+                {
+                    if (Offset >= Data.size() || !Data[Offset]) return Written;
+                    BlockLeft = Data[Offset++];
+                }
+                if (Offset >= Data.size()) return Written;
+                BitBuffer |= static_cast<uint32_t>(Data[Offset++]) << BitCount;
+                BitCount += 8;
+                --BlockLeft;
+            }
+            int32_t Code = static_cast<int32_t>(BitBuffer & ((1u << CodeSize) - 1));
+            BitBuffer >>= CodeSize;
+            BitCount -= CodeSize;
+
+            if (Code == ClearCode)
+            {
+                CodeSize = MinCodeSize + 1;
+                NextCode = EndCode + 1;
+                Previous = -1;
+                continue;
+            }
+            if (Code == EndCode) break;
+            if (Previous < 0)
+            {
+                if (Code > ClearCode) return Written;
+                Out[Written++] = static_cast<uint8_t>(Code);
+                Previous = Code;
+                First = static_cast<uint8_t>(Code);
+                continue;
+            }
+            if (Code > NextCode) return Written;
+
+            int32_t Incoming = Code;
+            int32_t Depth = 0;
+            if (Code == NextCode)
+            {
+                Stack[Depth++] = First;
+                Code = Previous;
+            }
+            while (Code >= ClearCode)
+            {
+                Stack[Depth++] = Suffix[Code];
+                Code = Prefix[Code];
+            }
+            First = static_cast<uint8_t>(Code);
+            Stack[Depth++] = First;
+
+            if (NextCode < 4096)
+            {
+                Prefix[NextCode] = static_cast<uint16_t>(Previous);
+                Suffix[NextCode] = First;
+                ++NextCode;
+                if (NextCode == (1 << CodeSize) && CodeSize < 12) ++CodeSize;
+            }
+            Previous = Incoming;
+
+            while (Depth && Written < OutSize) Out[Written++] = Stack[--Depth];
+        }
+        return Written;
+    }
+
+    std::vector<uint8_t> Data;
+    std::vector<FGifFrame> Frames;
+    FAnimationInfo Info;
+    FAnimationCanvas Canvas;
+    std::vector<uint8_t> Indices;
+    uint32_t GlobalPalette[256] = {};
+    uint32_t LocalPalette[256] = {};
+    int32_t GlobalPaletteSize = 0;
+    int32_t NextFrame = 0;
+    uint8_t PreviousDisposal = 0;
+    FIntRect PreviousRect;
+
+    uint16_t Prefix[4096] = {};
+    uint8_t Suffix[4096] = {};
+    uint8_t Stack[4097] = {};
+};
@@ -0,0 +1,351 @@
+// Inflate - DEFLATE (RFC 1951) and zlib (RFC 1950) decompression.
+// Just enough zlib for PNG image data: stored, fixed-Huffman and dynamic-Huffman
+// blocks. Codes up to FastBits long resolve with one table lookup; longer ones
+// walk the canonical code counts bit by bit. The zlib checksum is not verified;
+// a corrupt stream fails on its structure or yields fewer bytes than expected.
+// The caller bounds the output, so a small stream cannot expand into gigabytes.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum class EInflateResult : uint8_t
+{
+    Done,
+    Corrupt,    // Malformed or truncated stream
+    TooLarge    // Decodes to more than the caller's limit
+};
+
+namespace InflateDetail
+{
+    constexpr int32_t MaxCodeBits = 15;
+    constexpr int32_t FastBits = 10;
+
+    /**
+     * Canonical Huffman decoding table: code counts per length and symbols in code
+     * order, plus a direct lookup on the next FastBits stream bits (symbol << 4 | length,
+     * 0 when the code is longer).
+     */
+    struct FHuffman
+    {
+        uint16_t Counts[MaxCodeBits + 1] = {};
+        uint16_t Symbols[288] = {};
+        uint16_t Fast[1 << FastBits] = {};
+
+        /** False on an over-subscribed code set. */
+        bool Build(const uint8_t* Lengths, int32_t Count)
+        {
+            for (auto& Entry : Counts) Entry = 0;
+            for (int32_t Symbol = 0; Symbol < Count; ++Symbol) ++Counts[Lengths[Symbol]];
+            Counts[0] = 0;
+
+            int32_t Left = 1;
+            for (int32_t Length = 1; Length <= MaxCodeBits; ++Length)
+            {
+                Left = (Left << 1) - Counts[Length];
+                if (Left < 0) return false;
+            }
+
+            uint16_t Offsets[MaxCodeBits + 1] = {};
+            for (int32_t Length = 1; Length < MaxCodeBits; ++Length) Offsets[Length + 1] = Offsets[Length] + Counts[Length];
+            for (int32_t Symbol = 0; Symbol < Count; ++Symbol)
+            {
+                if (Lengths[Symbol]) Symbols[Offsets[Lengths[Symbol]]++] = static_cast<uint16_t>(Symbol);
+            }
+
+            // Codes go into the stream most significant bit first, so the lookup index is bit-reversed.
+            for (auto& Entry : Fast) Entry = 0;
+            int32_t Code = 0;
+            int32_t Index = 0;
+            for (int32_t Length = 1; Length <= FastBits; ++Length)
+            {
+                for (int32_t Rank = 0; Rank < Counts[Length]; ++Rank, ++Code, ++Index)
+                {
+                    int32_t Reversed = 0;
+                    for (int32_t Bit = 0; Bit < Length; ++Bit) Reversed |= ((Code >> Bit) & 1) << (Length - 1 - Bit);
+                    uint16_t Entry = static_cast<uint16_t>((Symbols[Index] << 4) | Length);
+                    for (int32_t Fill = Reversed; Fill < (1 << FastBits); Fill += 1 << Length) Fast[Fill] = Entry;
+                }
+                Code <<= 1;
+            }
+            return true;
+        }
+    };
+
+    class FBitReader
+    {
+    public:
+        FBitReader(const uint8_t* InData, size_t InSize) : Data(InData), Size(InSize) {}
+
+        /** Reads Count bits LSB-first; past the end reads zeros, which HasOverrun reports. */
+        uint32_t Bits(int32_t Count)
+        {
+            Refill();
+            uint32_t Value = static_cast<uint32_t>(BitBuffer & ((1u << Count) - 1));
+            BitBuffer >>= Count;
+            BitCount -= Count;
+            return Value;
+        }
+
+        /** Decodes one symbol; -1 on an invalid code. */
+        int32_t Decode(const FHuffman& Table)
+        {
+            Refill();
+            uint16_t Entry = Table.Fast[BitBuffer & ((1u << FastBits) - 1)];
+            if (Entry)
+            {
+                BitBuffer >>= Entry & 15;
+                BitCount -= Entry & 15;
+                return Entry >> 4;
+            }
+
+            int32_t Code = 0;
+            int32_t First = 0;
+            int32_t Index = 0;
+            for (int32_t Length = 1; Length <= MaxCodeBits; ++Length)
+            {
+                Code |= static_cast<int32_t>(Bits(1));
+                int32_t Count = Table.Counts[Length];
+                if (Code - Count < First) return Table.Symbols[Index + (Code - First)];
+                Index += Count;
+                First = (First + Count) << 1;
+                Code <<= 1;
+            }
+            return -1;
+        }
+
+        /** Drops the partial byte; whole bytes already buffered are given back to the input. */
+        void AlignToByte()
+        {
+            Position -= static_cast<size_t>(BitCount / 8);
+            BitBuffer = 0;
+            BitCount = 0;
+        }
+
+        size_t GetPosition() const { return Position; }
+        void Skip(size_t Bytes) { Position += Bytes; }
+
+        /** True once bits past the end of the input have been consumed. */
+        bool HasOverrun() const { return Position * 8 - static_cast<size_t>(BitCount) > Size * 8; }
+
+    private:
+        /** Keeps more than 56 bits buffered: enough for any code plus its extra bits. */
+        void Refill()
+        {
+            while (BitCount <= 56)
+            {
+                uint64_t Byte = Position < Size ? Data[Position] : 0;
+                ++Position;
+                BitBuffer |= Byte << BitCount;
+                BitCount += 8;
+            }
+        }
+
+        const uint8_t* Data;
+        size_t Size;
+        size_t Position = 0;
+        uint64_t BitBuffer = 0;
+        int32_t BitCount = 0;
+    };
+
+    constexpr uint16_t LengthBase[29] =
+    {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    constexpr uint8_t LengthExtra[29] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    constexpr uint16_t DistanceBase[30] =
+    {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+        1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    constexpr uint8_t DistanceExtra[30] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    /**
+     * Makes room for at least Bytes more after Written, doubling so appends stay amortized;
+     * growth stops at Limit, past which nothing is written.
+     */
+    inline void Reserve(std::vector<uint8_t>& Out, size_t Written, size_t Bytes, size_t Limit)
+    {
+        if (Out.size() - Written >= Bytes) return;
+        size_t Grown = Out.size() * 2 > 65536 ? Out.size() * 2 : 65536;
+        if (Grown > Limit) Grown = Limit;
+        Out.resize(Grown > Written + Bytes ? Grown : Written + Bytes);
+    }
+
+    /** Decodes one Huffman block; Out is written through the Written cursor and may have slack past it. */
+    inline EInflateResult InflateCodes(FBitReader& Reader, const FHuffman& Literals, const FHuffman& Distances,
+        std::vector<uint8_t>& Out, size_t& Written, size_t Limit)
+    {
+        for (;;)
+        {
+            Reserve(Out, Written, 258, Limit);
+
+            int32_t Symbol = Reader.Decode(Literals);
+            if (Symbol < 0 || Reader.HasOverrun()) return EInflateResult::Corrupt;
+            if (Symbol < 256)
+            {
+                if (Written == Limit) return EInflateResult::TooLarge;
+                Out[Written++] = static_cast<uint8_t>(Symbol);
+                continue;
+            }
+            if (Symbol == 256) return EInflateResult::Done;
+
+            Symbol -= 257;
+            if (Symbol >= 29) return EInflateResult::Corrupt;
+            size_t Length = LengthBase[Symbol] + Reader.Bits(LengthExtra[Symbol]);
+            int32_t DistanceSymbol = Reader.Decode(Distances);
+            if (DistanceSymbol < 0 || DistanceSymbol >= 30) return EInflateResult::Corrupt;
+            size_t Distance = DistanceBase[DistanceSymbol] + Reader.Bits(DistanceExtra[DistanceSymbol]);
+            if (Distance > Written) return EInflateResult::Corrupt;
+            if (Length > Limit - Written) return EInflateResult::TooLarge;
+
+            // Byte by byte: a match may overlap the bytes it produces.
+            uint8_t* Dest = &Out[Written];
+            const uint8_t* From = Dest - Distance;
+            for (size_t Index = 0; Index < Length; ++Index) Dest[Index] = From[Index];
+            Written += Length;
+        }
+    }
+
+    inline bool InflateDynamicTables(FBitReader& Reader, FHuffman& Literals, FHuffman& Distances)
+    {
+        constexpr uint8_t CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        int32_t LiteralCount = static_cast<int32_t>(Reader.Bits(5)) + 257;
+        int32_t DistanceCount = static_cast<int32_t>(Reader.Bits(5)) + 1;
+        int32_t CodeLengthCount = static_cast<int32_t>(Reader.Bits(4)) + 4;
+        if (LiteralCount > 286 || DistanceCount > 30) return false;
+
+        uint8_t Lengths[286 + 30] = {};
+        for (int32_t Index = 0; Index < CodeLengthCount; ++Index) Lengths[CodeLengthOrder[Index]] = static_cast<uint8_t>(Reader.Bits(3));
+        FHuffman CodeLengths;
+        if (!CodeLengths.Build(Lengths, 19)) return false;
+
+        int32_t Index = 0;
+        uint8_t Code[286 + 30] = {};
+        while (Index < LiteralCount + DistanceCount)
+        {
+            int32_t Symbol = Reader.Decode(CodeLengths);
+            if (Symbol < 0 || Reader.HasOverrun()) return false;
+            if (Symbol < 16)
+            {
+                Code[Index++] = static_cast<uint8_t>(Symbol);
+                continue;
+            }
+            uint8_t Repeated = 0;
+            int32_t Repeat = 0;
+            if (Symbol == 16)
+            {
+                if (!Index) return false;
+                Repeated = Code[Index - 1];
+                Repeat = 3 + static_cast<int32_t>(Reader.Bits(2));
+            }
+            else if (Symbol == 17) Repeat = 3 + static_cast<int32_t>(Reader.Bits(3));
+            else Repeat = 11 + static_cast<int32_t>(Reader.Bits(7));
+            if (Index + Repeat > LiteralCount + DistanceCount) return false;
+            while (Repeat--) Code[Index++] = Repeated;
+        }
+        if (!Code[256]) return false; // No end-of-block code
+        return Literals.Build(Code, LiteralCount) && Distances.Build(Code + LiteralCount, DistanceCount);
+    }
+}
+
+/**
+ * Appends the decompressed DEFLATE stream to Out, stopping before Out would hold more
+ * than MaxSize bytes. On a malformed or truncated stream, or one that would pass
+ * MaxSize, Out still holds everything decoded before the damage or the limit.
+ */
+inline EInflateResult InflateRaw(const uint8_t* Data, size_t Size, std::vector<uint8_t>& Out, size_t MaxSize = SIZE_MAX)
+{
+    using namespace InflateDetail;
+    FBitReader Reader(Data, Size);
+    size_t Written = Out.size();
+    bool bLast = false;
+    EInflateResult Result = Written > MaxSize ? EInflateResult::TooLarge : EInflateResult::Done;
+    while (Result == EInflateResult::Done && !bLast)
+    {
+        bLast = Reader.Bits(1) != 0;
+        uint32_t Type = Reader.Bits(2);
+        if (Type == 0)
+        {
+            Reader.AlignToByte();
+            size_t Position = Reader.GetPosition();
+            if (Position + 4 > Size)
+            {
+                Result = EInflateResult::Corrupt;
+                break;
+            }
+            size_t Length = Data[Position] | (Data[Position + 1] << 8);
+            size_t Complement = Data[Position + 2] | (Data[Position + 3] << 8);
+            if ((Length ^ 0xFFFF) != Complement || Position + 4 + Length > Size)
+            {
+                Result = EInflateResult::Corrupt;
+                break;
+            }
+            if (Length > MaxSize - Written)
+            {
+                Result = EInflateResult::TooLarge;
+                break;
+            }
+            Reserve(Out, Written, Length, MaxSize);
+            std::memcpy(&Out[Written], Data + Position + 4, Length);
+            Written += Length;
+            Reader.Skip(4 + Length);
+        }
+        else if (Type == 1)
+        {
+            static const FHuffman FixedLiterals = []
+            {
+                uint8_t Lengths[288];
+                for (int32_t Symbol = 0; Symbol < 288; ++Symbol)
+                {
+                    Lengths[Symbol] = Symbol < 144 ? 8 : Symbol < 256 ? 9 : Symbol < 280 ? 7 : 8;
+                }
+                FHuffman Table;
+                Table.Build(Lengths, 288);
+                return Table;
+            }();
+            static const FHuffman FixedDistances = []
+            {
+                uint8_t Lengths[30];
+                for (auto& Length : Lengths) Length = 5;
+                FHuffman Table;
+                Table.Build(Lengths, 30);
+                return Table;
+            }();
+            Result = InflateCodes(Reader, FixedLiterals, FixedDistances, Out, Written, MaxSize);
+        }
+        else if (Type == 2)
+        {
+            FHuffman Literals;
+            FHuffman Distances;
+            Result = InflateDynamicTables(Reader, Literals, Distances)
+                ? InflateCodes(Reader, Literals, Distances, Out, Written, MaxSize)
+                : EInflateResult::Corrupt;
+        }
+        else
+        {
+            Result = EInflateResult::Corrupt;
+        }
+        if (Result == EInflateResult::Done && Reader.HasOverrun()) Result = EInflateResult::Corrupt;
+    }
+    Out.resize(Written);
+    return Result;
+}
+
+/** zlib wrapper: checks the header (deflate, no preset dictionary) and inflates the body. */
+inline EInflateResult InflateZlib(const uint8_t* Data, size_t Size, std::vector<uint8_t>& Out, size_t MaxSize = SIZE_MAX)
+{
+    if (Size < 2) return EInflateResult::Corrupt;
+    if ((Data[0] & 0x0F) != 8 || ((Data[0] << 8) | Data[1]) % 31 != 0 || (Data[1] & 0x20)) return EInflateResult::Corrupt;
+    return InflateRaw(Data + 2, Size - 2, Out, MaxSize);
+}
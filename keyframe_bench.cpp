@@ -0,0 +1,259 @@
+// keyframe_bench - Low-power frame selection checks on synthetic GOP structures.
+// Builds sample tables for fixed, short, long, variable (scene-cut) and open GOPs,
+// with and without B-frames in decode order, and checks the schedules Select()
+// makes: keyframe mode shows only sync samples, every-Nth mode never goes deeper
+// than MaxDecodeDepth, shown frames are ascending and at least MinInterval apart,
+// each step's decode cost is its distance from the previous keyframe, samples
+// before the first keyframe are never chosen, and FindStep() maps media times to
+// the step on screen. Then times Build and Select on a --minutes long table at
+// --fps and prints the decodes per second of low-power playback against full playback.
+//   g++ -std=c++20 -O2 -pthread keyframe_bench.cpp -o keyframe_bench
+//   keyframe_bench [--minutes N] [--fps N] [--gop N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "keyframe_index.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    struct FBenchOptions
+    {
+        int32_t Minutes = 120;
+        int32_t Fps = 60;
+        int32_t Gop = 120;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--minutes") Options.Minutes = std::atoi(Value);
+            else if (Name == "--fps") Options.Fps = std::atoi(Value);
+            else if (Name == "--gop") Options.Gop = std::atoi(Value);
+            else return false;
+        }
+        return Options.Minutes > 0 && Options.Fps > 0 && Options.Gop > 0;
+    }
+
+    /** I/P-only samples of Count frames at Fps with a keyframe every Gop (0: none), the first at Leading. */
+    std::vector<FSampleEntry> MakeGops(int32_t Count, int32_t Fps, int32_t Gop, int32_t Leading = 0)
+    {
+        std::vector<FSampleEntry> Samples;
+        for (int32_t Index = 0; Index < Count; ++Index)
+        {
+            FSampleEntry Sample;
+            Sample.Timestamp100ns = static_cast<int64_t>(Index) * 10000000 / Fps;
+            Sample.bSync = Gop > 0 && Index >= Leading && (Index - Leading) % Gop == 0;
+            Samples.push_back(Sample);
+        }
+        return Samples;
+    }
+
+    /** Reorders an IBBP... presentation-order table into decode order: each P before the Bs it anchors. */
+    std::vector<FSampleEntry> ToDecodeOrder(const std::vector<FSampleEntry>& Presentation, int32_t BFrames)
+    {
+        std::vector<FSampleEntry> Decode;
+        size_t Index = 0;
+        while (Index < Presentation.size())
+        {
+            if (Presentation[Index].bSync) { Decode.push_back(Presentation[Index++]); continue; }
+            size_t Anchor = Index + static_cast<size_t>(BFrames);
+            while (Anchor >= Presentation.size() || (Anchor > Index && Presentation[Anchor].bSync)) --Anchor;
+            Decode.push_back(Presentation[Anchor]);
+            for (size_t B = Index; B < Anchor; ++B) Decode.push_back(Presentation[B]);
+            Index = Anchor + 1;
+        }
+        return Decode;
+    }
+
+    /** Properties every schedule must have, checked against a brute-force walk of the presentation-order table. */
+    bool CheckSchedule(const std::vector<FSampleEntry>& Presentation, const std::vector<FSubsampleStep>& Steps,
+        const FSubsampleSettings& Settings, const char* What)
+    {
+        bool bOk = !Steps.empty();
+        size_t Cursor = 0;
+        for (size_t Step = 0; Step < Steps.size() && bOk; ++Step)
+        {
+            if (Step) bOk &= Steps[Step].Timestamp100ns - Steps[Step - 1].Timestamp100ns >= Settings.MinInterval100ns;
+            while (Cursor < Presentation.size() && Presentation[Cursor].Timestamp100ns != Steps[Step].Timestamp100ns) ++Cursor;
+            if (Cursor == Presentation.size()) { bOk = false; break; }
+
+            int32_t Depth = 0;
+            for (size_t Back = Cursor + 1; Back-- > 0;)
+            {
+                ++Depth;
+                if (Presentation[Back].bSync) break;
+                if (!Back) Depth = 0;
+            }
+            bOk &= Depth > 0 && Steps[Step].DecodeCost == Depth;
+            if (Settings.Mode == ESubsampleMode::Keyframes) bOk &= Presentation[Cursor].bSync;
+            else bOk &= Depth <= Settings.MaxDecodeDepth || Presentation[Cursor].bSync;
+        }
+        if (!bOk) std::printf("  %s: %zu step(s)\n", What, Steps.size());
+        return Check(bOk, What);
+    }
+
+    bool CheckFixedGops()
+    {
+        bool bPass = true;
+        FKeyframeIndex Index;
+        FSubsampleSettings Keyframes;
+        std::vector<FSampleEntry> Samples = MakeGops(30 * 60, 30, 30);
+        Index.Build(Samples);
+        std::vector<FSubsampleStep> Steps = Index.Select(Keyframes);
+        bPass &= Check(Index.GetSyncCount() == 60 && Index.GetAverageGopLength() == 30.0, "one-second GOPs counted");
+        bPass &= Check(Steps.size() == 60, "every one-second keyframe shown at 2 fps");
+        bPass &= CheckSchedule(Samples, Steps, Keyframes, "one-second GOPs, keyframes");
+
+        // Keyframes every third of a second: the interval drops some of them.
+        Samples = MakeGops(30 * 60, 30, 10);
+        Index.Build(Samples);
+        Steps = Index.Select(Keyframes);
+        bPass &= Check(Steps.size() == 90, "short GOPs thinned to the interval");
+        bPass &= CheckSchedule(Samples, Steps, Keyframes, "short GOPs, keyframes");
+
+        // Ten-second GOPs: every-Nth fills in between keyframes without decoding deep.
+        Samples = MakeGops(30 * 60, 30, 300);
+        Index.Build(Samples);
+        FSubsampleSettings EveryNth;
+        EveryNth.Mode = ESubsampleMode::EveryNth;
+        EveryNth.Nth = 3;
+        EveryNth.MaxDecodeDepth = 8;
+        EveryNth.MinInterval100ns = 2000000;
+        Steps = Index.Select(EveryNth);
+        bPass &= Check(Steps.size() == 12, "long GOPs: keyframes and shallow frames only");
+        bPass &= CheckSchedule(Samples, Steps, EveryNth, "long GOPs, every third");
+        EveryNth.MaxDecodeDepth = 300;
+        EveryNth.MinInterval100ns = 5000000;
+        bPass &= Check(Index.Select(EveryNth).size() == 120, "a deep limit fills every interval");
+        return bPass;
+    }
+
+    bool CheckVariableGops()
+    {
+        bool bPass = true;
+        std::mt19937 Random(17);
+        for (int32_t Trial = 0; Trial < 50; ++Trial)
+        {
+            // Scene cuts at random, plus a forced keyframe every 250 frames.
+            std::vector<FSampleEntry> Samples = MakeGops(3000, 25, 250, static_cast<int32_t>(Random() % 5));
+            for (auto& Sample : Samples) Sample.bSync = Sample.bSync || Random() % 60 == 0;
+            std::vector<FSampleEntry> Decode = ToDecodeOrder(Samples, static_cast<int32_t>(Random() % 4));
+
+            FKeyframeIndex Index;
+            Index.Build(Decode);
+            FSubsampleSettings Settings;
+            Settings.MinInterval100ns = 2000000 + static_cast<int64_t>(Random() % 10) * 1000000;
+            bPass &= CheckSchedule(Samples, Index.Select(Settings), Settings, "variable GOPs, keyframes");
+            Settings.Mode = ESubsampleMode::EveryNth;
+            Settings.Nth = 1 + static_cast<int32_t>(Random() % 6);
+            Settings.MaxDecodeDepth = 1 + static_cast<int32_t>(Random() % 12);
+            bPass &= CheckSchedule(Samples, Index.Select(Settings), Settings, "variable GOPs, every Nth");
+            if (!bPass) break;
+        }
+        return bPass;
+    }
+
+    bool CheckEdges()
+    {
+        bool bPass = true;
+        FKeyframeIndex Index;
+        FSubsampleSettings EveryNth;
+        EveryNth.Mode = ESubsampleMode::EveryNth;
+        EveryNth.MinInterval100ns = 0;
+
+        // An open GOP: the first frames reference a keyframe that is not in the file.
+        std::vector<FSampleEntry> Samples = MakeGops(100, 30, 30, 7);
+        Index.Build(Samples);
+        std::vector<FSubsampleStep> Steps = Index.Select(EveryNth);
+        bPass &= Check(!Steps.empty() && Steps.front().Timestamp100ns == Samples[7].Timestamp100ns && Steps.front().DecodeCost == 1,
+            "samples before the first keyframe are never shown");
+
+        Index.Build(MakeGops(100, 30, 0));
+        bPass &= Check(Index.Select(FSubsampleSettings{}).empty() && Index.GetAverageGopLength() == 0.0, "no keyframes, no schedule");
+        Index.Build({});
+        bPass &= Check(Index.Select(EveryNth).empty(), "empty table, no schedule");
+
+        // B-frames in decode order come out in presentation order.
+        Samples = MakeGops(90, 30, 15);
+        Index.Build(ToDecodeOrder(Samples, 2));
+        std::vector<int64_t> Sync = Index.GetSyncTimestamps();
+        bool bAscending = Sync.size() == 6;
+        for (size_t Key = 1; Key < Sync.size(); ++Key) bAscending &= Sync[Key] > Sync[Key - 1];
+        bPass &= Check(bAscending, "sync timestamps ascending after reordering");
+
+        std::vector<FSubsampleStep> Fixed = { { 0, 1 }, { 5000000, 1 }, { 10000000, 1 } };
+        bPass &= Check(FKeyframeIndex::FindStep(Fixed, -1) == 0, "before the first step");
+        bPass &= Check(FKeyframeIndex::FindStep(Fixed, 5000000) == 1, "exactly on a step");
+        bPass &= Check(FKeyframeIndex::FindStep(Fixed, 9999999) == 1, "between steps");
+        bPass &= Check(FKeyframeIndex::FindStep(Fixed, 99999999) == 2, "after the last step");
+        return bPass;
+    }
+
+    void RunBenchmark(const FBenchOptions& Options)
+    {
+        int32_t Count = Options.Minutes * 60 * Options.Fps;
+        std::vector<FSampleEntry> Samples = ToDecodeOrder(MakeGops(Count, Options.Fps, Options.Gop), 2);
+
+        FKeyframeIndex Index;
+        auto Start = std::chrono::steady_clock::now();
+        Index.Build(Samples);
+        double BuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+        std::printf("%d samples, GOP %d: build %.2f ms\n", Count, Options.Gop, BuildMs);
+
+        double Seconds = static_cast<double>(Count) / Options.Fps;
+        auto Report = [&](const char* Name, const FSubsampleSettings& Settings)
+        {
+            auto SelectStart = std::chrono::steady_clock::now();
+            std::vector<FSubsampleStep> Steps = Index.Select(Settings);
+            double SelectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - SelectStart).count();
+            int64_t Decodes = 0;
+            for (const auto& Step : Steps) Decodes += Step.DecodeCost;
+            std::printf("  %-20s select %6.2f ms, %6.2f frames/s shown, %6.2f decodes/s (full playback %d)\n",
+                Name, SelectMs, Steps.size() / Seconds, Decodes / Seconds, Options.Fps);
+        };
+        FSubsampleSettings Settings;
+        Report("keyframes, 2 fps", Settings);
+        Settings.Mode = ESubsampleMode::EveryNth;
+        Settings.Nth = 4;
+        Report("every 4th, depth 8", Settings);
+        Settings.MaxDecodeDepth = Options.Gop;
+        Report("every 4th, any", Settings);
+        Settings.MinInterval100ns = 2000000;
+        Report("every 4th, any, 5fps", Settings);
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: keyframe_bench [--minutes N] [--fps N] [--gop N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckFixedGops(), "fixed GOPs");
+    bPass &= Check(CheckVariableGops(), "variable GOPs");
+    bPass &= Check(CheckEdges(), "edges");
+    RunBenchmark(Options);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// KeyframeIndex - Sample selection for low-power (temporally subsampled) playback.
+// Built once from the container's sample table: every video sample's timestamp
+// and whether it is a sync sample (keyframe). Low-power playback then shows only
+// a few frames per second, chosen so each one is cheap to reach by a seek: a
+// keyframe decodes alone, while a frame k samples into its GOP needs k+1 decodes.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct FSampleEntry
+{
+    int64_t Timestamp100ns = 0;
+    bool bSync = false;
+};
+
+enum class ESubsampleMode : uint8_t
+{
+    Keyframes,  // Sync samples only: one decode per shown frame
+    EveryNth    // Every Nth sample, where it lies shallow enough in its GOP
+};
+
+struct FSubsampleSettings
+{
+    ESubsampleMode Mode = ESubsampleMode::Keyframes;
+    int32_t Nth = 1;                        // EveryNth: sample stride
+    int64_t MinInterval100ns = 5000000;     // Shown frames are at least this far apart (2 fps)
+    int32_t MaxDecodeDepth = 8;             // EveryNth: most samples decoded to reach one frame
+};
+
+/** One frame of the low-power schedule: media time to seek to and what reaching it costs. */
+struct FSubsampleStep
+{
+    int64_t Timestamp100ns = 0;
+    int32_t DecodeCost = 1;
+};
+
+class FKeyframeIndex
+{
+public:
+    /** Takes samples in decode order; they are kept in presentation (timestamp) order. */
+    void Build(std::vector<FSampleEntry> InSamples)
+    {
+        Samples = std::move(InSamples);
+        std::stable_sort
+        (
+            Samples.begin(), Samples.end(),
+            [](const FSampleEntry& A, const FSampleEntry& B) { return A.Timestamp100ns < B.Timestamp100ns; }
+        );
+        SyncCount = 0;
+        for (const auto& Sample : Samples) SyncCount += Sample.bSync ? 1 : 0;
+    }
+
+    size_t GetSampleCount() const { return Samples.size(); }
+    size_t GetSyncCount() const { return SyncCount; }
+    double GetAverageGopLength() const
+    {
+        return SyncCount ? static_cast<double>(Samples.size()) / static_cast<double>(SyncCount) : 0.0;
+    }
+
+    /** Presentation times of the sync samples, ascending. */
+    std::vector<int64_t> GetSyncTimestamps() const
+    {
+        std::vector<int64_t> Timestamps;
+        Timestamps.reserve(SyncCount);
+        for (const auto& Sample : Samples)
+        {
+            if (Sample.bSync) Timestamps.push_back(Sample.Timestamp100ns);
+        }
+        return Timestamps;
+    }
+
+    /**
+     * Builds the low-power schedule. Decode cost counts samples back to the previous
+     * sync sample in presentation order, which is exact for I/P streams and a close
+     * bound with B-frames. Returns nothing when the index has no sync samples.
+     */
+    std::vector<FSubsampleStep> Select(const FSubsampleSettings& Settings) const
+    {
+        std::vector<FSubsampleStep> Steps;
+        if (!SyncCount) return Steps;
+
+        int32_t Nth = Settings.Nth > 0 ? Settings.Nth : 1;
+        int32_t Depth = 0;
+        bool bHaveDue = false;
+        int64_t NextDue = 0;
+        for (size_t Index = 0; Index < Samples.size(); ++Index)
+        {
+            const FSampleEntry& Sample = Samples[Index];
+            Depth = Sample.bSync ? 1 : (Depth ? Depth + 1 : 0);
+            if (!Depth) continue; // Leading samples before the first keyframe cannot be decoded alone
+
+            bool bCandidate = Sample.bSync;
+            if (Settings.Mode == ESubsampleMode::EveryNth && !bCandidate)
+            {
+                bCandidate = Index % static_cast<size_t>(Nth) == 0 && Depth <= Settings.MaxDecodeDepth;
+            }
+            if (!bCandidate || (bHaveDue && Sample.Timestamp100ns < NextDue)) continue;
+
+            Steps.push_back({ Sample.Timestamp100ns, Depth });
+            NextDue = Sample.Timestamp100ns + Settings.MinInterval100ns;
+            bHaveDue = true;
+        }
+        return Steps;
+    }
+
+    /** Index of the step to show at media time Position100ns: the last one at or before it. */
+    static size_t FindStep(const std::vector<FSubsampleStep>& Steps, int64_t Position100ns)
+    {
+        auto It = std::upper_bound
+        (
+            Steps.begin(), Steps.end(), Position100ns,
+            [](int64_t Position, const FSubsampleStep& Step) { return Position < Step.Timestamp100ns; }
+        );
+        return It == Steps.begin() ? 0 : static_cast<size_t>(It - Steps.begin()) - 1;
+    }
+
+private:
+    std::vector<FSampleEntry> Samples;
+    size_t SyncCount = 0;
+};
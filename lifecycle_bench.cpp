@@ -0,0 +1,424 @@
+// lifecycle_bench - Scripted headless runs of the session and display-power lifecycle.
+// A fake host applies FSessionLifecycle's transitions the way UpdateLifecycle does:
+// players of monitors that leave Active are paused and re-seeked to the master
+// clock when they come back, the pipelines are released once every monitor is
+// released and rebuilt when one is visible again. Scripts give timed events -
+// lock, unlock, disconnect, connect, display power for one or all monitors, a
+// new monitor set - and expectations about monitor states, players, pipelines
+// and the time accounted to each state; the host's 500 ms update timer runs in
+// between. Built-in scripts cover lock and unlock, a lock long enough to release,
+// one display off, all displays off, dimming, a disconnect inside a lock, a
+// monitor change while released and releasing turned off. --script runs a file
+// of the same form instead, one "<ms> <command> [args]" per line:
+//   monitors N | lock | unlock | disconnect | connect | display all|M on|off|dimmed
+//   release_after MS | pause_dimmed on|off
+//   expect all|M active|paused|released | expect pipelines live|released
+//   expect builds N | expect playing N | expect time M active|paused|released MS
+//   g++ -std=c++20 -O2 -pthread lifecycle_bench.cpp -o lifecycle_bench
+//   lifecycle_bench [--script FILE]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "session_lifecycle.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    /** The window procedure's update timer (TimerIntervalMs). */
+    constexpr int64_t TickMs = 500;
+
+    struct FBenchOptions
+    {
+        std::string ScriptPath;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--script") Options.ScriptPath = Value;
+            else return false;
+        }
+        return true;
+    }
+
+    struct FScript
+    {
+        const char* Name;
+        const char* Text;
+    };
+
+    const FScript BuiltInScripts[] =
+    {
+        { "lock and unlock",
+            "0 monitors 2\n"
+            "1000 lock\n"
+            "1000 expect all paused\n"
+            "1000 expect playing 0\n"
+            "5000 unlock\n"
+            "5000 expect all active\n"
+            "5000 expect playing 2\n"
+            "5000 expect builds 1\n"
+            "5000 expect time 0 paused 4000\n" },
+        { "long lock releases",
+            "0 release_after 10000\n"
+            "0 monitors 2\n"
+            "2000 lock\n"
+            "11500 expect all paused\n"
+            "11500 expect pipelines live\n"
+            "12000 expect all released\n"
+            "12000 expect pipelines released\n"
+            "30000 unlock\n"
+            "30000 expect all active\n"
+            "30000 expect pipelines live\n"
+            "30000 expect builds 2\n"
+            "30000 expect time 1 released 18000\n" },
+        { "one display off",
+            "0 release_after 10000\n"
+            "0 monitors 2\n"
+            "1000 display 1 off\n"
+            "1000 expect 0 active\n"
+            "1000 expect 1 paused\n"
+            "1000 expect playing 1\n"
+            "60000 expect 1 paused\n"
+            "60000 expect pipelines live\n"
+            "61000 display 1 on\n"
+            "61000 expect all active\n"
+            "61000 expect builds 1\n" },
+        { "all displays off",
+            "0 release_after 10000\n"
+            "0 monitors 3\n"
+            "1000 display all off\n"
+            "1000 expect all paused\n"
+            "11000 expect all released\n"
+            "11000 expect pipelines released\n"
+            "20000 display all on\n"
+            "20000 expect all active\n"
+            "20000 expect playing 3\n"
+            "20000 expect builds 2\n" },
+        { "dimmed",
+            "0 monitors 1\n"
+            "1000 display all dimmed\n"
+            "1000 expect all active\n"
+            "2000 pause_dimmed on\n"
+            "2500 expect all paused\n"
+            "3000 display all on\n"
+            "3000 expect all active\n" },
+        { "disconnect inside a lock",
+            "0 release_after 10000\n"
+            "0 monitors 2\n"
+            "1000 lock\n"
+            "2000 disconnect\n"
+            "3000 unlock\n"
+            "3000 expect all paused\n"
+            "4000 connect\n"
+            "4000 expect all active\n"
+            "4000 expect builds 1\n"
+            "4000 expect time 0 paused 3000\n" },
+        { "monitor change while released",
+            "0 release_after 10000\n"
+            "0 monitors 2\n"
+            "1000 lock\n"
+            "11000 expect all released\n"
+            "15000 monitors 3\n"
+            "15000 expect 0 paused\n"
+            "15000 expect 2 paused\n"
+            "15000 expect pipelines live\n"
+            "24500 expect all paused\n"
+            "25000 expect all released\n"
+            "25000 expect pipelines released\n"
+            "30000 unlock\n"
+            "30000 expect all active\n" },
+        { "release off",
+            "0 release_after 0\n"
+            "0 monitors 2\n"
+            "1000 lock\n"
+            "3600000 expect all paused\n"
+            "3600000 expect pipelines live\n"
+            "3601000 unlock\n"
+            "3601000 expect all active\n"
+            "3601000 expect builds 1\n" },
+    };
+
+    struct FHostMonitor
+    {
+        bool bDormant = false;
+        bool bPlaying = true;
+        int32_t Seeks = 0;
+    };
+
+    /** UpdateLifecycle's side of the contract, with counters instead of players. */
+    class FLifecycleHost
+    {
+    public:
+        bool RunScript(const char* Name, const std::string& Text)
+        {
+            std::istringstream Lines(Text);
+            std::string Line;
+            bool bPass = true;
+            int32_t LineNumber = 0;
+            while (std::getline(Lines, Line))
+            {
+                ++LineNumber;
+                std::istringstream Words(Line);
+                int64_t AtMs = 0;
+                std::string Command;
+                if (Line.empty() || Line[0] == '#') continue;
+                if (!(Words >> AtMs >> Command) || AtMs < NowMs)
+                {
+                    std::printf("  %s:%d: bad line \"%s\"\n", Name, LineNumber, Line.c_str());
+                    return false;
+                }
+                AdvanceTo(AtMs);
+                if (!Apply(Command, Words))
+                {
+                    std::printf("  %s:%d: %s\n", Name, LineNumber, Line.c_str());
+                    bPass = false;
+                }
+            }
+            std::printf("%-30s %s: %d pipeline build(s), %d seek(s) on resume\n", Name, bPass ? "ok" : "FAILED", Builds, Seeks);
+            return bPass;
+        }
+
+    private:
+        /** The update timer fires on every multiple of TickMs up to and including Target. */
+        void AdvanceTo(int64_t TargetMs)
+        {
+            for (int64_t Tick = (NowMs / TickMs + 1) * TickMs; Tick <= TargetMs; Tick += TickMs)
+            {
+                NowMs = Tick;
+                Update();
+            }
+            NowMs = TargetMs;
+        }
+
+        void Update()
+        {
+            std::vector<FLifecycleTransition> Transitions;
+            Lifecycle.Update(NowMs, Transitions);
+            for (const auto& Transition : Transitions)
+            {
+                if (Transition.Monitor >= Monitors.size()) continue;
+                FHostMonitor& Monitor = Monitors[Transition.Monitor];
+                bool bDormant = Transition.To != ELifecycleState::Active;
+                if (bDormant == Monitor.bDormant) continue;
+                Monitor.bDormant = bDormant;
+                Monitor.bPlaying = !bDormant;
+                if (!bDormant)
+                {
+                    ++Monitor.Seeks;
+                    ++Seeks;
+                }
+            }
+            if (Lifecycle.AreAllReleased() && !bReleased) bReleased = true;
+            else if (bReleased && !Lifecycle.AreAllReleased())
+            {
+                bReleased = false;
+                ++Builds;
+            }
+        }
+
+        /** ReloadWallpaper after a display change: monitors and pipelines are built anew. */
+        void SetMonitors(size_t Count)
+        {
+            Lifecycle.SetMonitorCount(Count, NowMs);
+            Monitors.assign(Count, FHostMonitor{});
+            for (size_t Index = 0; Index < Count; ++Index)
+            {
+                // Rebuilt players start paused for monitors the lifecycle keeps dormant.
+                Monitors[Index].bDormant = Lifecycle.GetState(Index) != ELifecycleState::Active;
+                Monitors[Index].bPlaying = !Monitors[Index].bDormant;
+            }
+            if (Builds == 0 || bReleased) ++Builds;
+            bReleased = false;
+            Update();
+        }
+
+        static bool ParseState(const std::string& Word, ELifecycleState& State)
+        {
+            for (ELifecycleState Candidate : { ELifecycleState::Active, ELifecycleState::Paused, ELifecycleState::Released })
+            {
+                if (Word == GetLifecycleStateName(Candidate)) { State = Candidate; return true; }
+            }
+            return false;
+        }
+
+        bool Apply(const std::string& Command, std::istringstream& Words)
+        {
+            std::string First, Second;
+            if (Command == "monitors")
+            {
+                int32_t Count = 0;
+                if (!(Words >> Count) || Count <= 0) return false;
+                SetMonitors(static_cast<size_t>(Count));
+                return true;
+            }
+            if (Command == "lock" || Command == "unlock" || Command == "disconnect" || Command == "connect")
+            {
+                Lifecycle.OnSessionEvent
+                (
+                    Command == "lock" ? ESessionEvent::Lock
+                    : Command == "unlock" ? ESessionEvent::Unlock
+                    : Command == "disconnect" ? ESessionEvent::Disconnect
+                    : ESessionEvent::Connect
+                );
+                Update();
+                return true;
+            }
+            if (Command == "display")
+            {
+                if (!(Words >> First >> Second)) return false;
+                EDisplayPower Power = Second == "off" ? EDisplayPower::Off : Second == "dimmed" ? EDisplayPower::Dimmed : EDisplayPower::On;
+                if (First == "all") Lifecycle.SetAllDisplayPower(Power);
+                else Lifecycle.SetDisplayPower(static_cast<size_t>(std::atoi(First.c_str())), Power);
+                Update();
+                return true;
+            }
+            if (Command == "release_after" || Command == "pause_dimmed")
+            {
+                if (!(Words >> First)) return false;
+                if (Command == "release_after") Settings.ReleaseAfterMs = std::atoll(First.c_str());
+                else Settings.bPauseWhenDimmed = First == "on";
+                Lifecycle.Configure(Settings);
+                return true;
+            }
+            if (Command == "expect") return Expect(Words);
+            return false;
+        }
+
+        bool Expect(std::istringstream& Words)
+        {
+            std::string What, Value;
+            if (!(Words >> What >> Value)) return false;
+            if (What == "pipelines") return bReleased == (Value == "released");
+            if (What == "builds") return Builds == std::atoi(Value.c_str());
+            if (What == "playing")
+            {
+                int32_t Playing = 0;
+                for (const auto& Monitor : Monitors) Playing += Monitor.bPlaying ? 1 : 0;
+                return Playing == std::atoi(Value.c_str());
+            }
+            if (What == "time")
+            {
+                // expect time M state MS: time accounted to that state so far.
+                std::string Ms;
+                ELifecycleState State;
+                size_t Monitor = static_cast<size_t>(std::atoi(Value.c_str()));
+                if (!(Words >> Value >> Ms) || !ParseState(Value, State) || Monitor >= Lifecycle.GetMonitorCount()) return false;
+                return Lifecycle.GetTimeInState(Monitor, State, NowMs) == std::atoll(Ms.c_str());
+            }
+
+            ELifecycleState State;
+            if (!ParseState(Value, State)) return false;
+            bool bAll = What == "all";
+            size_t Only = bAll ? 0 : static_cast<size_t>(std::atoi(What.c_str()));
+            if (!bAll && Only >= Lifecycle.GetMonitorCount()) return false;
+            bool bMatch = true;
+            for (size_t Index = 0; Index < Lifecycle.GetMonitorCount(); ++Index)
+            {
+                if (!bAll && Index != Only) continue;
+                bMatch &= Lifecycle.GetState(Index) == State;
+                bMatch &= Monitors[Index].bDormant == (State != ELifecycleState::Active);
+            }
+            return bMatch;
+        }
+
+        FSessionLifecycle Lifecycle;
+        FLifecycleSettings Settings;
+        std::vector<FHostMonitor> Monitors;
+        int64_t NowMs = 0;
+        bool bReleased = false;
+        int32_t Builds = 0;
+        int32_t Seeks = 0;
+    };
+
+    /** Every millisecond of a long random run is accounted to exactly one state. */
+    bool CheckAccounting()
+    {
+        FSessionLifecycle Lifecycle;
+        FLifecycleSettings Settings;
+        Settings.ReleaseAfterMs = 5000;
+        Lifecycle.Configure(Settings);
+        Lifecycle.SetMonitorCount(3, 0);
+        std::vector<FLifecycleTransition> Transitions;
+        uint32_t Seed = 12345;
+        int64_t NowMs = 0;
+        for (int32_t Step = 0; Step < 20000; ++Step)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            NowMs += 100 + (Seed >> 8) % 3000;
+            switch ((Seed >> 4) % 6)
+            {
+            case 0: Lifecycle.OnSessionEvent(ESessionEvent::Lock); break;
+            case 1: Lifecycle.OnSessionEvent(ESessionEvent::Unlock); break;
+            case 2: Lifecycle.OnSessionEvent((Seed >> 12) % 2 ? ESessionEvent::Disconnect : ESessionEvent::Connect); break;
+            case 3: Lifecycle.SetDisplayPower((Seed >> 12) % 3, (Seed >> 16) % 2 ? EDisplayPower::Off : EDisplayPower::On); break;
+            default: break;
+            }
+            Lifecycle.Update(NowMs, Transitions);
+        }
+
+        bool bSums = true;
+        for (size_t Monitor = 0; Monitor < 3; ++Monitor)
+        {
+            int64_t Total = 0;
+            for (ELifecycleState State : { ELifecycleState::Active, ELifecycleState::Paused, ELifecycleState::Released })
+            {
+                Total += Lifecycle.GetTimeInState(Monitor, State, NowMs);
+            }
+            bSums &= Total == NowMs;
+        }
+        bool bTransitions = true;
+        for (const auto& Transition : Transitions) bTransitions &= Transition.From != Transition.To && Transition.TimeInFromMs >= 0;
+        bool bPass = Check(bSums, "time in states adds up to the run");
+        bPass &= Check(bTransitions && !Transitions.empty(), "transitions change state");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: lifecycle_bench [--script FILE]\n");
+        return 2;
+    }
+
+    bool bPass = true;
+    if (!Options.ScriptPath.empty())
+    {
+        std::ifstream File(Options.ScriptPath);
+        std::stringstream Text;
+        Text << File.rdbuf();
+        FLifecycleHost Host;
+        bPass = Check(File.good() && Host.RunScript(Options.ScriptPath.c_str(), Text.str()), "script");
+    }
+    else
+    {
+        for (const FScript& Script : BuiltInScripts)
+        {
+            FLifecycleHost Host;
+            bPass &= Check(Host.RunScript(Script.Name, Script.Text), Script.Name);
+        }
+        bPass &= Check(CheckAccounting(), "accounting");
+    }
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
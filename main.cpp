@@ -2,51 +2,112 @@
 // Supports both legacy WorkerW trick (Win 7-10) and Win 11 24H2+ (child of Progman)
 // Per-monitor support: one window + one MFPlay player per monitor.
 // Usage: Place config.txt next to .exe with the absolute path to a video file.
-// Press Ctrl+Alt+Q to quit.
+// Animated GIF/APNG (and still PNG) files play through the software presenter.
+// Press Ctrl+Alt+Q to quit, Ctrl+Alt+T to toggle hot-path tracing.
+// A resources.flag next to the .exe turns on per-subsystem resource tracking.
 
 #include <windows.h>
 #include <psapi.h>
 #include <mfplay.h>
 #include <mfapi.h>
 #include <mfidl.h>
+#include <mfreadwrite.h>
 #include <shlwapi.h>
 #include <propvarutil.h>
 #include <commdlg.h>
 #include <evr.h>
+#include <wtsapi32.h>
 
 // MR_VIDEO_RENDER_SERVICE GUID (not exported by MinGW's import libs)
 static const GUID LOCAL_MR_VIDEO_RENDER_SERVICE =
     { 0x1092a86c, 0xab1a, 0x459a, { 0xa3, 0x36, 0x83, 0x1f, 0xbc, 0x4d, 0x11, 0xf4 } };
 
+// GUID_CONSOLE_DISPLAY_STATE power setting (same reason)
+static const GUID LOCAL_GUID_CONSOLE_DISPLAY_STATE =
+    { 0x6fe69556, 0x704a, 0x47a0, { 0x8f, 0x24, 0xc2, 0x8d, 0x93, 0x6f, 0xda, 0x47 } };
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "animation_cache.h"
+#include "compositor.h"
+#include "control_protocol.h"
+#include "keyframe_index.h"
+#include "master_clock.h"
+#include "memory_governor.h"
+#include "pingpong.h"
+#include "qos.h"
+#include "quality_controller.h"
+#include "rendition.h"
+#include "resource_tracker.h"
+#include "session_lifecycle.h"
+#include "shell_attach.h"
+#include "software_pipeline.h"
+#include "span_layout.h"
+#include "task_group.h"
+#include "thread_pool.h"
+#include "tile_diff.h"
+#include "trace.h"
+#include "video_source.h"
+#include "window_cache.h"
+
 #ifdef _MSC_VER
 #pragma comment(lib, "mfplay.lib")
 #pragma comment(lib, "mfplat.lib")
+#pragma comment(lib, "mfreadwrite.lib")
 #pragma comment(lib, "mf.lib")
 #pragma comment(lib, "mfuuid.lib")
 #pragma comment(lib, "ole32.lib")
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "comdlg32.lib")
 #pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "wtsapi32.lib")
 #endif
 
 
 /** Undocumented Progman message to spawn a WorkerW behind the desktop icons. */
 constexpr UINT WM_SPAWN_WORKERW = 0x052C;
 
-/** Pre-seek threshold: begin looping when within 500ms (in 100ns units) of end. */
-constexpr LONGLONG PreSeekThreshold100ns = 5000000LL;
-
 /** Timer ID for the periodic update tick. */
 constexpr UINT_PTR TimerIdUpdate = 100;
 
+/** Timer ID for the one-shot synchronized loop at the master clock's wrap. */
+constexpr UINT_PTR TimerIdLoop = 101;
+
+/** Timer ID for the one-shot low-power step that falls between two update ticks. */
+constexpr UINT_PTR TimerIdLowPower = 102;
+
+/** Low-power playback frame rate bounds (lowpower_fps). */
+constexpr int32_t LowPowerMinFps = 1;
+constexpr int32_t LowPowerMaxFps = 5;
+
+/** Smallest playback-rate change worth sending to a player. */
+constexpr double RateChangeEpsilon = 0.001;
+
 /** Timer interval in milliseconds. */
 constexpr UINT TimerIntervalMs = 500;
 
+/** Software presenter: timer ticks between per-stage timing log lines. */
+constexpr int32_t PresenterStatsLogTicks = 20;
+
+/** Software presenter: default length of the crossfade between videos. */
+constexpr int32_t DefaultCrossfadeMs = 1000;
+
+/** Resource tracking: timer ticks between periodic checkpoints (10 minutes). */
+constexpr int32_t ResourceCheckpointTicks = 1200;
+
 /** Maximum number of boot retries waiting for desktop. */
 constexpr int32_t MaxDesktopRetries = 30;
 
@@ -56,16 +117,87 @@ constexpr int32_t ClassNameBufferSize = 64;
 namespace
 {
     void ShutdownAllMonitors();
+    void OnPipelineReady(int32_t MonitorIndex);
+    void OnPipelineFailed(int32_t MonitorIndex, HRESULT Result);
     void ChangeVideo();
     bool IsAutoStartEnabled();
     void SetAutoStart(bool bEnable);
+    using FSoftwareLayout = TSoftwareLayout<HWND>;
+    FSoftwareLayout BuildSoftwareLayout();
+    bool IsAnimatedImageFile(const std::wstring& Path);
+    bool ShouldUseSoftwarePresenter();
+    std::wstring GetIndexedVideoPath();
+    void UpdateRenditions();
+    void LogSoftwarePresenterStats();
+    void UpdatePresenterQuality();
+    void OnWallpaperWindowDestroyed(HWND Window);
+    void RunShellAttachAction(EShellAttachAction Action);
+    void UpdateLifecycle();
+    void OnSessionEvent(ESessionEvent Event);
+    void OnDisplayPower(EDisplayPower Power);
+    void LogLifecycleTotals();
+    void StartControlServer(HWND Target);
+    void StopControlServer();
+    std::wstring GetControlPipeName();
+    FControlResponse HandleControlRequest(const FControlRequest& Request);
+    void LogResourceCheckpoint(const wchar_t* Reason);
+    std::wstring AsciiToWide(const char* Text);
+    void TickResourceCheckpoint();
 
     HANDLE GMutex = nullptr;
     HWND GMsgWindow = nullptr;
 
+    /** Broadcast to top-level windows when the shell (re)creates the taskbar. */
+    UINT GMsgTaskbarCreated = 0;
+
     bool GbDebugEnabled = false;
+
+    /** Per-monitor DPI awareness took: monitor rects are physical pixels. */
+    bool GbPerMonitorDpiAware = false;
     std::ofstream GLogFile;
     std::wstring GVideoPath;
+
+    enum class EPresenter : uint8_t
+    {
+        Auto,       // Software inside remote sessions, EVR otherwise
+        Evr,        // One MFPlay/EVR player per monitor (GPU)
+        Software    // One decode, CPU composition, GDI blit
+    };
+
+    enum class ELoopMode : uint8_t
+    {
+        Wrap,       // Back to the first frame at the end
+        PingPong    // Forwards, then backwards (software presenter only)
+    };
+
+    enum class ELowPowerScope : uint8_t
+    {
+        Off,
+        All,        // Every monitor
+        Secondary,  // Every monitor except the primary
+        Battery     // Every monitor while the system runs on battery
+    };
+
+    /** Contents of config.txt: the video path on line one, then optional key = value lines. */
+    struct FConfig
+    {
+        std::wstring VideoPath;
+        bool bSpanMode = false;
+        FSpanSettings Span;
+        EPresenter Presenter = EPresenter::Auto;
+        ELowPowerScope LowPower = ELowPowerScope::Off;
+        FSubsampleSettings Subsample;
+        FLifecycleSettings Lifecycle;
+        int64_t AnimationCacheBytes = DefaultAnimationCacheBytes;
+        int32_t CrossfadeMs = DefaultCrossfadeMs;
+        ELoopMode Loop = ELoopMode::Wrap;
+        int64_t PingPongCacheBytes = DefaultPingPongCacheBytes;
+        int64_t MemoryCeilingBytes = 0;
+        std::vector<TRendition<std::wstring>> Renditions;
+        EQosLevel Priority = EQosLevel::Background;
+        bool bEfficiencyCores = false;
+    };
+    FConfig GConfig;
     bool GbPaused = false;
     bool GbAutoPausedByFullscreen = false;
     bool GbMuted = true;
@@ -78,10 +210,67 @@ namespace
         IMFPMediaPlayer* Player = nullptr;
         RECT Rect = {};
         LONGLONG Duration = 0;
+        SIZE VideoSize = {};
+        FDriftCorrector Drift;
+        double Rate = 1.0;
+        bool bLowPower = false;             // Paused and stepped through GLowPowerSteps
+        size_t LowPowerStep = SIZE_MAX;     // Step currently shown
+        bool bDormant = false;              // Locked session or display off: paused until visible
+        int32_t Rendition = MasterRendition;    // Index into GRenditions of the encode this player decodes
 
     };
     std::vector<FMonitorWallpaper> GMonitors;
 
+    /** Renditions of GVideoPath whose files exist, refreshed whenever pipelines are built. */
+    std::vector<TRendition<std::wstring>> GRenditions;
+    int32_t GSoftwareRendition = MasterRendition;
+
+    /** Released once every monitor's player has opened the video or failed to. */
+    FPipelineBarrier GPipelineBarrier;
+
+    /** Shared timeline all players are trimmed toward; started when the barrier releases. */
+    FMasterClock GMasterClock;
+
+    /** Monitor placement on the bezel-expanded canvas for span mode. */
+    FSpanLayout GSpanLayout;
+
+    /** Low-power playback: the sample table is read in the background, then turned into a schedule. */
+    FTaskGroup GKeyframeIndexTask;
+    FKeyframeIndex GKeyframeIndex;
+    std::atomic<bool> GbCancelKeyframeIndex{ false };
+    bool GbKeyframeIndexPending = false;
+    std::vector<FSubsampleStep> GLowPowerSteps;
+
+    /** Ping-pong loop: keyframes of the current video, handed to its source once the index arrives. */
+    std::shared_ptr<FKeyframeTimestamps> GPingPongKeyframes;
+
+    /** Local control endpoint (named pipe) served on a background thread; commands run on the UI thread. */
+    FTaskGroup GControlServerTask;
+    HANDLE GControlStopEvent = nullptr;
+
+    /** A request handed from the control thread to the UI thread (WM_CONTROL_REQUEST). */
+    struct FControlExchange
+    {
+        const FControlRequest* Request;
+        FControlResponse Response;
+    };
+
+    /** Per-monitor visibility from session and display-power notifications. */
+    FSessionLifecycle GLifecycle;
+    bool GbPipelinesReleased = false;
+    HPOWERNOTIFY GDisplayStateNotify = nullptr;
+
+    /** Samples memory every tick: trims the working set when idle, degrades caches under pressure. */
+    FMemoryGovernor GMemoryGovernor;
+    HANDLE GLowMemoryNotification = nullptr;
+
+    /** Whether the wallpaper windows are hosted; tracks Explorer restarts and re-attachment. */
+    FShellAttachMachine GShellAttach;
+
+    /** Occlusion-scan classification per HWND; our own wallpaper windows live in its own-window set. */
+    TWindowClassCache<HWND> GWindowCache;
+    HWINEVENTHOOK GWindowCacheHooks[3] = {};
+
     struct FDesktopWindows
     {
         HWND Progman = nullptr;
@@ -105,6 +294,18 @@ namespace
         return GetFileAttributesW(FlagPath.c_str()) != INVALID_FILE_ATTRIBUTES;
     }
 
+    bool IsTraceFlagPresent()
+    {
+        std::wstring FlagPath = GetExeDir() + L"\\trace.flag";
+        return GetFileAttributesW(FlagPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
+    bool IsResourceFlagPresent()
+    {
+        std::wstring FlagPath = GetExeDir() + L"\\resources.flag";
+        return GetFileAttributesW(FlagPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+    }
+
     void Log(const std::wstring& Message)
     {
         if (!GbDebugEnabled) return;
@@ -148,6 +349,21 @@ namespace
         if (GLogFile.is_open()) GLogFile.close();
     }
 
+    /** Writes the trace ring buffer next to the .exe as Chrome trace JSON (open in Perfetto). Call with tracing disabled. */
+    void DumpTrace()
+    {
+        GTrace.WaitForWriters();
+        if (!GTrace.Recorded()) return;
+        std::wstring TracePath = GetExeDir() + L"\\trace.json";
+        std::ofstream TraceFile(TracePath.c_str());
+        GTrace.WriteChromeJson(TraceFile);
+        Log
+        (
+            L"Trace written: " + std::to_wstring(GTrace.Snapshot().size()) + L" of "
+            + std::to_wstring(GTrace.Recorded()) + L" events."
+        );
+    }
+
     std::wstring TrimString(const std::wstring& InString)
     {
         const wchar_t* Whitespace = L" \t\r\n\"";
@@ -157,13 +373,152 @@ namespace
         return InString.substr(Start, End - Start + 1);
     }
 
-    std::wstring ReadVideoPath()
+    /**
+     * One settings line of config.txt (also "vwctl set <key> <value>"); false for unknown keys:
+     *   mode  = clone | span      (span: one video across all monitors)
+     *   bezel = 40[,40]           (span gap in pixels, horizontal[,vertical])
+     *   fit   = cover | stretch   (span: crop to keep aspect, or stretch)
+     *   presenter = auto | evr | software
+     *   lowpower = off | on | secondary | battery   (keyframe-only playback on those monitors)
+     *   lowpower_fps = 2                            (1-5 shown frames per second)
+     *   lowpower_frames = keyframes | N             (sync samples only, or every Nth frame)
+     *   release_after = 600       (seconds locked/off before pipelines are released; 0 = only pause)
+     *   pause_dimmed = off | on   (treat a dimmed display as off)
+     *   animation_cache_mb = 256  (decoded GIF/APNG frames kept in memory; 0 = always stream)
+     *   crossfade_ms = 1000       (software presenter: fade between videos on a switch; 0 = cut)
+     *   loop = wrap | pingpong    (pingpong: forwards then backwards; uses the software presenter)
+     *   pingpong_cache_mb = 256   (decoded frames kept for reverse playback)
+     *   memory_ceiling_mb = 0     (working set to stay under by degrading caches, then trimming; 0 = none)
+     *   rendition = 1920x1080 _1080p   (another encode next to the video; repeat per encode; off = none)
+     *   priority = background | idle | normal   (CPU priority and EcoQoS of decode and present work)
+     *   efficiency_cores = off | on  (keep demoted threads on the efficiency cores of hybrid CPUs)
+     */
+    bool ApplyConfigSetting(FConfig& Config, const std::wstring& Key, const std::wstring& Value)
+    {
+        if (Key == L"mode") Config.bSpanMode = Value == L"span";
+        else if (Key == L"fit") Config.Span.Fit = Value == L"stretch" ? ESpanFit::Stretch : ESpanFit::Cover;
+        else if (Key == L"presenter")
+        {
+            Config.Presenter = Value == L"software" ? EPresenter::Software
+                             : Value == L"evr" ? EPresenter::Evr
+                             : EPresenter::Auto;
+        }
+        else if (Key == L"lowpower")
+        {
+            Config.LowPower = Value == L"on" ? ELowPowerScope::All
+                            : Value == L"secondary" ? ELowPowerScope::Secondary
+                            : Value == L"battery" ? ELowPowerScope::Battery
+                            : ELowPowerScope::Off;
+        }
+        else if (Key == L"lowpower_fps")
+        {
+            int32_t Fps = _wtoi(Value.c_str());
+            Fps = Fps < LowPowerMinFps ? LowPowerMinFps : (Fps > LowPowerMaxFps ? LowPowerMaxFps : Fps);
+            Config.Subsample.MinInterval100ns = 10000000LL / Fps;
+        }
+        else if (Key == L"lowpower_frames")
+        {
+            int32_t Nth = _wtoi(Value.c_str());
+            Config.Subsample.Mode = Nth > 0 ? ESubsampleMode::EveryNth : ESubsampleMode::Keyframes;
+            Config.Subsample.Nth = Nth > 0 ? Nth : 1;
+        }
+        else if (Key == L"release_after")
+        {
+            int32_t Seconds = _wtoi(Value.c_str());
+            Config.Lifecycle.ReleaseAfterMs = Seconds > 0 ? Seconds * 1000LL : 0;
+        }
+        else if (Key == L"pause_dimmed") Config.Lifecycle.bPauseWhenDimmed = Value == L"on";
+        else if (Key == L"animation_cache_mb")
+        {
+            int32_t Megabytes = _wtoi(Value.c_str());
+            Config.AnimationCacheBytes = Megabytes > 0 ? Megabytes * 1024LL * 1024 : 0;
+        }
+        else if (Key == L"crossfade_ms")
+        {
+            int32_t Milliseconds = _wtoi(Value.c_str());
+            Config.CrossfadeMs = Milliseconds > 0 ? Milliseconds : 0;
+        }
+        else if (Key == L"loop") Config.Loop = Value == L"pingpong" ? ELoopMode::PingPong : ELoopMode::Wrap;
+        else if (Key == L"pingpong_cache_mb")
+        {
+            int32_t Megabytes = _wtoi(Value.c_str());
+            Config.PingPongCacheBytes = Megabytes > 0 ? Megabytes * 1024LL * 1024 : DefaultPingPongCacheBytes;
+        }
+        else if (Key == L"memory_ceiling_mb")
+        {
+            int32_t Megabytes = _wtoi(Value.c_str());
+            Config.MemoryCeilingBytes = Megabytes > 0 ? Megabytes * 1024LL * 1024 : 0;
+        }
+        else if (Key == L"rendition")
+        {
+            TRendition<std::wstring> Rendition;
+            if (Value == L"off") Config.Renditions.clear();
+            else if (ParseRendition(Value, Rendition))
+            {
+                std::erase_if(Config.Renditions, [&](const auto& Other) { return Other.Suffix == Rendition.Suffix; });
+                Config.Renditions.push_back(Rendition);
+            }
+        }
+        else if (Key == L"priority")
+        {
+            if (!ParseQosLevel(Value, Config.Priority)) Config.Priority = EQosLevel::Background;
+        }
+        else if (Key == L"efficiency_cores") Config.bEfficiencyCores = Value == L"on";
+        else if (Key == L"bezel")
+        {
+            Config.Span.BezelX = _wtoi(Value.c_str());
+            auto Comma = Value.find(L',');
+            Config.Span.BezelY = Comma != std::wstring::npos
+                ? _wtoi(Value.c_str() + Comma + 1)
+                : Config.Span.BezelX;
+        }
+        else return false;
+        return true;
+    }
+
+    /**
+     * Line one is the video path (the original single-line format still works).
+     * Later lines are optional settings (ApplyConfigSetting); unknown keys and '#'
+     * comments are ignored.
+     */
+    FConfig ReadConfig()
     {
+        FConfig Config;
         std::wstring ConfigPath = GetExeDir() + L"\\config.txt";
         std::wifstream File(ConfigPath.c_str());
-        std::wstring Path;
-        std::getline(File, Path);
-        return TrimString(Path);
+        std::wstring Line;
+        std::getline(File, Line);
+        Config.VideoPath = TrimString(Line);
+
+        while (std::getline(File, Line))
+        {
+            Line = TrimString(Line);
+            auto Equals = Line.find(L'=');
+            if (Line.empty() || Line[0] == L'#' || Equals == std::wstring::npos) continue;
+            ApplyConfigSetting(Config, TrimString(Line.substr(0, Equals)), TrimString(Line.substr(Equals + 1)));
+        }
+        return Config;
+    }
+
+    /** Replaces the video path (line one) and keeps every settings line after it. */
+    void WriteConfigVideoPath(const std::wstring& VideoPath)
+    {
+        std::wstring ConfigPath = GetExeDir() + L"\\config.txt";
+        std::vector<std::wstring> Lines;
+        {
+            std::wifstream File(ConfigPath.c_str());
+            std::wstring Line;
+            while (std::getline(File, Line)) Lines.push_back(Line);
+        }
+        if (Lines.empty()) Lines.emplace_back();
+        Lines[0] = VideoPath;
+
+        std::wofstream ConfigFile(ConfigPath.c_str());
+        for (size_t Index = 0; Index < Lines.size(); ++Index)
+        {
+            ConfigFile << Lines[Index];
+            if (Index + 1 < Lines.size()) ConfigFile << L'\n';
+        }
     }
 
     // Finds the WorkerW that CONTAINS SHELLDLL_DefView (the icons container).
@@ -318,11 +673,345 @@ namespace
         return Rects;
     }
 
+    FIntRect ToIntRect(const RECT& Rect)
+    {
+        return
+        {
+            static_cast<int32_t>(Rect.left), static_cast<int32_t>(Rect.top),
+            static_cast<int32_t>(Rect.right), static_cast<int32_t>(Rect.bottom)
+        };
+    }
+
+    /** Seeks a player to an absolute position in 100ns units. */
+    void SeekPlayer(IMFPMediaPlayer* Player, LONGLONG Position100ns)
+    {
+        PROPVARIANT Position; PropVariantInit(&Position);
+        Position.vt = VT_I8; Position.hVal.QuadPart = Position100ns;
+        Player->SetPosition(MFP_POSITIONTYPE_100NS, &Position);
+        PropVariantClear(&Position);
+    }
+
+    /**
+     * Span mode: every player shows only its monitor's slice of the video, mapped
+     * from the monitor's place on the bezel-expanded virtual desktop. The crop is a
+     * renderer source rectangle, so no frame is copied. Clone mode shows the full frame.
+     */
+    void ApplySpanViewports()
+    {
+        std::vector<FIntRect> MonitorRects;
+        for (const auto& Monitor : GMonitors) MonitorRects.push_back(ToIntRect(Monitor.Rect));
+        GSpanLayout.Build(MonitorRects, GConfig.Span);
+
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+        {
+            auto& Monitor = GMonitors[Index];
+            if (!Monitor.Player || Monitor.VideoSize.cx <= 0) continue;
+
+            MFVideoNormalizedRect SourceRect = { 0.0f, 0.0f, 1.0f, 1.0f };
+            if (GConfig.bSpanMode)
+            {
+                FNormalizedRect Source = GSpanLayout.GetViewport
+                (
+                    Index, Monitor.VideoSize.cx, Monitor.VideoSize.cy
+                ).Source;
+                SourceRect = { Source.Left, Source.Top, Source.Right, Source.Bottom };
+            }
+            Monitor.Player->SetVideoSourceRect(&SourceRect);
+        }
+    }
+
+    /** IVideoSource over the Media Foundation source reader, decoding to NV12 (P010 for HDR10). */
+    class FMFSourceReaderSource final : public IVideoSource
+    {
+    public:
+        ~FMFSourceReaderSource() override
+        {
+            if (!Reader) return;
+            Reader->Release();
+            RESOURCE_RELEASE("SourceReader", ComRef);
+        }
+
+        HRESULT Open(const std::wstring& Path)
+        {
+            IMFAttributes* Attributes = nullptr;
+            HRESULT Result = MFCreateAttributes(&Attributes, 1);
+            if (SUCCEEDED(Result))
+            {
+                // Lets the reader insert a converter when the decoder cannot output NV12 itself.
+                Attributes->SetUINT32(MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING, TRUE);
+                Result = MFCreateSourceReaderFromURL(Path.c_str(), Attributes, &Reader);
+                Attributes->Release();
+            }
+            if (FAILED(Result)) return Result;
+            RESOURCE_ACQUIRE("SourceReader", ComRef);
+
+            Reader->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, FALSE);
+            Reader->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
+
+            // HDR10 is decoded to P010 and tone mapped by the compositor: the reader's own
+            // conversion to NV12 only drops the low bits, which leaves PQ video washed out.
+            bool bHdr = IsPqStream();
+            IMFMediaType* Type = nullptr;
+            Result = MFCreateMediaType(&Type);
+            if (SUCCEEDED(Result))
+            {
+                Type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+                Type->SetGUID(MF_MT_SUBTYPE, bHdr ? MFVideoFormat_P010 : MFVideoFormat_NV12);
+                Result = Reader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, nullptr, Type);
+                if (FAILED(Result) && bHdr)
+                {
+                    Type->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_NV12);
+                    Result = Reader->SetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, nullptr, Type);
+                }
+                Type->Release();
+            }
+            if (FAILED(Result)) return Result;
+            return ReadCurrentType();
+        }
+
+        const FVideoInfo& GetInfo() const override { return Info; }
+
+        bool ReadFrame(FFrame& Out) override
+        {
+            for (;;)
+            {
+                DWORD Flags = 0;
+                LONGLONG Timestamp = 0;
+                IMFSample* Sample = nullptr;
+                HRESULT Result = Reader->ReadSample
+                (
+                    MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, nullptr, &Flags, &Timestamp, &Sample
+                );
+                if (FAILED(Result) || (Flags & (MF_SOURCE_READERF_ERROR | MF_SOURCE_READERF_ENDOFSTREAM)))
+                {
+                    if (Sample) Sample->Release();
+                    return false;
+                }
+                if (Flags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) ReadCurrentType();
+                if (!Sample) continue; // Stream tick: a gap with no frame
+
+                bool bCopied = CopySample(Sample, Out);
+                Sample->Release();
+                if (!bCopied) return false;
+                Out.Timestamp100ns = Timestamp;
+                return true;
+            }
+        }
+
+        bool Seek(int64_t Position100ns) override
+        {
+            PROPVARIANT Position; PropVariantInit(&Position);
+            Position.vt = VT_I8; Position.hVal.QuadPart = Position100ns;
+            HRESULT Result = Reader->SetCurrentPosition(GUID_NULL, Position);
+            PropVariantClear(&Position);
+            return SUCCEEDED(Result);
+        }
+
+    private:
+        bool IsPqStream()
+        {
+            IMFMediaType* Native = nullptr;
+            if (FAILED(Reader->GetNativeMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, &Native))) return false;
+            UINT32 Transfer = 0;
+            Native->GetUINT32(MF_MT_TRANSFER_FUNCTION, &Transfer);
+            Native->Release();
+            return Transfer == 15; // MFVideoTransFunc_2084, missing from older MinGW headers
+        }
+
+        HRESULT ReadCurrentType()
+        {
+            IMFMediaType* Type = nullptr;
+            HRESULT Result = Reader->GetCurrentMediaType(MF_SOURCE_READER_FIRST_VIDEO_STREAM, &Type);
+            if (FAILED(Result)) return Result;
+
+            UINT32 Width = 0, Height = 0, Numerator = 0, Denominator = 0;
+            GUID Subtype = {};
+            MFGetAttributeSize(Type, MF_MT_FRAME_SIZE, &Width, &Height);
+            Type->GetGUID(MF_MT_SUBTYPE, &Subtype);
+            if
+            (
+                SUCCEEDED(MFGetAttributeRatio(Type, MF_MT_FRAME_RATE, &Numerator, &Denominator)) &&
+                Numerator && Denominator
+            )
+            {
+                Info.FrameRateNumerator = Numerator;
+                Info.FrameRateDenominator = Denominator;
+            }
+            Info.Width = static_cast<int32_t>(Width);
+            Info.Height = static_cast<int32_t>(Height);
+            Info.Format = Subtype == MFVideoFormat_P010 ? EPixelFormat::P010 : EPixelFormat::NV12;
+            Type->Release();
+
+            PROPVARIANT DurationVar; PropVariantInit(&DurationVar);
+            if
+            (
+                SUCCEEDED(Reader->GetPresentationAttribute(MF_SOURCE_READER_MEDIASOURCE, MF_PD_DURATION, &DurationVar))
+            ) Info.Duration100ns = static_cast<int64_t>(DurationVar.uhVal.QuadPart);
+            PropVariantClear(&DurationVar);
+            return S_OK;
+        }
+
+        /** Copies an NV12 or P010 sample into Out, honoring the decoder's pitch and padded plane height. */
+        bool CopySample(IMFSample* Sample, FFrame& Out)
+        {
+            if (Info.Width <= 0 || Info.Height <= 0) return false;
+            IMFMediaBuffer* Buffer = nullptr;
+            if (FAILED(Sample->ConvertToContiguousBuffer(&Buffer))) return false;
+
+            BYTE* Data = nullptr;
+            LONG Pitch = 0;
+            DWORD Length = 0;
+            IMF2DBuffer* Buffer2D = nullptr;
+            if
+            (
+                SUCCEEDED(Buffer->QueryInterface(__uuidof(IMF2DBuffer), reinterpret_cast<void**>(&Buffer2D))) &&
+                FAILED(Buffer2D->Lock2D(&Data, &Pitch))
+            )
+            {
+                Buffer2D->Release();
+                Buffer2D = nullptr;
+            }
+            if (!Buffer2D)
+            {
+                if (FAILED(Buffer->Lock(&Data, nullptr, &Length)))
+                {
+                    Buffer->Release();
+                    return false;
+                }
+                Pitch = Info.Width * BytesPerPixel(Info.Format);
+            }
+            Buffer->GetCurrentLength(&Length);
+
+            // Decoders pad luma to a macroblock multiple; chroma starts after the padding.
+            int32_t PaddedHeight = Pitch > 0 && Length
+                ? static_cast<int32_t>(Length * 2 / (3 * static_cast<DWORD>(Pitch)))
+                : Info.Height;
+            if (PaddedHeight < Info.Height) PaddedHeight = Info.Height;
+
+            size_t RowBytes = static_cast<size_t>(Info.Width) * BytesPerPixel(Info.Format);
+            Out.Allocate(Info.Width, Info.Height, Info.Format);
+            const FFrameView& View = Out.GetView();
+            for (int32_t Row = 0; Row < Info.Height; ++Row)
+            {
+                std::memcpy(View.Row(0, Row), Data + static_cast<ptrdiff_t>(Row) * Pitch, RowBytes);
+            }
+            const BYTE* ChromaData = Data + static_cast<ptrdiff_t>(PaddedHeight) * Pitch;
+            for (int32_t Row = 0; Row < (Info.Height + 1) / 2; ++Row)
+            {
+                std::memcpy(View.Row(1, Row), ChromaData + static_cast<ptrdiff_t>(Row) * Pitch, RowBytes);
+            }
+
+            if (Buffer2D)
+            {
+                Buffer2D->Unlock2D();
+                Buffer2D->Release();
+            }
+            else Buffer->Unlock();
+            Buffer->Release();
+            return true;
+        }
+
+        IMFSourceReader* Reader = nullptr;
+        FVideoInfo Info;
+    };
+
+    /**
+     * Demuxes the video stream without decoding it (no output type is set, so samples
+     * stay compressed) and lists every sample's timestamp and sync flag.
+     */
+    std::vector<FSampleEntry> ReadSampleTable(const std::wstring& Path, const std::atomic<bool>& bCancel)
+    {
+        std::vector<FSampleEntry> Samples;
+        IMFSourceReader* Reader = nullptr;
+        if (FAILED(MFCreateSourceReaderFromURL(Path.c_str(), nullptr, &Reader))) return Samples;
+        Reader->SetStreamSelection(MF_SOURCE_READER_ALL_STREAMS, FALSE);
+        Reader->SetStreamSelection(MF_SOURCE_READER_FIRST_VIDEO_STREAM, TRUE);
+
+        while (!bCancel.load(std::memory_order_relaxed))
+        {
+            DWORD Flags = 0;
+            LONGLONG Timestamp = 0;
+            IMFSample* Sample = nullptr;
+            HRESULT Result = Reader->ReadSample
+            (
+                MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, nullptr, &Flags, &Timestamp, &Sample
+            );
+            if (FAILED(Result) || (Flags & (MF_SOURCE_READERF_ERROR | MF_SOURCE_READERF_ENDOFSTREAM)))
+            {
+                if (Sample) Sample->Release();
+                break;
+            }
+            if (!Sample) continue;
+
+            FSampleEntry Entry;
+            Entry.Timestamp100ns = Timestamp;
+            Entry.bSync = MFGetAttributeUINT32(Sample, MFSampleExtension_CleanPoint, FALSE) != 0;
+            Samples.push_back(Entry);
+            Sample->Release();
+        }
+        Reader->Release();
+        return Samples;
+    }
+
+    /** Win32 side of the software presenter: SetDIBitsToDevice into each wallpaper window. */
+    class FGdiPresenter final : public ISurfacePresenter<HWND>
+    {
+    public:
+        void OnThreadStart() override { ComResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED); }
+        void OnThreadStop() override { if (SUCCEEDED(ComResult)) CoUninitialize(); }
+
+        void Present(const HWND& Window, const FFrameView& View, const std::vector<FIntRect>& Rects) override
+        {
+            if (!Window) return;
+            HDC Dc = GetDC(Window);
+            if (!Dc) return;
+            RESOURCE_ACQUIRE("Software.Present", Gdi);
+            for (const auto& Rect : Rects) Blit(Dc, View.Crop(Rect), Rect.Left, Rect.Top);
+            ReleaseDC(Window, Dc);
+            RESOURCE_RELEASE("Software.Present", Gdi);
+        }
+
+        /** Views are crops of the canvas, so the DIB width is the canvas stride. */
+        static void Blit(HDC Dc, const FFrameView& View, int32_t X, int32_t Y)
+        {
+            if (!View.IsValid()) return;
+
+            BITMAPINFO Bitmap = {};
+            Bitmap.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+            Bitmap.bmiHeader.biWidth = View.Strides[0] / 4;
+            Bitmap.bmiHeader.biHeight = -View.Height; // Top-down
+            Bitmap.bmiHeader.biPlanes = 1;
+            Bitmap.bmiHeader.biBitCount = 32;
+            Bitmap.bmiHeader.biCompression = BI_RGB;
+            SetDIBitsToDevice
+            (
+                Dc, X, Y, View.Width, View.Height,
+                0, 0, 0, View.Height,
+                View.Planes[0], &Bitmap, DIB_RGB_COLORS
+            );
+        }
+
+    private:
+        HRESULT ComResult = E_FAIL;
+    };
+
+    FGdiPresenter GGdiPresenter;
+    using FSoftwarePipeline = TSoftwarePipeline<HWND>;
+
+    /** Set while the software presenter owns the wallpaper windows instead of MFPlay players. */
+    std::unique_ptr<FSoftwarePipeline> GSoftwarePipeline;
+
+    /** Steps the software presenter along PresenterQualityLevels from its measured load. */
+    FQualityController GPresenterQuality;
+
     class FMediaPlayerCallback final : public IMFPMediaPlayerCallback
     {
     public:
         explicit FMediaPlayerCallback(int32_t InMonitorIndex) 
-            : MonitorIndex(InMonitorIndex) {}
+            : MonitorIndex(InMonitorIndex)
+        {
+            RESOURCE_ACQUIRE("PlayerCallback", ComRef);
+        }
 
         STDMETHODIMP QueryInterface(REFIID Riid, void** OutPv) override
         {
@@ -334,9 +1023,14 @@ namespace
             }
             *OutPv = nullptr; return E_NOINTERFACE;
         }
-        STDMETHODIMP_(ULONG) AddRef()  override { return InterlockedIncrement(&RefCount); }
+        STDMETHODIMP_(ULONG) AddRef()  override
+        {
+            RESOURCE_ACQUIRE("PlayerCallback", ComRef);
+            return InterlockedIncrement(&RefCount);
+        }
         STDMETHODIMP_(ULONG) Release() override
         {
+            RESOURCE_RELEASE("PlayerCallback", ComRef);
             ULONG Count = InterlockedDecrement(&RefCount);
             if (!Count) delete this;
             return Count;
@@ -347,14 +1041,32 @@ namespace
             if (!Header) return;
             if (MonitorIndex < 0 || MonitorIndex >= static_cast<int32_t>(GMonitors.size())) return;
 
+            // Events queued by a player that has since been torn down must not
+            // reach whichever player now occupies the same monitor slot.
             auto* Player = GMonitors[MonitorIndex].Player;
-            if (!Player) return;
+            if (!Player || Header->pMediaPlayer != Player) return;
 
             switch (Header->eEventType)
             {
+            case MFP_EVENT_TYPE_MEDIAITEM_CREATED:
+            {
+                auto* Event = reinterpret_cast<MFP_MEDIAITEM_CREATED_EVENT*>(Header);
+                HRESULT Result = Header->hrEvent;
+                if (SUCCEEDED(Result))
+                {
+                    Result = Event->pMediaItem ? Player->SetMediaItem(Event->pMediaItem) : E_POINTER;
+                }
+                if (FAILED(Result)) OnPipelineFailed(MonitorIndex, Result);
+                break;
+            }
             case MFP_EVENT_TYPE_MEDIAITEM_SET:
             {
-                Log(L"Monitor " + std::to_wstring(MonitorIndex) + L": Playing.");
+                if (FAILED(Header->hrEvent))
+                {
+                    OnPipelineFailed(MonitorIndex, Header->hrEvent);
+                    break;
+                }
+                Log(L"Monitor " + std::to_wstring(MonitorIndex) + L": Media item set.");
                 auto* Event = reinterpret_cast<MFP_MEDIAITEM_SET_EVENT*>(Header);
                 if (Event->pMediaItem)
                 {
@@ -373,7 +1085,6 @@ namespace
 
                     PropVariantClear(&DurationVar);
                 }
-                Player->Play();
                 Player->UpdateVideo();
 
                 // Fix: disable letterboxing — stretch video to fill the window
@@ -385,22 +1096,36 @@ namespace
                         __uuidof(IMFVideoDisplayControl),
                         reinterpret_cast<void**>(&pVDC))))
                     {
+                        RESOURCE_ACQUIRE("DisplayControl", ComRef);
                         pVDC->SetAspectRatioMode(MFVideoARMode_None);
                         pVDC->Release();
+                        RESOURCE_RELEASE("DisplayControl", ComRef);
                     }
                 }
+
+                SIZE NativeSize = {};
+                if (SUCCEEDED(Player->GetNativeVideoSize(&NativeSize, nullptr)))
+                {
+                    GMonitors[MonitorIndex].VideoSize = NativeSize;
+                    if (GConfig.bSpanMode) ApplySpanViewports();
+                }
+                OnPipelineReady(MonitorIndex);
                 break;
             }
             case MFP_EVENT_TYPE_PLAYBACK_ENDED:
+            {
+                TRACE_INSTANT("PlaybackEndedLoop", MonitorIndex);
                 Log(L"Monitor " + std::to_wstring(MonitorIndex) + L": Looping.");
-                {
-                    PROPVARIANT Position; PropVariantInit(&Position);
-                    Position.vt = VT_I8; Position.hVal.QuadPart = 0;
-                    Player->SetPosition(MFP_POSITIONTYPE_100NS, &Position);
-                    PropVariantClear(&Position);
-                    Player->Play();
-                }
+                // Ran off the end ahead of the synchronized loop. Just before the wrap it starts
+                // over now and the loop lines it up; otherwise it rejoins the master timeline.
+                int64_t NowNs = MasterClockNowNs();
+                int64_t TimeToWrapNs = GMasterClock.GetTimeToWrapNs(NowNs);
+                bool bNearWrap = TimeToWrapNs >= 0 && TimeToWrapNs < DriftHardSeek100ns * 100;
+                SeekPlayer(Player, bNearWrap ? 0 : GMasterClock.GetPosition100ns(NowNs));
+                GMonitors[MonitorIndex].Drift.Reset();
+                Player->Play();
                 break;
+            }
             default: break;
             }
 
@@ -479,6 +1204,22 @@ namespace
         );
     }
 
+    /** Extended-style bits the classification depends on; reading them is a local call, not a round trip. */
+    uint32_t GetClassifiedStyle(HWND Hwnd)
+    {
+        return static_cast<uint32_t>(GetWindowLongPtrW(Hwnd, GWL_EXSTYLE) & WS_EX_TOOLWINDOW);
+    }
+
+    /** Slow path for GWindowCache misses: the per-window queries the scan used to run every tick. */
+    FWindowClassInfo ClassifyWindow(HWND Hwnd)
+    {
+        FWindowClassInfo Info;
+        Info.Category = IsShellWindow(Hwnd) ? EWindowCategory::Shell : EWindowCategory::Normal;
+        Info.bToolWindow = (GetClassifiedStyle(Hwnd) & WS_EX_TOOLWINDOW) != 0;
+        Info.bCloaked = IsWindowCloaked(Hwnd);
+        return Info;
+    }
+
     /** EnumWindows callback — sets bOccluded to true if any window covers the desktop. */
     BOOL CALLBACK OcclusionEnumProc(HWND Hwnd, LPARAM LParam)
     {
@@ -487,18 +1228,7 @@ namespace
         if (!IsWindowVisible(Hwnd)) return TRUE;
         if (IsIconic(Hwnd)) return TRUE;
 
-
-        LONG_PTR ExStyle = GetWindowLongPtrW(Hwnd, GWL_EXSTYLE);
-        if (ExStyle & WS_EX_TOOLWINDOW) return TRUE;
-
-        if (IsWindowCloaked(Hwnd)) return TRUE;
-
-        if (IsShellWindow(Hwnd)) return TRUE;
-
-        for (const auto& Monitor : GMonitors)
-        {
-            if (Monitor.Window == Hwnd) return TRUE;
-        }
+        if (GWindowCache.Lookup(Hwnd, GetClassifiedStyle(Hwnd), ClassifyWindow).IsIgnored()) return TRUE;
 
         if (IsWindowCoveringMonitor(Hwnd))
         {
@@ -512,27 +1242,82 @@ namespace
     /** Checks whether ANY visible top-level window fully covers a monitor. */
     bool IsDesktopOccluded()
     {
+        TRACE_SCOPE("OcclusionScan");
         bool bOccluded = false;
         EnumWindows(OcclusionEnumProc, reinterpret_cast<LPARAM>(&bOccluded));
+        TRACE_COUNTER("WindowCacheSize", static_cast<int64_t>(GWindowCache.Size()));
         return bOccluded;
     }
+
+    /** Drops a window's cached classification when anything it depends on may have changed. */
+    void CALLBACK WindowCacheEventProc
+    (
+        HWINEVENTHOOK, DWORD, HWND Hwnd, LONG ObjectId, LONG ChildId, DWORD, DWORD
+    )
+    {
+        if (!Hwnd || ObjectId != OBJID_WINDOW || ChildId != CHILDID_SELF) return;
+        GWindowCache.Invalidate(Hwnd);
+    }
+
+    // Create/destroy/show/hide and STATECHANGE cover visibility and state; CLOAKED/UNCLOAKED
+    // track DWM cloaking. No event reports style changes, so lookups compare the style bits.
+    void InstallWindowCacheHooks()
+    {
+        GWindowCacheHooks[0] = SetWinEventHook
+        (
+            EVENT_OBJECT_CREATE, EVENT_OBJECT_HIDE,
+            nullptr, WindowCacheEventProc, 0, 0, WINEVENT_OUTOFCONTEXT
+        );
+        GWindowCacheHooks[1] = SetWinEventHook
+        (
+            EVENT_OBJECT_STATECHANGE, EVENT_OBJECT_STATECHANGE,
+            nullptr, WindowCacheEventProc, 0, 0, WINEVENT_OUTOFCONTEXT
+        );
+        GWindowCacheHooks[2] = SetWinEventHook
+        (
+            EVENT_OBJECT_CLOAKED, EVENT_OBJECT_UNCLOAKED,
+            nullptr, WindowCacheEventProc, 0, 0, WINEVENT_OUTOFCONTEXT
+        );
+
+        bool bAllHooked = GWindowCacheHooks[0] && GWindowCacheHooks[1] && GWindowCacheHooks[2];
+        GWindowCache.SetEnabled(bAllHooked);
+        if (!bAllHooked) Log(L"WinEvent hooks unavailable; window classification cache disabled.");
+    }
+
+    void RemoveWindowCacheHooks()
+    {
+        for (auto& Hook : GWindowCacheHooks)
+        {
+            if (Hook) UnhookWinEvent(Hook);
+            Hook = nullptr;
+        }
+        GWindowCache.InvalidateAll();
+    }
 }
 
 LRESULT CALLBACK WallpaperWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LParam)
 {
     switch (Msg)
     {
-    case WM_ERASEBKGND:
+    case WM_CREATE:
+        RESOURCE_ACQUIRE("Wallpaper", Window);
+        return 0;
+    case WM_ERASEBKGND:
         return 1;
     case WM_PAINT:
     {
         PAINTSTRUCT PaintStruct;
-        BeginPaint(Hwnd, &PaintStruct);
+        HDC Dc = BeginPaint(Hwnd, &PaintStruct);
+        if (GSoftwarePipeline)
+        {
+            GSoftwarePipeline->Paint(Hwnd, [Dc](const FFrameView& View) { FGdiPresenter::Blit(Dc, View, 0, 0); });
+        }
         EndPaint(Hwnd, &PaintStruct);
         for (auto& Monitor : GMonitors)
         {
             if (Monitor.Window == Hwnd && Monitor.Player)
             {
+                TRACE_SCOPE("UpdateVideo.Paint");
                 Monitor.Player->UpdateVideo();
             }
         }
@@ -544,16 +1329,23 @@ LRESULT CALLBACK WallpaperWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LPa
         {
             if (Monitor.Window == Hwnd && Monitor.Player)
             {
+                TRACE_SCOPE("UpdateVideo.Size");
                 Monitor.Player->UpdateVideo();
             }
         }
             
+        return 0;
+    case WM_DESTROY:
+        RESOURCE_RELEASE("Wallpaper", Window);
+        OnWallpaperWindowDestroyed(Hwnd);
         return 0;
     }
     return DefWindowProcW(Hwnd, Msg, WParam, LParam);
 }
 
 #define WM_TRAYICON (WM_USER + 1)
+#define WM_CONTROL_REQUEST (WM_USER + 2)
+#define WM_CONTROL_SERVER_ERROR (WM_USER + 3)
 #define ID_TRAY_QUIT 1001
 #define ID_TRAY_PAUSE 1002
 #define ID_TRAY_MUTE 1003
@@ -613,21 +1405,525 @@ namespace
         );
         DestroyMenu(Menu);
     }
+
+    /** The synchronized loop at the master's wrap: every player jumps to the start of the shared loop together. */
+    void LoopAllPlayers()
+    {
+        TRACE_SCOPE("PreSeek");
+        LONGLONG Target = GMasterClock.GetPosition100ns(MasterClockNowNs());
+        for (auto& Monitor : GMonitors)
+        {
+            if (!Monitor.Player || Monitor.Duration <= 0 || Monitor.bLowPower || Monitor.bDormant) continue;
+            SeekPlayer(Monitor.Player, Target);
+            Monitor.Drift.Reset();
+        }
+        Log(L"Synchronized loop triggered.");
+    }
+
+    /**
+     * Trims each player's rate toward the master clock (hard seek only on large drift)
+     * and, when the loop boundary falls before the next tick, arms a one-shot timer for it.
+     */
+    void SyncPlayersToMasterClock(HWND Hwnd)
+    {
+        if (!GMasterClock.IsRunning() || GMasterClock.IsPaused()) return;
+
+        static const char* DriftCounterNames[] =
+        {
+            "DriftUs.Monitor0", "DriftUs.Monitor1", "DriftUs.Monitor2", "DriftUs.Monitor3",
+            "DriftUs.Monitor4", "DriftUs.Monitor5", "DriftUs.Monitor6", "DriftUs.Monitor7"
+        };
+
+        int64_t NowNs = MasterClockNowNs();
+        int64_t MasterPos = GMasterClock.GetPosition100ns(NowNs);
+        int64_t LoopLength = GMasterClock.GetLoopLength100ns();
+
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+        {
+            auto& Monitor = GMonitors[Index];
+            if (!Monitor.Player || Monitor.Duration <= 0 || Monitor.bLowPower || Monitor.bDormant) continue;
+
+            PROPVARIANT Position; PropVariantInit(&Position);
+            if (SUCCEEDED(Monitor.Player->GetPosition(MFP_POSITIONTYPE_100NS, &Position)))
+            {
+                FDriftCorrection Correction = Monitor.Drift.Update
+                (
+                    MasterPos, Position.hVal.QuadPart, LoopLength
+                );
+                if (Index < sizeof(DriftCounterNames) / sizeof(DriftCounterNames[0]))
+                {
+                    TRACE_COUNTER(DriftCounterNames[Index], Correction.Drift100ns / 10);
+                }
+
+                if (Correction.bSeek)
+                {
+                    SeekPlayer(Monitor.Player, Correction.SeekTarget100ns);
+                    Log
+                    (
+                        L"Monitor " + std::to_wstring(Index) + L": drift "
+                        + std::to_wstring(Correction.Drift100ns / 10000) + L"ms, resynced by seek."
+                    );
+                }
+                else if
+                (
+                    std::fabs(Correction.Rate - Monitor.Rate) > RateChangeEpsilon &&
+                    SUCCEEDED(Monitor.Player->SetRate(static_cast<float>(Correction.Rate)))
+                ) Monitor.Rate = Correction.Rate;
+            }
+            PropVariantClear(&Position);
+        }
+
+        // The tick is too coarse to hit the loop boundary; schedule it precisely instead.
+        int64_t TimeToWrapNs = GMasterClock.GetTimeToWrapNs(NowNs);
+        if (TimeToWrapNs >= 0 && TimeToWrapNs < static_cast<int64_t>(TimerIntervalMs) * 1000000LL)
+        {
+            SetTimer(Hwnd, TimerIdLoop, static_cast<UINT>(TimeToWrapNs / 1000000) + 1, nullptr);
+        }
+    }
+
+    /**
+     * Reads the sample table on a worker thread; the low-power schedule and the ping-pong
+     * keyframes are taken from it once it arrives (PollKeyframeIndex). Only one encode is
+     * indexed; renditions encoded together share their keyframe times.
+     */
+    void StartKeyframeIndexing()
+    {
+        if (GConfig.LowPower == ELowPowerScope::Off && GConfig.Loop != ELoopMode::PingPong) return;
+        GbCancelKeyframeIndex = false;
+        GbKeyframeIndexPending = true;
+        std::wstring Path = GetIndexedVideoPath();
+        GKeyframeIndexTask.Run([Path]()
+        {
+            GQos.EnterThread(EWorkClass::Maintenance);
+            HRESULT ComResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+            GKeyframeIndex.Build(ReadSampleTable(Path, GbCancelKeyframeIndex));
+            if (SUCCEEDED(ComResult)) CoUninitialize();
+        });
+    }
+
+    void StopKeyframeIndexing()
+    {
+        GbCancelKeyframeIndex = true;
+        GKeyframeIndexTask.Join();
+        GbKeyframeIndexPending = false;
+        GLowPowerSteps.clear();
+    }
+
+    void PollKeyframeIndex()
+    {
+        if (!GbKeyframeIndexPending || !GKeyframeIndexTask.WaitFor(std::chrono::milliseconds(0))) return;
+        GKeyframeIndexTask.Join();
+        GbKeyframeIndexPending = false;
+        if (GPingPongKeyframes) GPingPongKeyframes->Set(GKeyframeIndex.GetSyncTimestamps());
+        if (GSoftwarePipeline) return; // Low-power stepping drives EVR players only
+        GLowPowerSteps = GKeyframeIndex.Select(GConfig.Subsample);
+
+        int32_t MaxCost = 0;
+        for (const auto& Step : GLowPowerSteps) MaxCost = Step.DecodeCost > MaxCost ? Step.DecodeCost : MaxCost;
+        Log
+        (
+            L"Keyframe index: " + std::to_wstring(GKeyframeIndex.GetSampleCount()) + L" samples, "
+            + std::to_wstring(GKeyframeIndex.GetSyncCount()) + L" keyframes; low-power schedule has "
+            + std::to_wstring(GLowPowerSteps.size()) + L" frames (max decode cost "
+            + std::to_wstring(MaxCost) + L")."
+        );
+    }
+
+    void ConfigureMemoryGovernor()
+    {
+        FMemoryGovernorSettings Settings;
+        Settings.CeilingBytes = GConfig.MemoryCeilingBytes;
+        GMemoryGovernor.Configure(Settings);
+    }
+
+    /** A trim outside the governor (after a pipeline starts or stops); counted so its own trims keep their spacing. */
+    void TrimWorkingSet()
+    {
+        EmptyWorkingSet(GetCurrentProcess());
+        GMemoryGovernor.NoteTrim();
+    }
+
+    /** Once per tick: feeds the governor and carries out its cache level changes and trims. */
+    void UpdateMemoryGovernor()
+    {
+        PROCESS_MEMORY_COUNTERS Memory = {};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &Memory, sizeof(Memory))) return;
+        FMemorySample Sample;
+        Sample.ResidentBytes = static_cast<int64_t>(Memory.WorkingSetSize);
+        Sample.CacheBytes = GSoftwarePipeline ? GSoftwarePipeline->GetCacheBytes() : 0;
+        Sample.bIdle = GbPaused || GbAutoPausedByFullscreen || !GLifecycle.IsAnyActive() || !GShellAttach.IsAttached();
+        BOOL bLowMemory = FALSE;
+        Sample.bLowMemory = GLowMemoryNotification
+            && QueryMemoryResourceNotification(GLowMemoryNotification, &bLowMemory) && bLowMemory;
+
+        FMemoryDecision Decision = GMemoryGovernor.Update(Sample);
+        std::wstring Reason = AsciiToWide(GetMemoryReasonName(Decision.Reason));
+        if (Decision.bCacheLevelChanged)
+        {
+            TRACE_INSTANT("Memory.CacheLevel", Decision.CacheLevel);
+            if (GSoftwarePipeline) GSoftwarePipeline->SetCacheLevel(Decision.CacheLevel);
+            Log
+            (
+                L"Memory: cache level " + std::to_wstring(Decision.CacheLevel) + L" (" + Reason + L"; working set "
+                + std::to_wstring(Sample.ResidentBytes / (1024 * 1024)) + L" MB, caches "
+                + std::to_wstring(Sample.CacheBytes / (1024 * 1024)) + L" MB)."
+            );
+        }
+        if (Decision.bTrimWorkingSet)
+        {
+            TRACE_INSTANT("Memory.Trim", Sample.ResidentBytes / (1024 * 1024));
+            EmptyWorkingSet(GetCurrentProcess());
+            Log(L"Memory: working set trimmed from " + std::to_wstring(Sample.ResidentBytes / (1024 * 1024)) + L" MB (" + Reason + L").");
+        }
+    }
+
+    // Layouts and classes from processthreadsapi.h and winnt.h, which old MinGW headers lack.
+    struct FPowerThrottlingState
+    {
+        ULONG Version;
+        ULONG ControlMask;
+        ULONG StateMask;
+    };
+    constexpr ULONG PowerThrottlingCurrentVersion = 1;
+    constexpr ULONG PowerThrottlingExecutionSpeed = 0x1;
+    constexpr int ThreadPowerThrottlingClass = 3;
+    constexpr int ProcessPowerThrottlingClass = 4;
+    constexpr DWORD CpuSetInformationType = 0;
+
+    struct FSystemCpuSet
+    {
+        DWORD Size;
+        DWORD Type;
+        DWORD Id;
+        WORD Group;
+        BYTE LogicalProcessorIndex;
+        BYTE CoreIndex;
+        BYTE LastLevelCacheIndex;
+        BYTE NumaNodeIndex;
+        BYTE EfficiencyClass;
+        BYTE Flags;
+        DWORD Reserved;
+        DWORD64 AllocationTag;
+    };
+
+    /**
+     * qos.h levels on Windows. EcoQoS (power throttling) needs Windows 11 to pick the
+     * efficiency cores and clock, CPU sets Windows 10; both are loaded at run time and
+     * skipped where missing, leaving thread priorities and the priority class.
+     *   idle        EcoQoS, THREAD_PRIORITY_IDLE; the process at IDLE_PRIORITY_CLASS
+     *   background  EcoQoS, THREAD_PRIORITY_BELOW_NORMAL; BELOW_NORMAL_PRIORITY_CLASS
+     *   normal      throttling left to the system, THREAD_PRIORITY_NORMAL; NORMAL_PRIORITY_CLASS
+     * The process part covers Media Foundation's own threads, which the EVR presenter
+     * cannot register.
+     */
+    struct FWindowsQos
+    {
+        typedef BOOL(WINAPI* SetThreadInformation_t)(HANDLE, int, LPVOID, DWORD);
+        typedef BOOL(WINAPI* SetProcessInformation_t)(HANDLE, int, LPVOID, DWORD);
+        typedef BOOL(WINAPI* GetSystemCpuSetInformation_t)(PVOID, ULONG, PULONG, HANDLE, ULONG);
+        typedef BOOL(WINAPI* SetThreadSelectedCpuSets_t)(HANDLE, const ULONG*, ULONG);
+
+        SetThreadInformation_t SetThreadInformationFn = nullptr;
+        SetProcessInformation_t SetProcessInformationFn = nullptr;
+        SetThreadSelectedCpuSets_t SetThreadSelectedCpuSetsFn = nullptr;
+        std::vector<ULONG> EfficiencyCpuSets;   // Lowest efficiency class, when the CPU has more than one
+
+        void Load()
+        {
+            HMODULE Kernel32 = GetModuleHandleW(L"kernel32.dll");
+            if (!Kernel32) return;
+            SetThreadInformationFn = reinterpret_cast<SetThreadInformation_t>(GetProcAddress(Kernel32, "SetThreadInformation"));
+            SetProcessInformationFn = reinterpret_cast<SetProcessInformation_t>(GetProcAddress(Kernel32, "SetProcessInformation"));
+            SetThreadSelectedCpuSetsFn = reinterpret_cast<SetThreadSelectedCpuSets_t>(GetProcAddress(Kernel32, "SetThreadSelectedCpuSets"));
+            auto GetCpuSetsFn = reinterpret_cast<GetSystemCpuSetInformation_t>(GetProcAddress(Kernel32, "GetSystemCpuSetInformation"));
+            if (!GetCpuSetsFn || !SetThreadSelectedCpuSetsFn) return;
+
+            ULONG Length = 0;
+            GetCpuSetsFn(nullptr, 0, &Length, GetCurrentProcess(), 0);
+            std::vector<uint8_t> Buffer(Length);
+            if (!Length || !GetCpuSetsFn(Buffer.data(), Length, &Length, GetCurrentProcess(), 0)) return;
+            std::vector<FSystemCpuSet> CpuSets;
+            for (ULONG Offset = 0; Offset + sizeof(FSystemCpuSet) <= Length;)
+            {
+                FSystemCpuSet CpuSet;
+                std::memcpy(&CpuSet, Buffer.data() + Offset, sizeof(CpuSet));
+                if (!CpuSet.Size) break;
+                if (CpuSet.Type == CpuSetInformationType) CpuSets.push_back(CpuSet);
+                Offset += CpuSet.Size;
+            }
+            if (CpuSets.empty()) return;
+            BYTE Lowest = CpuSets[0].EfficiencyClass;
+            BYTE Highest = Lowest;
+            for (const FSystemCpuSet& CpuSet : CpuSets)
+            {
+                Lowest = CpuSet.EfficiencyClass < Lowest ? CpuSet.EfficiencyClass : Lowest;
+                Highest = CpuSet.EfficiencyClass > Highest ? CpuSet.EfficiencyClass : Highest;
+            }
+            if (Lowest == Highest) return;  // All cores alike
+            for (const FSystemCpuSet& CpuSet : CpuSets)
+            {
+                if (CpuSet.EfficiencyClass == Lowest) EfficiencyCpuSets.push_back(CpuSet.Id);
+            }
+        }
+
+        static FPowerThrottlingState GetThrottling(EQosLevel Level)
+        {
+            // Normal clears the control mask: the system decides, as for any other thread.
+            FPowerThrottlingState State = { PowerThrottlingCurrentVersion, 0, 0 };
+            if (Level != EQosLevel::Normal)
+            {
+                State.ControlMask = PowerThrottlingExecutionSpeed;
+                State.StateMask = PowerThrottlingExecutionSpeed;
+            }
+            return State;
+        }
+
+        bool ApplyThread(uint64_t ThreadId, EQosLevel Level, bool bEfficiencyCores) const
+        {
+            HANDLE Thread = OpenThread
+            (
+                THREAD_SET_INFORMATION | THREAD_SET_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(ThreadId)
+            );
+            if (!Thread) return false;
+            int Priority = Level == EQosLevel::Idle ? THREAD_PRIORITY_IDLE
+                         : Level == EQosLevel::Background ? THREAD_PRIORITY_BELOW_NORMAL
+                         : THREAD_PRIORITY_NORMAL;
+            bool bOk = SetThreadPriority(Thread, Priority) != FALSE;
+            if (SetThreadInformationFn)
+            {
+                FPowerThrottlingState State = GetThrottling(Level);
+                // Fails before Windows 10 1709, which knows no thread throttling: priority alone then.
+                SetThreadInformationFn(Thread, ThreadPowerThrottlingClass, &State, sizeof(State));
+            }
+            if (SetThreadSelectedCpuSetsFn && !EfficiencyCpuSets.empty())
+            {
+                bool bPin = bEfficiencyCores && Level != EQosLevel::Normal;
+                bOk &= SetThreadSelectedCpuSetsFn
+                (
+                    Thread,
+                    bPin ? EfficiencyCpuSets.data() : nullptr,
+                    bPin ? static_cast<ULONG>(EfficiencyCpuSets.size()) : 0
+                ) != FALSE;
+            }
+            CloseHandle(Thread);
+            return bOk;
+        }
+
+        bool ApplyProcess(EQosLevel Level) const
+        {
+            DWORD PriorityClass = Level == EQosLevel::Idle ? IDLE_PRIORITY_CLASS
+                                : Level == EQosLevel::Background ? BELOW_NORMAL_PRIORITY_CLASS
+                                : NORMAL_PRIORITY_CLASS;
+            bool bOk = SetPriorityClass(GetCurrentProcess(), PriorityClass) != FALSE;
+            if (SetProcessInformationFn)
+            {
+                FPowerThrottlingState State = GetThrottling(Level);
+                SetProcessInformationFn(GetCurrentProcess(), ProcessPowerThrottlingClass, &State, sizeof(State));
+            }
+            return bOk;
+        }
+
+        FQosBackend MakeBackend() const
+        {
+            FQosBackend Backend;
+            Backend.GetCurrentThreadId = [] { return static_cast<uint64_t>(GetCurrentThreadId()); };
+            Backend.ApplyThread = [this](uint64_t Thread, EQosLevel Level, bool bEfficiencyCores, bool)
+            {
+                return ApplyThread(Thread, Level, bEfficiencyCores);
+            };
+            Backend.ApplyProcess = [this](EQosLevel Level) { return ApplyProcess(Level); };
+            return Backend;
+        }
+    };
+    FWindowsQos GWindowsQos;
+
+    /**
+     * Hands the configured priority to GQos. The first call installs the backend and
+     * registers the UI thread as interactive (background at most, never idle); later ones (vwctl set priority) re-apply to every
+     * registered thread.
+     */
+    void ConfigureQos()
+    {
+        static bool bInstalled = false;
+        if (!bInstalled)
+        {
+            GWindowsQos.Load();
+            GQos.SetBackend(GWindowsQos.MakeBackend());
+            GQos.EnterThread(EWorkClass::Interactive);
+            bInstalled = true;
+        }
+        GQos.SetPolicy(FQosPolicy::FromPriority(GConfig.Priority, GConfig.bEfficiencyCores));
+        Log
+        (
+            L"Scheduling: " + AsciiToWide(GetQosLevelName(GConfig.Priority))
+            + (GConfig.bEfficiencyCores ? L" on " + std::to_wstring(GWindowsQos.EfficiencyCpuSets.size()) + L" efficiency core(s)" : L"")
+            + (GWindowsQos.SetThreadInformationFn ? L", EcoQoS" : L", no EcoQoS") + L"."
+        );
+    }
+
+    bool IsOnBattery()
+    {
+        SYSTEM_POWER_STATUS Status = {};
+        return GetSystemPowerStatus(&Status) && Status.ACLineStatus == 0;
+    }
+
+    bool WantsLowPower(const FMonitorWallpaper& Monitor, bool bOnBattery)
+    {
+        if (GLowPowerSteps.empty()) return false;
+        switch (GConfig.LowPower)
+        {
+        case ELowPowerScope::All: return true;
+        // The primary monitor is the one at the virtual-desktop origin.
+        case ELowPowerScope::Secondary: return Monitor.Rect.left != 0 || Monitor.Rect.top != 0;
+        case ELowPowerScope::Battery: return bOnBattery;
+        default: return false;
+        }
+    }
+
+    /** Moves monitors in and out of low-power playback as the schedule, scope or power source changes. */
+    void UpdateLowPowerMonitors()
+    {
+        bool bOnBattery = GConfig.LowPower == ELowPowerScope::Battery && IsOnBattery();
+        bool bPlaying = !GbPaused && !GbAutoPausedByFullscreen;
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+        {
+            auto& Monitor = GMonitors[Index];
+            if (!Monitor.Player || Monitor.Duration <= 0) continue;
+            bool bWanted = WantsLowPower(Monitor, bOnBattery);
+            if (bWanted == Monitor.bLowPower) continue;
+
+            Monitor.bLowPower = bWanted;
+            Monitor.LowPowerStep = SIZE_MAX;
+            if (bWanted) Monitor.Player->Pause();
+            else
+            {
+                // Rejoin continuous playback on the master timeline.
+                SeekPlayer(Monitor.Player, GMasterClock.GetPosition100ns(MasterClockNowNs()));
+                Monitor.Drift.Reset();
+                if (bPlaying && !Monitor.bDormant) Monitor.Player->Play();
+            }
+            Log(L"Monitor " + std::to_wstring(Index) + (bWanted ? L": low-power playback." : L": full playback."));
+        }
+    }
+
+    /**
+     * Low-power monitors stay paused and are seeked to the scheduled frame for the
+     * master position; a paused seek decodes only what reaching that frame needs.
+     */
+    void StepLowPowerMonitors(HWND Hwnd)
+    {
+        if (GLowPowerSteps.empty() || !GMasterClock.IsRunning() || GMasterClock.IsPaused()) return;
+
+        int64_t MasterPos = GMasterClock.GetPosition100ns(MasterClockNowNs());
+        size_t Step = FKeyframeIndex::FindStep(GLowPowerSteps, MasterPos);
+        bool bAnyLowPower = false;
+        for (auto& Monitor : GMonitors)
+        {
+            if (!Monitor.Player || !Monitor.bLowPower || Monitor.bDormant) continue;
+            bAnyLowPower = true;
+            if (Monitor.LowPowerStep == Step) continue;
+            TRACE_INSTANT("LowPowerStep", static_cast<int64_t>(Step));
+            SeekPlayer(Monitor.Player, GLowPowerSteps[Step].Timestamp100ns);
+            Monitor.LowPowerStep = Step;
+        }
+
+        // Steps may be closer together than the tick; wake up exactly for the next one.
+        if (!bAnyLowPower || Step + 1 >= GLowPowerSteps.size()) return;
+        int64_t UntilNext100ns = GLowPowerSteps[Step + 1].Timestamp100ns - MasterPos;
+        if (UntilNext100ns >= 0 && UntilNext100ns < static_cast<int64_t>(TimerIntervalMs) * 10000LL)
+        {
+            SetTimer(Hwnd, TimerIdLowPower, static_cast<UINT>(UntilNext100ns / 10000) + 1, nullptr);
+        }
+    }
 }
 
 LRESULT CALLBACK MessageWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LParam)
 {
+    if (GMsgTaskbarCreated && Msg == GMsgTaskbarCreated)
+    {
+        // Explorer (re)started: the tray icon is gone, and the wallpaper windows may be too.
+        Log(L"Shell restarted.");
+        AddTrayIcon(Hwnd);
+        RunShellAttachAction(GShellAttach.OnShellRestarted(static_cast<int64_t>(GetTickCount64())));
+        return 0;
+    }
+
     switch (Msg)
     {
     case WM_CREATE:
+        GMsgTaskbarCreated = RegisterWindowMessageW(L"TaskbarCreated");
         RegisterHotKey(Hwnd, 1, MOD_CONTROL | MOD_ALT, 'Q');
         RegisterHotKey(Hwnd, 2, MOD_CONTROL | MOD_ALT, 'P');
+        RegisterHotKey(Hwnd, 3, MOD_CONTROL | MOD_ALT, 'T');
         SetTimer(Hwnd, TimerIdUpdate, TimerIntervalMs, nullptr);
         AddTrayIcon(Hwnd);
+        InstallWindowCacheHooks();
+        // Both report the current state right away, so a start on a locked or dark console is handled too.
+        WTSRegisterSessionNotification(Hwnd, NOTIFY_FOR_THIS_SESSION);
+        GDisplayStateNotify = RegisterPowerSettingNotification
+        (
+            Hwnd, &LOCAL_GUID_CONSOLE_DISPLAY_STATE, DEVICE_NOTIFY_WINDOW_HANDLE
+        );
+        StartControlServer(Hwnd);
+        GLowMemoryNotification = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+        if (GLowMemoryNotification) RESOURCE_ACQUIRE("MemoryGovernor", Handle);
+        return 0;
+    case WM_CONTROL_REQUEST:
+    {
+        auto* Exchange = reinterpret_cast<FControlExchange*>(LParam);
+        Exchange->Response = HandleControlRequest(*Exchange->Request);
+        return 0;
+    }
+    case WM_CONTROL_SERVER_ERROR:
+        // Posted by the server thread, which cannot write the log itself.
+        Log
+        (
+            WParam == ERROR_ACCESS_DENIED
+                ? L"Control endpoint: " + GetControlPipeName() + L" is held by another process; vwctl cannot reach this instance."
+                : L"Control endpoint: cannot create " + GetControlPipeName() + L" (error " + std::to_wstring(WParam) + L"); retrying."
+        );
         return 0;
+    case WM_WTSSESSION_CHANGE:
+        switch (WParam)
+        {
+        case WTS_SESSION_LOCK: OnSessionEvent(ESessionEvent::Lock); break;
+        case WTS_SESSION_UNLOCK: OnSessionEvent(ESessionEvent::Unlock); break;
+        case WTS_CONSOLE_DISCONNECT:
+        case WTS_REMOTE_DISCONNECT: OnSessionEvent(ESessionEvent::Disconnect); break;
+        case WTS_CONSOLE_CONNECT:
+        case WTS_REMOTE_CONNECT: OnSessionEvent(ESessionEvent::Connect); break;
+        }
+        return 0;
+    case WM_POWERBROADCAST:
+        if (WParam == PBT_POWERSETTINGCHANGE)
+        {
+            const auto* Setting = reinterpret_cast<const POWERBROADCAST_SETTING*>(LParam);
+            if (Setting && Setting->PowerSetting == LOCAL_GUID_CONSOLE_DISPLAY_STATE && Setting->DataLength >= sizeof(DWORD))
+            {
+                // 0 = off, 1 = on, 2 = dimmed. Only the console as a whole is reported.
+                DWORD State = *reinterpret_cast<const DWORD*>(Setting->Data);
+                OnDisplayPower(State == 0 ? EDisplayPower::Off : State == 2 ? EDisplayPower::Dimmed : EDisplayPower::On);
+            }
+        }
+        return TRUE;
     case WM_HOTKEY:
         if (WParam == 1) DestroyWindow(Hwnd);
         if (WParam == 2) SendMessageW(Hwnd, WM_COMMAND, ID_TRAY_PAUSE, 0);
+        if (WParam == 3)
+        {
+            // Toggle tracing; stopping dumps what was captured since it started.
+            if (GTrace.IsEnabled())
+            {
+                GTrace.SetEnabled(false);
+                DumpTrace();
+            }
+            else
+            {
+                GTrace.Clear();
+                GTrace.SetEnabled(true);
+                Log(L"Tracing started.");
+            }
+        }
         return 0;
     case WM_TRAYICON:
         if (LOWORD(LParam) == WM_RBUTTONUP || LOWORD(LParam) == WM_CONTEXTMENU)
@@ -642,10 +1938,16 @@ LRESULT CALLBACK MessageWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LPara
         case ID_TRAY_PAUSE:
             GbPaused = !GbPaused;
             GbAutoPausedByFullscreen = false;
+            TRACE_INSTANT(GbPaused ? "Pause.User" : "Resume.User", 0);
+            // Presentation is already suspended; re-attaching honours the new state.
+            if (!GShellAttach.IsAttached()) break;
+            GbPaused ? GMasterClock.Pause(MasterClockNowNs())
+                     : GMasterClock.Resume(MasterClockNowNs());
+            if (GSoftwarePipeline) GSoftwarePipeline->SetPaused(GbPaused || !GLifecycle.IsAnyActive());
 
             for (auto& Monitor : GMonitors)
             {
-                if (Monitor.Player) 
+                if (Monitor.Player && !Monitor.bLowPower && !Monitor.bDormant) 
                 { 
                     GbPaused ? Monitor.Player->Pause() 
                              : Monitor.Player->Play(); 
@@ -702,17 +2004,32 @@ LRESULT CALLBACK MessageWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LPara
                 );
                 if (Monitor.Player) Monitor.Player->UpdateVideo();
             }
+            if (GConfig.bSpanMode) ApplySpanViewports();
+            if (GSoftwarePipeline) GSoftwarePipeline->SetLayout(BuildSoftwareLayout());
+            UpdateRenditions();
         }
+        LogResourceCheckpoint(L"display change");
         return 0;
     case WM_TIMER:
         if (WParam == TimerIdUpdate)
         {
-            if (!GbPaused)
+            TRACE_SCOPE("TimerTick");
+            UpdateMemoryGovernor();
+            if (!GShellAttach.IsAttached())
+            {
+                RunShellAttachAction(GShellAttach.OnTick(static_cast<int64_t>(GetTickCount64())));
+                return 0;
+            }
+            UpdateLifecycle();
+            if (!GbPaused && GLifecycle.IsAnyActive())
             {
                 bool bOccluded = IsDesktopOccluded();
                 if (bOccluded && !GbAutoPausedByFullscreen)
                 {
                     GbAutoPausedByFullscreen = true;
+                    TRACE_INSTANT("Pause.Occluded", 0);
+                    GMasterClock.Pause(MasterClockNowNs());
+                    if (GSoftwarePipeline) GSoftwarePipeline->SetPaused(true);
                     for (auto& Monitor : GMonitors)
                     {
                         if (Monitor.Player) Monitor.Player->Pause();
@@ -723,54 +2040,67 @@ LRESULT CALLBACK MessageWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LPara
                 else if (!bOccluded && GbAutoPausedByFullscreen)
                 {
                     GbAutoPausedByFullscreen = false;
+                    TRACE_INSTANT("Resume.Occluded", 0);
+                    GMasterClock.Resume(MasterClockNowNs());
+                    if (GSoftwarePipeline) GSoftwarePipeline->SetPaused(false);
                     for (auto& Monitor : GMonitors)
                     {
-                        if (Monitor.Player) Monitor.Player->Play();
+                        if (Monitor.Player && !Monitor.bLowPower && !Monitor.bDormant) Monitor.Player->Play();
                     }
                         
                     Log(L"Auto-resumed: desktop visible.");
                 }
             }
 
-            for (auto& Monitor : GMonitors)
+            PollKeyframeIndex();
+            UpdateLowPowerMonitors();
+            if (!GbPaused && !GbAutoPausedByFullscreen)
             {
-                if 
-                (
-                    !Monitor.Player       || 
-                    Monitor.Duration <= 0 || 
-                    GbPaused              || 
-                    GbAutoPausedByFullscreen
-                ) continue;
-
-                PROPVARIANT Position; PropVariantInit(&Position);
-                if 
-                (
-                    SUCCEEDED
-                    (
-                        Monitor.Player->GetPosition(MFP_POSITIONTYPE_100NS, &Position)
-                    )
-                )
-                {
-                    LONGLONG CurrentPos = Position.hVal.QuadPart;
-                    if (CurrentPos > 0 && (Monitor.Duration - CurrentPos) < PreSeekThreshold100ns)
-                    {
-                        PROPVARIANT Zero; PropVariantInit(&Zero);
-                        Zero.vt = VT_I8; Zero.hVal.QuadPart = 0;
-                        Monitor.Player->SetPosition(MFP_POSITIONTYPE_100NS, &Zero);
-                        PropVariantClear(&Zero);
-                        Log(L"Pre-seek loop triggered.");
-                    }
-                }
-                PropVariantClear(&Position);
+                SyncPlayersToMasterClock(Hwnd);
+                StepLowPowerMonitors(Hwnd);
             }
+            UpdatePresenterQuality();
+            LogSoftwarePresenterStats();
+            TickResourceCheckpoint();
+        }
+        else if (WParam == TimerIdLoop)
+        {
+            KillTimer(Hwnd, TimerIdLoop);
+            if (!GbPaused && !GbAutoPausedByFullscreen && GShellAttach.IsAttached()) LoopAllPlayers();
+        }
+        else if (WParam == TimerIdLowPower)
+        {
+            KillTimer(Hwnd, TimerIdLowPower);
+            if (!GbPaused && !GbAutoPausedByFullscreen && GShellAttach.IsAttached()) StepLowPowerMonitors(Hwnd);
         }
         return 0;
     case WM_DESTROY:
         KillTimer(Hwnd, TimerIdUpdate);
+        KillTimer(Hwnd, TimerIdLoop);
+        KillTimer(Hwnd, TimerIdLowPower);
+        StopControlServer();
+        WTSUnRegisterSessionNotification(Hwnd);
+        if (GDisplayStateNotify) UnregisterPowerSettingNotification(GDisplayStateNotify);
+        GDisplayStateNotify = nullptr;
+        if (GLowMemoryNotification)
+        {
+            CloseHandle(GLowMemoryNotification);
+            RESOURCE_RELEASE("MemoryGovernor", Handle);
+            GLowMemoryNotification = nullptr;
+        }
+        LogLifecycleTotals();
         RemoveTrayIcon();
         UnregisterHotKey(Hwnd, 1);
         UnregisterHotKey(Hwnd, 2);
+        UnregisterHotKey(Hwnd, 3);
+        RemoveWindowCacheHooks();
         ShutdownAllMonitors();
+        LogResourceCheckpoint(L"shutdown");
+        if (GTrace.IsEnabled())
+        {
+            GTrace.SetEnabled(false);
+            DumpTrace();
+        }
         MFShutdown();
         CoUninitialize();
         CloseLog();
@@ -788,20 +2118,54 @@ LRESULT CALLBACK MessageWndProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LPara
 
 namespace
 {
-    void ShutdownAllMonitors()
+    /** Shuts every player down concurrently; each MFPlay Shutdown() blocks until its pipeline drains. */
+    void ShutdownPlayers()
     {
+        TRACE_SCOPE("ShutdownPlayers");
+        FTaskGroup Teardown;
         for (auto& Monitor : GMonitors)
         {
-            if (Monitor.Player)
+            if (!Monitor.Player) continue;
+
+            // Detach first so late callbacks for this player are ignored.
+            IMFPMediaPlayer* Player = Monitor.Player;
+            Monitor.Player = nullptr;
+            Teardown.Run([Player]()
             {
-                Monitor.Player->Shutdown();
-                Monitor.Player->Release();
-                Monitor.Player = nullptr;
-            }
+                HRESULT ComResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+                Player->Shutdown();
+                Player->Release();
+                RESOURCE_RELEASE("Player", ComRef);
+                if (SUCCEEDED(ComResult)) CoUninitialize();
+            });
+        }
+
+        // Service sent messages while waiting: a player may synchronously call
+        // back into the thread that created it while shutting down.
+        while (!Teardown.WaitFor(std::chrono::milliseconds(0)))
+        {
+            MsgWaitForMultipleObjects(0, nullptr, FALSE, 10, QS_SENDMESSAGE);
+            MSG Msg;
+            PeekMessageW(&Msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+        }
+    }
+
+    void ShutdownAllMonitors()
+    {
+        GMasterClock.Stop();
+        GSoftwarePipeline.reset();
+        StopKeyframeIndexing();
+        ShutdownPlayers();
+        GbPipelinesReleased = false;
+        for (auto& Monitor : GMonitors)
+        {
             if (Monitor.Window)
             {
-                DestroyWindow(Monitor.Window);
+                // Cleared first so WM_DESTROY does not mistake this for the shell dying.
+                HWND Window = Monitor.Window;
                 Monitor.Window = nullptr;
+                GWindowCache.RemoveOwnWindow(Window);
+                DestroyWindow(Window);
             }
         }
         GMonitors.clear();
@@ -812,177 +2176,554 @@ namespace
         }
     }
 
-    bool CreateMonitorWallpapers(const FDesktopWindows& DesktopWnds)
+    /** Creates one monitor's wallpaper window under the shell's desktop windows (Z-ordered below InsertAfter). */
+    HWND CreateWallpaperWindow(const FDesktopWindows& DesktopWnds, const RECT& MonRect, size_t Index, HWND& InsertAfter)
     {
-        auto Rects = EnumerateMonitors();
-        if (Rects.empty()) return false;
-
-        HWND InsertAfter = DesktopWnds.ShellDefView;
-
+        int32_t Width = MonRect.right - MonRect.left;
+        int32_t Height = MonRect.bottom - MonRect.top;
+        HWND Window = nullptr;
 
-        for (size_t Index = 0; Index < Rects.size(); ++Index)
+        if (DesktopWnds.bShellOnProgman)
         {
-            auto&& MonRect = Rects[Index];
+            Window = CreateWindowExW
+            (
+                0, 
+                GWallpaperClassName, 
+                L"",
+                WS_POPUP | WS_VISIBLE,
+                MonRect.left, 
+                MonRect.top, 
+                Width, 
+                Height,
+                nullptr, 
+                nullptr, 
+                GInstance, 
+                nullptr
+            );
+            if (!Window) 
+            {
+                Log
+                (
+                    L"Failed to create window for monitor " + std::to_wstring(Index)
+                ); return nullptr; 
+            }
 
-            int32_t Width = MonRect.right - MonRect.left;
-            int32_t Height = MonRect.bottom - MonRect.top;
+            SetParent(Window, DesktopWnds.Progman);
+            LONG_PTR Style = GetWindowLongPtrW(Window, GWL_STYLE);
+            Style = (Style & ~WS_POPUP) | WS_CHILD;
+            SetWindowLongPtrW(Window, GWL_STYLE, Style);
 
-            FMonitorWallpaper MonWallpaper;
-            MonWallpaper.Rect = Rects[Index];
+            POINT Point = { MonRect.left, MonRect.top };
+            MapWindowPoints(nullptr, DesktopWnds.Progman, &Point, 1);
 
+            Log
+            (
+                L"Monitor " + std::to_wstring(Index) + L": screen(" + std::to_wstring(MonRect.left) + L","
+                + std::to_wstring(MonRect.top) + L") -> client(" + std::to_wstring(Point.x) + L"," + std::to_wstring(Point.y) + L")"
+            );
 
-            if (DesktopWnds.bShellOnProgman)
+            if (InsertAfter)
+            {
+                // First send to absolute bottom so it's behind everything,
+                // then bring back up to just below ShellDefView.
+                // This guarantees desktop icons always appear in front.
+                SetWindowPos(
+                    Window, HWND_BOTTOM,
+                    Point.x, Point.y, Width, Height,
+                    SWP_NOACTIVATE);
+                SetWindowPos(
+                    Window, InsertAfter,
+                    Point.x, Point.y, Width, Height,
+                    SWP_NOACTIVATE | SWP_SHOWWINDOW);
+            }
+            else
             {
-                MonWallpaper.Window = CreateWindowExW
+                SetWindowPos
                 (
-                    0, 
-                    GWallpaperClassName, 
-                    L"",
-                    WS_POPUP | WS_VISIBLE,
-                    MonRect.left, 
-                    MonRect.top, 
+                    Window, 
+                    HWND_BOTTOM, 
+                    Point.x, 
+                    Point.y, 
                     Width, 
-                    Height,
-                    nullptr, 
-                    nullptr, 
-                    GInstance, 
-                    nullptr
+                    Height, 
+                    SWP_NOACTIVATE | SWP_SHOWWINDOW
                 );
-                if (!MonWallpaper.Window) 
-                {
-                    Log
-                    (
-                        L"Failed to create window for monitor " + std::to_wstring(Index)
-                    ); continue; 
-                }
-
-                SetParent(MonWallpaper.Window, DesktopWnds.Progman);
-                LONG_PTR Style = GetWindowLongPtrW(MonWallpaper.Window, GWL_STYLE);
-                Style = (Style & ~WS_POPUP) | WS_CHILD;
-                SetWindowLongPtrW(MonWallpaper.Window, GWL_STYLE, Style);
+            }
 
-                POINT Point = { MonRect.left, MonRect.top };
-                MapWindowPoints(nullptr, DesktopWnds.Progman, &Point, 1);
+            InsertAfter = Window;
+        }
+        else
+        {
+            HWND Host = DesktopWnds.WorkerW 
+                      ? DesktopWnds.WorkerW 
+                      : DesktopWnds.Progman;
 
-                Log
-                (
-                    L"Monitor " + std::to_wstring(Index) + L": screen(" + std::to_wstring(MonRect.left) + L","
-                    + std::to_wstring(MonRect.top) + L") -> client(" + std::to_wstring(Point.x) + L"," + std::to_wstring(Point.y) + L")"
-                );
+            POINT Point = { MonRect.left, MonRect.top };
+            MapWindowPoints(nullptr, Host, &Point, 1);
 
-                if (InsertAfter)
-                {
-                    // First send to absolute bottom so it's behind everything,
-                    // then bring back up to just below ShellDefView.
-                    // This guarantees desktop icons always appear in front.
-                    SetWindowPos(
-                        MonWallpaper.Window, HWND_BOTTOM,
-                        Point.x, Point.y, Width, Height,
-                        SWP_NOACTIVATE);
-                    SetWindowPos(
-                        MonWallpaper.Window, InsertAfter,
-                        Point.x, Point.y, Width, Height,
-                        SWP_NOACTIVATE | SWP_SHOWWINDOW);
-                }
-                else
-                {
-                    SetWindowPos
-                    (
-                        MonWallpaper.Window, 
-                        HWND_BOTTOM, 
-                        Point.x, 
-                        Point.y, 
-                        Width, 
-                        Height, 
-                        SWP_NOACTIVATE | SWP_SHOWWINDOW
-                    );
-                }
-
-                InsertAfter = MonWallpaper.Window;
-            }
-            else
+            Window = CreateWindowExW
+            (
+                0, GWallpaperClassName, L"",
+                WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN,
+                Point.x, Point.y, 
+                Width, Height,
+                Host, 
+                nullptr, 
+                GInstance, 
+                nullptr
+            );
+            if (!Window)
             {
-                HWND Host = DesktopWnds.WorkerW 
-                          ? DesktopWnds.WorkerW 
-                          : DesktopWnds.Progman;
+                Log(L"Failed to create window for monitor " + std::to_wstring(Index)); 
+                return nullptr;
+            }
+            SetWindowPos
+            (
+                Window, 
+                HWND_BOTTOM, 
+                Point.x, Point.y, 
+                Width, Height, 
+                SWP_NOACTIVATE | SWP_SHOWWINDOW
+            );
+        }
 
-                POINT Point = { MonRect.left, MonRect.top };
-                MapWindowPoints(nullptr, Host, &Point, 1);
+        return Window;
+    }
 
-                MonWallpaper.Window = CreateWindowExW
-                (
-                    0, GWallpaperClassName, L"",
-                    WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN,
-                    Point.x, Point.y, 
-                    Width, Height,
-                    Host, 
-                    nullptr, 
-                    GInstance, 
-                    nullptr
-                );
-                if (!MonWallpaper.Window)
-                {
-                    Log(L"Failed to create window for monitor " + std::to_wstring(Index)); 
-                    continue; 
-                }
-                SetWindowPos
-                (
-                    MonWallpaper.Window, 
-                    HWND_BOTTOM, 
-                    Point.x, Point.y, 
-                    Width, Height, 
-                    SWP_NOACTIVATE | SWP_SHOWWINDOW
-                );
-            }
+    void HideStaticWallpaper(const FDesktopWindows& DesktopWnds)
+    {
+        if (DesktopWnds.bShellOnProgman && DesktopWnds.WorkerW)
+        {
+            ShowWindow(DesktopWnds.WorkerW, SW_HIDE);
+            Log(L"Hid static wallpaper WorkerW.");
+        }
+    }
+
+    bool CreateMonitorWallpapers(const FDesktopWindows& DesktopWnds)
+    {
+        auto Rects = EnumerateMonitors();
+        if (Rects.empty()) return false;
+
+        HWND InsertAfter = DesktopWnds.ShellDefView;
+        for (size_t Index = 0; Index < Rects.size(); ++Index)
+        {
+            FMonitorWallpaper MonWallpaper;
+            MonWallpaper.Rect = Rects[Index];
+            MonWallpaper.Window = CreateWallpaperWindow(DesktopWnds, Rects[Index], Index, InsertAfter);
+            if (!MonWallpaper.Window) continue;
 
+            GWindowCache.AddOwnWindow(MonWallpaper.Window);
             GMonitors.push_back(MonWallpaper);
             Log
             (
                 L"Created window for monitor " + std::to_wstring(Index) + L": "
-                + std::to_wstring(Width) + L"x" + std::to_wstring(Height)
+                + std::to_wstring(Rects[Index].right - Rects[Index].left) + L"x"
+                + std::to_wstring(Rects[Index].bottom - Rects[Index].top)
             );
         }
 
-        if (DesktopWnds.bShellOnProgman && DesktopWnds.WorkerW)
+        HideStaticWallpaper(DesktopWnds);
+        GLifecycle.SetMonitorCount(GMonitors.size(), static_cast<int64_t>(GetTickCount64()));
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
         {
-            ShowWindow(DesktopWnds.WorkerW, SW_HIDE);
-            Log(L"Hid static wallpaper WorkerW.");
+            GMonitors[Index].bDormant = GLifecycle.GetState(Index) != ELifecycleState::Active;
         }
-
+        UpdateLifecycle();
         return !GMonitors.empty();
     }
 
+    /** Barrier released: start every pipeline that opened, together, so they begin on the same tick. */
+    void OnPipelinesSettled()
+    {
+        size_t ReadyCount = GPipelineBarrier.CountIn(EPipelineSlotState::Ready);
+        Log
+        (
+            L"Pipelines settled: " + std::to_wstring(ReadyCount) + L" ready, "
+            + std::to_wstring(GPipelineBarrier.CountIn(EPipelineSlotState::Failed)) + L" failed."
+        );
+        TRACE_INSTANT("PipelinesSettled", static_cast<int64_t>(ReadyCount));
+
+        if (!ReadyCount)
+        {
+            std::wstring ErrorMsg = L"Failed to open the video on any monitor.\n\nFile: " + GVideoPath;
+            MessageBoxW(nullptr, ErrorMsg.c_str(), L"VideoWallpaper", MB_ICONERROR);
+            return;
+        }
+
+        // One shared timeline per file, wrapping at the end of the file so every frame is shown;
+        // a player that reaches end-of-stream just ahead of the wrap starts over on its own.
+        LONGLONG Duration = 0;
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+        {
+            if (GPipelineBarrier.GetState(Index) != EPipelineSlotState::Ready) continue;
+            if (GMonitors[Index].Duration > Duration) Duration = GMonitors[Index].Duration;
+        }
+        bool bHold = GbPaused || GbAutoPausedByFullscreen || !GShellAttach.IsAttached();
+        GMasterClock.Start(MasterClockNowNs(), Duration);
+        if (bHold) GMasterClock.Pause(MasterClockNowNs());
+
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+        {
+            auto& Monitor = GMonitors[Index];
+            if (!Monitor.Player || GPipelineBarrier.GetState(Index) != EPipelineSlotState::Ready) continue;
+            if (!bHold && !Monitor.bDormant) Monitor.Player->Play();
+        }
+
+        TrimWorkingSet();
+        Log(L"Working set trimmed after player init.");
+    }
+
+    void OnPipelineReady(int32_t MonitorIndex)
+    {
+        Log(L"Monitor " + std::to_wstring(MonitorIndex) + L": Ready.");
+        if (GPipelineBarrier.MarkReady(static_cast<size_t>(MonitorIndex))) OnPipelinesSettled();
+    }
+
+    // A failed monitor keeps its (idle) player until the next teardown; the others carry on.
+    void OnPipelineFailed(int32_t MonitorIndex, HRESULT Result)
+    {
+        Log
+        (
+            L"Monitor " + std::to_wstring(MonitorIndex) + L": open FAILED hr="
+            + std::to_wstring(static_cast<long>(Result))
+        );
+        if (GPipelineBarrier.MarkFailed(static_cast<size_t>(MonitorIndex))) OnPipelinesSettled();
+    }
+
+    /**
+     * A monitor's rect sized to its display mode. Per-monitor DPI awareness makes the two
+     * agree; under the system-aware fallback rects are scaled to the system DPI, and
+     * would undersell a high-DPI monitor to the rendition choice.
+     */
+    FIntRect GetPhysicalMonitorRect(const RECT& Rect)
+    {
+        FIntRect Physical = ToIntRect(Rect);
+        if (GbPerMonitorDpiAware) return Physical;
+
+        MONITORINFOEXW MonitorInfo = {};
+        MonitorInfo.cbSize = sizeof(MonitorInfo);
+        DEVMODEW Mode = {};
+        Mode.dmSize = sizeof(Mode);
+        if (!GetMonitorInfoW(MonitorFromRect(&Rect, MONITOR_DEFAULTTONEAREST), &MonitorInfo)) return Physical;
+        if (!EnumDisplaySettingsW(MonitorInfo.szDevice, ENUM_CURRENT_SETTINGS, &Mode)) return Physical;
+        Physical.Right = Physical.Left + static_cast<int32_t>(Mode.dmPelsWidth);
+        Physical.Bottom = Physical.Top + static_cast<int32_t>(Mode.dmPelsHeight);
+        return Physical;
+    }
+
+    /** The configured renditions of GVideoPath whose files exist; animated images have none. */
+    void RefreshRenditions()
+    {
+        GRenditions.clear();
+        if (IsAnimatedImageFile(GVideoPath)) return;
+        for (const auto& Rendition : GConfig.Renditions)
+        {
+            std::wstring Path = GetRenditionPath(GVideoPath, Rendition.Suffix);
+            if (GetFileAttributesW(Path.c_str()) != INVALID_FILE_ATTRIBUTES) GRenditions.push_back(Rendition);
+        }
+    }
+
+    std::wstring GetRenditionVideoPath(int32_t Rendition)
+    {
+        if (Rendition < 0 || Rendition >= static_cast<int32_t>(GRenditions.size())) return GVideoPath;
+        return GetRenditionPath(GVideoPath, GRenditions[Rendition].Suffix);
+    }
+
+    std::wstring GetRenditionName(int32_t Rendition)
+    {
+        if (Rendition < 0 || Rendition >= static_cast<int32_t>(GRenditions.size())) return L"master";
+        const auto& Entry = GRenditions[Rendition];
+        return std::to_wstring(Entry.Width) + L"x" + std::to_wstring(Entry.Height) + L" " + Entry.Suffix;
+    }
+
+    std::vector<int32_t> SelectMonitorRenditions()
+    {
+        std::vector<FIntRect> MonitorRects;
+        for (const auto& Monitor : GMonitors) MonitorRects.push_back(GetPhysicalMonitorRect(Monitor.Rect));
+        return ::SelectMonitorRenditions(GRenditions, MonitorRects, GConfig.bSpanMode, GConfig.Span);
+    }
+
+    /** The software presenter decodes once for every monitor: the encode covering its largest target. */
+    int32_t SelectSoftwareRendition(const FSoftwareLayout& Layout)
+    {
+        int32_t Width = 0;
+        int32_t Height = 0;
+        Layout.GetFrameCoverSize(Width, Height);
+        return SelectRendition(GRenditions, Width, Height);
+    }
+
+    /** The encode whose sample table is read: the software presenter's, or the one most players decode. */
+    std::wstring GetIndexedVideoPath()
+    {
+        if (ShouldUseSoftwarePresenter()) return GetRenditionVideoPath(GSoftwareRendition);
+        std::vector<int32_t> Selection;
+        for (const auto& Monitor : GMonitors) Selection.push_back(Monitor.Rendition);
+        std::vector<FRenditionGroup> Groups = GroupMonitorsByRendition(Selection);
+        size_t Largest = 0;
+        for (size_t Index = 1; Index < Groups.size(); ++Index)
+        {
+            if (Groups[Index].Monitors.size() > Groups[Largest].Monitors.size()) Largest = Index;
+        }
+        return Groups.empty() ? GVideoPath : GetRenditionVideoPath(Groups[Largest].Rendition);
+    }
+
+    /**
+     * Creates one player per monitor without a URL (cheap), then opens the video on
+     * all of them asynchronously so source resolution runs concurrently on Media
+     * Foundation's work queues instead of serially on the UI thread. Each player opens
+     * the smallest rendition covering its monitor; MFPlay gives every player its own
+     * decoder, so monitors on the same rendition share the file, not the decode.
+     * Returns false only if no monitor could even start opening.
+     */
     bool CreatePlayers()
     {
+        TRACE_SCOPE("CreatePlayers");
+        GPipelineBarrier.Reset(GMonitors.size());
+        RefreshRenditions();
+        std::vector<int32_t> Selection = SelectMonitorRenditions();
+        for (const auto& Group : GroupMonitorsByRendition(Selection))
+        {
+            if (GRenditions.empty()) break;
+            std::wstring Monitors;
+            for (size_t Monitor : Group.Monitors) Monitors += (Monitors.empty() ? L"" : L", ") + std::to_wstring(Monitor);
+            Log(L"Rendition " + GetRenditionName(Group.Rendition) + L" for monitor(s) " + Monitors + L".");
+        }
+
+        bool bAnyOpening = false;
         for (size_t Index = 0; Index < GMonitors.size(); ++Index)
         {
             auto& Monitor = GMonitors[Index];
             auto* Callback = new FMediaPlayerCallback(static_cast<int32_t>(Index));
             HRESULT Result = MFPCreateMediaPlayer
             (
-                GVideoPath.c_str(), TRUE, 0, Callback, Monitor.Window, &Monitor.Player
+                nullptr, FALSE, 0, Callback, Monitor.Window, &Monitor.Player
             );
             Callback->Release();
+            if (SUCCEEDED(Result) && Monitor.Player) RESOURCE_ACQUIRE("Player", ComRef);
+
+            if (SUCCEEDED(Result) && Monitor.Player)
+            {
+                Monitor.Player->SetMute(GbMuted ? TRUE : FALSE);
+                Monitor.Rendition = Selection[Index];
+                Result = Monitor.Player->CreateMediaItemFromURL
+                (
+                    GetRenditionVideoPath(Monitor.Rendition).c_str(), FALSE, static_cast<DWORD_PTR>(Index), nullptr
+                );
+            }
 
             if (FAILED(Result) || !Monitor.Player)
             {
                 Log
                 (
-                    L"MFPCreateMediaPlayer FAILED for monitor " + std::to_wstring(Index)
+                    L"Player creation FAILED for monitor " + std::to_wstring(Index)
                     + L" hr=" + std::to_wstring(static_cast<long>(Result))
                 );
-                return false;
+                GPipelineBarrier.MarkFailed(Index);
+                continue;
             }
 
-            Monitor.Player->SetMute(GbMuted ? TRUE : FALSE);
-
             ShowWindow(Monitor.Window, SW_SHOW);
             UpdateWindow(Monitor.Window);
-            Log(L"Player created for monitor " + std::to_wstring(Index));
+            Log(L"Player created for monitor " + std::to_wstring(Index) + L", opening asynchronously.");
+            bAnyOpening = true;
+        }
+        if (bAnyOpening) StartKeyframeIndexing();
+        return bAnyOpening;
+    }
+
+    /** Sniffs the file header: GIF and PNG/APNG are decoded in-process, not by Media Foundation. */
+    bool IsAnimatedImageFile(const std::wstring& Path)
+    {
+        std::ifstream File(Path.c_str(), std::ios::binary);
+        uint8_t Header[8] = {};
+        File.read(reinterpret_cast<char*>(Header), sizeof(Header));
+        return IsAnimatedImageData(Header, static_cast<size_t>(File.gcount()));
+    }
+
+    /**
+     * Remote sessions have no GPU worth handing to EVR; elsewhere the software path is
+     * opt-in. Animated images have no EVR path at all, and MFPlay cannot play backwards.
+     */
+    bool ShouldUseSoftwarePresenter()
+    {
+        if (GConfig.Presenter == EPresenter::Software || IsAnimatedImageFile(GVideoPath)) return true;
+        if (GConfig.Loop == ELoopMode::PingPong) return true;
+        if (GConfig.Presenter == EPresenter::Evr) return false;
+        return GetSystemMetrics(SM_REMOTESESSION) != 0;
+    }
+
+    /** Canvas = bounding box of all monitors; each window's region is its rect relative to that box. */
+    FSoftwareLayout BuildSoftwareLayout()
+    {
+        std::vector<FIntRect> MonitorRects;
+        std::vector<HWND> Windows;
+        for (const auto& Monitor : GMonitors)
+        {
+            MonitorRects.push_back(ToIntRect(Monitor.Rect));
+            Windows.push_back(Monitor.Window);
         }
+        return ::BuildSoftwareLayout(MonitorRects, Windows, GConfig.bSpanMode, GConfig.Span);
+    }
+
+    /** Decodes the smallest rendition covering every monitor of the layout. */
+    std::unique_ptr<IVideoSource> OpenVideoSource(const FSoftwareLayout& Layout)
+    {
+        RefreshRenditions();
+        GSoftwareRendition = SelectSoftwareRendition(Layout);
+        auto Source = std::make_unique<FMFSourceReaderSource>();
+        HRESULT Result = Source->Open(GetRenditionVideoPath(GSoftwareRendition));
+        if (FAILED(Result))
+        {
+            Log(L"Software presenter: open FAILED hr=" + std::to_wstring(static_cast<long>(Result)));
+            return nullptr;
+        }
+        const FVideoInfo& Info = Source->GetInfo();
+        Log
+        (
+            L"Software presenter: " + std::to_wstring(Info.Width) + L"x" + std::to_wstring(Info.Height)
+            + (Info.Format == EPixelFormat::P010 ? L" P010 (HDR10, tone mapped to SDR)" : L" NV12") + L" @ " + std::to_wstring(Info.FrameRateNumerator) + L"/" + std::to_wstring(Info.FrameRateDenominator)
+            + L" fps, rendition " + GetRenditionName(GSoftwareRendition) + L"."
+        );
+        if (GConfig.Loop != ELoopMode::PingPong) return Source;
+
+        // Segments are fixed slices until the keyframe index arrives, GOP-aligned after.
+        GPingPongKeyframes = std::make_shared<FKeyframeTimestamps>();
+        StopKeyframeIndexing();
+        StartKeyframeIndexing();
+        FPingPongSettings Settings;
+        Settings.MaxCacheBytes = GConfig.PingPongCacheBytes;
+        Settings.Keyframes = GPingPongKeyframes;
+        Log(L"Ping-pong loop: " + std::to_wstring(Settings.MaxCacheBytes / (1024 * 1024)) + L" MB reverse cache.");
+        return std::make_unique<FPingPongSource>(std::move(Source), Settings);
+    }
+
+    /** Frames are cached no larger than the biggest area they are shown on. */
+    std::unique_ptr<IVideoSource> OpenAnimatedImageSource(const FSoftwareLayout& Layout)
+    {
+        std::ifstream File(GVideoPath.c_str(), std::ios::binary);
+        std::vector<uint8_t> Data((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+
+        FAnimationCacheSettings Settings;
+        Settings.MaxCacheBytes = GConfig.AnimationCacheBytes;
+        Layout.GetFrameCoverSize(Settings.TargetWidth, Settings.TargetHeight);
+
+        auto Source = std::make_unique<FAnimatedImageSource>();
+        if (!Source->Open(CreateAnimationDecoder(std::move(Data)), Settings))
+        {
+            Log(L"Animated image: cannot decode " + GVideoPath);
+            return nullptr;
+        }
+        const FAnimationInfo& Animation = Source->GetAnimationInfo();
+        const FVideoInfo& Info = Source->GetInfo();
+        bool bCached = Source->GetMode() == EAnimationCacheMode::Cached;
+        Log
+        (
+            L"Animated image: " + AsciiToWide(Animation.FormatName) + L" " + std::to_wstring(Animation.Width) + L"x"
+            + std::to_wstring(Animation.Height) + L", " + std::to_wstring(Animation.FrameCount) + L" frame(s), "
+            + (bCached ? L"cached " + std::to_wstring(Source->GetCacheBytes() / (1024 * 1024)) + L" MB"
+                       : std::wstring(L"streaming (over animation_cache_mb)"))
+            + L" at " + std::to_wstring(Info.Width) + L"x" + std::to_wstring(Info.Height) + L"."
+        );
+        return Source;
+    }
+
+    /** Opens the video once for all monitors; the decode thread takes over from here. */
+    bool CreateSoftwarePipeline()
+    {
+        TRACE_SCOPE("CreateSoftwarePipeline");
+        FSoftwareLayout Layout = BuildSoftwareLayout();
+        std::unique_ptr<IVideoSource> Source = IsAnimatedImageFile(GVideoPath)
+            ? OpenAnimatedImageSource(Layout)
+            : OpenVideoSource(Layout);
+        if (!Source) return false;
+
+        FQualitySettings QualitySettings;
+        QualitySettings.LevelCount = static_cast<int32_t>(std::size(PresenterQualityLevels));
+        GPresenterQuality.Reset(QualitySettings);
+
+        GSoftwarePipeline = std::make_unique<FSoftwarePipeline>(GGdiPresenter);
+        GSoftwarePipeline->SetCacheLevel(GMemoryGovernor.GetCacheLevel());
+        GSoftwarePipeline->Start
+        (
+            std::move(Source), std::move(Layout),
+            GbPaused || GbAutoPausedByFullscreen || !GLifecycle.IsAnyActive()
+        );
+        Log(L"Software presenter started with " + std::to_wstring(GSoftwarePipeline->GetWorkerCount()) + L" worker(s).");
+
+        TrimWorkingSet();
+        return true;
+    }
+
+    /**
+     * Hands the new video to the running software presenter, which fades it in over the
+     * old one without touching the windows. False when there is nothing to fade from
+     * (EVR players, a released or failed pipeline), fading is off, or the file does not open.
+     */
+    bool CrossfadeSoftwarePipeline()
+    {
+        if (!GSoftwarePipeline || GSoftwarePipeline->HasFailed() || GConfig.CrossfadeMs <= 0) return false;
+        if (!GShellAttach.IsAttached() || !ShouldUseSoftwarePresenter()) return false;
+        FSoftwareLayout Layout = BuildSoftwareLayout();
+        // Opened here, once the pipeline has closed any video still fading out.
+        auto Open = [&Layout]
+        {
+            return IsAnimatedImageFile(GVideoPath) ? OpenAnimatedImageSource(Layout) : OpenVideoSource(Layout);
+        };
+        if (!GSoftwarePipeline->Crossfade(Open, GConfig.CrossfadeMs * 1000000LL)) return false;
+
+        Log(L"Crossfading over " + std::to_wstring(GConfig.CrossfadeMs) + L" ms.");
         return true;
     }
 
+    bool CreatePipelines()
+    {
+        if (ShouldUseSoftwarePresenter()) return CreateSoftwarePipeline();
+        return CreatePlayers();
+    }
+
+    /** Feeds the last tick's measurements to the quality controller and applies (and logs) its decision. */
+    void UpdatePresenterQuality()
+    {
+        if (!GSoftwarePipeline) return;
+        FQualityDecision Decision = GPresenterQuality.Update(GSoftwarePipeline->TakeQualitySample());
+        if (Decision.Action == EQualityAction::Hold) return;
+
+        const FPresenterQuality& Quality = PresenterQualityLevels[Decision.Level];
+        GSoftwarePipeline->SetQuality(Quality);
+        TRACE_INSTANT("Quality", Decision.Level);
+        Log
+        (
+            std::wstring(Decision.Action == EQualityAction::StepDown ? L"Quality down" : L"Quality up")
+            + L" to level " + std::to_wstring(Decision.Level) + L" (" + AsciiToWide(Quality.Name) + L"): drops "
+            + std::to_wstring(static_cast<int32_t>(Decision.DropRate * 100)) + L"%, load "
+            + std::to_wstring(static_cast<int32_t>(Decision.Load * 100)) + L"% of frame budget."
+        );
+    }
+
+    /** Per-stage timings of the software presenter, averaged; logged from the UI thread. */
+    void LogSoftwarePresenterStats()
+    {
+        static int32_t Ticks = 0;
+        if (!GSoftwarePipeline || !GbDebugEnabled || ++Ticks < PresenterStatsLogTicks) return;
+        Ticks = 0;
+
+        if (GSoftwarePipeline->HasFailed()) Log(L"Software presenter: decode FAILED, playback stopped.");
+        FCompositorStats Stats = GSoftwarePipeline->GetStats();
+        uint64_t DirtyPercent = Stats.TilesTotal ? Stats.TilesDirty * 100 / Stats.TilesTotal : 0;
+        Log
+        (
+            L"Software presenter: frames=" + std::to_wstring(Stats.Frames)
+            + L" dropped=" + std::to_wstring(GSoftwarePipeline->GetDroppedFrames())
+            + L" level=" + std::to_wstring(GPresenterQuality.GetLevel())
+            + L" qosBoost=" + std::to_wstring(GQos.GetStats().Boost)
+            + L" static=" + std::to_wstring(Stats.StaticFrames)
+            + L" dirtyTiles=" + std::to_wstring(DirtyPercent) + L"%"
+            + L" convert=" + std::to_wstring(static_cast<int64_t>(Stats.Convert.AverageNs / 1000)) + L"us"
+            + L" scale=" + std::to_wstring(static_cast<int64_t>(Stats.Scale.AverageNs / 1000)) + L"us"
+            + L" present=" + std::to_wstring(static_cast<int64_t>(Stats.Present.AverageNs / 1000)) + L"us"
+        );
+    }
+
     const wchar_t* GAutoRunKey = L"Software\\Microsoft\\Windows\\CurrentVersion\\Run";
     const wchar_t* GAutoRunValue = L"VideoWallpaper";
 
@@ -1042,6 +2783,298 @@ namespace
         RegCloseKey(Key);
     }
 
+    std::wstring AsciiToWide(const char* Text)
+    {
+        return std::wstring(Text, Text + std::strlen(Text));
+    }
+
+    /** Tears down the decode pipelines but keeps the windows, so CreatePipelines() can rebuild them in place. */
+    void ReleasePipelines()
+    {
+        TRACE_SCOPE("ReleasePipelines");
+        GMasterClock.Stop();
+        GSoftwarePipeline.reset();
+        StopKeyframeIndexing();
+        ShutdownPlayers();
+        for (auto& Monitor : GMonitors)
+        {
+            Monitor.Duration = 0;
+            Monitor.Drift.Reset();
+            Monitor.Rate = 1.0;
+            Monitor.bLowPower = false;
+            Monitor.LowPowerStep = SIZE_MAX;
+        }
+        GbPipelinesReleased = true;
+        TrimWorkingSet();
+    }
+
+    /**
+     * Runs the lifecycle and carries out its transitions: hidden monitors pause,
+     * visible ones rejoin the master timeline, and the pipelines are released or
+     * rebuilt once every monitor is released or the first one comes back.
+     */
+    void UpdateLifecycle()
+    {
+        int64_t NowMs = static_cast<int64_t>(GetTickCount64());
+        std::vector<FLifecycleTransition> Transitions;
+        GLifecycle.Update(NowMs, Transitions);
+        if (Transitions.empty()) return;
+
+        bool bPlaying = !GbPaused && !GbAutoPausedByFullscreen && GShellAttach.IsAttached();
+        for (const auto& Transition : Transitions)
+        {
+            TRACE_INSTANT("Lifecycle", static_cast<int64_t>(Transition.To));
+            Log
+            (
+                L"Monitor " + std::to_wstring(Transition.Monitor) + L": "
+                + AsciiToWide(GetLifecycleStateName(Transition.From)) + L" -> "
+                + AsciiToWide(GetLifecycleStateName(Transition.To)) + L" after "
+                + std::to_wstring(Transition.TimeInFromMs / 1000) + L" s."
+            );
+            if (Transition.Monitor >= GMonitors.size()) continue;
+
+            auto& Monitor = GMonitors[Transition.Monitor];
+            bool bDormant = Transition.To != ELifecycleState::Active;
+            if (bDormant == Monitor.bDormant) continue;
+            Monitor.bDormant = bDormant;
+            if (!Monitor.Player || Monitor.Duration <= 0) continue;
+
+            if (bDormant) Monitor.Player->Pause();
+            else if (Monitor.bLowPower) Monitor.LowPowerStep = SIZE_MAX;
+            else
+            {
+                SeekPlayer(Monitor.Player, GMasterClock.GetPosition100ns(MasterClockNowNs()));
+                Monitor.Drift.Reset();
+                if (bPlaying) Monitor.Player->Play();
+            }
+        }
+
+        if (GLifecycle.AreAllReleased() && !GbPipelinesReleased)
+        {
+            Log(L"Every monitor hidden for a while; releasing decode pipelines.");
+            ReleasePipelines();
+        }
+        else if (GbPipelinesReleased && !GLifecycle.AreAllReleased())
+        {
+            Log(L"Monitor visible again; rebuilding decode pipelines.");
+            GbPipelinesReleased = false;
+            if (!CreatePipelines()) Log(L"ERROR: Failed to rebuild pipelines.");
+        }
+        else if (GSoftwarePipeline) GSoftwarePipeline->SetPaused(!bPlaying || !GLifecycle.IsAnyActive());
+    }
+
+    void OnSessionEvent(ESessionEvent Event)
+    {
+        GLifecycle.OnSessionEvent(Event);
+        UpdateLifecycle();
+    }
+
+    void OnDisplayPower(EDisplayPower Power)
+    {
+        GLifecycle.SetAllDisplayPower(Power);
+        UpdateLifecycle();
+    }
+
+    void LogLifecycleTotals()
+    {
+        int64_t NowMs = static_cast<int64_t>(GetTickCount64());
+        for (size_t Index = 0; Index < GLifecycle.GetMonitorCount(); ++Index)
+        {
+            Log
+            (
+                L"Monitor " + std::to_wstring(Index) + L" lifecycle: active "
+                + std::to_wstring(GLifecycle.GetTimeInState(Index, ELifecycleState::Active, NowMs) / 1000) + L" s, paused "
+                + std::to_wstring(GLifecycle.GetTimeInState(Index, ELifecycleState::Paused, NowMs) / 1000) + L" s, released "
+                + std::to_wstring(GLifecycle.GetTimeInState(Index, ELifecycleState::Released, NowMs) / 1000) + L" s."
+            );
+        }
+    }
+
+    /**
+     * Tears down every monitor and builds them again from scratch under the current
+     * desktop windows. Returns false if no pipeline could be created.
+     */
+    bool ReloadWallpaper()
+    {
+        ShutdownAllMonitors();
+        GDesktop = FindDesktopWindows();
+        if (!GDesktop.Progman) return false;
+
+        if (!GDesktop.bShellOnProgman)
+        {
+            HWND Host = GDesktop.WorkerW ? GDesktop.WorkerW : GDesktop.Progman;
+            ShowWindow(Host, SW_SHOWNA);
+        }
+
+        if (!CreateMonitorWallpapers(GDesktop)) return false;
+        GShellAttach.Reset();
+        bool bCreated = CreatePipelines();
+        LogResourceCheckpoint(L"reload");
+        return bCreated;
+    }
+
+    /**
+     * After a display change: if a monitor now needs another rendition, the software
+     * presenter fades over to it (or is rebuilt with fades off) and EVR players are rebuilt.
+     */
+    void UpdateRenditions()
+    {
+        if (GRenditions.empty() || GbPipelinesReleased) return;
+        bool bChanged = false;
+        if (GSoftwarePipeline) bChanged = SelectSoftwareRendition(BuildSoftwareLayout()) != GSoftwareRendition;
+        else
+        {
+            std::vector<int32_t> Selection = SelectMonitorRenditions();
+            for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+            {
+                if (GMonitors[Index].Player && Selection[Index] != GMonitors[Index].Rendition) bChanged = true;
+            }
+        }
+        if (!bChanged) return;
+        Log(L"Display change moved a monitor to another rendition; switching.");
+        if (!CrossfadeSoftwarePipeline() && !ReloadWallpaper()) Log(L"ERROR: Rendition switch failed.");
+    }
+
+    /** A wallpaper window we did not destroy ourselves: its host, the shell, went away. */
+    void OnWallpaperWindowDestroyed(HWND Window)
+    {
+        bool bLost = false;
+        for (auto& Monitor : GMonitors)
+        {
+            if (Monitor.Window != Window) continue;
+            GWindowCache.RemoveOwnWindow(Window);
+            Monitor.Window = nullptr;
+            bLost = true;
+        }
+        if (bLost) RunShellAttachAction(GShellAttach.OnHostLost(static_cast<int64_t>(GetTickCount64())));
+    }
+
+    /** Points a player's video renderer at a new window; its position and decoder stay as they are. */
+    bool RebindPlayerWindow(IMFPMediaPlayer* Player, HWND Window)
+    {
+        IMFVideoDisplayControl* DisplayControl = nullptr;
+        HRESULT Result = MFGetService
+        (
+            Player,
+            LOCAL_MR_VIDEO_RENDER_SERVICE,
+            __uuidof(IMFVideoDisplayControl),
+            reinterpret_cast<void**>(&DisplayControl)
+        );
+        if (FAILED(Result)) return false;
+        RESOURCE_ACQUIRE("DisplayControl", ComRef);
+        Result = DisplayControl->SetVideoWindow(Window);
+        DisplayControl->Release();
+        RESOURCE_RELEASE("DisplayControl", ComRef);
+        if (FAILED(Result)) return false;
+        Player->UpdateVideo();
+        return true;
+    }
+
+    /**
+     * Finds the new desktop windows and re-creates the lost wallpaper windows under
+     * them, re-binding each pipeline. Monitors that were re-attached are kept if a
+     * later monitor fails, so the next attempt only retries what is still missing.
+     */
+    bool ReattachToShell()
+    {
+        TRACE_SCOPE("ShellReattach");
+        FDesktopWindows Desktop = FindDesktopWindows();
+        bool bReady = Desktop.bShellOnProgman
+            ? Desktop.Progman != nullptr
+            : (Desktop.Progman != nullptr && Desktop.WorkerW != nullptr);
+        if (!bReady) return false;
+
+        GDesktop = Desktop;
+        if (!GDesktop.bShellOnProgman) ShowWindow(GDesktop.WorkerW, SW_SHOWNA);
+
+        HWND InsertAfter = GDesktop.ShellDefView;
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
+        {
+            auto& Monitor = GMonitors[Index];
+            if (Monitor.Window) continue;
+
+            HWND Window = CreateWallpaperWindow(GDesktop, Monitor.Rect, Index, InsertAfter);
+            if (!Window) return false;
+            if (Monitor.Player && !RebindPlayerWindow(Monitor.Player, Window))
+            {
+                Log(L"Failed to re-bind the player for monitor " + std::to_wstring(Index));
+                DestroyWindow(Window);
+                return false;
+            }
+            GWindowCache.AddOwnWindow(Window);
+            Monitor.Window = Window;
+            Monitor.LowPowerStep = SIZE_MAX; // Re-seek so the new window gets a frame
+        }
+
+        HideStaticWallpaper(GDesktop);
+        if (GConfig.bSpanMode) ApplySpanViewports();
+        if (GSoftwarePipeline) GSoftwarePipeline->SetLayout(BuildSoftwareLayout());
+        return true;
+    }
+
+    void RunShellAttachAction(EShellAttachAction Action)
+    {
+        int64_t NowMs = static_cast<int64_t>(GetTickCount64());
+        switch (Action)
+        {
+        case EShellAttachAction::Suspend:
+            TRACE_INSTANT("Shell.Lost", static_cast<int64_t>(GShellAttach.GetLossCount()));
+            GMasterClock.Pause(MasterClockNowNs());
+            if (GSoftwarePipeline) GSoftwarePipeline->SetPaused(true);
+            for (auto& Monitor : GMonitors)
+            {
+                if (Monitor.Player) Monitor.Player->Pause();
+            }
+            Log(L"Wallpaper host lost; presentation suspended until the shell is back.");
+            break;
+        case EShellAttachAction::Discover:
+            RunShellAttachAction(GShellAttach.OnDiscoveryResult(ReattachToShell(), NowMs));
+            break;
+        case EShellAttachAction::Resume:
+            TRACE_INSTANT("Shell.Reattached", GShellAttach.GetLastDowntimeMs());
+            Log
+            (
+                L"Re-attached to the shell after " + std::to_wstring(GShellAttach.GetLastDowntimeMs())
+                + L" ms (" + std::to_wstring(GShellAttach.GetAttempts()) + L" attempt(s))."
+            );
+            if (GbPaused || GbAutoPausedByFullscreen) break;
+            GMasterClock.Resume(MasterClockNowNs());
+            if (GSoftwarePipeline) GSoftwarePipeline->SetPaused(!GLifecycle.IsAnyActive());
+            for (auto& Monitor : GMonitors)
+            {
+                if (Monitor.Player && !Monitor.bLowPower && !Monitor.bDormant) Monitor.Player->Play();
+            }
+            break;
+        case EShellAttachAction::Reload:
+            Log(L"Shell did not come back in time; reloading the wallpaper.");
+            if (!ReloadWallpaper()) Log(L"ERROR: Reload after shell restart failed.");
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * Switches videos in place and remembers the choice in config.txt; false if no pipeline
+     * could be created. The software presenter crossfades; EVR players are rebuilt.
+     */
+    bool SetVideo(const std::wstring& Path)
+    {
+        WriteConfigVideoPath(Path);
+        GConfig.VideoPath = Path;
+        GVideoPath = Path;
+        Log(L"Switching video: " + GVideoPath);
+        bool bFaded = CrossfadeSoftwarePipeline();
+        if (!bFaded && !ReloadWallpaper()) return false;
+
+        // A switch always plays; the pause toggle also resumes the master clock.
+        if (bFaded && GbPaused) SendMessageW(GMsgWindow, WM_COMMAND, ID_TRAY_PAUSE, 0);
+        GbPaused = false;
+        GbAutoPausedByFullscreen = false;
+        if (bFaded) GSoftwarePipeline->SetPaused(!GLifecycle.IsAnyActive());
+        return true;
+    }
+
     void ChangeVideo()
     {
         wchar_t FilePath[MAX_PATH] = {};
@@ -1049,7 +3082,7 @@ namespace
         OpenFileName.lStructSize = sizeof(OpenFileName);
         OpenFileName.hwndOwner = GMsgWindow;
         OpenFileName.lpstrFilter = 
-            L"Video Files\0*.mp4;*.wmv;*.avi;*.mkv;*.mov;*.webm\0All Files\0*.*\0";
+            L"Video Files\0*.mp4;*.wmv;*.avi;*.mkv;*.mov;*.webm\0Animated Images\0*.gif;*.png;*.apng\0All Files\0*.*\0";
 
         OpenFileName.lpstrFile = FilePath;
         OpenFileName.nMaxFile = MAX_PATH;
@@ -1058,38 +3091,420 @@ namespace
 
         if (!GetOpenFileNameW(&OpenFileName)) return;
 
-        std::wstring ConfigPath = GetExeDir() + L"\\config.txt";
-        std::wofstream ConfigFile(ConfigPath.c_str());
-        ConfigFile << FilePath;
-        ConfigFile.close();
+        if (!SetVideo(FilePath))
+        {
+            MessageBoxW
+            (
+                nullptr, 
+                L"Failed to create player for the selected video.",
+                L"VideoWallpaper",
+                MB_ICONERROR
+            );
+        }
+    }
 
-        GVideoPath = FilePath;
-        ShutdownAllMonitors();
-        Log(L"Reloading video: " + GVideoPath);
+    std::string WideToUtf8(const std::wstring& Text)
+    {
+        int32_t Size = WideCharToMultiByte(CP_UTF8, 0, Text.data(), static_cast<int32_t>(Text.size()), nullptr, 0, nullptr, nullptr);
+        std::string Result(Size > 0 ? Size : 0, '\0');
+        if (Size > 0) WideCharToMultiByte(CP_UTF8, 0, Text.data(), static_cast<int32_t>(Text.size()), Result.data(), Size, nullptr, nullptr);
+        return Result;
+    }
 
-        GDesktop = FindDesktopWindows();
-        if (!GDesktop.Progman) return;
+    std::wstring Utf8ToWide(std::string_view Text)
+    {
+        int32_t Size = MultiByteToWideChar(CP_UTF8, 0, Text.data(), static_cast<int32_t>(Text.size()), nullptr, 0);
+        std::wstring Result(Size > 0 ? Size : 0, L'\0');
+        if (Size > 0) MultiByteToWideChar(CP_UTF8, 0, Text.data(), static_cast<int32_t>(Text.size()), Result.data(), Size);
+        return Result;
+    }
 
-        if (!GDesktop.bShellOnProgman)
+    /** Key=value lines describing the running instance, for "vwctl status". */
+    std::string FormatControlStatus()
+    {
+        const char* State = !GShellAttach.IsAttached() ? "detached"
+                          : GbPaused ? "paused"
+                          : GbAutoPausedByFullscreen ? "auto-paused"
+                          : !GLifecycle.IsAnyActive() ? "hidden"
+                          : "playing";
+        std::string Status = "\nvideo=" + WideToUtf8(GVideoPath);
+        Status += "\npresenter=" + std::string(GSoftwarePipeline ? "software" : "evr");
+        Status += "\nstate=" + std::string(State);
+        Status += "\nmuted=" + std::to_string(GbMuted ? 1 : 0);
+        Status += "\nmonitors=" + std::to_string(GMonitors.size());
+        for (size_t Index = 0; Index < GMonitors.size(); ++Index)
         {
-            HWND Host = GDesktop.WorkerW ? GDesktop.WorkerW : GDesktop.Progman;
-            ShowWindow(Host, SW_SHOWNA);
+            const auto& Monitor = GMonitors[Index];
+            Status += "\nmonitor." + std::to_string(Index) + "="
+                + std::to_string(Monitor.Rect.right - Monitor.Rect.left) + "x"
+                + std::to_string(Monitor.Rect.bottom - Monitor.Rect.top) + " "
+                + (Index < GLifecycle.GetMonitorCount() ? GetLifecycleStateName(GLifecycle.GetState(Index)) : "?")
+                + (Monitor.bLowPower ? " lowpower" : "")
+                + (Monitor.Player && !GRenditions.empty() ? " " + WideToUtf8(GetRenditionName(Monitor.Rendition)) : "");
+        }
+        if (GMasterClock.IsRunning())
+        {
+            Status += "\nposition_ms=" + std::to_string(GMasterClock.GetPosition100ns(MasterClockNowNs()) / 10000);
+        }
+        if (GSoftwarePipeline)
+        {
+            Status += "\nsoftware.frames=" + std::to_string(GSoftwarePipeline->GetStats().Frames);
+            Status += "\nsoftware.dropped=" + std::to_string(GSoftwarePipeline->GetDroppedFrames());
+            Status += "\nsoftware.level=" + std::to_string(GPresenterQuality.GetLevel());
+            Status += "\nsoftware.rendition=" + WideToUtf8(GetRenditionName(GSoftwareRendition));
+        }
+        PROCESS_MEMORY_COUNTERS Memory = {};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &Memory, sizeof(Memory)))
+        {
+            Status += "\nworking_set_kb=" + std::to_string(Memory.WorkingSetSize / 1024);
         }
+        const FMemoryGovernorStats& MemoryStats = GMemoryGovernor.GetStats();
+        Status += "\nmemory.peak_kb=" + std::to_string(MemoryStats.PeakResidentBytes / 1024);
+        Status += "\nmemory.cache_kb=" + std::to_string(MemoryStats.CacheBytes / 1024);
+        Status += "\nmemory.cache_level=" + std::to_string(GMemoryGovernor.GetCacheLevel());
+        Status += "\nmemory.trims=" + std::to_string(MemoryStats.Trims);
+        Status += "\nmemory.degrades=" + std::to_string(MemoryStats.Degrades);
+        Status += "\nmemory.restores=" + std::to_string(MemoryStats.Restores);
+        Status += "\nmemory.last_reason=" + std::string(GetMemoryReasonName(MemoryStats.LastReason));
+        FQosStats Qos = GQos.GetStats();
+        Status += "\nqos.priority=" + std::string(GetQosLevelName(GConfig.Priority));
+        Status += "\nqos.boost=" + std::to_string(Qos.Boost);
+        Status += "\nqos.frame_level=" + std::string(GetQosLevelName(Qos.Levels[static_cast<size_t>(EWorkClass::Decode)]));
+        Status += "\nqos.failures=" + std::to_string(Qos.Failed);
+        if (GSoftwarePipeline)
+        {
+            FDeadlineStats Deadline = GSoftwarePipeline->GetDeadlineStats();
+            Status += "\nqos.near_misses=" + std::to_string(Deadline.NearMisses);
+            Status += "\nqos.escalations=" + std::to_string(Deadline.Escalations);
+        }
+        return Status;
+    }
 
-        if (!CreateMonitorWallpapers(GDesktop)) return;
-        if (!CreatePlayers())
+    /** OS totals for the whole process, kept next to the per-subsystem counters as "Process". */
+    void SampleProcessResources()
+    {
+        HANDLE Process = GetCurrentProcess();
+        // USER objects are mostly windows, hence the window kind.
+        GResources.SetGauge("Process", EResourceKind::Window, GetGuiResources(Process, GR_USEROBJECTS));
+        GResources.SetGauge("Process", EResourceKind::Gdi, GetGuiResources(Process, GR_GDIOBJECTS));
+        DWORD Handles = 0;
+        if (GetProcessHandleCount(Process, &Handles)) GResources.SetGauge("Process", EResourceKind::Handle, Handles);
+        PROCESS_MEMORY_COUNTERS_EX Memory = {};
+        if (GetProcessMemoryInfo(Process, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&Memory), sizeof(Memory)))
         {
-            MessageBoxW
+            GResources.SetGauge("Process", EResourceKind::HeapBytes, static_cast<int64_t>(Memory.PrivateUsage));
+        }
+    }
+
+    std::string FormatResourceReport()
+    {
+        SampleProcessResources();
+        std::ostringstream Out;
+        WriteResourceSnapshot(Out, GResources.Snapshot());
+        return Out.str();
+    }
+
+    /** Logs the counters that moved since the previous checkpoint; Reason names what just happened. */
+    void LogResourceCheckpoint(const wchar_t* Reason)
+    {
+        static FResourceSnapshot Previous;
+        if (!GResources.IsEnabled()) return;
+        SampleProcessResources();
+        FResourceSnapshot Current = GResources.Snapshot();
+        std::ostringstream Out;
+        WriteResourceDiff(Out, DiffResourceSnapshots(Previous, Current));
+        Previous = std::move(Current);
+
+        std::string Diff = Out.str();
+        if (!Diff.empty()) Diff.pop_back();
+        Log(L"Resources after " + std::wstring(Reason) + (Diff.empty() ? L": unchanged." : L":\n" + AsciiToWide(Diff.c_str())));
+    }
+
+    /** Periodic checkpoint, so slow growth shows up without a reload or display change. */
+    void TickResourceCheckpoint()
+    {
+        static int32_t Ticks = 0;
+        if (!GResources.IsEnabled() || ++Ticks < ResourceCheckpointTicks) return;
+        Ticks = 0;
+        LogResourceCheckpoint(L"periodic check");
+    }
+
+    /** Low-power settings changed at runtime: index the video if needed, or re-select the schedule. */
+    void ApplyLowPowerSettings(ELowPowerScope PreviousScope)
+    {
+        bool bHavePlayers = !GMonitors.empty() && !GSoftwarePipeline && !GbPipelinesReleased;
+        if (PreviousScope == ELowPowerScope::Off && GConfig.LowPower != ELowPowerScope::Off)
+        {
+            if (bHavePlayers && !GbKeyframeIndexPending) StartKeyframeIndexing();
+        }
+        else if (!GbKeyframeIndexPending && GKeyframeIndex.GetSampleCount())
+        {
+            GLowPowerSteps = GKeyframeIndex.Select(GConfig.Subsample);
+            for (auto& Monitor : GMonitors) Monitor.LowPowerStep = SIZE_MAX;
+        }
+        UpdateLowPowerMonitors();
+    }
+
+    /** "set <key> <value>": lifecycle and low-power keys apply live; layout and presenter keys rebuild in place. */
+    FControlResponse ApplyControlSetting(const std::string& Argument)
+    {
+        std::string_view Key;
+        std::string_view Value;
+        SplitControlWord(Argument, Key, Value);
+        if (Value.empty()) return { false, "usage: set <key> <value>" };
+
+        ELowPowerScope PreviousScope = GConfig.LowPower;
+        if (!ApplyConfigSetting(GConfig, Utf8ToWide(Key), Utf8ToWide(Value)))
+        {
+            return { false, "unknown setting '" + std::string(Key) + "'" };
+        }
+
+        if (Key == "release_after" || Key == "pause_dimmed")
+        {
+            GLifecycle.Configure(GConfig.Lifecycle);
+            UpdateLifecycle();
+            return { true, "applied" };
+        }
+        if (Key.starts_with("lowpower"))
+        {
+            ApplyLowPowerSettings(PreviousScope);
+            return { true, "applied" };
+        }
+        if (Key == "crossfade_ms") return { true, "applied" };
+        if (Key == "memory_ceiling_mb")
+        {
+            ConfigureMemoryGovernor();
+            return { true, "applied" };
+        }
+        if (Key == "priority" || Key == "efficiency_cores")
+        {
+            ConfigureQos();
+            return { true, "applied" };
+        }
+        if (!ReloadWallpaper()) return { false, "rebuild failed" };
+        return { true, "rebuilt" };
+    }
+
+    FControlResponse HandleControlRequest(const FControlRequest& Request)
+    {
+        TRACE_INSTANT("Control", static_cast<int64_t>(Request.Command));
+        switch (Request.Command)
+        {
+        case EControlCommand::Status:
+            return { true, FormatControlStatus() };
+        case EControlCommand::Pause:
+        case EControlCommand::Resume:
+        case EControlCommand::Toggle:
+        {
+            bool bWantPaused = Request.Command == EControlCommand::Toggle
+                ? !GbPaused
+                : Request.Command == EControlCommand::Pause;
+            if (bWantPaused != GbPaused) SendMessageW(GMsgWindow, WM_COMMAND, ID_TRAY_PAUSE, 0);
+            return { true, GbPaused ? "paused" : "playing" };
+        }
+        case EControlCommand::Mute:
+        case EControlCommand::Unmute:
+            if ((Request.Command == EControlCommand::Mute) != GbMuted) SendMessageW(GMsgWindow, WM_COMMAND, ID_TRAY_MUTE, 0);
+            return { true, GbMuted ? "muted" : "unmuted" };
+        case EControlCommand::Video:
+        {
+            std::wstring Path = Utf8ToWide(Request.Argument);
+            if (GetFileAttributesW(Path.c_str()) == INVALID_FILE_ATTRIBUTES) return { false, "file not found" };
+            if (!SetVideo(Path)) return { false, "failed to create player" };
+            return { true, "playing " + Request.Argument };
+        }
+        case EControlCommand::Set:
+            return ApplyControlSetting(Request.Argument);
+        case EControlCommand::Resources:
+            if (!GResources.IsEnabled()) return { false, "resource tracking is off (needs resources.flag at startup)" };
+            return { true, "\n" + FormatResourceReport() };
+        case EControlCommand::Reload:
+            Log(L"Control: reload.");
+            if (!ReloadWallpaper()) return { false, "rebuild failed" };
+            return { true, "rebuilt" };
+        case EControlCommand::Quit:
+            // Posted: quitting joins the server thread, which is waiting for this reply.
+            PostMessageW(GMsgWindow, WM_COMMAND, ID_TRAY_QUIT, 0);
+            return { true, "quitting" };
+        default:
+            return { false, "unsupported command" };
+        }
+    }
+
+    /** The pipe is per session, so instances in different sessions of a shared host do not collide. */
+    std::wstring GetControlPipeName()
+    {
+        DWORD SessionId = 0;
+        ProcessIdToSessionId(GetCurrentProcessId(), &SessionId);
+        return L"\\\\.\\pipe\\" + AsciiToWide(ControlEndpointName) + L"." + std::to_wstring(SessionId);
+    }
+
+    /** Waits for an overlapped pipe operation; false if it failed or the server is stopping. */
+    bool FinishPipeIo(HANDLE Pipe, OVERLAPPED& Overlapped, BOOL bCompleted, DWORD& Bytes)
+    {
+        if (!bCompleted && GetLastError() != ERROR_IO_PENDING) return false;
+        HANDLE Handles[2] = { Overlapped.hEvent, GControlStopEvent };
+        if (WaitForMultipleObjects(2, Handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+        {
+            CancelIo(Pipe);
+            GetOverlappedResult(Pipe, &Overlapped, &Bytes, TRUE);
+            return false;
+        }
+        return GetOverlappedResult(Pipe, &Overlapped, &Bytes, FALSE) != FALSE;
+    }
+
+    void ServeControlClient(HANDLE Pipe, HANDLE IoEvent, HWND Target)
+    {
+        FControlConnection Connection;
+        char Buffer[4096];
+        std::string Out;
+        for (;;)
+        {
+            OVERLAPPED Overlapped = {};
+            Overlapped.hEvent = IoEvent;
+            DWORD Bytes = 0;
+            BOOL bRead = ReadFile(Pipe, Buffer, sizeof(Buffer), nullptr, &Overlapped);
+            if (!FinishPipeIo(Pipe, Overlapped, bRead, Bytes) || !Bytes) return;
+
+            Out.clear();
+            bool bValid = Connection.Receive
             (
-                nullptr, 
-                L"Failed to create player for the selected video.",
-                L"VideoWallpaper",
-                MB_ICONERROR
+                Buffer, Bytes,
+                [Target](const FControlRequest& Request)
+                {
+                    // All state lives on the UI thread: run the command there and wait for its reply.
+                    FControlExchange Exchange{ &Request, { false, "not running" } };
+                    SendMessageW(Target, WM_CONTROL_REQUEST, 0, reinterpret_cast<LPARAM>(&Exchange));
+                    return Exchange.Response;
+                },
+                Out
             );
+            if (!Out.empty())
+            {
+                OVERLAPPED WriteOverlapped = {};
+                WriteOverlapped.hEvent = IoEvent;
+                BOOL bWritten = WriteFile(Pipe, Out.data(), static_cast<DWORD>(Out.size()), nullptr, &WriteOverlapped);
+                if (!FinishPipeIo(Pipe, WriteOverlapped, bWritten, Bytes)) return;
+            }
+            if (!bValid) return;
+        }
+    }
+
+    /**
+     * Security for the control pipe: a DACL whose only entry is the current user, so
+     * other users of a shared host can neither connect nor open another instance of
+     * the name. Holds the buffers the descriptor points into.
+     */
+    struct FControlPipeSecurity
+    {
+        std::vector<BYTE> User;
+        std::vector<BYTE> Acl;
+        SECURITY_DESCRIPTOR Descriptor = {};
+        SECURITY_ATTRIBUTES Attributes = {};
+
+        bool Init()
+        {
+            HANDLE Token = nullptr;
+            if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &Token)) return false;
+            DWORD Size = 0;
+            GetTokenInformation(Token, TokenUser, nullptr, 0, &Size);
+            User.resize(Size);
+            bool bUser = Size && GetTokenInformation(Token, TokenUser, User.data(), Size, &Size);
+            CloseHandle(Token);
+            if (!bUser) return false;
+
+            PSID Sid = reinterpret_cast<TOKEN_USER*>(User.data())->User.Sid;
+            Acl.resize(sizeof(ACL) + sizeof(ACCESS_ALLOWED_ACE) + GetLengthSid(Sid));
+            PACL Dacl = reinterpret_cast<PACL>(Acl.data());
+            if (!InitializeAcl(Dacl, static_cast<DWORD>(Acl.size()), ACL_REVISION)
+                || !AddAccessAllowedAce(Dacl, ACL_REVISION, GENERIC_ALL, Sid)
+                || !InitializeSecurityDescriptor(&Descriptor, SECURITY_DESCRIPTOR_REVISION)
+                || !SetSecurityDescriptorDacl(&Descriptor, TRUE, Dacl, FALSE))
+            {
+                return false;
+            }
+            Attributes.nLength = sizeof(Attributes);
+            Attributes.lpSecurityDescriptor = &Descriptor;
+            Attributes.bInheritHandle = FALSE;
+            return true;
+        }
+    };
+
+    /**
+     * One client at a time; a client may send several requests before it disconnects.
+     * Every instance is created as the first one of its name, so a pipe another process
+     * already holds is never joined; creation failures are reported to the UI thread
+     * once per distinct error and retried.
+     */
+    void RunControlServer(HWND Target)
+    {
+        std::wstring Name = GetControlPipeName();
+        FControlPipeSecurity Security;
+        if (!Security.Init())
+        {
+            PostMessageW(Target, WM_CONTROL_SERVER_ERROR, GetLastError(), 0);
             return;
         }
-        GbPaused = false;
-        GbAutoPausedByFullscreen = false;
+        HANDLE IoEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        DWORD LastError = ERROR_SUCCESS;
+        while (IoEvent && WaitForSingleObject(GControlStopEvent, 0) == WAIT_TIMEOUT)
+        {
+            HANDLE Pipe = CreateNamedPipeW
+            (
+                Name.c_str(),
+                PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                1, 4096, 4096, 0, &Security.Attributes
+            );
+            if (Pipe == INVALID_HANDLE_VALUE)
+            {
+                DWORD Error = GetLastError();
+                if (Error != LastError) PostMessageW(Target, WM_CONTROL_SERVER_ERROR, Error, 0);
+                LastError = Error;
+                WaitForSingleObject(GControlStopEvent, 5000);
+                continue;
+            }
+            LastError = ERROR_SUCCESS;
+
+            OVERLAPPED Overlapped = {};
+            Overlapped.hEvent = IoEvent;
+            DWORD Bytes = 0;
+            BOOL bConnected = ConnectNamedPipe(Pipe, &Overlapped);
+            // A client that connected between CreateNamedPipe and ConnectNamedPipe does not signal the event.
+            bool bReady = !bConnected && GetLastError() == ERROR_PIPE_CONNECTED
+                ? true
+                : FinishPipeIo(Pipe, Overlapped, bConnected, Bytes);
+            if (bReady) ServeControlClient(Pipe, IoEvent, Target);
+
+            DisconnectNamedPipe(Pipe);
+            CloseHandle(Pipe);
+        }
+        if (IoEvent) CloseHandle(IoEvent);
+    }
+
+    void StartControlServer(HWND Target)
+    {
+        GControlStopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!GControlStopEvent) return;
+        GControlServerTask.Run([Target]() { RunControlServer(Target); });
+        Log(L"Control endpoint: " + GetControlPipeName());
+    }
+
+    void StopControlServer()
+    {
+        if (!GControlStopEvent) return;
+        SetEvent(GControlStopEvent);
+
+        // The server may be blocked sending a request to this thread; keep servicing those.
+        while (!GControlServerTask.WaitFor(std::chrono::milliseconds(0)))
+        {
+            MsgWaitForMultipleObjects(0, nullptr, FALSE, 10, QS_SENDMESSAGE);
+            MSG Msg;
+            PeekMessageW(&Msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+        }
+        GControlServerTask.Join();
+        CloseHandle(GControlStopEvent);
+        GControlStopEvent = nullptr;
     }
 }
 
@@ -1106,8 +3521,8 @@ int WINAPI wWinMain(HINSTANCE Instance, HINSTANCE, PWSTR, int)
                 GetProcAddress(User32, "SetProcessDpiAwarenessContext"))
             : nullptr;
         // DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2 = (HANDLE)-4
-        if (Fn) Fn(reinterpret_cast<HANDLE>(-4));
-        else    SetProcessDPIAware(); // Vista+ fallback
+        GbPerMonitorDpiAware = Fn && Fn(reinterpret_cast<HANDLE>(-4));
+        if (!GbPerMonitorDpiAware) SetProcessDPIAware(); // Vista+ fallback
     }
 
     GInstance = Instance;
@@ -1127,8 +3542,22 @@ int WINAPI wWinMain(HINSTANCE Instance, HINSTANCE, PWSTR, int)
 
     GbDebugEnabled = IsDebugFlagPresent();
     if (GbDebugEnabled) Log(L"Debug logging enabled.");
+    if (IsTraceFlagPresent())
+    {
+        GTrace.SetEnabled(true);
+        Log(L"Tracing enabled (trace.flag).");
+    }
+    if (IsResourceFlagPresent())
+    {
+        GResources.SetEnabled(true);
+        Log(L"Resource tracking enabled (resources.flag).");
+    }
 
-    GVideoPath = ReadVideoPath();
+    GConfig = ReadConfig();
+    GVideoPath = GConfig.VideoPath;
+    GLifecycle.Configure(GConfig.Lifecycle);
+    ConfigureMemoryGovernor();
+    ConfigureQos();
     if (GVideoPath.empty())
     {
         MessageBoxW
@@ -1203,7 +3632,7 @@ int WINAPI wWinMain(HINSTANCE Instance, HINSTANCE, PWSTR, int)
         return 1;
     }
 
-    if (!CreatePlayers())
+    if (!CreatePipelines())
     {
         std::wstring ErrorMsg = L"Failed to create media player.\n\nFile: " + GVideoPath;
         MessageBoxW(nullptr, ErrorMsg.c_str(), L"VideoWallpaper", MB_ICONERROR);
@@ -1212,14 +3641,13 @@ int WINAPI wWinMain(HINSTANCE Instance, HINSTANCE, PWSTR, int)
         return 1;
     }
 
-    EmptyWorkingSet(GetCurrentProcess());
-    Log(L"Working set trimmed after player init.");
-
+    // Hidden top-level rather than message-only: only top-level windows receive
+    // the TaskbarCreated broadcast that announces an Explorer restart.
     GMsgWindow = CreateWindowExW
     (
-        0, MsgClassName, L"", 0,
+        WS_EX_TOOLWINDOW, MsgClassName, L"", WS_POPUP,
         0, 0, 0, 0,
-        HWND_MESSAGE, nullptr, Instance, nullptr
+        nullptr, nullptr, Instance, nullptr
     );
     if (!GMsgWindow)
     {
@@ -0,0 +1,980 @@
+// VideoWallpaper for X11 - Live video wallpaper on Linux desktops.
+// Draws behind the desktop either straight onto the root window (bare X servers,
+// window managers without a desktop) or into one _NET_WM_WINDOW_TYPE_DESKTOP
+// window per monitor. Monitors come from XRandR and follow hot-plug and mode
+// changes. Frames are decoded once by the shared software pipeline and blitted
+// with MIT-SHM, so the server reads pixels straight from shared memory; plain
+// XPutImage is the fallback on remote displays. Runs headless under Xvfb:
+//   xvfb-run -a -s "-screen 0 1920x1080x24" ./videowallpaper-x11 --pattern --seconds 10
+// Usage: videowallpaper-x11 [--host auto|root|desktop] [--mode clone|span]
+//                           [--loop wrap|pingpong] [--memory-ceiling-mb N]
+//                           [--decode-service] [--decode-socket PATH]
+//                           [--priority normal|background|idle] [--efficiency-cores]
+//                           [--seconds N] (--pattern | :pattern:OPTIONS | <video>)
+// Videos are decoded by an ffmpeg child process (raw NV12 over a pipe); GIF and
+// PNG/APNG files use the built-in animated-image decoders and frame cache; Y4M files
+// are played straight from a memory mapping, and --pattern (or a ":pattern:..." path
+// picking the scene, size and rate) needs no decoder at all. --loop pingpong plays
+// videos forwards, then backwards. Memory is sampled from /proc by the same
+// governor as on Windows; --memory-ceiling-mb degrades frame caches to stay under a
+// resident ceiling. --decode-service takes frames from a running vwdecoded instead
+// of decoding, and decodes itself if the service is missing or goes away. Decode
+// and compose threads run at background priority by default and are raised while
+// frames run late (see qos.h); --efficiency-cores keeps them on a hybrid CPU's
+// efficiency cores. vwctl reaches a running instance through the control socket
+// (see control_socket.h). With --seconds the run ends after N seconds, prints
+// presenter statistics and exits with 1 if nothing was presented.
+
+// Ahead of Xlib, whose Status macro would break the control protocol's enum.
+#include "control_socket.h"
+#include "decode_service.h"
+
+/** EControlCommand::Status, named where Xlib's macro cannot reach it. */
+constexpr EControlCommand ControlStatusCommand = EControlCommand::Status;
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xrandr.h>
+#include <poll.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "animation_cache.h"
+#include "ffmpeg_source.h"
+#include "frame.h"
+#include "memory_governor.h"
+#include "pattern_source.h"
+#include "pingpong.h"
+#include "qos_linux.h"
+#include "rendition.h"
+#include "resource_tracker.h"
+#include "software_pipeline.h"
+#include "span_layout.h"
+#include "trace.h"
+#include "video_source.h"
+#include "y4m_source.h"
+
+/** Event loop wake-up interval while idle; bounds quit and --seconds latency. */
+constexpr int32_t EventPollMs = 250;
+
+/** Memory governor sampling interval, as on Windows. */
+constexpr int32_t MemoryTickMs = 500;
+
+/** Fade of a video switched through the control endpoint (the Windows crossfade_ms default). */
+constexpr int64_t ControlCrossfadeNs = 1000000000;
+
+namespace
+{
+    enum class EDesktopHost : uint8_t
+    {
+        Auto,       // Desktop windows under an EWMH window manager, else the root window
+        Root,
+        Desktop
+    };
+
+    struct FX11Options
+    {
+        EDesktopHost Host = EDesktopHost::Auto;
+        bool bSpanMode = false;
+        bool bPingPong = false;
+        int64_t MemoryCeilingBytes = 0;
+        int32_t Seconds = 0;        // 0 = run until SIGINT/SIGTERM
+        bool bPattern = false;
+        bool bDecodeService = false;
+        std::string DecodeSocket;   // Empty: GetDecodeServicePath()
+        std::string VideoPath;
+        std::vector<TRendition<std::string>> Renditions;
+        EQosLevel Priority = EQosLevel::Background;
+        bool bEfficiencyCores = false;
+    };
+
+    std::atomic<bool> GbQuitRequested{ false };
+
+    /** X errors on the presenting connection are expected while windows are being replaced. */
+    std::atomic<uint64_t> GX11Errors{ 0 };
+
+    int OnX11Error(Display*, XErrorEvent*)
+    {
+        GX11Errors.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    /** A monitor's region of a drawable: its own desktop window at 0,0, or the root window at the monitor's origin. */
+    struct FX11Surface
+    {
+        Window Drawable = None;
+        int32_t X = 0;
+        int32_t Y = 0;
+
+        bool operator==(const FX11Surface& Other) const
+        {
+            return Drawable == Other.Drawable && X == Other.X && Y == Other.Y;
+        }
+    };
+
+    /** The root window's monitors from XRandR: RandR 1.5 monitors, else active CRTCs, else the whole screen. */
+    std::vector<FIntRect> EnumerateMonitors(Display* Connection, bool bHaveRandr)
+    {
+        std::vector<FIntRect> Rects;
+        Window Root = DefaultRootWindow(Connection);
+        int32_t Major = 0;
+        int32_t Minor = 0;
+        if (bHaveRandr && XRRQueryVersion(Connection, &Major, &Minor) && (Major > 1 || Minor >= 5))
+        {
+            int32_t Count = 0;
+            XRRMonitorInfo* Monitors = XRRGetMonitors(Connection, Root, True, &Count);
+            for (int32_t Index = 0; Monitors && Index < Count; ++Index)
+            {
+                const XRRMonitorInfo& Monitor = Monitors[Index];
+                Rects.push_back({ Monitor.x, Monitor.y, Monitor.x + Monitor.width, Monitor.y + Monitor.height });
+            }
+            if (Monitors) XRRFreeMonitors(Monitors);
+        }
+        else if (bHaveRandr)
+        {
+            XRRScreenResources* Resources = XRRGetScreenResourcesCurrent(Connection, Root);
+            for (int32_t Index = 0; Resources && Index < Resources->ncrtc; ++Index)
+            {
+                XRRCrtcInfo* Crtc = XRRGetCrtcInfo(Connection, Resources, Resources->crtcs[Index]);
+                if (Crtc && Crtc->mode != None && Crtc->width && Crtc->height)
+                {
+                    Rects.push_back
+                    ({
+                        Crtc->x, Crtc->y,
+                        Crtc->x + static_cast<int32_t>(Crtc->width), Crtc->y + static_cast<int32_t>(Crtc->height)
+                    });
+                }
+                if (Crtc) XRRFreeCrtcInfo(Crtc);
+            }
+            if (Resources) XRRFreeScreenResources(Resources);
+        }
+        if (Rects.empty())
+        {
+            int32_t Screen = DefaultScreen(Connection);
+            Rects.push_back({ 0, 0, DisplayWidth(Connection, Screen), DisplayHeight(Connection, Screen) });
+        }
+        return Rects;
+    }
+
+    /** An EWMH window manager advertises itself on the root window and stacks desktop-type windows at the bottom. */
+    bool IsEwmhWindowManagerRunning(Display* Connection)
+    {
+        Atom SupportingCheck = XInternAtom(Connection, "_NET_SUPPORTING_WM_CHECK", False);
+        Atom Type = None;
+        int Format = 0;
+        unsigned long Count = 0;
+        unsigned long After = 0;
+        unsigned char* Data = nullptr;
+        int Result = XGetWindowProperty
+        (
+            Connection, DefaultRootWindow(Connection), SupportingCheck, 0, 1, False, XA_WINDOW,
+            &Type, &Format, &Count, &After, &Data
+        );
+        bool bRunning = Result == Success && Type == XA_WINDOW && Count == 1;
+        if (Data) XFree(Data);
+        return bRunning;
+    }
+
+    /** Borderless, sticky, below everything and out of taskbars and pagers: the EWMH desktop. */
+    Window CreateDesktopWindow(Display* Connection, const FIntRect& Rect)
+    {
+        int32_t Screen = DefaultScreen(Connection);
+        XSetWindowAttributes Attributes = {};
+        Attributes.background_pixmap = None;
+        Attributes.event_mask = ExposureMask | StructureNotifyMask;
+        Window Desktop = XCreateWindow
+        (
+            Connection, RootWindow(Connection, Screen),
+            Rect.Left, Rect.Top, static_cast<unsigned>(Rect.Width()), static_cast<unsigned>(Rect.Height()),
+            0, CopyFromParent, InputOutput, CopyFromParent,
+            CWBackPixmap | CWEventMask, &Attributes
+        );
+
+        Atom WindowType = XInternAtom(Connection, "_NET_WM_WINDOW_TYPE", False);
+        Atom DesktopType = XInternAtom(Connection, "_NET_WM_WINDOW_TYPE_DESKTOP", False);
+        XChangeProperty
+        (
+            Connection, Desktop, WindowType, XA_ATOM, 32, PropModeReplace,
+            reinterpret_cast<unsigned char*>(&DesktopType), 1
+        );
+        Atom States[] =
+        {
+            XInternAtom(Connection, "_NET_WM_STATE_BELOW", False),
+            XInternAtom(Connection, "_NET_WM_STATE_STICKY", False),
+            XInternAtom(Connection, "_NET_WM_STATE_SKIP_TASKBAR", False),
+            XInternAtom(Connection, "_NET_WM_STATE_SKIP_PAGER", False)
+        };
+        XChangeProperty
+        (
+            Connection, Desktop, XInternAtom(Connection, "_NET_WM_STATE", False), XA_ATOM, 32, PropModeReplace,
+            reinterpret_cast<unsigned char*>(States), static_cast<int>(std::size(States))
+        );
+        unsigned long AllDesktops = 0xFFFFFFFFul;
+        XChangeProperty
+        (
+            Connection, Desktop, XInternAtom(Connection, "_NET_WM_DESKTOP", False), XA_CARDINAL, 32, PropModeReplace,
+            reinterpret_cast<unsigned char*>(&AllDesktops), 1
+        );
+        XStoreName(Connection, Desktop, "VideoWallpaper");
+
+        XMapWindow(Connection, Desktop);
+        XLowerWindow(Connection, Desktop);
+        RESOURCE_ACQUIRE("X11.Window", Window);
+        return Desktop;
+    }
+
+    /**
+     * X11 side of the software presenter. Each surface gets a BGRX image the size of
+     * its monitor; dirty rects are copied into it and put with XShmPutImage (or
+     * XPutImage without MIT-SHM). Owns its connection: the decode thread and the
+     * event loop each present through their own instance.
+     */
+    class FX11Presenter final : public ISurfacePresenter<FX11Surface>
+    {
+    public:
+        explicit FX11Presenter(bool bInAllowShm) : bAllowShm(bInAllowShm) {}
+        ~FX11Presenter() override { Close(); }
+
+        FX11Presenter(const FX11Presenter&) = delete;
+        FX11Presenter& operator=(const FX11Presenter&) = delete;
+
+        /** Fails if the default visual is not 24/32-bit TrueColor in the canvas's BGRX byte order. */
+        bool Open(const char* DisplayName)
+        {
+            Connection = XOpenDisplay(DisplayName);
+            if (!Connection) return false;
+            Visual* DefaultVisualPtr = DefaultVisual(Connection, DefaultScreen(Connection));
+            Depth = DefaultDepth(Connection, DefaultScreen(Connection));
+            if
+            (
+                Depth < 24 || DefaultVisualPtr->red_mask != 0xFF0000 || DefaultVisualPtr->green_mask != 0xFF00
+                || DefaultVisualPtr->blue_mask != 0xFF
+            ) return false;
+            VisualPtr = DefaultVisualPtr;
+            Gc = XCreateGC(Connection, DefaultRootWindow(Connection), 0, nullptr);
+            bUseShm = bAllowShm && XShmQueryExtension(Connection);
+            return true;
+        }
+
+        /** Drops every image; the next Present() recreates them at the new monitor sizes. Any thread. */
+        void Invalidate() { bInvalidated.store(true, std::memory_order_release); }
+
+        bool IsUsingShm() const { return bUseShm; }
+        Display* GetConnection() const { return Connection; }
+
+        void Present(const FX11Surface& Surface, const FFrameView& View, const std::vector<FIntRect>& Rects) override
+        {
+            if (!Connection || !View.IsValid()) return;
+            if (bInvalidated.exchange(false, std::memory_order_acq_rel)) ReleaseImages();
+
+            FImage* Image = FindImage(Surface, View.Width, View.Height);
+            if (!Image) return;
+            for (const auto& Rect : Rects)
+            {
+                FFrameView Source = View.Crop(Rect);
+                if (!Source.IsValid()) continue;
+                for (int32_t Y = 0; Y < Source.Height; ++Y)
+                {
+                    std::memcpy
+                    (
+                        Image->Pixels->data + static_cast<ptrdiff_t>(Rect.Top + Y) * Image->Pixels->bytes_per_line
+                            + static_cast<ptrdiff_t>(Rect.Left) * 4,
+                        Source.Row(0, Y), static_cast<size_t>(Source.Width) * 4
+                    );
+                }
+                if (Image->bShm)
+                {
+                    XShmPutImage
+                    (
+                        Connection, Surface.Drawable, Gc, Image->Pixels, Rect.Left, Rect.Top,
+                        Surface.X + Rect.Left, Surface.Y + Rect.Top,
+                        static_cast<unsigned>(Source.Width), static_cast<unsigned>(Source.Height), False
+                    );
+                }
+                else
+                {
+                    XPutImage
+                    (
+                        Connection, Surface.Drawable, Gc, Image->Pixels, Rect.Left, Rect.Top,
+                        Surface.X + Rect.Left, Surface.Y + Rect.Top,
+                        static_cast<unsigned>(Source.Width), static_cast<unsigned>(Source.Height)
+                    );
+                }
+            }
+            // The server must be done reading the segment before the next frame is copied into it.
+            XSync(Connection, False);
+        }
+
+        void Close()
+        {
+            ReleaseImages();
+            if (Gc) XFreeGC(Connection, Gc);
+            Gc = nullptr;
+            if (Connection) XCloseDisplay(Connection);
+            Connection = nullptr;
+        }
+
+    private:
+        struct FImage
+        {
+            FX11Surface Surface;
+            XImage* Pixels = nullptr;
+            XShmSegmentInfo Segment = {};
+            bool bShm = false;
+        };
+
+        FImage* FindImage(const FX11Surface& Surface, int32_t Width, int32_t Height)
+        {
+            for (auto& Image : Images)
+            {
+                if (!(Image->Surface == Surface)) continue;
+                if (Image->Pixels->width == Width && Image->Pixels->height == Height) return Image.get();
+                DestroyImage(*Image);
+                Image = std::move(Images.back());
+                Images.pop_back();
+                break;
+            }
+            auto Image = std::make_unique<FImage>();
+            Image->Surface = Surface;
+            if (!(bUseShm && CreateShmImage(*Image, Width, Height)) && !CreatePlainImage(*Image, Width, Height)) return nullptr;
+            Images.push_back(std::move(Image));
+            return Images.back().get();
+        }
+
+        bool CreateShmImage(FImage& Image, int32_t Width, int32_t Height)
+        {
+            Image.Pixels = XShmCreateImage
+            (
+                Connection, VisualPtr, static_cast<unsigned>(Depth), ZPixmap, nullptr, &Image.Segment,
+                static_cast<unsigned>(Width), static_cast<unsigned>(Height)
+            );
+            if (!Image.Pixels) return false;
+            size_t Bytes = static_cast<size_t>(Image.Pixels->bytes_per_line) * static_cast<size_t>(Height);
+            Image.Segment.shmid = shmget(IPC_PRIVATE, Bytes, IPC_CREAT | 0600);
+            if (Image.Segment.shmid < 0)
+            {
+                XDestroyImage(Image.Pixels);
+                Image.Pixels = nullptr;
+                return false;
+            }
+            Image.Segment.shmaddr = Image.Pixels->data = static_cast<char*>(shmat(Image.Segment.shmid, nullptr, 0));
+            Image.Segment.readOnly = False;
+
+            // Attaching fails on connections that do not share our memory (remote displays).
+            uint64_t ErrorsBefore = GX11Errors.load(std::memory_order_relaxed);
+            bool bAttached = Image.Segment.shmaddr != reinterpret_cast<char*>(-1) && XShmAttach(Connection, &Image.Segment);
+            XSync(Connection, False);
+            bAttached = bAttached && GX11Errors.load(std::memory_order_relaxed) == ErrorsBefore;
+            // Marked for removal now, freed once both sides detach (or either exits).
+            shmctl(Image.Segment.shmid, IPC_RMID, nullptr);
+            if (!bAttached)
+            {
+                if (Image.Segment.shmaddr != reinterpret_cast<char*>(-1)) shmdt(Image.Segment.shmaddr);
+                Image.Pixels->data = nullptr;
+                XDestroyImage(Image.Pixels);
+                Image.Pixels = nullptr;
+                bUseShm = false;
+                return false;
+            }
+            Image.bShm = true;
+            RESOURCE_ACQUIRE("X11.Shm", Handle);
+            GResources.Acquire("X11.Shm", EResourceKind::HeapBytes, static_cast<int64_t>(Bytes));
+            return true;
+        }
+
+        bool CreatePlainImage(FImage& Image, int32_t Width, int32_t Height)
+        {
+            size_t Bytes = static_cast<size_t>(Width) * static_cast<size_t>(Height) * 4;
+            char* Data = static_cast<char*>(std::malloc(Bytes));
+            if (!Data) return false;
+            Image.Pixels = XCreateImage
+            (
+                Connection, VisualPtr, static_cast<unsigned>(Depth), ZPixmap, 0, Data,
+                static_cast<unsigned>(Width), static_cast<unsigned>(Height), 32, Width * 4
+            );
+            if (!Image.Pixels)
+            {
+                std::free(Data);
+                return false;
+            }
+            GResources.Acquire("X11.Image", EResourceKind::HeapBytes, static_cast<int64_t>(Bytes));
+            return true;
+        }
+
+        void DestroyImage(FImage& Image)
+        {
+            if (!Image.Pixels) return;
+            int64_t Bytes = static_cast<int64_t>(Image.Pixels->bytes_per_line) * Image.Pixels->height;
+            if (Image.bShm)
+            {
+                XShmDetach(Connection, &Image.Segment);
+                XSync(Connection, False);
+                shmdt(Image.Segment.shmaddr);
+                Image.Pixels->data = nullptr;
+                RESOURCE_RELEASE("X11.Shm", Handle);
+                GResources.Release("X11.Shm", EResourceKind::HeapBytes, Bytes);
+            }
+            else
+            {
+                GResources.Release("X11.Image", EResourceKind::HeapBytes, Bytes);
+            }
+            XDestroyImage(Image.Pixels); // Frees malloc'd pixel data with it
+            Image.Pixels = nullptr;
+        }
+
+        void ReleaseImages()
+        {
+            for (auto& Image : Images) DestroyImage(*Image);
+            Images.clear();
+        }
+
+        Display* Connection = nullptr;
+        Visual* VisualPtr = nullptr;
+        int32_t Depth = 0;
+        GC Gc = nullptr;
+        bool bAllowShm = true;
+        bool bUseShm = false;
+        std::atomic<bool> bInvalidated{ false };
+        std::vector<std::unique_ptr<FImage>> Images;
+    };
+
+    using FX11Pipeline = TSoftwarePipeline<FX11Surface>;
+
+    /** Where the wallpaper lives on the current monitor set: surfaces and the windows created for them. */
+    class FX11Desktop
+    {
+    public:
+        FX11Desktop(Display* InConnection, EDesktopHost InHost, bool bInHaveRandr)
+            : Connection(InConnection), Host(InHost), bHaveRandr(bInHaveRandr)
+        {
+            if (Host == EDesktopHost::Auto)
+            {
+                Host = IsEwmhWindowManagerRunning(Connection) ? EDesktopHost::Desktop : EDesktopHost::Root;
+            }
+        }
+
+        ~FX11Desktop() { DestroyWindows(); }
+
+        /** Re-enumerates monitors; returns false if nothing changed. */
+        bool Rebuild()
+        {
+            std::vector<FIntRect> NewMonitors = EnumerateMonitors(Connection, bHaveRandr);
+            if (NewMonitors == Monitors && !Surfaces.empty()) return false;
+            DestroyWindows();
+            Monitors = std::move(NewMonitors);
+            Window Root = DefaultRootWindow(Connection);
+            for (const auto& Rect : Monitors)
+            {
+                if (Host == EDesktopHost::Desktop) Surfaces.push_back({ CreateDesktopWindow(Connection, Rect), 0, 0 });
+                else Surfaces.push_back({ Root, Rect.Left, Rect.Top });
+            }
+            XFlush(Connection);
+            return true;
+        }
+
+        TSoftwareLayout<FX11Surface> BuildLayout(bool bSpanMode) const
+        {
+            return BuildSoftwareLayout(Monitors, Surfaces, bSpanMode, FSpanSettings{});
+        }
+
+        EDesktopHost GetHost() const { return Host; }
+        const std::vector<FIntRect>& GetMonitors() const { return Monitors; }
+        const std::vector<FX11Surface>& GetSurfaces() const { return Surfaces; }
+
+        void DestroyWindows()
+        {
+            if (Host == EDesktopHost::Desktop)
+            {
+                for (const auto& Surface : Surfaces)
+                {
+                    XDestroyWindow(Connection, Surface.Drawable);
+                    RESOURCE_RELEASE("X11.Window", Window);
+                }
+            }
+            Surfaces.clear();
+        }
+
+        Display* Connection;
+        EDesktopHost Host;
+        bool bHaveRandr;
+        std::vector<FIntRect> Monitors;
+        std::vector<FX11Surface> Surfaces;
+    };
+
+    /** GIF/PNG/APNG through the frame cache; nullptr (and no message) for anything else. */
+    std::unique_ptr<IVideoSource> OpenAnimatedImage(const std::string& Path, const TSoftwareLayout<FX11Surface>& Layout)
+    {
+        std::ifstream File(Path, std::ios::binary);
+        std::vector<uint8_t> Data((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+        if (!IsAnimatedImageData(Data.data(), Data.size())) return nullptr;
+
+        FAnimationCacheSettings Settings;
+        Layout.GetFrameCoverSize(Settings.TargetWidth, Settings.TargetHeight);
+        auto Source = std::make_unique<FAnimatedImageSource>();
+        if (!Source->Open(CreateAnimationDecoder(std::move(Data)), Settings)) return nullptr;
+        std::printf
+        (
+            "%s, %d frame(s), %s\n", Source->GetAnimationInfo().FormatName, Source->GetAnimationInfo().FrameCount,
+            Source->GetMode() == EAnimationCacheMode::Cached ? "cached" : "streaming"
+        );
+        return Source;
+    }
+
+    /** The smallest --rendition file next to the video that covers the desktop, or the video itself. */
+    std::string SelectRenditionPath(const FX11Options& Options, const TSoftwareLayout<FX11Surface>& Layout)
+    {
+        std::vector<TRendition<std::string>> Available;
+        for (const auto& Rendition : Options.Renditions)
+        {
+            if (std::ifstream(GetRenditionPath(Options.VideoPath, Rendition.Suffix)).good()) Available.push_back(Rendition);
+        }
+        int32_t Width = 0;
+        int32_t Height = 0;
+        Layout.GetFrameCoverSize(Width, Height);
+        int32_t Rendition = SelectRendition(Available, Width, Height);
+        if (Rendition == MasterRendition) return Options.VideoPath;
+        return GetRenditionPath(Options.VideoPath, Available[Rendition].Suffix);
+    }
+
+    /** The stream for this desktop from the decode service; nullptr (and a message) if there is none. */
+    std::unique_ptr<IVideoSource> AttachDecodeService
+    (
+        const FX11Options& Options, const TSoftwareLayout<FX11Surface>& Layout, FSharedFrameSource::FFallbackFactory OpenFallback
+    )
+    {
+        // Sessions with the same desktop size share a stream; frames come scaled to cover it.
+        int32_t Width = 0;
+        int32_t Height = 0;
+        Layout.GetFrameCoverSize(Width, Height);
+        std::string SocketPath = Options.DecodeSocket.empty() ? GetDecodeServicePath() : Options.DecodeSocket;
+        auto Source = std::make_unique<FSharedFrameSource>(std::move(OpenFallback));
+        std::string Error;
+        if (!Source->Attach(SocketPath, Options.VideoPath, Width, Height, Error))
+        {
+            std::printf("Decode service: %s; decoding locally.\n", Error.c_str());
+            return nullptr;
+        }
+        std::printf("Decode service: attached at %dx%d.\n", Source->GetInfo().Width, Source->GetInfo().Height);
+        return Source;
+    }
+
+    bool ParseOptions(int Argc, char** Argv, FX11Options& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Argument = Argv[Index];
+            bool bHasValue = Index + 1 < Argc;
+            if (Argument == "--pattern") Options.bPattern = true;
+            else if (Argument == "--decode-service") Options.bDecodeService = true;
+            else if (Argument == "--decode-socket" && bHasValue)
+            {
+                Options.bDecodeService = true;
+                Options.DecodeSocket = Argv[++Index];
+            }
+            else if (Argument == "--rendition" && Index + 2 < Argc)
+            {
+                TRendition<std::string> Rendition;
+                if (!ParseRendition(std::string(Argv[Index + 1]) + " " + Argv[Index + 2], Rendition)) return false;
+                Options.Renditions.push_back(Rendition);
+                Index += 2;
+            }
+            else if (Argument == "--seconds" && bHasValue) Options.Seconds = std::atoi(Argv[++Index]);
+            else if (Argument == "--priority" && bHasValue)
+            {
+                if (!ParseQosLevel(std::string(Argv[++Index]), Options.Priority)) return false;
+            }
+            else if (Argument == "--efficiency-cores") Options.bEfficiencyCores = true;
+            else if (Argument == "--mode" && bHasValue)
+            {
+                std::string Mode = Argv[++Index];
+                if (Mode != "clone" && Mode != "span") return false;
+                Options.bSpanMode = Mode == "span";
+            }
+            else if (Argument == "--memory-ceiling-mb" && bHasValue)
+            {
+                Options.MemoryCeilingBytes = std::atoll(Argv[++Index]) * 1024 * 1024;
+                if (Options.MemoryCeilingBytes < 0) return false;
+            }
+            else if (Argument == "--loop" && bHasValue)
+            {
+                std::string Loop = Argv[++Index];
+                if (Loop != "wrap" && Loop != "pingpong") return false;
+                Options.bPingPong = Loop == "pingpong";
+            }
+            else if (Argument == "--host" && bHasValue)
+            {
+                std::string Host = Argv[++Index];
+                if (Host == "auto") Options.Host = EDesktopHost::Auto;
+                else if (Host == "root") Options.Host = EDesktopHost::Root;
+                else if (Host == "desktop") Options.Host = EDesktopHost::Desktop;
+                else return false;
+            }
+            else if (!Argument.starts_with("--") && Options.VideoPath.empty()) Options.VideoPath = Argument;
+            else return false;
+        }
+        if (Options.bPattern)
+        {
+            if (!Options.VideoPath.empty()) return false;
+            Options.VideoPath = PatternPathPrefix;
+        }
+        // A malformed ":pattern:..." is a usage error rather than a file that will not open.
+        FPatternSettings Pattern;
+        Options.bPattern = ParsePatternPath(Options.VideoPath, Pattern);
+        return !Options.VideoPath.empty() && (Options.bPattern || !IsPatternPath(Options.VideoPath));
+    }
+
+    void OnQuitSignal(int) { GbQuitRequested.store(true, std::memory_order_relaxed); }
+
+    /** One governor tick: cache level changes go to the pipeline, trims hand freed heap back to the kernel. */
+    void UpdateMemoryGovernor(FMemoryGovernor& Governor, FX11Pipeline& Pipeline)
+    {
+        FMemorySample Sample;
+        if (!ReadProcMemorySample(Sample)) return;
+        Sample.CacheBytes = Pipeline.GetCacheBytes();
+        FMemoryDecision Decision = Governor.Update(Sample);
+        if (Decision.bCacheLevelChanged)
+        {
+            Pipeline.SetCacheLevel(Decision.CacheLevel);
+            std::printf
+            (
+                "Memory: cache level %d (%s; resident %lld MB, caches %lld MB).\n", Decision.CacheLevel,
+                GetMemoryReasonName(Decision.Reason), static_cast<long long>(Sample.ResidentBytes / (1024 * 1024)),
+                static_cast<long long>(Sample.CacheBytes / (1024 * 1024))
+            );
+        }
+#ifdef __GLIBC__
+        // Frame buffers are mapped and already went back when freed; this returns the small-block heap.
+        if (Decision.bTrimWorkingSet) malloc_trim(0);
+#endif
+    }
+
+    /** key=value lines for the control endpoint's "status", named as on Windows where they mean the same. */
+    std::string FormatControlStatus
+    (
+        const FX11Options& Options, const FX11Desktop& Desktop, FX11Pipeline& Pipeline, const FMemoryGovernor& Governor,
+        const FControlSocketServer& Control, bool bPaused
+    )
+    {
+        std::string Text = "\nvideo=" + Options.VideoPath;
+        Text += "\npresenter=software";
+        Text += "\nstate=" + std::string(bPaused ? "paused" : "playing");
+        Text += "\nmode=" + std::string(Options.bSpanMode ? "span" : "clone");
+        Text += "\nhost=" + std::string(Desktop.GetHost() == EDesktopHost::Desktop ? "desktop" : "root");
+        Text += "\nmonitors=" + std::to_string(Desktop.GetMonitors().size());
+        for (size_t Index = 0; Index < Desktop.GetMonitors().size(); ++Index)
+        {
+            const FIntRect& Rect = Desktop.GetMonitors()[Index];
+            Text += "\nmonitor." + std::to_string(Index) + "=" + std::to_string(Rect.Width()) + "x" + std::to_string(Rect.Height())
+                + "+" + std::to_string(Rect.Left) + "+" + std::to_string(Rect.Top);
+        }
+        Text += "\nsoftware.frames=" + std::to_string(Pipeline.GetStats().Frames);
+        Text += "\nsoftware.dropped=" + std::to_string(Pipeline.GetDroppedFrames());
+        Text += "\nsoftware.crossfading=" + std::to_string(Pipeline.IsCrossfading() ? 1 : 0);
+        const FMemoryGovernorStats& Memory = Governor.GetStats();
+        Text += "\nmemory.peak_kb=" + std::to_string(Memory.PeakResidentBytes / 1024);
+        Text += "\nmemory.cache_kb=" + std::to_string(Memory.CacheBytes / 1024);
+        Text += "\nx11_errors=" + std::to_string(GX11Errors.load(std::memory_order_relaxed));
+        Text += "\ncontrol.rejected=" + std::to_string(Control.GetRejectedCount());
+        return Text;
+    }
+
+    void PrintStats(FX11Pipeline& Pipeline, const FX11Presenter& Presenter, const FMemoryGovernor& Governor, double Seconds)
+    {
+        FCompositorStats Stats = Pipeline.GetStats();
+        std::printf
+        (
+            "frames=%llu dropped=%llu static=%llu fps=%.1f convert=%.0fus scale=%.0fus present=%.0fus shm=%d x11_errors=%llu\n",
+            static_cast<unsigned long long>(Stats.Frames),
+            static_cast<unsigned long long>(Pipeline.GetDroppedFrames()),
+            static_cast<unsigned long long>(Stats.StaticFrames),
+            Seconds > 0.0 ? Stats.Frames / Seconds : 0.0,
+            Stats.Convert.AverageNs / 1000.0, Stats.Scale.AverageNs / 1000.0, Stats.Present.AverageNs / 1000.0,
+            Presenter.IsUsingShm() ? 1 : 0,
+            static_cast<unsigned long long>(GX11Errors.load(std::memory_order_relaxed))
+        );
+        const FMemoryGovernorStats& Memory = Governor.GetStats();
+        std::printf
+        (
+            "resident_peak=%lldMB caches=%lldMB cache_level=%d trims=%llu degrades=%llu restores=%llu\n",
+            static_cast<long long>(Memory.PeakResidentBytes / (1024 * 1024)),
+            static_cast<long long>(Memory.CacheBytes / (1024 * 1024)), Governor.GetCacheLevel(),
+            static_cast<unsigned long long>(Memory.Trims), static_cast<unsigned long long>(Memory.Degrades),
+            static_cast<unsigned long long>(Memory.Restores)
+        );
+        FQosStats Qos = GQos.GetStats();
+        FDeadlineStats Deadline = Pipeline.GetDeadlineStats();
+        std::printf
+        (
+            "qos=%s boost=%d near_misses=%llu escalations=%u relaxations=%u qos_failures=%llu\n",
+            GetQosLevelName(GQos.GetPolicy().Get(EWorkClass::Decode)), Qos.Boost,
+            static_cast<unsigned long long>(Deadline.NearMisses), Deadline.Escalations, Deadline.Relaxations,
+            static_cast<unsigned long long>(Qos.Failed)
+        );
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FX11Options Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf
+        (
+            stderr,
+            "usage: videowallpaper-x11 [--host auto|root|desktop] [--mode clone|span] [--loop wrap|pingpong]\n"
+            "                          [--memory-ceiling-mb N] [--decode-service] [--decode-socket PATH]\n"
+            "                          [--rendition WxH SUFFIX]... [--priority normal|background|idle]\n"
+            "                          [--efficiency-cores]\n"
+            "                          [--seconds N] (--pattern | :pattern:OPTIONS | <video>)\n"
+        );
+        return 2;
+    }
+    std::signal(SIGINT, OnQuitSignal);
+    std::signal(SIGTERM, OnQuitSignal);
+    XSetErrorHandler(OnX11Error);
+
+    // First, so the threads and decoder processes started from here on inherit or enter their class.
+    FLinuxQos Qos;
+    if (Options.Priority != EQosLevel::Normal)
+    {
+        GQos.SetBackend(Qos.MakeBackend());
+        GQos.SetPolicy(FQosPolicy::FromPriority(Options.Priority, Options.bEfficiencyCores));
+        GQos.EnterThread(EWorkClass::Interactive);
+        std::printf("Scheduling: %s (%s).\n", GetQosLevelName(Options.Priority), Qos.Describe().c_str());
+    }
+
+    // Events and window management on this thread; the decode thread presents through its own connection.
+    Display* Connection = XOpenDisplay(nullptr);
+    FX11Presenter FramePresenter(true);
+    FX11Presenter RepaintPresenter(false);
+    if (!Connection || !FramePresenter.Open(nullptr) || !RepaintPresenter.Open(nullptr))
+    {
+        std::fprintf(stderr, "Cannot open the X display, or its default visual is not 24-bit TrueColor.\n");
+        return 2;
+    }
+
+    int32_t RandrEventBase = 0;
+    int32_t RandrErrorBase = 0;
+    bool bHaveRandr = XRRQueryExtension(Connection, &RandrEventBase, &RandrErrorBase);
+    Window Root = DefaultRootWindow(Connection);
+    if (bHaveRandr) XRRSelectInput(Connection, Root, RRScreenChangeNotifyMask);
+
+    FX11Desktop Desktop(Connection, Options.Host, bHaveRandr);
+    if (Desktop.GetHost() == EDesktopHost::Root) XSelectInput(Connection, Root, ExposureMask);
+    Desktop.Rebuild();
+    if (!Options.bPattern && !Options.Renditions.empty())
+    {
+        // Picked for the desktop at startup; a later RandR change keeps the encode and rescales it.
+        Options.VideoPath = SelectRenditionPath(Options, Desktop.BuildLayout(Options.bSpanMode));
+        std::printf("Rendition: %s\n", Options.VideoPath.c_str());
+    }
+
+    // Decoding in this process: the pattern, a Y4M file, or ffmpeg. Also the fallback if the decode service goes away.
+    auto OpenLocalSource = [&]() -> std::unique_ptr<IVideoSource>
+    {
+        if (Options.bPattern)
+        {
+            // Sized for the first monitor unless the path says otherwise.
+            const FIntRect& First = Desktop.GetMonitors().front();
+            FPatternSettings Settings;
+            Settings.Width = First.Width();
+            Settings.Height = First.Height();
+            ParsePatternPath(Options.VideoPath, Settings);
+            return std::make_unique<FPatternSource>(Settings);
+        }
+        if (IsY4MFile(Options.VideoPath))
+        {
+            auto Reader = std::make_unique<FY4MSource>();
+            if (!Reader->Open(Options.VideoPath))
+            {
+                std::fprintf(stderr, "Cannot play %s: %s.\n", Options.VideoPath.c_str(), Reader->GetError().c_str());
+                return nullptr;
+            }
+            return Reader;
+        }
+        // ffmpeg takes the decode threads' priority, not this idle event thread's.
+        auto Decoder = std::make_unique<FFfmpegSource>();
+        if (!RunAsWorkClass(EWorkClass::Decode, [&] { return Decoder->Open(Options.VideoPath); }))
+        {
+            std::fprintf(stderr, "Cannot decode %s (needs ffmpeg and ffprobe on PATH).\n", Options.VideoPath.c_str());
+            return nullptr;
+        }
+        return Decoder;
+    };
+
+    std::unique_ptr<IVideoSource> Source;
+    // Y4M files are far too large to sniff by reading them whole, as the image check does.
+    if (!Options.bPattern && !IsY4MFile(Options.VideoPath)) Source = OpenAnimatedImage(Options.VideoPath, Desktop.BuildLayout(Options.bSpanMode));
+    // Ping-pong seeks on its own, which a shared live stream cannot do.
+    if (!Source && Options.bDecodeService && !Options.bPingPong)
+    {
+        Source = AttachDecodeService(Options, Desktop.BuildLayout(Options.bSpanMode), [&]() -> std::unique_ptr<IVideoSource>
+        {
+            std::printf("Decode service lost; decoding locally.\n");
+            return OpenLocalSource();
+        });
+    }
+    if (!Source)
+    {
+        if (!(Source = OpenLocalSource())) return 1;
+        // No sample table here: segments are fixed slices, each a fresh ffmpeg seek.
+        if (Options.bPingPong && !Options.bPattern) Source = std::make_unique<FPingPongSource>(std::move(Source), FPingPongSettings{});
+    }
+    std::printf
+    (
+        "%zu monitor(s), %s host, %s, %dx%d source\n",
+        Desktop.GetMonitors().size(), Desktop.GetHost() == EDesktopHost::Desktop ? "desktop-window" : "root-window",
+        FramePresenter.IsUsingShm() ? "MIT-SHM" : "XPutImage",
+        Source->GetInfo().Width, Source->GetInfo().Height
+    );
+
+    FX11Pipeline Pipeline(FramePresenter);
+    Pipeline.Start(std::move(Source), Desktop.BuildLayout(Options.bSpanMode), false);
+
+    FMemoryGovernorSettings MemorySettings;
+    MemorySettings.CeilingBytes = Options.MemoryCeilingBytes;
+    FMemoryGovernor Governor(MemorySettings);
+
+    // vwctl's endpoint; requests are served on this thread between X events, so they see consistent state.
+    FControlSocketServer Control;
+    std::string ControlError;
+    if (Control.Listen(ControlError)) std::printf("Control endpoint: %s\n", Control.GetPath().c_str());
+    else std::printf("Control endpoint: %s; vwctl cannot reach this instance.\n", ControlError.c_str());
+    bool bPaused = false;
+    auto HandleControlRequest = [&](const FControlRequest& Request) -> FControlResponse
+    {
+        switch (Request.Command)
+        {
+        case ControlStatusCommand:
+            return { true, FormatControlStatus(Options, Desktop, Pipeline, Governor, Control, bPaused) };
+        case EControlCommand::Pause:
+        case EControlCommand::Resume:
+        case EControlCommand::Toggle:
+            bPaused = Request.Command == EControlCommand::Toggle ? !bPaused : Request.Command == EControlCommand::Pause;
+            Pipeline.SetPaused(bPaused);
+            return { true, bPaused ? "paused" : "playing" };
+        case EControlCommand::Video:
+        {
+            // Switched videos decode in this process; the decode service and renditions apply to the startup video.
+            FPatternSettings Pattern;
+            bool bPatternPath = IsPatternPath(Request.Argument);
+            if (bPatternPath && !ParsePatternPath(Request.Argument, Pattern)) return { false, "malformed pattern" };
+            FX11Options Previous = Options;
+            Options.VideoPath = Request.Argument;
+            Options.bPattern = bPatternPath;
+            auto Open = [&]
+            {
+                std::unique_ptr<IVideoSource> Next;
+                if (!Options.bPattern && !IsY4MFile(Options.VideoPath)) Next = OpenAnimatedImage(Options.VideoPath, Desktop.BuildLayout(Options.bSpanMode));
+                if (!Next && (Next = OpenLocalSource()) && Options.bPingPong && !Options.bPattern)
+                {
+                    Next = std::make_unique<FPingPongSource>(std::move(Next), FPingPongSettings{});
+                }
+                return Next;
+            };
+            if (!Pipeline.Crossfade(Open, ControlCrossfadeNs))
+            {
+                Options = std::move(Previous);
+                return { false, "cannot play " + Request.Argument };
+            }
+            std::printf("Control: video %s\n", Options.VideoPath.c_str());
+            return { true, "playing " + Options.VideoPath };
+        }
+        case EControlCommand::Reload:
+            // Windows and surfaces are made anew, as after a RandR change.
+            Desktop.DestroyWindows();
+            Desktop.Rebuild();
+            Pipeline.SetLayout(Desktop.BuildLayout(Options.bSpanMode));
+            FramePresenter.Invalidate();
+            RepaintPresenter.Invalidate();
+            return { true, "rebuilt" };
+        case EControlCommand::Quit:
+            GbQuitRequested.store(true, std::memory_order_relaxed);
+            return { true, "quitting" };
+        case EControlCommand::Mute:
+        case EControlCommand::Unmute:
+            return { false, "no audio on X11" };
+        case EControlCommand::Set:
+            return { false, "settings are command-line options on X11" };
+        default:
+            return { false, "unsupported command" };
+        }
+    };
+
+    auto StartTime = std::chrono::steady_clock::now();
+    auto LastMemoryTick = StartTime;
+    std::vector<pollfd> Polls;
+    while (!GbQuitRequested.load(std::memory_order_relaxed))
+    {
+        auto Now = std::chrono::steady_clock::now();
+        double Elapsed = std::chrono::duration<double>(Now - StartTime).count();
+        if (Options.Seconds > 0 && Elapsed >= Options.Seconds) break;
+        if (Pipeline.HasFailed())
+        {
+            std::fprintf(stderr, "Decoding failed, playback stopped.\n");
+            break;
+        }
+        if (Now - LastMemoryTick >= std::chrono::milliseconds(MemoryTickMs))
+        {
+            LastMemoryTick = Now;
+            UpdateMemoryGovernor(Governor, Pipeline);
+        }
+        Polls.assign(1, pollfd{ ConnectionNumber(Connection), POLLIN, 0 });
+        Control.AddPolls(Polls);
+        if (!XPending(Connection) && poll(Polls.data(), Polls.size(), EventPollMs) <= 0) continue;
+        if (Polls.size() > 1) Control.Dispatch(Polls.data() + 1, HandleControlRequest);
+
+        while (XPending(Connection))
+        {
+            XEvent Event;
+            XNextEvent(Connection, &Event);
+            if (bHaveRandr && Event.type == RandrEventBase + RRScreenChangeNotify)
+            {
+                XRRUpdateConfiguration(&Event);
+                if (!Desktop.Rebuild()) continue;
+                std::printf("Display change: %zu monitor(s).\n", Desktop.GetMonitors().size());
+                Pipeline.SetLayout(Desktop.BuildLayout(Options.bSpanMode));
+                FramePresenter.Invalidate();
+                RepaintPresenter.Invalidate();
+            }
+            else if (Event.type == Expose && Event.xexpose.count == 0)
+            {
+                // The root window is shared by every monitor; repaint all of its surfaces.
+                for (const auto& Surface : Desktop.GetSurfaces())
+                {
+                    if (Surface.Drawable != Event.xexpose.window) continue;
+                    Pipeline.Paint(Surface, [&](const FFrameView& View)
+                    {
+                        RepaintPresenter.Present(Surface, View, { FIntRect{ 0, 0, View.Width, View.Height } });
+                    });
+                }
+            }
+        }
+    }
+
+    double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+    Pipeline.Stop();
+    PrintStats(Pipeline, FramePresenter, Governor, Elapsed);
+    bool bPresented = Pipeline.GetStats().Frames > 0;
+    Desktop.DestroyWindows();
+    XCloseDisplay(Connection);
+    return Options.Seconds > 0 && !bPresented ? 1 : 0;
+}
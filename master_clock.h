@@ -0,0 +1,174 @@
+// MasterClock - Shared presentation clock that per-monitor pipelines slave to.
+// FMasterClock owns the loop timeline (position modulo loop length) and pauses
+// with the app. FDriftCorrector compares a pipeline's reported position with the
+// master and answers with a small playback-rate trim, falling back to a hard seek
+// only when drift is too large to trim away.
+// Pure C++20: callers pass timestamps in, so the logic runs against simulated clocks.
+// Positions are in 100ns units to match Media Foundation.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/** Drift below this (100ns units) is treated as locked: half a frame at 60 fps. */
+constexpr int64_t DriftDeadband100ns = 80000LL;
+
+/** Drift above this (100ns units) is corrected by a seek instead of a rate trim. */
+constexpr int64_t DriftHardSeek100ns = 2500000LL;
+
+/** Largest playback-rate trim applied in either direction (2%, visually imperceptible). */
+constexpr double DriftMaxRateTrim = 0.02;
+
+/** Time horizon over which a trim aims to cancel the measured drift, in seconds. */
+constexpr double DriftCorrectionHorizonSec = 5.0;
+
+/** Weight of the newest sample in the drift moving average (position reads are jittery). */
+constexpr double DriftSmoothing = 0.5;
+
+inline int64_t MasterClockNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+    (
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+class FMasterClock
+{
+public:
+    /** Starts (or restarts) the timeline at position 0 with the given loop length. */
+    void Start(int64_t NowNs, int64_t InLoopLength100ns)
+    {
+        LoopLength100ns = InLoopLength100ns > 0 ? InLoopLength100ns : 0;
+        OriginNs = NowNs;
+        PausedAtNs = 0;
+        bRunning = LoopLength100ns > 0;
+        bPaused = false;
+    }
+
+    void Stop() { bRunning = false; }
+
+    void Pause(int64_t NowNs)
+    {
+        if (!bRunning || bPaused) return;
+        bPaused = true;
+        PausedAtNs = NowNs;
+    }
+
+    /** Shifts the origin by the paused span so position continues where it stopped. */
+    void Resume(int64_t NowNs)
+    {
+        if (!bRunning || !bPaused) return;
+        OriginNs += NowNs - PausedAtNs;
+        bPaused = false;
+    }
+
+    bool IsRunning() const { return bRunning; }
+    bool IsPaused() const { return bPaused; }
+    int64_t GetLoopLength100ns() const { return LoopLength100ns; }
+
+    /** Unwrapped elapsed presentation time in 100ns units. */
+    int64_t GetElapsed100ns(int64_t NowNs) const
+    {
+        if (!bRunning) return 0;
+        int64_t EffectiveNow = bPaused ? PausedAtNs : NowNs;
+        int64_t Elapsed = (EffectiveNow - OriginNs) / 100;
+        return Elapsed > 0 ? Elapsed : 0;
+    }
+
+    /** Position within the current loop, in 100ns units. */
+    int64_t GetPosition100ns(int64_t NowNs) const
+    {
+        return LoopLength100ns > 0 ? GetElapsed100ns(NowNs) % LoopLength100ns : 0;
+    }
+
+    uint64_t GetLoopIndex(int64_t NowNs) const
+    {
+        return LoopLength100ns > 0 ? static_cast<uint64_t>(GetElapsed100ns(NowNs) / LoopLength100ns) : 0;
+    }
+
+    /** Wall time until the next loop boundary in nanoseconds; negative while paused or stopped. */
+    int64_t GetTimeToWrapNs(int64_t NowNs) const
+    {
+        if (!bRunning || bPaused || LoopLength100ns <= 0) return -1;
+        return (LoopLength100ns - GetPosition100ns(NowNs)) * 100;
+    }
+
+private:
+    int64_t OriginNs = 0;
+    int64_t PausedAtNs = 0;
+    int64_t LoopLength100ns = 0;
+    bool bRunning = false;
+    bool bPaused = false;
+};
+
+/** Signed distance Position - Reference on a circular timeline of the given length. */
+inline int64_t WrappedDelta100ns(int64_t Position, int64_t Reference, int64_t LoopLength)
+{
+    int64_t Delta = Position - Reference;
+    if (LoopLength <= 0) return Delta;
+    Delta %= LoopLength;
+    if (Delta > LoopLength / 2) Delta -= LoopLength;
+    if (Delta < -LoopLength / 2) Delta += LoopLength;
+    return Delta;
+}
+
+struct FDriftCorrection
+{
+    double Rate = 1.0;
+    bool bSeek = false;
+    int64_t SeekTarget100ns = 0;
+    int64_t Drift100ns = 0;         // Smoothed; positive = pipeline ahead of master
+};
+
+class FDriftCorrector
+{
+public:
+    /** Forget history, e.g. after a seek or a loop, when old samples no longer apply. */
+    void Reset()
+    {
+        SmoothedDrift = 0.0;
+        bHasSample = false;
+    }
+
+    FDriftCorrection Update(int64_t MasterPosition100ns, int64_t PipelinePosition100ns, int64_t LoopLength100ns)
+    {
+        FDriftCorrection Correction;
+        int64_t RawDrift = WrappedDelta100ns(PipelinePosition100ns, MasterPosition100ns, LoopLength100ns);
+
+        if (RawDrift > DriftHardSeek100ns || RawDrift < -DriftHardSeek100ns)
+        {
+            Reset();
+            Correction.bSeek = true;
+            Correction.SeekTarget100ns = MasterPosition100ns;
+            Correction.Drift100ns = RawDrift;
+            ++SeekCount;
+            return Correction;
+        }
+
+        SmoothedDrift = bHasSample
+            ? SmoothedDrift + DriftSmoothing * (static_cast<double>(RawDrift) - SmoothedDrift)
+            : static_cast<double>(RawDrift);
+        bHasSample = true;
+        Correction.Drift100ns = static_cast<int64_t>(SmoothedDrift);
+
+        if (Correction.Drift100ns > DriftDeadband100ns || Correction.Drift100ns < -DriftDeadband100ns)
+        {
+            // Ahead -> slow down, behind -> speed up, enough to close the gap over the horizon.
+            double DriftSec = SmoothedDrift / 1.0e7;
+            double Trim = -DriftSec / DriftCorrectionHorizonSec;
+            if (Trim > DriftMaxRateTrim) Trim = DriftMaxRateTrim;
+            if (Trim < -DriftMaxRateTrim) Trim = -DriftMaxRateTrim;
+            Correction.Rate = 1.0 + Trim;
+        }
+        return Correction;
+    }
+
+    uint64_t GetSeekCount() const { return SeekCount; }
+
+private:
+    double SmoothedDrift = 0.0;
+    bool bHasSample = false;
+    uint64_t SeekCount = 0;
+};
@@ -0,0 +1,342 @@
+// memory_bench - Checks the memory governor's policy and runs it against a live pipeline.
+// First scripted sample traces check the policy: idle playback is trimmed once per
+// idle spell; a ceiling or a low-memory signal degrades caches a level at a time
+// before any trim, and trims (spaced out) once caches have nothing left; caches
+// come back only after a quiet streak, and more slowly when a restored level had
+// to be given up again. Then a software pipeline plays a synthetic animated image
+// whose decoded-frame cache pushes resident memory, sampled from /proc as on a
+// Linux desktop, over a ceiling: the governor must bring it back under by dropping
+// the cache while playback goes on (also while paused), and give the cache back
+// once the ceiling is lifted. Builds anywhere the portable headers do; the live
+// part needs /proc:
+//   g++ -std=c++20 -O2 -pthread memory_bench.cpp -o memory_bench
+//   memory_bench [--size WxH] [--frames N] [--tick-ms N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "animation_cache.h"
+#include "memory_governor.h"
+#include "software_pipeline.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t Width = 1280;
+        int32_t Height = 720;
+        int32_t Frames = 48;
+        int32_t TickMs = 50;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--size")
+            {
+                if (std::sscanf(Value, "%dx%d", &Options.Width, &Options.Height) != 2) return false;
+                if (Options.Width <= 0 || Options.Height <= 0) return false;
+            }
+            else if (Name == "--frames") Options.Frames = std::atoi(Value);
+            else if (Name == "--tick-ms") Options.TickMs = std::atoi(Value);
+            else return false;
+        }
+        return Options.Frames > 1 && Options.TickMs > 0;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    constexpr int64_t MB = 1024 * 1024;
+
+    /** Runs Ticks identical samples; returns how many trimmed and how many changed the cache level. */
+    void Feed(FMemoryGovernor& Governor, const FMemorySample& Sample, int32_t Ticks, int32_t& Trims, int32_t& LevelChanges)
+    {
+        Trims = LevelChanges = 0;
+        for (int32_t Tick = 0; Tick < Ticks; ++Tick)
+        {
+            FMemoryDecision Decision = Governor.Update(Sample);
+            Trims += Decision.bTrimWorkingSet ? 1 : 0;
+            LevelChanges += Decision.bCacheLevelChanged ? 1 : 0;
+        }
+    }
+
+    bool CheckIdlePolicy()
+    {
+        FMemoryGovernorSettings Settings;
+        FMemoryGovernor Governor(Settings);
+        FMemorySample Playing{ 300 * MB, 0, false, false };
+        FMemorySample Idle{ 300 * MB, 0, true, false };
+        int32_t Trims = 0;
+        int32_t Changes = 0;
+
+        Feed(Governor, Playing, 50, Trims, Changes);
+        bool bPass = Check(Trims == 0 && Changes == 0, "playing without pressure acted");
+        Feed(Governor, Idle, Settings.IdleTrimTicks - 1, Trims, Changes);
+        bPass &= Check(Trims == 0, "idle trimmed before it settled");
+        Feed(Governor, Idle, 100, Trims, Changes);
+        bPass &= Check(Trims == 1 && Changes == 0, "idle spell not trimmed exactly once");
+        Feed(Governor, Playing, 1, Trims, Changes);
+        Feed(Governor, Idle, Settings.IdleTrimTicks, Trims, Changes);
+        bPass &= Check(Trims == 1, "second idle spell not trimmed");
+        bPass &= Check(Governor.GetStats().LastReason == EMemoryReason::Idle, "idle trim not reported");
+        return bPass;
+    }
+
+    bool CheckPressurePolicy()
+    {
+        FMemoryGovernorSettings Settings;
+        Settings.CeilingBytes = 400 * MB;
+        FMemoryGovernor Governor(Settings);
+        int32_t Trims = 0;
+        int32_t Changes = 0;
+
+        // Over the ceiling with caches to give: every level goes before any trim.
+        FMemorySample Over{ 500 * MB, 200 * MB, false, false };
+        int32_t Ticks = (MaxCacheLevel - 1) * Settings.DegradeIntervalTicks + 1;
+        Feed(Governor, Over, Ticks, Trims, Changes);
+        bool bPass = Check(Changes == MaxCacheLevel && Governor.GetCacheLevel() == MaxCacheLevel, "caches not degraded level by level");
+        bPass &= Check(Trims == 0, "trimmed while caches could still give");
+        bPass &= Check(Governor.GetStats().LastReason == EMemoryReason::Ceiling, "ceiling not reported");
+
+        // Nothing left to degrade: trims, spaced out.
+        FMemorySample StillOver{ 450 * MB, 0, false, false };
+        Feed(Governor, StillOver, Settings.TrimIntervalTicks * 3, Trims, Changes);
+        bPass &= Check(Trims == 3 && Changes == 0, "trims under pressure not spaced by the interval");
+
+        // Under the ceiling but not quiet (above RestoreRatio): caches stay down.
+        FMemorySample Near{ 350 * MB, 0, false, false };
+        Feed(Governor, Near, Settings.RestoreTicks * 2, Trims, Changes);
+        bPass &= Check(Changes == 0, "restored while close to the ceiling");
+
+        // Quiet: one level per RestoreTicks.
+        FMemorySample Quiet{ 200 * MB, 0, false, false };
+        Feed(Governor, Quiet, Settings.RestoreTicks, Trims, Changes);
+        bPass &= Check(Changes == 1 && Governor.GetCacheLevel() == MaxCacheLevel - 1, "no restore after a quiet streak");
+
+        // The restored level does not hold: the next restore waits twice as long.
+        Feed(Governor, Over, 1, Trims, Changes);
+        bPass &= Check(Changes == 1 && Governor.GetCacheLevel() == MaxCacheLevel, "restored level not given up");
+        bPass &= Check(Governor.GetRestoreTicks() == Settings.RestoreTicks * 2, "no back-off after a failed restore");
+        Feed(Governor, Quiet, Settings.RestoreTicks, Trims, Changes);
+        bPass &= Check(Changes == 0, "restored before the back-off");
+        Feed(Governor, Quiet, Settings.RestoreTicks, Trims, Changes);
+        bPass &= Check(Changes == 1, "no restore after the back-off");
+
+        // A low-memory signal without caches (EVR players) goes straight to trimming.
+        FMemoryGovernor Bare(FMemoryGovernorSettings{});
+        FMemorySample Low{ 300 * MB, 0, false, true };
+        Feed(Bare, Low, 1, Trims, Changes);
+        bPass &= Check(Trims == 1 && Bare.GetStats().LastReason == EMemoryReason::LowMemory, "low memory without caches not trimmed");
+        return bPass;
+    }
+
+    bool CheckProcParsing()
+    {
+        std::string Status = "Name:\tmemory_bench\nVmPeak:\t  10240 kB\nVmRSS:\t   5120 kB\n";
+        bool bPass = Check(ParseProcKilobytes(Status, "VmRSS") == 5120 * 1024, "VmRSS misparsed");
+        bPass &= Check(ParseProcKilobytes(Status, "VmSwap") == -1, "missing key not reported");
+        bPass &= Check(ParseProcKilobytes("MemTotalX: 1 kB\nMemTotal: 2 kB\n", "MemTotal") == 2048, "key prefix matched");
+        return bPass;
+    }
+
+    /** Flat frames, each a different shade, at a fixed delay: cheap to decode, large to cache. */
+    class FSyntheticAnimation final : public IAnimationDecoder
+    {
+    public:
+        FSyntheticAnimation(int32_t Width, int32_t Height, int32_t Frames)
+        {
+            Info.Width = Width;
+            Info.Height = Height;
+            Info.FrameCount = Frames;
+            Info.DelaysMs.assign(static_cast<size_t>(Frames), 20);
+            Info.Duration100ns = Frames * 200000LL;
+            Info.FormatName = "synthetic";
+        }
+
+        const FAnimationInfo& GetInfo() const override { return Info; }
+
+        bool DecodeNext(FFrame& Out) override
+        {
+            if (NextFrame >= Info.FrameCount) return false;
+            Out.Allocate(Info.Width, Info.Height, EPixelFormat::BGRA8);
+            const FFrameView& View = Out.GetView();
+            for (int32_t Y = 0; Y < View.Height; ++Y)
+            {
+                std::memset(View.Row(0, Y), 16 + NextFrame * 3 % 200, static_cast<size_t>(View.Width) * 4);
+            }
+            ++NextFrame;
+            return true;
+        }
+
+        void Rewind() override { NextFrame = 0; }
+        int32_t GetNextFrameIndex() const override { return NextFrame; }
+
+    private:
+        FAnimationInfo Info;
+        int32_t NextFrame = 0;
+    };
+
+    class FNullPresenter final : public ISurfacePresenter<int32_t>
+    {
+    public:
+        void Present(const int32_t&, const FFrameView&, const std::vector<FIntRect>&) override
+        {
+            Presents.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> Presents{ 0 };
+    };
+
+    /** Ticks the governor against /proc until Done() or TimeoutMs; false on timeout. */
+    template <typename TDone>
+    bool RunGovernor(FMemoryGovernor& Governor, TSoftwarePipeline<int32_t>& Pipeline, int32_t TickMs, int32_t TimeoutMs, TDone&& Done)
+    {
+        auto Start = std::chrono::steady_clock::now();
+        while (!Done())
+        {
+            if (ElapsedMs(Start) > TimeoutMs) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(TickMs));
+            FMemorySample Sample;
+            if (!ReadProcMemorySample(Sample)) return false;
+            Sample.CacheBytes = Pipeline.GetCacheBytes();
+            Sample.bLowMemory = false; // The host's own pressure is not this test's
+            FMemoryDecision Decision = Governor.Update(Sample);
+            if (Decision.bCacheLevelChanged) Pipeline.SetCacheLevel(Decision.CacheLevel);
+        }
+        return true;
+    }
+
+    bool CheckLive(const FBenchOptions& Options)
+    {
+        FMemorySample Baseline;
+        if (!ReadProcMemorySample(Baseline))
+        {
+            std::printf("live: skipped (no /proc)\n");
+            return true;
+        }
+
+        auto Source = std::make_unique<FAnimatedImageSource>();
+        FAnimationCacheSettings CacheSettings;
+        CacheSettings.MaxCacheBytes = 1024 * MB;
+        if (!Check(Source->Open(std::make_unique<FSyntheticAnimation>(Options.Width, Options.Height, Options.Frames), CacheSettings), "open"))
+        {
+            return false;
+        }
+        int64_t LoopBytes = Source->GetCacheBytes();
+        int32_t LoopMs = Options.Frames * 20;
+        int32_t TimeoutMs = LoopMs * 4 + 5000;
+
+        FNullPresenter Presenter;
+        auto Layout = BuildSoftwareLayout<int32_t>({ { 0, 0, 640, 360 } }, { 1 }, false, {});
+        TSoftwarePipeline<int32_t> Pipeline(Presenter);
+        Pipeline.Start(std::move(Source), Layout, false);
+
+        // Let the cache fill untouched, then put the ceiling halfway up it.
+        FMemoryGovernorSettings Settings;
+        Settings.RestoreTicks = 4;
+        FMemoryGovernor Governor(Settings);
+        FMemorySample Filled;
+        bool bPass = Check
+        (
+            RunGovernor(Governor, Pipeline, Options.TickMs, TimeoutMs, [&]
+            {
+                return ReadProcMemorySample(Filled) && Filled.ResidentBytes >= Baseline.ResidentBytes + LoopBytes * 9 / 10;
+            }),
+            "cache never filled"
+        );
+        Settings.CeilingBytes = Baseline.ResidentBytes + LoopBytes / 2;
+        Governor.Configure(Settings);
+
+        auto Start = std::chrono::steady_clock::now();
+        FMemorySample Settled;
+        bPass &= Check
+        (
+            RunGovernor(Governor, Pipeline, Options.TickMs, TimeoutMs, [&]
+            {
+                return ReadProcMemorySample(Settled) && Settled.ResidentBytes < Settings.CeilingBytes && Pipeline.GetCacheBytes() == 0;
+            }),
+            "resident memory not brought under the ceiling"
+        );
+        double SettleMs = ElapsedMs(Start);
+        int32_t Level = Governor.GetCacheLevel();
+        bPass &= Check(Level > 0 && Governor.GetStats().Degrades > 0, "no cache degraded");
+        bPass &= Check(Governor.GetStats().Trims == 0, "trimmed while the cache could give");
+
+        uint64_t Presents = Presenter.Presents.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(LoopMs / 2 + 100));
+        bPass &= Check(Presenter.Presents.load() > Presents, "playback stopped after the cache was dropped");
+
+        // Ceiling lifted: the cache comes back from the next loop.
+        Settings.CeilingBytes = 0;
+        Governor.Configure(Settings);
+        bPass &= Check
+        (
+            RunGovernor(Governor, Pipeline, Options.TickMs, TimeoutMs, [&] { return Pipeline.GetCacheBytes() == LoopBytes; }),
+            "cache not restored"
+        );
+
+        // Paused: a new level is still applied, and the cache is freed without a frame shown.
+        Pipeline.SetPaused(true);
+        Pipeline.SetCacheLevel(MaxCacheLevel);
+        auto PauseStart = std::chrono::steady_clock::now();
+        while (Pipeline.GetCacheBytes() != 0 && ElapsedMs(PauseStart) < TimeoutMs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        bPass &= Check(Pipeline.GetCacheBytes() == 0, "cache level not applied while paused");
+        bPass &= Check(!Pipeline.HasFailed(), "pipeline failed");
+
+        std::printf
+        (
+            "live: %.1f MB loop cached over a %.1f MB baseline; ceiling %.1f MB reached in %.0f ms at cache level %d "
+            "(resident %.1f -> %.1f MB), restored after lifting it; %llu degrades, %llu restores, %llu presents\n",
+            static_cast<double>(LoopBytes) / MB, static_cast<double>(Baseline.ResidentBytes) / MB,
+            static_cast<double>(Baseline.ResidentBytes + LoopBytes / 2) / MB, SettleMs, Level,
+            static_cast<double>(Filled.ResidentBytes) / MB, static_cast<double>(Settled.ResidentBytes) / MB,
+            static_cast<unsigned long long>(Governor.GetStats().Degrades),
+            static_cast<unsigned long long>(Governor.GetStats().Restores),
+            static_cast<unsigned long long>(Presenter.Presents.load())
+        );
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: memory_bench [--size WxH] [--frames N] [--tick-ms N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckIdlePolicy(), "idle policy");
+    bPass &= Check(CheckPressurePolicy(), "pressure policy");
+    bPass &= Check(CheckProcParsing(), "/proc parsing");
+    bPass &= Check(CheckLive(Options), "live pipeline");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+// MemoryGovernor - Keeps resident memory in check over days of playback.
+// Once a tick the caller samples resident memory, the part of it held by decoded-
+// frame caches, whether anything on screen is moving, and the OS low-memory signal.
+// The governor answers with what to do: trim the working set (pages nobody touches
+// go back to the OS and fault in again if needed) or move caches one level down or
+// up (see GetCacheLevelBytes). Idle playback - paused, occluded, locked - is trimmed
+// once it has settled. A low-memory signal or a resident ceiling is met by degrading
+// caches first, one level at a time while they still hold memory, and by trimming
+// only once they have nothing left to give. Caches come back a level at a time after
+// a quiet streak well under the ceiling; a level that has to be given up again soon
+// after waits twice as long next time, as in the quality controller.
+// Pure logic fed with samples, so traces replay anywhere; ReadProcMemorySample is
+// the Linux sampler (and the test stand-in for the Windows counters).
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "video_source.h"
+
+/** One tick's measurements. */
+struct FMemorySample
+{
+    int64_t ResidentBytes = 0;      // Working set (Windows) or RSS (Linux)
+    int64_t CacheBytes = 0;         // ...of which decoded-frame caches that can be degraded
+    bool bIdle = false;             // Nothing on screen is moving: paused, occluded or hidden
+    bool bLowMemory = false;        // The OS reports memory pressure
+};
+
+struct FMemoryGovernorSettings
+{
+    int64_t CeilingBytes = 0;       // Resident memory to stay under; 0 = no ceiling
+    int32_t IdleTrimTicks = 5;      // Idle ticks before the working set is trimmed, once per idle spell
+    int32_t TrimIntervalTicks = 30; // Fewest ticks between trims under pressure
+    int32_t DegradeIntervalTicks = 2; // Ticks a cache level gets to take effect before the next
+    int32_t RestoreTicks = 120;     // Quiet ticks before a cache level is given back
+    int32_t MaxBackoffShift = 4;    // Restore streak grows to at most RestoreTicks << 4
+    double RestoreRatio = 0.7;      // Quiet: no pressure, and resident under CeilingBytes * this
+};
+
+enum class EMemoryReason : uint8_t
+{
+    NoAction,       // Nothing done yet
+    Idle,           // Playback stopped moving
+    LowMemory,      // The OS signalled pressure
+    Ceiling,        // Resident memory above CeilingBytes
+    Quiet           // Caches restored after a quiet streak
+};
+
+inline const char* GetMemoryReasonName(EMemoryReason Reason)
+{
+    switch (Reason)
+    {
+    case EMemoryReason::Idle: return "idle";
+    case EMemoryReason::LowMemory: return "low-memory";
+    case EMemoryReason::Ceiling: return "ceiling";
+    case EMemoryReason::Quiet: return "quiet";
+    default: return "none";
+    }
+}
+
+struct FMemoryDecision
+{
+    bool bTrimWorkingSet = false;
+    bool bCacheLevelChanged = false;
+    int32_t CacheLevel = 0;         // Level after this decision
+    EMemoryReason Reason = EMemoryReason::NoAction;
+};
+
+/** What the governor has done so far, for status reports. */
+struct FMemoryGovernorStats
+{
+    uint64_t Trims = 0;
+    uint64_t Degrades = 0;
+    uint64_t Restores = 0;
+    int64_t ResidentBytes = 0;      // Last sample
+    int64_t PeakResidentBytes = 0;
+    int64_t CacheBytes = 0;         // Last sample
+    EMemoryReason LastReason = EMemoryReason::NoAction;
+};
+
+class FMemoryGovernor
+{
+public:
+    explicit FMemoryGovernor(const FMemoryGovernorSettings& InSettings = {}) { Reset(InSettings); }
+
+    void Reset(const FMemoryGovernorSettings& InSettings)
+    {
+        Settings = InSettings;
+        Level = 0;
+        IdleTicks = 0;
+        QuietStreak = 0;
+        BackoffShift = 0;
+        TicksSinceTrim = Settings.TrimIntervalTicks;
+        TicksSinceDegrade = Settings.DegradeIntervalTicks;
+        TicksSinceRestore = -1;
+        Stats = {};
+    }
+
+    /** New settings (a changed ceiling, say) without forgetting the current level or counters. */
+    void Configure(const FMemoryGovernorSettings& InSettings) { Settings = InSettings; }
+
+    FMemoryDecision Update(const FMemorySample& Sample)
+    {
+        FMemoryDecision Decision;
+        Stats.ResidentBytes = Sample.ResidentBytes;
+        Stats.CacheBytes = Sample.CacheBytes;
+        if (Sample.ResidentBytes > Stats.PeakResidentBytes) Stats.PeakResidentBytes = Sample.ResidentBytes;
+        ++TicksSinceTrim;
+        ++TicksSinceDegrade;
+        if (TicksSinceRestore >= 0) ++TicksSinceRestore;
+        IdleTicks = Sample.bIdle ? IdleTicks + 1 : 0;
+
+        bool bOverCeiling = Settings.CeilingBytes > 0 && Sample.ResidentBytes > Settings.CeilingBytes;
+        if (Sample.bLowMemory || bOverCeiling)
+        {
+            EMemoryReason Reason = Sample.bLowMemory ? EMemoryReason::LowMemory : EMemoryReason::Ceiling;
+            QuietStreak = 0;
+            if (Level < MaxCacheLevel && Sample.CacheBytes > 0)
+            {
+                if (TicksSinceDegrade >= Settings.DegradeIntervalTicks) Degrade(Decision, Reason);
+            }
+            else if (TicksSinceTrim >= Settings.TrimIntervalTicks) Trim(Decision, Reason);
+        }
+        else
+        {
+            bool bQuiet = Settings.CeilingBytes <= 0
+                || Sample.ResidentBytes < static_cast<int64_t>(static_cast<double>(Settings.CeilingBytes) * Settings.RestoreRatio);
+            QuietStreak = bQuiet && Level > 0 ? QuietStreak + 1 : 0;
+            if (Level > 0 && QuietStreak >= GetRestoreTicks()) Restore(Decision);
+        }
+
+        // Idle trims come on top of whatever the caches did: nothing is being touched anyway.
+        if (IdleTicks == Settings.IdleTrimTicks && !Decision.bTrimWorkingSet) Trim(Decision, EMemoryReason::Idle);
+        Decision.CacheLevel = Level;
+        return Decision;
+    }
+
+    /** Counts a trim the caller made on its own (after startup, say), so the next one is not due at once. */
+    void NoteTrim()
+    {
+        ++Stats.Trims;
+        TicksSinceTrim = 0;
+    }
+
+    int32_t GetCacheLevel() const { return Level; }
+    const FMemoryGovernorStats& GetStats() const { return Stats; }
+
+    /** Quiet ticks needed before the next restore. */
+    int32_t GetRestoreTicks() const { return Settings.RestoreTicks << BackoffShift; }
+
+private:
+    void Trim(FMemoryDecision& Decision, EMemoryReason Reason)
+    {
+        Decision.bTrimWorkingSet = true;
+        if (Decision.Reason == EMemoryReason::NoAction) Decision.Reason = Reason;
+        Stats.LastReason = Decision.Reason;
+        ++Stats.Trims;
+        TicksSinceTrim = 0;
+    }
+
+    void Degrade(FMemoryDecision& Decision, EMemoryReason Reason)
+    {
+        // The level just given back did not hold: wait longer before the next attempt.
+        if (TicksSinceRestore >= 0 && TicksSinceRestore <= Settings.RestoreTicks && BackoffShift < Settings.MaxBackoffShift)
+        {
+            ++BackoffShift;
+        }
+        ++Level;
+        ++Stats.Degrades;
+        TicksSinceDegrade = 0;
+        TicksSinceRestore = -1;
+        Decision.bCacheLevelChanged = true;
+        Decision.Reason = Reason;
+        Stats.LastReason = Reason;
+    }
+
+    void Restore(FMemoryDecision& Decision)
+    {
+        --Level;
+        ++Stats.Restores;
+        QuietStreak = 0;
+        TicksSinceRestore = 0;
+        Decision.bCacheLevelChanged = true;
+        Decision.Reason = EMemoryReason::Quiet;
+        Stats.LastReason = EMemoryReason::Quiet;
+    }
+
+    FMemoryGovernorSettings Settings;
+    int32_t Level = 0;
+    int32_t IdleTicks = 0;
+    int32_t QuietStreak = 0;
+    int32_t BackoffShift = 0;
+    int32_t TicksSinceTrim = 0;
+    int32_t TicksSinceDegrade = 0;
+    int32_t TicksSinceRestore = -1;     // -1 until the first restore, and after a degrade
+    FMemoryGovernorStats Stats;
+};
+
+/** Value of a "Key:   1234 kB" line of a /proc file, in bytes; -1 if the key is missing. */
+inline int64_t ParseProcKilobytes(const std::string& Text, const char* Key)
+{
+    size_t KeyLength = std::strlen(Key);
+    std::istringstream Lines(Text);
+    std::string Line;
+    while (std::getline(Lines, Line))
+    {
+        if (Line.compare(0, KeyLength, Key) != 0 || Line.size() <= KeyLength || Line[KeyLength] != ':') continue;
+        return std::strtoll(Line.c_str() + KeyLength + 1, nullptr, 10) * 1024;
+    }
+    return -1;
+}
+
+inline std::string ReadWholeFile(const char* Path)
+{
+    std::ifstream File(Path);
+    std::ostringstream Text;
+    Text << File.rdbuf();
+    return Text.str();
+}
+
+/**
+ * Linux: resident memory from /proc/self/status and the low-memory signal from
+ * /proc/meminfo (available memory under LowMemoryRatio of the total). False where
+ * /proc does not exist. CacheBytes and bIdle are the caller's to fill.
+ */
+inline bool ReadProcMemorySample(FMemorySample& Sample, double LowMemoryRatio = 0.05)
+{
+    int64_t Resident = ParseProcKilobytes(ReadWholeFile("/proc/self/status"), "VmRSS");
+    if (Resident < 0) return false;
+    Sample.ResidentBytes = Resident;
+
+    std::string MemInfo = ReadWholeFile("/proc/meminfo");
+    int64_t Total = ParseProcKilobytes(MemInfo, "MemTotal");
+    int64_t Available = ParseProcKilobytes(MemInfo, "MemAvailable");
+    Sample.bLowMemory = Total > 0 && Available >= 0
+        && static_cast<double>(Available) < static_cast<double>(Total) * LowMemoryRatio;
+    return true;
+}
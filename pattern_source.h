@@ -0,0 +1,290 @@
+// PatternSource - Built-in synthetic video as a frame source.
+// Deterministic scenes generated from the frame index and a seed, so whatever
+// presents them always has the same work and benchmarks repeat exactly without a
+// video file or a decoder: moving colour bars (every tile changes), full-frame
+// motion under noise (nothing repeats), a still background with one moving box
+// (few dirty tiles), and a frozen frame. Size, frame rate, length and 8/10-bit
+// output are settings; a ":pattern:..." path selects them wherever a video path
+// is taken, so headless runs of the X11 wallpaper and decode service need no file.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "video_source.h"
+
+/** Frame rate of the built-in test pattern. */
+constexpr uint32_t PatternFrameRate = 30;
+
+enum class EPatternScene : uint8_t
+{
+    Bars,       // Colour bars scrolling sideways: every tile changes every frame
+    Motion,     // Diagonal gradient scrolling under per-frame noise: no two frames share a tile
+    Static,     // Still gradient with one small box bouncing across it: a few dirty tiles per frame
+    Still       // The first frame of Static, forever: nothing changes after it
+};
+
+inline const char* GetPatternSceneName(EPatternScene Scene)
+{
+    switch (Scene)
+    {
+    case EPatternScene::Bars:   return "bars";
+    case EPatternScene::Motion: return "motion";
+    case EPatternScene::Static: return "static";
+    case EPatternScene::Still:  return "still";
+    default:                    return "unknown";
+    }
+}
+
+struct FPatternSettings
+{
+    int32_t Width = 1920;
+    int32_t Height = 1080;
+    uint32_t FrameRateNumerator = PatternFrameRate;
+    uint32_t FrameRateDenominator = 1;
+    int64_t FrameCount = 0;                     // End of stream after this many frames; 0 never ends
+    EPatternScene Scene = EPatternScene::Bars;
+    EPixelFormat Format = EPixelFormat::NV12;   // NV12, or P010 to feed the HDR tone-mapping path
+    uint32_t Seed = 1;                          // Motion: the noise
+};
+
+/** Path prefix that names the pattern instead of a file. */
+inline constexpr const char* PatternPathPrefix = ":pattern";
+
+inline bool IsPatternPath(const std::string& Path)
+{
+    return Path.compare(0, 8, PatternPathPrefix) == 0 && (Path.size() == 8 || Path[8] == ':');
+}
+
+/**
+ * Reads ":pattern" or ":pattern:scene=motion,size=1280x720,fps=30000/1001,frames=300,
+ * format=p010,seed=7" over Settings; whatever is not given keeps its value, so callers
+ * fill in the monitor size first. False if Path is not a pattern or an option is bad.
+ */
+inline bool ParsePatternPath(const std::string& Path, FPatternSettings& Settings)
+{
+    if (!IsPatternPath(Path)) return false;
+    size_t Start = 9;
+    while (Start < Path.size())
+    {
+        size_t End = Path.find(',', Start);
+        if (End == std::string::npos) End = Path.size();
+        std::string Option = Path.substr(Start, End - Start);
+        Start = End + 1;
+        size_t Equals = Option.find('=');
+        if (Equals == std::string::npos) return false;
+        std::string Name = Option.substr(0, Equals);
+        std::string Value = Option.substr(Equals + 1);
+        char* Rest = nullptr;
+        if (Name == "scene")
+        {
+            if (Value == "bars") Settings.Scene = EPatternScene::Bars;
+            else if (Value == "motion") Settings.Scene = EPatternScene::Motion;
+            else if (Value == "static") Settings.Scene = EPatternScene::Static;
+            else if (Value == "still") Settings.Scene = EPatternScene::Still;
+            else return false;
+        }
+        else if (Name == "size")
+        {
+            long Width = std::strtol(Value.c_str(), &Rest, 10);
+            if (*Rest != 'x' && *Rest != 'X') return false;
+            long Height = std::strtol(Rest + 1, &Rest, 10);
+            if (*Rest || Width < 2 || Height < 2 || Width > 16384 || Height > 16384) return false;
+            Settings.Width = static_cast<int32_t>(Width);
+            Settings.Height = static_cast<int32_t>(Height);
+        }
+        else if (Name == "fps")
+        {
+            unsigned long Numerator = std::strtoul(Value.c_str(), &Rest, 10);
+            unsigned long Denominator = 1;
+            if (*Rest == '/') Denominator = std::strtoul(Rest + 1, &Rest, 10);
+            if (*Rest || !Numerator || !Denominator || Numerator > 1000000 || Denominator > 1000000) return false;
+            Settings.FrameRateNumerator = static_cast<uint32_t>(Numerator);
+            Settings.FrameRateDenominator = static_cast<uint32_t>(Denominator);
+        }
+        else if (Name == "frames")
+        {
+            long long Frames = std::strtoll(Value.c_str(), &Rest, 10);
+            if (*Rest || Value.empty() || Frames < 0) return false;
+            Settings.FrameCount = Frames;
+        }
+        else if (Name == "format")
+        {
+            if (Value == "nv12") Settings.Format = EPixelFormat::NV12;
+            else if (Value == "p010") Settings.Format = EPixelFormat::P010;
+            else return false;
+        }
+        else if (Name == "seed")
+        {
+            Settings.Seed = static_cast<uint32_t>(std::strtoul(Value.c_str(), &Rest, 10));
+            if (*Rest || Value.empty()) return false;
+        }
+        else return false;
+    }
+    return true;
+}
+
+class FPatternSource final : public IVideoSource
+{
+public:
+    FPatternSource(int32_t Width, int32_t Height)
+    {
+        FPatternSettings Defaults;
+        Defaults.Width = Width;
+        Defaults.Height = Height;
+        Configure(Defaults);
+    }
+
+    explicit FPatternSource(const FPatternSettings& InSettings) { Configure(InSettings); }
+
+    const FVideoInfo& GetInfo() const override { return Info; }
+    const FPatternSettings& GetSettings() const { return Settings; }
+
+    bool ReadFrame(FFrame& Out) override
+    {
+        if (Settings.FrameCount && FrameIndex >= static_cast<uint64_t>(Settings.FrameCount)) return false;
+        Out.Allocate(Info.Width, Info.Height, Info.Format);
+        if (Info.Format == EPixelFormat::P010) Render<uint16_t>(Out.GetView());
+        else Render<uint8_t>(Out.GetView());
+        Out.Timestamp100ns = GetFrameTime(FrameIndex++);
+        return true;
+    }
+
+    bool Seek(int64_t Position100ns) override
+    {
+        if (Position100ns < 0) Position100ns = 0;
+        // First frame at or after the position: timestamps are rounded down, so round the index up.
+        uint64_t Scaled = static_cast<uint64_t>(Position100ns) * Info.FrameRateNumerator;
+        uint64_t Period = 10000000ULL * Info.FrameRateDenominator;
+        FrameIndex = (Scaled + Period - 1) / Period;
+        return true;
+    }
+
+private:
+    void Configure(const FPatternSettings& InSettings)
+    {
+        Settings = InSettings;
+        Settings.Width = Settings.Width > 2 ? Settings.Width & ~1 : 2;
+        Settings.Height = Settings.Height > 2 ? Settings.Height & ~1 : 2;
+        if (!Settings.FrameRateNumerator || !Settings.FrameRateDenominator)
+        {
+            Settings.FrameRateNumerator = PatternFrameRate;
+            Settings.FrameRateDenominator = 1;
+        }
+        if (Settings.Format != EPixelFormat::P010) Settings.Format = EPixelFormat::NV12;
+        Info.Width = Settings.Width;
+        Info.Height = Settings.Height;
+        Info.FrameRateNumerator = Settings.FrameRateNumerator;
+        Info.FrameRateDenominator = Settings.FrameRateDenominator;
+        Info.Format = Settings.Format;
+        Info.Duration100ns = Settings.FrameCount ? GetFrameTime(static_cast<uint64_t>(Settings.FrameCount)) : 0;
+    }
+
+    /** Exact for fractional rates such as 30000/1001, where FrameDuration100ns() would drift. */
+    int64_t GetFrameTime(uint64_t Index) const
+    {
+        return static_cast<int64_t>(Index * 10000000ULL * Info.FrameRateDenominator / Info.FrameRateNumerator);
+    }
+
+    /** Samples are computed in 10 bits; NV12 keeps the top 8, P010 stores them MSB-aligned. */
+    template <typename TSample>
+    static void Store(uint8_t* Row, int32_t X, int32_t Value)
+    {
+        if constexpr (sizeof(TSample) == 1) Row[X] = static_cast<uint8_t>(Value >> 2);
+        else reinterpret_cast<uint16_t*>(Row)[X] = static_cast<uint16_t>(Value << 6);
+    }
+
+    /** Noise in [0, 63] from the position, the frame and the seed. */
+    static int32_t Noise(uint32_t X, uint32_t Y, uint32_t Frame, uint32_t Seed)
+    {
+        uint32_t Hash = X * 0x9E3779B1u ^ Y * 0x85EBCA77u ^ Frame * 0xC2B2AE3Du ^ Seed * 0x27D4EB2Fu;
+        Hash ^= Hash >> 15;
+        Hash *= 0x2C1B3C6Du;
+        Hash ^= Hash >> 12;
+        return static_cast<int32_t>(Hash >> 26);
+    }
+
+    template <typename TSample>
+    void Render(const FFrameView& View) const
+    {
+        int32_t Width = Info.Width;
+        int32_t Height = Info.Height;
+        uint32_t Frame = static_cast<uint32_t>(Settings.Scene == EPatternScene::Still ? 0 : FrameIndex);
+        int32_t Shift = static_cast<int32_t>(FrameIndex * 4 % static_cast<uint64_t>(Width));
+
+        // Static and Still: a box one eighth of the frame, bouncing off the edges.
+        int32_t BoxWidth = Width / 8 > 2 ? Width / 8 & ~1 : 2;
+        int32_t BoxHeight = Height / 8 > 2 ? Height / 8 & ~1 : 2;
+        auto Bounce = [](uint32_t Step, int32_t Range)
+        {
+            if (Range <= 0) return 0;
+            int32_t Phase = static_cast<int32_t>(Step % static_cast<uint32_t>(2 * Range));
+            return (Phase < Range ? Phase : 2 * Range - Phase) & ~1;
+        };
+        int32_t BoxLeft = Bounce(Frame * 6, Width - BoxWidth);
+        int32_t BoxTop = Bounce(Frame * 4, Height - BoxHeight);
+        auto InBox = [&](int32_t X, int32_t Y)
+        {
+            return X >= BoxLeft && X < BoxLeft + BoxWidth && Y >= BoxTop && Y < BoxTop + BoxHeight;
+        };
+
+        for (int32_t Y = 0; Y < View.Height; ++Y)
+        {
+            uint8_t* Row = View.Row(0, Y);
+            for (int32_t X = 0; X < View.Width; ++X)
+            {
+                int32_t Luma;
+                switch (Settings.Scene)
+                {
+                case EPatternScene::Bars:
+                    Luma = 64 + ((X + Shift) % Width) * 876 / Width;
+                    break;
+                case EPatternScene::Motion:
+                    Luma = 64 + static_cast<int32_t>((static_cast<uint32_t>(X + Y) + Frame * 8) % 768)
+                        + Noise(static_cast<uint32_t>(X), static_cast<uint32_t>(Y), Frame, Settings.Seed) * 2;
+                    break;
+                default:
+                    Luma = InBox(X, Y) ? 820 : 64 + (X * 438 / Width) + (Y * 438 / Height);
+                    break;
+                }
+                Store<TSample>(Row, X, Luma);
+            }
+        }
+        for (int32_t Y = 0; Y < View.Height / 2; ++Y)
+        {
+            uint8_t* Row = View.Row(1, Y);
+            for (int32_t X = 0; X < View.Width; X += 2)
+            {
+                int32_t U;
+                int32_t V;
+                switch (Settings.Scene)
+                {
+                case EPatternScene::Bars:
+                {
+                    int32_t Bar = ((X + Shift) % Width * 8 / Width) & 7;
+                    U = Bar & 1 ? 256 : 768;
+                    V = Bar & 2 ? 256 : 768;
+                    break;
+                }
+                case EPatternScene::Motion:
+                    U = 256 + static_cast<int32_t>((static_cast<uint32_t>(X) + Frame * 2) % 512);
+                    V = 256 + static_cast<int32_t>((static_cast<uint32_t>(Y * 2) + Frame * 3) % 512);
+                    break;
+                default:
+                    U = InBox(X, Y * 2) ? 320 : 384 + X * 256 / Width;
+                    V = InBox(X, Y * 2) ? 800 : 640 - Y * 512 / Height;
+                    break;
+                }
+                Store<TSample>(Row, X, U);
+                Store<TSample>(Row, X + 1, V);
+            }
+        }
+    }
+
+    FPatternSettings Settings;
+    FVideoInfo Info;
+    uint64_t FrameIndex = 0;
+};
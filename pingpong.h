@@ -0,0 +1,434 @@
+// PingPong - Forward-then-reverse ("boomerang") looping over any IVideoSource.
+// Decoders only run forwards, so reverse playback is built from segments: the
+// frames of one GOP (or a slice of it) are decoded forwards into a cache and shown
+// back to front. While one segment plays, the one before it is decoded into a
+// second cache a few frames at a time, spread evenly over the frames still to show,
+// so reverse runs at the forward rate with no burst at segment boundaries. The two
+// caches together stay under a byte budget; a GOP longer than half of it is split
+// into slices that each decode from the GOP's keyframe. The last segment of the
+// reverse pass is captured as the forward pass plays through it, so the turn at
+// the end needs no decoding either. Emitted timestamps keep increasing across turns.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "frame.h"
+#include "video_source.h"
+
+constexpr int64_t DefaultPingPongCacheBytes = 256ll * 1024 * 1024;
+
+/**
+ * Keyframe timestamps that arrive after playback has started (the sample table is
+ * read in the background). Shared between the reader and the source; the source
+ * picks them up at its next turn.
+ */
+class FKeyframeTimestamps
+{
+public:
+    void Set(std::vector<int64_t> InTimestamps)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Timestamps = std::move(InTimestamps);
+        ++Version;
+    }
+
+    /** Copies the timestamps into Out if they changed since KnownVersion. */
+    bool TakeIfNewer(uint32_t& KnownVersion, std::vector<int64_t>& Out) const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (Version == KnownVersion) return false;
+        KnownVersion = Version;
+        Out = Timestamps;
+        return true;
+    }
+
+private:
+    mutable std::mutex Mutex;
+    std::vector<int64_t> Timestamps;
+    uint32_t Version = 0;
+};
+
+struct FPingPongSettings
+{
+    int64_t MaxCacheBytes = DefaultPingPongCacheBytes;     // Both segment caches together
+    std::shared_ptr<const FKeyframeTimestamps> Keyframes;   // Optional; without it segments are fixed slices
+};
+
+/** Frames [FirstFrame, EndFrame) of a pass, decoded forwards from SeekTimestamp100ns. */
+struct FReverseSegment
+{
+    int64_t SeekTimestamp100ns = 0;
+    size_t FirstFrame = 0;
+    size_t EndFrame = 0;
+    size_t DecodeCost = 0;      // Frames decoded to fill it, counting from the seek point
+};
+
+/** Frames per segment such that two segments of FrameBytes frames fit in MaxCacheBytes; at least one. */
+inline size_t GetReverseSegmentFrames(int64_t MaxCacheBytes, size_t FrameBytes)
+{
+    if (!FrameBytes || MaxCacheBytes <= 0) return 1;
+    size_t Frames = static_cast<size_t>(MaxCacheBytes) / (2 * FrameBytes);
+    return Frames ? Frames : 1;
+}
+
+/**
+ * Splits a pass into reverse segments, returned in playing order (the last frames
+ * first). A GOP is one segment when it fits MaxSegmentFrames, or slices of it counted
+ * from its keyframe otherwise; each slice then decodes from the keyframe, so a slice
+ * ending k frames into its GOP costs k decodes. Without keyframes every slice is
+ * treated as its own GOP: the decoder lands wherever the seek takes it.
+ */
+inline std::vector<FReverseSegment> PlanReverseSegments
+(
+    const std::vector<int64_t>& FrameTimestamps,
+    const std::vector<int64_t>& KeyframeTimestamps,
+    size_t MaxSegmentFrames
+)
+{
+    std::vector<FReverseSegment> Segments;
+    size_t FrameCount = FrameTimestamps.size();
+    if (!FrameCount) return Segments;
+    if (!MaxSegmentFrames) MaxSegmentFrames = 1;
+
+    // GOP starts as frame indices; frames before the first keyframe join the first GOP.
+    std::vector<size_t> GopStarts{ 0 };
+    for (int64_t Keyframe : KeyframeTimestamps)
+    {
+        size_t Index = static_cast<size_t>
+        (
+            std::lower_bound(FrameTimestamps.begin(), FrameTimestamps.end(), Keyframe) - FrameTimestamps.begin()
+        );
+        if (Index < FrameCount && Index > GopStarts.back()) GopStarts.push_back(Index);
+    }
+    bool bKnownGops = GopStarts.size() > 1 || !KeyframeTimestamps.empty();
+    if (!bKnownGops)
+    {
+        GopStarts.clear();
+        for (size_t Start = 0; Start < FrameCount; Start += MaxSegmentFrames) GopStarts.push_back(Start);
+    }
+
+    for (size_t Gop = 0; Gop < GopStarts.size(); ++Gop)
+    {
+        size_t GopStart = GopStarts[Gop];
+        size_t GopEnd = Gop + 1 < GopStarts.size() ? GopStarts[Gop + 1] : FrameCount;
+        for (size_t First = GopStart; First < GopEnd; First += MaxSegmentFrames)
+        {
+            FReverseSegment Segment;
+            Segment.SeekTimestamp100ns = FrameTimestamps[GopStart];
+            Segment.FirstFrame = First;
+            Segment.EndFrame = First + MaxSegmentFrames < GopEnd ? First + MaxSegmentFrames : GopEnd;
+            Segment.DecodeCost = Segment.EndFrame - GopStart;
+            Segments.push_back(Segment);
+        }
+    }
+    std::reverse(Segments.begin(), Segments.end());
+    return Segments;
+}
+
+/** Decodes to run before showing the next frame: RemainingDecodes spread evenly over RemainingFrames. */
+inline size_t GetPrefetchBudget(size_t RemainingDecodes, size_t RemainingFrames)
+{
+    if (!RemainingFrames) return RemainingDecodes;
+    return (RemainingDecodes + RemainingFrames - 1) / RemainingFrames;
+}
+
+/** Copies every plane of Source into Dest, reallocating Dest only if the layout differs. */
+inline void CopyFramePixels(const FFrame& Source, FFrame& Dest)
+{
+    const FFrameView& From = Source.GetView();
+    Dest.Allocate(From.Width, From.Height, From.Format);
+    const FFrameView& To = Dest.GetView();
+    size_t RowBytes = static_cast<size_t>(From.Width) * BytesPerPixel(From.Format);
+    for (int32_t Y = 0; Y < From.Height; ++Y) std::memcpy(To.Row(0, Y), From.Row(0, Y), RowBytes);
+    if (PlaneCount(From.Format) == 2)
+    {
+        for (int32_t Y = 0; Y < (From.Height + 1) / 2; ++Y) std::memcpy(To.Row(1, Y), From.Row(1, Y), RowBytes);
+    }
+    Dest.Timestamp100ns = Source.Timestamp100ns;
+}
+
+class FPingPongSource final : public IVideoSource
+{
+public:
+    FPingPongSource(std::unique_ptr<IVideoSource> InInner, const FPingPongSettings& InSettings)
+        : Inner(std::move(InInner)), Settings(InSettings), ConfiguredCacheBytes(InSettings.MaxCacheBytes)
+    {
+        Scratch.SetResourceTag("PingPong.Cache");
+    }
+
+    const FVideoInfo& GetInfo() const override { return Inner->GetInfo(); }
+
+    /** Never ends by itself: false only when the inner source fails. */
+    bool ReadFrame(FFrame& Out) override
+    {
+        uint64_t DecodedBefore = DecodedFrames;
+        bool bRead = bReverse ? ReadReverse(Out) : ReadForward(Out);
+        size_t Decodes = static_cast<size_t>(DecodedFrames - DecodedBefore);
+        MaxDecodesPerFrame = Decodes > MaxDecodesPerFrame ? Decodes : MaxDecodesPerFrame;
+        return bRead;
+    }
+
+    /** Any position restarts the forward pass from the first frame; the plan and caches are kept. */
+    bool Seek(int64_t) override
+    {
+        bReverse = false;
+        bSkipFirstFrame = false;
+        FrameIndex = 0;
+        Playing.Count = Filling.Count = 0;
+        Filling.First = Segments.empty() ? 0 : Segments.front().FirstFrame;
+        bPrefetching = false;
+        return Inner->Seek(0);
+    }
+
+    int64_t GetCacheBytes() const override
+    {
+        int64_t Bytes = static_cast<int64_t>(Scratch.GetSizeBytes());
+        for (const FSegmentCache* Cache : { &Playing, &Filling })
+        {
+            for (const auto& Frame : Cache->Frames) Bytes += static_cast<int64_t>(Frame.GetSizeBytes());
+        }
+        return Bytes;
+    }
+
+    /**
+     * Replans with the scaled budget: at once going forwards (the tail is then decoded
+     * at the turn), after the reverse pass otherwise. At the last level segments are
+     * single frames, each decoded from its keyframe.
+     */
+    void SetCacheLevel(int32_t Level) override
+    {
+        Settings.MaxCacheBytes = GetCacheLevelBytes(ConfiguredCacheBytes, Level);
+        bPlanDirty = true;
+        if (!bReverse) Replan();
+    }
+
+    /** Frames pulled from the inner source; in steady state about one per frame shown, plus slice re-decodes. */
+    uint64_t GetDecodedFrames() const { return DecodedFrames; }
+
+    /** Most inner decodes any single ReadFrame ran: how evenly the prefetch is spread. */
+    size_t GetMaxDecodesPerFrame() const { return MaxDecodesPerFrame; }
+    void ResetMaxDecodesPerFrame() { MaxDecodesPerFrame = 0; }
+
+    size_t GetSegmentFrames() const { return SegmentFrames; }
+    size_t GetSegmentCount() const { return Segments.size(); }
+    uint64_t GetTurns() const { return Turns; }
+
+private:
+    /** Frames of one reverse segment, slot k holding frame First + k of the pass. */
+    struct FSegmentCache
+    {
+        std::vector<FFrame> Frames;
+        size_t First = 0;
+        size_t Count = 0;
+    };
+
+    bool ReadForward(FFrame& Out)
+    {
+        for (;;)
+        {
+            if (!Inner->ReadFrame(Out))
+            {
+                // Fewer than two frames cannot turn; let the caller loop or fail as usual.
+                if (FrameIndex < 2) return false;
+                if (!BeginReverse()) return false;
+                return ReadReverse(Out);
+            }
+            ++DecodedFrames;
+            size_t Index = FrameIndex++;
+            if (Index >= FrameTimestamps.size())
+            {
+                FrameTimestamps.push_back(Out.Timestamp100ns);
+                bPlanDirty = true;
+            }
+            if (bSkipFirstFrame && Index == 0) continue; // Shown last by the reverse pass
+            FrameBytes = Out.GetSizeBytes();
+            CaptureTail(Out, Index);
+            Out.Timestamp100ns = PassBase100ns + (FrameTimestamps[Index] - FrameTimestamps[0]);
+            return true;
+        }
+    }
+
+    /** Copies the frames of the first reverse segment as the forward pass plays through them. */
+    void CaptureTail(const FFrame& Frame, size_t Index)
+    {
+        if (bPlanDirty || Segments.empty()) return;
+        const FReverseSegment& Tail = Segments.front();
+        if (Index < Tail.FirstFrame || Index >= Tail.EndFrame || Index != Filling.First + Filling.Count) return;
+        CopyFramePixels(Frame, Filling.Frames[Filling.Count++]);
+    }
+
+    /** At the end of a forward pass: (re)plans if needed, then plays the tail back from the cache. */
+    bool BeginReverse()
+    {
+        if (FrameIndex != FrameTimestamps.size())
+        {
+            FrameTimestamps.resize(FrameIndex);
+            bPlanDirty = true;
+        }
+        if (Settings.Keyframes && Settings.Keyframes->TakeIfNewer(KeyframesVersion, KeyframeTimestamps)) bPlanDirty = true;
+        if (bPlanDirty) Replan();
+
+        ++Turns;
+        PassBase100ns += FrameTimestamps.back() - FrameTimestamps[0];
+        bReverse = true;
+        SegmentIndex = 0;
+        const FReverseSegment& Tail = Segments.front();
+        if (Filling.First != Tail.FirstFrame || Filling.Count != Tail.EndFrame - Tail.FirstFrame)
+        {
+            // First turn (or a new plan): nothing captured, so this segment is decoded now.
+            StartPrefetch(0);
+            if (!FinishPrefetch()) return false;
+        }
+        std::swap(Playing, Filling);
+        StartPrefetch(1);
+
+        // The last frame was just shown going forwards.
+        EmitIndex = static_cast<int64_t>(FrameTimestamps.size()) - 2;
+        return true;
+    }
+
+    bool ReadReverse(FFrame& Out)
+    {
+        if (EmitIndex < 0)
+        {
+            // Back at the first frame: play forwards again from the second.
+            bReverse = false;
+            bSkipFirstFrame = true;
+            bPrefetching = false;
+            FrameIndex = 0;
+            PassBase100ns += FrameTimestamps.back() - FrameTimestamps[0];
+            if (bPlanDirty) Replan();
+            Filling.First = Segments.front().FirstFrame;
+            Filling.Count = 0;
+            if (!Inner->Seek(FrameTimestamps[0])) return false;
+            return ReadForward(Out);
+        }
+
+        while (EmitIndex < static_cast<int64_t>(Playing.First))
+        {
+            if (!FinishPrefetch()) return false;
+            std::swap(Playing, Filling);
+            StartPrefetch(++SegmentIndex + 1);
+        }
+        // A segment the decoder came up short on plays what it has.
+        int64_t Last = static_cast<int64_t>(Playing.First + Playing.Count) - 1;
+        if (EmitIndex > Last) EmitIndex = Last;
+
+        size_t RemainingFrames = static_cast<size_t>(EmitIndex - static_cast<int64_t>(Playing.First)) + 1;
+        size_t Budget = GetPrefetchBudget(PrefetchRemaining(), RemainingFrames);
+        for (size_t Step = 0; Step < Budget && bPrefetching; ++Step) PrefetchOne();
+
+        CopyFramePixels(Playing.Frames[static_cast<size_t>(EmitIndex) - Playing.First], Out);
+        Out.Timestamp100ns = PassBase100ns + (FrameTimestamps.back() - FrameTimestamps[static_cast<size_t>(EmitIndex)]);
+        --EmitIndex;
+        return true;
+    }
+
+    void Replan()
+    {
+        bPlanDirty = false;
+        SegmentFrames = GetReverseSegmentFrames(Settings.MaxCacheBytes, FrameBytes);
+        Segments = PlanReverseSegments(FrameTimestamps, KeyframeTimestamps, SegmentFrames);
+        size_t Slots = 0;
+        for (const auto& Segment : Segments)
+        {
+            Slots = Segment.EndFrame - Segment.FirstFrame > Slots ? Segment.EndFrame - Segment.FirstFrame : Slots;
+        }
+        for (FSegmentCache* Cache : { &Playing, &Filling })
+        {
+            Cache->Frames.resize(Slots);
+            for (auto& Frame : Cache->Frames) Frame.SetResourceTag("PingPong.Cache");
+            Cache->Count = 0;
+        }
+    }
+
+    /** Points the decoder at a segment; past the last segment there is nothing to prefetch. */
+    void StartPrefetch(size_t Index)
+    {
+        bPrefetching = Index < Segments.size();
+        PrefetchSegment = Index;
+        PrefetchDecodes = 0;
+        Filling.Count = 0;
+        if (!bPrefetching) return;
+        Filling.First = Segments[Index].FirstFrame;
+        if (!Inner->Seek(Segments[Index].SeekTimestamp100ns)) bPrefetching = false;
+    }
+
+    size_t PrefetchRemaining() const
+    {
+        if (!bPrefetching) return 0;
+        size_t Cost = Segments[PrefetchSegment].DecodeCost;
+        return Cost > PrefetchDecodes ? Cost - PrefetchDecodes : 1;
+    }
+
+    /**
+     * Decodes one frame towards the segment being filled. Frames before it (the GOP
+     * lead-in) are decoded into the next free slot and dropped. False at end of stream.
+     */
+    bool PrefetchOne()
+    {
+        const FReverseSegment& Segment = Segments[PrefetchSegment];
+        FFrame& Slot = Filling.Count < Filling.Frames.size() ? Filling.Frames[Filling.Count] : Scratch;
+        if (!Inner->ReadFrame(Slot))
+        {
+            bPrefetching = false;
+            return false;
+        }
+        ++DecodedFrames;
+        ++PrefetchDecodes;
+        size_t Index = static_cast<size_t>
+        (
+            std::upper_bound(FrameTimestamps.begin(), FrameTimestamps.end(), Slot.Timestamp100ns) - FrameTimestamps.begin()
+        );
+        Index = Index ? Index - 1 : 0;
+        if (Index >= Segment.FirstFrame && Index < Segment.EndFrame && &Slot != &Scratch) ++Filling.Count;
+        if (Filling.Count >= Segment.EndFrame - Segment.FirstFrame || Index + 1 >= Segment.EndFrame) bPrefetching = false;
+        return true;
+    }
+
+    /** Decodes whatever the prefetch has left; false if the segment came up empty. */
+    bool FinishPrefetch()
+    {
+        while (bPrefetching) PrefetchOne();
+        return Filling.Count > 0;
+    }
+
+    std::unique_ptr<IVideoSource> Inner;
+    FPingPongSettings Settings;
+    int64_t ConfiguredCacheBytes = 0;
+
+    std::vector<int64_t> FrameTimestamps;      // Media time of every frame of a pass, learned on the first
+    std::vector<int64_t> KeyframeTimestamps;
+    uint32_t KeyframesVersion = 0;
+    std::vector<FReverseSegment> Segments;
+    size_t SegmentFrames = 0;
+    size_t FrameBytes = 0;
+    bool bPlanDirty = true;
+
+    FSegmentCache Playing;
+    FSegmentCache Filling;
+    FFrame Scratch;                             // Decode target once the filling cache is full
+    bool bPrefetching = false;
+    size_t PrefetchSegment = 0;
+    size_t PrefetchDecodes = 0;
+
+    bool bReverse = false;
+    bool bSkipFirstFrame = false;
+    size_t FrameIndex = 0;                      // Forward: frames read this pass
+    size_t SegmentIndex = 0;                    // Reverse: segment playing
+    int64_t EmitIndex = 0;                      // Reverse: next frame to show
+    int64_t PassBase100ns = 0;
+
+    uint64_t DecodedFrames = 0;
+    uint64_t Turns = 0;
+    size_t MaxDecodesPerFrame = 0;
+};
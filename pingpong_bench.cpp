@@ -0,0 +1,305 @@
+// pingpong_bench - Checks and times ping-pong looping on synthetic GOP streams.
+// The synthetic video stamps its frame index into the pixels and, like a real
+// decoder, lands every seek on the keyframe at or before the target, so reverse
+// segments pay their lead-in. For a range of lengths, GOP sizes and cache budgets,
+// with and without a keyframe list, it first checks the segment plan (every frame
+// in exactly one segment, in reverse order, none over budget), then plays several
+// forward-and-back cycles and checks the frames shown (0..N-1, N-2..0, 1..N-1, ...),
+// that timestamps advance by one frame every frame, that the caches stay within
+// budget and are freed with the source, and, with keyframes, that no frame runs
+// more decodes than the plan spreads over it. Builds anywhere the portable headers do:
+//   g++ -std=c++20 -O2 -pthread pingpong_bench.cpp -o pingpong_bench
+//   pingpong_bench [--size WxH] [--cycles N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pingpong.h"
+#include "resource_tracker.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t Width = 320;
+        int32_t Height = 180;
+        int32_t Cycles = 3;
+    };
+
+    struct FBenchCase
+    {
+        int32_t Frames = 0;
+        int32_t Gop = 0;
+        int32_t CacheFrames = 0;    // Frames per segment the budget allows
+        bool bKeyframes = false;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--size")
+            {
+                if (std::sscanf(Value, "%dx%d", &Options.Width, &Options.Height) != 2) return false;
+                if (Options.Width < 4 || Options.Height <= 0) return false;
+            }
+            else if (Name == "--cycles") Options.Cycles = std::atoi(Value);
+            else return false;
+        }
+        return Options.Cycles > 0;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    constexpr int64_t FirstTimestamp100ns = 2000;
+
+    /** Frames of Gop frames each; a seek lands on the keyframe at or before the target. */
+    class FSyntheticGopVideo final : public IVideoSource
+    {
+    public:
+        FSyntheticGopVideo(int32_t Width, int32_t Height, int32_t InFrames, int32_t InGop)
+            : Frames(InFrames), Gop(InGop)
+        {
+            Info.Width = Width;
+            Info.Height = Height;
+            Info.Format = EPixelFormat::NV12;
+            Info.FrameRateNumerator = 60;
+            Info.Duration100ns = Info.FrameDuration100ns() * Frames;
+        }
+
+        const FVideoInfo& GetInfo() const override { return Info; }
+
+        bool ReadFrame(FFrame& Out) override
+        {
+            if (Next >= Frames) return false;
+            Out.Allocate(Info.Width, Info.Height, EPixelFormat::NV12);
+            const FFrameView& View = Out.GetView();
+            uint32_t Stamp = static_cast<uint32_t>(Next);
+            std::memcpy(View.Row(0, 0), &Stamp, sizeof(Stamp));
+            Out.Timestamp100ns = GetTimestamp(Next++);
+            ++Decodes;
+            return true;
+        }
+
+        bool Seek(int64_t Position100ns) override
+        {
+            int64_t Duration = Info.FrameDuration100ns();
+            int64_t Offset = Position100ns - FirstTimestamp100ns;
+            int32_t Target = Offset <= 0 ? 0 : static_cast<int32_t>((Offset + Duration - 1) / Duration);
+            Next = Target >= Frames ? Frames : Target / Gop * Gop;
+            return true;
+        }
+
+        int64_t GetTimestamp(int32_t Index) const { return FirstTimestamp100ns + Index * Info.FrameDuration100ns(); }
+
+        std::vector<int64_t> GetKeyframeTimestamps() const
+        {
+            std::vector<int64_t> Keyframes;
+            for (int32_t Index = 0; Index < Frames; Index += Gop) Keyframes.push_back(GetTimestamp(Index));
+            return Keyframes;
+        }
+
+        uint64_t Decodes = 0;
+
+    private:
+        FVideoInfo Info;
+        int32_t Frames = 0;
+        int32_t Gop = 1;
+        int32_t Next = 0;
+    };
+
+    uint32_t GetStamp(const FFrame& Frame)
+    {
+        uint32_t Stamp = 0;
+        std::memcpy(&Stamp, Frame.GetView().Row(0, 0), sizeof(Stamp));
+        return Stamp;
+    }
+
+    int64_t GetLive(const char* Subsystem, EResourceKind Kind, int64_t* Peak = nullptr)
+    {
+        for (const auto& Count : GResources.Snapshot())
+        {
+            if (std::strcmp(Count.Subsystem, Subsystem) != 0 || Count.Kind != Kind) continue;
+            if (Peak) *Peak = Count.Peak;
+            return Count.Live;
+        }
+        return 0;
+    }
+
+    /** Every frame in exactly one segment, segments back to front, each within budget and seeking no later than it starts. */
+    bool CheckPlan(const std::vector<FReverseSegment>& Segments, const std::vector<int64_t>& Timestamps, size_t MaxSegmentFrames)
+    {
+        size_t Expected = Timestamps.size();
+        for (const auto& Segment : Segments)
+        {
+            if (!Check(Segment.EndFrame == Expected, "segments are not contiguous back to front")) return false;
+            if (!Check(Segment.FirstFrame < Segment.EndFrame, "empty segment")) return false;
+            if (!Check(Segment.EndFrame - Segment.FirstFrame <= MaxSegmentFrames, "segment over budget")) return false;
+            if (!Check(Segment.SeekTimestamp100ns <= Timestamps[Segment.FirstFrame], "segment seeks past its first frame")) return false;
+            if (!Check(Segment.DecodeCost >= Segment.EndFrame - Segment.FirstFrame, "decode cost below segment size")) return false;
+            Expected = Segment.FirstFrame;
+        }
+        return Check(Expected == 0, "segments do not reach the first frame");
+    }
+
+    /**
+     * Most decodes the plan asks of one shown frame: each segment is spread over the
+     * frames of the one playing before it. The tail has one frame fewer (the turn shows
+     * it going forwards); a segment with none left is decoded whole on the next frame.
+     */
+    size_t GetPlannedDecodesPerFrame(const std::vector<FReverseSegment>& Segments)
+    {
+        size_t Most = 2; // Forward: the skipped first frame and the one shown
+        size_t Carried = 0;
+        for (size_t Index = 0; Index + 1 < Segments.size(); ++Index)
+        {
+            size_t Shown = Segments[Index].EndFrame - Segments[Index].FirstFrame - (Index == 0 ? 1 : 0);
+            if (!Shown)
+            {
+                Carried += Segments[Index + 1].DecodeCost;
+                continue;
+            }
+            size_t Decodes = Carried + GetPrefetchBudget(Segments[Index + 1].DecodeCost, Shown);
+            Carried = 0;
+            Most = Decodes > Most ? Decodes : Most;
+        }
+        return Most + Carried;
+    }
+
+    bool RunCase(const FBenchOptions& Options, const FBenchCase& Case)
+    {
+        GResources.Reset();
+        auto Video = std::make_unique<FSyntheticGopVideo>(Options.Width, Options.Height, Case.Frames, Case.Gop);
+        FSyntheticGopVideo* Synthetic = Video.get();
+        int64_t FrameDuration = Synthetic->GetInfo().FrameDuration100ns();
+
+        FFrame Probe;
+        Probe.Allocate(Options.Width, Options.Height, EPixelFormat::NV12);
+        size_t FrameBytes = Probe.GetSizeBytes();
+
+        auto Keyframes = std::make_shared<FKeyframeTimestamps>();
+        if (Case.bKeyframes) Keyframes->Set(Synthetic->GetKeyframeTimestamps());
+        FPingPongSettings Settings;
+        Settings.MaxCacheBytes = static_cast<int64_t>(FrameBytes) * 2 * Case.CacheFrames;
+        Settings.Keyframes = Keyframes;
+
+        std::vector<int64_t> Timestamps;
+        for (int32_t Index = 0; Index < Case.Frames; ++Index) Timestamps.push_back(Synthetic->GetTimestamp(Index));
+        std::vector<FReverseSegment> Segments = PlanReverseSegments
+        (
+            Timestamps, Case.bKeyframes ? Synthetic->GetKeyframeTimestamps() : std::vector<int64_t>{}, static_cast<size_t>(Case.CacheFrames)
+        );
+        bool bPass = CheckPlan(Segments, Timestamps, static_cast<size_t>(Case.CacheFrames));
+
+        // Frames of one cycle after the first: 1..N-1 forwards, N-2..0 backwards.
+        std::vector<int32_t> Expected;
+        for (int32_t Index = 0; Index < Case.Frames; ++Index) Expected.push_back(Index);
+        for (int32_t Index = Case.Frames - 2; Index >= 0; --Index) Expected.push_back(Index);
+        size_t CycleFrames = Expected.size() - 1;
+        for (int32_t Cycle = 1; Cycle < Options.Cycles; ++Cycle)
+        {
+            Expected.insert(Expected.end(), Expected.end() - static_cast<std::ptrdiff_t>(CycleFrames), Expected.end());
+        }
+        if (Case.Frames == 1) Expected.assign(static_cast<size_t>(Options.Cycles) * 2, 0);
+
+        size_t MaxDecodes = 0;
+        double Ms = 0.0;
+        {
+            FPingPongSource Source(std::move(Video), Settings);
+            FFrame Frame;
+            int64_t PreviousTimestamp = 0;
+            bool bOrdered = true;
+            bool bPaced = true;
+            int32_t Failures = 0;
+            auto Start = std::chrono::steady_clock::now();
+            for (size_t Index = 0; Index < Expected.size() && bOrdered; ++Index)
+            {
+                // The first cycle learns the timestamps and decodes its first segment at the turn.
+                if (Index == static_cast<size_t>(2 * Case.Frames - 1)) Source.ResetMaxDecodesPerFrame();
+                if (!Source.ReadFrame(Frame))
+                {
+                    // As the pipeline does: loop from the start, give up after repeated failures.
+                    if (!Check(++Failures <= 2, "source failed repeatedly")) return false;
+                    Source.Seek(0);
+                    --Index;
+                    continue;
+                }
+                Failures = 0;
+                bOrdered = GetStamp(Frame) == static_cast<uint32_t>(Expected[Index]);
+                if (Index && Case.Frames > 1) bPaced &= Frame.Timestamp100ns - PreviousTimestamp == FrameDuration;
+                PreviousTimestamp = Frame.Timestamp100ns;
+            }
+            Ms = ElapsedMs(Start);
+            bPass &= Check(bOrdered, "frames out of ping-pong order");
+            bPass &= Check(bPaced, "timestamps do not advance one frame per frame");
+            MaxDecodes = Source.GetMaxDecodesPerFrame();
+            if (Case.Frames > 1)
+            {
+                bPass &= Check(Source.GetTurns() == static_cast<uint64_t>(Options.Cycles), "wrong number of turns");
+                bPass &= Check(Source.GetSegmentCount() == Segments.size(), "source planned differently");
+            }
+            if (Case.bKeyframes && Case.Frames > 1)
+            {
+                bPass &= Check(MaxDecodes <= GetPlannedDecodesPerFrame(Segments), "prefetch burst above plan");
+            }
+
+            int64_t PeakBytes = 0;
+            GetLive("PingPong.Cache", EResourceKind::HeapBytes, &PeakBytes);
+            bPass &= Check(PeakBytes <= Settings.MaxCacheBytes + static_cast<int64_t>(FrameBytes), "cache over budget");
+            std::printf
+            (
+                "%6d %5d %7d %5s %9zu %9zu %11.1f %10.3f %10llu  %s\n",
+                Case.Frames, Case.Gop, Case.CacheFrames, Case.bKeyframes ? "yes" : "no",
+                Segments.size(), MaxDecodes, static_cast<double>(PeakBytes) / (1024.0 * 1024.0),
+                Ms / static_cast<double>(Expected.size()),
+                static_cast<unsigned long long>(Synthetic->Decodes), bPass ? "ok" : "FAIL"
+            );
+        }
+        bPass &= Check(GetLive("PingPong.Cache", EResourceKind::HeapBytes) == 0, "cache not freed with the source");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: pingpong_bench [--size WxH] [--cycles N]\n");
+        return 2;
+    }
+    GResources.SetEnabled(true);
+
+    const FBenchCase Cases[] =
+    {
+        { 1, 1, 8, true }, { 2, 1, 8, true }, { 3, 2, 1, true },
+        { 90, 1, 16, true }, { 90, 12, 12, true }, { 91, 12, 12, true }, { 90, 12, 5, true },
+        { 300, 60, 60, true }, { 300, 60, 16, true }, { 301, 250, 32, true }, { 301, 250, 250, true },
+        { 90, 12, 12, false }, { 301, 250, 32, false }
+    };
+    std::printf("%6s %5s %7s %5s %9s %9s %11s %10s %10s\n", "frames", "gop", "segment", "keys", "segments", "max dec", "peak MB", "ms/frame", "decodes");
+    bool bPass = true;
+    for (const auto& Case : Cases) bPass &= RunCase(Options, Case);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
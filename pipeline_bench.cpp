@@ -0,0 +1,314 @@
+// pipeline_bench - Startup barrier and parallel teardown checks with fake players.
+// Fake per-monitor players open on their own threads after an injected latency,
+// some failing and some never answering in time, and report back through a UI
+// message queue the way MFPlay callbacks reach the window thread. The barrier must
+// release exactly once, on the last slot to settle, ignore duplicate, late and
+// out-of-range reports, and re-arm cleanly for a display change while callbacks of
+// the previous generation are still in flight. Startup must take about the slowest
+// player's latency, not the sum. Teardown runs every player's blocking shutdown on
+// an FTaskGroup while the UI thread polls and services calls the players make back
+// into it, which must neither deadlock nor serialize the shutdowns.
+//   g++ -std=c++20 -O2 -pthread pipeline_bench.cpp -o pipeline_bench
+//   pipeline_bench [--monitors N] [--latency-ms N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "task_group.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    using FClock = std::chrono::steady_clock;
+
+    struct FBenchOptions
+    {
+        int32_t Monitors = 6;
+        int32_t LatencyMs = 40;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--monitors") Options.Monitors = std::atoi(Value);
+            else if (Name == "--latency-ms") Options.LatencyMs = std::atoi(Value);
+            else return false;
+        }
+        return Options.Monitors > 1 && Options.LatencyMs > 0;
+    }
+
+    double MsSince(FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    }
+
+    /** The window thread's message queue: other threads post, the UI thread pumps. */
+    class FUiQueue
+    {
+    public:
+        void Post(std::function<void()> Message)
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Messages.push_back(std::move(Message));
+            Posted.notify_one();
+        }
+
+        /** SendMessage from another thread: blocks until the UI thread has run it. */
+        void Send(std::function<void()> Message)
+        {
+            std::promise<void> Handled;
+            std::future<void> Done = Handled.get_future();
+            Post([&Message, &Handled] { Message(); Handled.set_value(); });
+            Done.wait();
+        }
+
+        /** Runs the messages that arrive within Timeout; true if any ran. */
+        bool Pump(std::chrono::milliseconds Timeout)
+        {
+            std::deque<std::function<void()>> Batch;
+            {
+                std::unique_lock<std::mutex> Lock(Mutex);
+                Posted.wait_for(Lock, Timeout, [this] { return !Messages.empty(); });
+                Batch.swap(Messages);
+            }
+            for (auto& Message : Batch) Message();
+            return !Batch.empty();
+        }
+
+    private:
+        std::mutex Mutex;
+        std::condition_variable Posted;
+        std::deque<std::function<void()>> Messages;
+    };
+
+    enum class EFakeOutcome
+    {
+        Ready,
+        Failed,
+        Silent      // Never calls back; the startup timeout fails it
+    };
+
+    struct FFakePlayer
+    {
+        int32_t LatencyMs = 0;
+        EFakeOutcome Outcome = EFakeOutcome::Ready;
+    };
+
+    /** Starts every player; each reports to the UI queue with the generation it was opened for. */
+    std::vector<std::thread> OpenPlayers(FUiQueue& Queue, const std::vector<FFakePlayer>& Players, int32_t Generation,
+        std::function<void(int32_t, size_t, bool)> OnSettled)
+    {
+        std::vector<std::thread> Threads;
+        for (size_t Slot = 0; Slot < Players.size(); ++Slot)
+        {
+            FFakePlayer Player = Players[Slot];
+            Threads.emplace_back([&Queue, Player, Slot, Generation, OnSettled]
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(Player.LatencyMs));
+                if (Player.Outcome == EFakeOutcome::Silent) return;
+                bool bReady = Player.Outcome == EFakeOutcome::Ready;
+                Queue.Post([OnSettled, Generation, Slot, bReady] { OnSettled(Generation, Slot, bReady); });
+            });
+        }
+        return Threads;
+    }
+
+    bool CheckBarrierEdges()
+    {
+        FPipelineBarrier Barrier;
+        bool bPass = true;
+        Barrier.Reset(3);
+        bPass &= Check(!Barrier.MarkReady(0) && !Barrier.MarkReady(0), "duplicate report does not settle twice");
+        bPass &= Check(!Barrier.MarkFailed(0), "ready slot cannot fail afterwards");
+        bPass &= Check(!Barrier.MarkReady(7) && Barrier.GetState(7) == EPipelineSlotState::Failed, "out-of-range slot ignored");
+        bPass &= Check(!Barrier.MarkFailed(1) && !Barrier.IsReleased(), "not released while one is pending");
+        bPass &= Check(Barrier.MarkReady(2) && Barrier.IsReleased(), "last slot releases");
+        bPass &= Check(!Barrier.MarkReady(2) && !Barrier.MarkFailed(1), "settled barrier stays quiet");
+        bPass &= Check(Barrier.CountIn(EPipelineSlotState::Ready) == 2 && Barrier.CountIn(EPipelineSlotState::Failed) == 1, "slot counts");
+        Barrier.Reset(1);
+        bPass &= Check(!Barrier.IsReleased() && Barrier.GetState(0) == EPipelineSlotState::Pending, "reset re-arms");
+        bPass &= Check(Barrier.MarkFailed(0) && Barrier.CountIn(EPipelineSlotState::Failed) == 1, "all failed still releases");
+        return bPass;
+    }
+
+    /**
+     * One startup on the UI thread. A display change re-arms the barrier halfway,
+     * so the first generation's callbacks land on the second and must be dropped.
+     */
+    bool CheckStartup(const FBenchOptions& Options)
+    {
+        FUiQueue Queue;
+        FPipelineBarrier Barrier;
+        int32_t Generation = 0;
+        int32_t Releases = 0;
+        int32_t StaleReports = 0;
+        FClock::time_point ReleasedAt;
+        auto OnSettled = [&](int32_t ReportGeneration, size_t Slot, bool bReady)
+        {
+            if (ReportGeneration != Generation)
+            {
+                ++StaleReports;
+                return;
+            }
+            bool bRelease = bReady ? Barrier.MarkReady(Slot) : Barrier.MarkFailed(Slot);
+            if (!bRelease) return;
+            ++Releases;
+            ReleasedAt = FClock::now();
+        };
+
+        // First generation: slow players, abandoned by a display change before they answer.
+        std::vector<FFakePlayer> Slow(static_cast<size_t>(Options.Monitors), { Options.LatencyMs * 2, EFakeOutcome::Ready });
+        Barrier.Reset(Slow.size());
+        std::vector<std::thread> Abandoned = OpenPlayers(Queue, Slow, Generation, OnSettled);
+
+        ++Generation;
+        std::vector<FFakePlayer> Players;
+        for (int32_t Index = 0; Index < Options.Monitors; ++Index)
+        {
+            int32_t Latency = Options.LatencyMs * (Index + 1) / Options.Monitors;
+            Players.push_back({ Latency, Index == 1 ? EFakeOutcome::Failed : Index == 2 ? EFakeOutcome::Silent : EFakeOutcome::Ready });
+        }
+        auto Start = FClock::now();
+        Barrier.Reset(Players.size());
+        std::vector<std::thread> Opening = OpenPlayers(Queue, Players, Generation, OnSettled);
+
+        // The startup timeout fails whatever has not answered; here at 3x the slowest latency.
+        auto Deadline = Start + std::chrono::milliseconds(Options.LatencyMs * 3);
+        bool bTimedOut = false;
+        while (FClock::now() < Deadline + std::chrono::milliseconds(Options.LatencyMs))
+        {
+            Queue.Pump(std::chrono::milliseconds(5));
+            if (bTimedOut || FClock::now() < Deadline) continue;
+            bTimedOut = true;
+            for (size_t Slot = 0; Slot < Barrier.Size(); ++Slot)
+            {
+                if (Barrier.GetState(Slot) == EPipelineSlotState::Pending && Barrier.MarkFailed(Slot))
+                {
+                    ++Releases;
+                    ReleasedAt = FClock::now();
+                }
+            }
+        }
+        for (auto& Thread : Abandoned) Thread.join();
+        for (auto& Thread : Opening) Thread.join();
+        Queue.Pump(std::chrono::milliseconds(0));
+
+        double ReleaseMs = std::chrono::duration<double, std::milli>(ReleasedAt - Start).count();
+        std::printf("startup: %d monitors released after %.1f ms (timeout %d ms), %d stale report(s)\n",
+            Options.Monitors, ReleaseMs, Options.LatencyMs * 3, StaleReports);
+        bool bPass = Check(Releases == 1, "released exactly once");
+        bPass &= Check(StaleReports == Options.Monitors, "previous generation's reports dropped");
+        bPass &= Check(Barrier.GetState(1) == EPipelineSlotState::Failed && Barrier.GetState(2) == EPipelineSlotState::Failed, "failed and silent players fail");
+        bPass &= Check(Barrier.CountIn(EPipelineSlotState::Ready) == static_cast<size_t>(Options.Monitors - 2), "the rest are ready");
+        bPass &= Check(ReleaseMs >= Options.LatencyMs * 3 - 1 && ReleaseMs < Options.LatencyMs * 4, "silent player holds the release until the timeout");
+        return bPass;
+    }
+
+    /** Without a silent player the barrier releases on the slowest answer, not the sum of them. */
+    bool CheckParallelOpen(const FBenchOptions& Options)
+    {
+        FUiQueue Queue;
+        FPipelineBarrier Barrier;
+        bool bReleased = false;
+        FClock::time_point ReleasedAt;
+        std::vector<FFakePlayer> Players(static_cast<size_t>(Options.Monitors), { Options.LatencyMs, EFakeOutcome::Ready });
+        auto Start = FClock::now();
+        Barrier.Reset(Players.size());
+        std::vector<std::thread> Opening = OpenPlayers(Queue, Players, 0, [&](int32_t, size_t Slot, bool)
+        {
+            if (!Barrier.MarkReady(Slot)) return;
+            bReleased = true;
+            ReleasedAt = FClock::now();
+        });
+        while (!bReleased && MsSince(Start) < Options.LatencyMs * Options.Monitors * 2.0) Queue.Pump(std::chrono::milliseconds(5));
+        for (auto& Thread : Opening) Thread.join();
+
+        double ReleaseMs = std::chrono::duration<double, std::milli>(ReleasedAt - Start).count();
+        double SerialMs = static_cast<double>(Options.LatencyMs) * Options.Monitors;
+        std::printf("parallel open: %.1f ms for %d players of %d ms (serial %.0f ms)\n", ReleaseMs, Options.Monitors, Options.LatencyMs, SerialMs);
+        bool bPass = Check(bReleased, "every player ready");
+        bPass &= Check(ReleaseMs < SerialMs * 0.6, "players open concurrently");
+        return bPass;
+    }
+
+    /** ShutdownPlayers: blocking shutdowns on a task group, the UI thread pumping sent messages meanwhile. */
+    bool CheckTeardown(const FBenchOptions& Options)
+    {
+        FUiQueue Queue;
+        std::atomic<int32_t> Shutdowns{ 0 };
+        std::atomic<int32_t> Callbacks{ 0 };
+        std::thread::id UiThread = std::this_thread::get_id();
+        bool bCallbacksOnUi = true;
+
+        auto Start = FClock::now();
+        FTaskGroup Teardown;
+        for (int32_t Index = 0; Index < Options.Monitors; ++Index)
+        {
+            int32_t Latency = Options.LatencyMs * (Index % 3 + 1) / 3;
+            Teardown.Run([&, Latency]
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(Latency / 2));
+                // The player calls back into the thread that created it while draining.
+                Queue.Send([&] { bCallbacksOnUi &= std::this_thread::get_id() == UiThread; ++Callbacks; });
+                std::this_thread::sleep_for(std::chrono::milliseconds(Latency - Latency / 2));
+                ++Shutdowns;
+            });
+        }
+        bool bFinished = false;
+        while (!(bFinished = Teardown.WaitFor(std::chrono::milliseconds(0))) && MsSince(Start) < Options.LatencyMs * 20.0)
+        {
+            Queue.Pump(std::chrono::milliseconds(2));
+        }
+        double TeardownMs = MsSince(Start);
+        Teardown.Join();
+
+        std::printf("teardown: %d players in %.1f ms (slowest %d ms)\n", Options.Monitors, TeardownMs, Options.LatencyMs);
+        bool bPass = Check(bFinished, "teardown finishes while the UI thread services callbacks");
+        bPass &= Check(Shutdowns == Options.Monitors && Callbacks == Options.Monitors, "every player shut down");
+        bPass &= Check(bCallbacksOnUi, "callbacks run on the UI thread");
+        bPass &= Check(TeardownMs < Options.LatencyMs * 2.0, "shutdowns run concurrently");
+
+        FTaskGroup Empty;
+        bPass &= Check(Empty.WaitFor(std::chrono::milliseconds(0)), "empty group is finished");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: pipeline_bench [--monitors N] [--latency-ms N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckBarrierEdges(), "barrier edges");
+    bPass &= Check(CheckStartup(Options), "startup");
+    bPass &= Check(CheckParallelOpen(Options), "parallel open");
+    bPass &= Check(CheckTeardown(Options), "teardown");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
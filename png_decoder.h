@@ -0,0 +1,473 @@
+// PngDecoder - PNG and APNG decoding into full-canvas frames.
+// Every color type and bit depth, tRNS transparency and Adam7 interlacing are
+// supported; 16-bit samples keep their high byte. For APNG the skim at open
+// collects each frame's fcTL control and the spans of its IDAT/fdAT chunks, so
+// decoding a frame inflates only that frame's data before compositing it with
+// the frame's blend and dispose operations. A plain PNG is a one-frame animation.
+// A frame whose data inflates past its own rows fails to decode, so a few
+// kilobytes of file cannot expand into an unbounded allocation.
+// CRCs are not checked; gamma, color profiles and text chunks are ignored.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "animated_image.h"
+#include "inflate.h"
+
+inline bool IsPngData(const uint8_t* Data, size_t Size)
+{
+    static constexpr uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    return Size >= 8 && std::memcmp(Data, Signature, 8) == 0;
+}
+
+/** A still PNG never changes; a long delay keeps the pipeline from re-presenting it. */
+constexpr int32_t StillImageDelayMs = 1000;
+
+class FPngDecoder final : public IAnimationDecoder
+{
+public:
+    /** Takes the whole file and skims its chunks; false if it is not a decodable PNG. */
+    bool Open(std::vector<uint8_t> InData)
+    {
+        Data = std::move(InData);
+        Frames.clear();
+        Info = {};
+        Info.FormatName = "png";
+        if (!IsPngData(Data.data(), Data.size())) return false;
+
+        FPngFrame DefaultImage;
+        bool bHeader = false;
+        bool bAnimated = false;
+        size_t Offset = 8;
+        while (Offset + 12 <= Data.size())
+        {
+            uint32_t Length = Read32(Offset);
+            const uint8_t* Type = &Data[Offset + 4];
+            size_t Body = Offset + 8;
+            if (Length > Data.size() - Body - 4) break;
+            Offset = Body + Length + 4;
+
+            if (std::memcmp(Type, "IHDR", 4) == 0 && Length >= 13)
+            {
+                Info.Width = static_cast<int32_t>(Read32(Body));
+                Info.Height = static_cast<int32_t>(Read32(Body + 4));
+                BitDepth = Data[Body + 8];
+                ColorType = Data[Body + 9];
+                bInterlaced = Data[Body + 12] == 1;
+                bHeader = true;
+            }
+            else if (std::memcmp(Type, "PLTE", 4) == 0)
+            {
+                for (uint32_t Index = 0; Index < Length / 3 && Index < 256; ++Index)
+                {
+                    const uint8_t* Rgb = &Data[Body + Index * 3];
+                    Palette[Index] = 0xFF000000u | (Rgb[0] << 16) | (Rgb[1] << 8) | Rgb[2];
+                }
+            }
+            else if (std::memcmp(Type, "tRNS", 4) == 0)
+            {
+                if (ColorType == 3)
+                {
+                    for (uint32_t Index = 0; Index < Length && Index < 256; ++Index)
+                    {
+                        Palette[Index] = (Palette[Index] & 0x00FFFFFFu) | (static_cast<uint32_t>(Data[Body + Index]) << 24);
+                    }
+                }
+                else if (ColorType == 0 && Length >= 2)
+                {
+                    TransparentKey[0] = static_cast<int32_t>(Read16(Body));
+                    bTransparentKey = true;
+                }
+                else if (ColorType == 2 && Length >= 6)
+                {
+                    for (int32_t Channel = 0; Channel < 3; ++Channel)
+                    {
+                        TransparentKey[Channel] = static_cast<int32_t>(Read16(Body + Channel * 2));
+                    }
+                    bTransparentKey = true;
+                }
+            }
+            else if (std::memcmp(Type, "acTL", 4) == 0 && Length >= 8)
+            {
+                bAnimated = true;
+                Info.LoopCount = static_cast<int32_t>(Read32(Body + 4));
+            }
+            else if (std::memcmp(Type, "fcTL", 4) == 0 && Length >= 26)
+            {
+                // Each field is range-checked before the sums; an out-of-range frame keeps an empty
+                // rectangle so its fdAT chunks still land on it, and is dropped below.
+                FPngFrame Frame;
+                uint32_t Width = Read32(Body + 4);
+                uint32_t Height = Read32(Body + 8);
+                uint32_t Left = Read32(Body + 12);
+                uint32_t Top = Read32(Body + 16);
+                if (Width <= MaxAnimationDimension && Height <= MaxAnimationDimension
+                    && Left <= MaxAnimationDimension && Top <= MaxAnimationDimension)
+                {
+                    Frame.Rect.Left = static_cast<int32_t>(Left);
+                    Frame.Rect.Top = static_cast<int32_t>(Top);
+                    Frame.Rect.Right = static_cast<int32_t>(Left + Width);
+                    Frame.Rect.Bottom = static_cast<int32_t>(Top + Height);
+                }
+                uint32_t DelayNumerator = Read16(Body + 20);
+                uint32_t DelayDenominator = Read16(Body + 22);
+                Frame.DelayMs = ClampAnimationDelayMs(
+                    static_cast<int32_t>(DelayNumerator * 1000 / (DelayDenominator ? DelayDenominator : 100)));
+                Frame.Dispose = Data[Body + 24];
+                Frame.Blend = Data[Body + 25];
+                Frames.push_back(std::move(Frame));
+            }
+            else if (std::memcmp(Type, "IDAT", 4) == 0)
+            {
+                // IDAT belongs to the first animation frame only when its fcTL came first.
+                FPngFrame& Target = (bAnimated && Frames.size() == 1) ? Frames[0] : DefaultImage;
+                Target.Spans.push_back({ Body, Length });
+            }
+            else if (std::memcmp(Type, "fdAT", 4) == 0 && Length > 4 && !Frames.empty())
+            {
+                Frames.back().Spans.push_back({ Body + 4, Length - 4 });
+            }
+            else if (std::memcmp(Type, "IEND", 4) == 0)
+            {
+                break;
+            }
+        }
+        if (!bHeader || !IsAnimationCanvasAllowed(Info.Width, Info.Height) || !IsSupportedFormat()) return false;
+
+        // Frames whose data never arrived (truncated file) or that fall outside the canvas are dropped.
+        FIntRect Bounds{ 0, 0, Info.Width, Info.Height };
+        std::erase_if(Frames, [&](const FPngFrame& Frame)
+        {
+            return Frame.Spans.empty() || Frame.Rect.IsEmpty() || !(IntersectRect(Frame.Rect, Bounds) == Frame.Rect);
+        });
+        if (!bAnimated || Frames.empty())
+        {
+            if (DefaultImage.Spans.empty()) return false;
+            Frames.clear();
+            DefaultImage.Rect = Bounds;
+            DefaultImage.DelayMs = StillImageDelayMs;
+            Frames.push_back(std::move(DefaultImage));
+            Info.FormatName = "png";
+        }
+        else
+        {
+            Info.FormatName = "apng";
+        }
+
+        Info.FrameCount = static_cast<int32_t>(Frames.size());
+        for (const auto& Frame : Frames)
+        {
+            Info.DelaysMs.push_back(Frame.DelayMs);
+            Info.Duration100ns += static_cast<int64_t>(Frame.DelayMs) * 10000;
+        }
+        Rewind();
+        return true;
+    }
+
+    const FAnimationInfo& GetInfo() const override { return Info; }
+
+    bool DecodeNext(FFrame& Out) override
+    {
+        if (NextFrame >= static_cast<int32_t>(Frames.size())) return false;
+        const FPngFrame& Frame = Frames[NextFrame];
+
+        if (PreviousDispose == 1) Canvas.ClearRect(PreviousRect);
+        else if (PreviousDispose == 2) Canvas.Restore();
+
+        int32_t FrameWidth = Frame.Rect.Width();
+        int32_t FrameHeight = Frame.Rect.Height();
+        size_t RawSize = GetRawSize(FrameWidth, FrameHeight);
+        Compressed.clear();
+        for (const auto& Span : Frame.Spans) Compressed.insert(Compressed.end(), &Data[Span.Offset], &Data[Span.Offset] + Span.Length);
+        Raw.clear();
+        Raw.reserve(RawSize);
+        // The filtered rows (height x (1 + stride) per pass) are all a frame can hold; a stream
+        // inflating past them is corrupt or hostile and is rejected before it costs memory.
+        if (InflateZlib(Compressed.data(), Compressed.size(), Raw, RawSize) == EInflateResult::TooLarge) return false;
+
+        Pixels.assign(static_cast<size_t>(FrameWidth) * FrameHeight, 0);
+        // Short data (truncated or corrupt) leaves the remaining pixels transparent.
+        Raw.resize(RawSize, 0);
+        DecodeImage(FrameWidth, FrameHeight);
+
+        // dispose_op PREVIOUS on the first frame is specified to act as BACKGROUND.
+        uint8_t Dispose = Frame.Dispose;
+        if (Dispose == 2 && NextFrame == 0) Dispose = 1;
+        if (Dispose == 2) Canvas.Save();
+
+        for (int32_t Y = 0; Y < FrameHeight; ++Y)
+        {
+            const uint32_t* Source = &Pixels[static_cast<size_t>(Y) * FrameWidth];
+            uint32_t* Dest = Canvas.Row(Frame.Rect.Top + Y) + Frame.Rect.Left;
+            if (Frame.Blend == 0)
+            {
+                std::memcpy(Dest, Source, static_cast<size_t>(FrameWidth) * 4);
+                continue;
+            }
+            for (int32_t X = 0; X < FrameWidth; ++X) Dest[X] = BlendOver(Source[X], Dest[X]);
+        }
+
+        PreviousDispose = Dispose;
+        PreviousRect = Frame.Rect;
+        ++NextFrame;
+        Canvas.Flatten(Out);
+        return true;
+    }
+
+    void Rewind() override
+    {
+        Canvas.Reset(Info.Width, Info.Height);
+        NextFrame = 0;
+        PreviousDispose = 0;
+        PreviousRect = {};
+    }
+
+    int32_t GetNextFrameIndex() const override { return NextFrame; }
+
+private:
+    struct FChunkSpan
+    {
+        size_t Offset = 0;
+        size_t Length = 0;
+    };
+
+    struct FPngFrame
+    {
+        FIntRect Rect;
+        int32_t DelayMs = 0;
+        uint8_t Dispose = 0;           // 0 none, 1 clear to transparent, 2 restore previous
+        uint8_t Blend = 0;             // 0 source, 1 over
+        std::vector<FChunkSpan> Spans;
+    };
+
+    uint32_t Read32(size_t Offset) const
+    {
+        return (static_cast<uint32_t>(Data[Offset]) << 24) | (Data[Offset + 1] << 16) | (Data[Offset + 2] << 8) | Data[Offset + 3];
+    }
+
+    uint32_t Read16(size_t Offset) const { return (Data[Offset] << 8) | Data[Offset + 1]; }
+
+    bool IsSupportedFormat() const
+    {
+        switch (ColorType)
+        {
+        case 0: return BitDepth == 1 || BitDepth == 2 || BitDepth == 4 || BitDepth == 8 || BitDepth == 16;
+        case 3: return BitDepth == 1 || BitDepth == 2 || BitDepth == 4 || BitDepth == 8;
+        case 2: case 4: case 6: return BitDepth == 8 || BitDepth == 16;
+        default: return false;
+        }
+    }
+
+    int32_t GetChannels() const
+    {
+        switch (ColorType)
+        {
+        case 2: return 3;
+        case 4: return 2;
+        case 6: return 4;
+        default: return 1;
+        }
+    }
+
+    size_t GetRowBytes(int32_t Width) const
+    {
+        return (static_cast<size_t>(Width) * GetChannels() * BitDepth + 7) / 8;
+    }
+
+    /** Adam7 pass origins and steps: X, Y, StepX, StepY. */
+    static constexpr int32_t Adam7[7][4] =
+    {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+    };
+
+    static int32_t PassExtent(int32_t Size, int32_t Origin, int32_t Step)
+    {
+        return Size > Origin ? (Size - Origin + Step - 1) / Step : 0;
+    }
+
+    size_t GetRawSize(int32_t Width, int32_t Height) const
+    {
+        if (!bInterlaced) return (GetRowBytes(Width) + 1) * static_cast<size_t>(Height);
+        size_t Total = 0;
+        for (const auto& Pass : Adam7)
+        {
+            int32_t PassWidth = PassExtent(Width, Pass[0], Pass[2]);
+            int32_t PassHeight = PassExtent(Height, Pass[1], Pass[3]);
+            if (PassWidth && PassHeight) Total += (GetRowBytes(PassWidth) + 1) * static_cast<size_t>(PassHeight);
+        }
+        return Total;
+    }
+
+    /** Unfilters Raw in place and converts it into Pixels (Width x Height), pass by pass when interlaced. */
+    void DecodeImage(int32_t Width, int32_t Height)
+    {
+        size_t Offset = 0;
+        if (!bInterlaced)
+        {
+            DecodePass(Offset, Width, Height, 0, 0, 1, 1, Width);
+            return;
+        }
+        for (const auto& Pass : Adam7)
+        {
+            int32_t PassWidth = PassExtent(Width, Pass[0], Pass[2]);
+            int32_t PassHeight = PassExtent(Height, Pass[1], Pass[3]);
+            if (!PassWidth || !PassHeight) continue;
+            Offset = DecodePass(Offset, PassWidth, PassHeight, Pass[0], Pass[1], Pass[2], Pass[3], Width);
+        }
+    }
+
+    size_t DecodePass(size_t Offset, int32_t Width, int32_t Height, int32_t OriginX, int32_t OriginY,
+        int32_t StepX, int32_t StepY, int32_t ImageWidth)
+    {
+        size_t RowBytes = GetRowBytes(Width);
+        size_t FilterBytes = static_cast<size_t>((GetChannels() * BitDepth + 7) / 8);
+        // The row above the first is all zeros.
+        ZeroRow.assign(RowBytes, 0);
+        const uint8_t* Previous = ZeroRow.data();
+        for (int32_t Y = 0; Y < Height; ++Y)
+        {
+            uint8_t Filter = Raw[Offset];
+            uint8_t* Row = &Raw[Offset + 1];
+            Unfilter(Filter, Row, Previous, RowBytes, FilterBytes);
+            ConvertRow(Row, Width, &Pixels[static_cast<size_t>(OriginY + Y * StepY) * ImageWidth + OriginX], StepX);
+            Previous = Row;
+            Offset += RowBytes + 1;
+        }
+        return Offset;
+    }
+
+    /** Previous is the unfiltered row above (zeros for the first); the leftmost pixel has no left neighbor. */
+    static void Unfilter(uint8_t Filter, uint8_t* Row, const uint8_t* Previous, size_t RowBytes, size_t FilterBytes)
+    {
+        size_t Lead = FilterBytes < RowBytes ? FilterBytes : RowBytes;
+        switch (Filter)
+        {
+        case 1:
+            for (size_t Index = FilterBytes; Index < RowBytes; ++Index) Row[Index] = static_cast<uint8_t>(Row[Index] + Row[Index - FilterBytes]);
+            break;
+        case 2:
+            for (size_t Index = 0; Index < RowBytes; ++Index) Row[Index] = static_cast<uint8_t>(Row[Index] + Previous[Index]);
+            break;
+        case 3:
+            for (size_t Index = 0; Index < Lead; ++Index) Row[Index] = static_cast<uint8_t>(Row[Index] + (Previous[Index] >> 1));
+            for (size_t Index = Lead; Index < RowBytes; ++Index)
+            {
+                Row[Index] = static_cast<uint8_t>(Row[Index] + ((Row[Index - FilterBytes] + Previous[Index]) >> 1));
+            }
+            break;
+        case 4:
+            // Paeth with no left or upper-left neighbor predicts from above.
+            for (size_t Index = 0; Index < Lead; ++Index) Row[Index] = static_cast<uint8_t>(Row[Index] + Previous[Index]);
+            for (size_t Index = Lead; Index < RowBytes; ++Index)
+            {
+                int32_t A = Row[Index - FilterBytes];
+                int32_t B = Previous[Index];
+                int32_t C = Previous[Index - FilterBytes];
+                int32_t P = A + B - C;
+                int32_t Pa = P > A ? P - A : A - P;
+                int32_t Pb = P > B ? P - B : B - P;
+                int32_t Pc = P > C ? P - C : C - P;
+                int32_t Predictor = (Pa <= Pb && Pa <= Pc) ? A : (Pb <= Pc ? B : C);
+                Row[Index] = static_cast<uint8_t>(Row[Index] + Predictor);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    /** One unfiltered row to straight-alpha 0xAARRGGBB, writing every StepX-th output pixel. */
+    void ConvertRow(const uint8_t* Row, int32_t Width, uint32_t* Out, int32_t StepX) const
+    {
+        if (BitDepth == 8 && ColorType == 6)
+        {
+            for (int32_t X = 0; X < Width; ++X, Row += 4)
+            {
+                Out[static_cast<size_t>(X) * StepX] = (static_cast<uint32_t>(Row[3]) << 24) | (Row[0] << 16) | (Row[1] << 8) | Row[2];
+            }
+            return;
+        }
+        if (BitDepth == 8 && ColorType == 2 && !bTransparentKey)
+        {
+            for (int32_t X = 0; X < Width; ++X, Row += 3)
+            {
+                Out[static_cast<size_t>(X) * StepX] = 0xFF000000u | (Row[0] << 16) | (Row[1] << 8) | Row[2];
+            }
+            return;
+        }
+
+        auto Sample = [&](int32_t Index) -> int32_t
+        {
+            if (BitDepth == 16) return (Row[Index * 2] << 8) | Row[Index * 2 + 1];
+            if (BitDepth == 8) return Row[Index];
+            int32_t Bit = Index * BitDepth;
+            return (Row[Bit >> 3] >> (8 - BitDepth - (Bit & 7))) & ((1 << BitDepth) - 1);
+        };
+        auto To8 = [&](int32_t Value) -> uint32_t
+        {
+            if (BitDepth == 16) return static_cast<uint32_t>(Value >> 8);
+            return static_cast<uint32_t>(Value * 255 / ((1 << BitDepth) - 1));
+        };
+
+        for (int32_t X = 0; X < Width; ++X)
+        {
+            uint32_t Pixel = 0;
+            switch (ColorType)
+            {
+            case 0:
+            {
+                int32_t Gray = Sample(X);
+                uint32_t Alpha = bTransparentKey && Gray == TransparentKey[0] ? 0 : 255;
+                uint32_t Value = To8(Gray);
+                Pixel = (Alpha << 24) | (Value << 16) | (Value << 8) | Value;
+                break;
+            }
+            case 2:
+            {
+                int32_t R = Sample(X * 3);
+                int32_t G = Sample(X * 3 + 1);
+                int32_t B = Sample(X * 3 + 2);
+                bool bKeyed = bTransparentKey && R == TransparentKey[0] && G == TransparentKey[1] && B == TransparentKey[2];
+                Pixel = (bKeyed ? 0u : 0xFF000000u) | (To8(R) << 16) | (To8(G) << 8) | To8(B);
+                break;
+            }
+            case 3:
+                Pixel = Palette[Sample(X)];
+                break;
+            case 4:
+            {
+                uint32_t Value = To8(Sample(X * 2));
+                Pixel = (To8(Sample(X * 2 + 1)) << 24) | (Value << 16) | (Value << 8) | Value;
+                break;
+            }
+            case 6:
+                Pixel = (To8(Sample(X * 4 + 3)) << 24) | (To8(Sample(X * 4)) << 16) | (To8(Sample(X * 4 + 1)) << 8) | To8(Sample(X * 4 + 2));
+                break;
+            }
+            Out[static_cast<size_t>(X) * StepX] = Pixel;
+        }
+    }
+
+    std::vector<uint8_t> Data;
+    std::vector<FPngFrame> Frames;
+    FAnimationInfo Info;
+    FAnimationCanvas Canvas;
+    std::vector<uint8_t> Compressed;
+    std::vector<uint8_t> Raw;
+    std::vector<uint32_t> Pixels;
+    std::vector<uint8_t> ZeroRow;
+    uint32_t Palette[256] = {};
+    int32_t TransparentKey[3] = {};
+    bool bTransparentKey = false;
+    uint8_t BitDepth = 8;
+    uint8_t ColorType = 0;
+    bool bInterlaced = false;
+    int32_t NextFrame = 0;
+    uint8_t PreviousDispose = 0;
+    FIntRect PreviousRect;
+};
@@ -0,0 +1,427 @@
+// Qos - Scheduling classes for the wallpaper's own threads.
+// A wallpaper should only ever get the CPU time foreground work leaves over. Each
+// thread states which kind of work it does (decode, present, interactive, maintenance)
+// and the policy maps every kind onto a level: idle, background or normal. What a level
+// means is up to the platform backend - EcoQoS and priority classes on Windows,
+// SCHED_IDLE, SCHED_BATCH, nice and cgroup weights on Linux, optionally pinned to
+// the efficiency cores on hybrid CPUs. Demoted threads can fall behind, so the
+// deadline escalator watches how much slack each frame has left before it is due:
+// a few near misses, or one dropped frame, raise the frame threads a level for as
+// long as it takes; a long comfortable streak lowers them again, and a level that
+// has to be raised again soon after waits twice as long next time, as in the
+// quality controller. Interactive and maintenance threads are never raised; the
+// interactive one (windows, tray, control requests) is never demoted below background
+// either, so the user's clicks are answered promptly under foreground load.
+// The escalator is pure logic fed with samples, so traces replay anywhere; the
+// scheduler only keeps the registry and hands levels to the backend.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** What a thread does, which decides its level. */
+enum class EWorkClass : uint8_t
+{
+    Decode,         // Pulls and paces frames (the software pipeline's thread, decode service streams)
+    Present,        // Composes and blits frames (thread pool workers)
+    Maintenance,    // Indexing, service bookkeeping: late is harmless
+    Interactive,    // The UI thread: windows, tray, hotkeys, player callbacks, control requests
+    Count
+};
+
+/** Ordered from the least CPU to the most; escalation steps towards Normal. */
+enum class EQosLevel : uint8_t
+{
+    Idle,           // Only when nothing else wants the CPU
+    Background,     // Below foreground work, on efficiency cores if asked
+    Normal          // As the OS schedules anything else
+};
+
+inline const char* GetWorkClassName(EWorkClass Class)
+{
+    switch (Class)
+    {
+    case EWorkClass::Decode:      return "decode";
+    case EWorkClass::Present:     return "present";
+    case EWorkClass::Maintenance: return "maintenance";
+    case EWorkClass::Interactive: return "interactive";
+    default:                      return "unknown";
+    }
+}
+
+inline const char* GetQosLevelName(EQosLevel Level)
+{
+    switch (Level)
+    {
+    case EQosLevel::Idle:       return "idle";
+    case EQosLevel::Background: return "background";
+    case EQosLevel::Normal:     return "normal";
+    default:                    return "unknown";
+    }
+}
+
+/** "idle", "background" or "normal"; false for anything else. */
+template <typename TString>
+bool ParseQosLevel(const TString& Text, EQosLevel& Out)
+{
+    auto Equals = [&](const char* Name)
+    {
+        size_t Index = 0;
+        for (; Name[Index]; ++Index)
+        {
+            if (Index >= Text.size() || Text[Index] != static_cast<typename TString::value_type>(Name[Index])) return false;
+        }
+        return Index == Text.size();
+    };
+    if (Equals("idle")) Out = EQosLevel::Idle;
+    else if (Equals("background")) Out = EQosLevel::Background;
+    else if (Equals("normal")) Out = EQosLevel::Normal;
+    else return false;
+    return true;
+}
+
+/** Frame threads (decode, present) are raised when frames run late; the others never are. */
+inline bool IsEscalatable(EWorkClass Class) { return Class == EWorkClass::Decode || Class == EWorkClass::Present; }
+
+/** Base level per work class, before escalation. */
+struct FQosPolicy
+{
+    EQosLevel Levels[static_cast<size_t>(EWorkClass::Count)] = { EQosLevel::Normal, EQosLevel::Normal, EQosLevel::Normal, EQosLevel::Normal };
+    bool bEfficiencyCores = false;  // Demoted threads run only on the efficiency cores, where the CPU has them
+
+    /** Frame threads at Level, the UI thread at background, maintenance at idle; Normal leaves everything as the OS has it. */
+    static FQosPolicy FromPriority(EQosLevel Level, bool bEfficiencyCores)
+    {
+        FQosPolicy Policy;
+        Policy.Levels[static_cast<size_t>(EWorkClass::Decode)] = Level;
+        Policy.Levels[static_cast<size_t>(EWorkClass::Present)] = Level;
+        Policy.Levels[static_cast<size_t>(EWorkClass::Maintenance)] = Level == EQosLevel::Normal ? EQosLevel::Normal : EQosLevel::Idle;
+        Policy.Levels[static_cast<size_t>(EWorkClass::Interactive)] = Level == EQosLevel::Normal ? EQosLevel::Normal : EQosLevel::Background;
+        Policy.bEfficiencyCores = bEfficiencyCores;
+        return Policy;
+    }
+
+    EQosLevel Get(EWorkClass Class) const { return Levels[static_cast<size_t>(Class)]; }
+    bool IsDemoting() const
+    {
+        for (EQosLevel Level : Levels) if (Level != EQosLevel::Normal) return true;
+        return false;
+    }
+};
+
+/** Base raised by Boost steps; maintenance keeps its base. */
+inline EQosLevel GetEffectiveLevel(const FQosPolicy& Policy, EWorkClass Class, int32_t Boost)
+{
+    int32_t Level = static_cast<int32_t>(Policy.Get(Class)) + (IsEscalatable(Class) ? Boost : 0);
+    int32_t Top = static_cast<int32_t>(EQosLevel::Normal);
+    return static_cast<EQosLevel>(Level < Top ? Level : Top);
+}
+
+/** One frame as the pacing loop saw it. */
+struct FDeadlineSample
+{
+    int64_t SlackNs = 0;            // Time left before the frame was due once it was ready; negative when late
+    int64_t FrameNs = 0;            // Frame duration at the current rate
+    bool bDropped = false;          // Skipped for being more than a frame late
+};
+
+struct FDeadlineSettings
+{
+    double NearMissRatio = 0.25;    // Slack under this share of a frame is a near miss
+    int32_t EscalateMisses = 3;     // Near misses within WindowFrames that raise the boost (a drop counts as all of them)
+    int32_t WindowFrames = 30;      // Near misses older than this are forgotten
+    int32_t RelaxFrames = 300;      // Comfortable frames in a row before the boost drops a step
+    int32_t MaxBoost = 2;           // Idle can reach Normal
+    int32_t MaxBackoffShift = 3;    // Relax streak grows to at most RelaxFrames << 3
+};
+
+struct FDeadlineStats
+{
+    uint64_t Frames = 0;
+    uint64_t NearMisses = 0;        // Includes drops
+    uint64_t Drops = 0;             // Dropped, or ready only after they were due
+    uint32_t Escalations = 0;
+    uint32_t Relaxations = 0;
+};
+
+/** Turns per-frame slack into a boost: how many levels the frame threads are raised. */
+class FDeadlineEscalator
+{
+public:
+    explicit FDeadlineEscalator(const FDeadlineSettings& InSettings = {}) : Settings(InSettings) { Reset(); }
+
+    /** Boost 0, counters and backoff cleared; for a new video or a resume after a pause. */
+    void Reset()
+    {
+        Backoff.assign(static_cast<size_t>(Settings.MaxBoost > 0 ? Settings.MaxBoost : 1), 0);
+        Boost = 0;
+        Misses = 0;
+        WindowFrames = 0;
+        ComfortStreak = 0;
+        FramesSinceRelax = -1;
+    }
+
+    /** Returns the boost after this frame. */
+    int32_t Update(const FDeadlineSample& Sample)
+    {
+        bool bLate = Sample.bDropped || Sample.SlackNs < 0;
+        bool bNearMiss = bLate || Sample.SlackNs < static_cast<int64_t>(Sample.FrameNs * Settings.NearMissRatio);
+        ++Stats.Frames;
+        if (bNearMiss) ++Stats.NearMisses;
+        if (bLate) ++Stats.Drops;
+        if (FramesSinceRelax >= 0) ++FramesSinceRelax;
+
+        ++WindowFrames;
+        if (bNearMiss)
+        {
+            Misses += bLate ? Settings.EscalateMisses : 1;
+            ComfortStreak = 0;
+        }
+        else ++ComfortStreak;
+
+        if (Misses >= Settings.EscalateMisses && Boost < Settings.MaxBoost)
+        {
+            // The level we relaxed from did not hold: leave it less eagerly next time.
+            if (FramesSinceRelax >= 0 && FramesSinceRelax <= Settings.RelaxFrames)
+            {
+                int32_t& Shift = Backoff[static_cast<size_t>(Boost)];
+                if (Shift < Settings.MaxBackoffShift) ++Shift;
+            }
+            ++Boost;
+            ++Stats.Escalations;
+            Misses = 0;
+            WindowFrames = 0;
+            FramesSinceRelax = -1;
+            return Boost;
+        }
+        if (WindowFrames >= Settings.WindowFrames)
+        {
+            WindowFrames = 0;
+            Misses = 0;
+        }
+        if (Boost > 0 && ComfortStreak >= GetRelaxFrames(Boost - 1))
+        {
+            --Boost;
+            ++Stats.Relaxations;
+            ComfortStreak = 0;
+            FramesSinceRelax = 0;
+        }
+        return Boost;
+    }
+
+    int32_t GetBoost() const { return Boost; }
+    const FDeadlineStats& GetStats() const { return Stats; }
+
+    /** Comfortable frames needed before dropping from TargetBoost + 1 to TargetBoost. */
+    int32_t GetRelaxFrames(int32_t TargetBoost) const
+    {
+        return Settings.RelaxFrames << Backoff[static_cast<size_t>(TargetBoost)];
+    }
+
+private:
+    FDeadlineSettings Settings;
+    FDeadlineStats Stats;
+    std::vector<int32_t> Backoff;   // Per boost: left-shift applied to RelaxFrames
+    int32_t Boost = 0;
+    int32_t Misses = 0;
+    int32_t WindowFrames = 0;
+    int32_t ComfortStreak = 0;
+    int32_t FramesSinceRelax = -1;
+};
+
+/** Parses a kernel CPU list ("0-3,8,10-11"); empty on a malformed list. */
+inline std::vector<int32_t> ParseCpuList(const std::string& Text)
+{
+    std::vector<int32_t> Cpus;
+    size_t Index = 0;
+    auto ReadNumber = [&](int32_t& Value)
+    {
+        size_t Start = Index;
+        Value = 0;
+        while (Index < Text.size() && Text[Index] >= '0' && Text[Index] <= '9' && Value < 65536) Value = Value * 10 + (Text[Index++] - '0');
+        return Index > Start;
+    };
+    while (Index < Text.size() && Text[Index] != '\n')
+    {
+        int32_t First = 0;
+        int32_t Last = 0;
+        if (!ReadNumber(First)) return {};
+        Last = First;
+        if (Index < Text.size() && Text[Index] == '-' && (++Index, !ReadNumber(Last))) return {};
+        if (Last < First || Last >= 65536) return {};
+        for (int32_t Cpu = First; Cpu <= Last; ++Cpu) Cpus.push_back(Cpu);
+        if (Index < Text.size() && Text[Index] == ',') ++Index;
+    }
+    return Cpus;
+}
+
+/** What the platform does with a level. Unset functions make the scheduler a bookkeeper only. */
+struct FQosBackend
+{
+    std::function<uint64_t()> GetCurrentThreadId;
+    /** Thread, level, efficiency cores, whether the thread may be raised again later. False on failure. */
+    std::function<bool(uint64_t, EQosLevel, bool, bool)> ApplyThread;
+    /** Process-wide part (priority class, EcoQoS, cgroup weight), given the frame threads' level. */
+    std::function<bool(EQosLevel)> ApplyProcess;
+};
+
+struct FQosStats
+{
+    size_t Threads[static_cast<size_t>(EWorkClass::Count)] = {};
+    EQosLevel Levels[static_cast<size_t>(EWorkClass::Count)] = { EQosLevel::Normal, EQosLevel::Normal, EQosLevel::Normal, EQosLevel::Normal };
+    int32_t Boost = 0;
+    uint64_t Applied = 0;
+    uint64_t Failed = 0;
+};
+
+/**
+ * Registry of the process's threads by work class. Threads enter once they start;
+ * they leave on their own when they exit. Policy and boost changes are applied to
+ * every registered thread whose level moves. Thread-safe. A thread is tracked by one
+ * scheduler at a time, and schedulers other than GQos must outlive the threads in them.
+ */
+class FQosScheduler
+{
+public:
+    void SetBackend(FQosBackend InBackend)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Backend = std::move(InBackend);
+    }
+
+    void SetPolicy(const FQosPolicy& InPolicy)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Policy = InPolicy;
+        ApplyAll(true);
+    }
+
+    /** Raises the frame threads Boost levels above their base (0 is the base). */
+    void SetBoost(int32_t InBoost)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (InBoost == Boost) return;
+        Boost = InBoost;
+        ApplyAll(false);
+    }
+
+    /** Registers the calling thread; it is removed again when the thread exits. */
+    void EnterThread(EWorkClass Class)
+    {
+        thread_local FThreadExit Exit;
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (!Backend.GetCurrentThreadId) return;
+        uint64_t Id = Backend.GetCurrentThreadId();
+        Exit.Scheduler = this;
+        Exit.ThreadId = Id;
+        for (FThreadEntry& Entry : Threads)
+        {
+            if (Entry.ThreadId != Id) continue;
+            Entry.Class = Class;
+            Apply(Entry, true);
+            return;
+        }
+        Threads.push_back({ Id, Class, EQosLevel::Normal });
+        Apply(Threads.back(), true);
+    }
+
+    void LeaveThread(uint64_t ThreadId)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        for (size_t Index = 0; Index < Threads.size(); ++Index)
+        {
+            if (Threads[Index].ThreadId != ThreadId) continue;
+            Threads[Index] = Threads.back();
+            Threads.pop_back();
+            return;
+        }
+    }
+
+    FQosPolicy GetPolicy() const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        return Policy;
+    }
+
+    FQosStats GetStats() const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        FQosStats Result = Stats;
+        for (size_t Class = 0; Class < static_cast<size_t>(EWorkClass::Count); ++Class)
+        {
+            Result.Levels[Class] = GetEffectiveLevel(Policy, static_cast<EWorkClass>(Class), Boost);
+        }
+        for (const FThreadEntry& Entry : Threads) ++Result.Threads[static_cast<size_t>(Entry.Class)];
+        Result.Boost = Boost;
+        return Result;
+    }
+
+private:
+    struct FThreadEntry
+    {
+        uint64_t ThreadId = 0;
+        EWorkClass Class = EWorkClass::Maintenance;
+        EQosLevel Applied = EQosLevel::Normal;
+    };
+
+    struct FThreadExit
+    {
+        FQosScheduler* Scheduler = nullptr;
+        uint64_t ThreadId = 0;
+        ~FThreadExit() { if (Scheduler) Scheduler->LeaveThread(ThreadId); }
+    };
+
+    /** Caller holds Mutex. */
+    void Apply(FThreadEntry& Entry, bool bForce)
+    {
+        // Forced for a new policy, which may move demoted threads onto other cores; threads
+        // never demoted are left as the OS made them.
+        EQosLevel Level = GetEffectiveLevel(Policy, Entry.Class, Boost);
+        if (Level == Entry.Applied && !(bForce && Level != EQosLevel::Normal)) return;
+        Entry.Applied = Level;
+        if (!Backend.ApplyThread) return;
+        bool bApplied = Backend.ApplyThread(Entry.ThreadId, Level, Policy.bEfficiencyCores, IsEscalatable(Entry.Class));
+        ++(bApplied ? Stats.Applied : Stats.Failed);
+    }
+
+    /** Caller holds Mutex. */
+    void ApplyAll(bool bForce)
+    {
+        for (FThreadEntry& Entry : Threads) Apply(Entry, bForce);
+        EQosLevel Level = GetEffectiveLevel(Policy, EWorkClass::Decode, Boost);
+        if (Level == ProcessLevel && !(bForce && Level != EQosLevel::Normal)) return;
+        ProcessLevel = Level;
+        if (!Backend.ApplyProcess) return;
+        bool bApplied = Backend.ApplyProcess(Level);
+        ++(bApplied ? Stats.Applied : Stats.Failed);
+    }
+
+    mutable std::mutex Mutex;
+    FQosBackend Backend;
+    FQosPolicy Policy;
+    int32_t Boost = 0;
+    EQosLevel ProcessLevel = EQosLevel::Normal;
+    std::vector<FThreadEntry> Threads;
+    FQosStats Stats;
+};
+
+inline FQosScheduler GQos;
+
+/**
+ * Runs Function on a short-lived thread registered as Class and returns its result,
+ * so child processes it starts (an ffmpeg decoder) inherit that class's level
+ * instead of the caller's.
+ */
+template <typename TFunction>
+auto RunAsWorkClass(EWorkClass Class, TFunction&& Function) -> decltype(Function())
+{
+    decltype(Function()) Result {};
+    std::thread([&] { GQos.EnterThread(Class); Result = Function(); }).join();
+    return Result;
+}
@@ -0,0 +1,461 @@
+// qos_bench - Checks the scheduling classes and the deadline escalator, then the Linux backend.
+// Scripted slack traces check the escalator: a few near misses within the window,
+// or a single dropped frame, raise the boost a level; scattered near misses do not;
+// a long comfortable streak lowers it a level at a time, a level that had to be
+// raised again right after it was left waits twice as long next time, and the boost
+// never passes its cap. The policy, level parsing and the scheduler's registry run
+// against a recording backend: only threads whose level moves are re-applied,
+// maintenance is never raised, and threads leave the registry when they exit.
+// Then the Linux backend is applied to real threads and read back (scheduler
+// policy, nice value, affinity, also as an unprivileged process would map levels),
+// and a spinner at idle and at background priority shares one CPU with a spinner
+// at normal priority, which must get the bulk of it:
+//   g++ -std=c++20 -O2 -pthread qos_bench.cpp -o qos_bench
+//   qos_bench [--spin-ms N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "qos.h"
+#include "qos_linux.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t SpinMs = 500;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--spin-ms") Options.SpinMs = std::atoi(Value);
+            else return false;
+        }
+        return Options.SpinMs > 0;
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    constexpr int64_t FrameNs = 16666667;
+
+    /** Feeds Frames identical samples; returns the boost after the last one. */
+    int32_t Feed(FDeadlineEscalator& Escalator, int64_t SlackNs, bool bDropped, int32_t Frames)
+    {
+        int32_t Boost = Escalator.GetBoost();
+        for (int32_t Frame = 0; Frame < Frames; ++Frame) Boost = Escalator.Update({ SlackNs, FrameNs, bDropped });
+        return Boost;
+    }
+
+    int32_t Comfortable(FDeadlineEscalator& Escalator, int32_t Frames) { return Feed(Escalator, FrameNs / 2, false, Frames); }
+    int32_t NearMiss(FDeadlineEscalator& Escalator, int32_t Frames) { return Feed(Escalator, FrameNs / 10, false, Frames); }
+    int32_t Drop(FDeadlineEscalator& Escalator, int32_t Frames) { return Feed(Escalator, 0, true, Frames); }
+
+    bool CheckEscalator()
+    {
+        FDeadlineSettings Settings;
+        FDeadlineEscalator Escalator(Settings);
+        bool bPass = Check(Comfortable(Escalator, 100) == 0, "raised without near misses");
+        bPass &= Check(NearMiss(Escalator, Settings.EscalateMisses - 1) == 0, "raised before enough near misses");
+        bPass &= Check(NearMiss(Escalator, 1) == 1, "near misses within the window not raised");
+
+        Escalator.Reset();
+        for (int32_t Miss = 0; Miss < Settings.EscalateMisses * 3; ++Miss)
+        {
+            NearMiss(Escalator, 1);
+            Comfortable(Escalator, Settings.WindowFrames);
+        }
+        bPass &= Check(Escalator.GetBoost() == 0, "scattered near misses raised");
+        bPass &= Check(Escalator.Update({ -FrameNs / 4, FrameNs, false }) == 1, "late frame not raised at once");
+
+        Escalator.Reset();
+        bPass &= Check(Drop(Escalator, 1) == 1, "drop not raised at once");
+        bPass &= Check(Drop(Escalator, 1) == 2, "second drop not raised");
+        bPass &= Check(Drop(Escalator, 5) == Settings.MaxBoost, "boost passed its cap");
+
+        int32_t Escalations = static_cast<int32_t>(Escalator.GetStats().Escalations);
+        bPass &= Check(Comfortable(Escalator, Settings.RelaxFrames - 1) == 2, "relaxed before the streak");
+        bPass &= Check(Comfortable(Escalator, 1) == 1, "not relaxed after the streak");
+        bPass &= Check(NearMiss(Escalator, 1) == 1 && Comfortable(Escalator, Settings.RelaxFrames - 1) == 1, "near miss did not restart the streak");
+        bPass &= Check(Comfortable(Escalator, 1) == 0, "second level not relaxed");
+        bPass &= Check(Escalator.GetStats().Relaxations == 2, "relaxations miscounted");
+
+        // Raised again right after relaxing: the next relax waits twice as long.
+        bPass &= Check(Drop(Escalator, 1) == 1, "drop after relaxing not raised");
+        bPass &= Check(Escalator.GetRelaxFrames(0) == Settings.RelaxFrames * 2, "no back-off after a failed relax");
+        bPass &= Check(Comfortable(Escalator, Settings.RelaxFrames * 2 - 1) == 1, "relaxed before the back-off");
+        bPass &= Check(Comfortable(Escalator, 1) == 0, "not relaxed after the back-off");
+        bPass &= Check(static_cast<int32_t>(Escalator.GetStats().Escalations) == Escalations + 1, "escalations miscounted");
+
+        // Raised long after relaxing: no further back-off.
+        Comfortable(Escalator, Settings.RelaxFrames + 1);
+        Drop(Escalator, 1);
+        bPass &= Check(Escalator.GetRelaxFrames(0) == Settings.RelaxFrames * 2, "back-off grew after a lasting relax");
+
+        Escalator.Reset();
+        bPass &= Check(Escalator.GetBoost() == 0 && Escalator.GetRelaxFrames(0) == Settings.RelaxFrames, "reset kept boost or back-off");
+        bPass &= Check(Escalator.GetStats().Drops >= 5 && Escalator.GetStats().NearMisses >= Escalator.GetStats().Drops, "drops not counted as near misses");
+        return bPass;
+    }
+
+    bool CheckPolicy()
+    {
+        FQosPolicy Background = FQosPolicy::FromPriority(EQosLevel::Background, true);
+        bool bPass = Check
+        (
+            Background.Get(EWorkClass::Decode) == EQosLevel::Background &&
+            Background.Get(EWorkClass::Present) == EQosLevel::Background &&
+            Background.Get(EWorkClass::Maintenance) == EQosLevel::Idle &&
+            Background.Get(EWorkClass::Interactive) == EQosLevel::Background &&
+            Background.bEfficiencyCores && Background.IsDemoting(),
+            "background policy"
+        );
+        FQosPolicy Normal = FQosPolicy::FromPriority(EQosLevel::Normal, false);
+        bPass &= Check(Normal.Get(EWorkClass::Maintenance) == EQosLevel::Normal && !Normal.IsDemoting(), "normal policy demotes");
+
+        FQosPolicy Idle = FQosPolicy::FromPriority(EQosLevel::Idle, false);
+        bPass &= Check(GetEffectiveLevel(Idle, EWorkClass::Decode, 0) == EQosLevel::Idle, "base level");
+        bPass &= Check(GetEffectiveLevel(Idle, EWorkClass::Present, 1) == EQosLevel::Background, "one step of boost");
+        bPass &= Check(GetEffectiveLevel(Idle, EWorkClass::Decode, 5) == EQosLevel::Normal, "boost past normal");
+        bPass &= Check(GetEffectiveLevel(Idle, EWorkClass::Maintenance, 2) == EQosLevel::Idle, "maintenance raised");
+        bPass &= Check(GetEffectiveLevel(Idle, EWorkClass::Interactive, 2) == EQosLevel::Background, "UI thread idle or raised");
+        bPass &= Check(Normal.Get(EWorkClass::Interactive) == EQosLevel::Normal, "normal policy demotes the UI thread");
+
+        EQosLevel Level = EQosLevel::Normal;
+        bPass &= Check(ParseQosLevel(std::string("idle"), Level) && Level == EQosLevel::Idle, "idle not parsed");
+        bPass &= Check(ParseQosLevel(std::wstring(L"background"), Level) && Level == EQosLevel::Background, "wide background not parsed");
+        bPass &= Check(!ParseQosLevel(std::string("normally"), Level) && !ParseQosLevel(std::string(), Level), "bad level parsed");
+        bPass &= Check(Level == EQosLevel::Background, "bad level changed the value");
+
+        bPass &= Check(ParseCpuList("0-3,8,10-11\n") == std::vector<int32_t>{ 0, 1, 2, 3, 8, 10, 11 }, "cpu list misparsed");
+        bPass &= Check(ParseCpuList("5") == std::vector<int32_t>{ 5 }, "single cpu misparsed");
+        bPass &= Check(ParseCpuList("").empty() && ParseCpuList("3-1").empty() && ParseCpuList("x").empty(), "bad cpu list parsed");
+        return bPass;
+    }
+
+    /** Backend that records what it is asked to apply. */
+    struct FRecordingBackend
+    {
+        struct FApplied
+        {
+            uint64_t Thread = 0;
+            EQosLevel Level = EQosLevel::Normal;
+            bool bEfficiencyCores = false;
+            bool bEscalatable = false;
+        };
+
+        std::mutex Mutex;
+        std::vector<FApplied> Threads;
+        std::vector<EQosLevel> Processes;
+        bool bFail = false;
+
+        FQosBackend MakeBackend()
+        {
+            FQosBackend Backend;
+            Backend.GetCurrentThreadId = [] { return static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())); };
+            Backend.ApplyThread = [this](uint64_t Thread, EQosLevel Level, bool bEfficiencyCores, bool bEscalatable)
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                Threads.push_back({ Thread, Level, bEfficiencyCores, bEscalatable });
+                return !bFail;
+            };
+            Backend.ApplyProcess = [this](EQosLevel Level)
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                Processes.push_back(Level);
+                return !bFail;
+            };
+            return Backend;
+        }
+
+        /** Takes what was applied since the last call. */
+        std::vector<FApplied> TakeThreads()
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            std::vector<FApplied> Taken;
+            Taken.swap(Threads);
+            return Taken;
+        }
+    };
+
+    /** A thread that registers in Scheduler as Class and stays until Finish. */
+    class FRegisteredThread
+    {
+    public:
+        FRegisteredThread(FQosScheduler& Scheduler, EWorkClass Class)
+        {
+            Thread = std::thread([this, &Scheduler, Class]()
+            {
+                Scheduler.EnterThread(Class);
+                bEntered = true;
+                while (!bFinish) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            });
+            while (!bEntered) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ~FRegisteredThread() { Finish(); }
+
+        void Finish()
+        {
+            bFinish = true;
+            if (Thread.joinable()) Thread.join();
+        }
+
+    private:
+        std::thread Thread;
+        std::atomic<bool> bEntered{ false };
+        std::atomic<bool> bFinish{ false };
+    };
+
+    bool CheckScheduler()
+    {
+        // Declared first so it outlives every thread registered in it.
+        FQosScheduler Scheduler;
+        FRecordingBackend Recorder;
+        Scheduler.SetBackend(Recorder.MakeBackend());
+        Scheduler.SetPolicy(FQosPolicy::FromPriority(EQosLevel::Background, true));
+        bool bPass = Check(Recorder.Processes.size() == 1 && Recorder.Processes[0] == EQosLevel::Background, "process level not applied");
+
+        FRegisteredThread Maintenance(Scheduler, EWorkClass::Maintenance);
+        FRegisteredThread Decode(Scheduler, EWorkClass::Decode);
+        std::vector<FRecordingBackend::FApplied> Applied = Recorder.TakeThreads();
+        bPass &= Check
+        (
+            Applied.size() == 2 &&
+            Applied[0].Level == EQosLevel::Idle && !Applied[0].bEscalatable && Applied[0].bEfficiencyCores &&
+            Applied[1].Level == EQosLevel::Background && Applied[1].bEscalatable,
+            "threads not applied on entry"
+        );
+        FQosStats Stats = Scheduler.GetStats();
+        bPass &= Check
+        (
+            Stats.Threads[static_cast<size_t>(EWorkClass::Decode)] == 1 &&
+            Stats.Threads[static_cast<size_t>(EWorkClass::Maintenance)] == 1,
+            "registry miscounted"
+        );
+
+        Scheduler.SetBoost(1);
+        Applied = Recorder.TakeThreads();
+        bPass &= Check(Applied.size() == 1 && Applied[0].Level == EQosLevel::Normal, "boost not applied to the frame thread only");
+        bPass &= Check(Recorder.Processes.back() == EQosLevel::Normal, "boost not applied to the process");
+        Scheduler.SetBoost(1);
+        bPass &= Check(Recorder.TakeThreads().empty(), "unchanged boost re-applied");
+        Scheduler.SetBoost(0);
+        Applied = Recorder.TakeThreads();
+        bPass &= Check(Applied.size() == 1 && Applied[0].Level == EQosLevel::Background, "boost not taken back");
+
+        Decode.Finish();
+        Stats = Scheduler.GetStats();
+        bPass &= Check(Stats.Threads[static_cast<size_t>(EWorkClass::Decode)] == 0, "exited thread still registered");
+
+        Scheduler.SetPolicy(FQosPolicy::FromPriority(EQosLevel::Normal, false));
+        Applied = Recorder.TakeThreads();
+        bPass &= Check(Applied.size() == 1 && Applied[0].Level == EQosLevel::Normal, "normal policy not applied");
+        Scheduler.SetPolicy(FQosPolicy::FromPriority(EQosLevel::Normal, false));
+        bPass &= Check(Recorder.TakeThreads().empty(), "normal policy re-applied to undemoted threads");
+
+        Recorder.bFail = true;
+        Scheduler.SetPolicy(FQosPolicy::FromPriority(EQosLevel::Idle, false));
+        bPass &= Check(Scheduler.GetStats().Failed == 2, "failures not counted");
+        Maintenance.Finish();
+        return bPass;
+    }
+
+    int64_t ThreadCpuNs()
+    {
+        timespec Time {};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Time);
+        return Time.tv_sec * 1000000000LL + Time.tv_nsec;
+    }
+
+    struct FThreadState
+    {
+        int Policy = -1;
+        int Nice = 0;
+        cpu_set_t Affinity;
+    };
+
+    FThreadState ReadThreadState()
+    {
+        FThreadState State;
+        State.Policy = sched_getscheduler(0) & ~SCHED_RESET_ON_FORK;
+        State.Nice = getpriority(PRIO_PROCESS, static_cast<id_t>(GetLinuxThreadId()));
+        CPU_ZERO(&State.Affinity);
+        sched_getaffinity(0, sizeof(State.Affinity), &State.Affinity);
+        return State;
+    }
+
+    /** Runs Body on a fresh thread, so what it applies dies with it. */
+    bool OnThread(const std::function<bool()>& Body)
+    {
+        bool bResult = false;
+        std::thread([&]() { bResult = Body(); }).join();
+        return bResult;
+    }
+
+    bool CheckLinuxBackend()
+    {
+        FLinuxQosSettings Settings;
+        Settings.bUseCgroup = false;
+        Settings.EfficiencyCpus = { 0 };
+        FLinuxQos Qos(Settings);
+        cpu_set_t All;
+        CPU_ZERO(&All);
+        sched_getaffinity(0, sizeof(All), &All);
+        int ProcessNice = getpriority(PRIO_PROCESS, 0);
+        int BackgroundNice = ProcessNice > Settings.BackgroundNice ? ProcessNice : Settings.BackgroundNice;
+
+        bool bPass = Check(Qos.GetEfficiencyCpuCount() == (CPU_ISSET(0, &All) ? 1 : 0), "forced efficiency cores");
+        bPass &= Check(OnThread([&]()
+        {
+            uint64_t Self = GetLinuxThreadId();
+            bool bOk = Check(Qos.ApplyThread(Self, EQosLevel::Background, false, true), "background apply failed");
+            FThreadState State = ReadThreadState();
+            bOk &= Check
+            (
+                Qos.CanRaise()
+                    ? State.Policy == SCHED_OTHER && State.Nice == BackgroundNice
+                    : State.Policy == SCHED_BATCH && State.Nice == ProcessNice,
+                "background misapplied"
+            );
+            bOk &= Check(Qos.ApplyThread(Self, EQosLevel::Idle, true, true), "idle apply failed");
+            State = ReadThreadState();
+            bOk &= Check(State.Policy == (Qos.CanRaise() ? SCHED_IDLE : SCHED_BATCH), "idle misapplied");
+            bOk &= Check(CPU_EQUAL(&State.Affinity, &All) || (CPU_COUNT(&State.Affinity) == 1 && CPU_ISSET(0, &State.Affinity)), "not pinned to the efficiency cores");
+            bOk &= Check(Qos.ApplyThread(Self, EQosLevel::Normal, true, true), "normal apply failed");
+            State = ReadThreadState();
+            bOk &= Check
+            (
+                State.Policy == SCHED_OTHER && State.Nice == ProcessNice && CPU_EQUAL(&State.Affinity, &All),
+                "escalated thread not back at normal"
+            );
+            return bOk;
+        }), "applied levels");
+
+        // As an unprivileged process: escalatable threads only get what they can undo.
+        Settings.bAssumeUnprivileged = true;
+        FLinuxQos Unprivileged(Settings);
+        bPass &= Check(OnThread([&]()
+        {
+            uint64_t Self = GetLinuxThreadId();
+            bool bOk = Unprivileged.ApplyThread(Self, EQosLevel::Idle, false, true);
+            FThreadState State = ReadThreadState();
+            bOk &= Check(State.Policy == SCHED_BATCH && State.Nice == ProcessNice, "unprivileged idle not batch");
+            bOk &= Unprivileged.ApplyThread(Self, EQosLevel::Normal, false, true);
+            bOk &= Check(ReadThreadState().Policy == SCHED_OTHER, "unprivileged batch not undone");
+            bOk &= Unprivileged.ApplyThread(Self, EQosLevel::Idle, false, false);
+            bOk &= Check(ReadThreadState().Policy == SCHED_IDLE, "maintenance thread not idle");
+            return bOk;
+        }), "unprivileged mapping");
+        std::printf("linux backend: %s\n", Qos.Describe().c_str());
+        return bPass;
+    }
+
+    /**
+     * Share of one CPU a spinner at Level gets next to a spinner at the process's
+     * priority; negative if the threads could not be set up.
+     */
+    double MeasureShare(const FLinuxQos& Qos, EQosLevel Level, int32_t Cpu, int32_t SpinMs)
+    {
+        std::atomic<int32_t> Ready{ 0 };
+        std::atomic<bool> bStart{ false };
+        std::atomic<bool> bStop{ false };
+        std::atomic<bool> bFailed{ false };
+        int64_t CpuNs[2] = {};
+        auto Spin = [&](int32_t Index)
+        {
+            // Applied first: the backend resets affinity along with the level.
+            bool bOk = Index == 0 || Qos.ApplyThread(GetLinuxThreadId(), Level, false, false);
+            cpu_set_t Pinned;
+            CPU_ZERO(&Pinned);
+            CPU_SET(Cpu, &Pinned);
+            bOk &= sched_setaffinity(0, sizeof(Pinned), &Pinned) == 0;
+            if (!bOk) bFailed = true;
+            ++Ready;
+            while (!bStart) std::this_thread::yield();
+            int64_t Start = ThreadCpuNs();
+            volatile uint64_t Counter = 0;
+            while (!bStop.load(std::memory_order_relaxed)) Counter = Counter + 1;
+            CpuNs[Index] = ThreadCpuNs() - Start;
+        };
+        std::thread Normal(Spin, 0);
+        std::thread Demoted(Spin, 1);
+        while (Ready < 2) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        bStart = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(SpinMs));
+        bStop = true;
+        Normal.join();
+        Demoted.join();
+        int64_t Total = CpuNs[0] + CpuNs[1];
+        if (bFailed || Total <= 0) return -1.0;
+        return static_cast<double>(CpuNs[1]) / static_cast<double>(Total);
+    }
+
+    bool CheckContention(const FBenchOptions& Options)
+    {
+        FLinuxQosSettings Settings;
+        Settings.bUseCgroup = false;
+        FLinuxQos Qos(Settings);
+        cpu_set_t All;
+        CPU_ZERO(&All);
+        sched_getaffinity(0, sizeof(All), &All);
+        int32_t Cpu = 0;
+        while (Cpu < CPU_SETSIZE && !CPU_ISSET(Cpu, &All)) ++Cpu;
+
+        double IdleShare = MeasureShare(Qos, EQosLevel::Idle, Cpu, Options.SpinMs);
+        double BackgroundShare = MeasureShare(Qos, EQosLevel::Background, Cpu, Options.SpinMs);
+        if (IdleShare < 0 || BackgroundShare < 0)
+        {
+            std::printf("contention: skipped (threads could not be demoted or pinned)\n");
+            return true;
+        }
+        std::printf
+        (
+            "contention: on cpu %d next to a normal spinner, idle got %.1f%% and background %.1f%% over %d ms\n",
+            Cpu, IdleShare * 100.0, BackgroundShare * 100.0, Options.SpinMs
+        );
+        bool bPass = Check(IdleShare < 0.2, "idle spinner took too much of the CPU");
+        bPass &= Check(BackgroundShare < 0.35, "background spinner took too much of the CPU");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: qos_bench [--spin-ms N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckEscalator(), "deadline escalator");
+    bPass &= Check(CheckPolicy(), "policy and parsing");
+    bPass &= Check(CheckScheduler(), "scheduler");
+    bPass &= Check(CheckLinuxBackend(), "linux backend");
+    bPass &= Check(CheckContention(Options), "contention");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+// QosLinux - Linux backend for the scheduling classes in qos.h (Linux).
+// Levels map onto per-thread scheduler settings, applied by thread id so the
+// scheduler can move any registered thread:
+//   normal      SCHED_OTHER at the process's own nice value, on every CPU it may use
+//   background  SCHED_OTHER at nice 10, or SCHED_BATCH where that nice value could not be undone
+//   idle        SCHED_IDLE, or SCHED_BATCH where the thread could not leave it again
+// Without CAP_SYS_NICE or an RLIMIT_NICE that allows it, a thread may lower its
+// priority but not raise it back, so threads that escalation has to be able to
+// raise again only get the settings they can undo. Demoted threads can be pinned to
+// the efficiency cores: Intel hybrid parts list them in /sys/devices/cpu_atom/cpus,
+// ARM big.LITTLE ones have a cpu_capacity below the big cores'. When the process
+// runs in a cgroup of its own (systemd-run --user --scope, say), the cgroup's
+// cpu.weight follows the frame threads' level as well, and idle sets cpu.idle.
+
+#pragma once
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "qos.h"
+
+inline uint64_t GetLinuxThreadId() { return static_cast<uint64_t>(syscall(SYS_gettid)); }
+
+/** Efficiency cores of a hybrid CPU; empty when all cores are alike or nothing says. */
+inline std::vector<int32_t> FindEfficiencyCpus()
+{
+    std::ifstream Atom("/sys/devices/cpu_atom/cpus");
+    std::string Line;
+    if (Atom && std::getline(Atom, Line)) return ParseCpuList(Line);
+
+    std::vector<int32_t> Capacities;
+    for (int32_t Cpu = 0; Cpu < 1024; ++Cpu)
+    {
+        std::ifstream File("/sys/devices/system/cpu/cpu" + std::to_string(Cpu) + "/cpu_capacity");
+        int32_t Capacity = 0;
+        if (!(File >> Capacity)) break;
+        Capacities.push_back(Capacity);
+    }
+    int32_t Largest = 0;
+    for (int32_t Capacity : Capacities) Largest = Capacity > Largest ? Capacity : Largest;
+    std::vector<int32_t> Efficient;
+    for (size_t Cpu = 0; Cpu < Capacities.size(); ++Cpu)
+    {
+        if (Capacities[Cpu] < Largest) Efficient.push_back(static_cast<int32_t>(Cpu));
+    }
+    return Efficient;
+}
+
+/** True if threads that were lowered may be raised back to the process's nice value and out of SCHED_IDLE. */
+inline bool CanRaiseThreadPriority(int32_t Nice)
+{
+    std::ifstream ProcStatus("/proc/self/status");
+    std::string Line;
+    while (std::getline(ProcStatus, Line))
+    {
+        if (Line.compare(0, 7, "CapEff:") != 0) continue;
+        unsigned long long Capabilities = std::strtoull(Line.c_str() + 7, nullptr, 16);
+        if (Capabilities & (1ULL << 23)) return true;   // CAP_SYS_NICE
+    }
+    rlimit Limit {};
+    return getrlimit(RLIMIT_NICE, &Limit) == 0 && (Limit.rlim_cur == RLIM_INFINITY || Limit.rlim_cur >= static_cast<rlim_t>(20 - Nice));
+}
+
+/**
+ * The cgroup v2 directory this process has to itself, or empty: a cgroup shared with
+ * anything else (the whole user session, typically) is not ours to reweight.
+ */
+inline std::string FindOwnCgroup()
+{
+    std::ifstream Membership("/proc/self/cgroup");
+    std::string Line;
+    std::string Path;
+    while (std::getline(Membership, Line))
+    {
+        if (Line.compare(0, 3, "0::") == 0) Path = "/sys/fs/cgroup" + Line.substr(3);
+    }
+    if (Path.empty()) return {};
+    std::ifstream Procs(Path + "/cgroup.procs");
+    std::string Pid;
+    bool bAlone = false;
+    while (std::getline(Procs, Pid))
+    {
+        if (std::atoll(Pid.c_str()) != static_cast<long long>(getpid())) return {};
+        bAlone = true;
+    }
+    if (!bAlone || !std::ofstream(Path + "/cpu.weight", std::ios::app)) return {};
+    return Path;
+}
+
+struct FLinuxQosSettings
+{
+    int32_t BackgroundNice = 10;
+    bool bUseCgroup = true;
+    bool bAssumeUnprivileged = false;       // Map levels as if raising priority were not allowed
+    std::vector<int32_t> EfficiencyCpus;    // Empty: detected
+};
+
+/** Applies qos.h levels to Linux threads. Outlives the backend handed to GQos. */
+class FLinuxQos
+{
+public:
+    explicit FLinuxQos(const FLinuxQosSettings& InSettings = {}) : Settings(InSettings)
+    {
+        errno = 0;
+        int Priority = getpriority(PRIO_PROCESS, 0);
+        ProcessNice = errno ? 0 : Priority;
+        bCanRaise = !Settings.bAssumeUnprivileged && CanRaiseThreadPriority(ProcessNice);
+        CPU_ZERO(&AllCpus);
+        sched_getaffinity(0, sizeof(AllCpus), &AllCpus);
+        std::vector<int32_t> Efficient = Settings.EfficiencyCpus.empty() ? FindEfficiencyCpus() : Settings.EfficiencyCpus;
+        CPU_ZERO(&EfficiencyCpus);
+        for (int32_t Cpu : Efficient)
+        {
+            if (Cpu < CPU_SETSIZE && CPU_ISSET(Cpu, &AllCpus)) CPU_SET(Cpu, &EfficiencyCpus);
+        }
+        EfficiencyCpuCount = CPU_COUNT(&EfficiencyCpus);
+        if (Settings.bUseCgroup) Cgroup = FindOwnCgroup();
+    }
+
+    FQosBackend MakeBackend()
+    {
+        FQosBackend Backend;
+        Backend.GetCurrentThreadId = &GetLinuxThreadId;
+        Backend.ApplyThread = [this](uint64_t Thread, EQosLevel Level, bool bEfficiencyCores, bool bEscalatable)
+        {
+            return ApplyThread(Thread, Level, bEfficiencyCores, bEscalatable);
+        };
+        Backend.ApplyProcess = [this](EQosLevel Level) { return ApplyProcess(Level); };
+        return Backend;
+    }
+
+    bool ApplyThread(uint64_t Thread, EQosLevel Level, bool bEfficiencyCores, bool bEscalatable) const
+    {
+        pid_t Id = static_cast<pid_t>(Thread);
+        // What cannot be undone is only done to threads that will never be raised again.
+        bool bIrreversibleOk = bCanRaise || !bEscalatable;
+        int Policy = SCHED_OTHER;
+        int32_t Nice = ProcessNice;
+        if (Level == EQosLevel::Idle) Policy = bIrreversibleOk ? SCHED_IDLE : SCHED_BATCH;
+        else if (Level == EQosLevel::Background)
+        {
+            if (bIrreversibleOk) Nice = ProcessNice > Settings.BackgroundNice ? ProcessNice : Settings.BackgroundNice;
+            else Policy = SCHED_BATCH;
+        }
+
+        sched_param Param {};
+        bool bOk = sched_setscheduler(Id, Policy, &Param) == 0;
+        // SCHED_IDLE ignores the nice value; it is left where it was.
+        if (Policy != SCHED_IDLE && getpriority(PRIO_PROCESS, static_cast<id_t>(Id)) != Nice)
+        {
+            bOk &= setpriority(PRIO_PROCESS, static_cast<id_t>(Id), Nice) == 0;
+        }
+        bool bPin = bEfficiencyCores && Level != EQosLevel::Normal && EfficiencyCpuCount > 0;
+        bOk &= sched_setaffinity(Id, sizeof(cpu_set_t), bPin ? &EfficiencyCpus : &AllCpus) == 0;
+        return bOk;
+    }
+
+    /** The cgroup's weight, if the process has one to itself; true when there is none. */
+    bool ApplyProcess(EQosLevel Level) const
+    {
+        if (Cgroup.empty()) return true;
+        const char* Weight = Level == EQosLevel::Normal ? "100" : "20";
+        bool bOk = static_cast<bool>(std::ofstream(Cgroup + "/cpu.weight") << Weight);
+        // cpu.idle needs Linux 5.15; older kernels only get the weight.
+        std::ofstream Idle(Cgroup + "/cpu.idle");
+        if (Idle) Idle << (Level == EQosLevel::Idle ? "1" : "0");
+        return bOk;
+    }
+
+    bool CanRaise() const { return bCanRaise; }
+    int32_t GetEfficiencyCpuCount() const { return EfficiencyCpuCount; }
+    const std::string& GetCgroup() const { return Cgroup; }
+
+    /** One line for logs: what the levels turn into on this machine. */
+    std::string Describe() const
+    {
+        std::ostringstream Text;
+        Text << (bCanRaise ? "SCHED_IDLE and nice" : "SCHED_BATCH (priority cannot be raised back)")
+            << ", " << EfficiencyCpuCount << " efficiency core(s), cgroup " << (Cgroup.empty() ? "shared" : Cgroup);
+        return Text.str();
+    }
+
+private:
+    FLinuxQosSettings Settings;
+    int32_t ProcessNice = 0;
+    bool bCanRaise = false;
+    cpu_set_t AllCpus;
+    cpu_set_t EfficiencyCpus;
+    int32_t EfficiencyCpuCount = 0;
+    std::string Cgroup;
+};
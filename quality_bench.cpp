@@ -0,0 +1,293 @@
+// quality_bench - Quality controller simulation against machine load traces.
+// A simulated presenter shows frames at --fps; each shown frame costs decode,
+// convert and scale/present time that shrinks with the quality level's frame
+// stride and resolution shift (PresenterQualityLevels), stretched by the share
+// of the CPU other work takes in that half-second window. The controller sees
+// what the real pipeline reports - frames due, frames dropped, compose time per
+// shown frame and the budget - and its decisions feed back into the next window.
+// Scripted traces check that an idle machine never steps down, that isolated
+// spikes and pauses do not move it, that sustained overload settles on the first
+// level that fits without climbing back, that a burst is left and recovered from,
+// and that a marginal machine oscillates far less with backoff than without.
+// --trace replays a recorded trace instead (one CPU share taken by other work,
+// 0 to 1, per line and half-second window).
+//   g++ -std=c++20 -O2 -pthread quality_bench.cpp -o quality_bench
+//   quality_bench [--fps N] [--work-ms N] [--minutes N] [--trace FILE]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "quality_controller.h"
+#include "software_pipeline.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    /** The controller is fed from the UI thread's update timer. */
+    constexpr double WindowSeconds = 0.5;
+
+    struct FBenchOptions
+    {
+        int32_t Fps = 30;
+        double WorkMs = 0.0;        // --trace only: CPU time per frame at full quality on an idle machine
+        int32_t Minutes = 60;
+        std::string TracePath;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--fps") Options.Fps = std::atoi(Value);
+            else if (Name == "--work-ms") Options.WorkMs = std::atof(Value);
+            else if (Name == "--minutes") Options.Minutes = std::atoi(Value);
+            else if (Name == "--trace") Options.TracePath = Value;
+            else return false;
+        }
+        return Options.Fps > 0 && Options.WorkMs >= 0.0 && Options.Minutes > 0;
+    }
+
+    /** Per-frame cost at full quality on an idle machine, split by stage. */
+    struct FMachine
+    {
+        int32_t Fps = 30;
+        double DecodeMs = 3.0;      // Paid for every decoded frame, shown or not
+        double ConvertMs = 3.0;     // Quartered at half resolution
+        double ComposeMs = 4.0;     // Scale, hash and present: the output size does not change
+        double NoiseRatio = 0.1;    // Per-window jitter of every stage
+
+        static FMachine FromWorkMs(int32_t Fps, double WorkMs)
+        {
+            FMachine Machine;
+            Machine.Fps = Fps;
+            Machine.DecodeMs = WorkMs * 0.3;
+            Machine.ConvertMs = WorkMs * 0.3;
+            Machine.ComposeMs = WorkMs * 0.4;
+            return Machine;
+        }
+    };
+
+    struct FRunResult
+    {
+        std::vector<int32_t> Levels;        // Level in effect during each window
+        uint32_t StepDowns = 0;
+        uint32_t StepUps = 0;
+        uint64_t FramesDue = 0;
+        uint64_t FramesDropped = 0;
+        int32_t FirstStepDown = -1;
+        int32_t LastStepUp = -1;
+
+        int32_t FinalLevel() const { return Levels.empty() ? 0 : Levels.back(); }
+        double DropRate() const { return FramesDue ? static_cast<double>(FramesDropped) / FramesDue : 0.0; }
+    };
+
+    /** Busy < 0 marks a paused window: nothing is due. */
+    FRunResult Run(const FMachine& Machine, const std::vector<double>& Busy, const FQualitySettings& Settings = {}, uint32_t Seed = 1)
+    {
+        FQualitySettings LevelSettings = Settings;
+        LevelSettings.LevelCount = static_cast<int32_t>(std::size(PresenterQualityLevels));
+        FQualityController Controller(LevelSettings);
+        std::mt19937 Random(Seed);
+        std::uniform_real_distribution<double> Noise(1.0 - Machine.NoiseRatio, 1.0 + Machine.NoiseRatio);
+
+        FRunResult Result;
+        double FrameMs = 1000.0 / Machine.Fps;
+        for (size_t Window = 0; Window < Busy.size(); ++Window)
+        {
+            const FPresenterQuality& Quality = PresenterQualityLevels[Controller.GetLevel()];
+            Result.Levels.push_back(Controller.GetLevel());
+            FQualitySample Sample;
+            if (Busy[Window] >= 0.0)
+            {
+                double Stretch = 1.0 / (1.0 - (Busy[Window] < 0.95 ? Busy[Window] : 0.95));
+                double ComposeMs = (Machine.ConvertMs / (1 << (2 * Quality.ResolutionShift)) + Machine.ComposeMs) * Stretch * Noise(Random);
+                double ShownMs = Quality.FrameStride * Machine.DecodeMs * Stretch * Noise(Random) + ComposeMs;
+                double BudgetMs = Quality.FrameStride * FrameMs;
+
+                // A presenter that needs longer than the budget per frame shows only the frames it keeps up with.
+                Sample.FramesDue = static_cast<uint32_t>(WindowSeconds * Machine.Fps / Quality.FrameStride + 0.5);
+                double Shown = ShownMs > BudgetMs ? Sample.FramesDue * BudgetMs / ShownMs : Sample.FramesDue;
+                Sample.FramesDropped = Sample.FramesDue - static_cast<uint32_t>(Shown);
+                Sample.WorkNs = static_cast<int64_t>(ComposeMs * 1e6);
+                Sample.BudgetNs = static_cast<int64_t>(BudgetMs * 1e6);
+                Result.FramesDue += Sample.FramesDue;
+                Result.FramesDropped += Sample.FramesDropped;
+            }
+
+            FQualityDecision Decision = Controller.Update(Sample);
+            if (Decision.Action == EQualityAction::StepDown && Result.FirstStepDown < 0) Result.FirstStepDown = static_cast<int32_t>(Window);
+            if (Decision.Action == EQualityAction::StepUp) Result.LastStepUp = static_cast<int32_t>(Window);
+        }
+        Result.StepDowns = Controller.GetStepDowns();
+        Result.StepUps = Controller.GetStepUps();
+        return Result;
+    }
+
+    void Print(const char* Name, const FRunResult& Result)
+    {
+        size_t Windows = Result.Levels.size();
+        std::vector<size_t> AtLevel(std::size(PresenterQualityLevels), 0);
+        for (int32_t Level : Result.Levels) ++AtLevel[static_cast<size_t>(Level)];
+        std::printf("%-12s %6zu %5d %5u %5u %7.2f%%", Name, Windows, Result.FinalLevel(), Result.StepDowns, Result.StepUps, Result.DropRate() * 100);
+        for (size_t Count : AtLevel) std::printf(" %6.1f%%", Windows ? 100.0 * Count / Windows : 0.0);
+        std::printf("\n");
+    }
+
+    std::vector<double> Constant(size_t Windows, double Busy)
+    {
+        return std::vector<double>(Windows, Busy);
+    }
+
+    bool CheckTraces(const FBenchOptions& Options)
+    {
+        bool bPass = true;
+        size_t Hour = static_cast<size_t>(Options.Minutes * 60 / WindowSeconds);
+        std::printf("%-12s %6s %5s %5s %5s %8s", "trace", "windows", "final", "downs", "ups", "dropped");
+        for (const FPresenterQuality& Quality : PresenterQualityLevels) std::printf("  L%-5td", &Quality - PresenterQualityLevels);
+        std::printf("\n");
+
+        // A light video on a quiet machine.
+        FMachine Light = FMachine::FromWorkMs(Options.Fps, 10.0);
+        FRunResult Idle = Run(Light, Constant(Hour, 0.05));
+        Print("idle", Idle);
+        bPass &= Check(Idle.StepDowns == 0 && Idle.DropRate() == 0.0, "idle machine stays at full quality");
+
+        // Every fifth window overloaded by a background spike.
+        std::vector<double> Spikes = Constant(Hour, 0.05);
+        for (size_t Window = 0; Window < Spikes.size(); Window += 5) Spikes[Window] = 0.9;
+        FRunResult Spiky = Run(Light, Spikes);
+        Print("spikes", Spiky);
+        bPass &= Check(Spiky.StepDowns == 0, "isolated spikes do not step down");
+
+        // A video too heavy for full quality: settle on the first level that fits and stay there.
+        FMachine Heavy = FMachine::FromWorkMs(Options.Fps, 42.0 * 30 / Options.Fps);
+        FRunResult Overloaded = Run(Heavy, Constant(Hour, 0.05));
+        Print("overloaded", Overloaded);
+        bPass &= Check(Overloaded.FirstStepDown >= 0 && Overloaded.FirstStepDown < 4, "sustained overload steps down at once");
+        bPass &= Check(Overloaded.FinalLevel() == 1 && Overloaded.StepDowns == 1 && Overloaded.StepUps == 0,
+            "sustained overload settles without climbing back");
+        bPass &= Check(Overloaded.DropRate() < 0.01, "settled playback drops (almost) nothing");
+
+        // A 30-second burst of background work, then quiet again.
+        std::vector<double> Burst = Constant(Hour, 0.05);
+        size_t BurstStart = 120, BurstEnd = BurstStart + static_cast<size_t>(30 / WindowSeconds);
+        for (size_t Window = BurstStart; Window < BurstEnd; ++Window) Burst[Window] = 0.85;
+        FMachine Medium = FMachine::FromWorkMs(Options.Fps, 20.0 * 30 / Options.Fps);
+        FRunResult Bursty = Run(Medium, Burst);
+        Print("burst", Bursty);
+        bPass &= Check(Bursty.FirstStepDown >= static_cast<int32_t>(BurstStart) && Bursty.FirstStepDown < static_cast<int32_t>(BurstStart) + 3,
+            "burst steps down within two windows");
+        bPass &= Check(Bursty.Levels[BurstEnd - 1] > 0, "quality stays down during the burst");
+        bPass &= Check(Bursty.FinalLevel() == 0 && Bursty.LastStepUp > static_cast<int32_t>(BurstEnd)
+            && Bursty.LastStepUp < static_cast<int32_t>(BurstEnd) + 120, "full quality back within a minute of the burst");
+
+        // Pauses in the middle of an overload streak neither finish nor reset it.
+        std::vector<double> Paused = Constant(Hour, 0.05);
+        Paused[100] = 0.9;
+        for (size_t Window = 101; Window < 200; ++Window) Paused[Window] = -1.0;
+        Paused[200] = 0.9;
+        FRunResult Resumed = Run(Light, Paused);
+        Print("paused", Resumed);
+        bPass &= Check(Resumed.FirstStepDown == 200, "a pause keeps the overload streak");
+
+        // Just too heavy for full quality, light enough at half rate: without backoff it flaps all hour.
+        FMachine Marginal = FMachine::FromWorkMs(Options.Fps, 32.0 * 30 / Options.Fps);
+        std::vector<double> Wobble(Hour);
+        std::mt19937 Random(9);
+        for (double& Busy : Wobble) Busy = 0.02 + 0.08 * (Random() % 1000) / 1000.0;
+        FRunResult Backoff = Run(Marginal, Wobble);
+        Print("marginal", Backoff);
+        FQualitySettings NoBackoff;
+        NoBackoff.MaxBackoffShift = 0;
+        FRunResult Flapping = Run(Marginal, Wobble, NoBackoff);
+        Print("no backoff", Flapping);
+        bPass &= Check(Flapping.StepUps > 50, "marginal machine is marginal");
+        bPass &= Check(Backoff.StepUps * 5 < Flapping.StepUps, "backoff settles a marginal machine");
+        bPass &= Check(Backoff.DropRate() < Flapping.DropRate(), "settling drops fewer frames");
+        return bPass;
+    }
+
+    bool CheckBackoff()
+    {
+        FQualitySettings Settings;
+        FQualityController Controller(Settings);
+        FQualitySample Overload{ 15, 5, 30000000, 33000000 };
+        FQualitySample Headroom{ 15, 0, 5000000, 33000000 };
+        auto Feed = [&](const FQualitySample& Sample, int32_t Windows)
+        {
+            for (int32_t Window = 0; Window < Windows; ++Window) Controller.Update(Sample);
+        };
+
+        bool bPass = true;
+        Feed(Overload, Settings.StepDownWindows);
+        bPass &= Check(Controller.GetLevel() == 1, "two overloaded windows step down");
+        Feed(Headroom, Settings.StepUpWindows);
+        bPass &= Check(Controller.GetLevel() == 0, "ten headroom windows step up");
+        for (int32_t Attempt = 1; Attempt <= Settings.MaxBackoffShift + 2; ++Attempt)
+        {
+            Feed(Overload, Settings.StepDownWindows);
+            int32_t Expected = Settings.StepUpWindows << (Attempt < Settings.MaxBackoffShift ? Attempt : Settings.MaxBackoffShift);
+            bPass &= Check(Controller.GetStepUpWindows(0) == Expected, "each failed step up doubles the wait, up to the cap");
+            Feed(Headroom, Expected - 1);
+            bPass &= Check(Controller.GetLevel() == 1, "no step up before the wait");
+            Feed(Headroom, 1);
+        }
+        bPass &= Check(Controller.GetLevel() == 0, "step up after the wait");
+
+        // Holding long enough clears nothing, but an overload later is not blamed on the step up.
+        Feed(Headroom, Settings.StepUpWindows + 1);
+        Feed(Overload, Settings.StepDownWindows);
+        bPass &= Check(Controller.GetStepUpWindows(0) == Settings.StepUpWindows << Settings.MaxBackoffShift, "later overload leaves the backoff");
+        Feed(Overload, 100);
+        bPass &= Check(Controller.GetLevel() == static_cast<int32_t>(Settings.LevelCount) - 1, "never below the cheapest level");
+        return bPass;
+    }
+
+    bool ReplayTrace(const FBenchOptions& Options)
+    {
+        std::ifstream File(Options.TracePath);
+        if (!File)
+        {
+            std::printf("cannot read %s\n", Options.TracePath.c_str());
+            return false;
+        }
+        std::vector<double> Busy;
+        for (double Value = 0.0; File >> Value;) Busy.push_back(Value);
+        FMachine Machine = FMachine::FromWorkMs(Options.Fps, Options.WorkMs > 0.0 ? Options.WorkMs : 20.0);
+        FRunResult Result = Run(Machine, Busy);
+        Print("replay", Result);
+        return true;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: quality_bench [--fps N] [--work-ms N] [--minutes N] [--trace FILE]\n");
+        return 2;
+    }
+    if (!Options.TracePath.empty()) return ReplayTrace(Options) ? 0 : 1;
+
+    bool bPass = Check(CheckBackoff(), "backoff");
+    bPass &= Check(CheckTraces(Options), "traces");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
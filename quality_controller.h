@@ -0,0 +1,147 @@
+// QualityController - Closed-loop playback quality under machine load.
+// Each measurement window (frames due, frames dropped, work time per shown frame
+// against the frame budget) is classified as overloaded, steady or with headroom.
+// Sustained overload steps quality down one level; sustained headroom steps it
+// back up. Stepping up needs a much longer streak than stepping down, and a level
+// that has to be abandoned soon after it was re-entered waits twice as long
+// before the next attempt, so a marginal machine settles instead of oscillating.
+// Pure logic with no clock or platform dependency: callers feed measurements, so
+// recorded load traces can be replayed through it.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** One measurement window. */
+struct FQualitySample
+{
+    uint32_t FramesDue = 0;         // Frames that should have been shown at the current level
+    uint32_t FramesDropped = 0;     // ...of which were skipped for being late
+    int64_t WorkNs = 0;             // Mean decode + compose + present time per shown frame
+    int64_t BudgetNs = 0;           // Time available per shown frame at the current level
+};
+
+struct FQualitySettings
+{
+    int32_t LevelCount = 4;         // Level 0 is full quality, LevelCount - 1 the cheapest
+    double MaxDropRate = 0.05;      // More drops than this is overload
+    double OverloadRatio = 0.9;     // WorkNs / BudgetNs above this is overload
+    double HeadroomRatio = 0.4;     // ...below this, with (almost) no drops, is headroom
+    int32_t StepDownWindows = 2;    // Consecutive overloaded windows before stepping down
+    int32_t StepUpWindows = 10;     // Consecutive headroom windows before stepping up
+    int32_t MaxBackoffShift = 4;    // Step-up streak grows to at most StepUpWindows << 4
+};
+
+enum class EQualityAction : uint8_t
+{
+    Hold,
+    StepDown,
+    StepUp
+};
+
+enum class EQualityVerdict : uint8_t
+{
+    Idle,           // Nothing was due (paused); streaks are left untouched
+    Overloaded,
+    Steady,
+    Headroom
+};
+
+struct FQualityDecision
+{
+    EQualityAction Action = EQualityAction::Hold;
+    EQualityVerdict Verdict = EQualityVerdict::Idle;
+    int32_t Level = 0;              // Level after this decision
+    double DropRate = 0.0;
+    double Load = 0.0;              // WorkNs / BudgetNs
+};
+
+class FQualityController
+{
+public:
+    explicit FQualityController(const FQualitySettings& InSettings = {}) { Reset(InSettings); }
+
+    void Reset(const FQualitySettings& InSettings)
+    {
+        Settings = InSettings;
+        if (Settings.LevelCount < 1) Settings.LevelCount = 1;
+        Backoff.assign(static_cast<size_t>(Settings.LevelCount), 0);
+        Level = 0;
+        OverloadStreak = 0;
+        HeadroomStreak = 0;
+        WindowsSinceStepUp = -1;
+        StepDowns = 0;
+        StepUps = 0;
+    }
+
+    FQualityDecision Update(const FQualitySample& Sample)
+    {
+        FQualityDecision Decision;
+        Decision.Level = Level;
+        if (!Sample.FramesDue) return Decision;
+
+        Decision.DropRate = static_cast<double>(Sample.FramesDropped) / Sample.FramesDue;
+        Decision.Load = Sample.BudgetNs > 0 ? static_cast<double>(Sample.WorkNs) / Sample.BudgetNs : 0.0;
+        if (Decision.DropRate > Settings.MaxDropRate || Decision.Load > Settings.OverloadRatio)
+        {
+            Decision.Verdict = EQualityVerdict::Overloaded;
+        }
+        else if (Decision.DropRate <= Settings.MaxDropRate * 0.25 && Decision.Load < Settings.HeadroomRatio)
+        {
+            Decision.Verdict = EQualityVerdict::Headroom;
+        }
+        else Decision.Verdict = EQualityVerdict::Steady;
+
+        if (WindowsSinceStepUp >= 0) ++WindowsSinceStepUp;
+        OverloadStreak = Decision.Verdict == EQualityVerdict::Overloaded ? OverloadStreak + 1 : 0;
+        HeadroomStreak = Decision.Verdict == EQualityVerdict::Headroom ? HeadroomStreak + 1 : 0;
+
+        if (OverloadStreak >= Settings.StepDownWindows && Level + 1 < Settings.LevelCount)
+        {
+            // The level we stepped up into did not hold: try it less eagerly next time.
+            if (WindowsSinceStepUp >= 0 && WindowsSinceStepUp <= Settings.StepUpWindows)
+            {
+                int32_t& Shift = Backoff[static_cast<size_t>(Level)];
+                if (Shift < Settings.MaxBackoffShift) ++Shift;
+            }
+            ++Level;
+            ++StepDowns;
+            OverloadStreak = 0;
+            WindowsSinceStepUp = -1;
+            Decision.Action = EQualityAction::StepDown;
+        }
+        else if (Level > 0 && HeadroomStreak >= GetStepUpWindows(Level - 1))
+        {
+            --Level;
+            ++StepUps;
+            HeadroomStreak = 0;
+            WindowsSinceStepUp = 0;
+            Decision.Action = EQualityAction::StepUp;
+        }
+        Decision.Level = Level;
+        return Decision;
+    }
+
+    int32_t GetLevel() const { return Level; }
+    uint32_t GetStepDowns() const { return StepDowns; }
+    uint32_t GetStepUps() const { return StepUps; }
+
+    /** Headroom windows needed before re-entering TargetLevel from the level below it. */
+    int32_t GetStepUpWindows(int32_t TargetLevel) const
+    {
+        return Settings.StepUpWindows << Backoff[static_cast<size_t>(TargetLevel)];
+    }
+
+private:
+    FQualitySettings Settings;
+    std::vector<int32_t> Backoff;   // Per level: left-shift applied to StepUpWindows
+    int32_t Level = 0;
+    int32_t OverloadStreak = 0;
+    int32_t HeadroomStreak = 0;
+    int32_t WindowsSinceStepUp = -1;
+    uint32_t StepDowns = 0;
+    uint32_t StepUps = 0;
+};
@@ -0,0 +1,129 @@
+// Rendition - Picks which encode of a wallpaper each monitor decodes.
+// A wallpaper may ship in several encodes next to the configured file, told apart
+// by a file name suffix: "ocean.mp4" with "ocean_1440p.mp4" and "ocean_1080p.mp4".
+// Each monitor decodes the smallest encode that still covers its physical pixels,
+// so a 1080p panel no longer decodes the 4K file for the renderer to throw three
+// quarters of it away. The configured file is the master: it plays wherever no
+// smaller encode covers. Monitors that resolve to the same encode form a group
+// that one decoder can serve.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "span_layout.h"
+
+/** One extra encode of the wallpaper: its frame size and the suffix its file name carries. */
+template <typename TString>
+struct TRendition
+{
+    int32_t Width = 0;
+    int32_t Height = 0;
+    TString Suffix;     // Inserted before the extension: "_1080p" turns "ocean.mp4" into "ocean_1080p.mp4"
+};
+
+/** Master: the configured file itself, used when no rendition covers. */
+inline constexpr int32_t MasterRendition = -1;
+
+/** Parses "1920x1080 _1080p"; false if the size or the suffix is missing. */
+template <typename TString>
+bool ParseRendition(const TString& Text, TRendition<TString>& Out)
+{
+    size_t Index = 0;
+    auto ReadNumber = [&](int32_t& Value)
+    {
+        size_t Start = Index;
+        Value = 0;
+        while (Index < Text.size() && Text[Index] >= '0' && Text[Index] <= '9' && Value < 100000)
+        {
+            Value = Value * 10 + static_cast<int32_t>(Text[Index++] - '0');
+        }
+        return Index > Start && Value > 0;
+    };
+    if (!ReadNumber(Out.Width) || Index >= Text.size() || (Text[Index] != 'x' && Text[Index] != 'X')) return false;
+    ++Index;
+    if (!ReadNumber(Out.Height)) return false;
+    while (Index < Text.size() && (Text[Index] == ' ' || Text[Index] == '\t')) ++Index;
+    Out.Suffix = Text.substr(Index);
+    while (!Out.Suffix.empty() && (Out.Suffix.back() == ' ' || Out.Suffix.back() == '\t')) Out.Suffix.pop_back();
+    return !Out.Suffix.empty();
+}
+
+/** The rendition's file: the suffix goes before the master's extension, or at the end if it has none. */
+template <typename TString>
+TString GetRenditionPath(const TString& MasterPath, const TString& Suffix)
+{
+    const typename TString::value_type Separators[] = { '/', '\\', 0 };
+    size_t Dot = MasterPath.find_last_of('.');
+    size_t Separator = MasterPath.find_last_of(Separators);
+    if (Dot == TString::npos || (Separator != TString::npos && Dot < Separator)) return MasterPath + Suffix;
+    return MasterPath.substr(0, Dot) + Suffix + MasterPath.substr(Dot);
+}
+
+/**
+ * Index of the smallest rendition, by area, at least Width x Height, or MasterRendition
+ * if none is. Both sides must cover: stretched and cover-fitted frames alike are then
+ * only ever scaled down, never up.
+ */
+template <typename TString>
+int32_t SelectRendition(const std::vector<TRendition<TString>>& Renditions, int32_t Width, int32_t Height)
+{
+    int32_t Best = MasterRendition;
+    int64_t BestArea = 0;
+    for (size_t Index = 0; Index < Renditions.size(); ++Index)
+    {
+        const auto& Rendition = Renditions[Index];
+        if (Rendition.Width < Width || Rendition.Height < Height) continue;
+        int64_t Area = static_cast<int64_t>(Rendition.Width) * Rendition.Height;
+        if (Best != MasterRendition && Area >= BestArea) continue;
+        Best = static_cast<int32_t>(Index);
+        BestArea = Area;
+    }
+    return Best;
+}
+
+/**
+ * Rendition per monitor, from physical monitor rects. In span mode each monitor shows
+ * its slice of one frame laid over the bezel-expanded canvas, so every monitor needs
+ * the encode that covers the whole canvas, and they all land in one group.
+ */
+template <typename TString>
+std::vector<int32_t> SelectMonitorRenditions
+(
+    const std::vector<TRendition<TString>>& Renditions, const std::vector<FIntRect>& MonitorRects,
+    bool bSpanMode, const FSpanSettings& Span
+)
+{
+    std::vector<int32_t> Selection;
+    FSpanLayout Layout;
+    if (bSpanMode) Layout.Build(MonitorRects, Span);
+    for (const FIntRect& Rect : MonitorRects)
+    {
+        const FIntRect& Covered = bSpanMode ? Layout.GetCanvas() : Rect;
+        Selection.push_back(SelectRendition(Renditions, Covered.Width(), Covered.Height()));
+    }
+    return Selection;
+}
+
+/** Monitors that decode the same encode. */
+struct FRenditionGroup
+{
+    int32_t Rendition = MasterRendition;
+    std::vector<size_t> Monitors;
+};
+
+/** One group per distinct rendition in Selection, in order of first appearance. */
+inline std::vector<FRenditionGroup> GroupMonitorsByRendition(const std::vector<int32_t>& Selection)
+{
+    std::vector<FRenditionGroup> Groups;
+    for (size_t Monitor = 0; Monitor < Selection.size(); ++Monitor)
+    {
+        size_t Group = 0;
+        while (Group < Groups.size() && Groups[Group].Rendition != Selection[Monitor]) ++Group;
+        if (Group == Groups.size()) Groups.push_back({ Selection[Monitor], {} });
+        Groups[Group].Monitors.push_back(Monitor);
+    }
+    return Groups;
+}
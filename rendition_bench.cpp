@@ -0,0 +1,194 @@
+// rendition_bench - Checks which encode each monitor of a layout picks.
+// A wallpaper shipped as a 4K master with 1440p and 1080p renditions is matched
+// against monitor layouts: single panels, portrait panels, mixed multi-monitor
+// desktops and span mode across bezels. Every monitor must get the smallest
+// encode that covers it on both axes (the master when none does), monitors on the
+// same encode must form one group, and span mode must put every monitor on the
+// encode covering the whole canvas. Rendition lines and file names are parsed as
+// the config does. Then prints, per layout, the pixels decoded per frame with one
+// decoder per monitor, master only versus per-monitor renditions.
+//   g++ -std=c++20 -O2 -pthread rendition_bench.cpp -o rendition_bench
+//   rendition_bench
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "rendition.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    using FRendition = TRendition<std::string>;
+
+    constexpr int32_t MasterWidth = 3840;
+    constexpr int32_t MasterHeight = 2160;
+
+    /** Declared largest first on purpose: selection must not depend on the order. */
+    const std::vector<FRendition> Renditions =
+    {
+        { 2560, 1440, "_1440p" },
+        { 1920, 1080, "_1080p" },
+    };
+    constexpr int32_t R1440 = 0;
+    constexpr int32_t R1080 = 1;
+
+    struct FLayoutCase
+    {
+        const char* Name;
+        std::vector<FIntRect> Monitors;
+        bool bSpanMode;
+        FSpanSettings Span;
+        std::vector<int32_t> Expected;
+        size_t ExpectedGroups;
+    };
+
+    FIntRect At(int32_t Left, int32_t Top, int32_t Width, int32_t Height)
+    {
+        return { Left, Top, Left + Width, Top + Height };
+    }
+
+    std::vector<FLayoutCase> BuildCases()
+    {
+        FSpanSettings NoBezel;
+        FSpanSettings Bezel;
+        Bezel.BezelX = 40;
+        Bezel.BezelY = 40;
+        return
+        {
+            { "1080p laptop", { At(0, 0, 1920, 1080) }, false, NoBezel, { R1080 }, 1 },
+            { "1440p monitor", { At(0, 0, 2560, 1440) }, false, NoBezel, { R1440 }, 1 },
+            { "4K monitor", { At(0, 0, 3840, 2160) }, false, NoBezel, { MasterRendition }, 1 },
+            { "720p panel", { At(0, 0, 1280, 720) }, false, NoBezel, { R1080 }, 1 },
+            { "1920x1200 monitor", { At(0, 0, 1920, 1200) }, false, NoBezel, { R1440 }, 1 },
+            { "ultrawide 3440x1440", { At(0, 0, 3440, 1440) }, false, NoBezel, { MasterRendition }, 1 },
+            { "portrait 1080x1920", { At(0, 0, 1080, 1920) }, false, NoBezel, { MasterRendition }, 1 },
+            {
+                "4K + 1440p + 1080p", { At(0, 0, 3840, 2160), At(3840, 0, 2560, 1440), At(-1920, 0, 1920, 1080) },
+                false, NoBezel, { MasterRendition, R1440, R1080 }, 3
+            },
+            {
+                "two 1080p + 1440p", { At(0, 0, 1920, 1080), At(1920, 0, 1920, 1080), At(0, 1080, 2560, 1440) },
+                false, NoBezel, { R1080, R1080, R1440 }, 2
+            },
+            {
+                "span: two 720p", { At(0, 0, 1280, 720), At(1280, 0, 1280, 720) },
+                true, NoBezel, { R1440, R1440 }, 1
+            },
+            {
+                "span: two 720p, bezels", { At(0, 0, 1280, 720), At(1280, 0, 1280, 720) },
+                true, Bezel, { MasterRendition, MasterRendition }, 1
+            },
+            {
+                "span: 2x2 960x540", { At(0, 0, 960, 540), At(960, 0, 960, 540), At(0, 540, 960, 540), At(960, 540, 960, 540) },
+                true, NoBezel, { R1080, R1080, R1080, R1080 }, 1
+            },
+            {
+                "span: two 1080p", { At(0, 0, 1920, 1080), At(1920, 0, 1920, 1080) },
+                true, NoBezel, { MasterRendition, MasterRendition }, 1
+            },
+        };
+    }
+
+    int64_t GetRenditionPixels(int32_t Rendition)
+    {
+        if (Rendition == MasterRendition) return static_cast<int64_t>(MasterWidth) * MasterHeight;
+        return static_cast<int64_t>(Renditions[Rendition].Width) * Renditions[Rendition].Height;
+    }
+
+    bool CheckLayouts()
+    {
+        bool bPass = true;
+        std::printf("%-24s %8s %14s %14s\n", "layout", "encodes", "master MP/fr", "picked MP/fr");
+        for (const FLayoutCase& Case : BuildCases())
+        {
+            std::vector<int32_t> Selection = SelectMonitorRenditions(Renditions, Case.Monitors, Case.bSpanMode, Case.Span);
+            std::vector<FRenditionGroup> Groups = GroupMonitorsByRendition(Selection);
+            bool bCase = Selection == Case.Expected && Groups.size() == Case.ExpectedGroups;
+
+            size_t Grouped = 0;
+            for (const FRenditionGroup& Group : Groups)
+            {
+                Grouped += Group.Monitors.size();
+                for (size_t Monitor : Group.Monitors) bCase &= Selection[Monitor] == Group.Rendition;
+            }
+            bCase &= Grouped == Case.Monitors.size();
+            if (!bCase) std::printf("FAIL: layout '%s'\n", Case.Name);
+            bPass &= bCase;
+
+            int64_t MasterPixels = 0;
+            int64_t PickedPixels = 0;
+            for (int32_t Rendition : Selection)
+            {
+                MasterPixels += GetRenditionPixels(MasterRendition);
+                PickedPixels += GetRenditionPixels(Rendition);
+            }
+            std::printf
+            (
+                "%-24s %8zu %14.1f %14.1f\n", Case.Name, Groups.size(),
+                MasterPixels / 1000000.0, PickedPixels / 1000000.0
+            );
+        }
+        return bPass;
+    }
+
+    bool CheckSelectionEdges()
+    {
+        bool bPass = Check(SelectRendition(std::vector<FRendition>{}, 640, 480) == MasterRendition, "no renditions: master");
+        bPass &= Check(SelectRendition(Renditions, 1920, 1080) == R1080, "exact size covers");
+        bPass &= Check(SelectRendition(Renditions, 1921, 1080) == R1440, "one pixel over takes the next encode");
+        bPass &= Check(SelectRendition(Renditions, 0, 0) == R1080, "empty monitor takes the smallest");
+
+        std::vector<FRendition> Wide = { { 3840, 1080, "_wide" }, { 2560, 1440, "_1440p" } };
+        bPass &= Check(SelectRendition(Wide, 2000, 1000) == 1, "smallest by area, not by width");
+        return bPass;
+    }
+
+    bool CheckParsing()
+    {
+        FRendition Rendition;
+        bool bPass = Check(ParseRendition(std::string("1920x1080 _1080p"), Rendition), "parse size and suffix");
+        bPass &= Check(Rendition.Width == 1920 && Rendition.Height == 1080 && Rendition.Suffix == "_1080p", "parsed values");
+        bPass &= Check(ParseRendition(std::string("2560X1440\t-qhd "), Rendition) && Rendition.Suffix == "-qhd", "tabs, X, trailing space");
+        bPass &= Check(!ParseRendition(std::string("1920x1080"), Rendition), "missing suffix rejected");
+        bPass &= Check(!ParseRendition(std::string("1920x _1080p"), Rendition), "missing height rejected");
+        bPass &= Check(!ParseRendition(std::string("0x1080 _a"), Rendition), "zero width rejected");
+        bPass &= Check(!ParseRendition(std::string("wide _a"), Rendition), "no size rejected");
+
+        TRendition<std::wstring> WideRendition;
+        bPass &= Check(ParseRendition(std::wstring(L"1280x720 _720p"), WideRendition), "wide string parse");
+        bPass &= Check(WideRendition.Width == 1280 && WideRendition.Suffix == L"_720p", "wide string values");
+
+        bPass &= Check(GetRenditionPath(std::string("/v/ocean.mp4"), std::string("_1080p")) == "/v/ocean_1080p.mp4", "suffix before extension");
+        bPass &= Check(GetRenditionPath(std::string("/v.d/ocean"), std::string("_1080p")) == "/v.d/ocean_1080p", "no extension: dot in a directory");
+        bPass &= Check
+        (
+            GetRenditionPath(std::wstring(L"C:\\Walls\\a.b.mkv"), std::wstring(L"_1440p")) == L"C:\\Walls\\a.b_1440p.mkv",
+            "last dot, backslashes"
+        );
+        return bPass;
+    }
+}
+
+int main(int Argc, char**)
+{
+    if (Argc > 1)
+    {
+        std::fprintf(stderr, "usage: rendition_bench\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckLayouts(), "monitor layouts");
+    bPass &= Check(CheckSelectionEdges(), "selection edges");
+    bPass &= Check(CheckParsing(), "parsing");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
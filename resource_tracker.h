@@ -0,0 +1,219 @@
+// ResourceTracker - Opt-in accounting of live resources per subsystem, for leak hunting.
+// Subsystems report what they acquire and release: COM references, windows, GDI
+// objects, kernel handles, heap bytes. Gauges carry totals sampled from the OS.
+// A snapshot taken after some cycle (a video switch, a display change) diffed
+// against one taken after the previous cycle shows exactly what was left behind.
+// Counters are lock-free; while disabled each call costs one relaxed load. Enable
+// before the resources it should see are created, or their releases go negative.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+enum class EResourceKind : uint8_t
+{
+    ComRef,     // Outstanding COM references (AddRef/Release pairs)
+    Window,
+    Gdi,        // GDI objects and device contexts
+    Handle,     // Kernel handles (events, threads, pipes)
+    HeapBytes,
+    Count
+};
+
+inline const char* GetResourceKindName(EResourceKind Kind)
+{
+    switch (Kind)
+    {
+    case EResourceKind::ComRef: return "com";
+    case EResourceKind::Window: return "window";
+    case EResourceKind::Gdi: return "gdi";
+    case EResourceKind::Handle: return "handle";
+    case EResourceKind::HeapBytes: return "heap";
+    default: return "?";
+    }
+}
+
+/** Distinct subsystem names; further names are folded into the last slot. */
+constexpr size_t MaxResourceSubsystems = 32;
+
+struct FResourceCount
+{
+    const char* Subsystem = nullptr;
+    EResourceKind Kind = EResourceKind::ComRef;
+    int64_t Live = 0;
+    int64_t Peak = 0;
+    uint64_t Acquired = 0;      // Total acquisitions (for gauges: samples)
+};
+
+using FResourceSnapshot = std::vector<FResourceCount>;
+
+struct FResourceDelta
+{
+    const char* Subsystem = nullptr;
+    EResourceKind Kind = EResourceKind::ComRef;
+    int64_t Before = 0;
+    int64_t After = 0;
+};
+
+class FResourceTracker
+{
+public:
+    FResourceTracker() = default;
+    FResourceTracker(const FResourceTracker&) = delete;
+    FResourceTracker& operator=(const FResourceTracker&) = delete;
+
+    void SetEnabled(bool bInEnabled) { bEnabled.store(bInEnabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+
+    /** Subsystem must point at a string with static storage duration. */
+    void Acquire(const char* Subsystem, EResourceKind Kind, int64_t Amount = 1)
+    {
+        if (!IsEnabled()) return;
+        FCounter& Counter = FindSlot(Subsystem).Counters[static_cast<size_t>(Kind)];
+        int64_t Live = Counter.Live.fetch_add(Amount, std::memory_order_relaxed) + Amount;
+        Counter.Acquired.fetch_add(1, std::memory_order_relaxed);
+        int64_t Peak = Counter.Peak.load(std::memory_order_relaxed);
+        while (Live > Peak && !Counter.Peak.compare_exchange_weak(Peak, Live, std::memory_order_relaxed)) {}
+    }
+
+    void Release(const char* Subsystem, EResourceKind Kind, int64_t Amount = 1)
+    {
+        if (!IsEnabled()) return;
+        FindSlot(Subsystem).Counters[static_cast<size_t>(Kind)].Live.fetch_sub(Amount, std::memory_order_relaxed);
+    }
+
+    /** Replaces the live value, for totals the OS reports (process handle count, private bytes). */
+    void SetGauge(const char* Subsystem, EResourceKind Kind, int64_t Value)
+    {
+        if (!IsEnabled()) return;
+        FCounter& Counter = FindSlot(Subsystem).Counters[static_cast<size_t>(Kind)];
+        Counter.Live.store(Value, std::memory_order_relaxed);
+        Counter.Acquired.fetch_add(1, std::memory_order_relaxed);
+        int64_t Peak = Counter.Peak.load(std::memory_order_relaxed);
+        while (Value > Peak && !Counter.Peak.compare_exchange_weak(Peak, Value, std::memory_order_relaxed)) {}
+    }
+
+    /** Every counter that has ever been touched, in registration order. */
+    FResourceSnapshot Snapshot() const
+    {
+        FResourceSnapshot Out;
+        for (const auto& Slot : Slots)
+        {
+            const char* Subsystem = Slot.Subsystem.load(std::memory_order_acquire);
+            if (!Subsystem) break;
+            for (size_t Kind = 0; Kind < static_cast<size_t>(EResourceKind::Count); ++Kind)
+            {
+                const FCounter& Counter = Slot.Counters[Kind];
+                uint64_t Acquired = Counter.Acquired.load(std::memory_order_relaxed);
+                if (!Acquired) continue;
+                FResourceCount Count;
+                Count.Subsystem = Subsystem;
+                Count.Kind = static_cast<EResourceKind>(Kind);
+                Count.Live = Counter.Live.load(std::memory_order_relaxed);
+                Count.Peak = Counter.Peak.load(std::memory_order_relaxed);
+                Count.Acquired = Acquired;
+                Out.push_back(Count);
+            }
+        }
+        return Out;
+    }
+
+    /** Zeroes every counter; registered subsystem names are kept. */
+    void Reset()
+    {
+        for (auto& Slot : Slots)
+        {
+            for (auto& Counter : Slot.Counters)
+            {
+                Counter.Live.store(0, std::memory_order_relaxed);
+                Counter.Peak.store(0, std::memory_order_relaxed);
+                Counter.Acquired.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct FCounter
+    {
+        std::atomic<int64_t> Live{ 0 };
+        std::atomic<int64_t> Peak{ 0 };
+        std::atomic<uint64_t> Acquired{ 0 };
+    };
+
+    struct FSlot
+    {
+        std::atomic<const char*> Subsystem{ nullptr };
+        FCounter Counters[static_cast<size_t>(EResourceKind::Count)];
+    };
+
+    /** Lock-free: a new name claims the first empty slot; racing claims for one name meet in the same slot. */
+    FSlot& FindSlot(const char* Subsystem)
+    {
+        for (auto& Slot : Slots)
+        {
+            const char* Current = Slot.Subsystem.load(std::memory_order_acquire);
+            if (!Current && Slot.Subsystem.compare_exchange_strong(Current, Subsystem, std::memory_order_acq_rel))
+            {
+                return Slot;
+            }
+            if (Current == Subsystem || std::strcmp(Current, Subsystem) == 0) return Slot;
+        }
+        return Slots[MaxResourceSubsystems - 1];
+    }
+
+    FSlot Slots[MaxResourceSubsystems];
+    std::atomic<bool> bEnabled{ false };
+};
+
+/** Counters whose live value differs between two snapshots (new counters count from zero). */
+inline std::vector<FResourceDelta> DiffResourceSnapshots(const FResourceSnapshot& Before, const FResourceSnapshot& After)
+{
+    std::vector<FResourceDelta> Out;
+    for (const auto& Count : After)
+    {
+        int64_t Previous = 0;
+        for (const auto& Old : Before)
+        {
+            if (Old.Kind == Count.Kind && std::strcmp(Old.Subsystem, Count.Subsystem) == 0)
+            {
+                Previous = Old.Live;
+                break;
+            }
+        }
+        if (Previous != Count.Live) Out.push_back({ Count.Subsystem, Count.Kind, Previous, Count.Live });
+    }
+    return Out;
+}
+
+/** One "subsystem.kind live=N peak=N acquired=N" line per counter. */
+inline void WriteResourceSnapshot(std::ostream& Out, const FResourceSnapshot& Snapshot)
+{
+    for (const auto& Count : Snapshot)
+    {
+        Out << Count.Subsystem << '.' << GetResourceKindName(Count.Kind) << " live=" << Count.Live
+            << " peak=" << Count.Peak << " acquired=" << Count.Acquired << '\n';
+    }
+}
+
+/** One "subsystem.kind before -> after (+delta)" line per changed counter. */
+inline void WriteResourceDiff(std::ostream& Out, const std::vector<FResourceDelta>& Deltas)
+{
+    for (const auto& Delta : Deltas)
+    {
+        int64_t Change = Delta.After - Delta.Before;
+        Out << Delta.Subsystem << '.' << GetResourceKindName(Delta.Kind) << ' ' << Delta.Before << " -> "
+            << Delta.After << " (" << (Change > 0 ? "+" : "") << Change << ")\n";
+    }
+}
+
+/** Process-wide tracker used by the RESOURCE_* macros. Disabled until SetEnabled(true). */
+inline FResourceTracker GResources;
+
+#define RESOURCE_ACQUIRE(Subsystem, Kind) GResources.Acquire(Subsystem, EResourceKind::Kind)
+#define RESOURCE_RELEASE(Subsystem, Kind) GResources.Release(Subsystem, EResourceKind::Kind)
@@ -0,0 +1,674 @@
+// service_bench - Stress test of the shared decode service with many sessions (Linux).
+// Forks a decode service serving synthetic streams, then dozens of session processes
+// that attach to a few distinct streams, read frames through FSharedFrameSource and
+// check every byte of each one: a torn or foreign frame fails the run. Along the way
+// a quarter of the sessions are SIGKILLed, and the service must drop exactly their
+// references while the rest play on; once the last session leaves, every stream and
+// segment must be gone after the linger. Then the service itself is frozen (SIGSTOP)
+// and later killed under attached sessions, which must fall back to local decoding
+// and keep going; a restarted service must sweep the segments the dead one left.
+// A stream whose decoder takes a second to open must not hold up the service
+// meanwhile, nor may a client that floods requests without reading the replies.
+// Segments of a default service are 0600. Last, access: the socket gets the mode it is given under umask 000, and a service
+// starting up leaves the segments of a running one alone. As root, a session of
+// another user is refused by a 0600 socket, and a 0666 one serves it a file it can
+// read but not one it cannot.
+//   g++ -std=c++20 -O2 -pthread service_bench.cpp -o service_bench
+//   service_bench [--clients N] [--streams N] [--size WxH] [--seconds N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <dirent.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "decode_service.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t Clients = 40;
+        int32_t Streams = 3;
+        int32_t Width = 320;
+        int32_t Height = 180;
+        int32_t Seconds = 4;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--clients") Options.Clients = std::atoi(Value);
+            else if (Name == "--streams") Options.Streams = std::atoi(Value);
+            else if (Name == "--seconds") Options.Seconds = std::atoi(Value);
+            else if (Name == "--size")
+            {
+                if (std::sscanf(Value, "%dx%d", &Options.Width, &Options.Height) != 2) return false;
+            }
+            else return false;
+        }
+        return Options.Clients >= 4 && Options.Streams > 0 && Options.Streams <= Options.Clients
+            && Options.Width >= 16 && Options.Height >= 2 && Options.Seconds >= 2;
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    void SleepMs(int32_t Milliseconds) { std::this_thread::sleep_for(std::chrono::milliseconds(Milliseconds)); }
+
+    constexpr uint32_t StampedFrameRate = 30;
+
+    /** Loop length; the service's rewind at the end is part of what sessions see. */
+    constexpr uint64_t StampedLoopFrames = 45;
+
+    uint8_t GetLumaFill(uint64_t Frame, uint64_t Stream) { return static_cast<uint8_t>(Frame * 31 + Stream * 64 + 7); }
+    uint8_t GetChromaFill(uint64_t Frame, uint64_t Stream) { return static_cast<uint8_t>(Frame * 17 + Stream * 16 + 3); }
+
+    /** NV12 frames filled from (frame, stream), with both stamped into the first 16 luma bytes. */
+    class FStampedSource final : public IVideoSource
+    {
+    public:
+        FStampedSource(uint64_t InStream, int32_t Width, int32_t Height)
+            : Stream(InStream)
+        {
+            Info.Width = Width & ~1;
+            Info.Height = Height & ~1;
+            Info.FrameRateNumerator = StampedFrameRate;
+            Info.Format = EPixelFormat::NV12;
+            Info.Duration100ns = static_cast<int64_t>(StampedLoopFrames) * Info.FrameDuration100ns();
+        }
+
+        const FVideoInfo& GetInfo() const override { return Info; }
+
+        bool ReadFrame(FFrame& Out) override
+        {
+            if (FrameIndex >= StampedLoopFrames) return false;
+            Out.Allocate(Info.Width, Info.Height, EPixelFormat::NV12);
+            const FFrameView& View = Out.GetView();
+            for (int32_t Y = 0; Y < View.Height; ++Y) std::memset(View.Row(0, Y), GetLumaFill(FrameIndex, Stream), static_cast<size_t>(View.Width));
+            for (int32_t Y = 0; Y < View.Height / 2; ++Y) std::memset(View.Row(1, Y), GetChromaFill(FrameIndex, Stream), static_cast<size_t>(View.Width));
+            std::memcpy(View.Row(0, 0), &FrameIndex, 8);
+            std::memcpy(View.Row(0, 0) + 8, &Stream, 8);
+            Out.Timestamp100ns = static_cast<int64_t>(FrameIndex++) * Info.FrameDuration100ns();
+            return true;
+        }
+
+        bool Seek(int64_t Position100ns) override
+        {
+            FrameIndex = static_cast<uint64_t>(Position100ns / Info.FrameDuration100ns());
+            return true;
+        }
+
+    private:
+        FVideoInfo Info;
+        uint64_t Stream;
+        uint64_t FrameIndex = 0;
+    };
+
+    /** Every byte, so a frame torn between two writes or taken from another stream is caught. */
+    bool IsIntactFrame(const FFrame& Frame, uint64_t ExpectedStream)
+    {
+        const FFrameView& View = Frame.GetView();
+        if (View.Width < 16) return false;
+        uint64_t Index = 0;
+        uint64_t Stream = 0;
+        std::memcpy(&Index, View.Row(0, 0), 8);
+        std::memcpy(&Stream, View.Row(0, 0) + 8, 8);
+        if (Stream != ExpectedStream || Index >= StampedLoopFrames) return false;
+        for (int32_t Y = 0; Y < View.Height; ++Y)
+        {
+            const uint8_t* Row = View.Row(0, Y);
+            for (int32_t X = Y ? 0 : 16; X < View.Width; ++X)
+            {
+                if (Row[X] != GetLumaFill(Index, Stream)) return false;
+            }
+        }
+        for (int32_t Y = 0; Y < View.Height / 2; ++Y)
+        {
+            const uint8_t* Row = View.Row(1, Y);
+            for (int32_t X = 0; X < View.Width; ++X)
+            {
+                if (Row[X] != GetChromaFill(Index, Stream)) return false;
+            }
+        }
+        return true;
+    }
+
+    std::string GetStreamPath(int32_t Stream) { return "synthetic:" + std::to_string(Stream); }
+
+    enum EClientState : int32_t
+    {
+        Starting,
+        Attached,
+        FellBack,
+        Finished,
+        AttachFailed,
+        ReadFailed
+    };
+
+    /** Written by session processes into an anonymous shared mapping the bench reads. */
+    struct FClientResult
+    {
+        std::atomic<int32_t> State{ Starting };
+        std::atomic<uint64_t> SharedFrames{ 0 };
+        std::atomic<uint64_t> FallbackFrames{ 0 };
+        std::atomic<uint64_t> BadFrames{ 0 };
+        std::atomic<uint64_t> SkippedFrames{ 0 };
+        std::atomic<uint64_t> LappedReads{ 0 };
+    };
+
+    /** Body of a session process. */
+    int RunClient(const std::string& SocketPath, const FBenchOptions& Options, int32_t Stream, int32_t Seconds, int32_t StallTimeoutMs, FClientResult& Result)
+    {
+        auto OpenFallback = [&]() -> std::unique_ptr<IVideoSource>
+        {
+            return std::make_unique<FStampedSource>(static_cast<uint64_t>(Stream), Options.Width, Options.Height);
+        };
+        FSharedFrameSource Source(OpenFallback, StallTimeoutMs);
+        std::string Error;
+        if (!Source.Attach(SocketPath, GetStreamPath(Stream), Options.Width, Options.Height, Error))
+        {
+            Result.State = AttachFailed;
+            return 1;
+        }
+        Result.State = Attached;
+
+        FFrame Frame;
+        auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(Seconds);
+        while (std::chrono::steady_clock::now() < Deadline)
+        {
+            // A local fallback reaches the end of the file; the service loops on its own.
+            if (!Source.ReadFrame(Frame) && (!Source.Seek(0) || !Source.ReadFrame(Frame)))
+            {
+                Result.State = ReadFailed;
+                return 1;
+            }
+            if (!IsIntactFrame(Frame, static_cast<uint64_t>(Stream))) Result.BadFrames.fetch_add(1);
+            if (Source.HasFallenBack())
+            {
+                Result.State = FellBack;
+                Result.FallbackFrames.fetch_add(1);
+                // The local decoder is not paced by anyone; keep it to the stream's rate.
+                SleepMs(1000 / static_cast<int32_t>(StampedFrameRate));
+            }
+            else Result.SharedFrames.fetch_add(1);
+            Result.SkippedFrames = Source.GetReader().GetSkippedFrames();
+            Result.LappedReads = Source.GetReader().GetLappedReads();
+        }
+        if (Result.State == Attached) Result.State = Finished;
+        return 0;
+    }
+
+    /** How long "slow:N" streams take to open, like ffprobe on a large file. */
+    constexpr int32_t SlowOpenMs = 1000;
+
+    /** Body of the service process. Files it can read play as stream 0. */
+    int RunService(const std::string& SocketPath, mode_t SocketMode)
+    {
+        static std::atomic<bool> bQuit{ false };
+        std::signal(SIGTERM, [](int) { bQuit.store(true); });
+        FDecodeServiceSettings Settings;
+        Settings.SocketPath = SocketPath;
+        Settings.SocketMode = SocketMode;
+        Settings.LingerMs = 300;
+        FDecodeService Service([](const std::string& Path, int32_t Width, int32_t Height) -> std::unique_ptr<IVideoSource>
+        {
+            if (access(Path.c_str(), R_OK) == 0) return std::make_unique<FStampedSource>(0, Width, Height);
+            if (Path.starts_with("slow:"))
+            {
+                SleepMs(SlowOpenMs);
+                return std::make_unique<FStampedSource>(std::strtoull(Path.c_str() + 5, nullptr, 10), Width, Height);
+            }
+            if (!Path.starts_with("synthetic:")) return nullptr;
+            return std::make_unique<FStampedSource>(std::strtoull(Path.c_str() + 10, nullptr, 10), Width, Height);
+        }, Settings);
+        std::string Error;
+        if (!Service.Listen(Error))
+        {
+            std::fprintf(stderr, "service: %s\n", Error.c_str());
+            return 1;
+        }
+        Service.Run(bQuit);
+        return 0;
+    }
+
+    pid_t StartService(const std::string& SocketPath, mode_t SocketMode = S_IRUSR | S_IWUSR)
+    {
+        pid_t Pid = fork();
+        if (Pid == 0) _exit(RunService(SocketPath, SocketMode));
+        return Pid;
+    }
+
+    pid_t StartClient(const std::string& SocketPath, const FBenchOptions& Options, int32_t Stream, int32_t Seconds, int32_t StallTimeoutMs, FClientResult& Result)
+    {
+        pid_t Pid = fork();
+        if (Pid == 0) _exit(RunClient(SocketPath, Options, Stream, Seconds, StallTimeoutMs, Result));
+        return Pid;
+    }
+
+    /** Parsed "status" reply; Streams < 0 if the service did not answer. */
+    struct FServiceStatus
+    {
+        int32_t Streams = -1;
+        int32_t Connections = 0;
+        int32_t Clients = 0;
+        uint64_t Frames = 0;
+    };
+
+    FServiceStatus QueryStatus(const std::string& SocketPath)
+    {
+        FServiceStatus Status;
+        int Socket = ConnectUnixSocket(SocketPath);
+        std::string Reply;
+        bool bReplied = Socket >= 0 && RequestOverSocket(Socket, "status", Reply, 1000);
+        if (Socket >= 0) close(Socket);
+        if (!bReplied) return Status;
+
+        std::string Text = ParseControlResponse(Reply).Text;
+        size_t Start = 0;
+        while (Start < Text.size())
+        {
+            size_t End = Text.find('\n', Start);
+            std::string Line = Text.substr(Start, End == std::string::npos ? std::string::npos : End - Start);
+            Start = End == std::string::npos ? Text.size() : End + 1;
+            size_t Equals = Line.find('=');
+            if (Equals == std::string::npos) continue;
+            std::string Key = Line.substr(0, Equals);
+            long long Value = std::atoll(Line.c_str() + Equals + 1);
+            if (Key == "streams") Status.Streams = static_cast<int32_t>(Value);
+            else if (Key == "connections") Status.Connections = static_cast<int32_t>(Value);
+            else if (Key.ends_with(".clients")) Status.Clients += static_cast<int32_t>(Value);
+            else if (Key.ends_with(".frames")) Status.Frames += static_cast<uint64_t>(Value);
+        }
+        return Status;
+    }
+
+    /** Polls until Done(status) or TimeoutMs; the last status either way. */
+    template <typename TDone>
+    FServiceStatus WaitForStatus(const std::string& SocketPath, int32_t TimeoutMs, TDone&& Done)
+    {
+        auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TimeoutMs);
+        FServiceStatus Status = QueryStatus(SocketPath);
+        while (!Done(Status) && std::chrono::steady_clock::now() < Deadline)
+        {
+            SleepMs(20);
+            Status = QueryStatus(SocketPath);
+        }
+        return Status;
+    }
+
+    /** Segments in /dev/shm; only those of service Owner and with permissions Mode if they are given. */
+    int32_t CountSegments(pid_t Owner = 0, mode_t Mode = 0)
+    {
+        int32_t Count = 0;
+        if (DIR* Directory = opendir("/dev/shm"))
+        {
+            int64_t SegmentOwner = 0;
+            while (dirent* Entry = readdir(Directory))
+            {
+                if (!ParseSharedStreamOwner(Entry->d_name, SegmentOwner) || (Owner && SegmentOwner != Owner)) continue;
+                struct stat FileInfo = {};
+                std::string Path = std::string("/dev/shm/") + Entry->d_name;
+                if (!Mode || (stat(Path.c_str(), &FileInfo) == 0 && (FileInfo.st_mode & 0777) == Mode)) ++Count;
+            }
+            closedir(Directory);
+        }
+        return Count;
+    }
+
+    /** Exit code, or -1 if it did not exit cleanly. */
+    int32_t WaitForExit(pid_t Pid)
+    {
+        int Status = 0;
+        if (waitpid(Pid, &Status, 0) != Pid || !WIFEXITED(Status)) return -1;
+        return WEXITSTATUS(Status);
+    }
+
+    bool RunSharingPhase(const std::string& SocketPath, const FBenchOptions& Options, FClientResult* Results)
+    {
+        std::vector<pid_t> Clients;
+        for (int32_t Index = 0; Index < Options.Clients; ++Index)
+        {
+            Clients.push_back(StartClient(SocketPath, Options, Index % Options.Streams, Options.Seconds, 3000, Results[Index]));
+        }
+        FServiceStatus Attached = WaitForStatus(SocketPath, 10000, [&](const FServiceStatus& Status) { return Status.Clients == Options.Clients; });
+        bool bPass = Check(Attached.Clients == Options.Clients, "not every session attached");
+        bPass &= Check(Attached.Streams == Options.Streams, "not one decoder per distinct stream");
+        bPass &= Check(CountSegments() == Options.Streams && CountSegments(0, 0600) == Options.Streams, "a default service's segment is readable by other users");
+
+        // Crash a quarter of the sessions mid-stream.
+        SleepMs(Options.Seconds * 1000 / 3);
+        int32_t Killed = 0;
+        std::vector<uint64_t> FramesAtKill(static_cast<size_t>(Options.Clients));
+        for (int32_t Index = 0; Index < Options.Clients; ++Index)
+        {
+            FramesAtKill[Index] = Results[Index].SharedFrames.load();
+            if (Index % 4 != 3) continue;
+            kill(Clients[Index], SIGKILL);
+            ++Killed;
+        }
+        auto KillTime = std::chrono::steady_clock::now();
+        FServiceStatus Released = WaitForStatus(SocketPath, 2000, [&](const FServiceStatus& Status) { return Status.Clients == Options.Clients - Killed; });
+        double ReleaseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - KillTime).count();
+        bPass &= Check(Released.Clients == Options.Clients - Killed, "crashed sessions still counted");
+        bPass &= Check(Released.Streams == Options.Streams, "a stream went away with live sessions");
+
+        uint64_t Presented = 0;
+        uint64_t Bad = 0;
+        uint64_t Skipped = 0;
+        uint64_t Lapped = 0;
+        int32_t Failed = 0;
+        FServiceStatus Decoded;
+        for (int32_t Index = 0; Index < Options.Clients; ++Index)
+        {
+            // The last survivors are still attached: the decoded count is taken before they leave.
+            if (Index == Options.Clients - 1) Decoded = QueryStatus(SocketPath);
+            int32_t ExitCode = WaitForExit(Clients[Index]);
+            FClientResult& Result = Results[Index];
+            Presented += Result.SharedFrames;
+            Bad += Result.BadFrames;
+            Skipped += Result.SkippedFrames;
+            Lapped += Result.LappedReads;
+            if (Index % 4 == 3) continue;
+            if (ExitCode != 0 || Result.State != Finished || Result.SharedFrames <= FramesAtKill[Index]) ++Failed;
+        }
+        bPass &= Check(Bad == 0, "torn or foreign frames");
+        bPass &= Check(Failed == 0, "a surviving session stopped playing");
+
+        FServiceStatus Drained = WaitForStatus(SocketPath, 3000, [](const FServiceStatus& Status) { return Status.Streams == 0; });
+        bPass &= Check(Drained.Streams == 0, "streams outlived their last session");
+        bPass &= Check(CountSegments() == 0, "segments left after the last session");
+
+        std::printf
+        (
+            "sharing: %d sessions on %d streams; %d killed, released in %.0f ms; %llu frames decoded, %llu presented "
+            "(%.1f per decode), %llu skipped, %llu lapped reads\n",
+            Options.Clients, Options.Streams, Killed, ReleaseMs, static_cast<unsigned long long>(Decoded.Frames),
+            static_cast<unsigned long long>(Presented), Decoded.Frames ? static_cast<double>(Presented) / Decoded.Frames : 0.0,
+            static_cast<unsigned long long>(Skipped), static_cast<unsigned long long>(Lapped)
+        );
+        return bPass;
+    }
+
+    /** Freezes, then kills the service under attached sessions; FClientResult slots from Results on. */
+    bool RunFailurePhase(const std::string& SocketPath, const FBenchOptions& Options, pid_t& Service, FClientResult* Results)
+    {
+        constexpr int32_t StallTimeoutMs = 500;
+        int32_t Count = Options.Streams;
+        bool bPass = true;
+        for (int32_t Round = 0; Round < 2; ++Round)
+        {
+            bool bFreeze = Round == 0;
+            FClientResult* RoundResults = Results + Round * Count;
+            std::vector<pid_t> Clients;
+            for (int32_t Index = 0; Index < Count; ++Index)
+            {
+                Clients.push_back(StartClient(SocketPath, Options, Index, 3, StallTimeoutMs, RoundResults[Index]));
+            }
+            FServiceStatus Attached = WaitForStatus(SocketPath, 10000, [&](const FServiceStatus& Status) { return Status.Clients == Count; });
+            bPass &= Check(Attached.Clients == Count, "sessions did not attach for the failure round");
+            SleepMs(500);
+            kill(Service, bFreeze ? SIGSTOP : SIGKILL);
+
+            int32_t Recovered = 0;
+            for (int32_t Index = 0; Index < Count; ++Index)
+            {
+                bool bExited = WaitForExit(Clients[Index]) == 0;
+                const FClientResult& Result = RoundResults[Index];
+                if (bExited && Result.State == FellBack && Result.FallbackFrames > 0 && Result.BadFrames == 0) ++Recovered;
+            }
+            bPass &= Check(Recovered == Count, bFreeze ? "sessions did not fall back from a hung service" : "sessions did not fall back from a dead service");
+            std::printf
+            (
+                "%s service: %d/%d sessions fell back to local decoding\n", bFreeze ? "hung" : "killed", Recovered, Count
+            );
+            if (bFreeze)
+            {
+                // Thawed, it sees the sessions gone and drops their streams.
+                kill(Service, SIGCONT);
+                FServiceStatus Drained = WaitForStatus(SocketPath, 3000, [](const FServiceStatus& Status) { return Status.Streams == 0; });
+                bPass &= Check(Drained.Streams == 0, "a thawed service kept streams of sessions that left");
+            }
+        }
+        WaitForExit(Service);
+
+        int32_t Stale = CountSegments();
+        Service = StartService(SocketPath);
+        FServiceStatus Restarted = WaitForStatus(SocketPath, 5000, [](const FServiceStatus& Status) { return Status.Streams == 0; });
+        bPass &= Check(Restarted.Streams == 0, "service did not restart");
+        bPass &= Check(Stale > 0 && CountSegments() == 0, "segments of the dead service not swept");
+        std::printf("restart: %d stale segment(s) swept\n", Stale);
+        return bPass;
+    }
+
+    /** Status requests while a stream takes SlowOpenMs to open are answered at once; the attach when it opens. */
+    /** Payloads of the next Count replies on Socket; fewer if they do not all arrive within TimeoutMs. */
+    std::vector<std::string> ReadReplies(int Socket, size_t Count, int32_t TimeoutMs)
+    {
+        std::vector<std::string> Replies;
+        FControlFrameReader Reader;
+        auto Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TimeoutMs);
+        char Buffer[4096];
+        std::string Payload;
+        while (Replies.size() < Count)
+        {
+            EControlFrameResult Result = Reader.Next(Payload);
+            if (Result == EControlFrameResult::Frame)
+            {
+                Replies.push_back(Payload);
+                continue;
+            }
+            if (Result == EControlFrameResult::Invalid) break;
+            auto Remaining = std::chrono::duration_cast<std::chrono::milliseconds>(Deadline - std::chrono::steady_clock::now());
+            pollfd Poll = { Socket, POLLIN, 0 };
+            if (Remaining.count() <= 0 || poll(&Poll, 1, static_cast<int>(Remaining.count())) <= 0) break;
+            ssize_t Read = recv(Socket, Buffer, sizeof(Buffer), 0);
+            if (Read <= 0) break;
+            Reader.Append(Buffer, static_cast<size_t>(Read));
+        }
+        return Replies;
+    }
+
+    /**
+     * Status requests while a stream takes SlowOpenMs to open are answered at once; the
+     * attach when it opens, followed by a request pipelined behind it.
+     */
+    bool RunSlowOpenPhase(const std::string& SocketPath)
+    {
+        int Socket = ConnectUnixSocket(SocketPath);
+        bool bAttached = false;
+        bool bPipelinedAnswered = false;
+        auto Start = std::chrono::steady_clock::now();
+        std::thread Attach([&]
+        {
+            std::string Requests;
+            AppendControlFrame(Requests, FormatAttachRequest("slow:1", 64, 36));
+            AppendControlFrame(Requests, "status");
+            if (Socket < 0 || !SendAll(Socket, Requests)) return;
+            std::vector<std::string> Replies = ReadReplies(Socket, 2, 5000);
+            bAttached = !Replies.empty() && ParseControlResponse(Replies[0]).bOk;
+            bPipelinedAnswered = Replies.size() == 2 && ParseControlResponse(Replies[1]).Text.starts_with("streams=");
+        });
+        SleepMs(100);
+        double WorstStatusMs = 0;
+        int32_t Answered = 0;
+        for (int32_t Query = 0; Query < 5; ++Query, SleepMs(50))
+        {
+            auto QueryStart = std::chrono::steady_clock::now();
+            Answered += QueryStatus(SocketPath).Streams >= 0 ? 1 : 0;
+            double Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - QueryStart).count();
+            WorstStatusMs = Ms > WorstStatusMs ? Ms : WorstStatusMs;
+        }
+        Attach.join();
+        double AttachMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+        if (Socket >= 0) close(Socket);
+
+        bool bPass = Check(Answered == 5 && WorstStatusMs < SlowOpenMs / 4, "service held up by a stream opening");
+        bPass &= Check(bAttached, "attach to a slow stream not answered");
+        bPass &= Check(bPipelinedAnswered, "request pipelined behind a slow attach not answered");
+        bPass &= Check(WaitForStatus(SocketPath, 3000, [](const FServiceStatus& Status) { return Status.Streams == 0; }).Streams == 0, "slow stream outlived its session");
+        std::printf("slow open: attach answered after %.0f ms, status during the open at worst %.1f ms\n", AttachMs, WorstStatusMs);
+        return bPass;
+    }
+
+    /** A client that floods requests without reading the replies is dropped and holds nobody else up for long. */
+    bool RunStuckClientPhase(const std::string& SocketPath)
+    {
+        int Socket = ConnectUnixSocket(SocketPath);
+        std::string Request;
+        AppendControlFrame(Request, "status");
+        size_t Sent = 0;
+        auto FloodEnd = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (Socket >= 0 && std::chrono::steady_clock::now() < FloodEnd)
+        {
+            ssize_t Result = send(Socket, Request.data(), Request.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (Result < 0 && errno == EAGAIN)
+            {
+                SleepMs(1);
+                continue;
+            }
+            if (Result <= 0) break;
+            Sent += static_cast<size_t>(Result);
+        }
+
+        auto QueryStart = std::chrono::steady_clock::now();
+        FServiceStatus Status = QueryStatus(SocketPath);
+        double QueryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - QueryStart).count();
+        if (Socket >= 0) close(Socket);
+
+        bool bPass = Check(Status.Streams >= 0 && QueryMs < 500, "a client not reading its replies held up the service");
+        bPass &= Check(Status.Connections == 1, "a client not reading its replies was not dropped");
+        std::printf("stuck client: %zu request bytes sent before the drop, next status answered in %.1f ms\n", Sent, QueryMs);
+        return bPass;
+    }
+
+    /** Forks a session that drops to another user and attaches Path; its exit code says what happened. */
+    int AttachAsOtherUser(const std::string& SocketPath, const std::string& Path)
+    {
+        pid_t Child = fork();
+        if (Child == 0)
+        {
+            if (setgid(65534) != 0 || setuid(65534) != 0) _exit(10);
+            int Socket = ConnectUnixSocket(SocketPath);
+            if (Socket < 0) _exit(errno == EACCES ? 3 : 11);
+            std::string Reply;
+            if (!RequestOverSocket(Socket, FormatAttachRequest(Path, 64, 36), Reply, 2000)) _exit(12);
+            _exit(ParseControlResponse(Reply).bOk ? 0 : 4);
+        }
+        return WaitForExit(Child);
+    }
+
+    /** Socket modes, a running service's segments across another's start, and sessions of another user. */
+    bool RunAccessPhase(const FBenchOptions& Options, FClientResult& Result)
+    {
+        std::string Base = "/tmp/service_bench-" + std::to_string(getpid());
+        std::string PrivatePath = Base + ".private.sock";
+        std::string OpenPath = Base + ".open.sock";
+        mode_t PreviousMask = umask(0);
+        pid_t Private = StartService(PrivatePath);
+        pid_t Open = StartService(OpenPath, 0666);
+        umask(PreviousMask);
+        auto IsUp = [](const FServiceStatus& Status) { return Status.Streams >= 0; };
+        bool bPass = Check(WaitForStatus(PrivatePath, 5000, IsUp).Streams == 0 && WaitForStatus(OpenPath, 5000, IsUp).Streams == 0, "access services did not start");
+        struct stat FileInfo = {};
+        bPass &= Check(stat(PrivatePath.c_str(), &FileInfo) == 0 && (FileInfo.st_mode & 0777) == 0600, "default socket mode is not 0600 under umask 000");
+        bPass &= Check(stat(OpenPath.c_str(), &FileInfo) == 0 && (FileInfo.st_mode & 0777) == 0666, "socket mode 0666 not applied under umask 000");
+
+        // A service starting next to a running one must not take its segments away.
+        pid_t Client = StartClient(OpenPath, Options, 1, 2, 3000, Result);
+        WaitForStatus(OpenPath, 5000, [](const FServiceStatus& Status) { return Status.Clients == 1; });
+        int32_t Live = CountSegments(Open);
+        std::string ThirdPath = Base + ".third.sock";
+        pid_t Third = StartService(ThirdPath);
+        WaitForStatus(ThirdPath, 5000, IsUp);
+        bPass &= Check(Live == 1 && CountSegments(Open) == 1, "a starting service swept a running one's segment");
+        bPass &= Check(CountSegments(Open, 0644) == 1, "a host-wide service's segment is not readable by its sessions");
+        bPass &= Check(WaitForExit(Client) == 0 && Result.State == Finished && Result.FallbackFrames == 0, "session lost its running service's stream");
+        kill(Third, SIGTERM);
+        WaitForExit(Third);
+
+        if (geteuid() != 0) std::printf("access: other user skipped (needs root to switch users)\n");
+        else
+        {
+            std::string SecretPath = Base + ".secret";
+            std::string SharedPath = Base + ".shared";
+            for (const std::string& Path : { SecretPath, SharedPath })
+            {
+                if (std::FILE* File = std::fopen(Path.c_str(), "w")) std::fclose(File);
+            }
+            chmod(SecretPath.c_str(), 0600);
+            chmod(SharedPath.c_str(), 0644);
+            int ByMode = AttachAsOtherUser(PrivatePath, SharedPath);
+            int Secret = AttachAsOtherUser(OpenPath, SecretPath);
+            int Shared = AttachAsOtherUser(OpenPath, SharedPath);
+            unlink(SecretPath.c_str());
+            unlink(SharedPath.c_str());
+            bPass &= Check(ByMode == 3, "other user not refused by a 0600 socket");
+            bPass &= Check(Secret == 4, "other user served a file it cannot read");
+            bPass &= Check(Shared == 0, "other user refused a file it can read");
+            std::printf("access: other user refused by mode %s, unreadable file %s, readable file %s\n",
+                ByMode == 3 ? "yes" : "no", Secret == 4 ? "refused" : "served", Shared == 0 ? "served" : "refused");
+        }
+
+        for (pid_t Service : { Private, Open }) kill(Service, SIGTERM);
+        bPass &= Check(WaitForExit(Private) == 0 && WaitForExit(Open) == 0, "access services did not shut down cleanly");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: service_bench [--clients N] [--streams N] [--size WxH] [--seconds N]\n");
+        return 2;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Shared with the forked sessions; sized for every phase.
+    size_t ResultCount = static_cast<size_t>(Options.Clients + 2 * Options.Streams + 1);
+    void* Mapping = mmap(nullptr, sizeof(FClientResult) * ResultCount, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (Mapping == MAP_FAILED) return 1;
+    FClientResult* Results = new (Mapping) FClientResult[ResultCount];
+
+    std::string SocketPath = "/tmp/service_bench-" + std::to_string(getpid()) + ".sock";
+    pid_t Service = StartService(SocketPath);
+    bool bPass = Check(WaitForStatus(SocketPath, 5000, [](const FServiceStatus& Status) { return Status.Streams >= 0; }).Streams == 0, "service did not start");
+    if (bPass)
+    {
+        bPass &= Check(RunSharingPhase(SocketPath, Options, Results), "sharing");
+        bPass &= Check(RunFailurePhase(SocketPath, Options, Service, Results + Options.Clients), "service failure");
+        bPass &= Check(RunSlowOpenPhase(SocketPath), "slow open");
+        bPass &= Check(RunStuckClientPhase(SocketPath), "stuck client");
+        bPass &= Check(RunAccessPhase(Options, Results[ResultCount - 1]), "access");
+    }
+
+    kill(Service, SIGTERM);
+    bPass &= Check(WaitForExit(Service) == 0, "service did not shut down cleanly");
+    bPass &= Check(access(SocketPath.c_str(), F_OK) != 0, "socket left behind");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
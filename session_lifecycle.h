@@ -0,0 +1,212 @@
+// SessionLifecycle - Per-monitor presentation lifecycle from session and display power.
+// Nobody sees the wallpaper while the workstation is locked, the session is
+// disconnected (RDP) or a display is off, so those monitors stop decoding. A hidden
+// monitor is first paused, which keeps its pipeline so it resumes at once; once
+// every monitor has been hidden for ReleaseAfterMs the pipelines are released too.
+// Pipelines (master clock, software presenter) are shared between monitors, so
+// release is all-or-nothing. Time spent in each state is accounted per monitor.
+// Pure logic: callers feed events with a timestamp, then apply the transitions
+// returned by Update(), so scripted event sequences can be replayed through it.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class ELifecycleState : uint8_t
+{
+    Active,     // Visible and decoding
+    Paused,     // Hidden; pipeline kept for an instant resume
+    Released,   // Hidden long enough that the pipeline was torn down
+    Count
+};
+
+inline const char* GetLifecycleStateName(ELifecycleState State)
+{
+    switch (State)
+    {
+    case ELifecycleState::Active: return "active";
+    case ELifecycleState::Paused: return "paused";
+    case ELifecycleState::Released: return "released";
+    default: return "?";
+    }
+}
+
+enum class ESessionEvent : uint8_t
+{
+    Lock,
+    Unlock,
+    Disconnect,     // Console or remote session detached from its display
+    Connect
+};
+
+enum class EDisplayPower : uint8_t
+{
+    Off,
+    On,
+    Dimmed
+};
+
+struct FLifecycleSettings
+{
+    bool bPauseWhenDimmed = false;      // A dimmed display is still visible by default
+    int64_t ReleaseAfterMs = 600000;    // 0 = never release, only pause
+};
+
+struct FLifecycleTransition
+{
+    size_t Monitor = 0;
+    ELifecycleState From = ELifecycleState::Active;
+    ELifecycleState To = ELifecycleState::Active;
+    int64_t TimeInFromMs = 0;           // How long the monitor had been in From
+};
+
+class FSessionLifecycle
+{
+public:
+    void Configure(const FLifecycleSettings& InSettings) { Settings = InSettings; }
+
+    /**
+     * Resizes to a freshly built monitor set; session state and existing monitors are
+     * kept. Building the monitors recreates the pipelines, so released monitors are
+     * paused again and their release timeout restarts. New monitors start Active
+     * until the next Update().
+     */
+    void SetMonitorCount(size_t Count, int64_t NowMs)
+    {
+        for (auto& Monitor : Monitors)
+        {
+            if (Monitor.State != ELifecycleState::Released) continue;
+            Monitor.TotalMs[static_cast<size_t>(ELifecycleState::Released)] += NowMs - Monitor.EnteredAtMs;
+            Monitor.State = ELifecycleState::Paused;
+            Monitor.EnteredAtMs = NowMs;
+            Monitor.HiddenSinceMs = NowMs;
+        }
+        FMonitor New;
+        New.Power = DefaultPower;
+        New.EnteredAtMs = NowMs;
+        Monitors.resize(Count, New);
+    }
+
+    void OnSessionEvent(ESessionEvent Event)
+    {
+        switch (Event)
+        {
+        case ESessionEvent::Lock: bLocked = true; break;
+        case ESessionEvent::Unlock: bLocked = false; break;
+        case ESessionEvent::Disconnect: bConnected = false; break;
+        case ESessionEvent::Connect: bConnected = true; break;
+        }
+    }
+
+    void SetDisplayPower(size_t Monitor, EDisplayPower Power)
+    {
+        if (Monitor < Monitors.size()) Monitors[Monitor].Power = Power;
+    }
+
+    /** For platforms that only report the console's display state as a whole. */
+    void SetAllDisplayPower(EDisplayPower Power)
+    {
+        DefaultPower = Power;
+        for (auto& Monitor : Monitors) Monitor.Power = Power;
+    }
+
+    /** Re-evaluates every monitor after events or as time passes; appends what changed to Out. */
+    void Update(int64_t NowMs, std::vector<FLifecycleTransition>& Out)
+    {
+        bool bSessionVisible = !bLocked && bConnected;
+        bool bAnyVisible = false;
+        bool bAllExpired = Settings.ReleaseAfterMs > 0 && !Monitors.empty();
+        for (auto& Monitor : Monitors)
+        {
+            Monitor.bVisible = bSessionVisible && IsPowerVisible(Monitor.Power);
+            if (Monitor.bVisible)
+            {
+                Monitor.HiddenSinceMs = -1;
+                bAnyVisible = true;
+                bAllExpired = false;
+                continue;
+            }
+            if (Monitor.HiddenSinceMs < 0) Monitor.HiddenSinceMs = NowMs;
+            if (NowMs - Monitor.HiddenSinceMs < Settings.ReleaseAfterMs) bAllExpired = false;
+        }
+
+        for (size_t Index = 0; Index < Monitors.size(); ++Index)
+        {
+            FMonitor& Monitor = Monitors[Index];
+            ELifecycleState Target = ELifecycleState::Active;
+            if (!Monitor.bVisible)
+            {
+                // Released monitors come back to Paused when another monitor brings the pipelines back.
+                Target = bAllExpired || (Monitor.State == ELifecycleState::Released && !bAnyVisible)
+                    ? ELifecycleState::Released
+                    : ELifecycleState::Paused;
+            }
+            if (Target == Monitor.State) continue;
+
+            FLifecycleTransition Transition;
+            Transition.Monitor = Index;
+            Transition.From = Monitor.State;
+            Transition.To = Target;
+            Transition.TimeInFromMs = NowMs - Monitor.EnteredAtMs;
+            Monitor.TotalMs[static_cast<size_t>(Monitor.State)] += Transition.TimeInFromMs;
+            Monitor.State = Target;
+            Monitor.EnteredAtMs = NowMs;
+            Out.push_back(Transition);
+        }
+    }
+
+    size_t GetMonitorCount() const { return Monitors.size(); }
+    ELifecycleState GetState(size_t Monitor) const { return Monitors[Monitor].State; }
+    bool IsSessionVisible() const { return !bLocked && bConnected; }
+
+    bool IsAnyActive() const
+    {
+        for (const auto& Monitor : Monitors)
+        {
+            if (Monitor.State == ELifecycleState::Active) return true;
+        }
+        return false;
+    }
+
+    bool AreAllReleased() const
+    {
+        for (const auto& Monitor : Monitors)
+        {
+            if (Monitor.State != ELifecycleState::Released) return false;
+        }
+        return !Monitors.empty();
+    }
+
+    /** Total time Monitor has spent in State, including the current stay. */
+    int64_t GetTimeInState(size_t Monitor, ELifecycleState State, int64_t NowMs) const
+    {
+        const FMonitor& Entry = Monitors[Monitor];
+        int64_t Total = Entry.TotalMs[static_cast<size_t>(State)];
+        return Entry.State == State ? Total + NowMs - Entry.EnteredAtMs : Total;
+    }
+
+private:
+    struct FMonitor
+    {
+        ELifecycleState State = ELifecycleState::Active;
+        EDisplayPower Power = EDisplayPower::On;
+        bool bVisible = true;
+        int64_t EnteredAtMs = 0;
+        int64_t HiddenSinceMs = -1;
+        int64_t TotalMs[static_cast<size_t>(ELifecycleState::Count)] = {};
+    };
+
+    bool IsPowerVisible(EDisplayPower Power) const
+    {
+        return Power == EDisplayPower::On || (Power == EDisplayPower::Dimmed && !Settings.bPauseWhenDimmed);
+    }
+
+    FLifecycleSettings Settings;
+    std::vector<FMonitor> Monitors;
+    EDisplayPower DefaultPower = EDisplayPower::On;
+    bool bLocked = false;
+    bool bConnected = true;
+};
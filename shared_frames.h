@@ -0,0 +1,356 @@
+// SharedFrames - Frame ring shared between the decode service and its sessions.
+// One memory segment per decoded stream: a header describing the video, then a few
+// frame slots. The service copies frame n into slot n % slots and then publishes n;
+// each slot carries its own sequence counter, odd while it is being written, so a
+// session copying a slot that the service laps meanwhile sees the counter move and
+// retries with the newest frame instead of showing a torn one. The writer never
+// waits for readers: a slow session skips frames, it cannot stall the others.
+// Segment names carry the serving process's id and a hash of the (video,
+// resolution) pair, so every session asking one service for the same wallpaper at
+// the same size lands on the same segment, and a service only ever sweeps the
+// segments of services that are gone. Requests travel over the control endpoint's
+// framing: "attach <W>x<H> <path>" is answered with "ok <segment> <bytes>", after
+// which the connection is the session's lease.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "control_protocol.h"
+#include "video_source.h"
+
+/** Socket file stem (or pipe name) of the decode service. */
+constexpr const char* DecodeServiceEndpointName = "VideoWallpaperDecoder";
+
+/** Segment names are this prefix, the owning service's process id, '.' and a hash of the stream key. */
+constexpr const char* SharedStreamPrefix = "VideoWallpaper.stream.";
+
+constexpr uint32_t SharedFrameMagic = 0x46535756;  // "VWSF"
+constexpr uint32_t SharedFrameVersion = 1;
+
+/** Newest frame, the one being written, and one for a reader that is still copying. */
+constexpr uint32_t SharedFrameSlots = 3;
+
+/** Lapped reads retried before a read gives up until the next frame. */
+constexpr int32_t SharedFrameReadAttempts = 4;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must not need a lock");
+
+/** At offset 0 of a segment. Written once by the service before any client maps it, except the atomics. */
+struct alignas(64) FSharedStreamHeader
+{
+    std::atomic<uint32_t> Magic{ 0 };   // Set last, once the rest is written
+    uint32_t Version = 0;
+    int32_t Width = 0;
+    int32_t Height = 0;
+    int32_t Format = 0;                 // EPixelFormat
+    int32_t Strides[2] = {};
+    uint32_t FrameRateNumerator = 0;
+    uint32_t FrameRateDenominator = 0;
+    uint32_t SlotCount = 0;
+    int64_t Duration100ns = 0;
+    uint64_t PlaneOffsets[2] = {};      // Within a slot's pixels
+    uint64_t SlotBytes = 0;             // Slot header and pixels
+    std::atomic<uint64_t> Published{ 0 };   // Newest complete frame; 0 before the first
+    std::atomic<uint32_t> Clients{ 0 };     // Attached sessions, for inspection
+    std::atomic<uint32_t> bClosed{ 0 };     // The service gave the stream up
+};
+
+struct alignas(64) FSharedSlotHeader
+{
+    std::atomic<uint64_t> Sequence{ 0 };    // 2n - 1 while frame n is written, 2n once it is complete
+    int64_t Timestamp100ns = 0;
+};
+
+/** Where frames of one layout go in a segment. */
+struct FSharedStreamLayout
+{
+    int32_t Strides[2] = {};
+    uint64_t PlaneOffsets[2] = {};
+    uint64_t SlotBytes = 0;
+    uint64_t TotalBytes = 0;
+};
+
+inline uint64_t AlignSharedBytes(uint64_t Value) { return (Value + 63) & ~uint64_t(63); }
+
+/** Zero TotalBytes for a format or size frames cannot have. */
+inline FSharedStreamLayout GetSharedStreamLayout(int32_t Width, int32_t Height, EPixelFormat Format)
+{
+    FSharedStreamLayout Layout;
+    int32_t Bpp = BytesPerPixel(Format);
+    if (Width <= 0 || Height <= 0 || !Bpp) return Layout;
+
+    Layout.Strides[0] = static_cast<int32_t>(AlignSharedBytes(static_cast<uint64_t>(Width) * Bpp));
+    uint64_t PixelBytes = static_cast<uint64_t>(Layout.Strides[0]) * Height;
+    if (PlaneCount(Format) == 2)
+    {
+        Layout.Strides[1] = Layout.Strides[0];
+        Layout.PlaneOffsets[1] = PixelBytes;
+        PixelBytes += static_cast<uint64_t>(Layout.Strides[1]) * ((Height + 1) / 2);
+    }
+    Layout.SlotBytes = sizeof(FSharedSlotHeader) + AlignSharedBytes(PixelBytes);
+    Layout.TotalBytes = sizeof(FSharedStreamHeader) + Layout.SlotBytes * SharedFrameSlots;
+    return Layout;
+}
+
+/** FNV-1a over the stream key, so a name fits any platform's limit whatever the path. */
+inline std::string GetSharedStreamName(int64_t OwnerId, std::string_view Path, int32_t Width, int32_t Height)
+{
+    std::string Key = std::string(Path) + '\n' + std::to_string(Width) + 'x' + std::to_string(Height);
+    uint64_t Hash = 14695981039346656037ULL;
+    for (char Char : Key)
+    {
+        Hash ^= static_cast<uint8_t>(Char);
+        Hash *= 1099511628211ULL;
+    }
+    char Digits[17];
+    for (int32_t Index = 15; Index >= 0; --Index, Hash >>= 4) Digits[Index] = "0123456789abcdef"[Hash & 15];
+    Digits[16] = '\0';
+    return SharedStreamPrefix + std::to_string(OwnerId) + '.' + std::string(Digits);
+}
+
+/** Owning process id of a segment name; false for names that are not segments or lack one. */
+inline bool ParseSharedStreamOwner(std::string_view Name, int64_t& OwnerId)
+{
+    std::string_view Prefix = SharedStreamPrefix;
+    if (!Name.starts_with(Prefix)) return false;
+    Name.remove_prefix(Prefix.size());
+    size_t Dot = Name.find('.');
+    if (Dot == 0 || Dot == std::string_view::npos || Dot > 18) return false;
+    OwnerId = 0;
+    for (char Char : Name.substr(0, Dot))
+    {
+        if (Char < '0' || Char > '9') return false;
+        OwnerId = OwnerId * 10 + (Char - '0');
+    }
+    return true;
+}
+
+inline std::string FormatAttachRequest(std::string_view Path, int32_t Width, int32_t Height)
+{
+    return "attach " + std::to_string(Width) + 'x' + std::to_string(Height) + ' ' + std::string(Path);
+}
+
+/** Argument of "attach": "<W>x<H> <path>". */
+inline bool ParseAttachArgument(std::string_view Argument, std::string& Path, int32_t& Width, int32_t& Height)
+{
+    std::string_view Size;
+    std::string_view Rest;
+    SplitControlWord(Argument, Size, Rest);
+    std::string SizeText(Size);
+    char* End = nullptr;
+    Width = static_cast<int32_t>(std::strtol(SizeText.c_str(), &End, 10));
+    if (*End != 'x') return false;
+    Height = static_cast<int32_t>(std::strtol(End + 1, &End, 10));
+    if (*End != '\0' || Width <= 0 || Height <= 0 || Rest.empty()) return false;
+    Path.assign(Rest);
+    return true;
+}
+
+/** Service side: formats a segment and publishes frames into it. */
+class FSharedFrameWriter
+{
+public:
+    /** Memory must be zeroed and at least GetSharedStreamLayout(...).TotalBytes long. */
+    bool Initialize(void* Memory, size_t Size, const FVideoInfo& Info)
+    {
+        Layout = GetSharedStreamLayout(Info.Width, Info.Height, Info.Format);
+        if (!Layout.TotalBytes || Size < Layout.TotalBytes) return false;
+
+        Base = static_cast<uint8_t*>(Memory);
+        Header = new (Base) FSharedStreamHeader();
+        Header->Width = Info.Width;
+        Header->Height = Info.Height;
+        Header->Format = static_cast<int32_t>(Info.Format);
+        Header->FrameRateNumerator = Info.FrameRateNumerator;
+        Header->FrameRateDenominator = Info.FrameRateDenominator;
+        Header->Duration100ns = Info.Duration100ns;
+        Header->SlotCount = SharedFrameSlots;
+        Header->SlotBytes = Layout.SlotBytes;
+        for (int32_t Plane = 0; Plane < 2; ++Plane)
+        {
+            Header->Strides[Plane] = Layout.Strides[Plane];
+            Header->PlaneOffsets[Plane] = Layout.PlaneOffsets[Plane];
+        }
+        for (uint32_t Slot = 0; Slot < SharedFrameSlots; ++Slot) new (GetSlot(Slot)) FSharedSlotHeader();
+        Header->Version = SharedFrameVersion;
+        // Last, so a client that maps the segment early sees it as not ready rather than half written.
+        Header->Magic.store(SharedFrameMagic, std::memory_order_release);
+        return true;
+    }
+
+    /** False if View does not have the segment's layout. */
+    bool Publish(const FFrameView& View, int64_t Timestamp100ns)
+    {
+        if (!Header || View.Width != Header->Width || View.Height != Header->Height
+            || static_cast<int32_t>(View.Format) != Header->Format)
+        {
+            return false;
+        }
+
+        uint64_t Sequence = Header->Published.load(std::memory_order_relaxed) + 1;
+        FSharedSlotHeader* Slot = GetSlot(static_cast<uint32_t>(Sequence % SharedFrameSlots));
+        Slot->Sequence.store(Sequence * 2 - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Slot->Timestamp100ns = Timestamp100ns;
+        uint8_t* Pixels = reinterpret_cast<uint8_t*>(Slot) + sizeof(FSharedSlotHeader);
+        int32_t Bpp = BytesPerPixel(View.Format);
+        for (int32_t Plane = 0; Plane < PlaneCount(View.Format); ++Plane)
+        {
+            int32_t Rows = Plane ? (View.Height + 1) / 2 : View.Height;
+            size_t RowBytes = static_cast<size_t>(View.Width) * Bpp;
+            uint8_t* Target = Pixels + Layout.PlaneOffsets[Plane];
+            for (int32_t Y = 0; Y < Rows; ++Y)
+            {
+                std::memcpy(Target + static_cast<size_t>(Y) * Layout.Strides[Plane], View.Row(Plane, Y), RowBytes);
+            }
+        }
+
+        Slot->Sequence.store(Sequence * 2, std::memory_order_release);
+        Header->Published.store(Sequence, std::memory_order_release);
+        return true;
+    }
+
+    /** Tells clients the stream is gone for good (decoder failure, shutdown). */
+    void Close()
+    {
+        if (Header) Header->bClosed.store(1, std::memory_order_release);
+    }
+
+    void SetClients(uint32_t Clients)
+    {
+        if (Header) Header->Clients.store(Clients, std::memory_order_relaxed);
+    }
+
+    uint64_t GetPublished() const { return Header ? Header->Published.load(std::memory_order_relaxed) : 0; }
+
+private:
+    FSharedSlotHeader* GetSlot(uint32_t Slot) const
+    {
+        return reinterpret_cast<FSharedSlotHeader*>(Base + sizeof(FSharedStreamHeader) + Slot * Layout.SlotBytes);
+    }
+
+    uint8_t* Base = nullptr;
+    FSharedStreamHeader* Header = nullptr;
+    FSharedStreamLayout Layout;
+};
+
+enum class ESharedReadResult : uint8_t
+{
+    NoNewFrame,     // Nothing published since the last read, or every attempt was lapped
+    Frame,
+    Closed          // The service gave the stream up
+};
+
+/** Session side: copies the newest frame out of a mapped segment. Never writes to it. */
+class FSharedFrameReader
+{
+public:
+    /** False if the segment is too small or not (yet) a segment of this version. */
+    bool Attach(const void* Memory, size_t Size)
+    {
+        Header = static_cast<const FSharedStreamHeader*>(Memory);
+        if (Size < sizeof(FSharedStreamHeader)
+            || Header->Magic.load(std::memory_order_acquire) != SharedFrameMagic
+            || Header->Version != SharedFrameVersion || Header->SlotCount != SharedFrameSlots)
+        {
+            Header = nullptr;
+            return false;
+        }
+
+        Info = {};
+        Info.Width = Header->Width;
+        Info.Height = Header->Height;
+        Info.Format = static_cast<EPixelFormat>(Header->Format);
+        Info.FrameRateNumerator = Header->FrameRateNumerator;
+        Info.FrameRateDenominator = Header->FrameRateDenominator;
+        Info.Duration100ns = Header->Duration100ns;
+        FSharedStreamLayout Expected = GetSharedStreamLayout(Info.Width, Info.Height, Info.Format);
+        if (!Expected.TotalBytes || Size < Expected.TotalBytes || Expected.SlotBytes != Header->SlotBytes
+            || Expected.Strides[0] != Header->Strides[0] || Expected.PlaneOffsets[1] != Header->PlaneOffsets[1])
+        {
+            Header = nullptr;
+            return false;
+        }
+        Layout = Expected;
+        Base = static_cast<const uint8_t*>(Memory);
+        LastSequence = 0;
+        return true;
+    }
+
+    const FVideoInfo& GetInfo() const { return Info; }
+
+    ESharedReadResult Read(FFrame& Out)
+    {
+        if (!Header || Header->bClosed.load(std::memory_order_acquire)) return ESharedReadResult::Closed;
+        for (int32_t Attempt = 0; Attempt < SharedFrameReadAttempts; ++Attempt)
+        {
+            uint64_t Sequence = Header->Published.load(std::memory_order_acquire);
+            if (Sequence == LastSequence) return ESharedReadResult::NoNewFrame;
+
+            const FSharedSlotHeader* Slot = GetSlot(static_cast<uint32_t>(Sequence % SharedFrameSlots));
+            if (Slot->Sequence.load(std::memory_order_acquire) != Sequence * 2)
+            {
+                ++LappedReads;
+                continue;
+            }
+            CopySlot(Slot, Out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Slot->Sequence.load(std::memory_order_relaxed) != Sequence * 2)
+            {
+                ++LappedReads;
+                continue;
+            }
+
+            if (LastSequence && Sequence > LastSequence + 1) SkippedFrames += Sequence - LastSequence - 1;
+            LastSequence = Sequence;
+            return ESharedReadResult::Frame;
+        }
+        return ESharedReadResult::NoNewFrame;
+    }
+
+    uint64_t GetLastSequence() const { return LastSequence; }
+    uint64_t GetSkippedFrames() const { return SkippedFrames; }
+    uint64_t GetLappedReads() const { return LappedReads; }
+
+private:
+    const FSharedSlotHeader* GetSlot(uint32_t Slot) const
+    {
+        return reinterpret_cast<const FSharedSlotHeader*>(Base + sizeof(FSharedStreamHeader) + Slot * Layout.SlotBytes);
+    }
+
+    void CopySlot(const FSharedSlotHeader* Slot, FFrame& Out) const
+    {
+        Out.Allocate(Info.Width, Info.Height, Info.Format);
+        Out.Timestamp100ns = Slot->Timestamp100ns;
+        const uint8_t* Pixels = reinterpret_cast<const uint8_t*>(Slot) + sizeof(FSharedSlotHeader);
+        const FFrameView& View = Out.GetView();
+        size_t RowBytes = static_cast<size_t>(Info.Width) * BytesPerPixel(Info.Format);
+        for (int32_t Plane = 0; Plane < PlaneCount(Info.Format); ++Plane)
+        {
+            int32_t Rows = Plane ? (Info.Height + 1) / 2 : Info.Height;
+            const uint8_t* Source = Pixels + Layout.PlaneOffsets[Plane];
+            for (int32_t Y = 0; Y < Rows; ++Y)
+            {
+                std::memcpy(View.Row(Plane, Y), Source + static_cast<size_t>(Y) * Layout.Strides[Plane], RowBytes);
+            }
+        }
+    }
+
+    const uint8_t* Base = nullptr;
+    const FSharedStreamHeader* Header = nullptr;
+    FSharedStreamLayout Layout;
+    FVideoInfo Info;
+    uint64_t LastSequence = 0;
+    uint64_t SkippedFrames = 0;
+    uint64_t LappedReads = 0;
+};
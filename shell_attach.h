@@ -0,0 +1,121 @@
+// ShellAttach - Re-attach state machine for shell (Explorer) restarts.
+// The wallpaper windows are children of the shell's desktop windows, so they die
+// when the shell does, while the decode pipelines (players, software presenter)
+// survive. This machine decides when to suspend presentation, when to look for
+// the new desktop windows (on the shell's restart broadcast, or on a backoff
+// schedule if that never arrives), and when to give up and reload everything.
+// Pure logic: the caller supplies the time and carries out the returned actions.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+
+enum class EShellAttachState : uint8_t
+{
+    Attached,       // Wallpaper windows are hosted and presenting
+    Lost,           // Host died; waiting for the shell to come back
+    Discovering,    // Retrying to find the new desktop windows
+    Failed          // Gave up; the caller reloads from scratch
+};
+
+enum class EShellAttachAction : uint8_t
+{
+    None,
+    Suspend,        // Pause presentation; keep pipelines (and their positions) alive
+    Discover,       // Look for the desktop windows, then report with OnDiscoveryResult
+    Resume,         // Windows re-created and re-bound; continue presenting
+    Reload          // Tear everything down and start over
+};
+
+struct FShellAttachSettings
+{
+    int64_t SettleDelayMs = 1000;   // First attempt without a restart broadcast
+    int64_t RetryInitialMs = 250;
+    int64_t RetryMaxMs = 4000;
+    int64_t GiveUpMs = 60000;       // Longest time without a host before reloading
+};
+
+class FShellAttachMachine
+{
+public:
+    explicit FShellAttachMachine(const FShellAttachSettings& InSettings = {}) : Settings(InSettings) {}
+
+    EShellAttachState GetState() const { return State; }
+    bool IsAttached() const { return State == EShellAttachState::Attached; }
+
+    /** A wallpaper window was destroyed by someone other than us. */
+    EShellAttachAction OnHostLost(int64_t NowMs)
+    {
+        if (State != EShellAttachState::Attached) return EShellAttachAction::None;
+        State = EShellAttachState::Lost;
+        LostAtMs = NowMs;
+        NextAttemptMs = NowMs + Settings.SettleDelayMs;
+        Attempts = 0;
+        ++LossCount;
+        return EShellAttachAction::Suspend;
+    }
+
+    /** The shell announced itself (TaskbarCreated): try right away, or reload again if an earlier reload failed. */
+    EShellAttachAction OnShellRestarted(int64_t NowMs)
+    {
+        if (State == EShellAttachState::Failed) return EShellAttachAction::Reload;
+        if (State != EShellAttachState::Lost && State != EShellAttachState::Discovering) return EShellAttachAction::None;
+        State = EShellAttachState::Discovering;
+        NextAttemptMs = NowMs;
+        return EShellAttachAction::Discover;
+    }
+
+    EShellAttachAction OnTick(int64_t NowMs)
+    {
+        if (State != EShellAttachState::Lost && State != EShellAttachState::Discovering) return EShellAttachAction::None;
+        if (NowMs - LostAtMs >= Settings.GiveUpMs)
+        {
+            State = EShellAttachState::Failed;
+            return EShellAttachAction::Reload;
+        }
+        if (NowMs < NextAttemptMs) return EShellAttachAction::None;
+        State = EShellAttachState::Discovering;
+        return EShellAttachAction::Discover;
+    }
+
+    /** Outcome of a Discover action, including re-creating and re-binding the windows. */
+    EShellAttachAction OnDiscoveryResult(bool bAttached, int64_t NowMs)
+    {
+        if (State != EShellAttachState::Discovering) return EShellAttachAction::None;
+        ++Attempts;
+        if (bAttached)
+        {
+            State = EShellAttachState::Attached;
+            LastDowntimeMs = NowMs - LostAtMs;
+            ++ReattachCount;
+            return EShellAttachAction::Resume;
+        }
+        int32_t Shift = Attempts - 1 < 16 ? Attempts - 1 : 16;
+        int64_t Delay = Settings.RetryInitialMs << Shift;
+        NextAttemptMs = NowMs + (Delay < Settings.RetryMaxMs ? Delay : Settings.RetryMaxMs);
+        return EShellAttachAction::None;
+    }
+
+    /** After the caller reloaded (or started fresh), everything is attached again. */
+    void Reset()
+    {
+        State = EShellAttachState::Attached;
+        Attempts = 0;
+    }
+
+    int32_t GetAttempts() const { return Attempts; }
+    int64_t GetLastDowntimeMs() const { return LastDowntimeMs; }
+    uint32_t GetLossCount() const { return LossCount; }
+    uint32_t GetReattachCount() const { return ReattachCount; }
+
+private:
+    FShellAttachSettings Settings;
+    EShellAttachState State = EShellAttachState::Attached;
+    int64_t LostAtMs = 0;
+    int64_t NextAttemptMs = 0;
+    int64_t LastDowntimeMs = 0;
+    int32_t Attempts = 0;
+    uint32_t LossCount = 0;
+    uint32_t ReattachCount = 0;
+};
@@ -0,0 +1,311 @@
+// shell_bench - Shell restart simulator for the re-attach state machine.
+// A fake shell dies and comes back on a script: its desktop windows reappear some
+// time after it restarts, its TaskbarCreated broadcast may come before they exist
+// or not at all, and creating a wallpaper window under it can fail. A fake host
+// drives FShellAttachMachine the way the window procedure does - host-lost on the
+// wallpaper window's destruction, the broadcast, the 500 ms update timer - and
+// carries out its actions: suspend pauses the players, discover re-creates the
+// missing windows and re-binds the players, resume plays on, reload starts over
+// from the beginning of the video. Checks that every scripted restart re-attaches
+// without a reload once the shell is back, within the retry schedule, keeping the
+// players' positions; that a shell that never returns is reloaded after the
+// give-up time and a failed reload is retried on the next broadcast; that partial
+// re-attaches keep the windows that succeeded; and that retries stay bounded.
+//   g++ -std=c++20 -O2 -pthread shell_bench.cpp -o shell_bench
+//   shell_bench [--monitors N] [--crashes N] [--seed N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "shell_attach.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    /** The window procedure's update timer (TimerIntervalMs). */
+    constexpr int64_t TickMs = 500;
+
+    struct FBenchOptions
+    {
+        int32_t Monitors = 3;
+        int32_t Crashes = 200;
+        uint32_t Seed = 1;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--monitors") Options.Monitors = std::atoi(Value);
+            else if (Name == "--crashes") Options.Crashes = std::atoi(Value);
+            else if (Name == "--seed") Options.Seed = static_cast<uint32_t>(std::atoll(Value));
+            else return false;
+        }
+        return Options.Monitors > 0 && Options.Crashes > 0;
+    }
+
+    /** One shell lifetime: when it dies, when it is back, when its desktop windows exist. */
+    struct FShellOutage
+    {
+        int64_t CrashMs = 0;
+        int64_t RestartMs = -1;         // TaskbarCreated broadcast; -1: never sent
+        int64_t ReadyMs = -1;           // Desktop windows exist from here on; -1: never
+        int32_t FailedCreates = 0;      // Window creations that fail after ReadyMs, one per attempt
+    };
+
+    struct FSimMonitor
+    {
+        bool bWindow = true;
+        bool bPlaying = true;
+        int64_t PositionMs = 0;
+    };
+
+    /** The wallpaper as RunShellAttachAction sees it, over a scripted shell. */
+    class FShellSimulator
+    {
+    public:
+        FShellSimulator(int32_t MonitorCount, const FShellAttachSettings& Settings = {})
+            : Machine(Settings), Monitors(static_cast<size_t>(MonitorCount)) {}
+
+        void Run(const std::vector<FShellOutage>& Outages, int64_t EndMs)
+        {
+            Script = Outages;
+            for (int64_t Now = 0; Now < EndMs; Now += StepMs)
+            {
+                for (const FShellOutage& Outage : Script)
+                {
+                    if (Outage.CrashMs == Now) Crash(Now);
+                    if (Outage.RestartMs == Now) Act(Machine.OnShellRestarted(Now), Now);
+                }
+                if (Now % TickMs == 0 && !Machine.IsAttached()) Act(Machine.OnTick(Now), Now);
+                AdvancePlayback(StepMs);
+            }
+        }
+
+        FShellAttachMachine Machine;
+        std::vector<FSimMonitor> Monitors;
+        int32_t Discoveries = 0;
+        int32_t WindowsCreated = 0;
+        int32_t Reloads = 0;
+        int32_t FailedReloads = 0;
+        int64_t MaxDowntimeMs = 0;
+        int64_t LastResumeMs = -1;
+
+    private:
+        static constexpr int64_t StepMs = 10;
+
+        void AdvancePlayback(int64_t Ms)
+        {
+            for (auto& Monitor : Monitors)
+            {
+                if (Monitor.bPlaying) Monitor.PositionMs += Ms;
+            }
+        }
+
+        /** The shell takes our windows with it; each destruction reports the host lost. */
+        void Crash(int64_t Now)
+        {
+            for (auto& Monitor : Monitors)
+            {
+                if (!Monitor.bWindow) continue;
+                Monitor.bWindow = false;
+                Act(Machine.OnHostLost(Now), Now);
+            }
+        }
+
+        /** The last scripted outage that has started decides what the shell looks like. */
+        FShellOutage* GetShell(int64_t Now)
+        {
+            FShellOutage* Latest = nullptr;
+            for (auto& Outage : Script)
+            {
+                if (Outage.CrashMs <= Now) Latest = &Outage;
+            }
+            return Latest;
+        }
+
+        bool IsShellReady(int64_t Now)
+        {
+            const FShellOutage* Shell = GetShell(Now);
+            return !Shell || (Shell->ReadyMs >= 0 && Now >= Shell->ReadyMs);
+        }
+
+        /** ReattachToShell: only the monitors without a window are retried. */
+        bool Reattach(int64_t Now)
+        {
+            ++Discoveries;
+            if (!IsShellReady(Now)) return false;
+            FShellOutage* Shell = GetShell(Now);
+            for (auto& Monitor : Monitors)
+            {
+                if (Monitor.bWindow) continue;
+                if (Shell && Shell->FailedCreates > 0)
+                {
+                    --Shell->FailedCreates;
+                    return false;
+                }
+                Monitor.bWindow = true;
+                ++WindowsCreated;
+            }
+            return true;
+        }
+
+        void Act(EShellAttachAction Action, int64_t Now)
+        {
+            switch (Action)
+            {
+            case EShellAttachAction::Suspend:
+                for (auto& Monitor : Monitors) Monitor.bPlaying = false;
+                break;
+            case EShellAttachAction::Discover:
+                Act(Machine.OnDiscoveryResult(Reattach(Now), Now), Now);
+                break;
+            case EShellAttachAction::Resume:
+                for (auto& Monitor : Monitors) Monitor.bPlaying = true;
+                if (Machine.GetLastDowntimeMs() > MaxDowntimeMs) MaxDowntimeMs = Machine.GetLastDowntimeMs();
+                LastResumeMs = Now;
+                break;
+            case EShellAttachAction::Reload:
+                // ReloadWallpaper: everything is rebuilt, playback starts over.
+                if (!IsShellReady(Now))
+                {
+                    ++FailedReloads;
+                    break;
+                }
+                ++Reloads;
+                for (auto& Monitor : Monitors) Monitor = FSimMonitor{};
+                Machine.Reset();
+                LastResumeMs = Now;
+                break;
+            case EShellAttachAction::None:
+                break;
+            }
+        }
+
+        std::vector<FShellOutage> Script;
+    };
+
+    bool AllPlaying(const FShellSimulator& Sim)
+    {
+        bool bAll = Sim.Machine.IsAttached();
+        for (const auto& Monitor : Sim.Monitors) bAll &= Monitor.bWindow && Monitor.bPlaying;
+        return bAll;
+    }
+
+    bool CheckScripted(int32_t MonitorCount)
+    {
+        bool bPass = true;
+        FShellAttachSettings Settings;
+
+        // Explorer restarts in two seconds and announces itself once its windows exist.
+        FShellSimulator Quick(MonitorCount);
+        Quick.Run({ { 10000, 12000, 12000, 0 } }, 20000);
+        bPass &= Check(AllPlaying(Quick) && Quick.Reloads == 0, "quick restart re-attaches");
+        bPass &= Check(Quick.LastResumeMs == 12000, "re-attached on the broadcast");
+        bPass &= Check(Quick.MaxDowntimeMs == 2000, "downtime is the outage");
+        bPass &= Check(Quick.Monitors[0].PositionMs == 20000 - 2000, "players keep their position");
+        bPass &= Check(Quick.Machine.GetLossCount() == 1, "one loss for all windows");
+
+        // The broadcast comes before the desktop windows do: the backoff finds them.
+        FShellSimulator Early(MonitorCount);
+        Early.Run({ { 10000, 11000, 12300, 0 } }, 30000);
+        bPass &= Check(AllPlaying(Early) && Early.Reloads == 0, "early broadcast still re-attaches");
+        bPass &= Check(Early.Discoveries > 1 && Early.LastResumeMs >= 12300
+            && Early.LastResumeMs <= 12300 + Settings.RetryMaxMs + TickMs, "retries find windows that appear later");
+
+        // No broadcast at all: the settle delay and the timer carry it.
+        FShellSimulator Silent(MonitorCount);
+        Silent.Run({ { 10000, -1, 13000, 0 } }, 30000);
+        bPass &= Check(AllPlaying(Silent) && Silent.Reloads == 0, "missed broadcast still re-attaches");
+        bPass &= Check(Silent.LastResumeMs <= 13000 + Settings.RetryMaxMs + TickMs, "re-attached within one retry period");
+
+        // One window fails to be created on the first two attempts; the others are kept.
+        FShellSimulator Partial(MonitorCount);
+        Partial.Run({ { 10000, 12000, 12000, 2 } }, 30000);
+        bPass &= Check(AllPlaying(Partial) && Partial.Reloads == 0, "failed window creations are retried");
+        bPass &= Check(Partial.WindowsCreated == MonitorCount, "each window re-created once");
+
+        // The shell dies again while we are still looking for it.
+        FShellSimulator Twice(MonitorCount);
+        Twice.Run({ { 10000, 11000, 11000, 0 }, { 11200, 14000, 14000, 0 } }, 30000);
+        bPass &= Check(AllPlaying(Twice) && Twice.Reloads == 0 && Twice.Machine.GetReattachCount() == 2, "back-to-back restarts");
+
+        // The shell is gone for good, then comes back much later.
+        FShellSimulator Gone(MonitorCount);
+        Gone.Run({ { 10000, 100000, 100000, 0 } }, 120000);
+        bPass &= Check(Gone.FailedReloads == 1, "reload after the give-up time while the shell is gone");
+        bPass &= Check(Gone.Reloads == 1 && AllPlaying(Gone) && Gone.LastResumeMs == 100000, "failed reload retried on the broadcast");
+        int64_t MaxAttempts = (Settings.GiveUpMs - Settings.SettleDelayMs) / Settings.RetryMaxMs + 8;
+        bPass &= Check(Gone.Discoveries <= MaxAttempts, "retries back off while the shell is gone");
+
+        // A broadcast while attached, or ticks while attached, do nothing.
+        FShellAttachMachine Idle;
+        bPass &= Check(Idle.OnShellRestarted(0) == EShellAttachAction::None && Idle.OnTick(0) == EShellAttachAction::None
+            && Idle.OnDiscoveryResult(true, 0) == EShellAttachAction::None, "attached machine ignores restarts and ticks");
+        return bPass;
+    }
+
+    bool RunCrashLoop(const FBenchOptions& Options)
+    {
+        // Random outages a minute apart: restart after 0.5-10 s, windows up to 3 s after
+        // that, one broadcast in five lost and the odd failed window creation.
+        std::mt19937 Random(Options.Seed);
+        std::vector<FShellOutage> Outages;
+        int64_t Now = 5000;
+        for (int32_t Crash = 0; Crash < Options.Crashes; ++Crash)
+        {
+            FShellOutage Outage;
+            Outage.CrashMs = Now / 10 * 10;
+            int64_t Restart = Outage.CrashMs + 500 + static_cast<int64_t>(Random() % 950) * 10;
+            Outage.ReadyMs = Restart + static_cast<int64_t>(Random() % 300) * 10;
+            Outage.RestartMs = Random() % 5 == 0 ? -1 : Restart;
+            Outage.FailedCreates = Random() % 4 == 0 ? 1 : 0;
+            Outages.push_back(Outage);
+            Now += 60000;
+        }
+
+        FShellSimulator Sim(Options.Monitors);
+        Sim.Run(Outages, Now);
+        int64_t Played = Sim.Monitors[0].PositionMs;
+        int64_t Total = Now;
+        std::printf("%d crash(es): %u re-attach(es), %d reload(s), %d discovery attempt(s), longest downtime %lld ms, %.2f%% of the time suspended\n",
+            Options.Crashes, Sim.Machine.GetReattachCount(), Sim.Reloads, Sim.Discoveries,
+            static_cast<long long>(Sim.MaxDowntimeMs), 100.0 * (Total - Played) / Total);
+
+        FShellAttachSettings Settings;
+        bool bPass = Check(Sim.Reloads == 0 && static_cast<int32_t>(Sim.Machine.GetReattachCount()) == Options.Crashes,
+            "every outage re-attached without a reload");
+        bPass &= Check(AllPlaying(Sim), "playing at the end");
+        bPass &= Check(Sim.MaxDowntimeMs <= 10000 + 3000 + Settings.RetryMaxMs + 2 * TickMs, "downtime bounded by the retry schedule");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: shell_bench [--monitors N] [--crashes N] [--seed N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckScripted(Options.Monitors), "scripted restarts");
+    bPass &= Check(RunCrashLoop(Options), "crash loop");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
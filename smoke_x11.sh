@@ -0,0 +1,84 @@
+#!/bin/sh
+# X11 smoke test: runs videowallpaper-x11 headless under Xvfb and checks that frames
+# reach the screen - on the root window and in desktop windows, cloned and spanned,
+# with the codec-free sources (test pattern, a mostly static scene, a 10-bit P010
+# pattern) and under a memory ceiling - then that vwctl drives a running instance
+# over the control socket (status, pause, resume, video, an error reply, quit) and
+# that the socket is gone after it exits. Needs no ffmpeg. Run ./build.sh first.
+# Needs xvfb-run (Debian/Ubuntu: xvfb).
+# Usage: ./smoke_x11.sh [seconds per run]
+# Exit code: 0 when every run passes, 1 on a failed run, 2 if Xvfb or the binaries are missing.
+
+RUN_SECONDS=${1:-3}
+SCREEN="-screen 0 1920x1080x24"
+
+if ! command -v xvfb-run >/dev/null 2>&1; then
+    echo "xvfb-run not found (Debian/Ubuntu: apt install xvfb)."
+    exit 2
+fi
+if [ ! -x ./videowallpaper-x11 ] || [ ! -x ./vwctl ]; then
+    echo "Build first: ./build.sh"
+    exit 2
+fi
+
+FAILURES=0
+
+# run_case NAME ARGS...: one timed run; passes if it exits 0 having presented frames.
+run_case() {
+    NAME=$1
+    shift
+    OUTPUT=$(xvfb-run -a -s "$SCREEN" ./videowallpaper-x11 --seconds "$RUN_SECONDS" "$@" 2>&1)
+    STATUS=$?
+    FRAMES=$(printf '%s\n' "$OUTPUT" | sed -n 's/^frames=\([0-9]*\) .*/\1/p')
+    if [ "$STATUS" -eq 0 ] && [ "${FRAMES:-0}" -gt 0 ]; then
+        echo "ok   $NAME: $FRAMES frames"
+    else
+        echo "FAIL $NAME (exit $STATUS)"
+        printf '%s\n' "$OUTPUT" | sed 's/^/     /'
+        FAILURES=$((FAILURES + 1))
+    fi
+}
+
+run_case "root window" --host root --pattern
+run_case "desktop windows" --host desktop --pattern
+run_case "span" --mode span --pattern
+run_case "static scene" ":pattern:scene=static,size=1280x720"
+run_case "p010" ":pattern:format=p010,size=1280x720"
+run_case "memory ceiling" --memory-ceiling-mb 64 --pattern
+
+# The control socket lives in a runtime directory of this run, so a desktop session's instance is not touched.
+RUNTIME_DIR=$(mktemp -d)
+xvfb-run -a -s "$SCREEN" env XDG_RUNTIME_DIR="$RUNTIME_DIR" sh -c '
+    ./videowallpaper-x11 --seconds 60 --pattern > "$XDG_RUNTIME_DIR/output.txt" 2>&1 &
+    PID=$!
+    for TRY in 1 2 3 4 5 6 7 8 9 10; do
+        [ -S "$XDG_RUNTIME_DIR/VideoWallpaper.sock" ] && break
+        sleep 0.5
+    done
+    ./vwctl status | grep -q "^state=playing" || exit 11
+    ./vwctl pause | grep -q "^paused" || exit 12
+    ./vwctl status | grep -q "^state=paused" || exit 13
+    ./vwctl resume | grep -q "^playing" || exit 14
+    ./vwctl video ":pattern:scene=static" | grep -q "^playing" || exit 15
+    ./vwctl set crossfade_ms 0 >/dev/null 2>&1
+    [ $? -eq 1 ] || exit 16
+    ./vwctl quit | grep -q "^quitting" || exit 17
+    wait $PID || exit 18
+    [ ! -e "$XDG_RUNTIME_DIR/VideoWallpaper.sock" ] || exit 19
+'
+STATUS=$?
+if [ "$STATUS" -eq 0 ]; then
+    echo "ok   control socket"
+else
+    echo "FAIL control socket (step $STATUS)"
+    sed 's/^/     /' "$RUNTIME_DIR/output.txt" 2>/dev/null
+    FAILURES=$((FAILURES + 1))
+fi
+rm -rf "$RUNTIME_DIR"
+
+if [ "$FAILURES" -eq 0 ]; then
+    echo "PASS"
+    exit 0
+fi
+echo "FAIL: $FAILURES run(s)"
+exit 1
@@ -0,0 +1,470 @@
+// soak - Long-run leak benchmark for the portable presentation stack.
+// Runs thousands of video switches, display changes and pause/resume cycles through
+// the software compositor against a simulator backend (synthetic NV12 videos and
+// in-memory windows and device contexts) with resource tracking on. At every
+// checkpoint the scene is put back into one fixed configuration, whose counters
+// must match the baseline taken after warm-up exactly; resident memory may grow by
+// no more than --rss-mb. Builds and runs anywhere the portable headers do:
+//   g++ -std=c++20 -O2 -pthread soak.cpp -o soak          (add -lpsapi on MinGW)
+//   soak [--cycles N] [--frames N] [--seed N] [--rss-mb N] [--leak-every N]
+// --leak-every deliberately leaks a tracked frame every N cycles, to check the check.
+// Exit code: 0 when nothing grew, 1 on growth, 2 on bad usage.
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "compositor.h"
+#include "resource_tracker.h"
+#include "session_lifecycle.h"
+#include "thread_pool.h"
+#include "video_source.h"
+
+namespace
+{
+    struct FSize
+    {
+        int32_t Width;
+        int32_t Height;
+    };
+
+    /** Video and monitor sizes the simulator picks from; kept small so a cycle costs milliseconds. */
+    constexpr FSize SimulatedVideoSizes[] = { { 320, 180 }, { 480, 270 }, { 640, 360 }, { 960, 540 } };
+    constexpr FSize SimulatedMonitorSizes[] = { { 320, 180 }, { 480, 270 }, { 640, 360 }, { 800, 450 } };
+    constexpr int32_t MaxSimulatedMonitors = 3;
+
+    /** Hidden time after which the simulated lifecycle releases the pipeline. */
+    constexpr int64_t SimulatedReleaseAfterMs = 60000;
+
+    /** Workers per simulated pipeline; each switch tears its pool down and starts a new one. */
+    constexpr size_t SimulatedWorkers = 2;
+
+    /** Codec-free NV12 source: a moving gradient, so every frame changes some tiles. */
+    class FSimulatedVideo final : public IVideoSource
+    {
+    public:
+        FSimulatedVideo(FSize Size, int32_t FrameCount)
+        {
+            Info.Width = Size.Width;
+            Info.Height = Size.Height;
+            Info.Format = EPixelFormat::NV12;
+            Info.Duration100ns = Info.FrameDuration100ns() * FrameCount;
+            RESOURCE_ACQUIRE("Simulator.Source", ComRef);
+        }
+
+        ~FSimulatedVideo() override { RESOURCE_RELEASE("Simulator.Source", ComRef); }
+
+        const FVideoInfo& GetInfo() const override { return Info; }
+
+        bool ReadFrame(FFrame& Out) override
+        {
+            if (Position100ns >= Info.Duration100ns) return false;
+            Out.Allocate(Info.Width, Info.Height, EPixelFormat::NV12);
+            const FFrameView& View = Out.GetView();
+            int32_t Phase = static_cast<int32_t>(Position100ns / Info.FrameDuration100ns());
+            for (int32_t Y = 0; Y < View.Height; ++Y)
+            {
+                uint8_t* Row = View.Row(0, Y);
+                for (int32_t X = 0; X < View.Width; ++X) Row[X] = static_cast<uint8_t>(16 + ((X + Y + Phase * 8) & 0x7F));
+            }
+            for (int32_t Y = 0; Y < View.Height / 2; ++Y)
+            {
+                std::memset(View.Row(1, Y), 96 + (Phase & 0x3F), static_cast<size_t>(View.Width));
+            }
+            Out.Timestamp100ns = Position100ns;
+            Position100ns += Info.FrameDuration100ns();
+            return true;
+        }
+
+        bool Seek(int64_t Position100nsIn) override
+        {
+            Position100ns = Position100nsIn < 0 ? 0 : Position100nsIn;
+            return true;
+        }
+
+    private:
+        FVideoInfo Info;
+        int64_t Position100ns = 0;
+    };
+
+    /** In-memory stand-in for a wallpaper window: a surface that presented rects are blitted into. */
+    class FSimulatedWindow
+    {
+    public:
+        explicit FSimulatedWindow(FSize Size)
+        {
+            Surface.SetResourceTag("Simulator.Window");
+            Surface.Allocate(Size.Width, Size.Height, EPixelFormat::BGRA8);
+            RESOURCE_ACQUIRE("Simulator.Window", Window);
+        }
+
+        ~FSimulatedWindow() { RESOURCE_RELEASE("Simulator.Window", Window); }
+
+        FSimulatedWindow(const FSimulatedWindow&) = delete;
+        FSimulatedWindow& operator=(const FSimulatedWindow&) = delete;
+
+        /** GetDC, one blit per dirty rect, ReleaseDC: what the software presenter does per window. */
+        void Present(const FFrameView& Output, const std::vector<FIntRect>& DirtyRects)
+        {
+            RESOURCE_ACQUIRE("Simulator.Window", Gdi);
+            for (const auto& Rect : DirtyRects)
+            {
+                FFrameView Source = Output.Crop(Rect);
+                FFrameView Dest = Surface.GetView().Crop(Rect);
+                int32_t Width = Source.Width < Dest.Width ? Source.Width : Dest.Width;
+                int32_t Height = Source.Height < Dest.Height ? Source.Height : Dest.Height;
+                for (int32_t Y = 0; Y < Height; ++Y)
+                {
+                    std::memcpy(Dest.Row(0, Y), Source.Row(0, Y), static_cast<size_t>(Width) * 4);
+                }
+            }
+            RESOURCE_RELEASE("Simulator.Window", Gdi);
+        }
+
+    private:
+        FFrame Surface;
+    };
+
+    /** Mirrors the app's software pipeline: its own pool, compositor, source and decode frame. */
+    class FSimulatedPipeline
+    {
+    public:
+        explicit FSimulatedPipeline(std::unique_ptr<IVideoSource> InSource)
+            : Pool(SimulatedWorkers), Compositor(Pool), Source(std::move(InSource))
+        {
+            Frame.SetResourceTag("Software.Decode");
+        }
+
+        /** Monitors side by side; the canvas is their bounding box. */
+        void SetLayout(const std::vector<FSize>& Monitors)
+        {
+            std::vector<FCompositorOutput> Outputs;
+            int32_t CanvasWidth = 0;
+            int32_t CanvasHeight = 0;
+            for (const auto& Monitor : Monitors)
+            {
+                FCompositorOutput Output;
+                Output.Target = { CanvasWidth, 0, CanvasWidth + Monitor.Width, Monitor.Height };
+                Outputs.push_back(Output);
+                CanvasWidth += Monitor.Width;
+                if (Monitor.Height > CanvasHeight) CanvasHeight = Monitor.Height;
+            }
+            Compositor.Configure(CanvasWidth, CanvasHeight, Outputs);
+        }
+
+        /** Decodes, composes and presents one frame; loops the video at its end. */
+        bool Step(std::vector<std::unique_ptr<FSimulatedWindow>>& Windows)
+        {
+            if (!Source->ReadFrame(Frame))
+            {
+                Source->Seek(0);
+                if (!Source->ReadFrame(Frame)) return false;
+            }
+            Compositor.Compose(Frame.GetView());
+            for (size_t Index = 0; Index < Windows.size(); ++Index)
+            {
+                Windows[Index]->Present(Compositor.GetOutputView(Index), Compositor.GetDirtyRects(Index));
+            }
+            return true;
+        }
+
+    private:
+        FThreadPool Pool;
+        FSoftwareCompositor Compositor;
+        std::unique_ptr<IVideoSource> Source;
+        FFrame Frame;
+    };
+
+    struct FSoakStats
+    {
+        uint64_t Switches = 0;
+        uint64_t DisplayChanges = 0;
+        uint64_t Pauses = 0;
+        uint64_t Releases = 0;
+        uint64_t Frames = 0;
+    };
+
+    /** Windows, pipeline and lifecycle of the simulated wallpaper, driven the way the app drives them. */
+    class FSoakScene
+    {
+    public:
+        FSoakScene()
+        {
+            FLifecycleSettings Settings;
+            Settings.ReleaseAfterMs = SimulatedReleaseAfterMs;
+            Lifecycle.Configure(Settings);
+        }
+
+        /** ChangeVideo(): the old pipeline goes away entirely before the new one is built. */
+        void SwitchVideo(FSize Size)
+        {
+            VideoSize = Size;
+            ++Stats.Switches;
+            Pipeline.reset();
+            if (!Lifecycle.AreAllReleased()) BuildPipeline();
+        }
+
+        /** WM_DISPLAYCHANGE with a different monitor set: windows are rebuilt, the pipeline re-laid out. */
+        void ChangeDisplay(const std::vector<FSize>& InMonitors)
+        {
+            Monitors = InMonitors;
+            ++Stats.DisplayChanges;
+            Windows.clear();
+            for (const auto& Monitor : Monitors) Windows.push_back(std::make_unique<FSimulatedWindow>(Monitor));
+            Lifecycle.SetMonitorCount(Monitors.size(), NowMs);
+            if (Pipeline) Pipeline->SetLayout(Monitors);
+            UpdateLifecycle();
+        }
+
+        /** Lock, stay hidden for HiddenMs (long enough to release the pipeline or not), unlock. */
+        void PauseResume(int64_t HiddenMs)
+        {
+            ++Stats.Pauses;
+            Lifecycle.OnSessionEvent(ESessionEvent::Lock);
+            UpdateLifecycle();
+            NowMs += HiddenMs;
+            UpdateLifecycle();
+            Lifecycle.OnSessionEvent(ESessionEvent::Unlock);
+            UpdateLifecycle();
+        }
+
+        void Play(int32_t FrameCount)
+        {
+            if (!Pipeline || !Lifecycle.IsAnyActive()) return;
+            for (int32_t Frame = 0; Frame < FrameCount; ++Frame)
+            {
+                if (Pipeline->Step(Windows)) ++Stats.Frames;
+            }
+            NowMs += FrameCount * 33;
+        }
+
+        /** Everything torn down, as at exit. */
+        void Shutdown()
+        {
+            Pipeline.reset();
+            Windows.clear();
+            Monitors.clear();
+            Lifecycle.SetMonitorCount(0, NowMs);
+        }
+
+        const FSoakStats& GetStats() const { return Stats; }
+
+    private:
+        void BuildPipeline()
+        {
+            Pipeline = std::make_unique<FSimulatedPipeline>(std::make_unique<FSimulatedVideo>(VideoSize, 90));
+            Pipeline->SetLayout(Monitors);
+        }
+
+        /** Applies lifecycle transitions as UpdateLifecycle() does: release when all are released, rebuild on return. */
+        void UpdateLifecycle()
+        {
+            Transitions.clear();
+            Lifecycle.Update(NowMs, Transitions);
+            if (Lifecycle.AreAllReleased() && Pipeline)
+            {
+                Pipeline.reset();
+                ++Stats.Releases;
+            }
+            else if (!Lifecycle.AreAllReleased() && !Pipeline && !Monitors.empty())
+            {
+                BuildPipeline();
+            }
+        }
+
+        FSessionLifecycle Lifecycle;
+        std::vector<FLifecycleTransition> Transitions;
+        std::vector<FSize> Monitors;
+        std::vector<std::unique_ptr<FSimulatedWindow>> Windows;
+        std::unique_ptr<FSimulatedPipeline> Pipeline;
+        FSize VideoSize = SimulatedVideoSizes[0];
+        int64_t NowMs = 0;
+        FSoakStats Stats;
+    };
+
+    /** Resident set size in bytes, or -1 where the platform does not say. */
+    int64_t GetResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS Memory = {};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &Memory, sizeof(Memory))) return -1;
+        return static_cast<int64_t>(Memory.WorkingSetSize);
+#elif defined(__linux__)
+        std::ifstream Statm("/proc/self/statm");
+        int64_t Pages = 0;
+        int64_t ResidentPages = 0;
+        if (!(Statm >> Pages >> ResidentPages)) return -1;
+        return ResidentPages * static_cast<int64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return -1;
+#endif
+    }
+
+    struct FSoakOptions
+    {
+        int32_t Cycles = 3000;
+        int32_t WarmupCycles = 100;
+        int32_t CheckpointCycles = 500;
+        int32_t FramesPerCycle = 2;
+        uint32_t Seed = 1;
+        int64_t RssLimitBytes = 32 * 1024 * 1024;
+        int32_t LeakEvery = 0;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FSoakOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            long long Value = std::atoll(Argv[++Index]);
+            if (Value < 0) return false;
+            if (Name == "--cycles") Options.Cycles = static_cast<int32_t>(Value);
+            else if (Name == "--frames") Options.FramesPerCycle = static_cast<int32_t>(Value);
+            else if (Name == "--seed") Options.Seed = static_cast<uint32_t>(Value);
+            else if (Name == "--rss-mb") Options.RssLimitBytes = Value * 1024 * 1024;
+            else if (Name == "--leak-every") Options.LeakEvery = static_cast<int32_t>(Value);
+            else return false;
+        }
+        return true;
+    }
+
+    /** The fixed configuration every checkpoint is measured in. */
+    void ApplyCanonicalScene(FSoakScene& Scene)
+    {
+        Scene.ChangeDisplay({ SimulatedMonitorSizes[1], SimulatedMonitorSizes[1] });
+        Scene.SwitchVideo(SimulatedVideoSizes[1]);
+        Scene.Play(1);
+    }
+
+    /** Counters that were live but should not be once everything is torn down. */
+    std::vector<FResourceDelta> FindLiveResources()
+    {
+        std::vector<FResourceDelta> Live;
+        for (const auto& Count : GResources.Snapshot())
+        {
+            if (Count.Live) Live.push_back({ Count.Subsystem, Count.Kind, 0, Count.Live });
+        }
+        return Live;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FSoakOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: soak [--cycles N] [--frames N] [--seed N] [--rss-mb N] [--leak-every N]\n");
+        return 2;
+    }
+    GResources.SetEnabled(true);
+
+    std::mt19937 Random(Options.Seed);
+    auto Pick = [&Random](size_t Count) { return static_cast<size_t>(Random() % Count); };
+    std::vector<std::unique_ptr<FFrame>> Leaked;
+
+    FSoakScene Scene;
+    ApplyCanonicalScene(Scene);
+
+    FResourceSnapshot Baseline;
+    int64_t BaselineRss = -1;
+    int64_t WorstRssGrowth = 0;
+    bool bGrew = false;
+    int32_t TotalCycles = Options.WarmupCycles + Options.Cycles;
+    for (int32_t Cycle = 1; Cycle <= TotalCycles; ++Cycle)
+    {
+        switch (Pick(3))
+        {
+        case 0:
+            Scene.SwitchVideo(SimulatedVideoSizes[Pick(std::size(SimulatedVideoSizes))]);
+            break;
+        case 1:
+        {
+            std::vector<FSize> Monitors(1 + Pick(MaxSimulatedMonitors));
+            for (auto& Monitor : Monitors) Monitor = SimulatedMonitorSizes[Pick(std::size(SimulatedMonitorSizes))];
+            Scene.ChangeDisplay(Monitors);
+            break;
+        }
+        default:
+            Scene.PauseResume(static_cast<int64_t>(Pick(2 * SimulatedReleaseAfterMs)));
+            break;
+        }
+        Scene.Play(Options.FramesPerCycle);
+
+        if (Options.LeakEvery && Cycle % Options.LeakEvery == 0)
+        {
+            auto Frame = std::make_unique<FFrame>();
+            Frame->SetResourceTag("Simulator.Leak");
+            Frame->Allocate(256, 256, EPixelFormat::BGRA8);
+            Leaked.push_back(std::move(Frame));
+        }
+
+        bool bWarmedUp = Cycle == Options.WarmupCycles;
+        bool bCheckpoint = Cycle > Options.WarmupCycles
+            && ((Cycle - Options.WarmupCycles) % Options.CheckpointCycles == 0 || Cycle == TotalCycles);
+        if (!bWarmedUp && !bCheckpoint) continue;
+
+        ApplyCanonicalScene(Scene);
+        int64_t Rss = GetResidentBytes();
+        if (bWarmedUp)
+        {
+            Baseline = GResources.Snapshot();
+            BaselineRss = Rss;
+            continue;
+        }
+
+        std::vector<FResourceDelta> Deltas = DiffResourceSnapshots(Baseline, GResources.Snapshot());
+        int64_t RssGrowth = Rss >= 0 && BaselineRss >= 0 ? Rss - BaselineRss : 0;
+        if (RssGrowth > WorstRssGrowth) WorstRssGrowth = RssGrowth;
+        std::printf
+        (
+            "cycle %d: rss %+.1f MB, %zu counter(s) changed\n",
+            Cycle - Options.WarmupCycles, RssGrowth / (1024.0 * 1024.0), Deltas.size()
+        );
+        if (!Deltas.empty())
+        {
+            WriteResourceDiff(std::cout, Deltas);
+            std::cout.flush();
+            bGrew = true;
+        }
+        if (RssGrowth > Options.RssLimitBytes) bGrew = true;
+    }
+
+    Scene.Shutdown();
+    std::vector<FResourceDelta> StillLive = FindLiveResources();
+    if (!StillLive.empty())
+    {
+        std::printf("live after shutdown:\n");
+        WriteResourceDiff(std::cout, StillLive);
+        std::cout.flush();
+        bGrew = true;
+    }
+
+    const FSoakStats& Stats = Scene.GetStats();
+    std::printf
+    (
+        "%llu switches, %llu display changes, %llu pause/resume (%llu released), %llu frames; "
+        "worst rss growth %.1f MB (limit %lld MB)\n",
+        static_cast<unsigned long long>(Stats.Switches), static_cast<unsigned long long>(Stats.DisplayChanges),
+        static_cast<unsigned long long>(Stats.Pauses), static_cast<unsigned long long>(Stats.Releases),
+        static_cast<unsigned long long>(Stats.Frames), WorstRssGrowth / (1024.0 * 1024.0),
+        static_cast<long long>(Options.RssLimitBytes / (1024 * 1024))
+    );
+    std::printf("%s\n", bGrew ? "FAIL: resources grew" : "PASS");
+    return bGrew ? 1 : 0;
+}
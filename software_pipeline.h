@@ -0,0 +1,646 @@
+// SoftwarePipeline - Decode thread, pacing and quality ladder of the CPU presentation path.
+// Frames are read from an IVideoSource, paced on their timestamps, composed into
+// one canvas and handed out per surface as dirty rects. Everything that touches
+// the screen is behind ISurfacePresenter<TSurface>, so the same pipeline drives
+// GDI windows on Windows and MIT-SHM images on X11. Switching videos crossfades:
+// the outgoing source keeps decoding into a second canvas until the fade ends. A
+// fade still running is cut before the next video opens, so two decoders at most.
+// How close each frame comes to its due time drives the scheduling level of the
+// decode and compose threads (see qos.h).
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "compositor.h"
+#include "crossfade.h"
+#include "frame.h"
+#include "qos.h"
+#include "quality_controller.h"
+#include "span_layout.h"
+#include "trace.h"
+#include "video_source.h"
+
+/** Canvas placement of every presentation surface (a window per monitor, say). */
+template <typename TSurface>
+struct TSoftwareLayout
+{
+    struct FTarget
+    {
+        TSurface Surface{};
+        FIntRect CanvasRect;
+    };
+    std::vector<FTarget> Targets;
+    int32_t CanvasWidth = 0;
+    int32_t CanvasHeight = 0;
+    bool bSpanMode = false;
+    FSpanLayout Span;
+
+    /** Largest area one frame is scaled onto: the span canvas, or the biggest monitor. */
+    void GetFrameCoverSize(int32_t& Width, int32_t& Height) const
+    {
+        Width = bSpanMode ? CanvasWidth : 0;
+        Height = bSpanMode ? CanvasHeight : 0;
+        if (bSpanMode) return;
+        for (const auto& Target : Targets)
+        {
+            if (Target.CanvasRect.Width() > Width) Width = Target.CanvasRect.Width();
+            if (Target.CanvasRect.Height() > Height) Height = Target.CanvasRect.Height();
+        }
+    }
+};
+
+/** One rung of the software presenter's quality ladder. */
+struct FPresenterQuality
+{
+    int32_t FrameStride;        // Show every Nth decoded frame
+    int32_t ResolutionShift;    // Convert at 1/2^N resolution
+    const char* Name;
+};
+
+/** Cheapest last. The frame-rate cap goes first: it saves conversion, scaling and blits alike. */
+inline constexpr FPresenterQuality PresenterQualityLevels[] =
+{
+    { 1, 0, "full" },
+    { 2, 0, "half rate" },
+    { 2, 1, "half rate, half resolution" },
+    { 4, 1, "quarter rate, half resolution" }
+};
+
+/**
+ * Canvas = bounding box of all monitors; each surface's region is its monitor rect
+ * relative to that box. Surfaces[Index] presents MonitorRects[Index].
+ */
+template <typename TSurface>
+TSoftwareLayout<TSurface> BuildSoftwareLayout
+(
+    const std::vector<FIntRect>& MonitorRects,
+    const std::vector<TSurface>& Surfaces,
+    bool bSpanMode,
+    const FSpanSettings& Span
+)
+{
+    TSoftwareLayout<TSurface> Layout;
+    if (MonitorRects.empty()) return Layout;
+
+    FIntRect Bounds = MonitorRects[0];
+    for (const auto& Rect : MonitorRects)
+    {
+        if (Rect.Left < Bounds.Left) Bounds.Left = Rect.Left;
+        if (Rect.Top < Bounds.Top) Bounds.Top = Rect.Top;
+        if (Rect.Right > Bounds.Right) Bounds.Right = Rect.Right;
+        if (Rect.Bottom > Bounds.Bottom) Bounds.Bottom = Rect.Bottom;
+    }
+
+    Layout.CanvasWidth = Bounds.Width();
+    Layout.CanvasHeight = Bounds.Height();
+    for (size_t Index = 0; Index < MonitorRects.size() && Index < Surfaces.size(); ++Index)
+    {
+        const FIntRect& Rect = MonitorRects[Index];
+        Layout.Targets.push_back
+        ({
+            Surfaces[Index],
+            { Rect.Left - Bounds.Left, Rect.Top - Bounds.Top, Rect.Right - Bounds.Left, Rect.Bottom - Bounds.Top }
+        });
+    }
+    Layout.bSpanMode = bSpanMode;
+    Layout.Span.Build(MonitorRects, Span);
+    return Layout;
+}
+
+/** Platform side of the software presenter: how canvas pixels reach a surface. */
+template <typename TSurface>
+class ISurfacePresenter
+{
+public:
+    virtual ~ISurfacePresenter() = default;
+
+    /** On the decode thread, before its first frame and after its last (per-thread setup such as COM). */
+    virtual void OnThreadStart() {}
+    virtual void OnThreadStop() {}
+
+    /**
+     * Puts Rects of View, the surface's canvas region, onto Surface at the same offsets.
+     * Called on the decode thread with the canvas locked; View is a crop, so its
+     * stride is the canvas stride.
+     */
+    virtual void Present(const TSurface& Surface, const FFrameView& View, const std::vector<FIntRect>& Rects) = 0;
+};
+
+/** Opens the next video for TSoftwarePipeline::Crossfade(); null if it cannot. */
+using FSourceOpener = std::function<std::unique_ptr<IVideoSource>()>;
+
+/**
+ * GPU-less presentation: one decode thread reads frames, an FSoftwareCompositor
+ * converts and scales them into a shared BGRA canvas across a thread pool, and
+ * each surface gets the changed parts of its region through the platform's
+ * ISurfacePresenter. The UI thread only repaints from the canvas and forwards
+ * pause/layout changes.
+ */
+template <typename TSurface>
+class TSoftwarePipeline
+{
+public:
+    using FLayout = TSoftwareLayout<TSurface>;
+
+    explicit TSoftwarePipeline(ISurfacePresenter<TSurface>& InPresenter)
+        : Presenter(InPresenter), Pool(0, [] { GQos.EnterThread(EWorkClass::Present); }), Compositor(Pool), FadeCompositor(Pool)
+    {
+        FadeFrame.SetResourceTag("Software.Fade");
+    }
+    ~TSoftwarePipeline() { Stop(); }
+
+    TSoftwarePipeline(const TSoftwarePipeline&) = delete;
+    TSoftwarePipeline& operator=(const TSoftwarePipeline&) = delete;
+
+    void Start(std::unique_ptr<IVideoSource> InSource, FLayout InLayout, bool bInPaused)
+    {
+        Source = std::move(InSource);
+        FrameDurationNs.store(Source->GetInfo().FrameDuration100ns() * 100, std::memory_order_relaxed);
+        PendingLayout = std::move(InLayout);
+        bLayoutPending = true;
+        bPaused = bInPaused;
+        bDecoding = true;
+        Thread = std::thread([this] { Run(); });
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            bStopping = true;
+        }
+        StateCondition.notify_all();
+        if (Thread.joinable()) Thread.join();
+    }
+
+    void SetPaused(bool bInPaused)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            bPaused = bInPaused;
+        }
+        StateCondition.notify_all();
+    }
+
+    /**
+     * Switches to the video Open returns without a gap: the current video keeps playing
+     * underneath while it fades in over DurationNs (0 cuts). Before Open runs (on this
+     * thread) the decode thread ends a fade in progress and a switch not taken yet is
+     * dropped, so no more than two sources are ever open. The new source waits, idle,
+     * until the decode thread takes it before its next frame (a paused pipeline takes it
+     * when it resumes). False if Open returns nothing; the current video plays on.
+     */
+    bool Crossfade(const FSourceOpener& Open, int64_t DurationNs)
+    {
+        std::unique_ptr<IVideoSource> Untaken;
+        {
+            std::unique_lock<std::mutex> Lock(StateMutex);
+            Untaken = std::move(PendingSource);
+            bDropOutgoing = bDecoding;
+            StateCondition.notify_all();
+            StateCondition.wait(Lock, [this] { return !bDropOutgoing || !bDecoding; });
+        }
+        Untaken.reset();
+
+        std::unique_ptr<IVideoSource> Next = Open();
+        if (!Next) return false;
+        std::lock_guard<std::mutex> Lock(StateMutex);
+        PendingSource = std::move(Next);
+        PendingFadeNs = DurationNs;
+        return true;
+    }
+
+    bool IsCrossfading() const { return bCrossfading.load(std::memory_order_relaxed); }
+
+    /** Cache level (see GetCacheLevelBytes) for the current and later sources; applied by the decode thread, paused or not. */
+    void SetCacheLevel(int32_t Level)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            PendingCacheLevel = Level;
+        }
+        StateCondition.notify_all();
+    }
+
+    /** Bytes the sources keep in frame caches, as of the last shown frame or cache level change. */
+    int64_t GetCacheBytes() const { return CacheBytes.load(std::memory_order_relaxed); }
+
+    /** Applied by the decode thread before its next frame. */
+    void SetLayout(FLayout InLayout)
+    {
+        std::lock_guard<std::mutex> Lock(StateMutex);
+        PendingLayout = std::move(InLayout);
+        bLayoutPending = true;
+    }
+
+    /** Repaints one surface from the last composed canvas: Paint(View) gets its whole region. */
+    template <typename TPaint>
+    void Paint(const TSurface& Surface, TPaint&& PaintView)
+    {
+        std::lock_guard<std::mutex> Lock(CanvasMutex);
+        for (size_t Index = 0; Index < Layout.Targets.size(); ++Index)
+        {
+            if (Layout.Targets[Index].Surface == Surface) PaintView(Compositor.GetOutputView(Index));
+        }
+    }
+
+    FCompositorStats GetStats()
+    {
+        std::lock_guard<std::mutex> Lock(CanvasMutex);
+        return Compositor.GetStats();
+    }
+
+    /** Applied from the next decoded frame. */
+    void SetQuality(const FPresenterQuality& Quality)
+    {
+        FrameStride.store(Quality.FrameStride, std::memory_order_relaxed);
+        ResolutionShift.store(Quality.ResolutionShift, std::memory_order_relaxed);
+    }
+
+    /** Measurements since the previous call, for the quality controller. */
+    FQualitySample TakeQualitySample()
+    {
+        std::lock_guard<std::mutex> Lock(QualityMutex);
+        FQualitySample Sample = Window;
+        Sample.WorkNs = WindowShown ? WindowWorkNs / static_cast<int64_t>(WindowShown) : 0;
+        Sample.BudgetNs = FrameDurationNs.load(std::memory_order_relaxed) * FrameStride.load(std::memory_order_relaxed);
+        Window = {};
+        WindowWorkNs = 0;
+        WindowShown = 0;
+        return Sample;
+    }
+
+    /** Near misses and escalations of the frame threads' scheduling level (see qos.h). */
+    FDeadlineStats GetDeadlineStats()
+    {
+        std::lock_guard<std::mutex> Lock(QualityMutex);
+        return Deadline.GetStats();
+    }
+
+    uint64_t GetDroppedFrames() const { return DroppedFrames.load(std::memory_order_relaxed); }
+    size_t GetWorkerCount() const { return Pool.GetWorkerCount(); }
+    bool HasFailed() const { return bFailed.load(std::memory_order_relaxed); }
+
+private:
+    void Run()
+    {
+        GQos.EnterThread(EWorkClass::Decode);
+        Presenter.OnThreadStart();
+        FFrame Frame;
+        Frame.SetResourceTag("Software.Decode");
+        auto Anchor = std::chrono::steady_clock::now();
+        int64_t AnchorTimestamp = -1;
+        int32_t ConsecutiveFailures = 0;
+        uint64_t FrameCounter = 0;
+        int64_t PendingWorkNs = 0;  // Decode time since the last shown frame
+        auto LastShown = Anchor;
+
+        for (;;)
+        {
+            bool bRunning = false;
+            {
+                std::unique_lock<std::mutex> Lock(StateMutex);
+                StateCondition.wait(Lock, [this] { return bStopping || !bPaused || bDropOutgoing || PendingCacheLevel != CacheLevel; });
+                if (bStopping) break;
+                bRunning = !bPaused;
+            }
+            ApplyCacheLevel();
+            DropOutgoingOnRequest();
+            if (!bRunning)
+            {
+                // Nothing is due while paused: drop any boost rather than hold it until the resume.
+                std::lock_guard<std::mutex> Lock(QualityMutex);
+                if (Deadline.GetBoost()) UpdateDeadline({}, true);
+                continue;
+            }
+            if (AdoptPendingSource())
+            {
+                AnchorTimestamp = -1;
+                ConsecutiveFailures = 0;
+            }
+
+            int64_t DecodeStartNs = TraceNowNs();
+            bool bDecoded = Source->ReadFrame(Frame);
+            PendingWorkNs += TraceNowNs() - DecodeStartNs;
+            if (!bDecoded)
+            {
+                // End of stream loops; a file that cannot produce a frame after a rewind is dead.
+                TRACE_INSTANT("Software.Loop", 0);
+                if (++ConsecutiveFailures > 2 || !Source->Seek(0))
+                {
+                    bFailed = true;
+                    break;
+                }
+                AnchorTimestamp = -1;
+                continue;
+            }
+            ConsecutiveFailures = 0;
+
+            // Frame-rate cap: every frame is decoded (P-frames depend on it), only every Nth is shown.
+            int32_t Stride = FrameStride.load(std::memory_order_relaxed);
+            if (FrameCounter++ % static_cast<uint64_t>(Stride > 0 ? Stride : 1) != 0) continue;
+
+            // Pace on media timestamps against a wall-clock anchor set at (re)start and after pauses.
+            auto Now = std::chrono::steady_clock::now();
+            if (AnchorTimestamp < 0 || Frame.Timestamp100ns < AnchorTimestamp)
+            {
+                Anchor = Now;
+                AnchorTimestamp = Frame.Timestamp100ns;
+            }
+            auto Due = Anchor + std::chrono::nanoseconds((Frame.Timestamp100ns - AnchorTimestamp) * 100);
+            FDeadlineSample Slack;
+            Slack.FrameNs = Source->GetInfo().FrameDuration100ns() * 100 * (Stride > 0 ? Stride : 1);
+            Slack.SlackNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Due - Now).count();
+            if (Now - Due > std::chrono::nanoseconds(Source->GetInfo().FrameDuration100ns() * 100))
+            {
+                // More than a frame late: skip composing so decode catches up.
+                DroppedFrames.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> Lock(QualityMutex);
+                ++Window.FramesDue;
+                ++Window.FramesDropped;
+                Slack.bDropped = true;
+                UpdateDeadline(Slack, false);
+                continue;
+            }
+            {
+                std::unique_lock<std::mutex> Lock(StateMutex);
+                if (StateCondition.wait_until(Lock, Due, [this] { return bStopping || bPaused || bDropOutgoing; }))
+                {
+                    // A switch waiting on the outgoing video costs this frame, not the pacing.
+                    if (bStopping) break;
+                    if (bPaused) AnchorTimestamp = -1;
+                    continue;
+                }
+            }
+
+            auto Shown = std::chrono::steady_clock::now();
+            if (Outgoing)
+            {
+                int64_t FadeStartNs = TraceNowNs();
+                AdvanceCrossfade(std::chrono::duration_cast<std::chrono::nanoseconds>(Shown - LastShown).count());
+                PendingWorkNs += TraceNowNs() - FadeStartNs;
+            }
+            LastShown = Shown;
+
+            std::lock_guard<std::mutex> Lock(CanvasMutex);
+            int64_t ComposeStartNs = TraceNowNs();
+            ApplyPendingLayout(Frame.Width(), Frame.Height());
+            int32_t Shift = ResolutionShift.load(std::memory_order_relaxed);
+            Compositor.SetSourceShift(Shift);
+            if (Outgoing)
+            {
+                TRACE_SCOPE("Software.Crossfade");
+                ConfigureFadeCompositor(FadeFrame.Width(), FadeFrame.Height());
+                FadeCompositor.SetSourceShift(Shift);
+                FadeCompositor.Compose(FadeFrame.GetView());
+                Compositor.Compose(Frame.GetView(), FadeCompositor.GetCanvas(), Fade.GetWeight());
+            }
+            else Compositor.Compose(Frame.GetView());
+
+            // Only the tiles that changed since the last frame are blitted.
+            int64_t PresentStartNs = TraceNowNs();
+            if (!Compositor.IsStatic())
+            {
+                TRACE_SCOPE("Software.Present");
+                for (size_t Index = 0; Index < Layout.Targets.size(); ++Index)
+                {
+                    const auto& DirtyRects = Compositor.GetDirtyRects(Index);
+                    if (DirtyRects.empty()) continue;
+                    Presenter.Present(Layout.Targets[Index].Surface, Compositor.GetOutputView(Index), DirtyRects);
+                }
+                Compositor.RecordPresent(TraceNowNs() - PresentStartNs);
+            }
+
+            UpdateCacheBytes();
+            std::lock_guard<std::mutex> QualityLock(QualityMutex);
+            ++Window.FramesDue;
+            ++WindowShown;
+            WindowWorkNs += PendingWorkNs + (TraceNowNs() - ComposeStartNs);
+            PendingWorkNs = 0;
+            UpdateDeadline(Slack, false);
+        }
+
+        FinishCrossfade();
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            bDecoding = false;
+        }
+        StateCondition.notify_all();
+        Presenter.OnThreadStop();
+    }
+
+    /** Feeds one frame's slack to the escalator (or resets it) and hands a changed boost to GQos. Caller holds QualityMutex. */
+    void UpdateDeadline(const FDeadlineSample& Sample, bool bReset)
+    {
+        int32_t Previous = Deadline.GetBoost();
+        if (bReset) Deadline.Reset();
+        else Deadline.Update(Sample);
+        if (Deadline.GetBoost() == Previous) return;
+        TRACE_INSTANT("Software.QosBoost", Deadline.GetBoost());
+        GQos.SetBoost(Deadline.GetBoost());
+    }
+
+    /** Takes a source handed over by Crossfade(); the current one becomes the outgoing video. */
+    bool AdoptPendingSource()
+    {
+        std::unique_ptr<IVideoSource> Next;
+        int64_t FadeNs = 0;
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            if (!PendingSource) return false;
+            Next = std::move(PendingSource);
+            FadeNs = PendingFadeNs;
+        }
+        TRACE_INSTANT("Software.Switch", FadeNs / 1000000);
+        FinishCrossfade();
+        Fade.Begin(FadeNs);
+        if (Fade.IsActive())
+        {
+            Outgoing = std::move(Source);
+            bFadeFrameStale = true;
+            FadeDebtNs = 0;
+            bCrossfading.store(true, std::memory_order_relaxed);
+        }
+        Source = std::move(Next);
+        Source->SetCacheLevel(CacheLevel);
+        FrameDurationNs.store(Source->GetInfo().FrameDuration100ns() * 100, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** Ends a fade in progress for Crossfade(), which waits on it before opening the next video. */
+    void DropOutgoingOnRequest()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            if (!bDropOutgoing) return;
+        }
+        FinishCrossfade();
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            bDropOutgoing = false;
+        }
+        StateCondition.notify_all();
+    }
+
+    /** Hands a changed cache level to the sources; their caches shrink (or may grow back) from here. */
+    void ApplyCacheLevel()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            if (PendingCacheLevel == CacheLevel) return;
+            CacheLevel = PendingCacheLevel;
+        }
+        TRACE_INSTANT("Software.CacheLevel", CacheLevel);
+        Source->SetCacheLevel(CacheLevel);
+        if (Outgoing) Outgoing->SetCacheLevel(CacheLevel);
+        UpdateCacheBytes();
+    }
+
+    void UpdateCacheBytes()
+    {
+        int64_t Bytes = Source->GetCacheBytes() + (Outgoing ? Outgoing->GetCacheBytes() : 0);
+        CacheBytes.store(Bytes, std::memory_order_relaxed);
+    }
+
+    /** Once per shown frame: moves the fade on and keeps the outgoing video playing until the fade ends. */
+    void AdvanceCrossfade(int64_t StepNs)
+    {
+        Fade.Advance(StepNs);
+        if (Fade.IsActive() && AdvanceOutgoing(StepNs)) return;
+        FinishCrossfade();
+    }
+
+    /**
+     * Reads as many outgoing frames as its own frame rate calls for over StepNs, up to
+     * MaxFadeReadsPerFrame (further lag is dropped, not decoded in a burst). Loops at the
+     * end of stream; false once it cannot produce a frame, which cuts to the new video.
+     */
+    bool AdvanceOutgoing(int64_t StepNs)
+    {
+        int64_t DurationNs = Outgoing->GetInfo().FrameDuration100ns() * 100;
+        int32_t Reads = bFadeFrameStale ? 1 : 0;
+        bFadeFrameStale = false;
+        for (FadeDebtNs += StepNs; FadeDebtNs >= DurationNs && Reads < MaxFadeReadsPerFrame; FadeDebtNs -= DurationNs) ++Reads;
+        if (FadeDebtNs >= DurationNs) FadeDebtNs = 0;
+
+        for (; Reads > 0; --Reads)
+        {
+            if (Outgoing->ReadFrame(FadeFrame)) continue;
+            if (!Outgoing->Seek(0) || !Outgoing->ReadFrame(FadeFrame)) return false;
+        }
+        return true;
+    }
+
+    /** Closes the outgoing video and frees everything the fade used. */
+    void FinishCrossfade()
+    {
+        Fade.Finish();
+        Outgoing.reset();
+        FadeFrame.Release();
+        FadeCompositor.Release();
+        FadeFrameWidth = FadeFrameHeight = -1;
+        bCrossfading.store(false, std::memory_order_relaxed);
+    }
+
+    /** Called with CanvasMutex held; span crops depend on the frame size, so they are resolved here. */
+    void ApplyPendingLayout(int32_t FrameWidth, int32_t FrameHeight)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            if (bLayoutPending)
+            {
+                Layout = std::move(PendingLayout);
+                bLayoutPending = false;
+                LayoutFrameWidth = -1;
+                FadeFrameWidth = -1;
+            }
+        }
+        if (FrameWidth == LayoutFrameWidth && FrameHeight == LayoutFrameHeight) return;
+        LayoutFrameWidth = FrameWidth;
+        LayoutFrameHeight = FrameHeight;
+        Compositor.Configure(Layout.CanvasWidth, Layout.CanvasHeight, BuildCompositorOutputs(FrameWidth, FrameHeight));
+    }
+
+    /** Called with CanvasMutex held; the outgoing video shares the layout but has its own frame size. */
+    void ConfigureFadeCompositor(int32_t FrameWidth, int32_t FrameHeight)
+    {
+        if (FrameWidth == FadeFrameWidth && FrameHeight == FadeFrameHeight) return;
+        FadeFrameWidth = FrameWidth;
+        FadeFrameHeight = FrameHeight;
+        FadeCompositor.Configure(Layout.CanvasWidth, Layout.CanvasHeight, BuildCompositorOutputs(FrameWidth, FrameHeight));
+    }
+
+    std::vector<FCompositorOutput> BuildCompositorOutputs(int32_t FrameWidth, int32_t FrameHeight) const
+    {
+        std::vector<FCompositorOutput> Outputs;
+        for (size_t Index = 0; Index < Layout.Targets.size(); ++Index)
+        {
+            FCompositorOutput Output;
+            Output.Target = Layout.Targets[Index].CanvasRect;
+            if (Layout.bSpanMode) Output.SourceCrop = Layout.Span.GetCropRect(Index, FrameWidth, FrameHeight);
+            Outputs.push_back(Output);
+        }
+        return Outputs;
+    }
+
+    /** Outgoing frames decoded per shown frame at most, when the outgoing video runs faster. */
+    static constexpr int32_t MaxFadeReadsPerFrame = 4;
+
+    ISurfacePresenter<TSurface>& Presenter;
+    FThreadPool Pool;
+    FSoftwareCompositor Compositor;
+    std::unique_ptr<IVideoSource> Source;
+    std::thread Thread;
+
+    // Crossfade: decode thread only, apart from the flag.
+    FSoftwareCompositor FadeCompositor;
+    std::unique_ptr<IVideoSource> Outgoing;
+    FFrame FadeFrame;
+    FCrossfadeSchedule Fade;
+    int64_t FadeDebtNs = 0;
+    bool bFadeFrameStale = false;
+    int32_t FadeFrameWidth = -1;
+    int32_t FadeFrameHeight = -1;
+    std::atomic<bool> bCrossfading{ false };
+
+    std::mutex StateMutex;
+    std::condition_variable StateCondition;
+    bool bStopping = false;
+    bool bPaused = false;
+    bool bLayoutPending = false;
+    FLayout PendingLayout;
+    std::unique_ptr<IVideoSource> PendingSource;
+    int64_t PendingFadeNs = 0;
+    bool bDropOutgoing = false;         // Crossfade() waits for the decode thread to clear it
+    bool bDecoding = false;             // Decode thread running: Start() to the end of Run()
+    int32_t PendingCacheLevel = 0;
+    int32_t CacheLevel = 0;             // Written by the decode thread under StateMutex
+
+    std::mutex CanvasMutex;
+    FLayout Layout;
+    int32_t LayoutFrameWidth = -1;
+    int32_t LayoutFrameHeight = -1;
+
+    std::atomic<uint64_t> DroppedFrames{ 0 };
+    std::atomic<int64_t> CacheBytes{ 0 };
+    std::atomic<bool> bFailed{ false };
+
+    std::atomic<int32_t> FrameStride{ 1 };
+    std::atomic<int32_t> ResolutionShift{ 0 };
+    std::atomic<int64_t> FrameDurationNs{ 0 };
+    std::mutex QualityMutex;
+    FQualitySample Window;
+    int64_t WindowWorkNs = 0;
+    uint32_t WindowShown = 0;
+    FDeadlineEscalator Deadline;        // Under QualityMutex; drives GQos's boost
+};
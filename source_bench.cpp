@@ -0,0 +1,485 @@
+// source_bench - Checks and times the codec-free video sources.
+// First the synthetic pattern is checked: every scene and format repeats byte for
+// byte from its settings, seeks land on the same frame a straight read does,
+// fractional frame rates keep exact timestamps, finite patterns end, and each
+// scene has the character it claims once composed (bars and motion dirty every
+// tile, static only a few, still none). Then the Y4M writer and the memory-mapped
+// reader must round-trip 8- and 10-bit frames exactly, odd sizes included, and
+// hand-made files check odd sizes, FRAME parameters, mono, truncated tails and
+// rejected headers. Last, each scene is captured to a Y4M file and the frame path
+// is timed on the thread pool from both sources: read or generate, then convert and
+// scale into a canvas of the same size, against the frame budget of the chosen
+// rate. Needs no codec:
+//   g++ -std=c++20 -O2 -pthread source_bench.cpp -o source_bench
+//   source_bench [--size WxH] [--fps N] [--frames N] [--format nv12|p010]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compositor.h"
+#include "pattern_source.h"
+#include "thread_pool.h"
+#include "y4m_source.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t Width = 1920;
+        int32_t Height = 1080;
+        uint32_t FrameRate = 30;
+        int32_t Frames = 60;
+        EPixelFormat Format = EPixelFormat::NV12;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            std::string Value = Argv[++Index];
+            if (Name == "--size")
+            {
+                if (std::sscanf(Value.c_str(), "%dx%d", &Options.Width, &Options.Height) != 2) return false;
+                if (Options.Width < 2 || Options.Height < 2) return false;
+            }
+            else if (Name == "--fps") Options.FrameRate = static_cast<uint32_t>(std::atoi(Value.c_str()));
+            else if (Name == "--frames") Options.Frames = std::atoi(Value.c_str());
+            else if (Name == "--format")
+            {
+                if (Value != "nv12" && Value != "p010") return false;
+                Options.Format = Value == "p010" ? EPixelFormat::P010 : EPixelFormat::NV12;
+            }
+            else return false;
+        }
+        return Options.Frames > 0 && Options.FrameRate > 0;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    /** Scratch file next to the others of this run; removed by the caller. */
+    std::string GetTempPath(const char* Tag)
+    {
+        const char* Directory = std::getenv("TMPDIR");
+        return std::string(Directory && *Directory ? Directory : "/tmp") + "/source_bench_"
+            + std::to_string(getpid()) + "_" + Tag + ".y4m";
+    }
+
+    bool WriteFile(const std::string& Path, const std::string& Bytes)
+    {
+        FILE* File = std::fopen(Path.c_str(), "wb");
+        if (!File) return false;
+        bool bOk = std::fwrite(Bytes.data(), 1, Bytes.size(), File) == Bytes.size();
+        return std::fclose(File) == 0 && bOk;
+    }
+
+    /** Same size, format and visible samples; padding past the row is ignored. */
+    bool FramesEqual(const FFrameView& A, const FFrameView& B)
+    {
+        if (A.Width != B.Width || A.Height != B.Height || A.Format != B.Format) return false;
+        size_t RowBytes = static_cast<size_t>(A.Width) * BytesPerPixel(A.Format);
+        for (int32_t Y = 0; Y < A.Height; ++Y)
+        {
+            if (std::memcmp(A.Row(0, Y), B.Row(0, Y), RowBytes) != 0) return false;
+        }
+        for (int32_t Y = 0; PlaneCount(A.Format) == 2 && Y < A.Height / 2; ++Y)
+        {
+            if (std::memcmp(A.Row(1, Y), B.Row(1, Y), RowBytes) != 0) return false;
+        }
+        return true;
+    }
+
+    FPatternSettings MakeSettings(EPatternScene Scene, EPixelFormat Format, int32_t Width = 320, int32_t Height = 180)
+    {
+        FPatternSettings Settings;
+        Settings.Width = Width;
+        Settings.Height = Height;
+        Settings.Scene = Scene;
+        Settings.Format = Format;
+        return Settings;
+    }
+
+    constexpr EPatternScene Scenes[] = { EPatternScene::Bars, EPatternScene::Motion, EPatternScene::Static, EPatternScene::Still };
+    constexpr EPixelFormat Formats[] = { EPixelFormat::NV12, EPixelFormat::P010 };
+
+    bool CheckPatternDeterminism()
+    {
+        bool bPass = true;
+        for (EPatternScene Scene : Scenes)
+        {
+            for (EPixelFormat Format : Formats)
+            {
+                FPatternSource A(MakeSettings(Scene, Format));
+                FPatternSource B(MakeSettings(Scene, Format));
+                FFrame FrameA, FrameB;
+                bool bSame = true;
+                for (int32_t Frame = 0; Frame < 8; ++Frame)
+                {
+                    bSame &= A.ReadFrame(FrameA) && B.ReadFrame(FrameB) && FramesEqual(FrameA.GetView(), FrameB.GetView());
+                    bSame &= FrameA.Timestamp100ns == FrameB.Timestamp100ns && FrameA.Format() == Format;
+                }
+                bPass &= Check(bSame, "pattern differs between two runs");
+
+                // Frame 8 sequentially (A) against a seek straight to it (B).
+                A.ReadFrame(FrameA);
+                B.Seek(FrameA.Timestamp100ns);
+                B.ReadFrame(FrameB);
+                bPass &= Check(FramesEqual(FrameA.GetView(), FrameB.GetView()), "seek lands on a different frame");
+                bPass &= Check(FrameA.Timestamp100ns == FrameB.Timestamp100ns, "seek timestamp differs");
+            }
+        }
+
+        FPatternSource SeedA(MakeSettings(EPatternScene::Motion, EPixelFormat::NV12));
+        FPatternSettings Other = MakeSettings(EPatternScene::Motion, EPixelFormat::NV12);
+        Other.Seed = 2;
+        FPatternSource SeedB(Other);
+        FFrame FrameA, FrameB;
+        SeedA.ReadFrame(FrameA);
+        SeedB.ReadFrame(FrameB);
+        bPass &= Check(!FramesEqual(FrameA.GetView(), FrameB.GetView()), "seed does not change the noise");
+
+        FPatternSource Still(MakeSettings(EPatternScene::Still, EPixelFormat::NV12));
+        FPatternSource Static(MakeSettings(EPatternScene::Static, EPixelFormat::NV12));
+        Still.ReadFrame(FrameA);
+        Static.ReadFrame(FrameB);
+        bPass &= Check(FramesEqual(FrameA.GetView(), FrameB.GetView()), "still is not the first static frame");
+        Still.ReadFrame(FrameB);
+        bPass &= Check(FramesEqual(FrameA.GetView(), FrameB.GetView()), "still frame changed");
+        Static.ReadFrame(FrameA);
+        bPass &= Check(!FramesEqual(FrameA.GetView(), FrameB.GetView()), "static box does not move");
+        return bPass;
+    }
+
+    bool CheckPatternTiming()
+    {
+        FPatternSettings Settings = MakeSettings(EPatternScene::Bars, EPixelFormat::NV12, 64, 36);
+        Settings.FrameRateNumerator = 30000;
+        Settings.FrameRateDenominator = 1001;
+        Settings.FrameCount = 3000;
+        FPatternSource Source(Settings);
+        bool bPass = Check(Source.GetInfo().Duration100ns == 1001000000, "3000 frames at 29.97 are not 100.1 s");
+
+        FFrame Frame;
+        bool bExact = true;
+        for (int64_t Index : { 0, 1, 1000, 2999 })
+        {
+            int64_t Expected = Index * 10000000 * 1001 / 30000;
+            bExact &= Source.Seek(Expected) && Source.ReadFrame(Frame) && Frame.Timestamp100ns == Expected;
+            // One tick past a frame's time is the next frame.
+            if (Index < 2999) bExact &= Source.Seek(Expected + 1) && Source.ReadFrame(Frame) && Frame.Timestamp100ns > Expected;
+        }
+        bPass &= Check(bExact, "fractional-rate timestamps or seeks are off");
+        bPass &= Check(!Source.ReadFrame(Frame), "finite pattern does not end");
+        bPass &= Check(Source.Seek(0) && Source.ReadFrame(Frame) && Frame.Timestamp100ns == 0, "no restart after the end");
+
+        FPatternSource Endless(64, 36);
+        bPass &= Check(Endless.GetInfo().Duration100ns == 0 && Endless.GetInfo().Format == EPixelFormat::NV12, "size-only pattern");
+        FPatternSource Odd(MakeSettings(EPatternScene::Bars, EPixelFormat::NV12, 65, 37));
+        bPass &= Check(Odd.GetInfo().Width == 64 && Odd.GetInfo().Height == 36, "odd pattern size not made even");
+        return bPass;
+    }
+
+    bool CheckPatternPaths()
+    {
+        FPatternSettings Settings;
+        Settings.Width = 800;
+        Settings.Height = 600;
+        bool bPass = Check(ParsePatternPath(":pattern", Settings) && Settings.Width == 800, "plain pattern path");
+        bPass &= Check
+        (
+            ParsePatternPath(":pattern:scene=motion,size=1280x720,fps=30000/1001,frames=300,format=p010,seed=7", Settings)
+                && Settings.Scene == EPatternScene::Motion && Settings.Width == 1280 && Settings.Height == 720
+                && Settings.FrameRateNumerator == 30000 && Settings.FrameRateDenominator == 1001
+                && Settings.FrameCount == 300 && Settings.Format == EPixelFormat::P010 && Settings.Seed == 7,
+            "full pattern path"
+        );
+        bPass &= Check(ParsePatternPath(":pattern:fps=60", Settings) && Settings.FrameRateNumerator == 60 && Settings.FrameRateDenominator == 1, "integer fps");
+        bPass &= Check(!ParsePatternPath(":patterns", Settings) && !ParsePatternPath("/v/pattern.mp4", Settings), "not a pattern path");
+        bPass &= Check(!ParsePatternPath(":pattern:scene=sky", Settings), "unknown scene accepted");
+        bPass &= Check(!ParsePatternPath(":pattern:size=1280", Settings), "size without height accepted");
+        bPass &= Check(!ParsePatternPath(":pattern:fps=0", Settings), "zero fps accepted");
+        bPass &= Check(!ParsePatternPath(":pattern:frames=-1", Settings), "negative frame count accepted");
+        bPass &= Check(!ParsePatternPath(":pattern:loud", Settings), "option without a value accepted");
+        return bPass;
+    }
+
+    /** Share of tiles each scene dirties per frame once composed, after the first frame. */
+    bool CheckSceneCharacter()
+    {
+        FThreadPool Pool;
+        bool bPass = true;
+        for (EPatternScene Scene : Scenes)
+        {
+            FPatternSource Source(MakeSettings(Scene, EPixelFormat::NV12, 640, 360));
+            FSoftwareCompositor Compositor(Pool);
+            std::vector<FCompositorOutput> Outputs(1);
+            Outputs[0].Target = { 0, 0, 640, 360 };
+            Compositor.Configure(640, 360, Outputs);
+            FFrame Frame;
+            Source.ReadFrame(Frame);
+            Compositor.Compose(Frame.GetView());
+            FCompositorStats First = Compositor.GetStats();
+            for (int32_t Index = 0; Index < 16; ++Index)
+            {
+                Source.ReadFrame(Frame);
+                Compositor.Compose(Frame.GetView());
+            }
+            const FCompositorStats& Stats = Compositor.GetStats();
+            double Dirty = static_cast<double>(Stats.TilesDirty - First.TilesDirty) / static_cast<double>(Stats.TilesTotal - First.TilesTotal);
+            switch (Scene)
+            {
+            case EPatternScene::Bars:   bPass &= Check(Dirty > 0.9, "bars leave tiles clean"); break;
+            case EPatternScene::Motion: bPass &= Check(Dirty == 1.0, "motion leaves tiles clean"); break;
+            case EPatternScene::Static: bPass &= Check(Dirty > 0.0 && Dirty < 0.25, "static dirties too much or nothing"); break;
+            case EPatternScene::Still:  bPass &= Check(Dirty == 0.0, "still dirties tiles"); break;
+            }
+        }
+        return bPass;
+    }
+
+    bool CheckY4MRoundTrip()
+    {
+        bool bPass = true;
+        for (EPixelFormat Format : Formats)
+        {
+            FPatternSettings Settings = MakeSettings(EPatternScene::Motion, Format, 322, 182);
+            Settings.FrameRateNumerator = 60000;
+            Settings.FrameRateDenominator = 1001;
+            std::string Path = GetTempPath(Format == EPixelFormat::P010 ? "roundtrip10" : "roundtrip8");
+            FPatternSource Pattern(Settings);
+            FY4MWriter Writer;
+            FFrame Frame;
+            bool bWritten = Writer.Open(Path, Pattern.GetInfo());
+            for (int32_t Index = 0; Index < 6 && bWritten; ++Index) bWritten = Pattern.ReadFrame(Frame) && Writer.WriteFrame(Frame.GetView());
+            bPass &= Check(Writer.Close() && bWritten && Writer.GetFramesWritten() == 6, "Y4M write failed");
+
+            FY4MSource Reader;
+            bool bOpened = Reader.Open(Path);
+            bPass &= Check(bOpened, "Y4M written by the writer does not open");
+            if (bOpened)
+            {
+                const FVideoInfo& Info = Reader.GetInfo();
+                bPass &= Check
+                (
+                    Reader.GetFrameCount() == 6 && Info.Width == 322 && Info.Height == 182 && Info.Format == Format
+                        && Info.FrameRateNumerator == 60000 && Info.FrameRateDenominator == 1001
+                        && Info.Duration100ns == 6 * 10000000LL * 1001 / 60000,
+                    "Y4M stream parameters lost"
+                );
+                Pattern.Seek(0);
+                FFrame Expected;
+                bool bSame = true;
+                for (int32_t Index = 0; Index < 6; ++Index)
+                {
+                    bSame &= Pattern.ReadFrame(Expected) && Reader.ReadFrame(Frame) && FramesEqual(Expected.GetView(), Frame.GetView());
+                    bSame &= Expected.Timestamp100ns == Frame.Timestamp100ns;
+                }
+                bPass &= Check(bSame, "Y4M frames differ from what was written");
+                bPass &= Check(!Reader.ReadFrame(Frame), "Y4M reads past the end");
+
+                Pattern.Seek(0);
+                for (int32_t Index = 0; Index < 4; ++Index) Pattern.ReadFrame(Expected);
+                bPass &= Check
+                (
+                    Reader.Seek(Expected.Timestamp100ns) && Reader.ReadFrame(Frame) && FramesEqual(Expected.GetView(), Frame.GetView()),
+                    "Y4M seek lands on a different frame"
+                );
+            }
+
+            // 321x181 (the pattern cropped by a pixel each way): the chroma planes must be 161x91, and the reader
+            // crops back to 320x180 with every kept sample in place.
+            Pattern.Seek(0);
+            FFrameView Odd = Pattern.ReadFrame(Frame) ? Frame.GetView() : FFrameView{};
+            Odd.Width = 321;
+            Odd.Height = 181;
+            FVideoInfo OddInfo = Pattern.GetInfo();
+            OddInfo.Width = Odd.Width;
+            OddInfo.Height = Odd.Height;
+            FY4MWriter OddWriter;
+            bPass &= Check(OddWriter.Open(Path, OddInfo) && OddWriter.WriteFrame(Odd) && OddWriter.Close(), "odd-size Y4M write failed");
+            size_t SampleBytes = Format == EPixelFormat::P010 ? 2 : 1;
+            size_t PayloadBytes = (321 * 181 + 2 * 161 * 91) * SampleBytes;
+            bOpened = Reader.Open(Path);
+            bPass &= Check(bOpened && Reader.GetFrameCount() == 1, "odd-size Y4M written by the writer does not open");
+            if (bOpened)
+            {
+                // Stream header line, "FRAME\n", then exactly one payload.
+                std::string Bytes;
+                if (FILE* Stream = std::fopen(Path.c_str(), "rb"))
+                {
+                    char Buffer[4096];
+                    for (size_t Read; (Read = std::fread(Buffer, 1, sizeof(Buffer), Stream)) > 0;) Bytes.append(Buffer, Read);
+                    std::fclose(Stream);
+                }
+                bPass &= Check(Bytes.size() == Bytes.find('\n') + 1 + 6 + PayloadBytes, "odd-size Y4M frame has the wrong size");
+                FFrame Cropped;
+                FFrameView Kept = Odd;
+                Kept.Width = 320;
+                Kept.Height = 180;
+                bPass &= Check(Reader.ReadFrame(Cropped) && FramesEqual(Kept, Cropped.GetView()), "odd-size Y4M frame differs from what was written");
+            }
+            std::remove(Path.c_str());
+        }
+        return bPass;
+    }
+
+    bool CheckY4MParsing()
+    {
+        std::string Path = GetTempPath("parsing");
+        FY4MSource Reader;
+        FFrame Frame;
+
+        // 5x3 8-bit: chroma planes are 3x2. Two frames, the second with FRAME parameters, then a truncated third.
+        std::string Odd = "YUV4MPEG2 W5 H3 F25:1 Ip C420jpeg\n";
+        for (int32_t Index = 0; Index < 2; ++Index)
+        {
+            Odd += Index ? "FRAME Ixyz\n" : "FRAME\n";
+            for (int32_t Sample = 0; Sample < 15; ++Sample) Odd += static_cast<char>(Index * 100 + Sample);
+            for (int32_t Sample = 0; Sample < 6; ++Sample) Odd += static_cast<char>(50 + Sample);
+            for (int32_t Sample = 0; Sample < 6; ++Sample) Odd += static_cast<char>(70 + Sample);
+        }
+        Odd += "FRAME\n0123";
+        bool bPass = Check(WriteFile(Path, Odd) && Reader.Open(Path), "odd-size Y4M does not open");
+        bPass &= Check(Reader.GetFrameCount() == 2 && Reader.GetInfo().Width == 4 && Reader.GetInfo().Height == 2, "odd-size frame count or crop");
+        bPass &= Check(Reader.GetInfo().FrameRateNumerator == 25 && Reader.GetInfo().Format == EPixelFormat::NV12, "odd-size stream parameters");
+        bPass &= Check(Reader.ReadFrame(Frame) && Reader.ReadFrame(Frame), "odd-size frames do not read");
+        const FFrameView& View = Frame.GetView();
+        bPass &= Check(View.Row(0, 0)[0] == 100 && View.Row(0, 0)[3] == 103 && View.Row(0, 1)[0] == 105, "luma rows not at the file's stride");
+        bPass &= Check(View.Row(1, 0)[0] == 50 && View.Row(1, 0)[1] == 70 && View.Row(1, 0)[2] == 51 && View.Row(1, 0)[3] == 71, "chroma not interleaved U, V");
+
+        std::string Mono = "YUV4MPEG2 W4 H2 Cmono\nFRAME\n" + std::string(8, '\x40');
+        bPass &= Check(WriteFile(Path, Mono) && Reader.Open(Path) && Reader.ReadFrame(Frame), "mono Y4M does not open");
+        bPass &= Check(Frame.GetView().Row(0, 1)[3] == 0x40 && Frame.GetView().Row(1, 0)[1] == 128, "mono luma or neutral chroma");
+        bPass &= Check(Reader.GetInfo().FrameRateNumerator == 30, "missing rate is not 30 fps");
+
+        // 10-bit samples are little-endian in the file and MSB-aligned in P010.
+        std::string Deep = "YUV4MPEG2 W2 H2 F30:1 C420p10\nFRAME\n";
+        Deep += std::string("\xFF\x03\x00\x00\x00\x02\x01\x00", 8) + std::string("\x00\x01\x00\x03", 4);
+        bPass &= Check(WriteFile(Path, Deep) && Reader.Open(Path) && Reader.ReadFrame(Frame), "10-bit Y4M does not open");
+        const uint16_t* Luma = reinterpret_cast<const uint16_t*>(Frame.GetView().Row(0, 0));
+        const uint16_t* Chroma = reinterpret_cast<const uint16_t*>(Frame.GetView().Row(1, 0));
+        bPass &= Check(Frame.Format() == EPixelFormat::P010 && Luma[0] == 0xFFC0 && Luma[1] == 0, "10-bit luma not MSB-aligned");
+        bPass &= Check(Chroma[0] == 0x4000 && Chroma[1] == 0xC000, "10-bit chroma not MSB-aligned");
+
+        bPass &= Check(WriteFile(Path, "YUV4MPEG2 W4 H2 C422\nFRAME\n" + std::string(16, '\0')) && !Reader.Open(Path), "4:2:2 accepted");
+        bPass &= Check(WriteFile(Path, "YUV4MPEG2 H2 C420\nFRAME\n" + std::string(6, '\0')) && !Reader.Open(Path), "missing width accepted");
+        bPass &= Check(WriteFile(Path, "RIFF....WAVE") && !Reader.Open(Path), "non-Y4M accepted");
+        bPass &= Check(WriteFile(Path, "YUV4MPEG2 W4 H2\nFRAME\n12") && !Reader.Open(Path), "file without a whole frame accepted");
+        bPass &= Check(!Reader.Open(Path + ".missing") && !Reader.GetError().empty(), "missing file opened");
+        std::remove(Path.c_str());
+        return bPass;
+    }
+
+    /** Reads (or generates) and composes every frame of Source, timing the two stages. */
+    void TimeFramePath(const char* Name, IVideoSource& Source, const FBenchOptions& Options, FThreadPool& Pool)
+    {
+        FSoftwareCompositor Compositor(Pool);
+        std::vector<FCompositorOutput> Outputs(1);
+        Outputs[0].Target = { 0, 0, Source.GetInfo().Width, Source.GetInfo().Height };
+        Compositor.Configure(Source.GetInfo().Width, Source.GetInfo().Height, Outputs);
+
+        FFrame Frame;
+        double ReadMs = 0.0;
+        double ComposeMs = 0.0;
+        int32_t Frames = 0;
+        for (; Frames < Options.Frames; ++Frames)
+        {
+            auto Start = std::chrono::steady_clock::now();
+            if (!Source.ReadFrame(Frame)) break;
+            ReadMs += ElapsedMs(Start);
+            Start = std::chrono::steady_clock::now();
+            Compositor.Compose(Frame.GetView());
+            ComposeMs += ElapsedMs(Start);
+        }
+        if (!Frames) return;
+        const FCompositorStats& Stats = Compositor.GetStats();
+        double BudgetMs = 1000.0 / Options.FrameRate;
+        double FrameMs = (ReadMs + ComposeMs) / Frames;
+        std::printf
+        (
+            "  %-16s read %7.2f ms  compose %7.2f ms  dirty %5.1f%%  %5.1fx the %.1f ms budget\n", Name,
+            ReadMs / Frames, ComposeMs / Frames, Stats.TilesTotal ? 100.0 * Stats.TilesDirty / Stats.TilesTotal : 0.0,
+            BudgetMs / FrameMs, BudgetMs
+        );
+    }
+
+    bool BenchScenes(const FBenchOptions& Options)
+    {
+        FThreadPool Pool;
+        std::printf
+        (
+            "frame path %dx%d %s at %u fps, %d frames, %zu worker(s) and the caller:\n", Options.Width, Options.Height,
+            Options.Format == EPixelFormat::P010 ? "P010" : "NV12", Options.FrameRate, Options.Frames, Pool.GetWorkerCount()
+        );
+        bool bPass = true;
+        for (EPatternScene Scene : Scenes)
+        {
+            FPatternSettings Settings = MakeSettings(Scene, Options.Format, Options.Width, Options.Height);
+            Settings.FrameRateNumerator = Options.FrameRate;
+            Settings.FrameCount = Options.Frames;
+
+            std::string Path = GetTempPath(GetPatternSceneName(Scene));
+            FPatternSource Capture(Settings);
+            FY4MWriter Writer;
+            FFrame Frame;
+            bool bWritten = Writer.Open(Path, Capture.GetInfo());
+            while (bWritten && Capture.ReadFrame(Frame)) bWritten = Writer.WriteFrame(Frame.GetView());
+            bWritten &= Writer.Close();
+            if (!Check(bWritten, "cannot write the Y4M capture"))
+            {
+                std::remove(Path.c_str());
+                bPass = false;
+                continue;
+            }
+
+            std::string Label = std::string(GetPatternSceneName(Scene));
+            FPatternSource Pattern(Settings);
+            TimeFramePath((Label + " pattern").c_str(), Pattern, Options, Pool);
+            FY4MSource Reader;
+            bPass &= Check(Reader.Open(Path), "cannot open the Y4M capture");
+            TimeFramePath((Label + " y4m").c_str(), Reader, Options, Pool);
+            std::remove(Path.c_str());
+        }
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: source_bench [--size WxH] [--fps N] [--frames N] [--format nv12|p010]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckPatternDeterminism(), "pattern determinism");
+    bPass &= Check(CheckPatternTiming(), "pattern timing");
+    bPass &= Check(CheckPatternPaths(), "pattern paths");
+    bPass &= Check(CheckSceneCharacter(), "scene character");
+    bPass &= Check(CheckY4MRoundTrip(), "Y4M round trip");
+    bPass &= Check(CheckY4MParsing(), "Y4M parsing");
+    bPass &= Check(BenchScenes(Options), "frame path benchmark");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+// span_bench - Span-mode bezel placement, viewport mapping and crop checks.
+// Lays out side-by-side, stacked, grid and mixed-row monitor sets and checks where
+// each monitor lands on the bezel-expanded canvas: only monitors in the same row
+// (or column) push it right (or down). Then checks the normalized source rects for
+// cover and stretch fit - neighbours meet across exactly one bezel, the outermost
+// monitors reach the visible edges, cover keeps the video's aspect - and that the
+// pixel crops agree with them and cut a shared NV12 frame into zero-copy views
+// whose planes stay aligned. Finally times Build and the per-monitor crops for
+// --monitors monitors in a row.
+//   g++ -std=c++20 -O2 -pthread span_bench.cpp -o span_bench
+//   span_bench [--monitors N] [--bezel N] [--iterations N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "span_layout.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    struct FBenchOptions
+    {
+        int32_t Monitors = 4;
+        int32_t Bezel = 60;
+        int32_t Iterations = 100000;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--monitors") Options.Monitors = std::atoi(Value);
+            else if (Name == "--bezel") Options.Bezel = std::atoi(Value);
+            else if (Name == "--iterations") Options.Iterations = std::atoi(Value);
+            else return false;
+        }
+        return Options.Monitors > 0 && Options.Bezel >= 0 && Options.Iterations > 0;
+    }
+
+    bool Near(double A, double B, double Tolerance = 1e-5)
+    {
+        return std::fabs(A - B) <= Tolerance;
+    }
+
+    void PrintLayout(const FSpanLayout& Layout, int32_t VideoWidth, int32_t VideoHeight)
+    {
+        for (size_t Index = 0; Index < Layout.Size(); ++Index)
+        {
+            FSpanViewport Viewport = Layout.GetViewport(Index, VideoWidth, VideoHeight);
+            std::printf("  monitor %zu: physical %d,%d-%d,%d source %.4f,%.4f-%.4f,%.4f\n", Index,
+                Viewport.Physical.Left, Viewport.Physical.Top, Viewport.Physical.Right, Viewport.Physical.Bottom,
+                Viewport.Source.Left, Viewport.Source.Top, Viewport.Source.Right, Viewport.Source.Bottom);
+        }
+    }
+
+    bool CheckPlacement()
+    {
+        bool bPass = true;
+        FSpanLayout Layout;
+
+        // Two side by side and a smaller one below the first: the lower row has no bezel to its left.
+        FSpanSettings Settings;
+        Settings.BezelX = 100;
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 0, 1080, 1280, 1800 } }, Settings);
+        FSpanViewport Second = Layout.GetViewport(1, 1920, 1080);
+        FSpanViewport Below = Layout.GetViewport(2, 1920, 1080);
+        if (Second.Physical.Left != 2020) PrintLayout(Layout, 1920, 1080);
+        bPass &= Check(Second.Physical == FIntRect{ 2020, 0, 3940, 1080 }, "monitor beside is shifted by one bezel");
+        bPass &= Check(Below.Physical == FIntRect{ 0, 1080, 1280, 1800 }, "monitor in another row is not shifted");
+        bPass &= Check(Layout.GetCanvas() == FIntRect{ 0, 0, 3940, 1800 }, "mixed-row canvas");
+
+        // Three in a row.
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 3840, 0, 5760, 1080 } }, Settings);
+        bPass &= Check(Layout.GetViewport(1, 0, 0).Physical.Left == 2020 && Layout.GetViewport(2, 0, 0).Physical.Left == 4040,
+            "one bezel per monitor to the left");
+        bPass &= Check(Layout.GetCanvas() == FIntRect{ 0, 0, 5960, 1080 }, "row canvas includes the bezels");
+
+        // A column, with a monitor beside the top one that must not push the lower one down.
+        Settings = {};
+        Settings.BezelY = 50;
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 0, 1080, 1920, 2160 }, { 1920, 0, 3840, 700 } }, Settings);
+        bPass &= Check(Layout.GetViewport(1, 0, 0).Physical.Top == 1130, "stacked monitor shifted by one bezel");
+        bPass &= Check(Layout.GetViewport(2, 0, 0).Physical.Top == 0, "top-row monitor not shifted down");
+
+        // A 2x2 grid shifts right and down independently.
+        Settings.BezelX = 80;
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 0, 1080, 1920, 2160 }, { 1920, 1080, 3840, 2160 } }, Settings);
+        bPass &= Check(Layout.GetViewport(3, 0, 0).Physical == FIntRect{ 2000, 1130, 3920, 2210 }, "grid corner shifted both ways");
+        bPass &= Check(Layout.GetViewport(2, 0, 0).Physical == FIntRect{ 0, 1130, 1920, 2210 }, "grid lower left shifted down only");
+
+        // A monitor left of the origin and a portrait monitor spanning both rows of its neighbours.
+        Settings = {};
+        Settings.BezelX = 40;
+        Settings.BezelY = 40;
+        Layout.Build({ { -1080, 0, 0, 1920 }, { 0, 0, 1920, 1080 }, { 0, 1080, 1920, 2160 } }, Settings);
+        bPass &= Check(Layout.GetViewport(0, 0, 0).Physical == FIntRect{ -1080, 0, 0, 1920 }, "leftmost portrait monitor in place");
+        bPass &= Check(Layout.GetViewport(1, 0, 0).Physical.Left == 40 && Layout.GetViewport(2, 0, 0).Physical.Left == 40,
+            "both rows beside the portrait monitor shift once");
+        bPass &= Check(Layout.GetViewport(2, 0, 0).Physical.Top == 1120, "lower landscape monitor shifted down once");
+        return bPass;
+    }
+
+    bool CheckViewports()
+    {
+        bool bPass = true;
+        FSpanLayout Layout;
+        FSpanSettings Settings;
+        Settings.BezelX = 100;
+        std::vector<FIntRect> Row = { { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 3840, 0, 5760, 1080 } };
+
+        // Stretch: the canvas is the whole video.
+        Settings.Fit = ESpanFit::Stretch;
+        Layout.Build(Row, Settings);
+        FNormalizedRect First = Layout.GetViewport(0, 1920, 1080).Source;
+        FNormalizedRect Middle = Layout.GetViewport(1, 1920, 1080).Source;
+        FNormalizedRect Last = Layout.GetViewport(2, 1920, 1080).Source;
+        double Bezel = 100.0 / 5960.0;
+        bPass &= Check(Near(First.Left, 0.0) && Near(Last.Right, 1.0), "stretch reaches both video edges");
+        bPass &= Check(Near(First.Top, 0.0) && Near(First.Bottom, 1.0), "stretch shows the full height");
+        bPass &= Check(Near(Middle.Left - First.Right, Bezel) && Near(Last.Left - Middle.Right, Bezel),
+            "neighbours meet across one bezel");
+        bPass &= Check(Near(Middle.Right - Middle.Left, 1920.0 / 5960.0), "each monitor shows its share");
+
+        // Cover, video narrower than the canvas: full width, middle band of rows.
+        Settings.Fit = ESpanFit::Cover;
+        Layout.Build(Row, Settings);
+        First = Layout.GetViewport(0, 1920, 1080).Source;
+        Last = Layout.GetViewport(2, 1920, 1080).Source;
+        double VisibleHeight = (1920.0 / 1080.0) / (5960.0 / 1080.0);
+        bPass &= Check(Near(First.Left, 0.0) && Near(Last.Right, 1.0), "cover keeps the full width");
+        bPass &= Check(Near(First.Bottom - First.Top, VisibleHeight) && Near(First.Top, (1.0 - VisibleHeight) * 0.5),
+            "cover crops top and bottom evenly");
+        double ShownAspect = (Last.Right - First.Left) * 1920.0 / ((First.Bottom - First.Top) * 1080.0);
+        bPass &= Check(Near(ShownAspect, 5960.0 / 1080.0, 1e-3), "cover shows the canvas aspect");
+
+        // Cover, video wider than the canvas: full height, middle band of columns.
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 0, 1080, 1920, 2160 } }, FSpanSettings{});
+        FNormalizedRect Top = Layout.GetViewport(0, 3840, 1080).Source;
+        FNormalizedRect Bottom = Layout.GetViewport(1, 3840, 1080).Source;
+        double VisibleWidth = (1920.0 / 2160.0) / (3840.0 / 1080.0);
+        bPass &= Check(Near(Top.Top, 0.0) && Near(Bottom.Bottom, 1.0) && Near(Top.Bottom, Bottom.Top), "stack shares the full height");
+        bPass &= Check(Near(Top.Right - Top.Left, VisibleWidth) && Near(Top.Left, (1.0 - VisibleWidth) * 0.5),
+            "cover crops left and right evenly");
+
+        bPass &= Check(Layout.GetViewport(5, 1920, 1080).Physical.IsEmpty(), "unknown monitor gets an empty viewport");
+        return bPass;
+    }
+
+    bool CheckCrops()
+    {
+        bool bPass = true;
+        FSpanLayout Layout;
+        FSpanSettings Settings;
+        Settings.Fit = ESpanFit::Stretch;
+
+        // No bezel, frame the size of the canvas: crops are the monitor rects.
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 3840, 0, 5760, 1080 } }, Settings);
+        bPass &= Check(Layout.GetCropRect(1, 5760, 1080) == FIntRect{ 1920, 0, 3840, 1080 }, "crop at native size");
+
+        // Crops of a smaller frame tile it without gaps or overlap.
+        int32_t Covered = 0;
+        FIntRect Previous;
+        bool bContiguous = true;
+        for (size_t Index = 0; Index < Layout.Size(); ++Index)
+        {
+            FIntRect Crop = Layout.GetCropRect(Index, 1920, 1080);
+            bContiguous &= Index == 0 ? Crop.Left == 0 : Crop.Left == Previous.Right;
+            bContiguous &= Crop.Top == 0 && Crop.Bottom == 1080;
+            Covered += Crop.Width();
+            Previous = Crop;
+        }
+        bPass &= Check(bContiguous && Covered == 1920, "scaled crops tile the frame");
+
+        // With bezels the crops skip the hidden columns.
+        Settings.BezelX = 100;
+        Layout.Build({ { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 } }, Settings);
+        FIntRect Left = Layout.GetCropRect(0, 3940, 1080);
+        FIntRect Right = Layout.GetCropRect(1, 3940, 1080);
+        bPass &= Check(Left == FIntRect{ 0, 0, 1920, 1080 } && Right == FIntRect{ 2020, 0, 3940, 1080 }, "crops skip the bezel");
+
+        // Crop views of one shared NV12 frame point into it and keep chroma aligned.
+        Settings = {};
+        Settings.BezelX = 33;
+        Layout.Build({ { 0, 0, 1280, 720 }, { 1280, 0, 2560, 720 }, { 0, 720, 1280, 1440 } }, Settings);
+        FFrame Shared(1919, 1081, EPixelFormat::NV12);
+        const FFrameView& Whole = Shared.GetView();
+        bool bInside = true;
+        bool bAligned = true;
+        for (size_t Index = 0; Index < Layout.Size(); ++Index)
+        {
+            FIntRect Crop = Layout.GetCropRect(Index, Whole.Width, Whole.Height);
+            FFrameView View = Whole.Crop(Crop);
+            bInside &= View.IsValid() && View.Width <= Whole.Width && View.Height <= Whole.Height;
+            ptrdiff_t Offset = View.Planes[0] - Whole.Planes[0];
+            int32_t X = static_cast<int32_t>(Offset % Whole.Strides[0]);
+            int32_t Y = static_cast<int32_t>(Offset / Whole.Strides[0]);
+            bInside &= X + View.Width <= Whole.Width && Y + View.Height <= Whole.Height;
+            bAligned &= X % 2 == 0 && Y % 2 == 0;
+            bAligned &= View.Planes[1] == Whole.Planes[1] + static_cast<ptrdiff_t>(Y / 2) * Whole.Strides[1] + X;
+        }
+        bPass &= Check(bInside, "crop views lie inside the shared frame");
+        bPass &= Check(bAligned, "crop views keep chroma aligned");
+        bPass &= Check(Layout.GetCropRect(0, 0, 0).IsEmpty(), "empty frame gives an empty crop");
+        return bPass;
+    }
+
+    void RunBenchmark(const FBenchOptions& Options)
+    {
+        std::vector<FIntRect> Monitors;
+        for (int32_t Index = 0; Index < Options.Monitors; ++Index)
+        {
+            Monitors.push_back({ Index * 1920, 0, (Index + 1) * 1920, 1080 });
+        }
+        FSpanSettings Settings;
+        Settings.BezelX = Options.Bezel;
+        FSpanLayout Layout;
+
+        auto Start = std::chrono::steady_clock::now();
+        for (int32_t Iteration = 0; Iteration < Options.Iterations; ++Iteration) Layout.Build(Monitors, Settings);
+        double BuildNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Options.Iterations;
+
+        int64_t Sum = 0;
+        Start = std::chrono::steady_clock::now();
+        for (int32_t Iteration = 0; Iteration < Options.Iterations; ++Iteration)
+        {
+            for (size_t Index = 0; Index < Layout.Size(); ++Index) Sum += Layout.GetCropRect(Index, 3840, 2160).Left;
+        }
+        double CropNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count()
+            / (static_cast<double>(Options.Iterations) * Options.Monitors);
+
+        std::printf("%d monitors, bezel %d: %.0f ns per build, %.1f ns per crop (checksum %lld)\n",
+            Options.Monitors, Options.Bezel, BuildNs, CropNs, static_cast<long long>(Sum));
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: span_bench [--monitors N] [--bezel N] [--iterations N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckPlacement(), "placement");
+    bPass &= Check(CheckViewports(), "viewports");
+    bPass &= Check(CheckCrops(), "crops");
+    RunBenchmark(Options);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
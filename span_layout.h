@@ -0,0 +1,154 @@
+// SpanLayout - Maps one video across the virtual desktop, one crop per monitor.
+// Monitors are placed on a physical canvas: their virtual-desktop positions plus
+// a bezel gap for every edge of a monitor in the same row (or column) that lies
+// between them and the canvas origin, so a scene continues "behind" the bezels
+// instead of jumping across them. Monitors in other rows do not shift them.
+// Each monitor then gets the normalized source rectangle of the video that
+// covers its physical area (for EVR source rects) or the equivalent pixel rect
+// (for zero-copy FFrameView crops of a shared decoded frame).
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+
+enum class ESpanFit : uint8_t
+{
+    Cover,      // Preserve video aspect; crop the excess so the canvas is filled
+    Stretch     // Map the whole video onto the whole canvas
+};
+
+struct FSpanSettings
+{
+    int32_t BezelX = 0;     // Horizontal gap between side-by-side monitors, in pixels
+    int32_t BezelY = 0;     // Vertical gap between stacked monitors, in pixels
+    ESpanFit Fit = ESpanFit::Cover;
+};
+
+/** Source rectangle in normalized [0,1] video coordinates. */
+struct FNormalizedRect
+{
+    float Left = 0.0f;
+    float Top = 0.0f;
+    float Right = 1.0f;
+    float Bottom = 1.0f;
+};
+
+struct FSpanViewport
+{
+    FIntRect Physical;          // Monitor rect on the bezel-expanded canvas
+    FNormalizedRect Source;     // Part of the video this monitor shows
+};
+
+class FSpanLayout
+{
+public:
+    /** Rebuilds the canvas for a monitor layout; call again on display changes. */
+    void Build(const std::vector<FIntRect>& MonitorRects, const FSpanSettings& InSettings)
+    {
+        Settings = InSettings;
+        Physical.clear();
+        Physical.reserve(MonitorRects.size());
+        Canvas = {};
+
+        for (const auto& Rect : MonitorRects)
+        {
+            int32_t ShiftX = Settings.BezelX * CountEdgesBefore(MonitorRects, Rect, true);
+            int32_t ShiftY = Settings.BezelY * CountEdgesBefore(MonitorRects, Rect, false);
+            FIntRect Moved{ Rect.Left + ShiftX, Rect.Top + ShiftY, Rect.Right + ShiftX, Rect.Bottom + ShiftY };
+            Physical.push_back(Moved);
+
+            if (Physical.size() == 1) Canvas = Moved;
+            else
+            {
+                if (Moved.Left < Canvas.Left) Canvas.Left = Moved.Left;
+                if (Moved.Top < Canvas.Top) Canvas.Top = Moved.Top;
+                if (Moved.Right > Canvas.Right) Canvas.Right = Moved.Right;
+                if (Moved.Bottom > Canvas.Bottom) Canvas.Bottom = Moved.Bottom;
+            }
+        }
+    }
+
+    const FIntRect& GetCanvas() const { return Canvas; }
+    size_t Size() const { return Physical.size(); }
+
+    /** Viewport for one monitor given the video's display size. */
+    FSpanViewport GetViewport(size_t MonitorIndex, int32_t VideoWidth, int32_t VideoHeight) const
+    {
+        FSpanViewport Viewport;
+        if (MonitorIndex >= Physical.size() || Canvas.IsEmpty()) return Viewport;
+        Viewport.Physical = Physical[MonitorIndex];
+
+        // Region of the video (normalized) that is stretched over the whole canvas.
+        double VisibleLeft = 0.0, VisibleTop = 0.0, VisibleWidth = 1.0, VisibleHeight = 1.0;
+        if (Settings.Fit == ESpanFit::Cover && VideoWidth > 0 && VideoHeight > 0)
+        {
+            double VideoAspect = static_cast<double>(VideoWidth) / VideoHeight;
+            double CanvasAspect = static_cast<double>(Canvas.Width()) / Canvas.Height();
+            if (VideoAspect > CanvasAspect)
+            {
+                VisibleWidth = CanvasAspect / VideoAspect;
+                VisibleLeft = (1.0 - VisibleWidth) * 0.5;
+            }
+            else
+            {
+                VisibleHeight = VideoAspect / CanvasAspect;
+                VisibleTop = (1.0 - VisibleHeight) * 0.5;
+            }
+        }
+
+        const FIntRect& Rect = Viewport.Physical;
+        double ScaleX = VisibleWidth / Canvas.Width();
+        double ScaleY = VisibleHeight / Canvas.Height();
+        Viewport.Source.Left = static_cast<float>(VisibleLeft + (Rect.Left - Canvas.Left) * ScaleX);
+        Viewport.Source.Right = static_cast<float>(VisibleLeft + (Rect.Right - Canvas.Left) * ScaleX);
+        Viewport.Source.Top = static_cast<float>(VisibleTop + (Rect.Top - Canvas.Top) * ScaleY);
+        Viewport.Source.Bottom = static_cast<float>(VisibleTop + (Rect.Bottom - Canvas.Top) * ScaleY);
+        return Viewport;
+    }
+
+    /** Pixel crop of a decoded frame for one monitor, ready for FFrameView::Crop. */
+    FIntRect GetCropRect(size_t MonitorIndex, int32_t FrameWidth, int32_t FrameHeight) const
+    {
+        FNormalizedRect Source = GetViewport(MonitorIndex, FrameWidth, FrameHeight).Source;
+        FIntRect Crop;
+        Crop.Left = static_cast<int32_t>(std::lround(Source.Left * FrameWidth));
+        Crop.Top = static_cast<int32_t>(std::lround(Source.Top * FrameHeight));
+        Crop.Right = static_cast<int32_t>(std::lround(Source.Right * FrameWidth));
+        Crop.Bottom = static_cast<int32_t>(std::lround(Source.Bottom * FrameHeight));
+        return IntersectRect(Crop, FIntRect{ 0, 0, FrameWidth, FrameHeight });
+    }
+
+private:
+    /**
+     * Number of distinct far edges (right or bottom) at or before Rect's left or top,
+     * counting only monitors beside it: sharing rows for X, sharing columns for Y.
+     * Each one is a bezel the scene has to cross to reach Rect.
+     */
+    static int32_t CountEdgesBefore(const std::vector<FIntRect>& Rects, const FIntRect& Rect, bool bHorizontal)
+    {
+        int32_t Coordinate = bHorizontal ? Rect.Left : Rect.Top;
+        std::vector<int32_t> Edges;
+        for (const auto& Other : Rects)
+        {
+            bool bBeside = bHorizontal
+                ? Other.Top < Rect.Bottom && Other.Bottom > Rect.Top
+                : Other.Left < Rect.Right && Other.Right > Rect.Left;
+            if (!bBeside) continue;
+            int32_t Edge = bHorizontal ? Other.Right : Other.Bottom;
+            if (Edge > Coordinate) continue;
+            bool bSeen = false;
+            for (int32_t Existing : Edges) bSeen = bSeen || Existing == Edge;
+            if (!bSeen) Edges.push_back(Edge);
+        }
+        return static_cast<int32_t>(Edges.size());
+    }
+
+    FSpanSettings Settings;
+    std::vector<FIntRect> Physical;
+    FIntRect Canvas;
+};
@@ -0,0 +1,124 @@
+// TaskGroup - Concurrent per-monitor pipeline orchestration.
+// FTaskGroup fans blocking work (player teardown) out to one thread per task and
+// lets the caller poll for completion so a UI thread can keep pumping messages.
+// FPipelineBarrier tracks asynchronous per-monitor bring-up and reports, exactly
+// once, when every monitor has either become ready or failed.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class FTaskGroup
+{
+public:
+    FTaskGroup() = default;
+    FTaskGroup(const FTaskGroup&) = delete;
+    FTaskGroup& operator=(const FTaskGroup&) = delete;
+
+    ~FTaskGroup() { Join(); }
+
+    /** Starts Task on its own thread immediately. */
+    void Run(std::function<void()> Task)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            ++Pending;
+        }
+        Threads.emplace_back([this, Task = std::move(Task)]()
+        {
+            Task();
+            std::lock_guard<std::mutex> Lock(Mutex);
+            if (--Pending == 0) Done.notify_all();
+        });
+    }
+
+    /** Waits up to Timeout for all tasks; returns true once every task has finished. */
+    bool WaitFor(std::chrono::milliseconds Timeout)
+    {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        return Done.wait_for(Lock, Timeout, [this] { return Pending == 0; });
+    }
+
+    /** Blocks until every task has finished and reclaims the threads. */
+    void Join()
+    {
+        for (auto& Thread : Threads)
+        {
+            if (Thread.joinable()) Thread.join();
+        }
+        Threads.clear();
+    }
+
+private:
+    std::vector<std::thread> Threads;
+    std::mutex Mutex;
+    std::condition_variable Done;
+    size_t Pending = 0;
+};
+
+enum class EPipelineSlotState : uint8_t
+{
+    Pending,
+    Ready,
+    Failed
+};
+
+/**
+ * Completion barrier for N independently-starting pipelines. Single-threaded by design:
+ * the Windows path only touches it from the UI thread where MFPlay delivers callbacks.
+ */
+class FPipelineBarrier
+{
+public:
+    /** Re-arms the barrier for a new set of pipelines. */
+    void Reset(size_t SlotCount)
+    {
+        Slots.assign(SlotCount, EPipelineSlotState::Pending);
+        SettledCount = 0;
+        bReleased = false;
+    }
+
+    /** Returns true if this call settled the last pending slot (release the barrier now). */
+    bool MarkReady(size_t Slot) { return Settle(Slot, EPipelineSlotState::Ready); }
+
+    /** Returns true if this call settled the last pending slot (release the barrier now). */
+    bool MarkFailed(size_t Slot) { return Settle(Slot, EPipelineSlotState::Failed); }
+
+    EPipelineSlotState GetState(size_t Slot) const
+    {
+        return Slot < Slots.size() ? Slots[Slot] : EPipelineSlotState::Failed;
+    }
+
+    bool IsReleased() const { return bReleased; }
+    size_t Size() const { return Slots.size(); }
+
+    size_t CountIn(EPipelineSlotState State) const
+    {
+        size_t Count = 0;
+        for (auto SlotState : Slots) Count += SlotState == State ? 1 : 0;
+        return Count;
+    }
+
+private:
+    bool Settle(size_t Slot, EPipelineSlotState State)
+    {
+        if (Slot >= Slots.size() || Slots[Slot] != EPipelineSlotState::Pending) return false;
+        Slots[Slot] = State;
+        if (++SettledCount < Slots.size() || bReleased) return false;
+        bReleased = true;
+        return true;
+    }
+
+    std::vector<EPipelineSlotState> Slots;
+    size_t SettledCount = 0;
+    bool bReleased = false;
+};
@@ -0,0 +1,203 @@
+// ThreadPool - Small work-stealing pool for data-parallel frame work.
+// Each worker owns a deque: it pops its own work from the front and, when empty,
+// steals from the back of a sibling's deque. ParallelFor splits an index range
+// into per-worker chunks and the calling thread helps until the batch finishes,
+// so a pool with zero workers degrades to running inline.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "resource_tracker.h"
+
+class FThreadPool
+{
+public:
+    /**
+     * WorkerCount 0 picks hardware_concurrency - 1 (the caller is the extra thread).
+     * OnWorkerStart, if set, runs first on every worker thread (to register it with GQos, say).
+     */
+    explicit FThreadPool(size_t WorkerCount = 0, std::function<void()> OnWorkerStart = {})
+    {
+        if (!WorkerCount)
+        {
+            size_t Hardware = std::thread::hardware_concurrency();
+            WorkerCount = Hardware > 1 ? Hardware - 1 : 0;
+        }
+        Queues.reserve(WorkerCount);
+        for (size_t Index = 0; Index < WorkerCount; ++Index) Queues.push_back(std::make_unique<FWorkQueue>());
+        for (size_t Index = 0; Index < WorkerCount; ++Index)
+        {
+            Workers.emplace_back([this, Index, OnWorkerStart]
+            {
+                if (OnWorkerStart) OnWorkerStart();
+                WorkerLoop(Index);
+            });
+        }
+        GResources.Acquire("ThreadPool", EResourceKind::Handle, static_cast<int64_t>(Workers.size()));
+    }
+
+    ~FThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(WakeMutex);
+            bStopping = true;
+        }
+        WakeCondition.notify_all();
+        for (auto& Worker : Workers) Worker.join();
+        GResources.Release("ThreadPool", EResourceKind::Handle, static_cast<int64_t>(Workers.size()));
+    }
+
+    FThreadPool(const FThreadPool&) = delete;
+    FThreadPool& operator=(const FThreadPool&) = delete;
+
+    size_t GetWorkerCount() const { return Workers.size(); }
+
+    /** Runs Body(Index) for Index in [0, Count) across the pool and the calling thread; blocks until done. */
+    void ParallelFor(size_t Count, const std::function<void(size_t)>& Body)
+    {
+        if (!Count) return;
+        if (Workers.empty() || Count == 1)
+        {
+            for (size_t Index = 0; Index < Count; ++Index) Body(Index);
+            return;
+        }
+
+        auto Batch = std::make_shared<FBatch>();
+        Batch->Body = &Body;
+
+        // A few chunks per participant keeps stealing effective when tiles differ in cost.
+        size_t Participants = Workers.size() + 1;
+        size_t ChunkCount = Participants * 4 < Count ? Participants * 4 : Count;
+        size_t ChunkSize = (Count + ChunkCount - 1) / ChunkCount;
+        ChunkCount = (Count + ChunkSize - 1) / ChunkSize;
+        Batch->Remaining.store(ChunkCount, std::memory_order_relaxed);
+
+        for (size_t Chunk = 0; Chunk < ChunkCount; ++Chunk)
+        {
+            size_t Begin = Chunk * ChunkSize;
+            size_t End = Begin + ChunkSize < Count ? Begin + ChunkSize : Count;
+            FWorkQueue& Queue = *Queues[Chunk % Queues.size()];
+            std::lock_guard<std::mutex> Lock(Queue.Mutex);
+            Queue.Items.push_back({ Batch, Begin, End });
+        }
+        {
+            std::lock_guard<std::mutex> Lock(WakeMutex);
+            ++ActiveBatches;
+        }
+        WakeCondition.notify_all();
+
+        // Help from the caller's side until every chunk of this batch is done.
+        FWorkItem Item;
+        while (Batch->Remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (TrySteal(Queues.size(), Item)) Execute(Item);
+            else std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> Lock(WakeMutex);
+            --ActiveBatches;
+        }
+    }
+
+    uint64_t GetStealCount() const { return Steals.load(std::memory_order_relaxed); }
+
+private:
+    struct FBatch
+    {
+        const std::function<void(size_t)>* Body = nullptr;
+        std::atomic<size_t> Remaining{ 0 };
+    };
+
+    struct FWorkItem
+    {
+        std::shared_ptr<FBatch> Batch;
+        size_t Begin = 0;
+        size_t End = 0;
+    };
+
+    struct FWorkQueue
+    {
+        std::mutex Mutex;
+        std::deque<FWorkItem> Items;
+    };
+
+    static void Execute(FWorkItem& Item)
+    {
+        for (size_t Index = Item.Begin; Index < Item.End; ++Index) (*Item.Batch->Body)(Index);
+        Item.Batch->Remaining.fetch_sub(1, std::memory_order_acq_rel);
+        Item.Batch.reset();
+    }
+
+    bool PopOwn(size_t Self, FWorkItem& Out)
+    {
+        FWorkQueue& Queue = *Queues[Self];
+        std::lock_guard<std::mutex> Lock(Queue.Mutex);
+        if (Queue.Items.empty()) return false;
+        Out = std::move(Queue.Items.front());
+        Queue.Items.pop_front();
+        return true;
+    }
+
+    /** Steals from the back of any queue other than Self (Self == size() means "not a worker"). */
+    bool TrySteal(size_t Self, FWorkItem& Out)
+    {
+        for (size_t Offset = 1; Offset <= Queues.size(); ++Offset)
+        {
+            size_t Victim = (Self + Offset) % Queues.size();
+            if (Victim == Self) continue;
+            FWorkQueue& Queue = *Queues[Victim];
+            std::lock_guard<std::mutex> Lock(Queue.Mutex);
+            if (Queue.Items.empty()) continue;
+            Out = std::move(Queue.Items.back());
+            Queue.Items.pop_back();
+            Steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void WorkerLoop(size_t Self)
+    {
+        FWorkItem Item;
+        for (;;)
+        {
+            if (PopOwn(Self, Item) || TrySteal(Self, Item))
+            {
+                Execute(Item);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> Lock(WakeMutex);
+            if (bStopping) return;
+            // Sleep only while no batch is in flight; a batch in flight may still have stealable chunks.
+            WakeCondition.wait(Lock, [this] { return bStopping || ActiveBatches > 0; });
+            if (bStopping) return;
+            Lock.unlock();
+            if (!PopOwn(Self, Item) && !TrySteal(Self, Item))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            Execute(Item);
+        }
+    }
+
+    std::vector<std::unique_ptr<FWorkQueue>> Queues;
+    std::vector<std::thread> Workers;
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    size_t ActiveBatches = 0;
+    bool bStopping = false;
+    std::atomic<uint64_t> Steals{ 0 };
+};
@@ -0,0 +1,242 @@
+// TileDiff - Per-tile change detection for presented frames.
+// Each tile of a composed BGRA frame is hashed right after it is written (while
+// it is still in cache) and compared with the previous frame's hash. Frames with
+// no changed tile need not be presented at all; otherwise the changed tiles are
+// coalesced into a few dirty rectangles so only those regions are blitted.
+// Cinemagraph-style wallpapers (mostly static, small moving area) benefit most.
+// Portable C++20: no platform headers (SSE2 intrinsics when available).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TILE_DIFF_SSE2 1
+#else
+#define TILE_DIFF_SSE2 0
+#endif
+
+#include "frame.h"
+
+/** Default tile edge in pixels (64x64 BGRA = 16 KB, fits L1/L2 comfortably). */
+constexpr int32_t DefaultTileSize = 64;
+
+/** Dirty rects beyond this many are merged into their bounding box; each blit has a fixed cost. */
+constexpr size_t MaxDirtyRects = 8;
+
+/** Splits a rect into a row-major grid of tiles no larger than TileSize. */
+struct FTileGrid
+{
+    FIntRect Bounds;
+    int32_t TileSize = DefaultTileSize;
+    int32_t Columns = 0;
+    int32_t Rows = 0;
+
+    FTileGrid() = default;
+    FTileGrid(const FIntRect& InBounds, int32_t InTileSize) { Reset(InBounds, InTileSize); }
+
+    void Reset(const FIntRect& InBounds, int32_t InTileSize)
+    {
+        Bounds = InBounds;
+        TileSize = InTileSize > 0 ? InTileSize : DefaultTileSize;
+        Columns = Bounds.IsEmpty() ? 0 : (Bounds.Width() + TileSize - 1) / TileSize;
+        Rows = Bounds.IsEmpty() ? 0 : (Bounds.Height() + TileSize - 1) / TileSize;
+    }
+
+    int32_t Count() const { return Columns * Rows; }
+
+    FIntRect GetTile(int32_t Index) const
+    {
+        int32_t Column = Index % Columns;
+        int32_t Row = Index / Columns;
+        FIntRect Tile;
+        Tile.Left = Bounds.Left + Column * TileSize;
+        Tile.Top = Bounds.Top + Row * TileSize;
+        Tile.Right = Tile.Left + TileSize < Bounds.Right ? Tile.Left + TileSize : Bounds.Right;
+        Tile.Bottom = Tile.Top + TileSize < Bounds.Bottom ? Tile.Top + TileSize : Bounds.Bottom;
+        return Tile;
+    }
+};
+
+/** Final avalanche so nearby accumulator states map to unrelated hashes. */
+inline uint64_t MixTileHash(uint64_t Value)
+{
+    Value ^= Value >> 30; Value *= 0xBF58476D1CE4E5B9ULL;
+    Value ^= Value >> 27; Value *= 0x94D049BB133111EBULL;
+    return Value ^ (Value >> 31);
+}
+
+inline uint64_t FoldTileLanes(const uint32_t Sum[4], const uint32_t Weighted[4])
+{
+    uint64_t Hash = 0x9E3779B97F4A7C15ULL;
+    for (int32_t Lane = 0; Lane < 4; ++Lane)
+    {
+        Hash = MixTileHash(Hash ^ (static_cast<uint64_t>(Weighted[Lane]) << 32 | Sum[Lane]));
+    }
+    return Hash;
+}
+
+/**
+ * Reference kernel. Pixels are spread over four 32-bit lanes (pixel x goes to lane
+ * x % 4); per 4-pixel step every lane does Sum += pixel, Weighted += Sum, i.e. a
+ * Fletcher-style checksum whose second term makes it position-sensitive.
+ */
+inline uint64_t HashTileBgraScalar(const FFrameView& View, const FIntRect& Tile)
+{
+    uint32_t Sum[4] = {};
+    uint32_t Weighted[4] = {};
+    for (int32_t Y = Tile.Top; Y < Tile.Bottom; ++Y)
+    {
+        const uint32_t* Row = reinterpret_cast<const uint32_t*>(View.Row(0, Y)) + Tile.Left;
+        int32_t Width = Tile.Width();
+        for (int32_t X = 0; X < Width; X += 4)
+        {
+            for (int32_t Lane = 0; Lane < 4; ++Lane)
+            {
+                if (X + Lane < Width) Sum[Lane] += Row[X + Lane];
+                Weighted[Lane] += Sum[Lane];
+            }
+        }
+    }
+    return FoldTileLanes(Sum, Weighted);
+}
+
+/** Same result as HashTileBgraScalar; two vector adds per four pixels. */
+inline uint64_t HashTileBgra(const FFrameView& View, const FIntRect& Tile)
+{
+#if TILE_DIFF_SSE2
+    __m128i Sum = _mm_setzero_si128();
+    __m128i Weighted = _mm_setzero_si128();
+    int32_t Width = Tile.Width();
+    int32_t VectorWidth = Width & ~3;
+    for (int32_t Y = Tile.Top; Y < Tile.Bottom; ++Y)
+    {
+        const uint32_t* Row = reinterpret_cast<const uint32_t*>(View.Row(0, Y)) + Tile.Left;
+        for (int32_t X = 0; X < VectorWidth; X += 4)
+        {
+            Sum = _mm_add_epi32(Sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(Row + X)));
+            Weighted = _mm_add_epi32(Weighted, Sum);
+        }
+        if (VectorWidth < Width)
+        {
+            uint32_t Tail[4] = {};
+            std::memcpy(Tail, Row + VectorWidth, static_cast<size_t>(Width - VectorWidth) * 4);
+            Sum = _mm_add_epi32(Sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(Tail)));
+            Weighted = _mm_add_epi32(Weighted, Sum);
+        }
+    }
+    alignas(16) uint32_t SumLanes[4];
+    alignas(16) uint32_t WeightedLanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(SumLanes), Sum);
+    _mm_store_si128(reinterpret_cast<__m128i*>(WeightedLanes), Weighted);
+    return FoldTileLanes(SumLanes, WeightedLanes);
+#else
+    return HashTileBgraScalar(View, Tile);
+#endif
+}
+
+/** Previous-frame tile hashes and this frame's dirty flags. Update() is safe to call concurrently for distinct tiles. */
+class FTileChangeDetector
+{
+public:
+    /** Every tile reports dirty on the first frame after a reset. */
+    void Reset(size_t TileCount)
+    {
+        Hashes.assign(TileCount, 0);
+        Dirty.assign(TileCount, 1);
+        bPrimed = false;
+    }
+
+    /** Forces the next frame to be fully dirty (e.g. after the target was repainted or resized). */
+    void Invalidate() { bPrimed = false; }
+
+    void Update(size_t TileIndex, uint64_t Hash)
+    {
+        Dirty[TileIndex] = !bPrimed || Hashes[TileIndex] != Hash;
+        Hashes[TileIndex] = Hash;
+    }
+
+    /** Call once all tiles of a frame have been updated. */
+    void EndFrame() { bPrimed = true; }
+
+    size_t Size() const { return Dirty.size(); }
+    bool IsDirty(size_t TileIndex) const { return Dirty[TileIndex] != 0; }
+    const uint8_t* GetDirtyFlags() const { return Dirty.data(); }
+
+    size_t CountDirty(size_t Begin, size_t End) const
+    {
+        size_t Count = 0;
+        for (size_t Index = Begin; Index < End; ++Index) Count += Dirty[Index];
+        return Count;
+    }
+
+private:
+    std::vector<uint64_t> Hashes;
+    std::vector<uint8_t> Dirty;
+    bool bPrimed = false;
+};
+
+/**
+ * Merges the dirty tiles of one grid (flags in row-major order) into rectangles:
+ * horizontal runs per tile row, then runs spanning the same columns on consecutive
+ * rows are joined vertically. More than MaxRects results collapse to one bounding box.
+ */
+inline void CoalesceDirtyTiles(const FTileGrid& Grid, const uint8_t* DirtyFlags, size_t MaxRects, std::vector<FIntRect>& Out)
+{
+    Out.clear();
+    struct FOpenRect
+    {
+        int32_t FirstColumn;
+        int32_t EndColumn;
+        size_t OutIndex;
+    };
+    std::vector<FOpenRect> Open;
+    std::vector<FOpenRect> NextOpen;
+
+    for (int32_t Row = 0; Row < Grid.Rows; ++Row)
+    {
+        NextOpen.clear();
+        const uint8_t* RowFlags = DirtyFlags + static_cast<size_t>(Row) * Grid.Columns;
+        int32_t Column = 0;
+        while (Column < Grid.Columns)
+        {
+            if (!RowFlags[Column]) { ++Column; continue; }
+            int32_t FirstColumn = Column;
+            while (Column < Grid.Columns && RowFlags[Column]) ++Column;
+
+            FIntRect RowTop = Grid.GetTile(Row * Grid.Columns + FirstColumn);
+            FIntRect RowEnd = Grid.GetTile(Row * Grid.Columns + Column - 1);
+
+            size_t OutIndex = Out.size();
+            for (const auto& Candidate : Open)
+            {
+                if (Candidate.FirstColumn == FirstColumn && Candidate.EndColumn == Column)
+                {
+                    OutIndex = Candidate.OutIndex;
+                    Out[OutIndex].Bottom = RowEnd.Bottom;
+                    break;
+                }
+            }
+            if (OutIndex == Out.size()) Out.push_back({ RowTop.Left, RowTop.Top, RowEnd.Right, RowEnd.Bottom });
+            NextOpen.push_back({ FirstColumn, Column, OutIndex });
+        }
+        Open.swap(NextOpen);
+    }
+
+    if (Out.size() > MaxRects)
+    {
+        FIntRect Bounds = Out[0];
+        for (const auto& Rect : Out)
+        {
+            if (Rect.Left < Bounds.Left) Bounds.Left = Rect.Left;
+            if (Rect.Top < Bounds.Top) Bounds.Top = Rect.Top;
+            if (Rect.Right > Bounds.Right) Bounds.Right = Rect.Right;
+            if (Rect.Bottom > Bounds.Bottom) Bounds.Bottom = Rect.Bottom;
+        }
+        Out.assign(1, Bounds);
+    }
+}
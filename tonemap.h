@@ -0,0 +1,462 @@
+// ToneMap - P010 (10-bit HDR10) to 8-bit BGRA conversion for the software presenter.
+// HDR10 frames are BT.2020 colour with the PQ (SMPTE ST 2084) transfer curve. Each
+// pixel is taken to nonlinear R'G'B' with the BT.2020 matrix, every channel goes
+// through one table that holds the PQ curve and the BT.2390 roll-off from the
+// mastering peak down to SDR white, the linear result is moved to BT.709 primaries,
+// and a second table applies the sRGB curve. Both tables are built once per
+// setting, so the per-pixel work is two integer matrices and six lookups.
+// Kernels: a scalar reference, SSE4.1 (4 pixels a step) and AVX2 (8 pixels a step,
+// lookups by gather), chosen at run time by CPU; all three give identical bytes.
+// ToneMapP010PixelReference() is the floating-point model the tables approximate.
+// Portable C++20: no platform headers (x86 SIMD intrinsics with GCC and Clang).
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TONEMAP_X86 1
+#define TONEMAP_TARGET(Isa) __attribute__((target(Isa)))
+#else
+#define TONEMAP_X86 0
+#endif
+
+struct FToneMapSettings
+{
+    double SourcePeakNits = 1000.0;     // Mastering peak; brighter codes clip to it
+    double TargetPeakNits = 203.0;      // Luminance shown as SDR white (BT.2408 reference white)
+};
+
+/** Bits of the nonlinear R'G'B' code that indexes the curve table. */
+constexpr int32_t ToneMapCodeBits = 12;
+constexpr int32_t ToneMapCodeMax = (1 << ToneMapCodeBits) - 1;
+
+/** Linear light is 16-bit (65535 = SDR white); the sRGB table drops this many low bits. */
+constexpr int32_t ToneMapLinearMax = 65535;
+constexpr int32_t ToneMapLinearShift = 2;
+constexpr int32_t ToneMapSrgbEntries = (ToneMapLinearMax >> ToneMapLinearShift) + 1;
+
+/** BT.2020 limited-range 10-bit Y'CbCr to R'G'B' codes, 10-bit fixed point (4095/876 and 4095/896 folded in). */
+constexpr int32_t ToneMapLumaScale = 4787;
+constexpr int32_t ToneMapRedFromV = 6901;
+constexpr int32_t ToneMapGreenFromU = 770;
+constexpr int32_t ToneMapGreenFromV = 2674;
+constexpr int32_t ToneMapBlueFromU = 8805;
+
+/** Linear BT.2020 to BT.709 primaries, 12-bit fixed point; each row sums to 4096 so white stays white. */
+constexpr int32_t ToneMapGamut[3][3] =
+{
+    { 6801, -2407, -298 },
+    { -510, 4640, -34 },
+    { -75, -412, 4583 },
+};
+
+/** SMPTE ST 2084 EOTF: nonlinear [0,1] to nits. */
+inline double PqToNits(double Code)
+{
+    const double M1 = 2610.0 / 16384.0;
+    const double M2 = 2523.0 / 4096.0 * 128.0;
+    const double C1 = 3424.0 / 4096.0;
+    const double C2 = 2413.0 / 4096.0 * 32.0;
+    const double C3 = 2392.0 / 4096.0 * 32.0;
+    double Power = std::pow(Code < 0.0 ? 0.0 : Code, 1.0 / M2);
+    double Numerator = Power - C1 > 0.0 ? Power - C1 : 0.0;
+    return 10000.0 * std::pow(Numerator / (C2 - C3 * Power), 1.0 / M1);
+}
+
+/** SMPTE ST 2084 inverse EOTF: nits to nonlinear [0,1]. */
+inline double NitsToPq(double Nits)
+{
+    const double M1 = 2610.0 / 16384.0;
+    const double M2 = 2523.0 / 4096.0 * 128.0;
+    const double C1 = 3424.0 / 4096.0;
+    const double C2 = 2413.0 / 4096.0 * 32.0;
+    const double C3 = 2392.0 / 4096.0 * 32.0;
+    double Power = std::pow((Nits < 0.0 ? 0.0 : Nits) / 10000.0, M1);
+    return std::pow((C1 + C2 * Power) / (1.0 + C3 * Power), M2);
+}
+
+/**
+ * BT.2390 EETF on a PQ code: codes up to the knee pass unchanged, the rest roll off
+ * along a Hermite spline so the source peak lands exactly on the target peak. Returns nits.
+ */
+inline double ToneMapNits(double Code, const FToneMapSettings& Settings)
+{
+    double SourcePeak = NitsToPq(Settings.SourcePeakNits);
+    double TargetPeak = NitsToPq(Settings.TargetPeakNits);
+    if (TargetPeak >= SourcePeak) return PqToNits(Code < SourcePeak ? Code : SourcePeak);
+
+    double Normalized = Code / SourcePeak;
+    Normalized = Normalized > 1.0 ? 1.0 : Normalized;
+    double MaxLuminance = TargetPeak / SourcePeak;
+    double Knee = 1.5 * MaxLuminance - 0.5;
+    Knee = Knee < 0.0 ? 0.0 : Knee;
+    if (Normalized > Knee)
+    {
+        double T = (Normalized - Knee) / (1.0 - Knee);
+        double T2 = T * T;
+        double T3 = T2 * T;
+        Normalized = (2.0 * T3 - 3.0 * T2 + 1.0) * Knee + (T3 - 2.0 * T2 + T) * (1.0 - Knee)
+            + (-2.0 * T3 + 3.0 * T2) * MaxLuminance;
+    }
+    return PqToNits(Normalized * SourcePeak);
+}
+
+/** sRGB transfer curve: linear [0,1] to nonlinear [0,1]. */
+inline double EncodeSrgb(double Linear)
+{
+    Linear = Linear < 0.0 ? 0.0 : (Linear > 1.0 ? 1.0 : Linear);
+    return Linear <= 0.0031308 ? 12.92 * Linear : 1.055 * std::pow(Linear, 1.0 / 2.4) - 0.055;
+}
+
+/**
+ * Floating-point model of the whole conversion for one pixel (10-bit samples), the
+ * accuracy reference for the table-driven kernels.
+ */
+inline uint32_t ToneMapP010PixelReference(int32_t Y, int32_t U, int32_t V, const FToneMapSettings& Settings)
+{
+    double Luma = (Y - 64) / 876.0;
+    double Cb = (U - 512) / 896.0;
+    double Cr = (V - 512) / 896.0;
+    double Nonlinear[3] =
+    {
+        Luma + 1.4746 * Cr,
+        Luma - 0.16455 * Cb - 0.57135 * Cr,
+        Luma + 1.8814 * Cb,
+    };
+    double Linear[3];
+    for (int32_t Channel = 0; Channel < 3; ++Channel)
+    {
+        double Code = Nonlinear[Channel] < 0.0 ? 0.0 : (Nonlinear[Channel] > 1.0 ? 1.0 : Nonlinear[Channel]);
+        Linear[Channel] = ToneMapNits(Code, Settings) / Settings.TargetPeakNits;
+    }
+    const double Gamut[3][3] =
+    {
+        { 1.6605, -0.5876, -0.0728 },
+        { -0.1246, 1.1329, -0.0083 },
+        { -0.0182, -0.1006, 1.1187 },
+    };
+    uint32_t Bgra = 0xFF000000u;
+    for (int32_t Channel = 0; Channel < 3; ++Channel)
+    {
+        double Mixed = Gamut[Channel][0] * Linear[0] + Gamut[Channel][1] * Linear[1] + Gamut[Channel][2] * Linear[2];
+        uint32_t Byte = static_cast<uint32_t>(EncodeSrgb(Mixed) * 255.0 + 0.5);
+        Bgra |= Byte << (16 - 8 * Channel);
+    }
+    return Bgra;
+}
+
+/** Both lookup tables; Build() once per setting (a few milliseconds), then shared read-only by every thread. */
+class FToneMapTables
+{
+public:
+    void Build(const FToneMapSettings& InSettings)
+    {
+        Settings = InSettings;
+        Curve.resize(ToneMapCodeMax + 1);
+        for (int32_t Code = 0; Code <= ToneMapCodeMax; ++Code)
+        {
+            double Linear = ToneMapNits(static_cast<double>(Code) / ToneMapCodeMax, Settings) / Settings.TargetPeakNits;
+            Linear = Linear > 1.0 ? 1.0 : Linear;
+            Curve[Code] = static_cast<int32_t>(Linear * ToneMapLinearMax + 0.5);
+        }
+        // Three bytes of padding: the AVX2 kernel gathers four bytes per entry.
+        Srgb.assign(ToneMapSrgbEntries + 3, 0);
+        for (int32_t Index = 0; Index < ToneMapSrgbEntries; ++Index)
+        {
+            // Each entry stands for the middle of the linear values that share it.
+            double Linear = ((static_cast<double>(Index) + 0.5) * (1 << ToneMapLinearShift)) / ToneMapLinearMax;
+            Srgb[Index] = static_cast<uint8_t>(EncodeSrgb(Index ? Linear : 0.0) * 255.0 + 0.5);
+        }
+        bBuilt = true;
+    }
+
+    bool IsBuilt() const { return bBuilt; }
+    const FToneMapSettings& GetSettings() const { return Settings; }
+
+    std::vector<int32_t> Curve;     // R'G'B' code -> linear light, tone mapped, 65535 = SDR white
+    std::vector<uint8_t> Srgb;      // Linear light >> ToneMapLinearShift -> sRGB byte
+
+private:
+    FToneMapSettings Settings;
+    bool bBuilt = false;
+};
+
+inline int32_t ClampToneMap(int32_t Value, int32_t Max)
+{
+    return Value < 0 ? 0 : (Value > Max ? Max : Value);
+}
+
+/** One pixel from 10-bit samples; the scalar reference every SIMD kernel must match exactly. */
+inline uint32_t ToneMapP010Pixel(const FToneMapTables& Tables, int32_t Y, int32_t U, int32_t V)
+{
+    int32_t LumaTerm = (Y - 64) * ToneMapLumaScale + 512;
+    int32_t D = U - 512;
+    int32_t E = V - 512;
+    int32_t Linear[3] =
+    {
+        Tables.Curve[ClampToneMap((LumaTerm + ToneMapRedFromV * E) >> 10, ToneMapCodeMax)],
+        Tables.Curve[ClampToneMap((LumaTerm - ToneMapGreenFromU * D - ToneMapGreenFromV * E) >> 10, ToneMapCodeMax)],
+        Tables.Curve[ClampToneMap((LumaTerm + ToneMapBlueFromU * D) >> 10, ToneMapCodeMax)],
+    };
+    uint32_t Bgra = 0xFF000000u;
+    for (int32_t Channel = 0; Channel < 3; ++Channel)
+    {
+        const int32_t* Row = ToneMapGamut[Channel];
+        int32_t Mixed = (Row[0] * Linear[0] + Row[1] * Linear[1] + Row[2] * Linear[2] + 2048) >> 12;
+        Bgra |= static_cast<uint32_t>(Tables.Srgb[ClampToneMap(Mixed, ToneMapLinearMax) >> ToneMapLinearShift])
+            << (16 - 8 * Channel);
+    }
+    return Bgra;
+}
+
+/** Scalar reference of ConvertP010ToBGRARow; also the tail of the SIMD kernels. X0 must be even. */
+inline void ConvertP010ToBGRARowScalar
+(
+    const FToneMapTables& Tables, const uint16_t* Luma, const uint16_t* Chroma, uint32_t* Out, int32_t X0, int32_t Width
+)
+{
+    for (int32_t X = X0; X < Width; ++X)
+    {
+        int32_t Pair = X & ~1;
+        Out[X] = ToneMapP010Pixel(Tables, Luma[X] >> 6, Chroma[Pair] >> 6, Chroma[Pair + 1] >> 6);
+    }
+}
+
+#if TONEMAP_X86
+/** Four pixels a step; SSE4.1 for 32-bit multiplies and clamps. Lookups stay scalar (no gather). */
+TONEMAP_TARGET("sse4.1")
+inline void ConvertP010ToBGRARowSse41
+(
+    const FToneMapTables& Tables, const uint16_t* Luma, const uint16_t* Chroma, uint32_t* Out, int32_t Width
+)
+{
+    const __m128i LumaOffset = _mm_set1_epi32(64);
+    const __m128i ChromaOffset = _mm_set1_epi32(512);
+    const __m128i LumaScale = _mm_set1_epi32(ToneMapLumaScale);
+    const __m128i Round = _mm_set1_epi32(512);
+    const __m128i RedFromV = _mm_set1_epi32(ToneMapRedFromV);
+    const __m128i GreenFromU = _mm_set1_epi32(ToneMapGreenFromU);
+    const __m128i GreenFromV = _mm_set1_epi32(ToneMapGreenFromV);
+    const __m128i BlueFromU = _mm_set1_epi32(ToneMapBlueFromU);
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i CodeMax = _mm_set1_epi32(ToneMapCodeMax);
+    const __m128i LinearMax = _mm_set1_epi32(ToneMapLinearMax);
+    const __m128i GamutRound = _mm_set1_epi32(2048);
+    const int32_t* Curve = Tables.Curve.data();
+    const uint8_t* Srgb = Tables.Srgb.data();
+
+    alignas(16) int32_t Lanes[3][4];
+    int32_t X = 0;
+    for (; X + 4 <= Width; X += 4)
+    {
+        __m128i Y = _mm_srli_epi32(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Luma + X))), 6);
+        __m128i UV = _mm_srli_epi32(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Chroma + X))), 6);
+        UV = _mm_sub_epi32(UV, ChromaOffset);
+        __m128i D = _mm_shuffle_epi32(UV, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128i E = _mm_shuffle_epi32(UV, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128i LumaTerm = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(Y, LumaOffset), LumaScale), Round);
+
+        __m128i Red = _mm_srai_epi32(_mm_add_epi32(LumaTerm, _mm_mullo_epi32(RedFromV, E)), 10);
+        __m128i Green = _mm_srai_epi32
+        (
+            _mm_sub_epi32(_mm_sub_epi32(LumaTerm, _mm_mullo_epi32(GreenFromU, D)), _mm_mullo_epi32(GreenFromV, E)), 10
+        );
+        __m128i Blue = _mm_srai_epi32(_mm_add_epi32(LumaTerm, _mm_mullo_epi32(BlueFromU, D)), 10);
+        _mm_store_si128(reinterpret_cast<__m128i*>(Lanes[0]), _mm_min_epi32(_mm_max_epi32(Red, Zero), CodeMax));
+        _mm_store_si128(reinterpret_cast<__m128i*>(Lanes[1]), _mm_min_epi32(_mm_max_epi32(Green, Zero), CodeMax));
+        _mm_store_si128(reinterpret_cast<__m128i*>(Lanes[2]), _mm_min_epi32(_mm_max_epi32(Blue, Zero), CodeMax));
+
+        __m128i Linear[3];
+        for (int32_t Channel = 0; Channel < 3; ++Channel)
+        {
+            const int32_t* Codes = Lanes[Channel];
+            Linear[Channel] = _mm_setr_epi32(Curve[Codes[0]], Curve[Codes[1]], Curve[Codes[2]], Curve[Codes[3]]);
+        }
+        for (int32_t Channel = 0; Channel < 3; ++Channel)
+        {
+            const int32_t* Row = ToneMapGamut[Channel];
+            __m128i Mixed = _mm_add_epi32
+            (
+                _mm_add_epi32(_mm_mullo_epi32(Linear[0], _mm_set1_epi32(Row[0])), _mm_mullo_epi32(Linear[1], _mm_set1_epi32(Row[1]))),
+                _mm_add_epi32(_mm_mullo_epi32(Linear[2], _mm_set1_epi32(Row[2])), GamutRound)
+            );
+            Mixed = _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(Mixed, 12), Zero), LinearMax);
+            _mm_store_si128(reinterpret_cast<__m128i*>(Lanes[Channel]), _mm_srli_epi32(Mixed, ToneMapLinearShift));
+        }
+        for (int32_t Lane = 0; Lane < 4; ++Lane)
+        {
+            Out[X + Lane] = 0xFF000000u
+                | (static_cast<uint32_t>(Srgb[Lanes[0][Lane]]) << 16)
+                | (static_cast<uint32_t>(Srgb[Lanes[1][Lane]]) << 8)
+                | static_cast<uint32_t>(Srgb[Lanes[2][Lane]]);
+        }
+    }
+    ConvertP010ToBGRARowScalar(Tables, Luma, Chroma, Out, X, Width);
+}
+
+/** Eight pixels a step; both table lookups are gathers and the pixels are packed in registers. */
+TONEMAP_TARGET("avx2")
+inline void ConvertP010ToBGRARowAvx2
+(
+    const FToneMapTables& Tables, const uint16_t* Luma, const uint16_t* Chroma, uint32_t* Out, int32_t Width
+)
+{
+    const __m256i LumaOffset = _mm256_set1_epi32(64);
+    const __m256i ChromaOffset = _mm256_set1_epi32(512);
+    const __m256i LumaScale = _mm256_set1_epi32(ToneMapLumaScale);
+    const __m256i Round = _mm256_set1_epi32(512);
+    const __m256i RedFromV = _mm256_set1_epi32(ToneMapRedFromV);
+    const __m256i GreenFromU = _mm256_set1_epi32(ToneMapGreenFromU);
+    const __m256i GreenFromV = _mm256_set1_epi32(ToneMapGreenFromV);
+    const __m256i BlueFromU = _mm256_set1_epi32(ToneMapBlueFromU);
+    const __m256i Zero = _mm256_setzero_si256();
+    const __m256i CodeMax = _mm256_set1_epi32(ToneMapCodeMax);
+    const __m256i LinearMax = _mm256_set1_epi32(ToneMapLinearMax);
+    const __m256i GamutRound = _mm256_set1_epi32(2048);
+    const __m256i ByteMask = _mm256_set1_epi32(0xFF);
+    const __m256i Alpha = _mm256_set1_epi32(static_cast<int32_t>(0xFF000000u));
+    const int* Curve = Tables.Curve.data();
+    const int* Srgb = reinterpret_cast<const int*>(Tables.Srgb.data());
+
+    int32_t X = 0;
+    for (; X + 8 <= Width; X += 8)
+    {
+        __m256i Y = _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Luma + X))), 6);
+        __m256i UV = _mm256_srli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Chroma + X))), 6);
+        UV = _mm256_sub_epi32(UV, ChromaOffset);
+        __m256i D = _mm256_shuffle_epi32(UV, _MM_SHUFFLE(2, 2, 0, 0));
+        __m256i E = _mm256_shuffle_epi32(UV, _MM_SHUFFLE(3, 3, 1, 1));
+        __m256i LumaTerm = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(Y, LumaOffset), LumaScale), Round);
+
+        __m256i Codes[3] =
+        {
+            _mm256_srai_epi32(_mm256_add_epi32(LumaTerm, _mm256_mullo_epi32(RedFromV, E)), 10),
+            _mm256_srai_epi32
+            (
+                _mm256_sub_epi32(_mm256_sub_epi32(LumaTerm, _mm256_mullo_epi32(GreenFromU, D)), _mm256_mullo_epi32(GreenFromV, E)),
+                10
+            ),
+            _mm256_srai_epi32(_mm256_add_epi32(LumaTerm, _mm256_mullo_epi32(BlueFromU, D)), 10),
+        };
+        __m256i Linear[3];
+        for (int32_t Channel = 0; Channel < 3; ++Channel)
+        {
+            __m256i Code = _mm256_min_epi32(_mm256_max_epi32(Codes[Channel], Zero), CodeMax);
+            Linear[Channel] = _mm256_i32gather_epi32(Curve, Code, 4);
+        }
+        __m256i Bgra = Alpha;
+        for (int32_t Channel = 0; Channel < 3; ++Channel)
+        {
+            const int32_t* Row = ToneMapGamut[Channel];
+            __m256i Mixed = _mm256_add_epi32
+            (
+                _mm256_add_epi32
+                (
+                    _mm256_mullo_epi32(Linear[0], _mm256_set1_epi32(Row[0])), _mm256_mullo_epi32(Linear[1], _mm256_set1_epi32(Row[1]))
+                ),
+                _mm256_add_epi32(_mm256_mullo_epi32(Linear[2], _mm256_set1_epi32(Row[2])), GamutRound)
+            );
+            Mixed = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(Mixed, 12), Zero), LinearMax);
+            __m256i Byte = _mm256_and_si256
+            (
+                _mm256_i32gather_epi32(Srgb, _mm256_srli_epi32(Mixed, ToneMapLinearShift), 1), ByteMask
+            );
+            Bgra = _mm256_or_si256(Bgra, _mm256_slli_epi32(Byte, 16 - 8 * Channel));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + X), Bgra);
+    }
+    ConvertP010ToBGRARowScalar(Tables, Luma, Chroma, Out, X, Width);
+}
+#endif
+
+enum class EToneMapKernel : uint8_t
+{
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+inline const char* GetToneMapKernelName(EToneMapKernel Kernel)
+{
+    switch (Kernel)
+    {
+    case EToneMapKernel::Sse41: return "SSE4.1";
+    case EToneMapKernel::Avx2:  return "AVX2";
+    default:                    return "scalar";
+    }
+}
+
+inline bool IsToneMapKernelSupported(EToneMapKernel Kernel)
+{
+#if TONEMAP_X86
+    __builtin_cpu_init();
+    if (Kernel == EToneMapKernel::Avx2) return __builtin_cpu_supports("avx2");
+    if (Kernel == EToneMapKernel::Sse41) return __builtin_cpu_supports("sse4.1");
+#endif
+    return Kernel == EToneMapKernel::Scalar;
+}
+
+/** The widest kernel this CPU runs; probed once. */
+inline EToneMapKernel GetBestToneMapKernel()
+{
+    static const EToneMapKernel Best = IsToneMapKernelSupported(EToneMapKernel::Avx2) ? EToneMapKernel::Avx2
+                                     : IsToneMapKernelSupported(EToneMapKernel::Sse41) ? EToneMapKernel::Sse41
+                                     : EToneMapKernel::Scalar;
+    return Best;
+}
+
+/** Tone maps one row of Width pixels; the kernel must be supported (IsToneMapKernelSupported). */
+inline void ConvertP010ToBGRARow
+(
+    const FToneMapTables& Tables, const uint16_t* Luma, const uint16_t* Chroma, uint32_t* Out, int32_t Width,
+    EToneMapKernel Kernel
+)
+{
+#if TONEMAP_X86
+    if (Kernel == EToneMapKernel::Avx2) return ConvertP010ToBGRARowAvx2(Tables, Luma, Chroma, Out, Width);
+    if (Kernel == EToneMapKernel::Sse41) return ConvertP010ToBGRARowSse41(Tables, Luma, Chroma, Out, Width);
+#endif
+    (void)Kernel;
+    ConvertP010ToBGRARowScalar(Tables, Luma, Chroma, Out, 0, Width);
+}
+
+/** Converts P010 rows [RowBegin, RowEnd) into a BGRA view of the same size. */
+inline void ConvertP010ToBGRA
+(
+    const FToneMapTables& Tables, const FFrameView& Source, const FFrameView& Dest, int32_t RowBegin, int32_t RowEnd,
+    EToneMapKernel Kernel = GetBestToneMapKernel()
+)
+{
+    for (int32_t Y = RowBegin; Y < RowEnd; ++Y)
+    {
+        ConvertP010ToBGRARow
+        (
+            Tables, reinterpret_cast<const uint16_t*>(Source.Row(0, Y)), reinterpret_cast<const uint16_t*>(Source.Row(1, Y / 2)),
+            reinterpret_cast<uint32_t*>(Dest.Row(0, Y)), Source.Width, Kernel
+        );
+    }
+}
+
+/** Converts rows [RowBegin, RowEnd) of a half-size BGRA view: one luma sample per 2x2 block, chroma as stored. */
+inline void ConvertP010ToBGRAHalf
+(
+    const FToneMapTables& Tables, const FFrameView& Source, const FFrameView& Dest, int32_t RowBegin, int32_t RowEnd
+)
+{
+    for (int32_t Y = RowBegin; Y < RowEnd; ++Y)
+    {
+        const uint16_t* Luma = reinterpret_cast<const uint16_t*>(Source.Row(0, Y * 2));
+        const uint16_t* Chroma = reinterpret_cast<const uint16_t*>(Source.Row(1, Y));
+        uint32_t* Out = reinterpret_cast<uint32_t*>(Dest.Row(0, Y));
+        for (int32_t X = 0; X < Dest.Width; ++X)
+        {
+            Out[X] = ToneMapP010Pixel(Tables, Luma[X * 2] >> 6, Chroma[X * 2] >> 6, Chroma[X * 2 + 1] >> 6);
+        }
+    }
+}
@@ -0,0 +1,276 @@
+// tonemap_bench - Checks the P010 tone-mapping kernels and times them at 4K.
+// First the tables: the curve must rise monotonically from black to SDR white and
+// clip above the mastering peak, and the sRGB table must span 0-255. The scalar
+// kernel is then held against the floating-point model over a sweep of the whole
+// 10-bit Y'CbCr cube, and every SIMD kernel this CPU runs must produce the same
+// bytes as the scalar one for random frames of awkward widths (tails, odd sizes,
+// out-of-range samples). Finally each kernel converts a synthetic HDR frame on one
+// thread, next to the 8-bit NV12 converter for scale:
+//   g++ -std=c++20 -O2 -pthread tonemap_bench.cpp -o tonemap_bench
+//   tonemap_bench [--size WxH] [--frames N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "compositor.h"
+#include "tonemap.h"
+
+namespace
+{
+    struct FBenchOptions
+    {
+        int32_t Width = 3840;
+        int32_t Height = 2160;
+        int32_t Frames = 20;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--size")
+            {
+                if (std::sscanf(Value, "%dx%d", &Options.Width, &Options.Height) != 2) return false;
+                if (Options.Width < 2 || Options.Height < 2) return false;
+            }
+            else if (Name == "--frames") Options.Frames = std::atoi(Value);
+            else return false;
+        }
+        return Options.Frames > 0;
+    }
+
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    const EToneMapKernel Kernels[] = { EToneMapKernel::Scalar, EToneMapKernel::Sse41, EToneMapKernel::Avx2 };
+
+    uint32_t NextRandom(uint32_t& State)
+    {
+        State ^= State << 13;
+        State ^= State >> 17;
+        State ^= State << 5;
+        return State;
+    }
+
+    /** MSB-aligned 10-bit samples, as decoders write P010. */
+    uint16_t ToP010(int32_t Sample) { return static_cast<uint16_t>(Sample << 6); }
+
+    bool CheckTables(const FToneMapTables& Tables)
+    {
+        bool bPass = Check(Tables.Curve[0] == 0, "curve: black stays black");
+        bool bMonotonic = true;
+        for (size_t Index = 1; Index < Tables.Curve.size(); ++Index) bMonotonic &= Tables.Curve[Index] >= Tables.Curve[Index - 1];
+        bPass &= Check(bMonotonic, "curve: monotonic");
+
+        const FToneMapSettings& Settings = Tables.GetSettings();
+        int32_t SourcePeakCode = static_cast<int32_t>(NitsToPq(Settings.SourcePeakNits) * ToneMapCodeMax + 1.0);
+        bPass &= Check(Tables.Curve[SourcePeakCode] == ToneMapLinearMax, "curve: mastering peak reaches SDR white");
+        bPass &= Check(Tables.Curve[ToneMapCodeMax] == ToneMapLinearMax, "curve: brighter codes clip");
+
+        // Below the knee the curve is the plain PQ curve: 50 nits shows at 50/203 of white.
+        int32_t FiftyNits = static_cast<int32_t>(NitsToPq(50.0) * ToneMapCodeMax + 0.5);
+        double Expected = PqToNits(static_cast<double>(FiftyNits) / ToneMapCodeMax) / Settings.TargetPeakNits;
+        bPass &= Check(std::abs(Tables.Curve[FiftyNits] / static_cast<double>(ToneMapLinearMax) - Expected) < 1e-4, "curve: identity below the knee");
+
+        bool bSrgbMonotonic = true;
+        for (int32_t Index = 1; Index < ToneMapSrgbEntries; ++Index) bSrgbMonotonic &= Tables.Srgb[Index] >= Tables.Srgb[Index - 1];
+        bPass &= Check(bSrgbMonotonic, "sRGB table: monotonic");
+        bPass &= Check(Tables.Srgb[0] == 0 && Tables.Srgb[ToneMapSrgbEntries - 1] == 255, "sRGB table: spans 0-255");
+        return bPass;
+    }
+
+    int32_t ChannelError(uint32_t A, uint32_t B)
+    {
+        int32_t Worst = 0;
+        for (int32_t Shift = 0; Shift < 32; Shift += 8)
+        {
+            int32_t Difference = std::abs(static_cast<int32_t>((A >> Shift) & 0xFF) - static_cast<int32_t>((B >> Shift) & 0xFF));
+            Worst = Difference > Worst ? Difference : Worst;
+        }
+        return Worst;
+    }
+
+    /** The table-driven scalar kernel against the floating-point model over the limited-range cube. */
+    bool CheckAccuracy(const FToneMapTables& Tables)
+    {
+        int32_t WorstError = 0;
+        int64_t TotalError = 0;
+        int64_t Samples = 0;
+        int32_t Histogram[4] = {};
+        for (int32_t Y = 64; Y <= 940; Y += 4)
+        {
+            for (int32_t U = 64; U <= 960; U += 16)
+            {
+                for (int32_t V = 64; V <= 960; V += 16)
+                {
+                    int32_t Error = ChannelError(ToneMapP010Pixel(Tables, Y, U, V), ToneMapP010PixelReference(Y, U, V, Tables.GetSettings()));
+                    WorstError = Error > WorstError ? Error : WorstError;
+                    TotalError += Error;
+                    ++Histogram[Error < 3 ? Error : 3];
+                    ++Samples;
+                }
+            }
+        }
+        std::printf
+        (
+            "accuracy vs floating point: %lld samples, max error %d, mean %.3f (exact %.1f%%, off by 1 %.1f%%, 2 %.1f%%, 3+ %.2f%%)\n",
+            static_cast<long long>(Samples), WorstError, static_cast<double>(TotalError) / Samples,
+            100.0 * Histogram[0] / Samples, 100.0 * Histogram[1] / Samples, 100.0 * Histogram[2] / Samples,
+            100.0 * Histogram[3] / Samples
+        );
+        bool bPass = Check(WorstError <= 3, "scalar kernel within 3 levels of the floating-point model");
+        bPass &= Check(Histogram[3] * 1000 <= Samples, "at most 0.1% of samples off by 3");
+
+        bool bNeutral = true;
+        for (int32_t Y = 64; Y <= 940; ++Y)
+        {
+            uint32_t Gray = ToneMapP010Pixel(Tables, Y, 512, 512);
+            bNeutral &= ((Gray >> 16) & 0xFF) == ((Gray >> 8) & 0xFF) && ((Gray >> 8) & 0xFF) == (Gray & 0xFF);
+        }
+        bPass &= Check(bNeutral, "neutral grays stay neutral");
+        bPass &= Check(ToneMapP010Pixel(Tables, 64, 512, 512) == 0xFF000000u, "video black is black");
+        bPass &= Check(ToneMapP010Pixel(Tables, 940, 512, 512) == 0xFFFFFFFFu, "peak white is white");
+        return bPass;
+    }
+
+    /** Every supported SIMD kernel against the scalar one, byte for byte, on random rows of awkward widths. */
+    bool CheckKernelsMatch(const FToneMapTables& Tables)
+    {
+        bool bPass = true;
+        uint32_t State = 0x9E3779B9u;
+        const int32_t Widths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 64, 127, 1920, 3841 };
+        for (int32_t Width : Widths)
+        {
+            std::vector<uint16_t> Luma(Width);
+            std::vector<uint16_t> Chroma((Width + 1) & ~1);
+            for (int32_t Round = 0; Round < 64; ++Round)
+            {
+                // Full 10-bit range, so codes outside the limited range exercise the clamps.
+                for (auto& Sample : Luma) Sample = ToP010(static_cast<int32_t>(NextRandom(State) & 1023));
+                for (auto& Sample : Chroma) Sample = ToP010(static_cast<int32_t>(NextRandom(State) & 1023));
+                std::vector<uint32_t> Expected(Width);
+                ConvertP010ToBGRARow(Tables, Luma.data(), Chroma.data(), Expected.data(), Width, EToneMapKernel::Scalar);
+                for (EToneMapKernel Kernel : Kernels)
+                {
+                    if (Kernel == EToneMapKernel::Scalar || !IsToneMapKernelSupported(Kernel)) continue;
+                    std::vector<uint32_t> Actual(Width);
+                    ConvertP010ToBGRARow(Tables, Luma.data(), Chroma.data(), Actual.data(), Width, Kernel);
+                    if (Actual == Expected) continue;
+                    std::printf("FAIL: %s differs from scalar at width %d\n", GetToneMapKernelName(Kernel), Width);
+                    bPass = false;
+                    break;
+                }
+            }
+        }
+        return bPass;
+    }
+
+    /** A dim scene with a bright highlight band, so rows mix the knee and the roll-off. */
+    FFrame BuildHdrFrame(int32_t Width, int32_t Height)
+    {
+        FFrame Frame(Width, Height, EPixelFormat::P010);
+        const FFrameView& View = Frame.GetView();
+        for (int32_t Y = 0; Y < Height; ++Y)
+        {
+            uint16_t* Luma = reinterpret_cast<uint16_t*>(View.Row(0, Y));
+            for (int32_t X = 0; X < Width; ++X)
+            {
+                int32_t Sample = 64 + (X * 600 / Width) + ((Y / 64) % 4 == 0 ? 276 : 0);
+                Luma[X] = ToP010(Sample > 940 ? 940 : Sample);
+            }
+        }
+        for (int32_t Y = 0; Y < (Height + 1) / 2; ++Y)
+        {
+            uint16_t* Chroma = reinterpret_cast<uint16_t*>(View.Row(1, Y));
+            for (int32_t X = 0; X < Width; X += 2)
+            {
+                Chroma[X] = ToP010(512 + ((X * 7 + Y * 3) % 256) - 128);
+                Chroma[X + 1] = ToP010(512 + ((X * 5 + Y * 11) % 256) - 128);
+            }
+        }
+        return Frame;
+    }
+
+    double TimeFrames(int32_t Frames, const auto& Convert)
+    {
+        Convert();
+        auto Start = std::chrono::steady_clock::now();
+        for (int32_t Frame = 0; Frame < Frames; ++Frame) Convert();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / Frames;
+    }
+
+    void RunThroughput(const FToneMapTables& Tables, const FBenchOptions& Options)
+    {
+        FFrame Source = BuildHdrFrame(Options.Width, Options.Height);
+        FFrame Dest(Options.Width, Options.Height, EPixelFormat::BGRA8);
+        double Megapixels = static_cast<double>(Options.Width) * Options.Height / 1e6;
+        std::printf("throughput %dx%d, one thread, best kernel here: %s\n", Options.Width, Options.Height,
+            GetToneMapKernelName(GetBestToneMapKernel()));
+
+        double ScalarMs = 0.0;
+        for (EToneMapKernel Kernel : Kernels)
+        {
+            if (!IsToneMapKernelSupported(Kernel)) continue;
+            double Ms = TimeFrames(Options.Frames, [&]()
+            {
+                ConvertP010ToBGRA(Tables, Source.GetView(), Dest.GetView(), 0, Options.Height, Kernel);
+            });
+            if (Kernel == EToneMapKernel::Scalar) ScalarMs = Ms;
+            std::printf
+            (
+                "  P010 %-7s %8.2f ms/frame %8.1f Mpix/s %6.2fx scalar\n",
+                GetToneMapKernelName(Kernel), Ms, Megapixels / Ms * 1000.0, ScalarMs / Ms
+            );
+        }
+
+        FFrame Nv12(Options.Width, Options.Height, EPixelFormat::NV12);
+        const FFrameView& View = Nv12.GetView();
+        for (int32_t Y = 0; Y < Options.Height; ++Y) std::memset(View.Row(0, Y), 128, Options.Width);
+        for (int32_t Y = 0; Y < Options.Height / 2; ++Y) std::memset(View.Row(1, Y), 128, Options.Width);
+        double Nv12Ms = TimeFrames(Options.Frames, [&]()
+        {
+            ConvertNV12ToBGRA(View, Dest.GetView(), 0, Options.Height);
+        });
+        std::printf("  NV12 8-bit  %8.2f ms/frame %8.1f Mpix/s (reference)\n", Nv12Ms, Megapixels / Nv12Ms * 1000.0);
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: tonemap_bench [--size WxH] [--frames N]\n");
+        return 2;
+    }
+
+    FToneMapTables Tables;
+    auto BuildStart = std::chrono::steady_clock::now();
+    Tables.Build(FToneMapSettings{});
+    std::printf
+    (
+        "tables built in %.2f ms (1000 nits -> 203 nits white)\n",
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - BuildStart).count()
+    );
+
+    bool bPass = Check(CheckTables(Tables), "tables");
+    bPass &= Check(CheckAccuracy(Tables), "accuracy");
+    bPass &= Check(CheckKernelsMatch(Tables), "SIMD kernels match scalar");
+    RunThroughput(Tables, Options);
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+// Trace - Low-overhead hot-path event recorder for VideoWallpaper.
+// Events are fixed-size binary records written into a lock-free ring buffer;
+// spans are recorded as a single complete event when their scope closes. Each slot
+// carries a sequence number that is cleared while it is written and set once the
+// event is complete, so readers skip events that are torn or being overwritten.
+// The buffer is dumped as Chrome trace JSON, viewable in Perfetto (ui.perfetto.dev).
+// Portable C++20: no platform headers, builds on Windows and Linux alike.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/** Default ring capacity in events (must be a power of two). 64K 48-byte slots = 3 MiB. */
+constexpr size_t TraceDefaultCapacity = 1u << 16;
+
+enum class ETracePhase : uint8_t
+{
+    Complete,   // Span with start + duration ("X")
+    Instant,    // Point event ("i")
+    Counter     // Sampled value ("C")
+};
+
+/** One recorded event, as Snapshot() returns it. Name must point at a string with static storage duration. */
+struct FTraceEvent
+{
+    int64_t StartNs = 0;
+    int64_t DurationNs = 0;
+    const char* Name = nullptr;
+    int64_t Arg = 0;
+    uint32_t ThreadId = 0;
+    ETracePhase Phase = ETracePhase::Instant;
+};
+
+inline int64_t TraceNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+    (
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/** Small, stable per-thread id (hashing std::thread::id once per thread). */
+inline uint32_t TraceThreadId()
+{
+    thread_local const uint32_t ThreadId = static_cast<uint32_t>
+    (
+        std::hash<std::thread::id>{}(std::this_thread::get_id())
+    );
+    return ThreadId;
+}
+
+class FTraceRecorder
+{
+public:
+    explicit FTraceRecorder(size_t InCapacity = TraceDefaultCapacity)
+        : Slots(RoundUpPow2(InCapacity)), Mask(Slots.size() - 1) {}
+
+    FTraceRecorder(const FTraceRecorder&) = delete;
+    FTraceRecorder& operator=(const FTraceRecorder&) = delete;
+
+    void SetEnabled(bool bInEnabled) { bEnabled.store(bInEnabled, std::memory_order_seq_cst); }
+    bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+    size_t Capacity() const { return Slots.size(); }
+
+    /** Waits for Record() calls already past the enabled check; after SetEnabled(false) none start. */
+    void WaitForWriters() const
+    {
+        while (ActiveWriters.load(std::memory_order_seq_cst)) std::this_thread::yield();
+    }
+
+    /** Total events recorded since the last Clear(), including overwritten ones. */
+    uint64_t Recorded() const { return WriteIndex.load(std::memory_order_acquire); }
+
+    void Record(ETracePhase Phase, const char* Name, int64_t StartNs, int64_t DurationNs, int64_t Arg)
+    {
+        if (!IsEnabled()) return;
+        // Announced before the second look at bEnabled, so WaitForWriters() cannot miss this call.
+        ActiveWriters.fetch_add(1, std::memory_order_seq_cst);
+        if (bEnabled.load(std::memory_order_seq_cst))
+        {
+            uint64_t Index = WriteIndex.fetch_add(1, std::memory_order_relaxed);
+            FTraceSlot& Slot = Slots[Index & Mask];
+            Slot.Sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            Slot.StartNs.store(StartNs, std::memory_order_relaxed);
+            Slot.DurationNs.store(DurationNs, std::memory_order_relaxed);
+            Slot.Name.store(Name, std::memory_order_relaxed);
+            Slot.Arg.store(Arg, std::memory_order_relaxed);
+            Slot.ThreadId.store(TraceThreadId(), std::memory_order_relaxed);
+            Slot.Phase.store(Phase, std::memory_order_relaxed);
+            Slot.Sequence.store(Index + 1, std::memory_order_release);
+        }
+        ActiveWriters.fetch_sub(1, std::memory_order_release);
+    }
+
+    void Instant(const char* Name, int64_t Arg = 0)
+    {
+        if (!IsEnabled()) return;
+        Record(ETracePhase::Instant, Name, TraceNowNs(), 0, Arg);
+    }
+
+    void Counter(const char* Name, int64_t Value)
+    {
+        if (!IsEnabled()) return;
+        Record(ETracePhase::Counter, Name, TraceNowNs(), 0, Value);
+    }
+
+    /** Forgets every event. Call while disabled, after WaitForWriters(). */
+    void Clear()
+    {
+        for (FTraceSlot& Slot : Slots) Slot.Sequence.store(0, std::memory_order_relaxed);
+        WriteIndex.store(0, std::memory_order_release);
+    }
+
+    /**
+     * Copies the retained events (oldest first). Events still being written, or
+     * overwritten while they were copied, are left out; after SetEnabled(false) and
+     * WaitForWriters() the copy is exact.
+     */
+    std::vector<FTraceEvent> Snapshot() const
+    {
+        uint64_t End = Recorded();
+        uint64_t Count = End < Slots.size() ? End : Slots.size();
+        std::vector<FTraceEvent> Out;
+        Out.reserve(static_cast<size_t>(Count));
+        for (uint64_t Index = End - Count; Index < End; ++Index)
+        {
+            const FTraceSlot& Slot = Slots[Index & Mask];
+            if (Slot.Sequence.load(std::memory_order_acquire) != Index + 1) continue;
+            FTraceEvent Event;
+            Event.StartNs = Slot.StartNs.load(std::memory_order_relaxed);
+            Event.DurationNs = Slot.DurationNs.load(std::memory_order_relaxed);
+            Event.Name = Slot.Name.load(std::memory_order_relaxed);
+            Event.Arg = Slot.Arg.load(std::memory_order_relaxed);
+            Event.ThreadId = Slot.ThreadId.load(std::memory_order_relaxed);
+            Event.Phase = Slot.Phase.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Slot.Sequence.load(std::memory_order_relaxed) != Index + 1) continue;
+            Out.push_back(Event);
+        }
+        return Out;
+    }
+
+    /** Writes the retained events as Chrome trace JSON ("traceEvents" array form). */
+    void WriteChromeJson(std::ostream& Out) const
+    {
+        std::vector<FTraceEvent> Retained = Snapshot();
+        int64_t BaseNs = Retained.empty() ? 0 : Retained.front().StartNs;
+        for (const auto& Event : Retained)
+        {
+            if (Event.StartNs < BaseNs) BaseNs = Event.StartNs;
+        }
+
+        Out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool bFirst = true;
+        for (const auto& Event : Retained)
+        {
+            if (!Event.Name) continue;
+            Out << (bFirst ? "\n" : ",\n");
+            bFirst = false;
+
+            Out << "{\"name\":\"";
+            WriteEscaped(Out, Event.Name);
+            Out << "\",\"pid\":1,\"tid\":" << Event.ThreadId << ",\"ts\":";
+            WriteMicros(Out, Event.StartNs - BaseNs);
+
+            switch (Event.Phase)
+            {
+            case ETracePhase::Complete:
+                Out << ",\"ph\":\"X\",\"dur\":";
+                WriteMicros(Out, Event.DurationNs);
+                Out << ",\"args\":{\"arg\":" << Event.Arg << "}}";
+                break;
+            case ETracePhase::Counter:
+                Out << ",\"ph\":\"C\",\"args\":{\"value\":" << Event.Arg << "}}";
+                break;
+            case ETracePhase::Instant:
+            default:
+                Out << ",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"arg\":" << Event.Arg << "}}";
+                break;
+            }
+        }
+        Out << "\n]}\n";
+    }
+
+private:
+    /** Event storage; fields are atomics so readers racing a writer stay well-defined. */
+    struct FTraceSlot
+    {
+        std::atomic<uint64_t> Sequence{ 0 };    // Index + 1 once complete, 0 while written
+        std::atomic<int64_t> StartNs{ 0 };
+        std::atomic<int64_t> DurationNs{ 0 };
+        std::atomic<const char*> Name{ nullptr };
+        std::atomic<int64_t> Arg{ 0 };
+        std::atomic<uint32_t> ThreadId{ 0 };
+        std::atomic<ETracePhase> Phase{ ETracePhase::Instant };
+    };
+    // The memory figure at TraceDefaultCapacity assumes this size on 64-bit targets.
+    static_assert(sizeof(void*) != 8 || sizeof(FTraceSlot) == 48, "update the TraceDefaultCapacity comment");
+
+    static size_t RoundUpPow2(size_t Value)
+    {
+        size_t Result = 1;
+        while (Result < Value) Result <<= 1;
+        return Result;
+    }
+
+    static void WriteMicros(std::ostream& Out, int64_t Ns)
+    {
+        // Fixed 3-decimal microseconds without touching stream precision state.
+        if (Ns < 0) { Out << '-'; Ns = -Ns; }
+        int64_t Frac = Ns % 1000;
+        Out << (Ns / 1000) << '.' << static_cast<char>('0' + Frac / 100)
+            << static_cast<char>('0' + (Frac / 10) % 10) << static_cast<char>('0' + Frac % 10);
+    }
+
+    static void WriteEscaped(std::ostream& Out, const char* Text)
+    {
+        for (; *Text; ++Text)
+        {
+            char Ch = *Text;
+            if (Ch == '"' || Ch == '\\') Out << '\\' << Ch;
+            else if (static_cast<unsigned char>(Ch) < 0x20) Out << ' ';
+            else Out << Ch;
+        }
+    }
+
+    std::vector<FTraceSlot> Slots;
+    size_t Mask = 0;
+    std::atomic<uint64_t> WriteIndex{ 0 };
+    std::atomic<bool> bEnabled{ false };
+    std::atomic<uint32_t> ActiveWriters{ 0 };
+};
+
+/** RAII span: records one Complete event covering the enclosing scope. */
+class FTraceScope
+{
+public:
+    FTraceScope(FTraceRecorder& InRecorder, const char* InName, int64_t InArg = 0)
+        : Recorder(InRecorder), Name(InName), Arg(InArg),
+          StartNs(InRecorder.IsEnabled() ? TraceNowNs() : 0) {}
+
+    ~FTraceScope()
+    {
+        if (!StartNs || !Recorder.IsEnabled()) return;
+        Recorder.Record(ETracePhase::Complete, Name, StartNs, TraceNowNs() - StartNs, Arg);
+    }
+
+    void SetArg(int64_t InArg) { Arg = InArg; }
+
+    FTraceScope(const FTraceScope&) = delete;
+    FTraceScope& operator=(const FTraceScope&) = delete;
+
+private:
+    FTraceRecorder& Recorder;
+    const char* Name;
+    int64_t Arg;
+    int64_t StartNs;
+};
+
+/** Process-wide recorder used by the TRACE_* macros. Disabled until SetEnabled(true). */
+inline FTraceRecorder GTrace;
+
+#define TRACE_CONCAT_INNER(A, B) A##B
+#define TRACE_CONCAT(A, B) TRACE_CONCAT_INNER(A, B)
+#define TRACE_SCOPE(Name) FTraceScope TRACE_CONCAT(TraceScope_, __LINE__)(GTrace, Name)
+#define TRACE_SCOPE_ARG(Name, Arg) FTraceScope TRACE_CONCAT(TraceScope_, __LINE__)(GTrace, Name, Arg)
+#define TRACE_INSTANT(Name, Arg) GTrace.Instant(Name, Arg)
+#define TRACE_COUNTER(Name, Value) GTrace.Counter(Name, Value)
@@ -0,0 +1,205 @@
+// trace_bench - Cost per event of the hot-path tracer, and torn-event checks.
+// Times Instant, Counter and TRACE_SCOPE-style spans with the recorder on and off,
+// from one thread and from --threads threads at once, and prints nanoseconds per
+// event. Then writer threads fill the ring with events whose fields all derive from
+// one value while a reader snapshots it over and over: every event a snapshot
+// returns must be whole. Finally the recorder is disabled mid-write and dumped after
+// WaitForWriters(), which must give exactly the events recorded.
+//   g++ -std=c++20 -O2 -pthread trace_bench.cpp -o trace_bench
+//   trace_bench [--events N] [--threads N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    struct FBenchOptions
+    {
+        int64_t Events = 2000000;
+        int32_t Threads = 4;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--events") Options.Events = std::atoll(Value);
+            else if (Name == "--threads") Options.Threads = std::atoi(Value);
+            else return false;
+        }
+        return Options.Events > 0 && Options.Threads > 0;
+    }
+
+    const char* const EventName = "bench";
+
+    enum class EBenchKind
+    {
+        Instant,
+        Counter,
+        Scope
+    };
+
+    void RecordEvents(FTraceRecorder& Recorder, EBenchKind Kind, int64_t Events)
+    {
+        for (int64_t Index = 0; Index < Events; ++Index)
+        {
+            switch (Kind)
+            {
+            case EBenchKind::Instant: Recorder.Instant(EventName, Index); break;
+            case EBenchKind::Counter: Recorder.Counter(EventName, Index); break;
+            case EBenchKind::Scope: { FTraceScope Scope(Recorder, EventName, Index); } break;
+            }
+        }
+    }
+
+    /** Nanoseconds per event over Threads threads recording Events each. */
+    double TimeEvents(FTraceRecorder& Recorder, EBenchKind Kind, int64_t Events, int32_t Threads)
+    {
+        auto Start = std::chrono::steady_clock::now();
+        std::vector<std::thread> Workers;
+        for (int32_t Thread = 0; Thread < Threads; ++Thread)
+        {
+            Workers.emplace_back([&Recorder, Kind, Events] { RecordEvents(Recorder, Kind, Events); });
+        }
+        for (auto& Worker : Workers) Worker.join();
+        double Ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+        return Ns / static_cast<double>(Events);
+    }
+
+    void PrintTimings(const FBenchOptions& Options)
+    {
+        FTraceRecorder Recorder;
+        const char* Names[] = { "instant", "counter", "scope" };
+        std::printf("ns per event; last column: wall time over %d threads recording at once\n", Options.Threads);
+        std::printf("%-10s %10s %10s %12s\n", "event", "off", "on", "on, shared");
+        for (EBenchKind Kind : { EBenchKind::Instant, EBenchKind::Counter, EBenchKind::Scope })
+        {
+            Recorder.SetEnabled(false);
+            double Off = TimeEvents(Recorder, Kind, Options.Events, 1);
+            Recorder.SetEnabled(true);
+            double On = TimeEvents(Recorder, Kind, Options.Events, 1);
+            double Shared = TimeEvents(Recorder, Kind, Options.Events / Options.Threads, Options.Threads);
+            std::printf("%-10s %10.2f %10.2f %12.2f\n", Names[static_cast<int>(Kind)], Off, On, Shared);
+        }
+    }
+
+    /** Every field derives from Arg, so a mix of two writes shows. */
+    void RecordWhole(FTraceRecorder& Recorder, int64_t Arg)
+    {
+        Recorder.Record(ETracePhase::Complete, EventName, Arg * 3, Arg * 7, Arg);
+    }
+
+    bool IsWhole(const FTraceEvent& Event)
+    {
+        return Event.Name == EventName && Event.Phase == ETracePhase::Complete
+            && Event.StartNs == Event.Arg * 3 && Event.DurationNs == Event.Arg * 7;
+    }
+
+    bool CheckTornEvents(const FBenchOptions& Options)
+    {
+        FTraceRecorder Recorder(1024);
+        Recorder.SetEnabled(true);
+        std::atomic<bool> bStop{ false };
+        std::vector<std::thread> Writers;
+        for (int32_t Thread = 0; Thread < Options.Threads; ++Thread)
+        {
+            Writers.emplace_back([&Recorder, &bStop, Thread]
+            {
+                for (int64_t Value = Thread * (1ll << 40); !bStop.load(std::memory_order_relaxed); ++Value) RecordWhole(Recorder, Value);
+            });
+        }
+
+        while (Recorder.Recorded() < 2 * Recorder.Capacity()) std::this_thread::yield();
+        bool bWhole = true;
+        int64_t Seen = 0;
+        for (int32_t Round = 0; Round < 2000; ++Round)
+        {
+            if (Round % 16 == 0) std::this_thread::yield();
+            for (const FTraceEvent& Event : Recorder.Snapshot())
+            {
+                bWhole &= IsWhole(Event);
+                ++Seen;
+            }
+        }
+        bStop = true;
+        for (auto& Writer : Writers) Writer.join();
+
+        std::printf("snapshots under load: %lld event(s) read\n", static_cast<long long>(Seen));
+        bool bPass = Check(bWhole, "no torn events under concurrent writers");
+        bPass &= Check(Seen > 0, "snapshots return events while writers run");
+        return bPass;
+    }
+
+    bool CheckQuiescentDump(const FBenchOptions& Options)
+    {
+        FTraceRecorder Recorder(1u << 20);
+        Recorder.SetEnabled(true);
+        std::vector<std::thread> Writers;
+        for (int32_t Thread = 0; Thread < Options.Threads; ++Thread)
+        {
+            Writers.emplace_back([&Recorder, Thread]
+            {
+                for (int64_t Value = Thread * (1ll << 40); Recorder.IsEnabled(); ++Value) RecordWhole(Recorder, Value);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        Recorder.SetEnabled(false);
+        Recorder.WaitForWriters();
+
+        uint64_t Recorded = Recorder.Recorded();
+        std::vector<FTraceEvent> Events = Recorder.Snapshot();
+        bool bWhole = true;
+        for (const FTraceEvent& Event : Events) bWhole &= IsWhole(Event);
+        uint64_t Expected = Recorded < Recorder.Capacity() ? Recorded : Recorder.Capacity();
+
+        std::ostringstream Json;
+        Recorder.WriteChromeJson(Json);
+        for (auto& Writer : Writers) Writer.join();
+
+        bool bPass = Check(Recorder.Recorded() == Recorded, "nothing recorded after WaitForWriters");
+        bPass &= Check(Events.size() == Expected, "dump after WaitForWriters is complete");
+        bPass &= Check(bWhole, "dumped events are whole");
+        bPass &= Check(Json.str().find("\"ph\":\"X\"") != std::string::npos, "dump written as JSON");
+
+        Recorder.Clear();
+        bPass &= Check(Recorder.Snapshot().empty(), "clear forgets every event");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: trace_bench [--events N] [--threads N]\n");
+        return 2;
+    }
+
+    PrintTimings(Options);
+    bool bPass = Check(CheckTornEvents(Options), "torn events");
+    bPass &= Check(CheckQuiescentDump(Options), "quiescent dump");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
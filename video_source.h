@@ -0,0 +1,63 @@
+// VideoSource - Pull interface for decoded frames, independent of the decoder.
+// The CPU presentation path reads frames through this; platform decoders (Media
+// Foundation's source reader on Windows) and codec-free sources implement it.
+// Portable C++20: no platform headers.
+
+#pragma once
+
+#include <cstdint>
+
+#include "frame.h"
+
+struct FVideoInfo
+{
+    int32_t Width = 0;
+    int32_t Height = 0;
+    uint32_t FrameRateNumerator = 30;
+    uint32_t FrameRateDenominator = 1;
+    int64_t Duration100ns = 0;
+    EPixelFormat Format = EPixelFormat::Unknown;
+
+    /** Nominal frame duration in 100ns units. */
+    int64_t FrameDuration100ns() const
+    {
+        if (!FrameRateNumerator) return 333333;
+        return static_cast<int64_t>(10000000ULL * FrameRateDenominator / FrameRateNumerator);
+    }
+};
+
+/** Cache degradation steps for IVideoSource::SetCacheLevel. */
+constexpr int32_t MaxCacheLevel = 3;
+
+/** Each level halves a cache's configured size; the last one keeps no cache at all. */
+inline int64_t GetCacheLevelBytes(int64_t ConfiguredBytes, int32_t Level)
+{
+    if (Level <= 0) return ConfiguredBytes;
+    return Level >= MaxCacheLevel ? 0 : ConfiguredBytes >> Level;
+}
+
+class IVideoSource
+{
+public:
+    virtual ~IVideoSource() = default;
+
+    virtual const FVideoInfo& GetInfo() const = 0;
+
+    /**
+     * Decodes the next frame into Out (reallocating it only if the layout changed) and
+     * sets Out.Timestamp100ns. Returns false at end of stream or on error.
+     */
+    virtual bool ReadFrame(FFrame& Out) = 0;
+
+    /** Repositions so the next ReadFrame returns the frame at or after Position100ns. */
+    virtual bool Seek(int64_t Position100ns) = 0;
+
+    /** Bytes held in decoded-frame caches, the part of a source's memory it can give up. */
+    virtual int64_t GetCacheBytes() const { return 0; }
+
+    /**
+     * Resizes caches to GetCacheLevelBytes(configured size, Level); what no longer fits
+     * is decoded again when needed. Sources without caches ignore it.
+     */
+    virtual void SetCacheLevel(int32_t) {}
+};
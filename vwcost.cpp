@@ -0,0 +1,388 @@
+// vwcost - Offline cost analysis of a wallpaper before it is rolled out (Linux).
+// Reads a config.txt the way the wallpaper does - the video on the first line,
+// settings after it (rendition, pingpong_cache_mb) - plays the video through once
+// and writes a JSON report (see cost_model.h): decode cost per GOP, bitrate peaks,
+// keyframe spacing, and for each monitor size the CPU and memory of live decode
+// against cached playback, with a recommended frame-rate cap and the encodes worth
+// adding. Videos are decoded by ffmpeg, with packet sizes and keyframes from
+// ffprobe; the ffmpeg child's CPU time is spread over the frames by how long each
+// took to arrive. Y4M files and ":pattern:..." paths need neither: they are
+// uncompressed, so every frame is a keyframe and the bitrate is the raw rate.
+// Composing is timed with the software presenter's compositor at the source size.
+//   vwcost [--monitors WxH[,WxH...]] [--cpu-budget SHARE] [--seconds N] [--out FILE] <config.txt>
+// Endless patterns are analyzed for --seconds (60 unless given); files to their end.
+// Exit code: 0 when the report was written, 1 if the video cannot be analyzed, 2 on bad usage.
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compositor.h"
+#include "cost_model.h"
+#include "ffmpeg_source.h"
+#include "pattern_source.h"
+#include "rendition.h"
+#include "thread_pool.h"
+#include "y4m_source.h"
+
+namespace
+{
+    /** Endless patterns: media seconds analyzed when --seconds is not given. */
+    constexpr int32_t DefaultPatternSeconds = 60;
+
+    struct FCostOptions
+    {
+        std::string ConfigPath;
+        std::string OutPath;
+        std::vector<FIntRect> Monitors;
+        double CpuBudget = FCostSettings().CpuBudget;
+        int32_t Seconds = 0;
+    };
+
+    /** Common desktop sizes, from laptops to 4K. */
+    std::vector<FIntRect> GetTypicalMonitors()
+    {
+        return { { 0, 0, 1366, 768 }, { 0, 0, 1920, 1080 }, { 0, 0, 2560, 1440 }, { 0, 0, 3440, 1440 }, { 0, 0, 3840, 2160 } };
+    }
+
+    bool ParseMonitors(const std::string& Text, std::vector<FIntRect>& Monitors)
+    {
+        Monitors.clear();
+        size_t Start = 0;
+        while (Start <= Text.size())
+        {
+            size_t End = Text.find(',', Start);
+            if (End == std::string::npos) End = Text.size();
+            int Width = 0;
+            int Height = 0;
+            char Rest = 0;
+            if (std::sscanf(Text.substr(Start, End - Start).c_str(), "%dx%d%c", &Width, &Height, &Rest) != 2) return false;
+            if (Width < 2 || Height < 2 || Width > 16384 || Height > 16384) return false;
+            Monitors.push_back({ 0, 0, Width, Height });
+            Start = End + 1;
+        }
+        return !Monitors.empty();
+    }
+
+    bool ParseOptions(int Argc, char** Argv, FCostOptions& Options)
+    {
+        Options.Monitors = GetTypicalMonitors();
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            std::string Name = Argv[Index];
+            if (Name.compare(0, 2, "--") != 0)
+            {
+                if (!Options.ConfigPath.empty()) return false;
+                Options.ConfigPath = Name;
+                continue;
+            }
+            if (Index + 1 >= Argc) return false;
+            const char* Value = Argv[++Index];
+            if (Name == "--monitors")
+            {
+                if (!ParseMonitors(Value, Options.Monitors)) return false;
+            }
+            else if (Name == "--cpu-budget") Options.CpuBudget = std::atof(Value);
+            else if (Name == "--seconds") Options.Seconds = std::atoi(Value);
+            else if (Name == "--out") Options.OutPath = Value;
+            else return false;
+        }
+        return !Options.ConfigPath.empty() && Options.CpuBudget > 0.0 && Options.Seconds >= 0;
+    }
+
+    std::string Trim(const std::string& Text)
+    {
+        size_t First = Text.find_first_not_of(" \t\r\n");
+        if (First == std::string::npos) return {};
+        return Text.substr(First, Text.find_last_not_of(" \t\r\n") - First + 1);
+    }
+
+    struct FCostConfig
+    {
+        std::string VideoPath;
+        std::vector<TRendition<std::string>> Renditions;
+        int64_t CacheBytes = FCostSettings().CacheBudgetBytes;
+    };
+
+    /** As the wallpaper reads config.txt; settings that do not change the cost are skipped like unknown ones. */
+    bool ReadConfig(const std::string& Path, FCostConfig& Config)
+    {
+        std::ifstream File(Path);
+        std::string Line;
+        if (!File || !std::getline(File, Line)) return false;
+        Config.VideoPath = Trim(Line);
+        // A relative video path is taken from the config's folder, where the wallpaper keeps both.
+        size_t Slash = Path.find_last_of('/');
+        if (!Config.VideoPath.empty() && Config.VideoPath[0] != '/' && !IsPatternPath(Config.VideoPath) && Slash != std::string::npos)
+        {
+            Config.VideoPath = Path.substr(0, Slash + 1) + Config.VideoPath;
+        }
+
+        while (std::getline(File, Line))
+        {
+            Line = Trim(Line);
+            size_t Equals = Line.find('=');
+            if (Line.empty() || Line[0] == '#' || Equals == std::string::npos) continue;
+            std::string Key = Trim(Line.substr(0, Equals));
+            std::string Value = Trim(Line.substr(Equals + 1));
+            TRendition<std::string> Rendition;
+            if (Key == "rendition" && Value == "off") Config.Renditions.clear();
+            else if (Key == "rendition" && ParseRendition(Value, Rendition))
+            {
+                std::erase_if(Config.Renditions, [&](const auto& Other) { return Other.Suffix == Rendition.Suffix; });
+                Config.Renditions.push_back(Rendition);
+            }
+            else if (Key == "pingpong_cache_mb")
+            {
+                int32_t Megabytes = std::atoi(Value.c_str());
+                if (Megabytes > 0) Config.CacheBytes = Megabytes * 1024LL * 1024;
+            }
+        }
+        return !Config.VideoPath.empty();
+    }
+
+    int64_t ProcessCpuNs()
+    {
+        timespec Time {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Time);
+        return Time.tv_sec * 1000000000LL + Time.tv_nsec;
+    }
+
+    int64_t ChildrenCpuNs()
+    {
+        rusage Usage {};
+        getrusage(RUSAGE_CHILDREN, &Usage);
+        return (Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec) * 1000000000LL
+            + (Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec) * 1000LL;
+    }
+
+    int64_t WallNs()
+    {
+        timespec Time {};
+        clock_gettime(CLOCK_MONOTONIC, &Time);
+        return Time.tv_sec * 1000000000LL + Time.tv_nsec;
+    }
+
+    /** Packet sizes and keyframe flags in presentation order, from ffprobe; empty if it is missing. */
+    std::vector<FCostFrame> ProbePackets(const std::string& Path)
+    {
+        std::string Probe = "ffprobe -v error -select_streams v:0 -show_entries packet=pts_time,size,flags -of csv=p=0 "
+            + QuoteShellArgument(Path);
+        std::vector<FCostFrame> Packets;
+        FILE* Pipe = popen(Probe.c_str(), "r");
+        if (!Pipe) return Packets;
+        char Line[256];
+        while (std::fgets(Line, sizeof(Line), Pipe))
+        {
+            double Seconds = 0.0;
+            long long Bytes = 0;
+            char Flags[16] = {};
+            if (std::sscanf(Line, "%lf,%lld,%15s", &Seconds, &Bytes, Flags) != 3) continue;
+            Packets.push_back({ static_cast<int64_t>(Seconds * 1e7 + 0.5), Bytes, Flags[0] == 'K', 0 });
+        }
+        pclose(Pipe);
+        std::stable_sort
+        (
+            Packets.begin(), Packets.end(),
+            [](const FCostFrame& A, const FCostFrame& B) { return A.Timestamp100ns < B.Timestamp100ns; }
+        );
+        return Packets;
+    }
+
+    /**
+     * Reads up to MaxFrames frames, composing each at the source size. Frames gets one
+     * entry per frame with the CPU time its read took in this process and the wall time
+     * it took to arrive in WaitNs; bEnded is set when the source ran out first.
+     */
+    void PlayThrough
+    (
+        IVideoSource& Source, int64_t MaxFrames, std::vector<FCostFrame>& Frames, std::vector<int64_t>& WaitNs,
+        FFrameCost& Cost, bool& bEnded
+    )
+    {
+        const FVideoInfo& Info = Source.GetInfo();
+        FThreadPool Pool;
+        FSoftwareCompositor Compositor(Pool);
+        std::vector<FCompositorOutput> Outputs(1);
+        Outputs[0].Target = { 0, 0, Info.Width, Info.Height };
+        Compositor.Configure(Info.Width, Info.Height, Outputs);
+
+        FFrame Frame;
+        Frame.SetResourceTag("Cost.Frame");
+        int64_t ComposeNs = 0;
+        bEnded = false;
+        while (static_cast<int64_t>(Frames.size()) < MaxFrames)
+        {
+            int64_t CpuStart = ProcessCpuNs();
+            int64_t WallStart = WallNs();
+            if (!Source.ReadFrame(Frame))
+            {
+                bEnded = true;
+                break;
+            }
+            int64_t ReadNs = ProcessCpuNs() - CpuStart;
+            WaitNs.push_back(WallNs() - WallStart);
+            Frames.push_back({ Frame.Timestamp100ns, GetDecodedFrameBytes(Info.Width, Info.Height, Info.Format), true, ReadNs });
+
+            CpuStart = ProcessCpuNs();
+            Compositor.Compose(Frame.GetView());
+            ComposeNs += ProcessCpuNs() - CpuStart;
+        }
+        if (Frames.empty()) return;
+
+        const FCompositorStats& Stats = Compositor.GetStats();
+        double Stages = Stats.Convert.AverageNs + Stats.Scale.AverageNs;
+        double ConvertShare = Stages > 0.0 ? Stats.Convert.AverageNs / Stages : 0.5;
+        double PerFrame = static_cast<double>(ComposeNs) / static_cast<double>(Frames.size());
+        Cost.ConvertNs = PerFrame * ConvertShare;
+        Cost.ScaleNs = PerFrame - Cost.ConvertNs;
+        Cost.DirtyShare = Stats.TilesTotal ? static_cast<double>(Stats.TilesDirty) / static_cast<double>(Stats.TilesTotal) : 1.0;
+    }
+
+    /** Opens and plays the video; false (and a message) if it cannot be. */
+    bool MeasureVideo(const FCostOptions& Options, FCostReport& Report, std::vector<FCostFrame>& Frames)
+    {
+        const std::string& Path = Report.VideoPath;
+        std::unique_ptr<IVideoSource> Source;
+        std::vector<FCostFrame> Packets;
+        int64_t ChildrenStart = 0;
+        if (IsPatternPath(Path))
+        {
+            FPatternSettings Settings;
+            if (!ParsePatternPath(Path, Settings))
+            {
+                std::fprintf(stderr, "Bad pattern: %s\n", Path.c_str());
+                return false;
+            }
+            Report.SourceKind = "pattern";
+            Source = std::make_unique<FPatternSource>(Settings);
+        }
+        else if (IsY4MFile(Path))
+        {
+            auto Reader = std::make_unique<FY4MSource>();
+            if (!Reader->Open(Path))
+            {
+                std::fprintf(stderr, "Cannot read %s: %s.\n", Path.c_str(), Reader->GetError().c_str());
+                return false;
+            }
+            Report.SourceKind = "y4m";
+            Source = std::move(Reader);
+        }
+        else
+        {
+            Packets = ProbePackets(Path);
+            ChildrenStart = ChildrenCpuNs();
+            auto Decoder = std::make_unique<FFfmpegSource>();
+            if (Packets.empty() || !Decoder->Open(Path))
+            {
+                std::fprintf(stderr, "Cannot decode %s (needs ffmpeg and ffprobe on PATH).\n", Path.c_str());
+                return false;
+            }
+            Report.SourceKind = "ffmpeg";
+            Report.bCoded = true;
+            Source = std::move(Decoder);
+        }
+        Report.Info = Source->GetInfo();
+
+        double FrameRate = GetFrameRate(Report.Info);
+        int32_t Seconds = Options.Seconds ? Options.Seconds : Report.Info.Duration100ns > 0 ? 0 : DefaultPatternSeconds;
+        int64_t MaxFrames = Seconds ? static_cast<int64_t>(Seconds * FrameRate + 0.5) : INT64_MAX;
+        std::vector<int64_t> WaitNs;
+        bool bEnded = false;
+        PlayThrough(*Source, MaxFrames, Frames, WaitNs, Report.Cost, bEnded);
+        Report.bWholeLoop = bEnded;
+        if (Frames.empty())
+        {
+            std::fprintf(stderr, "No frames decoded from %s.\n", Path.c_str());
+            return false;
+        }
+
+        if (Report.bCoded)
+        {
+            // Reaps the ffmpeg child, so its CPU time shows up in the children's.
+            Source.reset();
+            int64_t ChildNs = ChildrenCpuNs() - ChildrenStart;
+            int64_t TotalWaitNs = 0;
+            for (int64_t Wait : WaitNs) TotalWaitNs += Wait;
+            for (size_t Index = 0; Index < Frames.size(); ++Index)
+            {
+                if (TotalWaitNs > 0) Frames[Index].DecodeNs += ChildNs * WaitNs[Index] / TotalWaitNs;
+                bool bPacket = Index < Packets.size();
+                Frames[Index].Bytes = bPacket ? Packets[Index].Bytes : 0;
+                Frames[Index].bKeyframe = bPacket && Packets[Index].bKeyframe;
+            }
+        }
+        int64_t DecodeNs = 0;
+        for (const FCostFrame& Frame : Frames) DecodeNs += Frame.DecodeNs;
+        Report.Cost.DecodeNs = static_cast<double>(DecodeNs) / static_cast<double>(Frames.size());
+        return true;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FCostOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf
+        (
+            stderr,
+            "usage: vwcost [--monitors WxH[,WxH...]] [--cpu-budget SHARE] [--seconds N] [--out FILE] <config.txt>\n"
+        );
+        return 2;
+    }
+    FCostConfig Config;
+    if (!ReadConfig(Options.ConfigPath, Config))
+    {
+        std::fprintf(stderr, "Cannot read a video path from %s.\n", Options.ConfigPath.c_str());
+        return 1;
+    }
+
+    FCostReport Report;
+    Report.VideoPath = Config.VideoPath;
+    // Encodes count where their file exists, as in the wallpaper; a pattern has no files, so all of them do.
+    for (const auto& Rendition : Config.Renditions)
+    {
+        if (IsPatternPath(Config.VideoPath) || std::ifstream(GetRenditionPath(Config.VideoPath, Rendition.Suffix)).good())
+        {
+            Report.Renditions.push_back(Rendition);
+        }
+    }
+    std::vector<FCostFrame> Frames;
+    if (!MeasureVideo(Options, Report, Frames)) return 1;
+
+    FCostSettings Settings;
+    Settings.CpuBudget = Options.CpuBudget;
+    Settings.CacheBudgetBytes = Config.CacheBytes;
+    AnalyzeCost(Report, Frames, Options.Monitors, Settings);
+
+    if (Options.OutPath.empty()) WriteCostReportJson(std::cout, Report);
+    else
+    {
+        std::ofstream Out(Options.OutPath);
+        WriteCostReportJson(Out, Report);
+        if (!Out)
+        {
+            std::fprintf(stderr, "Cannot write %s.\n", Options.OutPath.c_str());
+            return 1;
+        }
+    }
+    std::fprintf
+    (
+        stderr,
+        "%s: %dx%d at %.3g fps, %lld frame(s); decode %.2f ms, compose %.2f ms per frame; fps cap %.3g, %zu encode(s) to add\n",
+        Report.SourceKind.c_str(), Report.Info.Width, Report.Info.Height, GetFrameRate(Report.Info),
+        static_cast<long long>(Report.FrameCount), Report.Cost.DecodeNs / 1e6,
+        (Report.Cost.ConvertNs + Report.Cost.ScaleNs) / 1e6, Report.FpsCap, Report.RecommendedRenditions.size()
+    );
+    return 0;
+}
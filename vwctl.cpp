@@ -0,0 +1,249 @@
+// vwctl - Command-line client for a running VideoWallpaper instance.
+// Sends one request over the local control endpoint and prints the reply:
+//   vwctl status
+//   vwctl resources
+//   vwctl pause | resume | toggle | mute | unmute | reload | quit
+//   vwctl video C:\Videos\clip.mp4
+//   vwctl set lowpower_fps 3
+// The endpoint is only trusted if the process serving it runs as the same user,
+// so another user cannot pose as the wallpaper to collect video paths or status.
+// Exit code: 0 on "ok", 1 on an "error" reply, 2 if no instance could be reached.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "control_protocol.h"
+#ifndef _WIN32
+#include "control_socket.h"
+#endif
+
+namespace
+{
+    enum class EConnectResult : uint8_t
+    {
+        Connected,
+        Missing,    // Nothing serves the endpoint
+        Foreign     // Served by a process of another user
+    };
+
+#ifdef _WIN32
+    /** One endpoint per session, so instances in different sessions of a shared host do not collide. */
+    std::string GetEndpointPath()
+    {
+        DWORD SessionId = 0;
+        ProcessIdToSessionId(GetCurrentProcessId(), &SessionId);
+        return std::string("\\\\.\\pipe\\") + ControlEndpointName + "." + std::to_string(SessionId);
+    }
+
+    /** The TOKEN_USER of a process, in Buffer. */
+    bool GetProcessUser(HANDLE Process, std::vector<BYTE>& Buffer)
+    {
+        HANDLE Token = nullptr;
+        if (!OpenProcessToken(Process, TOKEN_QUERY, &Token)) return false;
+        DWORD Size = 0;
+        GetTokenInformation(Token, TokenUser, nullptr, 0, &Size);
+        Buffer.resize(Size);
+        bool bOk = Size && GetTokenInformation(Token, TokenUser, Buffer.data(), Size, &Size);
+        CloseHandle(Token);
+        return bOk;
+    }
+
+    /** True if the process serving Pipe runs as the same user as this one. */
+    bool IsServedBySameUser(HANDLE Pipe)
+    {
+        ULONG ServerProcessId = 0;
+        if (!GetNamedPipeServerProcessId(Pipe, &ServerProcessId)) return false;
+        HANDLE Server = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, ServerProcessId);
+        if (!Server) return false;
+        std::vector<BYTE> ServerUser;
+        std::vector<BYTE> OwnUser;
+        bool bSame = GetProcessUser(Server, ServerUser) && GetProcessUser(GetCurrentProcess(), OwnUser)
+            && EqualSid
+            (
+                reinterpret_cast<TOKEN_USER*>(ServerUser.data())->User.Sid,
+                reinterpret_cast<TOKEN_USER*>(OwnUser.data())->User.Sid
+            );
+        CloseHandle(Server);
+        return bSame;
+    }
+
+    class FEndpoint
+    {
+    public:
+        ~FEndpoint() { if (Pipe != INVALID_HANDLE_VALUE) CloseHandle(Pipe); }
+
+        EConnectResult Connect()
+        {
+            std::string Path = GetEndpointPath();
+            for (int32_t Attempt = 0; Attempt < 2; ++Attempt)
+            {
+                Pipe = CreateFileA(Path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+                if (Pipe != INVALID_HANDLE_VALUE) return IsServedBySameUser(Pipe) ? EConnectResult::Connected : EConnectResult::Foreign;
+                // The server takes one client at a time; wait for it to finish with the previous one.
+                if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeA(Path.c_str(), 2000)) return EConnectResult::Missing;
+            }
+            return EConnectResult::Missing;
+        }
+
+        bool Write(const std::string& Data)
+        {
+            DWORD Written = 0;
+            return WriteFile(Pipe, Data.data(), static_cast<DWORD>(Data.size()), &Written, nullptr)
+                && Written == Data.size();
+        }
+
+        /** Returns bytes read, 0 when the server closed the pipe. */
+        size_t Read(char* Buffer, size_t Size)
+        {
+            DWORD Read = 0;
+            if (!ReadFile(Pipe, Buffer, static_cast<DWORD>(Size), &Read, nullptr)) return 0;
+            return Read;
+        }
+
+    private:
+        HANDLE Pipe = INVALID_HANDLE_VALUE;
+    };
+#else
+    std::string GetEndpointPath() { return GetControlSocketPath(); }
+
+    class FEndpoint
+    {
+    public:
+        ~FEndpoint() { if (Socket >= 0) close(Socket); }
+
+        EConnectResult Connect()
+        {
+            std::string Path = GetEndpointPath();
+            sockaddr_un Address = {};
+            Address.sun_family = AF_UNIX;
+            if (Path.size() >= sizeof(Address.sun_path)) return EConnectResult::Missing;
+            Path.copy(Address.sun_path, Path.size());
+
+            Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (Socket < 0 || connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0) return EConnectResult::Missing;
+            uid_t ServerUid = 0;
+            return GetSocketPeerUid(Socket, ServerUid) && ServerUid == getuid() ? EConnectResult::Connected : EConnectResult::Foreign;
+        }
+
+        bool Write(const std::string& Data)
+        {
+            size_t Sent = 0;
+            while (Sent < Data.size())
+            {
+                ssize_t Result = send(Socket, Data.data() + Sent, Data.size() - Sent, 0);
+                if (Result <= 0) return false;
+                Sent += static_cast<size_t>(Result);
+            }
+            return true;
+        }
+
+        size_t Read(char* Buffer, size_t Size)
+        {
+            ssize_t Result = recv(Socket, Buffer, Size, 0);
+            return Result > 0 ? static_cast<size_t>(Result) : 0;
+        }
+
+    private:
+        int Socket = -1;
+    };
+#endif
+
+    int32_t RunRequest(const std::string& Request)
+    {
+        FEndpoint Endpoint;
+        EConnectResult Connected = Endpoint.Connect();
+        if (Connected == EConnectResult::Missing)
+        {
+            std::fprintf(stderr, "VideoWallpaper is not running (no endpoint at %s).\n", GetEndpointPath().c_str());
+            return 2;
+        }
+        if (Connected == EConnectResult::Foreign)
+        {
+            std::fprintf(stderr, "The endpoint at %s is not served by your VideoWallpaper; not sending.\n", GetEndpointPath().c_str());
+            return 2;
+        }
+
+        std::string Frame;
+        AppendControlFrame(Frame, Request);
+        if (!Endpoint.Write(Frame))
+        {
+            std::fprintf(stderr, "Failed to send the request.\n");
+            return 2;
+        }
+
+        FControlFrameReader Reader;
+        std::string Payload;
+        char Buffer[4096];
+        for (;;)
+        {
+            EControlFrameResult Result = Reader.Next(Payload);
+            if (Result == EControlFrameResult::Frame) break;
+            size_t Read = Result == EControlFrameResult::Incomplete ? Endpoint.Read(Buffer, sizeof(Buffer)) : 0;
+            if (!Read)
+            {
+                std::fprintf(stderr, "No reply from VideoWallpaper.\n");
+                return 2;
+            }
+            Reader.Append(Buffer, Read);
+        }
+
+        FControlResponse Response = ParseControlResponse(Payload);
+        if (!Response.bOk)
+        {
+            std::fprintf(stderr, "error: %s\n", Response.Text.c_str());
+            return 1;
+        }
+        std::printf("%s\n", Response.Text.empty() ? "ok" : Response.Text.c_str());
+        return 0;
+    }
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr, "usage: vwctl <command> [argument...]\ncommands:");
+        for (const auto& Info : ControlCommands) std::fprintf(stderr, " %s", Info.Name);
+        std::fprintf(stderr, "\n");
+    }
+}
+
+#ifdef _WIN32
+int wmain(int Argc, wchar_t** Argv)
+{
+    // Arguments (video paths in particular) travel as UTF-8.
+    SetConsoleOutputCP(CP_UTF8);
+    std::string Request;
+    for (int Index = 1; Index < Argc; ++Index)
+    {
+        int32_t Size = WideCharToMultiByte(CP_UTF8, 0, Argv[Index], -1, nullptr, 0, nullptr, nullptr);
+        std::string Argument(Size > 0 ? Size - 1 : 0, '\0');
+        if (Size > 1) WideCharToMultiByte(CP_UTF8, 0, Argv[Index], -1, Argument.data(), Size, nullptr, nullptr);
+        if (!Request.empty()) Request += ' ';
+        Request += Argument;
+    }
+#else
+int main(int Argc, char** Argv)
+{
+    std::string Request;
+    for (int Index = 1; Index < Argc; ++Index)
+    {
+        if (!Request.empty()) Request += ' ';
+        Request += Argv[Index];
+    }
+#endif
+    if (Request.empty())
+    {
+        PrintUsage();
+        return 2;
+    }
+    return RunRequest(Request);
+}
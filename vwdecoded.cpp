@@ -0,0 +1,136 @@
+// vwdecoded - Shared decode service for multi-session hosts (Linux).
+// Decodes each distinct (video, resolution) pair once and publishes the frames in
+// shared memory; wallpaper instances started with --decode-service attach to it
+// instead of decoding themselves. See decode_service.h.
+//   vwdecoded [--socket PATH] [--socket-mode OCTAL] [--linger-ms N]
+//             [--priority normal|background|idle]
+//   vwdecoded --status [--socket PATH]
+// Streams are videos decoded by ffmpeg, scaled to cover the size sessions ask for,
+// Y4M files played from a memory mapping, or ":pattern" (":pattern:OPTIONS") for
+// the built-in synthetic video. Stream threads and their ffmpeg children run at
+// background priority unless --priority says otherwise (see qos.h). The socket is
+// 0600 whatever the umask; a host-wide service gives --socket-mode 0666, and then
+// serves other users only files they can read themselves. Runs until
+// SIGINT/SIGTERM; --status prints the streams and attached sessions of a running
+// service.
+// Exit code: 0 on a clean shutdown, 1 if the service cannot start or is not
+// running (--status), 2 on bad usage.
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "decode_service.h"
+#include "ffmpeg_source.h"
+#include "pattern_source.h"
+#include "qos_linux.h"
+#include "y4m_source.h"
+
+namespace
+{
+    std::atomic<bool> GbQuitRequested{ false };
+
+    void OnQuitSignal(int) { GbQuitRequested.store(true, std::memory_order_relaxed); }
+
+    std::unique_ptr<IVideoSource> OpenStreamSource(const std::string& Path, int32_t Width, int32_t Height)
+    {
+        FPatternSettings Pattern;
+        Pattern.Width = Width;
+        Pattern.Height = Height;
+        if (ParsePatternPath(Path, Pattern)) return std::make_unique<FPatternSource>(Pattern);
+        if (IsY4MFile(Path))
+        {
+            auto Reader = std::make_unique<FY4MSource>();
+            if (!Reader->Open(Path))
+            {
+                std::fprintf(stderr, "Cannot play %s: %s.\n", Path.c_str(), Reader->GetError().c_str());
+                return nullptr;
+            }
+            return Reader;
+        }
+        auto Decoder = std::make_unique<FFfmpegSource>();
+        if (!RunAsWorkClass(EWorkClass::Decode, [&] { return Decoder->Open(Path, Width, Height); }))
+        {
+            std::fprintf(stderr, "Cannot decode %s (needs ffmpeg and ffprobe on PATH).\n", Path.c_str());
+            return nullptr;
+        }
+        return Decoder;
+    }
+
+    /** Permission bits only, in octal ("0666"). */
+    bool ParseSocketMode(const char* Text, mode_t& Mode)
+    {
+        char* End = nullptr;
+        unsigned long Value = std::strtoul(Text, &End, 8);
+        if (!*Text || *End || Value > 0777) return false;
+        Mode = static_cast<mode_t>(Value);
+        return true;
+    }
+
+    int32_t PrintStatus(const std::string& SocketPath)
+    {
+        int Socket = ConnectUnixSocket(SocketPath);
+        std::string Reply;
+        bool bReplied = Socket >= 0 && RequestOverSocket(Socket, "status", Reply, 2000);
+        if (Socket >= 0) close(Socket);
+        if (!bReplied)
+        {
+            std::fprintf(stderr, "No decode service at %s.\n", SocketPath.c_str());
+            return 1;
+        }
+        std::printf("%s\n", ParseControlResponse(Reply).Text.c_str());
+        return 0;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FDecodeServiceSettings Settings;
+    bool bStatus = false;
+    EQosLevel Priority = EQosLevel::Background;
+    for (int Index = 1; Index < Argc; ++Index)
+    {
+        std::string Argument = Argv[Index];
+        bool bHasValue = Index + 1 < Argc;
+        if (Argument == "--status") bStatus = true;
+        else if (Argument == "--socket" && bHasValue) Settings.SocketPath = Argv[++Index];
+        else if (Argument == "--socket-mode" && bHasValue && ParseSocketMode(Argv[++Index], Settings.SocketMode)) continue;
+        else if (Argument == "--linger-ms" && bHasValue) Settings.LingerMs = std::atoi(Argv[++Index]);
+        else if (Argument == "--priority" && bHasValue && ParseQosLevel(std::string(Argv[++Index]), Priority)) continue;
+        else
+        {
+            std::fprintf(stderr, "usage: vwdecoded [--socket PATH] [--socket-mode OCTAL] [--linger-ms N] [--priority normal|background|idle] [--status]\n");
+            return 2;
+        }
+    }
+    if (Settings.SocketPath.empty()) Settings.SocketPath = GetDecodeServicePath();
+    if (bStatus) return PrintStatus(Settings.SocketPath);
+
+    std::signal(SIGINT, OnQuitSignal);
+    std::signal(SIGTERM, OnQuitSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Nothing is presented here, so there is no deadline to escalate on: levels stay at the base.
+    FLinuxQos Qos;
+    if (Priority != EQosLevel::Normal)
+    {
+        GQos.SetBackend(Qos.MakeBackend());
+        GQos.SetPolicy(FQosPolicy::FromPriority(Priority, false));
+        GQos.EnterThread(EWorkClass::Maintenance);
+    }
+
+    FDecodeService Service(OpenStreamSource, Settings);
+    std::string Error;
+    if (!Service.Listen(Error))
+    {
+        std::fprintf(stderr, "%s\n", Error.c_str());
+        return 1;
+    }
+    std::printf("Decode service listening on %s.\n", Settings.SocketPath.c_str());
+    std::fflush(stdout);
+    Service.Run(GbQuitRequested);
+    return 0;
+}
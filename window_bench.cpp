@@ -0,0 +1,305 @@
+// window_bench - Checks and times the occlusion scan's window classification cache.
+// A fake window system holds a z-ordered list of top-level windows with a class,
+// extended style, cloak state and whether they cover the monitor; the scan walks
+// it the way OcclusionEnumProc walks EnumWindows, classifying through the cache.
+// Scripted changes - windows created, destroyed and their handles reused, cloaked,
+// restyled with WS_EX_TOOLWINDOW (and WS_EX_APPWINDOW, which changes nothing)
+// without any event, and the wallpaper's own windows added - must give the same
+// answer as a scan without the cache, classifying only the windows that changed.
+// Then a --windows window desktop is scanned with and without the cache, each
+// classification costing three simulated cross-process queries of --query-ns.
+//   g++ -std=c++20 -O2 -pthread window_bench.cpp -o window_bench
+//   window_bench [--windows N] [--scans N] [--query-ns N]
+// Exit code: 0 when every check passes, 1 on a failed check, 2 on bad usage.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "window_cache.h"
+
+namespace
+{
+    bool Check(bool bCondition, const char* What)
+    {
+        if (!bCondition) std::printf("FAIL: %s\n", What);
+        return bCondition;
+    }
+
+    constexpr uint32_t ToolWindowStyle = 0x80;      // WS_EX_TOOLWINDOW
+    constexpr uint32_t AppWindowStyle = 0x40000;    // WS_EX_APPWINDOW
+
+    struct FBenchOptions
+    {
+        int32_t Windows = 1000;
+        int32_t Scans = 200;
+        int64_t QueryNs = 2000;
+    };
+
+    bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+    {
+        for (int Index = 1; Index < Argc; ++Index)
+        {
+            if (Index + 1 >= Argc) return false;
+            std::string Name = Argv[Index];
+            const char* Value = Argv[++Index];
+            if (Name == "--windows") Options.Windows = std::atoi(Value);
+            else if (Name == "--scans") Options.Scans = std::atoi(Value);
+            else if (Name == "--query-ns") Options.QueryNs = std::atoll(Value);
+            else return false;
+        }
+        return Options.Windows > 0 && Options.Scans > 0 && Options.QueryNs >= 0;
+    }
+
+    struct FFakeWindow
+    {
+        uint64_t Handle = 0;
+        bool bVisible = true;
+        bool bIconic = false;
+        bool bShell = false;
+        uint32_t ExStyle = 0;
+        bool bCloaked = false;
+        bool bCovers = false;       // Fully covers the monitor
+    };
+
+    /** Top-level windows front to back, and the cost of asking about them. */
+    class FFakeWindowSystem
+    {
+    public:
+        explicit FFakeWindowSystem(int64_t InQueryNs) : QueryNs(InQueryNs) {}
+
+        uint64_t Create(const FFakeWindow& Window)
+        {
+            Windows.push_back(Window);
+            Windows.back().Handle = NextHandle++;
+            return Windows.back().Handle;
+        }
+
+        /** Reuses a destroyed window's handle for a new window, as Windows may. */
+        void CreateWithHandle(uint64_t Handle, const FFakeWindow& Window)
+        {
+            Windows.insert(Windows.begin(), Window);
+            Windows.front().Handle = Handle;
+        }
+
+        void Destroy(uint64_t Handle)
+        {
+            for (size_t Index = 0; Index < Windows.size(); ++Index)
+            {
+                if (Windows[Index].Handle != Handle) continue;
+                Windows.erase(Windows.begin() + static_cast<std::ptrdiff_t>(Index));
+                return;
+            }
+        }
+
+        FFakeWindow* Find(uint64_t Handle)
+        {
+            for (FFakeWindow& Window : Windows)
+            {
+                if (Window.Handle == Handle) return &Window;
+            }
+            return nullptr;
+        }
+
+        /** The slow path: class name, extended style and cloak state, one query each. */
+        FWindowClassInfo Classify(uint64_t Handle)
+        {
+            ++Classifications;
+            for (int32_t Query = 0; Query < 3; ++Query) SimulateQuery();
+            const FFakeWindow& Window = *Find(Handle);
+            FWindowClassInfo Info;
+            Info.Category = Window.bShell ? EWindowCategory::Shell : EWindowCategory::Normal;
+            Info.bToolWindow = (Window.ExStyle & ToolWindowStyle) != 0;
+            Info.bCloaked = Window.bCloaked;
+            return Info;
+        }
+
+        const std::vector<FFakeWindow>& GetWindows() const { return Windows; }
+        uint64_t GetClassifications() const { return Classifications; }
+
+    private:
+        void SimulateQuery() const
+        {
+            if (!QueryNs) return;
+            auto End = std::chrono::steady_clock::now() + std::chrono::nanoseconds(QueryNs);
+            while (std::chrono::steady_clock::now() < End) {}
+        }
+
+        std::vector<FFakeWindow> Windows;
+        uint64_t NextHandle = 0x10000;
+        uint64_t Classifications = 0;
+        int64_t QueryNs = 0;
+    };
+
+    /** OcclusionEnumProc over the fake windows; the handle of the occluding window, or 0. */
+    uint64_t Scan(FFakeWindowSystem& System, TWindowClassCache<uint64_t>& Cache)
+    {
+        for (const FFakeWindow& Window : System.GetWindows())
+        {
+            if (!Window.bVisible || Window.bIconic) continue;
+            auto Classify = [&System](uint64_t Handle) { return System.Classify(Handle); };
+            uint32_t Style = Window.ExStyle & ToolWindowStyle;
+            if (Cache.Lookup(Window.Handle, Style, Classify).IsIgnored()) continue;
+            if (Window.bCovers) return Window.Handle;
+        }
+        return 0;
+    }
+
+    /** The same scan with the cache off: what the answer must be. */
+    uint64_t ScanUncached(FFakeWindowSystem& System, const TWindowClassCache<uint64_t>& Cache)
+    {
+        TWindowClassCache<uint64_t> Uncached;
+        Uncached.SetEnabled(false);
+        for (const FFakeWindow& Window : System.GetWindows())
+        {
+            if (Cache.IsOwnWindow(Window.Handle)) Uncached.AddOwnWindow(Window.Handle);
+        }
+        return Scan(System, Uncached);
+    }
+
+    bool CheckEvents()
+    {
+        FFakeWindowSystem System(0);
+        TWindowClassCache<uint64_t> Cache;
+        bool bPass = true;
+
+        FFakeWindow Shell;
+        Shell.bShell = true;
+        Shell.bCovers = true;
+        FFakeWindow Game;
+        Game.bCovers = true;
+        FFakeWindow Small;
+
+        uint64_t Overlay = System.Create(Small);
+        uint64_t Player = System.Create(Game);
+        System.Create(Small);
+        uint64_t Progman = System.Create(Shell);
+
+        auto Expect = [&](uint64_t Expected, uint64_t Classified, const char* What)
+        {
+            uint64_t Before = System.GetClassifications();
+            uint64_t Result = Scan(System, Cache);
+            uint64_t Count = System.GetClassifications() - Before;
+            bool bOk = Result == Expected && Result == ScanUncached(System, Cache);
+            bOk &= Count == Classified;
+            if (!bOk)
+            {
+                std::printf("  %s: occluder %llx (want %llx), %llu classification(s) (want %llu)\n",
+                    What, static_cast<unsigned long long>(Result), static_cast<unsigned long long>(Expected),
+                    static_cast<unsigned long long>(Count), static_cast<unsigned long long>(Classified));
+            }
+            bPass &= Check(bOk, What);
+        };
+
+        // Scans stop at the occluding window, so only the windows in front of it are classified.
+        Expect(Player, 2, "first scan classifies what it reaches");
+        Expect(Player, 0, "second scan is all hits");
+
+        // A full-screen game turning itself into a tool window raises no event.
+        System.Find(Player)->ExStyle |= ToolWindowStyle;
+        Expect(0, 3, "WS_EX_TOOLWINDOW set without an event");
+        Expect(0, 0, "restyled window cached again");
+        // Every tool window is skipped, as before the cache, whatever else its style says.
+        System.Find(Player)->ExStyle |= AppWindowStyle;
+        Expect(0, 0, "WS_EX_APPWINDOW tool window still skipped");
+        System.Find(Player)->ExStyle &= ~(ToolWindowStyle | AppWindowStyle);
+        Expect(Player, 1, "styles cleared");
+        bPass &= Check(Cache.GetStyleChanges() == 2, "style changes counted");
+
+        System.Find(Player)->bCloaked = true;
+        Cache.Invalidate(Player);   // EVENT_OBJECT_CLOAKED
+        Expect(0, 1, "cloaked on event");
+        System.Find(Player)->bCloaked = false;
+        Cache.Invalidate(Player);   // EVENT_OBJECT_UNCLOAKED
+        Expect(Player, 1, "uncloaked on event");
+
+        Cache.AddOwnWindow(Player);
+        Expect(0, 1, "own window ignored");
+        Cache.RemoveOwnWindow(Player);
+        Expect(Player, 1, "own window removed");
+
+        // The overlay is destroyed and its handle reused by a full-screen window.
+        System.Destroy(Overlay);
+        Cache.Invalidate(Overlay);  // EVENT_OBJECT_DESTROY
+        System.CreateWithHandle(Overlay, Game);
+        Cache.Invalidate(Overlay);  // EVENT_OBJECT_CREATE
+        Expect(Overlay, 1, "reused handle classified afresh");
+
+        System.Find(Overlay)->bVisible = false;
+        Expect(Player, 0, "visibility is a live query");
+        System.Destroy(Player);
+        Cache.Invalidate(Player);
+        Expect(0, 0, "shell windows never occlude");
+        bPass &= Check(System.Find(Progman) != nullptr, "shell window scanned");
+
+        Cache.SetEnabled(false);
+        bPass &= Check(Cache.Size() == 0, "disabling drops every entry");
+        Expect(0, 2, "disabled cache always classifies");
+        return bPass;
+    }
+
+    bool CheckBound()
+    {
+        FFakeWindowSystem System(0);
+        TWindowClassCache<uint64_t> Cache;
+        for (size_t Index = 0; Index < WindowCacheMaxEntries + 100; ++Index) System.Create(FFakeWindow());
+        Scan(System, Cache);
+        return Check(Cache.Size() <= WindowCacheMaxEntries, "cache stays under its bound without destroy events");
+    }
+
+    bool RunBenchmark(const FBenchOptions& Options)
+    {
+        FFakeWindowSystem System(Options.QueryNs);
+        FFakeWindow Window;
+        for (int32_t Index = 0; Index < Options.Windows; ++Index)
+        {
+            Window.bShell = Index % 50 == 0;
+            Window.ExStyle = Index % 7 == 0 ? ToolWindowStyle : 0;
+            Window.bCloaked = Index % 11 == 0;
+            Window.bIconic = Index % 13 == 0;
+            System.Create(Window);
+        }
+
+        auto Time = [&](TWindowClassCache<uint64_t>& Cache)
+        {
+            Scan(System, Cache);
+            auto Start = std::chrono::steady_clock::now();
+            for (int32_t ScanIndex = 0; ScanIndex < Options.Scans; ++ScanIndex) Scan(System, Cache);
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - Start).count() / Options.Scans;
+        };
+
+        TWindowClassCache<uint64_t> Cached;
+        uint64_t Before = System.GetClassifications();
+        double CachedUs = Time(Cached);
+        uint64_t CachedClassifications = System.GetClassifications() - Before;
+        TWindowClassCache<uint64_t> Uncached;
+        Uncached.SetEnabled(false);
+        double UncachedUs = Time(Uncached);
+
+        std::printf("%d windows, %lld ns per query: %.1f us per scan uncached, %.1f us cached (%.0fx)\n",
+            Options.Windows, static_cast<long long>(Options.QueryNs), UncachedUs, CachedUs, CachedUs > 0.0 ? UncachedUs / CachedUs : 0.0);
+        bool bPass = Check(CachedClassifications <= static_cast<uint64_t>(Options.Windows), "steady scans do not classify");
+        bPass &= Check(Options.QueryNs == 0 || CachedUs < UncachedUs, "cache is faster");
+        return bPass;
+    }
+}
+
+int main(int Argc, char** Argv)
+{
+    FBenchOptions Options;
+    if (!ParseOptions(Argc, Argv, Options))
+    {
+        std::fprintf(stderr, "usage: window_bench [--windows N] [--scans N] [--query-ns N]\n");
+        return 2;
+    }
+
+    bool bPass = Check(CheckEvents(), "events");
+    bPass &= Check(CheckBound(), "bound");
+    bPass &= Check(RunBenchmark(Options), "benchmark");
+
+    std::printf("%s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
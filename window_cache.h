@@ -0,0 +1,134 @@
+// WindowCache - Per-window classification cache for the occlusion scan.
+// Holds the parts of a window's classification that only change on discrete
+// events (class, tool-window style, DWM cloak, ownership), so a scan costs one
+// hash lookup per window instead of several cross-process round trips. Style
+// changes raise no event, so every lookup passes the window's current style bits
+// and an entry cached under different bits is classified again.
+// Portable C++20: the handle type and the classifier are supplied by the caller.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+/** Upper bound on cached windows; a missed destroy event can never grow the cache past this. */
+constexpr size_t WindowCacheMaxEntries = 4096;
+
+enum class EWindowCategory : uint8_t
+{
+    Normal,     // Ordinary application window, eligible to occlude
+    Shell       // Progman, WorkerW, taskbars — never occludes
+};
+
+struct FWindowClassInfo
+{
+    EWindowCategory Category = EWindowCategory::Normal;
+    bool bToolWindow = false;
+    bool bCloaked = false;
+    bool bOwnWindow = false;
+
+    /** True if the occlusion scan should skip this window regardless of geometry. */
+    bool IsIgnored() const
+    {
+        return Category == EWindowCategory::Shell || bToolWindow || bCloaked || bOwnWindow;
+    }
+};
+
+template <typename HandleType>
+class TWindowClassCache
+{
+public:
+    /**
+     * Returns the cached classification, running Classify(Handle) on a miss or when
+     * Style differs from the bits the entry was classified under. Classify fills
+     * everything except bOwnWindow, which comes from the own-window set.
+     */
+    template <typename ClassifyFn>
+    FWindowClassInfo Lookup(HandleType Handle, uint32_t Style, ClassifyFn&& Classify)
+    {
+        if (!bEnabled)
+        {
+            ++Misses;
+            FWindowClassInfo Info = Classify(Handle);
+            Info.bOwnWindow = IsOwnWindow(Handle);
+            return Info;
+        }
+
+        auto Found = Entries.find(Handle);
+        if (Found != Entries.end())
+        {
+            if (Found->second.Style == Style)
+            {
+                ++Hits;
+                return Found->second.Info;
+            }
+            ++StyleChanges;
+            Entries.erase(Found);
+        }
+
+        ++Misses;
+        if (Entries.size() >= WindowCacheMaxEntries) Entries.clear();
+
+        FWindowClassInfo Info = Classify(Handle);
+        Info.bOwnWindow = IsOwnWindow(Handle);
+        Entries.emplace(Handle, FEntry{ Info, Style });
+        return Info;
+    }
+
+    /** Drops one window's entry (create/destroy/show/hide/state/cloak change). */
+    void Invalidate(HandleType Handle) { Entries.erase(Handle); }
+
+    void InvalidateAll() { Entries.clear(); }
+
+    /**
+     * Without invalidation events the cache would go stale, so callers disable
+     * it when the event source is unavailable; lookups then always classify.
+     */
+    void SetEnabled(bool bInEnabled)
+    {
+        bEnabled = bInEnabled;
+        if (!bEnabled) Entries.clear();
+    }
+    bool IsEnabled() const { return bEnabled; }
+
+    void AddOwnWindow(HandleType Handle)
+    {
+        OwnWindows.insert(Handle);
+        Invalidate(Handle);
+    }
+
+    void RemoveOwnWindow(HandleType Handle)
+    {
+        OwnWindows.erase(Handle);
+        Invalidate(Handle);
+    }
+
+    void ClearOwnWindows()
+    {
+        for (const auto& Handle : OwnWindows) Entries.erase(Handle);
+        OwnWindows.clear();
+    }
+
+    bool IsOwnWindow(HandleType Handle) const { return OwnWindows.count(Handle) != 0; }
+
+    size_t Size() const { return Entries.size(); }
+    uint64_t GetHits() const { return Hits; }
+    uint64_t GetMisses() const { return Misses; }
+    uint64_t GetStyleChanges() const { return StyleChanges; }
+
+private:
+    struct FEntry
+    {
+        FWindowClassInfo Info;
+        uint32_t Style = 0;     // Style bits Info was classified under
+    };
+
+    std::unordered_map<HandleType, FEntry> Entries;
+    std::unordered_set<HandleType> OwnWindows;
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t StyleChanges = 0;  // Entries re-classified because their style bits changed
+    bool bEnabled = true;
+};
@@ -0,0 +1,400 @@
+// Y4mSource - Raw YUV4MPEG2 video as a frame source, and a writer for it (POSIX).
+// Y4M is uncompressed: a text header, then each frame as "FRAME" plus planar
+// 4:2:0 samples. Playing it needs no codec, so the whole frame path can be fed
+// and timed on a build box, and a decode can be captured once and replayed bit
+// for bit. The file is memory-mapped and read front to back: frames are copied
+// straight out of the mapping into NV12 (8-bit) or P010 (10-bit) frames, the
+// kernel is told to read ahead, and pages already played are dropped again, so a
+// multi-gigabyte 4K capture streams without growing the resident set.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "resource_tracker.h"
+#include "video_source.h"
+
+/** Stream parameters from a Y4M header. Only 4:2:0 (8 or 10 bit) and mono are supported. */
+struct FY4MHeader
+{
+    int32_t Width = 0;
+    int32_t Height = 0;
+    uint32_t FrameRateNumerator = 0;
+    uint32_t FrameRateDenominator = 0;
+    int32_t BitDepth = 8;
+    bool bMono = false;         // Luma only; chroma reads as neutral
+
+    int32_t SampleBytes() const { return BitDepth > 8 ? 2 : 1; }
+    size_t LumaBytes() const { return static_cast<size_t>(Width) * Height * SampleBytes(); }
+    size_t ChromaPlaneBytes() const
+    {
+        return bMono ? 0 : static_cast<size_t>((Width + 1) / 2) * ((Height + 1) / 2) * SampleBytes();
+    }
+    size_t FrameBytes() const { return LumaBytes() + 2 * ChromaPlaneBytes(); }
+};
+
+/**
+ * Parses the "YUV4MPEG2 ..." line at the start of Data; HeaderBytes gets its length
+ * including the newline. Interlacing, aspect and extension tags are ignored.
+ */
+inline bool ParseY4MHeader(const char* Data, size_t Size, FY4MHeader& Out, size_t& HeaderBytes, std::string& Error)
+{
+    const char* End = static_cast<const char*>(std::memchr(Data, '\n', Size < 1024 ? Size : 1024));
+    if (Size < 10 || std::memcmp(Data, "YUV4MPEG2 ", 10) != 0 || !End)
+    {
+        Error = "not a YUV4MPEG2 file";
+        return false;
+    }
+    HeaderBytes = static_cast<size_t>(End - Data) + 1;
+    Out = {};
+    std::string Line(Data + 10, End);
+    size_t Start = 0;
+    while (Start < Line.size())
+    {
+        size_t Space = Line.find(' ', Start);
+        if (Space == std::string::npos) Space = Line.size();
+        std::string Tag = Line.substr(Start, Space - Start);
+        Start = Space + 1;
+        if (Tag.empty()) continue;
+        const char* Value = Tag.c_str() + 1;
+        switch (Tag[0])
+        {
+        case 'W': Out.Width = std::atoi(Value); break;
+        case 'H': Out.Height = std::atoi(Value); break;
+        case 'F':
+            if (std::sscanf(Value, "%u:%u", &Out.FrameRateNumerator, &Out.FrameRateDenominator) != 2) Out.FrameRateNumerator = 0;
+            break;
+        case 'C':
+            if (Tag == "C420" || Tag == "C420jpeg" || Tag == "C420paldv" || Tag == "C420mpeg2") Out.BitDepth = 8;
+            else if (Tag == "C420p10") Out.BitDepth = 10;
+            else if (Tag == "Cmono") Out.bMono = true;
+            else
+            {
+                Error = "unsupported colour space " + Tag.substr(1) + " (4:2:0 or mono only)";
+                return false;
+            }
+            break;
+        default: break;
+        }
+    }
+    if (Out.Width < 2 || Out.Height < 2 || Out.Width > 16384 || Out.Height > 16384)
+    {
+        Error = "missing or invalid frame size";
+        return false;
+    }
+    if (!Out.FrameRateNumerator || !Out.FrameRateDenominator)
+    {
+        Out.FrameRateNumerator = 30;
+        Out.FrameRateDenominator = 1;
+    }
+    return true;
+}
+
+/** True if Path starts with the Y4M signature; reads only the first bytes. */
+inline bool IsY4MFile(const std::string& Path)
+{
+    FILE* File = std::fopen(Path.c_str(), "rb");
+    if (!File) return false;
+    char Signature[10] = {};
+    bool bY4M = std::fread(Signature, 1, sizeof(Signature), File) == sizeof(Signature)
+        && std::memcmp(Signature, "YUV4MPEG2 ", sizeof(Signature)) == 0;
+    std::fclose(File);
+    return bY4M;
+}
+
+/** Read-only mapping of a whole file. */
+class FMappedFile
+{
+public:
+    FMappedFile() = default;
+    ~FMappedFile() { Close(); }
+    FMappedFile(const FMappedFile&) = delete;
+    FMappedFile& operator=(const FMappedFile&) = delete;
+
+    bool Open(const std::string& Path)
+    {
+        Close();
+        int Handle = open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (Handle < 0) return false;
+        struct stat Stat {};
+        if (fstat(Handle, &Stat) == 0 && Stat.st_size > 0)
+        {
+            void* Mapped = mmap(nullptr, static_cast<size_t>(Stat.st_size), PROT_READ, MAP_PRIVATE, Handle, 0);
+            if (Mapped != MAP_FAILED)
+            {
+                Data = static_cast<const uint8_t*>(Mapped);
+                Size = static_cast<size_t>(Stat.st_size);
+                RESOURCE_ACQUIRE("Y4M.Mapping", Handle);
+            }
+        }
+        close(Handle);
+        return Data != nullptr;
+    }
+
+    void Close()
+    {
+        if (!Data) return;
+        munmap(const_cast<uint8_t*>(Data), Size);
+        RESOURCE_RELEASE("Y4M.Mapping", Handle);
+        Data = nullptr;
+        Size = 0;
+    }
+
+    /** Hints about [Begin, End): Advice is MADV_SEQUENTIAL, MADV_WILLNEED or MADV_DONTNEED. */
+    void Advise(size_t Begin, size_t End, int Advice) const
+    {
+        size_t Page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        Begin = Begin / Page * Page;
+        End = End < Size ? End : Size;
+        if (Data && End > Begin) madvise(const_cast<uint8_t*>(Data) + Begin, End - Begin, Advice);
+    }
+
+    const uint8_t* GetData() const { return Data; }
+    size_t GetSize() const { return Size; }
+
+private:
+    const uint8_t* Data = nullptr;
+    size_t Size = 0;
+};
+
+/** Plays a memory-mapped Y4M file: NV12 frames from 8-bit 4:2:0 or mono, P010 from 10-bit 4:2:0. */
+class FY4MSource final : public IVideoSource
+{
+public:
+    /** False if the file cannot be mapped or is not a supported Y4M stream; GetError() says why. */
+    bool Open(const std::string& Path)
+    {
+        FrameOffsets.clear();
+        NextFrame = 0;
+        if (!File.Open(Path))
+        {
+            Error = "cannot open or map the file";
+            return false;
+        }
+        const char* Text = reinterpret_cast<const char*>(File.GetData());
+        size_t Offset = 0;
+        if (!ParseY4MHeader(Text, File.GetSize(), Header, Offset, Error)) return false;
+
+        // Index every frame up front: only the FRAME lines are touched, and the duration is known.
+        size_t FrameBytes = Header.FrameBytes();
+        while (Offset + 5 <= File.GetSize() && std::memcmp(Text + Offset, "FRAME", 5) == 0)
+        {
+            const void* LineEnd = std::memchr(Text + Offset, '\n', File.GetSize() - Offset);
+            if (!LineEnd) break;
+            size_t Payload = static_cast<size_t>(static_cast<const char*>(LineEnd) - Text) + 1;
+            // A truncated last frame is dropped.
+            if (File.GetSize() - Payload < FrameBytes) break;
+            FrameOffsets.push_back(Payload);
+            Offset = Payload + FrameBytes;
+        }
+        if (FrameOffsets.empty())
+        {
+            Error = "no complete frame";
+            return false;
+        }
+        File.Advise(0, File.GetSize(), MADV_SEQUENTIAL);
+
+        Info.Width = Header.Width & ~1;
+        Info.Height = Header.Height & ~1;
+        Info.FrameRateNumerator = Header.FrameRateNumerator;
+        Info.FrameRateDenominator = Header.FrameRateDenominator;
+        Info.Format = Header.BitDepth > 8 ? EPixelFormat::P010 : EPixelFormat::NV12;
+        Info.Duration100ns = GetFrameTime(FrameOffsets.size());
+        return true;
+    }
+
+    const FVideoInfo& GetInfo() const override { return Info; }
+    const FY4MHeader& GetHeader() const { return Header; }
+    size_t GetFrameCount() const { return FrameOffsets.size(); }
+    const std::string& GetError() const { return Error; }
+
+    bool ReadFrame(FFrame& Out) override
+    {
+        if (NextFrame >= FrameOffsets.size()) return false;
+        size_t Offset = FrameOffsets[NextFrame];
+        const uint8_t* Luma = File.GetData() + Offset;
+        const uint8_t* ChromaU = Luma + Header.LumaBytes();
+        const uint8_t* ChromaV = ChromaU + Header.ChromaPlaneBytes();
+
+        Out.Allocate(Info.Width, Info.Height, Info.Format);
+        const FFrameView& View = Out.GetView();
+        int32_t SampleBytes = Header.SampleBytes();
+        size_t LumaStride = static_cast<size_t>(Header.Width) * SampleBytes;
+        size_t ChromaStride = static_cast<size_t>((Header.Width + 1) / 2) * SampleBytes;
+        for (int32_t Y = 0; Y < View.Height; ++Y)
+        {
+            const uint8_t* Row = Luma + LumaStride * Y;
+            if (SampleBytes == 1) std::memcpy(View.Row(0, Y), Row, static_cast<size_t>(View.Width));
+            else CopyP010Samples(Row, View.Row(0, Y), View.Width);
+        }
+        for (int32_t Y = 0; Y < View.Height / 2; ++Y)
+        {
+            uint8_t* Dest = View.Row(1, Y);
+            if (Header.bMono) std::memset(Dest, 128, static_cast<size_t>(View.Width));
+            else if (SampleBytes == 1) InterleaveChroma(ChromaU + ChromaStride * Y, ChromaV + ChromaStride * Y, Dest, View.Width / 2);
+            else InterleaveChromaP010(ChromaU + ChromaStride * Y, ChromaV + ChromaStride * Y, Dest, View.Width / 2);
+        }
+        Out.Timestamp100ns = GetFrameTime(NextFrame);
+
+        // Played pages go back to the page cache; only the frames ahead stay mapped in.
+        if (NextFrame > 0) File.Advise(FrameOffsets[NextFrame - 1], Offset, MADV_DONTNEED);
+        ++NextFrame;
+        return true;
+    }
+
+    bool Seek(int64_t Position100ns) override
+    {
+        if (Position100ns < 0) Position100ns = 0;
+        uint64_t Scaled = static_cast<uint64_t>(Position100ns) * Info.FrameRateNumerator;
+        uint64_t Period = 10000000ULL * Info.FrameRateDenominator;
+        uint64_t Index = (Scaled + Period - 1) / Period;
+        NextFrame = Index < FrameOffsets.size() ? static_cast<size_t>(Index) : FrameOffsets.size();
+        if (NextFrame < FrameOffsets.size())
+        {
+            File.Advise(FrameOffsets[NextFrame], FrameOffsets[NextFrame] + Header.FrameBytes(), MADV_WILLNEED);
+        }
+        return true;
+    }
+
+private:
+    int64_t GetFrameTime(uint64_t Index) const
+    {
+        return static_cast<int64_t>(Index * 10000000ULL * Info.FrameRateDenominator / Info.FrameRateNumerator);
+    }
+
+    /** Y4M 10-bit samples are little-endian and LSB-aligned; P010 keeps them in the top bits. */
+    static uint16_t ReadSample10(const uint8_t* Source)
+    {
+        return static_cast<uint16_t>((Source[0] | Source[1] << 8) << 6);
+    }
+
+    static void CopyP010Samples(const uint8_t* Source, uint8_t* Dest, int32_t Count)
+    {
+        uint16_t* Out = reinterpret_cast<uint16_t*>(Dest);
+        for (int32_t X = 0; X < Count; ++X) Out[X] = ReadSample10(Source + X * 2);
+    }
+
+    static void InterleaveChroma(const uint8_t* U, const uint8_t* V, uint8_t* Dest, int32_t Pairs)
+    {
+        for (int32_t X = 0; X < Pairs; ++X)
+        {
+            Dest[X * 2] = U[X];
+            Dest[X * 2 + 1] = V[X];
+        }
+    }
+
+    static void InterleaveChromaP010(const uint8_t* U, const uint8_t* V, uint8_t* Dest, int32_t Pairs)
+    {
+        uint16_t* Out = reinterpret_cast<uint16_t*>(Dest);
+        for (int32_t X = 0; X < Pairs; ++X)
+        {
+            Out[X * 2] = ReadSample10(U + X * 2);
+            Out[X * 2 + 1] = ReadSample10(V + X * 2);
+        }
+    }
+
+    FMappedFile File;
+    FY4MHeader Header;
+    FVideoInfo Info;
+    std::vector<size_t> FrameOffsets;   // Payload of each frame, past its FRAME line
+    size_t NextFrame = 0;
+    std::string Error;
+};
+
+/** Writes NV12 or P010 frames as a Y4M stream (4:2:0, 8 or 10 bit), e.g. to capture a decode for replay. */
+class FY4MWriter
+{
+public:
+    ~FY4MWriter() { Close(); }
+
+    /** Width, Height, frame rate and Format (NV12 or P010) come from Info. */
+    bool Open(const std::string& Path, const FVideoInfo& InInfo)
+    {
+        Close();
+        Info = InInfo;
+        if (Info.Width < 2 || Info.Height < 2 || (Info.Format != EPixelFormat::NV12 && Info.Format != EPixelFormat::P010)) return false;
+        File = std::fopen(Path.c_str(), "wb");
+        if (!File) return false;
+        bool b10Bit = Info.Format == EPixelFormat::P010;
+        bOk = std::fprintf
+        (
+            File, "YUV4MPEG2 W%d H%d F%u:%u Ip A1:1 %s\n", Info.Width, Info.Height,
+            Info.FrameRateNumerator ? Info.FrameRateNumerator : 30, Info.FrameRateNumerator ? Info.FrameRateDenominator : 1,
+            b10Bit ? "C420p10 XYSCSS=420P10" : "C420mpeg2 XYSCSS=420MPEG2"
+        ) > 0;
+        return bOk;
+    }
+
+    /** Frame must match the size and format given to Open(). */
+    bool WriteFrame(const FFrameView& Frame)
+    {
+        if (!File || !bOk || Frame.Width != Info.Width || Frame.Height != Info.Height || Frame.Format != Info.Format) return false;
+        bool b10Bit = Frame.Format == EPixelFormat::P010;
+        size_t SampleBytes = b10Bit ? 2 : 1;
+        int32_t ChromaWidth = (Frame.Width + 1) / 2;
+        bOk &= std::fwrite("FRAME\n", 1, 6, File) == 6;
+        for (int32_t Y = 0; Y < Frame.Height && bOk; ++Y)
+        {
+            if (!b10Bit) bOk &= std::fwrite(Frame.Row(0, Y), 1, static_cast<size_t>(Frame.Width), File) == static_cast<size_t>(Frame.Width);
+            else
+            {
+                Row.resize(static_cast<size_t>(Frame.Width) * 2);
+                const uint16_t* Samples = reinterpret_cast<const uint16_t*>(Frame.Row(0, Y));
+                for (int32_t X = 0; X < Frame.Width; ++X) WriteSample10(Samples[X], &Row[static_cast<size_t>(X) * 2]);
+                bOk &= std::fwrite(Row.data(), 1, Row.size(), File) == Row.size();
+            }
+        }
+        // Planar U, then planar V, split out of the interleaved plane; odd sizes round the chroma planes up.
+        Row.resize(static_cast<size_t>(ChromaWidth) * SampleBytes);
+        for (int32_t Component = 0; Component < 2; ++Component)
+        {
+            for (int32_t Y = 0; Y < (Frame.Height + 1) / 2 && bOk; ++Y)
+            {
+                const uint8_t* Source = Frame.Row(1, Y);
+                for (int32_t X = 0; X < ChromaWidth; ++X)
+                {
+                    if (!b10Bit) Row[static_cast<size_t>(X)] = Source[X * 2 + Component];
+                    else WriteSample10(reinterpret_cast<const uint16_t*>(Source)[X * 2 + Component], &Row[static_cast<size_t>(X) * 2]);
+                }
+                bOk &= std::fwrite(Row.data(), 1, Row.size(), File) == Row.size();
+            }
+        }
+        if (bOk) ++FramesWritten;
+        return bOk;
+    }
+
+    /** Flushes and closes; false if any write failed. */
+    bool Close()
+    {
+        if (!File) return bOk;
+        bOk &= std::fclose(File) == 0;
+        File = nullptr;
+        return bOk;
+    }
+
+    uint64_t GetFramesWritten() const { return FramesWritten; }
+
+private:
+    static void WriteSample10(uint16_t Sample, uint8_t* Dest)
+    {
+        uint16_t Value = static_cast<uint16_t>(Sample >> 6);
+        Dest[0] = static_cast<uint8_t>(Value & 0xFF);
+        Dest[1] = static_cast<uint8_t>(Value >> 8);
+    }
+
+    FILE* File = nullptr;
+    FVideoInfo Info;
+    std::vector<uint8_t> Row;
+    uint64_t FramesWritten = 0;
+    bool bOk = false;
+};